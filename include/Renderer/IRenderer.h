@@ -134,7 +134,8 @@ typedef enum RendererApi
 	RENDERER_API_VULKAN,
 	RENDERER_API_METAL,
 	RENDERER_API_XBOX_D3D12,
-	RENDERER_API_D3D11
+	RENDERER_API_D3D11,
+	RENDERER_API_NULL
 } RendererApi;
 
 typedef enum LogType
@@ -301,7 +302,7 @@ typedef enum DescriptorType
 	/// RTV / DSV per depth slice
 	DESCRIPTOR_TYPE_RENDER_TARGET_DEPTH_SLICES = (DESCRIPTOR_TYPE_RENDER_TARGET_ARRAY_SLICES << 1),
 	DESCRIPTOR_TYPE_RAY_TRACING = (DESCRIPTOR_TYPE_RENDER_TARGET_DEPTH_SLICES << 1),
-#if defined(VULKAN)
+#if defined(VULKAN) || defined(NULL_RENDERER)
 	/// Subpass input (descriptor type only available in Vulkan)
 	DESCRIPTOR_TYPE_INPUT_ATTACHMENT = (DESCRIPTOR_TYPE_RAY_TRACING << 1),
 	DESCRIPTOR_TYPE_TEXEL_BUFFER = (DESCRIPTOR_TYPE_INPUT_ATTACHMENT << 1),
@@ -588,6 +589,12 @@ typedef struct TextureBarrier
 	struct Texture* pTexture;
 	ResourceState   mNewState;
 	bool            mSplit;
+	/// Transitions mip mMipLevel of array layer mArrayLayer from mCurrentState only.
+	/// The caller tracks subresource states, pTexture->mCurrentState is left as it is
+	bool            mSubresourceBarrier;
+	uint32_t        mMipLevel;
+	uint32_t        mArrayLayer;
+	ResourceState   mCurrentState;
 } TextureBarrier;
 
 typedef struct ReadRange
@@ -649,6 +656,10 @@ typedef struct QueryHeap
     uint64_t gpuTimestampStart;
     uint64_t gpuTimestampEnd;
 #endif
+#if defined(NULL_RENDERER)
+	/// CPU timestamps written when the recorded query commands are replayed
+	uint64_t* pTimestamps;
+#endif
 } QueryHeap;
 
 /// Data structure holding necessary info to create a Buffer
@@ -722,12 +733,18 @@ typedef struct Buffer
 	struct VmaAllocation_T* pVkAllocation;
 	/// Description for creating the descriptor for this buffer (applicable to BUFFER_USAGE_UNIFORM, BUFFER_USAGE_STORAGE_SRV, BUFFER_USAGE_STORAGE_UAV)
 	VkDescriptorBufferInfo mVkBufferInfo;
+	/// Index in the bindless buffer table (DESCRIPTOR_TYPE_BUFFER / DESCRIPTOR_TYPE_RW_BUFFER), INVALID_BINDLESS_INDEX if there is none
+	uint32_t mBindlessIndex;
 #endif
 #if defined(METAL)
 	/// Contains resource allocation info such as parent heap, offset in heap
 	struct ResourceAllocation* pMtlAllocation;
 	/// Native handle of the underlying resource
 	id<MTLBuffer> mtlBuffer;
+#endif
+#if defined(NULL_RENDERER)
+	/// System memory backing the buffer contents
+	void* pNullMemory;
 #endif
 	/// Buffer creation info
 	BufferDesc mDesc;
@@ -840,6 +857,9 @@ typedef struct Texture
 	struct VmaAllocation_T* pVkAllocation;
 	/// Flags specifying which aspects (COLOR,DEPTH,STENCIL) are included in the pVkImageView
 	VkImageAspectFlags mVkAspectMask;
+	/// Index in the bindless texture table (DESCRIPTOR_TYPE_TEXTURE), INVALID_BINDLESS_INDEX if there is none.
+	/// Streamed textures get a new index whenever updateTextureStreaming swaps in other levels
+	uint32_t mBindlessIndex;
 #endif
 #if defined(METAL)
 	/// Contains resource allocation info such as parent heap, offset in heap
@@ -854,6 +874,10 @@ typedef struct Texture
 	ID3D11Resource*             pDxResource;
 	ID3D11ShaderResourceView*   pDxSRVDescriptor;
 	ID3D11UnorderedAccessView** pDxUAVDescriptors;
+#endif
+#if defined(NULL_RENDERER)
+	/// System memory backing all subresources (array layers, each with its full mip chain)
+	void* pNullMemory;
 #endif
 	/// Texture creation info
 	TextureDesc mDesc;    //88
@@ -936,6 +960,9 @@ typedef struct LoadActionsDesc
 	ClearValue     mClearDepth;
 	LoadActionType mLoadActionDepth;
 	LoadActionType mLoadActionStencil;
+	/// The render pass is recorded by secondary command buffers (beginSecondaryCmd / cmdExecuteSecondaryCmds)
+	/// instead of commands on the primary command buffer
+	bool mSecondaryCmds;
 } LoadActionsDesc;
 
 typedef struct SamplerDesc
@@ -986,6 +1013,17 @@ typedef enum DescriptorUpdateFrequency
 	DESCRIPTOR_UPDATE_FREQ_COUNT,
 } DescriptorUpdateFrequency;
 
+#if defined(VULKAN)
+/// Set of the global bindless table (RendererDesc::mBindless). Shaders declare unbounded arrays in it:
+///   layout(set = 4, binding = 0) uniform texture2D gTextures[];
+///   layout(set = 4, binding = 1) buffer Data { ... } gBuffers[];
+/// and index them with Texture::mBindlessIndex / Buffer::mBindlessIndex, usually passed in push constants
+#define BINDLESS_DESCRIPTOR_SET DESCRIPTOR_UPDATE_FREQ_COUNT
+#define BINDLESS_TEXTURE_BINDING 0
+#define BINDLESS_BUFFER_BINDING 1
+#define INVALID_BINDLESS_INDEX UINT32_MAX
+#endif
+
 /// Data structure holding the layout for a descriptor
 typedef struct DescriptorInfo
 {
@@ -1065,6 +1103,8 @@ typedef struct RootSignature
 	VkPushConstantRange*  pVkPushConstantRanges;
 	uint32_t              mVkPushConstantCount;
 	VkPipelineLayout      pPipelineLayout;
+	/// The shaders use the bindless table, cmdBindPipeline binds it to BINDLESS_DESCRIPTOR_SET
+	bool                  mVkBindless;
 #endif
 #if defined(METAL)
 	Sampler**    ppStaticSamplers;
@@ -1112,6 +1152,9 @@ typedef struct DescriptorData
 	};
 	/// Number of resources in the descriptor(applies to array of textures, buffers,...)
 	uint32_t mCount;
+	/// Index of descriptor (use getDescriptorIndexFromName to resolve it once). Only used if pName is NULL
+	/// Binding by index skips the name lookup in cmdBindDescriptors
+	uint32_t mIndex;
 } DescriptorData;
 
 typedef struct CmdPoolDesc
@@ -1147,6 +1190,8 @@ typedef struct Cmd
 	uint32_t             mBoundHeight;
 	uint32_t             mNodeIndex;
 	uint64_t             mRenderPassHash;
+	/// Allocated through addCmd with secondary = true
+	bool                 mSecondary;
 #if defined(DIRECT3D12)
 	// For now each command list will have its own allocator until we get the command allocator pool logic working
 	ID3D12CommandAllocator*    pDxCmdAlloc;
@@ -1157,20 +1202,42 @@ typedef struct Cmd
 	D3D12_CPU_DESCRIPTOR_HANDLE mTransientCBVs;
 	uint64_t                    mTransientCBVPosition;
 	uint32_t                    mBatchBarrierCount;
+	/// Render targets of the last cmdBindRenderTargets, bound again in secondary command lists
+	D3D12_CPU_DESCRIPTOR_HANDLE mBoundRtvs[MAX_RENDER_TARGET_ATTACHMENTS];
+	D3D12_CPU_DESCRIPTOR_HANDLE mBoundDsv;
+	/// cmdExecuteSecondaryCmds closes pDxCmdList and continues in the next segment command list.
+	/// queueSubmit executes ppDxSubmitCmdLists (closed segments and the secondary command lists in order), then pDxCmdList
+	ID3D12CommandAllocator**    ppDxSegmentCmdAllocs;
+	ID3D12GraphicsCommandList** ppDxSegmentCmdLists;
+	uint32_t                    mSegmentCount;
+	uint32_t                    mUsedSegmentCount;
+	ID3D12CommandList**         ppDxSubmitCmdLists;
+	uint32_t                    mSubmitCmdListCount;
+	uint32_t                    mSubmitCmdListCapacity;
+	/// Secondary command buffers executed by this one
+	struct Cmd**                ppExecutedCmds;
+	uint32_t                    mExecutedCmdCount;
+	uint32_t                    mExecutedCmdCapacity;
 #endif
 #if defined(VULKAN)
 	VkCommandBuffer pVkCmdBuf;
 	VkRenderPass    pVkActiveRenderPass;
+	VkFramebuffer   pVkActiveFrameBuffer;
 
 	VkImageMemoryBarrier        pBatchImageMemoryBarriers[MAX_BATCH_BARRIERS];
 	VkBufferMemoryBarrier       pBatchBufferMemoryBarriers[MAX_BATCH_BARRIERS];
 	uint32_t                    mBatchImageMemoryBarrierCount;
 	uint32_t                    mBatchBufferMemoryBarrierCount;
+	/// Stages the batched barriers wait for / block
+	VkPipelineStageFlags        mBatchSrcStageFlags;
+	VkPipelineStageFlags        mBatchDstStageFlags;
 #endif
 #if defined(METAL)
 	id<MTLCommandBuffer>         mtlCommandBuffer;
 	id<MTLFence>                 mtlEncoderFence;    // Used to sync different types of encoders recording in the same Cmd.
 	id<MTLRenderCommandEncoder>  mtlRenderEncoder;
+	/// Render pass bound with LoadActionsDesc::mSecondaryCmds, secondaries record into sub encoders of it
+	id<MTLParallelRenderCommandEncoder> mtlParallelRenderEncoder;
 	id<MTLComputeCommandEncoder> mtlComputeEncoder;
 	id<MTLBlitCommandEncoder>    mtlBlitEncoder;
 	MTLRenderPassDescriptor*     pRenderPassDesc;
@@ -1183,13 +1250,27 @@ typedef struct Cmd
 #endif
 #if defined(DIRECT3D11)
 	uint8_t* pDescriptorStructPool;
-	uint8_t* pDescriptorNamePool;
 	uint8_t* pDescriptorResourcesPool;
 	uint64_t mDescriptorStructPoolOffset;
-	uint64_t mDescriptorNamePoolOffset;
 	uint64_t mDescriptorResourcePoolOffset;
 	Buffer*  pRootConstantBuffer;
 	Buffer*  pTransientConstantBuffer;
+#endif
+#if defined(NULL_RENDERER)
+	/// Compact binary command stream (see NullCommands.h) replayed on queueSubmit
+	uint8_t*       pCmdStream;
+	uint64_t       mCmdStreamSize;
+	uint64_t       mCmdStreamCapacity;
+	uint32_t       mCmdCount;
+	bool           mRecording;
+	bool           mRenderPassActive;
+	/// Render targets bound with LoadActionsDesc::mSecondaryCmds
+	bool           mSecondaryRenderPass;
+	/// Secondary begun through beginSecondaryCmd, only those can be executed by a primary
+	bool           mInheritedRenderPass;
+	Pipeline*      pBoundPipeline;
+	RootSignature* pBoundRootSignature;
+	Buffer*        pBoundIndexBuffer;
 #endif
 	void*                        pBoundDescriptorBinderNode;
 	struct DescriptorBinder*     pBoundDescriptorBinder;
@@ -1218,13 +1299,21 @@ typedef struct Fence
 	uint64       mFenceValue;
 #endif
 #if defined(VULKAN)
-	VkFence pVkFence;
-	bool    mSubmitted;
+	VkFence       pVkFence;
+	bool          mSubmitted;
+	/// Queue and fence value of the last submission signaling this fence
+	struct Queue* pSubmitQueue;
+	uint64_t      mFenceValue;
 #endif
 #if defined(METAL)
 	dispatch_semaphore_t pMtlSemaphore;
 	bool                 mSubmitted;
 #endif
+#if defined(NULL_RENDERER)
+	/// getUSec() value at which the simulated GPU work completes
+	int64_t mCompletionTime;
+	bool    mSubmitted;
+#endif
 } Fence;
 
 typedef struct Semaphore
@@ -1255,6 +1344,9 @@ typedef struct Semaphore
 #if defined(METAL)
 	dispatch_semaphore_t pMtlSemaphore;
 #endif
+#if defined(NULL_RENDERER)
+	bool mSignaled;
+#endif
 } Semaphore;
 
 typedef struct Queue
@@ -1268,10 +1360,18 @@ typedef struct Queue
 	VkQueue  pVkQueue;
 	uint32_t mVkQueueFamilyIndex;
 	uint32_t mVkQueueIndex;
+	/// Incremented by every queueSubmit
+	uint64_t mFenceValue;
+	/// All submissions up to this value are done, raised when their fence is seen signaled or the queue goes idle
+	uint64_t mCompletedFenceValue;
 #endif
 #if defined(METAL)
 	id<MTLCommandQueue>  mtlCommandQueue;
 	uint32_t             mBarrierFlags;
+#endif
+#if defined(NULL_RENDERER)
+	/// getUSec() value at which all work submitted to this queue completes
+	int64_t mIdleTime;
 #endif
 	QueueDesc mQueueDesc;
 	Extent3D  mUploadGranularity;
@@ -1727,6 +1827,9 @@ typedef struct SwapChain
 	id<CAMetalDrawable>  mMTKDrawable;
 	id<MTLCommandBuffer> presentCommandBuffer;
 #endif
+#if defined(NULL_RENDERER)
+	uint32_t mCurrentImageIndex;
+#endif
 } SwapChain;
 
 typedef enum ShaderTarget
@@ -1762,12 +1865,53 @@ typedef struct RendererDesc
 	eastl::vector<eastl::string> mInstanceExtensions;
 	eastl::vector<eastl::string> mDeviceExtensions;
 	PFN_vkDebugReportCallbackEXT     pVkDebugFn;
+	// Skip loading and saving the on-disk pipeline cache
+	bool                             mDisablePipelineCache;
+	/// Frame buffers kept alive before the least recently used ones get evicted (512 if 0)
+	uint32_t                         mMaxCachedFrameBuffers;
+	/// Create the bindless table (needs VK_EXT_descriptor_indexing with update after bind, ignored otherwise)
+	bool                             mBindless;
+	/// Size of the bindless texture / buffer arrays (16384 / 4096 if 0, clamped to the device limits)
+	uint32_t                         mMaxBindlessTextures;
+	uint32_t                         mMaxBindlessBuffers;
 #endif
 #if defined(DIRECT3D12)
 	D3D_FEATURE_LEVEL mDxFeatureLevel;
 #endif
+#if defined(NULL_RENDERER)
+	// Simulated GPU latency (in microseconds) before a submitted fence reports completion
+	uint32_t mSimulatedGpuLatencyUs;
+#endif
 } RendererDesc;
 
+#if defined(VULKAN)
+/// Counters of the render pass / frame buffer cache used by cmdBindRenderTargets
+typedef struct RenderPassCacheStats
+{
+	uint64_t mRenderPassHits;
+	uint64_t mRenderPassMisses;
+	uint64_t mRenderPassEvictions;
+	uint64_t mFrameBufferHits;
+	uint64_t mFrameBufferMisses;
+	uint64_t mFrameBufferEvictions;
+	/// Live entries
+	uint32_t mRenderPassCount;
+	uint32_t mFrameBufferCount;
+} RenderPassCacheStats;
+
+/// Counters of the descriptor set cache of a DescriptorBinder (all update frequencies but DESCRIPTOR_UPDATE_FREQ_PER_DRAW)
+typedef struct DescriptorBinderStats
+{
+	/// Binds which found a descriptor set with the same contents and skipped the update
+	uint64_t mHits;
+	uint64_t mMisses;
+	/// Misses which recycled the least recently used descriptor set
+	uint64_t mEvictions;
+	/// Descriptor sets holding cached contents
+	uint32_t mCachedSetCount;
+} DescriptorBinderStats;
+#endif
+
 typedef struct GPUVendorPreset
 {
 	char           mVendorId[MAX_GPU_VENDOR_STRING_LENGTH];
@@ -1875,6 +2019,7 @@ typedef struct Renderer
 	Sampler* pDefaultSampler;
 
 	struct VmaAllocator_T*      pVmaAllocator;
+	struct PipelineCacheStore*  pPipelineCacheStore;
 
 	// These are the extensions that we have loaded
 	const char* gVkInstanceExtensions[MAX_INSTANCE_EXTENSIONS];
@@ -1924,11 +2069,16 @@ typedef struct CommandSignature
 #if defined(METAL)
 	IndirectArgumentType mDrawType;
 #endif
+#if defined(NULL_RENDERER)
+	IndirectArgumentType mDrawType;
+#endif
 } CommandSignature;
 
 typedef struct DescriptorBinderDesc
 {
 	RootSignature* pRootSignature;
+	/// Different descriptor sets of the batch frequency bound per frame. On Vulkan the sets are cached across frames,
+	/// MAX_FRAMES_IN_FLIGHT times this many stay cached. The cache grows when more than that are in flight
 	uint32_t       mMaxDynamicUpdatesPerBatch;
 	uint32_t       mMaxDynamicUpdatesPerDraw;
 } DescriptorBinderDesc;
@@ -1983,6 +2133,8 @@ API_INTERFACE void FORGE_CALLCONV removeShader(Renderer* pRenderer, Shader* p_sh
 // pipeline functions
 API_INTERFACE void FORGE_CALLCONV addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootDesc, RootSignature** pp_root_signature);
 API_INTERFACE void FORGE_CALLCONV removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature);
+/// Returns the index of the named descriptor in pRootSignature->pDescriptors to be used as DescriptorData::mIndex (UINT32_MAX if not found)
+API_INTERFACE uint32_t FORGE_CALLCONV getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName);
 API_INTERFACE void FORGE_CALLCONV addPipeline(Renderer* pRenderer, const PipelineDesc* p_pipeline_settings, Pipeline** pp_pipeline); 
 
 /////////////////////////Deprecated!
@@ -2012,11 +2164,23 @@ API_INTERFACE void FORGE_CALLCONV removeRasterizerState(RasterizerState* pRaster
 // command buffer functions
 API_INTERFACE void FORGE_CALLCONV beginCmd(Cmd* p_cmd);
 API_INTERFACE void FORGE_CALLCONV endCmd(Cmd* p_cmd);
+/// Begins a secondary command buffer continuing the render pass bound on p_primary_cmd with LoadActionsDesc::mSecondaryCmds.
+/// Secondary command buffers can be recorded on several threads at once if each comes from its own command pool.
+/// They inherit the render targets only: set viewport, scissor, pipeline and descriptors in each of them.
+/// Barriers and render target binds are not allowed in them. Metal executes them in the order they were begun
+API_INTERFACE void FORGE_CALLCONV beginSecondaryCmd(Cmd* p_cmd, Cmd* p_primary_cmd);
+/// Executes the ended secondary command buffers in order. The primary has to set its dynamic state and descriptors again afterwards
+API_INTERFACE void FORGE_CALLCONV cmdExecuteSecondaryCmds(Cmd* p_cmd, uint32_t cmd_count, Cmd** pp_secondary_cmds);
 API_INTERFACE void FORGE_CALLCONV cmdBindRenderTargets(Cmd* p_cmd, uint32_t render_target_count, RenderTarget** pp_render_targets, RenderTarget* p_depth_stencil, const LoadActionsDesc* loadActions, uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice, uint32_t depthMipSlice);
 API_INTERFACE void FORGE_CALLCONV cmdSetViewport(Cmd* p_cmd, float x, float y, float width, float height, float min_depth, float max_depth);
 API_INTERFACE void FORGE_CALLCONV cmdSetScissor(Cmd* p_cmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 API_INTERFACE void FORGE_CALLCONV cmdBindPipeline(Cmd* p_cmd, Pipeline* p_pipeline);
 API_INTERFACE void FORGE_CALLCONV cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams);
+#if defined(VULKAN)
+/// Sets the root constant at paramIndex (getDescriptorIndexFromName) without going through the descriptor binder,
+/// e.g. the bindless indices of a draw
+API_INTERFACE void FORGE_CALLCONV cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, uint32_t paramIndex, const void* pConstants);
+#endif
 API_INTERFACE void FORGE_CALLCONV cmdBindIndexBuffer(Cmd* p_cmd, Buffer* p_buffer, uint64_t offset);
 API_INTERFACE void FORGE_CALLCONV cmdBindVertexBuffer(Cmd* p_cmd, uint32_t buffer_count, Buffer** pp_buffers, uint64_t* pOffsets);
 API_INTERFACE void FORGE_CALLCONV cmdDraw(Cmd* p_cmd, uint32_t vertex_count, uint32_t first_vertex);
@@ -2069,6 +2233,10 @@ API_INTERFACE void FORGE_CALLCONV cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHe
 /************************************************************************/
 API_INTERFACE void FORGE_CALLCONV calculateMemoryStats(Renderer* pRenderer, char** stats);
 API_INTERFACE void FORGE_CALLCONV freeMemoryStats(Renderer* pRenderer, char* stats);
+#if defined(VULKAN)
+API_INTERFACE void FORGE_CALLCONV getRenderPassCacheStats(Renderer* pRenderer, RenderPassCacheStats* pStats);
+API_INTERFACE void FORGE_CALLCONV getDescriptorBinderStats(DescriptorBinder* pDescriptorBinder, DescriptorBinderStats* pStats);
+#endif
 /************************************************************************/
 // Debug Marker Interface
 /************************************************************************/
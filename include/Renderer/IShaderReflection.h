@@ -129,7 +129,7 @@ struct ShaderReflection
 	//number of tessellation control point
 	uint32_t mNumControlPoint;
 
-#if defined(VULKAN)
+#if defined(VULKAN) || defined(NULL_RENDERER)
 	char* pEntryPoint;
 #endif
 };
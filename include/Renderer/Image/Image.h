@@ -38,8 +38,58 @@
 
 /*************************************************************************************/
 
+/// Kernel used to filter the mip chain. Kaiser and Lanczos are windowed sinc filters with a radius of three texels
+typedef enum MipFilter
+{
+	MIP_FILTER_BOX = 0,
+	MIP_FILTER_KAISER,
+	MIP_FILTER_LANCZOS,
+} MipFilter;
+
+/// Speed / quality trade-off of Image::Compress
+typedef enum CompressionQuality
+{
+	COMPRESSION_QUALITY_FAST = 0,
+	COMPRESSION_QUALITY_NORMAL,
+	COMPRESSION_QUALITY_HIGH,
+} CompressionQuality;
+
+struct ThreadSystem;
+
 typedef void* (*memoryAllocationFunc)(class Image* pImage, uint64_t memoryRequirement, void* pUserData);
 
+/// One image (layer / face) of a Basis Universal supercompressed KTX2 level to transcode into pDst
+typedef struct KTX2TranscodeDesc
+{
+	/// Level data after zstd inflation, BasisLZ / UASTC payload of all images of the level
+	const void*       pLevelData;
+	uint64_t          mLevelDataSize;
+	/// Supercompression global data (BasisLZ codebooks and image descs), NULL for UASTC
+	const void*       pGlobalData;
+	uint64_t          mGlobalDataSize;
+	uint32_t          mLevel;
+	uint32_t          mLevelCount;
+	/// Index of the image in the level, layer * faceCount + face
+	uint32_t          mImageIndex;
+	uint32_t          mImageCount;
+	uint32_t          mWidth;
+	uint32_t          mHeight;
+	void*             pDst;
+	uint32_t          mDstSize;
+	ImageFormat::Enum mDstFormat;
+	bool              mUASTC;
+} KTX2TranscodeDesc;
+
+/// Decoders for the KTX2 payloads which need third party code. Unset callbacks make such files fail to load
+typedef struct KTX2Codecs
+{
+	bool (*pZstdDecompress)(const void* pSrc, uint64_t srcSize, void* pDst, uint64_t dstSize, void* pUserData);
+	bool (*pBasisTranscode)(const KTX2TranscodeDesc* pDesc, void* pUserData);
+	void* pUserData;
+} KTX2Codecs;
+
+typedef bool (*ImageFormatSupportedFunc)(ImageFormat::Enum format);
+
 class Image
 {
 	public:
@@ -64,6 +114,12 @@ class Image
 		pData = pixelData;
 	}
 	void SetName(const eastl::string& name) { mLoadFileName = name; }
+	/// Loaders of files with stored mip levels (DDS, KTX2) skip the levels wider or higher than maxSize, the first level
+	/// loaded stays block aligned. 0, the default, loads all levels
+	void SetMaxLoadSize(const uint maxSize) { mMaxLoadSize = maxSize; }
+	/// Called by the loaders once the dimensions of the file are set. Drops the levels above the max load size and
+	/// returns the bytes they take per array slice
+	uint SkipMipLevelsAboveMaxLoadSize();
 
 	uint                 GetWidth() const { return mWidth; }
 	uint                 GetHeight() const { return mHeight; }
@@ -72,17 +128,32 @@ class Image
 	uint                 GetHeight(const int mipMapLevel) const;
 	uint                 GetDepth(const int mipMapLevel) const;
 	uint                 GetMipMapCount() const { return mMipMapCount; }
+	/// Levels the last load skipped, the source width / height are the ones of level 0 in the file
+	uint                 GetSkippedMipCount() const { return mSkippedMipCount; }
+	uint                 GetSourceWidth() const { return mSkippedMipCount ? mSourceWidth : mWidth; }
+	uint                 GetSourceHeight() const { return mSkippedMipCount ? mSourceHeight : mHeight; }
 	const eastl::string& GetName() const { return mLoadFileName; }
 	uint                 GetMipMapCountFromDimensions() const;
 	uint                 GetArraySliceSize(const uint mipMapLevel = 0, ImageFormat::Enum srcFormat = ImageFormat::NONE) const;
 	uint                 GetNumberOfPixels(const uint firstMipLevel = 0, uint numMipLevels = ALL_MIPLEVELS) const;
 	bool                 GetColorRange(float& min, float& max);
 	bool                 Normalize();
-	bool                 Uncompress();
+	/// Decodes BC1 - BC5 images to R8 - RGBA8, block rows are decoded in parallel on pThreadSystem if one is given
+	bool                 Uncompress(ThreadSystem* pThreadSystem = NULL);
 	bool                 Unpack();
 
-	bool Convert(const ImageFormat::Enum newFormat);
-	bool GenerateMipMaps(const uint32_t mipMaps = ALL_MIPLEVELS);
+	/// Converts between the 8 / 16 bit unorm, half, float, RGBE8, RGB9E5 and RGB10A2 formats. Large images are converted
+	/// in chunks of rows in parallel on pThreadSystem if one is given
+	bool Convert(const ImageFormat::Enum newFormat, ThreadSystem* pThreadSystem = NULL);
+	/// Block compresses all mip levels, faces and slices. BC1 - BC5 and BC7 take R8 - RGBA8 / BGRA8 images, BC6H (GNF_BC6HUF)
+	/// takes 16 / 32 bit float images. Block rows are compressed in parallel on pThreadSystem if one is given
+	bool Compress(
+		const ImageFormat::Enum newFormat, const CompressionQuality quality = COMPRESSION_QUALITY_NORMAL,
+		ThreadSystem* pThreadSystem = NULL);
+	/// Filters in linear space for sRGB images. Works on any size, the faces and array slices are processed in parallel
+	/// on pThreadSystem if one is given
+	bool GenerateMipMaps(
+		const uint32_t mipMaps = ALL_MIPLEVELS, const MipFilter filter = MIP_FILTER_BOX, ThreadSystem* pThreadSystem = NULL);
 
 	uint GetArrayCount() const { return mArrayCount; }
 	uint GetMipMappedSize(
@@ -91,6 +162,7 @@ class Image
 	ImageFormat::Enum getFormat() const { return mFormat; }
 
 	void setFormat(const ImageFormat::Enum fmt) { mFormat = fmt; }
+	void setSrgb(const bool srgb) { mSrgb = srgb; }
 	bool Is1D() const { return (mDepth == 1 && mHeight == 1); }
 	bool Is2D() const { return (mDepth == 1 && mHeight > 1); }
 	bool Is3D() const { return (mDepth > 1); }
@@ -126,6 +198,9 @@ class Image
 	uint              mWidth, mHeight, mDepth;
 	uint              mMipMapCount;
 	uint              mArrayCount;
+	uint              mMaxLoadSize;
+	uint              mSkippedMipCount;
+	uint              mSourceWidth, mSourceHeight;
 	ImageFormat::Enum mFormat;
 	int               mAdditionalDataSize;
 	unsigned char*    pAdditionalData;
@@ -137,6 +212,10 @@ class Image
 	typedef bool (*ImageLoaderFunction)(
 		Image* pImage, const char* memory, uint32_t memSize, memoryAllocationFunc pAllocator, void* pUserData);
 	static void AddImageLoader(const char* pExtension, ImageLoaderFunction pFunc);
+	/// Registers the zstd / Basis Universal decoders used by the KTX2 loader
+	static void SetKTX2Codecs(const KTX2Codecs* pCodecs);
+	/// Query used to pick the GPU format Basis Universal textures are transcoded to, RGBA8 is used if none is set
+	static void SetSupportedFormatQuery(ImageFormatSupportedFunc pFunc);
 };
 
 static inline uint32_t calculateMipMapLevels(uint32_t width, uint32_t height)
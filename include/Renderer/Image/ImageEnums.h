@@ -267,12 +267,14 @@ static inline uint3 GetBlockSize(const Enum format)
 	case DXT1:         //  4x4
 	case ATI1N:        //  4x4
 	case GNF_BC1:      //  4x4
+	case GNF_BC4:      //  4x4
 	case ETC1:         //  4x4
 	case ATC:          //  4x4
 	case PVR_4BPP:     //  4x4
 	case PVR_4BPPA:    //  4x4
 	case DXT3:         //  4x4
 	case DXT5:         //  4x4
+	case GNF_BC2:      //  4x4
 	case GNF_BC3:      //  4x4
 	case GNF_BC5:      //  4x4
 	case ATI2N:        //  4x4
@@ -344,6 +346,7 @@ static inline int32_t GetBytesPerBlock(const Enum format)
 			case DXT1:              //  4x4
 			case ATI1N:             //  4x4
 			case GNF_BC1:           //  4x4
+			case GNF_BC4:           //  4x4
 			case ETC1:              //  4x4
 			case ATC:               //  4x4
 			case PVR_4BPP:          //  4x4
@@ -354,6 +357,7 @@ static inline int32_t GetBytesPerBlock(const Enum format)
 
 			case DXT3:       //  4x4
 			case DXT5:       //  4x4
+			case GNF_BC2:    //  4x4
 			case GNF_BC3:    //  4x4
 			case GNF_BC5:    //  4x4
 			case ATI2N:      //  4x4
@@ -48,9 +48,13 @@ FileHandle open_file(const char* filename, const char* flags);
 bool       close_file(FileHandle handle);
 void       flush_file(FileHandle handle);
 size_t     read_file(void* buffer, size_t byteCount, FileHandle handle);
-bool       seek_file(FileHandle handle, long offset, int origin);
-long       tell_file(FileHandle handle);
+bool       seek_file(FileHandle handle, int64_t offset, int origin);
+int64_t    tell_file(FileHandle handle);
 size_t     write_file(const void* buffer, size_t byteCount, FileHandle handle);
+/// Maps the whole file read-only into the address space. Returns NULL on failure or for empty files.
+/// pHandle receives the platform object backing the view and has to be passed back to unmap_file.
+const void* map_file(const char* filename, size_t* pSize, FileHandle* pHandle);
+void        unmap_file(const void* pData, size_t size, FileHandle handle);
 time_t     get_file_last_modified_time(const char* _fileName);
 time_t     get_file_last_accessed_time(const char* _fileName);
 time_t     get_file_creation_time(const char* _fileName);
@@ -217,7 +221,7 @@ class File: public Deserializer, public Serializer
 	virtual unsigned             GetChecksum() override;
 	virtual const eastl::string& GetName() const override { return mFileName; }
 	virtual FileMode             GetMode() const { return mMode; }
-	virtual bool                 IsOpen() const { return pHandle != NULL; }
+	virtual bool                 IsOpen() const { return pHandle != NULL || pArchiveData != NULL; }
 	virtual bool                 IsReadOnly() const { return !(mMode & FileMode::FM_Write || mMode & FileMode::FM_Append); }
 	virtual bool                 IsWriteOnly() const { return !(mMode & FileMode::FM_Read); }
 	virtual void*                GetHandle() const { return pHandle; }
@@ -230,6 +234,9 @@ class File: public Deserializer, public Serializer
 	unsigned        mChecksum;
 	bool            mReadSyncNeeded;
 	bool            mWriteSyncNeeded;
+	// Set instead of pHandle when the file is served from a mounted archive
+	const unsigned char* pArchiveData;
+	void*                pArchiveBuffer;
 };
 
 /// Memory area simulating a stream
@@ -255,11 +262,41 @@ class MemoryBuffer: public Deserializer, public Serializer
 	bool            mReadOnly;
 };
 
+/// Read-only view of a whole file mapped into memory (mmap on Linux)
+/// Parsers can read straight from GetData() without copying the file first
+class MappedFile
+{
+	public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const eastl::string& fileName, FSRoot root);
+	void Close();
+
+	const eastl::string& GetName() const { return mFileName; }
+	const void*          GetData() const { return pData; }
+	size_t               GetSize() const { return mSize; }
+	bool                 IsOpen() const { return pData != NULL; }
+
+	private:
+	// A view can only be unmapped once
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	eastl::string mFileName;
+	const void*   pData;
+	size_t        mSize;
+	FileHandle    pHandle;
+	// Files served from a mounted archive point into the archive mapping or own a decompressed copy
+	void*         pArchiveBuffer;
+	bool          mFromArchive;
+};
+
 /// High level platform independent file system
 class FileSystem
 {
 	public:
-	static unsigned GetFileSize(FileHandle handle);
+	static uint64_t GetFileSize(FileHandle handle);
 	// Allows to modify root paths at runtime
 	static void SetRootPath(FSRoot root, const eastl::string& rootPath);
 	// Reverts back to App static defined pszRoots[]
@@ -274,6 +311,11 @@ class FileSystem
 	static eastl::string GetRootPath(FSRoot root);
 	static bool            FileExists(const eastl::string& pszFileName, FSRoot root);
 
+	// Serves read-only opens of files under root from a packed archive built by the ArchivePacker tool.
+	// Archives should be mounted before loading starts, lookups are not synchronized with mounting.
+	static bool MountArchive(FSRoot root, const eastl::string& archiveFileName);
+	static void UnmountArchive(FSRoot root);
+
 	static eastl::string GetCurrentDir() { return AddTrailingSlash(get_current_dir()); }
 	static eastl::string GetProgramDir() { return GetPath(get_exe_path()); }
 	static eastl::string GetProgramFileName() { return GetFileName(get_exe_path()); }
@@ -313,6 +355,8 @@ class FileSystem
 	static bool CreateDir(const eastl::string& pathName);
 	static int  SystemRun(const eastl::string& fileName, const eastl::vector<eastl::string>& arguments, eastl::string stdOut = "");
 	static bool Delete(const eastl::string& fileName);
+	// Replaces dst if it exists. The replacement is atomic when both paths are on the same volume
+	static bool Rename(const eastl::string& src, const eastl::string& dst);
 
 	static void OpenFileDialog(
 		const eastl::string& title, const eastl::string& dir, FileDialogCallbackFn callback, void* userData,
@@ -81,6 +81,12 @@ void _PrintUnicodeLine(const eastl::string& str, bool error = false);
 //
 #define LOGF_SCOPE(log_level, ...) Log::LogScope ANONIMOUS_VARIABLE_LOG(scope_log_){ (log_level), __FILE__, __LINE__, __VA_ARGS__ }
 
+// Usage: BLOGF(LogLevel::eINFO | LogLevel::eDEBUG, "Whatever string %s, this is an int %d", "This is a string", 1)
+// Only captures the arguments, formatting happens on the log writer thread or offline in binary mode. The format must be a string literal.
+#define BLOGF(log_level, format, ...) Log::WriteDeferred((log_level), __FILE__, __LINE__, (format), ##__VA_ARGS__)
+// Usage: BLOGF_IF(LogLevel::eINFO | LogLevel::eDEBUG, boolean_value && integer_value == 5, "Whatever string %s, this is an int %d", "This is a string", 1)
+#define BLOGF_IF(log_level, condition, format, ...) ((condition) ? Log::WriteDeferred((log_level), __FILE__, __LINE__, (format), ##__VA_ARGS__) : (void)0)
+
 // Usage: RAW_LOGF(LogLevel::eINFO | LogLevel::eDEBUG, "Whatever string %s, this is an int %d", "This is a string", 1)
 #define RAW_LOGF(log_level, ...) Log::WriteRaw((log_level), ToString(__VA_ARGS__))
 // Usage: RAW_LOGF_IF(LogLevel::eINFO | LogLevel::eDEBUG, boolean_value && integer_value == 5, "Whatever string %s, this is an int %d", "This is a string", 1)
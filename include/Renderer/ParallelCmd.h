@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// ***************************************************
+// NOTE:
+// "IRenderer.h" MUST be included before this header!
+// ***************************************************
+
+#pragma once
+
+// Parallel command recording
+// Splits the draws of one render pass over secondary command buffers recorded on the thread system.
+// The primary binds the render targets with LoadActionsDesc::mSecondaryCmds first, e.g.:
+//   loadActions.mSecondaryCmds = true;
+//   cmdBindRenderTargets(pPrimaryCmd, 1, &pRenderTarget, pDepthBuffer, &loadActions, NULL, NULL, -1, -1);
+//   cmdRecordSecondaryCmds(pPrimaryCmd, pThreadSystem, SECONDARY_COUNT, ppSecondaryCmds[frameIdx], drawChunk, &scene);
+//   cmdBindRenderTargets(pPrimaryCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+// Every secondary has to come from its own command pool (command pools are not thread safe) and tasks which bind
+// descriptors need a DescriptorBinder per secondary.
+
+struct ThreadSystem;
+
+/// Records the commands of secondary command buffer index. pCmd is already begun with viewport and scissor unset
+typedef void (*SecondaryCmdFunc)(Cmd* pCmd, uint32_t index, void* pUserData);
+
+/// Begins the secondaries on the calling thread, records them in parallel on pThreadSystem (or serially if NULL),
+/// waits for them and executes them on pPrimaryCmd in index order
+void cmdRecordSecondaryCmds(
+	Cmd* pPrimaryCmd, ThreadSystem* pThreadSystem, uint32_t cmdCount, Cmd** ppSecondaryCmds, SecondaryCmdFunc pFunc, void* pUserData);
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// ***************************************************
+// NOTE:
+// "IRenderer.h" MUST be included before this header!
+// ***************************************************
+
+#pragma once
+
+// Render graph
+// Passes declare the textures, render targets and buffers (or mip / array layer ranges of them) they read and write.
+// compileRenderGraph culls passes whose results are never used, infers the barriers between the passes and assigns the
+// transient render targets to pooled render targets. It only works on the CPU side, the result can be inspected through
+// getRenderGraphBarriers / getRenderGraphMemoryPlan. executeRenderGraph records the barriers and the passes into a Cmd.
+//
+// Typical usage:
+//   addRenderGraph(pRenderer, &pGraph);
+//   RenderGraphResource backBuffer = importRenderGraphResource(pGraph, &importDesc);
+//   RenderGraphResource gbuffer = addRenderGraphRenderTarget(pGraph, &rtDesc, "GBuffer");
+//   addRenderGraphPass(pGraph, &gbufferPassDesc);
+//   addRenderGraphPass(pGraph, &lightingPassDesc);
+//   compileRenderGraph(pGraph);
+//   ...
+//   executeRenderGraph(pGraph, pCmd); // every frame
+
+typedef struct RenderGraph RenderGraph;
+/// Index of a resource in the graph
+typedef uint32_t RenderGraphResource;
+
+#define RENDER_GRAPH_RESOURCE_NONE UINT32_MAX
+
+typedef struct RenderGraphImportDesc
+{
+	/// Exactly one of these is set
+	Texture*      pTexture;
+	RenderTarget* pRenderTarget;
+	Buffer*       pBuffer;
+	/// State of the resource when the graph starts executing, the current state of the resource if RESOURCE_STATE_UNDEFINED
+	ResourceState mInitialState;
+	/// State the resource is left in, mInitialState if RESOURCE_STATE_UNDEFINED
+	ResourceState mFinalState;
+	const char*   pName;
+} RenderGraphImportDesc;
+
+/// A read or write of a resource by a pass
+typedef struct RenderGraphAccess
+{
+	RenderGraphResource mResource;
+	/// State the pass needs the resource in, e.g. RESOURCE_STATE_RENDER_TARGET or RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+	ResourceState mState;
+	bool          mWrite;
+	/// Subresource range (textures and render targets only). A count of 0 covers the remaining levels / layers
+	uint32_t mMipLevel;
+	uint32_t mMipCount;
+	uint32_t mArrayLayer;
+	uint32_t mArrayLayerCount;
+} RenderGraphAccess;
+
+typedef void (*RenderGraphPassFunc)(Cmd* pCmd, RenderGraph* pGraph, void* pUserData);
+
+typedef struct RenderGraphPassDesc
+{
+	const char*         pName;
+	RenderGraphPassFunc pExecute;
+	void*               pUserData;
+	RenderGraphAccess*  pAccesses;
+	uint32_t            mAccessCount;
+	/// Pass is never culled (e.g. writes to a readback buffer the graph does not know about)
+	bool mSideEffects;
+} RenderGraphPassDesc;
+
+typedef enum RenderGraphBarrierType
+{
+	RENDER_GRAPH_BARRIER_FULL = 0,
+	/// Split barrier: the begin half is recorded right after the last pass using the old state,
+	/// the end half right before the first pass using the new state
+	RENDER_GRAPH_BARRIER_BEGIN,
+	RENDER_GRAPH_BARRIER_END,
+} RenderGraphBarrierType;
+
+typedef struct RenderGraphBarrier
+{
+	/// Recorded before this pass, the pass count for the transitions at the end of the graph
+	uint32_t               mPass;
+	RenderGraphResource    mResource;
+	/// RESOURCE_STATE_UNDEFINED on the first use of a transient render target (the contents are discarded)
+	ResourceState          mOldState;
+	ResourceState          mNewState;
+	RenderGraphBarrierType mType;
+	/// Only mip mMipLevel of layer mArrayLayer is transitioned, never split
+	bool                   mSubresource;
+	uint32_t               mMipLevel;
+	uint32_t               mArrayLayer;
+} RenderGraphBarrier;
+
+typedef struct RenderGraphMemoryPlan
+{
+	/// Number of render targets backing the transient render targets of the live passes
+	uint32_t mPhysicalRenderTargetCount;
+	/// Memory of the transient render targets without aliasing
+	uint64_t mTransientSize;
+	/// Memory of the physical render targets
+	uint64_t mAliasedSize;
+} RenderGraphMemoryPlan;
+
+void addRenderGraph(Renderer* pRenderer, RenderGraph** ppGraph);
+/// Releases the pooled render targets as well, the GPU must be done with them
+void removeRenderGraph(RenderGraph* pGraph);
+/// Removes all passes and resources. Pooled render targets are kept for the next compile
+void resetRenderGraph(RenderGraph* pGraph);
+
+RenderGraphResource importRenderGraphResource(RenderGraph* pGraph, const RenderGraphImportDesc* pDesc);
+/// Render target only living inside the graph. Transient render targets with the same desc and disjoint lifetimes
+/// share one render target, their contents are undefined on the first write
+RenderGraphResource addRenderGraphRenderTarget(RenderGraph* pGraph, const RenderTargetDesc* pDesc, const char* pName);
+/// Passes execute in the order they were added, returns the index of the pass
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const RenderGraphPassDesc* pDesc);
+
+bool compileRenderGraph(RenderGraph* pGraph);
+/// Records the barriers and the live passes. Imported resources are left in their final state
+void executeRenderGraph(RenderGraph* pGraph, Cmd* pCmd);
+
+/// Barriers sorted by pass
+void getRenderGraphBarriers(const RenderGraph* pGraph, const RenderGraphBarrier** ppBarriers, uint32_t* pBarrierCount);
+bool isRenderGraphPassCulled(const RenderGraph* pGraph, uint32_t pass);
+void getRenderGraphMemoryPlan(const RenderGraph* pGraph, RenderGraphMemoryPlan* pPlan);
+/// Physical render target a transient render target is assigned to, UINT32_MAX if it is not used by a live pass
+uint32_t getRenderGraphPhysicalIndex(const RenderGraph* pGraph, RenderGraphResource resource);
+
+/// Resource lookup for the pass callbacks. Transient render targets are only valid during executeRenderGraph
+Texture*      getRenderGraphTexture(const RenderGraph* pGraph, RenderGraphResource resource);
+RenderTarget* getRenderGraphRenderTarget(const RenderGraph* pGraph, RenderGraphResource resource);
+Buffer*       getRenderGraphBuffer(const RenderGraph* pGraph, RenderGraphResource resource);
@@ -45,6 +45,19 @@ typedef volatile BASE_ALIGN(8) uint64_t tfrg_atomic64_t; // for SyncToken, from
 #define DEFAULT_MEMORY_BUDGET (uint64_t)6e+7
 #endif
 
+/// Streamer priority class of a request. Each class has its own queue and higher classes get staging memory first,
+/// so a small update never waits behind a large upload of a lower class.
+typedef enum LoadPriority
+{
+	/// Default: resources needed for the current view
+	LOAD_PRIORITY_VISIBLE = 0,
+	/// Processed before everything else (per frame data, resources blocking the render thread)
+	LOAD_PRIORITY_CRITICAL,
+	/// Only gets staging memory left over by the other classes
+	LOAD_PRIORITY_PREFETCH,
+	LOAD_PRIORITY_COUNT,
+} LoadPriority;
+
 typedef struct BufferLoadDesc
 {
 	Buffer**    ppBuffer;
@@ -52,6 +65,7 @@ typedef struct BufferLoadDesc
 	BufferDesc  mDesc;
 	/// Force Reset buffer to NULL
 	bool mForceReset;
+	LoadPriority mPriority;
 } BufferLoadDesc;
 
 typedef struct RawImageData
@@ -83,11 +97,30 @@ typedef struct TextureLoadDesc
 	RawImageData* pRawImageData = NULL;
 	/// Load texture from binary data (with header)
 	BinaryImageData* pBinaryImageData = NULL;
+	/// Generate the mip chain on load if the image only contains the top level
+	bool mGenerateMipMaps = false;
+	MipFilter mMipFilter = MIP_FILTER_BOX;
 
 	// Following is ignored if pDesc != NULL.  pDesc->mFlags will be considered instead.
 	TextureCreationFlags mCreationFlag; 
+	LoadPriority mPriority = LOAD_PRIORITY_VISIBLE;
+	/// Progressive residency (pFilename only): the token completes once the mip tail is resident,
+	/// more detailed levels are streamed in through requestTextureMips
+	bool mStreamMips = false;
 } TextureLoadDesc;
 
+/// Staging memory handed out by beginUpdateResource
+typedef struct MappedStagingMemory
+{
+	Buffer*  pBuffer;
+	uint64_t mOffset;
+	uint64_t mSize;
+	/// Position in the staging ring (UINT64_MAX if the memory comes from a temporary staging buffer)
+	uint64_t mRingOffset;
+	/// Set instead of pBuffer if the API cannot write staging memory from the calling thread
+	void* pSystemMemory;
+} MappedStagingMemory;
+
 typedef struct BufferUpdateDesc
 {
 	BufferUpdateDesc(Buffer* buf = NULL, const void* data = NULL, uint64_t srcOff = 0, uint64_t dstOff = 0, uint64_t size = 0):
@@ -95,21 +128,40 @@ typedef struct BufferUpdateDesc
 		pData(data),
 		mSrcOffset(srcOff),
 		mDstOffset(dstOff),
-		mSize(size)
+		mSize(size),
+		mPriority(LOAD_PRIORITY_VISIBLE),
+		pMappedData(NULL),
+		mInternal()
 	{
 	}
 
-	Buffer*     pBuffer;
-	const void* pData;
-	uint64_t    mSrcOffset;
-	uint64_t    mDstOffset;
-	uint64_t    mSize;    // If 0, uses size of pBuffer
+	Buffer*      pBuffer;
+	const void*  pData;
+	uint64_t     mSrcOffset;
+	uint64_t     mDstOffset;
+	uint64_t     mSize;    // If 0, uses size of pBuffer
+	LoadPriority mPriority;
+	/// Filled by beginUpdateResource: write mSize bytes here instead of providing pData
+	void*               pMappedData;
+	MappedStagingMemory mInternal;
 } BufferUpdateDesc;
 
 typedef struct TextureUpdateDesc
 {
 	Texture* pTexture;
 	RawImageData* pRawImageData = NULL;
+	LoadPriority mPriority = LOAD_PRIORITY_VISIBLE;
+
+	/// Subresource written through beginUpdateResource / endUpdateResource
+	uint32_t mMipLevel = 0;
+	uint32_t mArrayLayer = 0;
+	/// Filled by beginUpdateResource: mRowCount rows (block rows for compressed formats) per slice,
+	/// each one mDstRowPitch bytes apart, slices are mDstSlicePitch bytes apart
+	void*               pMappedData = NULL;
+	uint32_t            mRowCount = 0;
+	uint32_t            mDstRowPitch = 0;
+	uint32_t            mDstSlicePitch = 0;
+	MappedStagingMemory mInternal = {};
 } TextureUpdateDesc;
 
 typedef enum ResourceType
@@ -146,15 +198,35 @@ typedef struct ShaderLoadDesc
 	ShaderTarget        mTarget;
 } ShaderLoadDesc;
 
+/// Tokens grow in submission order. The low bits hold the LoadPriority of the request.
+/// A completed token guarantees all earlier tokens of the same priority class completed as well.
 typedef tfrg_atomic64_t SyncToken;
 
 typedef struct ResourceLoaderDesc
 {
+	/// The staging ring of each GPU is mBufferSize * mBufferCount bytes
 	uint64_t mBufferSize;
+	/// Number of copy command buffers in flight
 	uint32_t mBufferCount;
 	uint32_t mTimesliceMs;
+	/// GPU memory streamed textures may occupy, DEFAULT_MEMORY_BUDGET if 0. Mip tails are always resident
+	uint64_t mMemoryBudget;
 } ResourceLoaderDesc;
 
+typedef struct ResourceLoaderStats
+{
+	/// Bytes written to staging memory and uploaded since the resource loader was created
+	uint64_t mBytesUploaded;
+	/// Upload rate since the previous call to getResourceLoaderStats
+	double mBytesPerSecond;
+	/// Time the streamer waited for the copy queue
+	uint64_t mStallTimeUs;
+	/// Bytes which did not fit into the staging ring and went through temporary staging buffers
+	uint64_t mTempStagingBytes;
+	/// GPU memory held by streamed textures, including textures being built
+	uint64_t mStreamedTextureBytes;
+} ResourceLoaderStats;
+
 
 void initResourceLoaderInterface(Renderer* pRenderer, ResourceLoaderDesc* pDesc = nullptr);
 void removeResourceLoaderInterface(Renderer* pRenderer);
@@ -169,8 +241,35 @@ void updateResource(TextureUpdateDesc* pTexture, bool batch = false);
 void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources);
 void updateResource(BufferUpdateDesc* pBuffer, SyncToken* token);
 void updateResource(TextureUpdateDesc* pTexture, SyncToken* token);
+/// token receives the token of the last queued update. Tokens of different priority classes are not ordered, so it only covers
+/// the updates of that LoadPriority. The overload without a token waits for every class.
 void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources, SyncToken* token);
 
+/// Hands out staging memory for a direct write of pBufferUpdate->mSize bytes (or the whole buffer) into pBufferUpdate->pMappedData.
+/// endUpdateResource queues the copy without an intermediate copy of the data.
+/// Staging memory is only reclaimed after endUpdateResource, so do not wait for other uploads in between
+void beginUpdateResource(BufferUpdateDesc* pBufferUpdate);
+void endUpdateResource(BufferUpdateDesc* pBufferUpdate, SyncToken* token);
+/// Same for the subresource mMipLevel / mArrayLayer of pTextureUpdate->pTexture
+void beginUpdateResource(TextureUpdateDesc* pTextureUpdate);
+void endUpdateResource(TextureUpdateDesc* pTextureUpdate, SyncToken* token);
+
+/// Requests the levels from mostDetailedMip on for a texture loaded with mStreamMips, e.g. from screen space mip feedback.
+/// The levels are streamed in under the memory budget, textures requested least recently get evicted to make room
+void requestTextureMips(Texture* pTexture, uint32_t mostDetailedMip);
+/// Drops the levels above mostDetailedMip (never the mip tail) of a streamed texture. The mip tail kept since its first
+/// upgrade is swapped back in without reading the file, so every level above the tail goes at once
+void evictTextureMips(Texture* pTexture, uint32_t mostDetailedMip);
+/// Level of the full mip chain that is level 0 of the resident texture. Sampling with normalized coordinates
+/// clamps to it on its own, shaders computing explicit LODs for the full chain subtract it
+uint32_t getTextureResidentMip(Texture* pTexture);
+/// Call once per frame on the render thread before recording commands using streamed textures.
+/// Swaps in textures whose new levels completed uploading (the Texture object stays the same) and starts new streaming work
+void updateTextureStreaming();
+
+/// Not thread safe (the upload rate is computed between two calls)
+void getResourceLoaderStats(ResourceLoaderStats* pStats);
+
 bool isBatchCompleted();
 void waitBatchCompleted();
 bool isTokenCompleted(SyncToken token);
@@ -179,7 +278,8 @@ void waitTokenCompleted(SyncToken token);
 void removeResource(Buffer* pBuffer);
 void removeResource(Texture* pTexture);
 
-/// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
+/// Loads the shader bytecode from the content addressed shader cache. Entries are keyed by a hash of the source and its includes,
+/// the macros, the target and the entry point, the shader is compiled and its bytecode stored when the key misses
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader);
 
 void flushResourceUpdates();
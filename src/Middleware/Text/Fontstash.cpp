@@ -161,7 +161,7 @@ class _Impl_FontStash
 		};
 		addDescriptorBinder(pRenderer, 0, 2, descriptorBinderDescs, &pDescriptorBinder);
 
-		addUniformGPURingBuffer(pRenderer, 65536, &pUniformRingBuffer, true);
+		addUniformGPURingBuffer(pRenderer, 65536, &pUniformRingBuffer, true, 4);
 
 		BufferDesc vbDesc = {};
 		vbDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
@@ -169,7 +169,7 @@ class _Impl_FontStash
 		vbDesc.mSize = 1024 * 1024 * sizeof(float4);
 		vbDesc.mVertexStride = sizeof(float4);
 		vbDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
-		addGPURingBuffer(pRenderer, &vbDesc, &pMeshRingBuffer);
+		addGPURingBuffer(pRenderer, &vbDesc, &pMeshRingBuffer, 4);
 
 		mVertexLayout.mAttribCount = 2;
 		mVertexLayout.mAttribs[0].mSemantic = SEMANTIC_POSITION;
@@ -393,6 +393,12 @@ void Fontstash::drawText(
 	fonsDrawText(fs, 0.0f, 0.0f, message, NULL);
 }
 
+void Fontstash::markFrame(Fence* pFence)
+{
+	markGPURingBufferFrame(impl->pMeshRingBuffer, pFence);
+	markGPURingBufferFrame(impl->pUniformRingBuffer, pFence);
+}
+
 float Fontstash::measureText(
 	float* out_bounds, const char* message, float x, float y, int fontID, unsigned int color /*=0xffffffff*/
 	,
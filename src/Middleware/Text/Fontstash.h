@@ -77,6 +77,11 @@ class Fontstash
 		struct Cmd* pCmd, const char* message, const mat4& projView, const mat4& worldMat, int fontID, unsigned int color = 0xffffffff,
 		float size = 16.0f, float spacing = 0.0f, float blur = 0.0f);
 
+	//! Marks the end of a frame. Vertex and uniform data drawn so far is kept alive until pFence completed.
+	//! - Call this after the submission which signals pFence.
+	//! - Without it the ring buffers wrap without knowing which data the GPU still reads.
+	void markFrame(struct Fence* pFence);
+
 	//! Measure text boundaries. Results will be written to out_bounds (x,y,x2,y2).
 	float measureText(
 		float* out_bounds, const char* message, float x, float y, int fontID, unsigned int color = 0xffffffff, float size = 16.0f,
@@ -388,7 +388,7 @@ static void draw_gpu_profile_recurse(
 	Cmd* pCmd, Fontstash* pFontStash, float2& startPos, const GpuProfileDrawDesc* pDrawDesc, struct GpuProfiler* pGpuProfiler,
 	GpuTimerTree* pRoot)
 {
-#if defined(DIRECT3D12) || defined(VULKAN) || defined(DIRECT3D11)
+#if defined(DIRECT3D12) || defined(VULKAN) || defined(DIRECT3D11) || defined(NULL_RENDERER)
 	if (!pRoot)
 		return;
 
@@ -531,6 +531,8 @@ void UIApp::Draw(Cmd* pCmd)
 	}
 }
 
+void UIApp::MarkFrame(Fence* pFence) { pImpl->pFontStash->markFrame(pFence); }
+
 void UIApp::Gui(GuiComponent* pGui) { pImpl->mComponentsToUpdate.emplace_back(pGui); }
 
 IWidget* GuiComponent::AddWidget(const IWidget& widget, bool clone /* = true*/)
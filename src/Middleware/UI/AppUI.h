@@ -657,6 +657,9 @@ class UIApp: public IMiddleware
 
 	void Update(float deltaTime);
 	void Draw(Cmd* cmd);
+	// Call after the submission of the frame which drew text, pFence being the fence it signals.
+	// Keeps the text geometry of the frame alive until the GPU is done with it.
+	void MarkFrame(Fence* pFence);
 
 	uint          LoadFont(const char* pFontPath, uint root);
 	GuiComponent* AddGuiComponent(const char* pTitle, const GuiDesc* pDesc);
@@ -115,16 +115,16 @@ size_t read_file(void *buffer, size_t byteCount, FileHandle handle)
 	return readSize;
 }
 
-bool seek_file(FileHandle handle, long offset, int origin)
+bool seek_file(FileHandle handle, int64_t offset, int origin)
 {
 	// Seek function return -s on error.
-	return AAsset_seek(reinterpret_cast<AAsset*>(handle), offset, origin) != -1;
+	return AAsset_seek64(reinterpret_cast<AAsset*>(handle), offset, origin) != -1;
 }
 
-long tell_file(FileHandle handle)
+int64_t tell_file(FileHandle handle)
 {
-	size_t total_len = AAsset_getLength(reinterpret_cast<AAsset*>(handle));
-	size_t remain_len = AAsset_getRemainingLength(reinterpret_cast<AAsset*>(handle));
+	int64_t total_len = AAsset_getLength64(reinterpret_cast<AAsset*>(handle));
+	int64_t remain_len = AAsset_getRemainingLength64(reinterpret_cast<AAsset*>(handle));
 	return total_len - remain_len;
 	//AAsset_getLength(reinterpret_cast<AAsset*>(handle));
 }
@@ -138,6 +138,33 @@ size_t write_file(const void *buffer, size_t byteCount, FileHandle handle)
 	return -1;
 }
 
+const void* map_file(const char* filename, size_t* pSize, FileHandle* pHandle)
+{
+	*pSize = 0;
+	*pHandle = NULL;
+	if (_mgr == NULL)
+		return NULL;
+
+	// Uncompressed assets are mapped straight out of the apk, compressed ones are inflated once by the asset manager
+	AAsset* file = AAssetManager_open(_mgr, filename, AASSET_MODE_BUFFER);
+	if (file == NULL)
+		return NULL;
+
+	const void* pData = AAsset_getBuffer(file);
+	size_t      size = (size_t)AAsset_getLength(file);
+	if (!pData || !size)
+	{
+		AAsset_close(file);
+		return NULL;
+	}
+
+	*pSize = size;
+	*pHandle = file;
+	return pData;
+}
+
+void unmap_file(const void* pData, size_t size, FileHandle handle) { AAsset_close(reinterpret_cast<AAsset*>(handle)); }
+
 time_t get_file_last_modified_time(const char* _fileName)
 {
 	LOGF(LogLevel::eERROR,"FileSystem::Last Modified Time not supported in Android!");
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "Archive.h"
+
+#include <string.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 65535
+// The last LZ_LAST_LITERALS bytes are always literals and no match starts in the last LZ_MATCH_LIMIT bytes
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT 12
+
+uint64_t archive_hash_path(const char* pPath, size_t length)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= (uint8_t)pPath[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+bool archive_validate(const void* pArchive, size_t size)
+{
+	if (!pArchive || size < sizeof(ArchiveHeader))
+		return false;
+
+	const ArchiveHeader* pHeader = (const ArchiveHeader*)pArchive;
+	if (pHeader->mMagic != ARCHIVE_MAGIC || pHeader->mVersion != ARCHIVE_VERSION)
+		return false;
+	if (!pHeader->mBucketCount || (pHeader->mBucketCount & (pHeader->mBucketCount - 1)))
+		return false;
+	if ((pHeader->mEntryOffset % sizeof(uint64_t)) || (pHeader->mBucketOffset % sizeof(uint32_t)))
+		return false;
+	if (pHeader->mEntryOffset > size || (size - pHeader->mEntryOffset) / sizeof(ArchiveEntry) < pHeader->mEntryCount)
+		return false;
+	if (pHeader->mBucketOffset > size || (size - pHeader->mBucketOffset) / sizeof(uint32_t) < pHeader->mBucketCount)
+		return false;
+	if (pHeader->mNameOffset > size || size - pHeader->mNameOffset < pHeader->mNameSize)
+		return false;
+
+	const uint8_t*      pBase = (const uint8_t*)pArchive;
+	const ArchiveEntry* pEntries = (const ArchiveEntry*)(pBase + pHeader->mEntryOffset);
+	const uint32_t*     pBuckets = (const uint32_t*)(pBase + pHeader->mBucketOffset);
+
+	for (uint32_t i = 0; i < pHeader->mBucketCount; ++i)
+	{
+		if (pBuckets[i] != ARCHIVE_INVALID_INDEX && pBuckets[i] >= pHeader->mEntryCount)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < pHeader->mEntryCount; ++i)
+	{
+		const ArchiveEntry& entry = pEntries[i];
+		if (entry.mOffset > size || size - entry.mOffset < entry.mSize)
+			return false;
+		if (entry.mNameOffset > pHeader->mNameSize || pHeader->mNameSize - entry.mNameOffset < entry.mNameLength)
+			return false;
+		// Chains only point backwards so a lookup always terminates
+		if (entry.mNext != ARCHIVE_INVALID_INDEX && entry.mNext >= i)
+			return false;
+		if (entry.mCompression == ARCHIVE_COMPRESSION_NONE)
+		{
+			if (entry.mSize != entry.mOriginalSize)
+				return false;
+		}
+		else if (entry.mCompression != ARCHIVE_COMPRESSION_LZ || entry.mSize > UINT32_MAX || entry.mOriginalSize > UINT32_MAX)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const ArchiveEntry* archive_find_entry(const void* pArchive, const char* pPath, size_t length)
+{
+	const ArchiveHeader* pHeader = (const ArchiveHeader*)pArchive;
+	const uint8_t*       pBase = (const uint8_t*)pArchive;
+	const ArchiveEntry*  pEntries = (const ArchiveEntry*)(pBase + pHeader->mEntryOffset);
+	const uint32_t*      pBuckets = (const uint32_t*)(pBase + pHeader->mBucketOffset);
+	const char*          pNames = (const char*)(pBase + pHeader->mNameOffset);
+
+	uint64_t hash = archive_hash_path(pPath, length);
+	for (uint32_t i = pBuckets[hash & (pHeader->mBucketCount - 1)]; i != ARCHIVE_INVALID_INDEX; i = pEntries[i].mNext)
+	{
+		const ArchiveEntry& entry = pEntries[i];
+		if (entry.mHash == hash && entry.mNameLength == length && memcmp(pNames + entry.mNameOffset, pPath, length) == 0)
+			return &entry;
+	}
+
+	return NULL;
+}
+/************************************************************************/
+// LZ compression
+/************************************************************************/
+static inline uint32_t lzRead32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t lzHash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - LZ_HASH_BITS); }
+
+static inline uint8_t* lzWriteLength(uint8_t* pDst, uint32_t length)
+{
+	while (length >= 255)
+	{
+		*pDst++ = 255;
+		length -= 255;
+	}
+	*pDst++ = (uint8_t)length;
+	return pDst;
+}
+
+static inline bool lzReadLength(const uint8_t** ppSrc, const uint8_t* pSrcEnd, size_t* pLength)
+{
+	uint8_t byte;
+	do
+	{
+		if (*ppSrc >= pSrcEnd)
+			return false;
+		byte = *(*ppSrc)++;
+		*pLength += byte;
+	} while (byte == 255);
+	return true;
+}
+
+// Emits one sequence: literals followed by an optional match. Returns NULL if it does not fit.
+static uint8_t* lzWriteSequence(
+	uint8_t* pDst, const uint8_t* pDstEnd, const uint8_t* pLiterals, uint32_t literalLength, uint32_t offset, uint32_t matchLength)
+{
+	size_t worstCase = 1 + literalLength / 255 + 1 + literalLength + (offset ? 2 + matchLength / 255 + 1 : 0);
+	if ((size_t)(pDstEnd - pDst) < worstCase)
+		return NULL;
+
+	uint8_t* pToken = pDst++;
+	*pToken = (uint8_t)((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (literalLength >= 15)
+		pDst = lzWriteLength(pDst, literalLength - 15);
+	if (literalLength)
+		memcpy(pDst, pLiterals, literalLength);
+	pDst += literalLength;
+
+	if (offset)
+	{
+		*pDst++ = (uint8_t)(offset & 0xFF);
+		*pDst++ = (uint8_t)(offset >> 8);
+		*pToken |= (uint8_t)(matchLength >= 15 ? 15 : matchLength);
+		if (matchLength >= 15)
+			pDst = lzWriteLength(pDst, matchLength - 15);
+	}
+
+	return pDst;
+}
+
+uint32_t archive_compress_bound(uint32_t srcSize) { return srcSize + srcSize / 255 + 16; }
+
+uint32_t archive_compress(const void* pSrc, uint32_t srcSize, void* pDst, uint32_t dstCapacity)
+{
+	const uint8_t* pIn = (const uint8_t*)pSrc;
+	const uint8_t* pInEnd = pIn + srcSize;
+	const uint8_t* pAnchor = pIn;
+	const uint8_t* pCurrent = pIn;
+	uint8_t*       pOut = (uint8_t*)pDst;
+	const uint8_t* pOutEnd = pOut + dstCapacity;
+
+	if (srcSize > LZ_MATCH_LIMIT)
+	{
+		// Positions of the last occurrence of each hashed 4 byte sequence
+		uint32_t table[1 << LZ_HASH_BITS];
+		memset(table, 0xFF, sizeof(table));
+
+		const uint8_t* pMatchEnd = pInEnd - LZ_LAST_LITERALS;
+		const uint8_t* pSearchEnd = pInEnd - LZ_MATCH_LIMIT;
+		while (pCurrent < pSearchEnd)
+		{
+			uint32_t sequence = lzRead32(pCurrent);
+			uint32_t hash = lzHash(sequence);
+			uint32_t position = (uint32_t)(pCurrent - pIn);
+			uint32_t candidate = table[hash];
+			table[hash] = position;
+
+			if (candidate == ARCHIVE_INVALID_INDEX || position - candidate > LZ_MAX_OFFSET || lzRead32(pIn + candidate) != sequence)
+			{
+				++pCurrent;
+				continue;
+			}
+
+			const uint8_t* pMatch = pIn + candidate + LZ_MIN_MATCH;
+			const uint8_t* pEnd = pCurrent + LZ_MIN_MATCH;
+			while (pEnd < pMatchEnd && *pEnd == *pMatch)
+			{
+				++pEnd;
+				++pMatch;
+			}
+
+			pOut = lzWriteSequence(
+				pOut, pOutEnd, pAnchor, (uint32_t)(pCurrent - pAnchor), position - candidate,
+				(uint32_t)(pEnd - pCurrent) - LZ_MIN_MATCH);
+			if (!pOut)
+				return 0;
+
+			pCurrent = pEnd;
+			pAnchor = pEnd;
+		}
+	}
+
+	pOut = lzWriteSequence(pOut, pOutEnd, pAnchor, (uint32_t)(pInEnd - pAnchor), 0, 0);
+	if (!pOut)
+		return 0;
+
+	return (uint32_t)(pOut - (uint8_t*)pDst);
+}
+
+bool archive_decompress(const void* pSrc, uint32_t srcSize, void* pDst, uint32_t dstSize)
+{
+	const uint8_t* pIn = (const uint8_t*)pSrc;
+	const uint8_t* pInEnd = pIn + srcSize;
+	uint8_t*       pOut = (uint8_t*)pDst;
+	uint8_t*       pOutEnd = pOut + dstSize;
+
+	while (pIn < pInEnd)
+	{
+		uint8_t token = *pIn++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !lzReadLength(&pIn, pInEnd, &literalLength))
+			return false;
+		if ((size_t)(pInEnd - pIn) < literalLength || (size_t)(pOutEnd - pOut) < literalLength)
+			return false;
+		memcpy(pOut, pIn, literalLength);
+		pIn += literalLength;
+		pOut += literalLength;
+
+		// The last sequence has no match
+		if (pIn == pInEnd)
+			break;
+
+		if (pInEnd - pIn < 2)
+			return false;
+		size_t offset = (size_t)pIn[0] | ((size_t)pIn[1] << 8);
+		pIn += 2;
+		if (!offset || offset > (size_t)(pOut - (uint8_t*)pDst))
+			return false;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !lzReadLength(&pIn, pInEnd, &matchLength))
+			return false;
+		matchLength += LZ_MIN_MATCH;
+		if ((size_t)(pOutEnd - pOut) < matchLength)
+			return false;
+
+		const uint8_t* pMatch = pOut - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(pOut, pMatch, matchLength);
+			pOut += matchLength;
+		}
+		else
+		{
+			// Overlapping match repeats the last offset bytes
+			for (size_t i = 0; i < matchLength; ++i)
+				*pOut++ = *pMatch++;
+		}
+	}
+
+	return pOut == pOutEnd;
+}
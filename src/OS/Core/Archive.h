@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Packed read-only asset archive
+//
+// Layout:
+//   ArchiveHeader
+//   Entry data packed into ARCHIVE_BLOCK_SIZE blocks. An entry that fits in the rest of the current block
+//   is placed at the next ARCHIVE_ENTRY_ALIGNMENT boundary, anything else starts on a new block so small
+//   files never straddle two blocks.
+//   ArchiveEntry[mEntryCount]
+//   uint32_t[mBucketCount] - index of the first entry of each hash chain or ARCHIVE_INVALID_INDEX
+//   Entry paths, relative to the packed directory with '/' separators and not null terminated
+//
+// All offsets are from the start of the archive and all values are little endian.
+
+#define ARCHIVE_MAGIC 0x52414654    // 'TFAR'
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK_SIZE (64 * 1024)
+#define ARCHIVE_ENTRY_ALIGNMENT 16
+#define ARCHIVE_INVALID_INDEX 0xFFFFFFFF
+
+typedef enum ArchiveCompression
+{
+	ARCHIVE_COMPRESSION_NONE = 0,
+	// LZ4 block format
+	ARCHIVE_COMPRESSION_LZ,
+} ArchiveCompression;
+
+typedef struct ArchiveHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mEntryCount;
+	// Always a power of two
+	uint32_t mBucketCount;
+	uint64_t mEntryOffset;
+	uint64_t mBucketOffset;
+	uint64_t mNameOffset;
+	uint64_t mNameSize;
+} ArchiveHeader;
+
+typedef struct ArchiveEntry
+{
+	uint64_t mHash;
+	uint64_t mOffset;
+	// Size of the data stored in the archive
+	uint64_t mSize;
+	// Size of the file once decompressed
+	uint64_t mOriginalSize;
+	uint32_t mNameOffset;
+	uint32_t mNameLength;
+	uint32_t mCompression;
+	// Next entry in the same bucket
+	uint32_t mNext;
+} ArchiveEntry;
+
+uint64_t archive_hash_path(const char* pPath, size_t length);
+
+// Checks that the header and tables of an archive in memory are consistent with its size
+bool                archive_validate(const void* pArchive, size_t size);
+// Hash index lookup. pPath has to use '/' separators.
+const ArchiveEntry* archive_find_entry(const void* pArchive, const char* pPath, size_t length);
+
+// Worst case size of archive_compress output
+uint32_t archive_compress_bound(uint32_t srcSize);
+// Returns the compressed size or 0 if the data does not fit in dstCapacity
+uint32_t archive_compress(const void* pSrc, uint32_t srcSize, void* pDst, uint32_t dstCapacity);
+// Returns false if the stream is malformed or does not decompress to exactly dstSize bytes
+bool     archive_decompress(const void* pSrc, uint32_t srcSize, void* pDst, uint32_t dstSize);
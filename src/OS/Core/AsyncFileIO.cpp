@@ -0,0 +1,659 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "EASTL/deque.h"
+
+#include "Interfaces/IThread.h"
+#include "Interfaces/ILog.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define USE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#else
+#define USE_IO_URING 0
+#endif
+
+#include "Atomics.h"
+#include "AsyncFileIO.h"
+#include "Interfaces/IMemory.h"
+
+#define DEFAULT_QUEUE_DEPTH 64
+#define MAX_QUEUE_DEPTH 4096
+#define MAX_IO_THREADS 16
+// Larger reads are split, read and ReadFile can not take more than this at once
+#define MAX_READ_CHUNK (1U << 30)
+#define SHUTDOWN_TOKEN UINT64_MAX
+
+struct AsyncReadRequest
+{
+	AsyncReadDesc mDesc;
+	uint64_t      mBytesRead;
+	bool          mCompleted;
+#if USE_IO_URING
+	struct iovec  mIovec;
+#endif
+};
+
+#if USE_IO_URING
+struct IoUring
+{
+	int                  mFd;
+	void*                pSqRing;
+	size_t               mSqRingSize;
+	void*                pCqRing;
+	size_t               mCqRingSize;
+	struct io_uring_sqe* pSqes;
+	size_t               mSqesSize;
+	tfrg_atomic32_t*     pSqTail;
+	uint32_t*            pSqArray;
+	uint32_t             mSqMask;
+	tfrg_atomic32_t*     pCqHead;
+	tfrg_atomic32_t*     pCqTail;
+	struct io_uring_cqe* pCqes;
+	uint32_t             mCqMask;
+	// Only one thread may fill the submission ring at a time
+	Mutex                mSubmitMutex;
+	ThreadDesc           mThreadDesc;
+	ThreadHandle         mThread;
+};
+#endif
+
+struct AsyncFileIO
+{
+	// Indexed by token, a slot is reused once every earlier token completed
+	AsyncReadRequest*          pRequests;
+	uint32_t                   mQueueDepth;
+	Mutex                      mMutex;
+	ConditionVariable          mCompletedCond;
+	AsyncIOToken               mNextToken;
+	// Every token below this one completed
+	tfrg_atomic64_t            mCompletedToken;
+	// Thread pool backend
+	ConditionVariable          mQueueCond;
+	eastl::deque<AsyncIOToken> mQueue;
+	ThreadDesc*                pThreadDescs;
+	ThreadHandle*              pThreads;
+	uint32_t                   mThreadCount;
+	bool                       mRun;
+#if USE_IO_URING
+	IoUring*                   pRing;
+#endif
+};
+
+static inline AsyncReadRequest* getRequest(AsyncFileIO* pAsyncFileIO, AsyncIOToken token)
+{
+	return &pAsyncFileIO->pRequests[token & (pAsyncFileIO->mQueueDepth - 1)];
+}
+
+static void completeRead(AsyncFileIO* pAsyncFileIO, AsyncIOToken token, int64_t result)
+{
+	AsyncReadRequest* pRequest = getRequest(pAsyncFileIO, token);
+	if (pRequest->mDesc.pCallback)
+		pRequest->mDesc.pCallback(pRequest->mDesc.pUserData, result);
+
+	MutexLock lock(pAsyncFileIO->mMutex);
+	pRequest->mCompleted = true;
+
+	AsyncIOToken completed = pAsyncFileIO->mCompletedToken;
+	if (token != completed)
+		return;
+
+	while (completed < pAsyncFileIO->mNextToken && getRequest(pAsyncFileIO, completed)->mCompleted)
+	{
+		getRequest(pAsyncFileIO, completed)->mCompleted = false;
+		++completed;
+	}
+
+	tfrg_atomic64_store_release(&pAsyncFileIO->mCompletedToken, completed);
+	pAsyncFileIO->mCompletedCond.WakeAll();
+}
+
+// Blocking positional read, only stops early at the end of the file
+static int64_t readFileAt(AsyncFileHandle file, void* pBuffer, uint64_t size, uint64_t offset)
+{
+	uint64_t total = 0;
+	while (total < size)
+	{
+		uint32_t chunk = (uint32_t)min<uint64_t>(size - total, MAX_READ_CHUNK);
+		uint64_t position = offset + total;
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)position;
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+		DWORD bytesRead = 0;
+		if (!ReadFile((HANDLE)file, (uint8_t*)pBuffer + total, chunk, &bytesRead, &overlapped))
+		{
+			DWORD error = GetLastError();
+			if (error == ERROR_HANDLE_EOF)
+				break;
+			return -(int64_t)error;
+		}
+#else
+#if defined(__linux__)
+		ssize_t bytesRead = pread64((int)file, (uint8_t*)pBuffer + total, chunk, (off64_t)position);
+#else
+		ssize_t bytesRead = pread((int)file, (uint8_t*)pBuffer + total, chunk, (off_t)position);
+#endif
+		if (bytesRead < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -(int64_t)errno;
+		}
+#endif
+		if (bytesRead == 0)
+			break;
+		total += bytesRead;
+	}
+
+	return (int64_t)total;
+}
+/************************************************************************/
+// Thread pool backend
+/************************************************************************/
+static void asyncFileIOThreadFunc(void* pData)
+{
+	AsyncFileIO* pAsyncFileIO = (AsyncFileIO*)pData;
+	Thread::SetCurrentThreadName("AsyncFileIO");
+
+	while (true)
+	{
+		pAsyncFileIO->mMutex.Acquire();
+		while (pAsyncFileIO->mRun && pAsyncFileIO->mQueue.empty())
+			pAsyncFileIO->mQueueCond.Wait(pAsyncFileIO->mMutex);
+		if (pAsyncFileIO->mQueue.empty())
+		{
+			pAsyncFileIO->mMutex.Release();
+			return;
+		}
+		AsyncIOToken token = pAsyncFileIO->mQueue.front();
+		pAsyncFileIO->mQueue.pop_front();
+		pAsyncFileIO->mMutex.Release();
+
+		AsyncReadRequest* pRequest = getRequest(pAsyncFileIO, token);
+		int64_t result = readFileAt(pRequest->mDesc.mFile, pRequest->mDesc.pBuffer, pRequest->mDesc.mSize, pRequest->mDesc.mOffset);
+		completeRead(pAsyncFileIO, token, result);
+	}
+}
+/************************************************************************/
+// io_uring backend
+/************************************************************************/
+#if USE_IO_URING
+static inline int ioUringSetup(uint32_t entries, struct io_uring_params* pParams)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, pParams);
+}
+
+static inline int ioUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+// Caller holds mSubmitMutex. Queues the part of the request that has not been read yet.
+static void ioUringQueueRead(IoUring* pRing, AsyncReadRequest* pRequest, AsyncIOToken token)
+{
+	uint32_t             tail = tfrg_atomic32_load_relaxed(pRing->pSqTail);
+	uint32_t             index = tail & pRing->mSqMask;
+	struct io_uring_sqe* pSqe = &pRing->pSqes[index];
+	memset(pSqe, 0, sizeof(*pSqe));
+
+	if (token == SHUTDOWN_TOKEN)
+	{
+		pSqe->opcode = IORING_OP_NOP;
+	}
+	else
+	{
+		pRequest->mIovec.iov_base = (uint8_t*)pRequest->mDesc.pBuffer + pRequest->mBytesRead;
+		pRequest->mIovec.iov_len = (size_t)min<uint64_t>(pRequest->mDesc.mSize - pRequest->mBytesRead, MAX_READ_CHUNK);
+		pSqe->opcode = IORING_OP_READV;
+		pSqe->fd = (int)pRequest->mDesc.mFile;
+		pSqe->off = pRequest->mDesc.mOffset + pRequest->mBytesRead;
+		pSqe->addr = (uint64_t)(uintptr_t)&pRequest->mIovec;
+		pSqe->len = 1;
+	}
+	pSqe->user_data = token;
+
+	pRing->pSqArray[index] = index;
+	tfrg_atomic32_store_release(pRing->pSqTail, tail + 1);
+}
+
+// Caller holds mSubmitMutex. Finishes a read the ring could not take with a blocking read on this thread.
+static void ioUringFallbackRead(AsyncFileIO* pAsyncFileIO, AsyncIOToken token)
+{
+	AsyncReadRequest* pRequest = getRequest(pAsyncFileIO, token);
+	const AsyncReadDesc& desc = pRequest->mDesc;
+	int64_t result = readFileAt(
+		desc.mFile, (uint8_t*)desc.pBuffer + pRequest->mBytesRead, desc.mSize - pRequest->mBytesRead, desc.mOffset + pRequest->mBytesRead);
+	completeRead(pAsyncFileIO, token, result < 0 ? result : (int64_t)pRequest->mBytesRead + result);
+}
+
+// Caller holds mSubmitMutex. Submits the last count queued entries, entries the kernel refuses are taken
+// back out of the ring and read on this thread so their tokens still complete.
+static void ioUringSubmit(AsyncFileIO* pAsyncFileIO, uint32_t count)
+{
+	IoUring* pRing = pAsyncFileIO->pRing;
+	while (count)
+	{
+		int submitted = ioUringEnter(pRing->mFd, count, 0, 0);
+		if (submitted < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+				continue;
+			LOGF(LogLevel::eERROR, "io_uring_enter failed with error %d, reading %u requests synchronously", errno, count);
+			break;
+		}
+		count -= (uint32_t)submitted;
+	}
+
+	if (!count)
+		return;
+
+	// Without SQPOLL the kernel only consumes entries inside io_uring_enter, so the unsubmitted tail is still ours
+	uint32_t tail = tfrg_atomic32_load_relaxed(pRing->pSqTail) - count;
+	tfrg_atomic32_store_release(pRing->pSqTail, tail);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		AsyncIOToken token = pRing->pSqes[(tail + i) & pRing->mSqMask].user_data;
+		if (token == SHUTDOWN_TOKEN)
+			LOGF(LogLevel::eERROR, "Could not submit the io_uring shutdown request");
+		else
+			ioUringFallbackRead(pAsyncFileIO, token);
+	}
+}
+
+static void ioUringResubmit(AsyncFileIO* pAsyncFileIO, AsyncReadRequest* pRequest, AsyncIOToken token)
+{
+	IoUring*  pRing = pAsyncFileIO->pRing;
+	MutexLock lock(pRing->mSubmitMutex);
+	ioUringQueueRead(pRing, pRequest, token);
+	ioUringSubmit(pAsyncFileIO, 1);
+}
+
+static void ioUringThreadFunc(void* pData)
+{
+	AsyncFileIO* pAsyncFileIO = (AsyncFileIO*)pData;
+	IoUring*     pRing = pAsyncFileIO->pRing;
+	Thread::SetCurrentThreadName("AsyncFileIO");
+
+	bool run = true;
+	while (run)
+	{
+		if (ioUringEnter(pRing->mFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+			LOGF(LogLevel::eERROR, "io_uring_enter failed with error %d", errno);
+
+		uint32_t head = tfrg_atomic32_load_relaxed(pRing->pCqHead);
+		uint32_t tail = tfrg_atomic32_load_acquire(pRing->pCqTail);
+		for (; head != tail; ++head)
+		{
+			const struct io_uring_cqe* pCqe = &pRing->pCqes[head & pRing->mCqMask];
+			AsyncIOToken               token = pCqe->user_data;
+			int32_t                    result = pCqe->res;
+			if (token == SHUTDOWN_TOKEN)
+			{
+				run = false;
+				continue;
+			}
+
+			AsyncReadRequest* pRequest = getRequest(pAsyncFileIO, token);
+			if (result == -EINTR || result == -EAGAIN)
+			{
+				ioUringResubmit(pAsyncFileIO, pRequest, token);
+				continue;
+			}
+			if (result < 0)
+			{
+				completeRead(pAsyncFileIO, token, result);
+				continue;
+			}
+
+			// Short reads continue where they stopped unless the end of the file was reached
+			pRequest->mBytesRead += (uint32_t)result;
+			if (result > 0 && pRequest->mBytesRead < pRequest->mDesc.mSize)
+			{
+				ioUringResubmit(pAsyncFileIO, pRequest, token);
+				continue;
+			}
+
+			completeRead(pAsyncFileIO, token, (int64_t)pRequest->mBytesRead);
+		}
+		tfrg_atomic32_store_release(pRing->pCqHead, head);
+	}
+}
+
+static void exitIoUring(IoUring* pRing)
+{
+	if (pRing->pSqes)
+		munmap(pRing->pSqes, pRing->mSqesSize);
+	if (pRing->pCqRing && pRing->pCqRing != pRing->pSqRing)
+		munmap(pRing->pCqRing, pRing->mCqRingSize);
+	if (pRing->pSqRing)
+		munmap(pRing->pSqRing, pRing->mSqRingSize);
+	close(pRing->mFd);
+	conf_delete(pRing);
+}
+
+static bool initIoUring(AsyncFileIO* pAsyncFileIO)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = ioUringSetup(pAsyncFileIO->mQueueDepth, &params);
+	if (fd < 0)
+		return false;
+
+	IoUring* pRing = conf_new(IoUring);
+	pRing->mFd = fd;
+	pRing->pSqRing = NULL;
+	pRing->pCqRing = NULL;
+	pRing->pSqes = NULL;
+	pRing->mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	pRing->mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	pRing->mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap)
+		pRing->mSqRingSize = pRing->mCqRingSize = max(pRing->mSqRingSize, pRing->mCqRingSize);
+
+	void* pSqRing = mmap(NULL, pRing->mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	pRing->pSqRing = pSqRing != MAP_FAILED ? pSqRing : NULL;
+	if (singleMap)
+	{
+		pRing->pCqRing = pRing->pSqRing;
+	}
+	else
+	{
+		void* pCqRing = mmap(NULL, pRing->mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		pRing->pCqRing = pCqRing != MAP_FAILED ? pCqRing : NULL;
+	}
+	void* pSqes = mmap(NULL, pRing->mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	pRing->pSqes = pSqes != MAP_FAILED ? (struct io_uring_sqe*)pSqes : NULL;
+
+	if (!pRing->pSqRing || !pRing->pCqRing || !pRing->pSqes)
+	{
+		exitIoUring(pRing);
+		return false;
+	}
+
+	uint8_t* pSq = (uint8_t*)pRing->pSqRing;
+	pRing->pSqTail = (tfrg_atomic32_t*)(pSq + params.sq_off.tail);
+	pRing->pSqArray = (uint32_t*)(pSq + params.sq_off.array);
+	pRing->mSqMask = *(uint32_t*)(pSq + params.sq_off.ring_mask);
+
+	uint8_t* pCq = (uint8_t*)pRing->pCqRing;
+	pRing->pCqHead = (tfrg_atomic32_t*)(pCq + params.cq_off.head);
+	pRing->pCqTail = (tfrg_atomic32_t*)(pCq + params.cq_off.tail);
+	pRing->pCqes = (struct io_uring_cqe*)(pCq + params.cq_off.cqes);
+	pRing->mCqMask = *(uint32_t*)(pCq + params.cq_off.ring_mask);
+
+	pAsyncFileIO->pRing = pRing;
+	pRing->mThreadDesc.pFunc = ioUringThreadFunc;
+	pRing->mThreadDesc.pData = pAsyncFileIO;
+	pRing->mThread = create_thread(&pRing->mThreadDesc);
+	return true;
+}
+
+static void shutdownIoUring(AsyncFileIO* pAsyncFileIO)
+{
+	IoUring* pRing = pAsyncFileIO->pRing;
+	pRing->mSubmitMutex.Acquire();
+	ioUringQueueRead(pRing, NULL, SHUTDOWN_TOKEN);
+	ioUringSubmit(pAsyncFileIO, 1);
+	pRing->mSubmitMutex.Release();
+
+	destroy_thread(pRing->mThread);
+	exitIoUring(pRing);
+}
+#endif
+/************************************************************************/
+// Interface
+/************************************************************************/
+void initAsyncFileIO(const AsyncFileIODesc* pDesc, AsyncFileIO** ppAsyncFileIO)
+{
+	AsyncFileIO* pAsyncFileIO = conf_new(AsyncFileIO);
+
+	uint32_t queueDepth = min<uint32_t>(pDesc->mQueueDepth ? pDesc->mQueueDepth : DEFAULT_QUEUE_DEPTH, MAX_QUEUE_DEPTH);
+	uint32_t powerOfTwoDepth = 1;
+	while (powerOfTwoDepth < queueDepth)
+		powerOfTwoDepth <<= 1;
+
+	pAsyncFileIO->mQueueDepth = powerOfTwoDepth;
+	pAsyncFileIO->pRequests = (AsyncReadRequest*)conf_calloc(powerOfTwoDepth, sizeof(AsyncReadRequest));
+	// Token 0 is never handed out so an empty batch submitted first is already completed
+	pAsyncFileIO->mNextToken = 1;
+	pAsyncFileIO->mCompletedToken = 1;
+	pAsyncFileIO->pThreadDescs = NULL;
+	pAsyncFileIO->pThreads = NULL;
+	pAsyncFileIO->mThreadCount = 0;
+	pAsyncFileIO->mRun = true;
+
+	bool native = false;
+#if USE_IO_URING
+	pAsyncFileIO->pRing = NULL;
+	if (!pDesc->mForceThreadPool)
+		native = initIoUring(pAsyncFileIO);
+#endif
+
+	if (!native)
+	{
+		uint32_t threadCount = pDesc->mThreadCount ? pDesc->mThreadCount : min<uint32_t>(powerOfTwoDepth, MAX_IO_THREADS);
+		pAsyncFileIO->mThreadCount = threadCount;
+		pAsyncFileIO->pThreadDescs = (ThreadDesc*)conf_calloc(threadCount, sizeof(ThreadDesc));
+		pAsyncFileIO->pThreads = (ThreadHandle*)conf_calloc(threadCount, sizeof(ThreadHandle));
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			pAsyncFileIO->pThreadDescs[i].pFunc = asyncFileIOThreadFunc;
+			pAsyncFileIO->pThreadDescs[i].pData = pAsyncFileIO;
+			pAsyncFileIO->pThreads[i] = create_thread(&pAsyncFileIO->pThreadDescs[i]);
+		}
+	}
+
+	LOGF(LogLevel::eINFO, "Async file I/O: %s, queue depth %u", native ? "io_uring" : "thread pool", powerOfTwoDepth);
+	*ppAsyncFileIO = pAsyncFileIO;
+}
+
+void shutdownAsyncFileIO(AsyncFileIO* pAsyncFileIO)
+{
+	pAsyncFileIO->mMutex.Acquire();
+	AsyncIOToken lastToken = pAsyncFileIO->mNextToken - 1;
+	pAsyncFileIO->mMutex.Release();
+	waitAsyncIOTokenCompleted(pAsyncFileIO, lastToken);
+
+#if USE_IO_URING
+	if (pAsyncFileIO->pRing)
+		shutdownIoUring(pAsyncFileIO);
+#endif
+
+	pAsyncFileIO->mMutex.Acquire();
+	pAsyncFileIO->mRun = false;
+	pAsyncFileIO->mQueueCond.WakeAll();
+	pAsyncFileIO->mMutex.Release();
+
+	for (uint32_t i = 0; i < pAsyncFileIO->mThreadCount; ++i)
+		destroy_thread(pAsyncFileIO->pThreads[i]);
+
+	conf_free(pAsyncFileIO->pThreads);
+	conf_free(pAsyncFileIO->pThreadDescs);
+	conf_free(pAsyncFileIO->pRequests);
+	conf_delete(pAsyncFileIO);
+}
+
+bool isAsyncFileIONative(AsyncFileIO* pAsyncFileIO)
+{
+#if USE_IO_URING
+	return pAsyncFileIO->pRing != NULL;
+#else
+	return false;
+#endif
+}
+
+bool openAsyncFile(const eastl::string& fileName, FSRoot root, AsyncFileHandle* pFile)
+{
+	eastl::string path = FileSystem::FixPath(fileName, root);
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		LOGF(LogLevel::eERROR, "Could not open file %s", path.c_str());
+		return false;
+	}
+	*pFile = file;
+#else
+	int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_LARGEFILE
+	flags |= O_LARGEFILE;
+#endif
+	int fd = open(path.c_str(), flags);
+	if (fd < 0)
+	{
+		LOGF(LogLevel::eERROR, "Could not open file %s", path.c_str());
+		return false;
+	}
+	*pFile = fd;
+#endif
+	return true;
+}
+
+void closeAsyncFile(AsyncFileHandle file)
+{
+#ifdef _WIN32
+	CloseHandle((HANDLE)file);
+#else
+	close((int)file);
+#endif
+}
+
+uint64_t getAsyncFileSize(AsyncFileHandle file)
+{
+#ifdef _WIN32
+	LARGE_INTEGER size = {};
+	return GetFileSizeEx((HANDLE)file, &size) ? (uint64_t)size.QuadPart : 0;
+#elif defined(__linux__)
+	struct stat64 fileInfo = {};
+	return fstat64((int)file, &fileInfo) == 0 ? (uint64_t)fileInfo.st_size : 0;
+#else
+	struct stat fileInfo = {};
+	return fstat((int)file, &fileInfo) == 0 ? (uint64_t)fileInfo.st_size : 0;
+#endif
+}
+
+AsyncIOToken addAsyncReads(AsyncFileIO* pAsyncFileIO, uint32_t count, const AsyncReadDesc* pDescs)
+{
+	// An empty batch completes with everything submitted before it
+	if (!count)
+	{
+		MutexLock lock(pAsyncFileIO->mMutex);
+		return pAsyncFileIO->mNextToken - 1;
+	}
+
+	AsyncIOToken lastToken = 0;
+	uint32_t     submitted = 0;
+
+	while (submitted < count)
+	{
+		pAsyncFileIO->mMutex.Acquire();
+		while (pAsyncFileIO->mNextToken - pAsyncFileIO->mCompletedToken >= pAsyncFileIO->mQueueDepth)
+			pAsyncFileIO->mCompletedCond.Wait(pAsyncFileIO->mMutex);
+
+		uint32_t     available = pAsyncFileIO->mQueueDepth - (uint32_t)(pAsyncFileIO->mNextToken - pAsyncFileIO->mCompletedToken);
+		uint32_t     batchCount = min(available, count - submitted);
+		AsyncIOToken firstToken = pAsyncFileIO->mNextToken;
+		pAsyncFileIO->mNextToken += batchCount;
+		lastToken = pAsyncFileIO->mNextToken - 1;
+
+		for (uint32_t i = 0; i < batchCount; ++i)
+		{
+			AsyncReadRequest* pRequest = getRequest(pAsyncFileIO, firstToken + i);
+			pRequest->mDesc = pDescs[submitted + i];
+			pRequest->mBytesRead = 0;
+			pRequest->mCompleted = false;
+		}
+
+		bool native = isAsyncFileIONative(pAsyncFileIO);
+		if (!native)
+		{
+			for (uint32_t i = 0; i < batchCount; ++i)
+			{
+				if (pDescs[submitted + i].mSize)
+				{
+					pAsyncFileIO->mQueue.push_back(firstToken + i);
+					pAsyncFileIO->mQueueCond.WakeOne();
+				}
+			}
+		}
+		pAsyncFileIO->mMutex.Release();
+
+#if USE_IO_URING
+		if (native)
+		{
+			IoUring* pRing = pAsyncFileIO->pRing;
+			uint32_t queued = 0;
+			MutexLock lock(pRing->mSubmitMutex);
+			for (uint32_t i = 0; i < batchCount; ++i)
+			{
+				if (pDescs[submitted + i].mSize)
+				{
+					ioUringQueueRead(pRing, getRequest(pAsyncFileIO, firstToken + i), firstToken + i);
+					++queued;
+				}
+			}
+			ioUringSubmit(pAsyncFileIO, queued);
+		}
+#endif
+
+		// Nothing to read, complete these right away
+		for (uint32_t i = 0; i < batchCount; ++i)
+		{
+			if (!pDescs[submitted + i].mSize)
+				completeRead(pAsyncFileIO, firstToken + i, 0);
+		}
+
+		submitted += batchCount;
+	}
+
+	return lastToken;
+}
+
+bool isAsyncIOTokenCompleted(AsyncFileIO* pAsyncFileIO, AsyncIOToken token)
+{
+	return token < tfrg_atomic64_load_acquire(&pAsyncFileIO->mCompletedToken);
+}
+
+void waitAsyncIOTokenCompleted(AsyncFileIO* pAsyncFileIO, AsyncIOToken token)
+{
+	if (isAsyncIOTokenCompleted(pAsyncFileIO, token))
+		return;
+
+	MutexLock lock(pAsyncFileIO->mMutex);
+	while (token >= pAsyncFileIO->mCompletedToken)
+		pAsyncFileIO->mCompletedCond.Wait(pAsyncFileIO->mMutex);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "Interfaces/IFileSystem.h"
+
+/// Batched asynchronous reads. Uses io_uring on Linux when the kernel provides it
+/// and a pool of threads issuing positional reads everywhere else.
+struct AsyncFileIO;
+
+#ifdef _WIN32
+typedef void* AsyncFileHandle;
+#else
+typedef intptr_t AsyncFileHandle;
+#endif
+
+/// Every read gets a token in submission order. A token is completed once it and all earlier reads finished.
+typedef uint64_t AsyncIOToken;
+
+/// Runs on an I/O thread once the read finished and must not submit reads itself.
+/// bytesRead is -errno on failure and only shorter than the request at the end of the file.
+typedef void (*AsyncReadCallback)(void* pUserData, int64_t bytesRead);
+
+struct AsyncFileIODesc
+{
+	/// Maximum number of reads in flight, rounded up to a power of two. 0 picks the default.
+	uint32_t mQueueDepth;
+	/// Threads of the fallback backend. 0 picks the default.
+	uint32_t mThreadCount;
+	/// Skip io_uring even if it is available
+	bool     mForceThreadPool;
+};
+
+struct AsyncReadDesc
+{
+	AsyncFileHandle   mFile;
+	uint64_t          mOffset;
+	uint64_t          mSize;
+	void*             pBuffer;
+	/// Optional
+	AsyncReadCallback pCallback;
+	void*             pUserData;
+};
+
+void initAsyncFileIO(const AsyncFileIODesc* pDesc, AsyncFileIO** ppAsyncFileIO);
+/// Waits for all reads in flight
+void shutdownAsyncFileIO(AsyncFileIO* pAsyncFileIO);
+bool isAsyncFileIONative(AsyncFileIO* pAsyncFileIO);
+
+bool     openAsyncFile(const eastl::string& fileName, FSRoot root, AsyncFileHandle* pFile);
+void     closeAsyncFile(AsyncFileHandle file);
+uint64_t getAsyncFileSize(AsyncFileHandle file);
+
+/// Blocks while the queue is full. Returns the token that completes with the last read of the batch.
+AsyncIOToken addAsyncReads(AsyncFileIO* pAsyncFileIO, uint32_t count, const AsyncReadDesc* pDescs);
+bool         isAsyncIOTokenCompleted(AsyncFileIO* pAsyncFileIO, AsyncIOToken token);
+void         waitAsyncIOTokenCompleted(AsyncFileIO* pAsyncFileIO, AsyncIOToken token);
@@ -45,6 +45,7 @@
 #include <sys/wait.h>
 #include <dirent.h>
 #endif
+#include "Archive.h"
 #include "Interfaces/IMemory.h"
 
 void translateFileAccessFlags(FileMode modeFlags, char* fileAccesString, int strLength)
@@ -100,6 +101,70 @@ extern const char* pszBases[];
 
 static inline unsigned SDBMHash(unsigned hash, unsigned char c) { return c + (hash << 6) + (hash << 16) - hash; }
 
+/************************************************************************/
+// Archive mounting
+/************************************************************************/
+struct MountedArchive
+{
+	FSRoot        mRoot;
+	// Fixed path of the root, entries are stored relative to it
+	eastl::string mPrefix;
+	MappedFile*   pFile;
+};
+
+static eastl::vector<MountedArchive> gMountedArchives;
+
+// Looks a fixed path up in every archive whose root contains it, preferring the most specific root
+static const ArchiveEntry* findArchiveEntry(const eastl::string& fixedPath, const uint8_t** ppArchive)
+{
+	if (gMountedArchives.empty())
+		return NULL;
+
+	eastl::string       path = FileSystem::GetInternalPath(fixedPath);
+	const ArchiveEntry* pFound = NULL;
+	size_t              foundPrefixSize = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)gMountedArchives.size(); ++i)
+	{
+		const MountedArchive& archive = gMountedArchives[i];
+		size_t                prefixSize = archive.mPrefix.size();
+		if (path.size() <= prefixSize || path.compare(0, prefixSize, archive.mPrefix) != 0)
+			continue;
+		if (pFound && prefixSize <= foundPrefixSize)
+			continue;
+
+		const uint8_t*      pArchive = (const uint8_t*)archive.pFile->GetData();
+		const ArchiveEntry* pEntry = archive_find_entry(pArchive, path.c_str() + prefixSize, path.size() - prefixSize);
+		if (pEntry)
+		{
+			pFound = pEntry;
+			foundPrefixSize = prefixSize;
+			*ppArchive = pArchive;
+		}
+	}
+
+	return pFound;
+}
+
+// Returns the contents of an archive entry. Compressed entries are decoded into *ppBuffer which the caller has to free.
+static const unsigned char* readArchiveEntry(const uint8_t* pArchive, const ArchiveEntry* pEntry, void** ppBuffer)
+{
+	*ppBuffer = NULL;
+	if (pEntry->mCompression == ARCHIVE_COMPRESSION_NONE)
+		return pArchive + pEntry->mOffset;
+
+	void* pBuffer = conf_malloc(pEntry->mOriginalSize ? (size_t)pEntry->mOriginalSize : 1);
+	if (!archive_decompress(pArchive + pEntry->mOffset, (uint32_t)pEntry->mSize, pBuffer, (uint32_t)pEntry->mOriginalSize))
+	{
+		LOGF(LogLevel::eERROR, "Archive entry is corrupted");
+		conf_free(pBuffer);
+		return NULL;
+	}
+
+	*ppBuffer = pBuffer;
+	return (const unsigned char*)pBuffer;
+}
+
 /************************************************************************/
 // Deserializer implementation
 /************************************************************************/
@@ -344,7 +409,17 @@ bool Serializer::WriteLine(const eastl::string& value)
 /************************************************************************/
 // File implementation
 /************************************************************************/
-File::File(): mMode(FileMode::FM_Read), pHandle(0), mOffset(0), mChecksum(0), mReadSyncNeeded(false), mWriteSyncNeeded(false) {}
+File::File():
+	mMode(FileMode::FM_Read),
+	pHandle(0),
+	mOffset(0),
+	mChecksum(0),
+	mReadSyncNeeded(false),
+	mWriteSyncNeeded(false),
+	pArchiveData(NULL),
+	pArchiveBuffer(NULL)
+{
+}
 
 bool File::Open(const eastl::string& _fileName, FileMode mode, FSRoot root)
 {
@@ -358,6 +433,37 @@ bool File::Open(const eastl::string& _fileName, FileMode mode, FSRoot root)
 		return false;
 	}
 
+	if (!(mode & (FileMode::FM_Write | FileMode::FM_Append)))
+	{
+		const uint8_t*      pArchive = NULL;
+		const ArchiveEntry* pEntry = findArchiveEntry(fileName, &pArchive);
+		if (pEntry)
+		{
+			if (pEntry->mOriginalSize > UINT_MAX)
+			{
+				LOGF(LogLevel::eERROR, "Could not open file %s which is larger than 4GB", fileName.c_str());
+				return false;
+			}
+
+			pArchiveData = readArchiveEntry(pArchive, pEntry, &pArchiveBuffer);
+			if (!pArchiveData)
+			{
+				LOGF(LogLevel::eERROR, "Could not open file %s", fileName.c_str());
+				return false;
+			}
+
+			mFileName = fileName;
+			mMode = mode;
+			mPosition = 0;
+			mOffset = 0;
+			mChecksum = 0;
+			mReadSyncNeeded = false;
+			mWriteSyncNeeded = false;
+			mSize = (unsigned)pEntry->mOriginalSize;
+			return true;
+		}
+	}
+
 	char fileAcessStr[8];
 	translateFileAccessFlags(mode, fileAcessStr, sizeof(fileAcessStr));
 	pHandle = open_file(fileName.c_str(), fileAcessStr);
@@ -376,7 +482,7 @@ bool File::Open(const eastl::string& _fileName, FileMode mode, FSRoot root)
 	mReadSyncNeeded = false;
 	mWriteSyncNeeded = false;
 
-	size_t size = FileSystem::GetFileSize(pHandle);
+	uint64_t size = FileSystem::GetFileSize(pHandle);
 	if (size > UINT_MAX)
 	{
 		LOGF(LogLevel::eERROR, "Could not open file %s which is larger than 4GB", fileName.c_str());
@@ -392,6 +498,16 @@ bool File::Open(const eastl::string& _fileName, FileMode mode, FSRoot root)
 bool File::Close()
 {
 	bool ret = false;
+	if (pArchiveData)
+	{
+		conf_free(pArchiveBuffer);
+		pArchiveData = NULL;
+		pArchiveBuffer = NULL;
+		mPosition = 0;
+		mSize = 0;
+		mChecksum = 0;
+		ret = true;
+	}
 	if (pHandle)
 	{
 		ret = close_file(pHandle);
@@ -412,7 +528,7 @@ void File::Flush()
 
 unsigned File::Read(void* dest, unsigned size)
 {
-	if (!pHandle)
+	if (!IsOpen())
 	{
 		// Avoid spamming stderr
 		return 0;
@@ -429,6 +545,13 @@ unsigned File::Read(void* dest, unsigned size)
 	if (!size)
 		return 0;
 
+	if (pArchiveData)
+	{
+		memcpy(dest, pArchiveData + mPosition, size);
+		mPosition += size;
+		return size;
+	}
+
 	if (mReadSyncNeeded)
 	{
 		seek_file(pHandle, mPosition + mOffset, SEEK_SET);
@@ -443,7 +566,7 @@ unsigned File::Read(void* dest, unsigned size)
 
 unsigned File::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BEGIN*/)
 {
-	if (!pHandle)
+	if (!IsOpen())
 	{
 		// Avoid spamming stderr
 		return 0;
@@ -453,6 +576,12 @@ unsigned File::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BE
 	if ((mMode & FileMode::FM_Read || mMode & FileMode::FM_Append) && position > mSize)
 		position = mSize;
 
+	if (pArchiveData)
+	{
+		mPosition = position;
+		return mPosition;
+	}
+
 	int origin = -1;
 	switch (seekDir)
 	{
@@ -470,6 +599,11 @@ unsigned File::Seek(unsigned position, SeekDir seekDir /* = SeekDir::SEEK_DIR_BE
 
 unsigned File::Tell()
 {
+    if (pArchiveData)
+    {
+        return mPosition;
+    }
+
     if (!pHandle)
     {
         return 0;
@@ -525,7 +659,7 @@ unsigned File::GetChecksum()
 	if (mOffset || mChecksum)
 		return mChecksum;
 
-	if (!pHandle || IsWriteOnly())
+	if (!IsOpen() || IsWriteOnly())
 		return 0;
 
 	unsigned oldPos = mPosition;
@@ -660,6 +794,64 @@ unsigned MemoryBuffer::Write(const void* data, unsigned size)
 	return size;
 }
 /************************************************************************/
+// MappedFile implementation
+/************************************************************************/
+MappedFile::MappedFile(): pData(NULL), mSize(0), pHandle(NULL), pArchiveBuffer(NULL), mFromArchive(false) {}
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const eastl::string& _fileName, FSRoot root)
+{
+	eastl::string fileName = FileSystem::FixPath(_fileName, root);
+
+	Close();
+
+	if (fileName.size() == 0)
+	{
+		LOGF(LogLevel::eERROR, "Could not map file with empty name");
+		return false;
+	}
+
+	const uint8_t*      pArchive = NULL;
+	const ArchiveEntry* pEntry = findArchiveEntry(fileName, &pArchive);
+	if (pEntry)
+	{
+		pData = pEntry->mOriginalSize ? readArchiveEntry(pArchive, pEntry, &pArchiveBuffer) : NULL;
+		mSize = (size_t)pEntry->mOriginalSize;
+		mFromArchive = pData != NULL;
+	}
+	else
+	{
+		pData = map_file(fileName.c_str(), &mSize, &pHandle);
+	}
+
+	if (!pData)
+	{
+		LOGF(LogLevel::eERROR, "Could not map file %s", fileName.c_str());
+		mSize = 0;
+		return false;
+	}
+
+	mFileName = fileName;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (pData)
+	{
+		if (mFromArchive)
+			conf_free(pArchiveBuffer);
+		else
+			unmap_file(pData, mSize, pHandle);
+		pData = NULL;
+		mSize = 0;
+		pHandle = NULL;
+		pArchiveBuffer = NULL;
+		mFromArchive = false;
+	}
+}
+/************************************************************************/
 /************************************************************************/
 eastl::string FileSystem::mModifiedRootPaths[FSRoot::FSR_Count] = { "" };
 eastl::string FileSystem::mProgramDir = "";
@@ -680,18 +872,21 @@ time_t FileSystem::GetLastModifiedTime(const eastl::string& fileName) { return g
 time_t FileSystem::GetLastAccessedTime(const eastl::string& fileName) { return get_file_last_accessed_time(fileName.c_str()); }
 time_t FileSystem::GetCreationTime(const eastl::string& fileName) { return get_file_creation_time(fileName.c_str()); }
 
-unsigned FileSystem::GetFileSize(FileHandle handle)
+uint64_t FileSystem::GetFileSize(FileHandle handle)
 {
-	long curPos = tell_file((::FILE*)handle);
+	int64_t curPos = tell_file((::FILE*)handle);
 	seek_file(handle, 0, SEEK_END);
-	size_t length = tell_file((::FILE*)handle);
+	int64_t length = tell_file((::FILE*)handle);
 	seek_file((::FILE*)handle, curPos, SEEK_SET);
-	return (unsigned)length;
+	return length > 0 ? (uint64_t)length : 0;
 }
 
 bool FileSystem::FileExists(const eastl::string& _fileName, FSRoot _root)
 {
 	eastl::string fileName = FileSystem::FixPath(_fileName, _root);
+	const uint8_t* pArchive = NULL;
+	if (findArchiveEntry(fileName, &pArchive))
+		return true;
 #ifdef _DURANGO
 	return (fopen(fileName.c_str(), "rb") != NULL);
 #else
@@ -765,6 +960,44 @@ eastl::string FileSystem::FixPath(const eastl::string& pszFileName, FSRoot root)
 	return res;
 }
 
+bool FileSystem::MountArchive(FSRoot root, const eastl::string& archiveFileName)
+{
+	ASSERT(root < FSR_Absolute);
+
+	MappedFile* pFile = conf_new(MappedFile);
+	if (!pFile->Open(archiveFileName, FSR_OtherFiles))
+	{
+		conf_delete(pFile);
+		return false;
+	}
+
+	if (!archive_validate(pFile->GetData(), pFile->GetSize()))
+	{
+		LOGF(LogLevel::eERROR, "%s is not a valid archive", pFile->GetName().c_str());
+		conf_delete(pFile);
+		return false;
+	}
+
+	UnmountArchive(root);
+
+	MountedArchive archive = { root, GetInternalPath(FixPath("", root)), pFile };
+	gMountedArchives.push_back(archive);
+	return true;
+}
+
+void FileSystem::UnmountArchive(FSRoot root)
+{
+	for (uint32_t i = 0; i < (uint32_t)gMountedArchives.size(); ++i)
+	{
+		if (gMountedArchives[i].mRoot == root)
+		{
+			conf_delete(gMountedArchives[i].pFile);
+			gMountedArchives.erase(gMountedArchives.begin() + i);
+			return;
+		}
+	}
+}
+
 eastl::string FileSystem::GetRootPath(FSRoot root)
 {
 	if (mModifiedRootPaths[root].size())
@@ -1053,3 +1286,12 @@ bool FileSystem::Delete(const eastl::string& fileName)
 	return remove(GetNativePath(fileName).c_str()) == 0;
 #endif
 }
+
+bool FileSystem::Rename(const eastl::string& src, const eastl::string& dst)
+{
+#ifdef _WIN32
+	return MoveFileExA(GetNativePath(src).c_str(), GetNativePath(dst).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(GetNativePath(src).c_str(), GetNativePath(dst).c_str()) == 0;
+#endif
+}
@@ -27,6 +27,9 @@
 #include "Renderer/IRenderer.h"
 #include "Renderer/ResourceLoader.h"
 #include "Interfaces/ILog.h"
+#include "Interfaces/IThread.h"
+#include "Interfaces/ITime.h"
+#include "OS/Core/Atomics.h"
 
 #define MEM_MANAGER_FROM_HEADER
 #include "Interfaces/IMemory.h"
@@ -34,14 +37,73 @@
 /************************************************************************/
 /* RING BUFFER MANAGEMENT											  */
 /************************************************************************/
+/* Allocations are sub-allocated lock free from the current page by advancing a virtual head offset.
+ * markGPURingBufferFrame records the head of every page together with the fence signaled by the submission
+ * which consumes the data. Once that fence completed, the tail of the page is moved up to the recorded head.
+ * An allocation which would overrun the tail first retires completed frames, then chains a new page
+ * (up to mMaxPageCount) and finally waits for the oldest frame in flight.
+ * Ring buffers which never get a frame marked keep the old behavior and wrap without looking at the GPU.
+ */
+#define MAX_GPU_RING_BUFFER_PAGES 8
+#define MAX_GPU_RING_BUFFER_FRAMES 8
+
+typedef struct GPURingBufferPage
+{
+	Buffer* pBuffer;
+	/// Virtual offsets which only grow. The offset in pBuffer is the virtual offset modulo GPURingBuffer::mMaxBufferSize
+	tfrg_atomic64_t mHead;
+	tfrg_atomic64_t mTail;
+} GPURingBufferPage;
+
+typedef struct GPURingBufferFrame
+{
+	Fence*   pFence;
+	uint64_t mPageHeads[MAX_GPU_RING_BUFFER_PAGES];
+} GPURingBufferFrame;
+
+typedef struct GPURingBufferStats
+{
+	/// Highest number of bytes in use in a single page (allocated and not yet released by a fence)
+	uint64_t mPeakUsage;
+	/// Highest number of frames in flight
+	uint32_t mPeakFramesInFlight;
+	/// Number of pages (including the first one)
+	uint32_t mPageCount;
+	/// Number of times an allocation had to wait for the GPU to release memory
+	uint32_t mStallCount;
+	uint64_t mStallTimeUs;
+	/// Number of times the ring wrapped over memory not protected by a fence (no frames marked or a single frame larger than all pages)
+	uint32_t mUnsafeWrapCount;
+} GPURingBufferStats;
+
 typedef struct GPURingBuffer
 {
 	Renderer* pRenderer;
-	Buffer*   pBuffer;
+	/// Buffer of the first page
+	Buffer* pBuffer;
 
-	uint32_t mBufferAlignment;
+	BufferDesc mPageDesc;
+	uint32_t   mBufferAlignment;
+	/// Size of each page
 	uint64_t mMaxBufferSize;
-	uint64_t mCurrentBufferOffset;
+	uint32_t mMaxPageCount;
+
+	GPURingBufferPage mPages[MAX_GPU_RING_BUFFER_PAGES];
+	tfrg_atomic32_t   mPageCount;
+	tfrg_atomic32_t   mCurrentPage;
+
+	/// Frames in flight (FIFO), only accessed with pMutex held
+	GPURingBufferFrame mFrames[MAX_GPU_RING_BUFFER_FRAMES];
+	uint32_t           mFrameStart;
+	uint32_t           mFrameCount;
+	bool               mFenceTracking;
+	Mutex*             pMutex;
+
+	tfrg_atomic64_t mPeakUsage;
+	tfrg_atomic32_t mStallCount;
+	tfrg_atomic64_t mStallTimeUs;
+	tfrg_atomic32_t mUnsafeWrapCount;
+	uint32_t        mPeakFramesInFlight;
 } GPURingBuffer;
 
 
@@ -51,29 +113,55 @@ typedef struct GPURingBufferOffset
 	uint64_t mOffset;
 } GPURingBufferOffset;
 
-static inline void addGPURingBuffer(Renderer* pRenderer, const BufferDesc* pBufferDesc, GPURingBuffer** ppRingBuffer)
+/// Needs pMutex held
+static inline void addGPURingBufferPage(GPURingBuffer* pRingBuffer)
+{
+	uint32_t           pageIndex = tfrg_atomic32_load_relaxed(&pRingBuffer->mPageCount);
+	GPURingBufferPage* pPage = &pRingBuffer->mPages[pageIndex];
+	BufferLoadDesc     loadDesc = {};
+	loadDesc.mDesc = pRingBuffer->mPageDesc;
+	loadDesc.ppBuffer = &pPage->pBuffer;
+	addResource(&loadDesc);
+	pPage->mHead = 0;
+	pPage->mTail = 0;
+
+	// Frames in flight did not use the new page
+	for (uint32_t i = 0; i < pRingBuffer->mFrameCount; ++i)
+		pRingBuffer->mFrames[(pRingBuffer->mFrameStart + i) % MAX_GPU_RING_BUFFER_FRAMES].mPageHeads[pageIndex] = 0;
+
+	// Publish the page after it was created so lock free allocations never see a partially initialized page
+	tfrg_atomic32_store_release(&pRingBuffer->mPageCount, pageIndex + 1);
+}
+
+static inline void initGPURingBuffer(Renderer* pRenderer, const BufferDesc* pBufferDesc, uint32_t alignment, uint32_t maxPageCount, GPURingBuffer** ppRingBuffer)
 {
+	ASSERT(maxPageCount >= 1 && maxPageCount <= MAX_GPU_RING_BUFFER_PAGES);
+
 	GPURingBuffer* pRingBuffer = (GPURingBuffer*)conf_calloc(1, sizeof(GPURingBuffer));
 	pRingBuffer->pRenderer = pRenderer;
+	pRingBuffer->mPageDesc = *pBufferDesc;
 	pRingBuffer->mMaxBufferSize = pBufferDesc->mSize;
-	pRingBuffer->mBufferAlignment = sizeof(float[4]);
-	BufferLoadDesc loadDesc = {};
-	loadDesc.mDesc = *pBufferDesc;
-	loadDesc.ppBuffer = &pRingBuffer->pBuffer;
-	addResource(&loadDesc);
+	pRingBuffer->mBufferAlignment = alignment;
+	pRingBuffer->mMaxPageCount = max(1U, min(maxPageCount, (uint32_t)MAX_GPU_RING_BUFFER_PAGES));
+	pRingBuffer->pMutex = conf_placement_new<Mutex>(conf_calloc(1, sizeof(Mutex)));
+
+	addGPURingBufferPage(pRingBuffer);
+	pRingBuffer->pBuffer = pRingBuffer->mPages[0].pBuffer;
 
 	*ppRingBuffer = pRingBuffer;
 }
 
-static inline void addUniformGPURingBuffer(Renderer* pRenderer, uint32_t requiredUniformBufferSize, GPURingBuffer** ppRingBuffer, bool const ownMemory = false)
+/// maxPageCount > 1 lets the ring chain new pages instead of waiting for the GPU when it would overrun data in flight.
+/// Chained pages are created from a copy of pBufferDesc so pointers in it have to stay valid
+static inline void addGPURingBuffer(Renderer* pRenderer, const BufferDesc* pBufferDesc, GPURingBuffer** ppRingBuffer, uint32_t maxPageCount = 1)
 {
-	GPURingBuffer* pRingBuffer = (GPURingBuffer*)conf_calloc(1, sizeof(GPURingBuffer));
-	pRingBuffer->pRenderer = pRenderer;
+	initGPURingBuffer(pRenderer, pBufferDesc, sizeof(float[4]), maxPageCount, ppRingBuffer);
+}
 
+static inline void addUniformGPURingBuffer(Renderer* pRenderer, uint32_t requiredUniformBufferSize, GPURingBuffer** ppRingBuffer, bool const ownMemory = false, uint32_t maxPageCount = 1)
+{
 	const uint32_t uniformBufferAlignment = (uint32_t)pRenderer->pActiveGpuSettings->mUniformBufferAlignment;
 	const uint32_t maxUniformBufferSize = requiredUniformBufferSize;
-	pRingBuffer->mBufferAlignment = uniformBufferAlignment;
-	pRingBuffer->mMaxBufferSize = maxUniformBufferSize;
 
 	BufferDesc ubDesc = {};
 #if defined(DIRECT3D11)
@@ -86,28 +174,145 @@ static inline void addUniformGPURingBuffer(Renderer* pRenderer, uint32_t require
 	if (ownMemory)
 		ubDesc.mFlags |= BUFFER_CREATION_FLAG_OWN_MEMORY_BIT;
 	ubDesc.mSize = maxUniformBufferSize;
-	BufferLoadDesc loadDesc = {};
-	loadDesc.mDesc = ubDesc;
-	loadDesc.ppBuffer = &pRingBuffer->pBuffer;
-	addResource(&loadDesc);
 
-	*ppRingBuffer = pRingBuffer;
+	initGPURingBuffer(pRenderer, &ubDesc, uniformBufferAlignment, maxPageCount, ppRingBuffer);
 }
 
 static inline void removeGPURingBuffer(GPURingBuffer* pRingBuffer)
 {
-	removeResource(pRingBuffer->pBuffer);
+	const uint32_t pageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+	for (uint32_t i = 0; i < pageCount; ++i)
+		removeResource(pRingBuffer->mPages[i].pBuffer);
+
+	pRingBuffer->pMutex->~Mutex();
+	conf_free(pRingBuffer->pMutex);
 	conf_free(pRingBuffer);
 }
 
+/// Releases all memory of the ring buffer. Only call this if the GPU is not using any data from the ring buffer
 static inline void resetGPURingBuffer(GPURingBuffer* pRingBuffer)
 {
-	pRingBuffer->mCurrentBufferOffset = 0;
+	MutexLock lock(*pRingBuffer->pMutex);
+
+	const uint32_t pageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+	for (uint32_t i = 0; i < pageCount; ++i)
+	{
+		tfrg_atomic64_store_relaxed(&pRingBuffer->mPages[i].mHead, 0);
+		tfrg_atomic64_store_relaxed(&pRingBuffer->mPages[i].mTail, 0);
+	}
+	tfrg_atomic32_store_release(&pRingBuffer->mCurrentPage, 0);
+	pRingBuffer->mFrameStart = 0;
+	pRingBuffer->mFrameCount = 0;
 }
 
+/// Moves the tail of every page past the frames whose fence completed. Needs pMutex held
+static inline bool retireGPURingBufferFrames(GPURingBuffer* pRingBuffer)
+{
+	bool retired = false;
+	while (pRingBuffer->mFrameCount)
+	{
+		GPURingBufferFrame* pFrame = &pRingBuffer->mFrames[pRingBuffer->mFrameStart];
+		if (pFrame->pFence)
+		{
+			// Not submitted counts as complete: waitForFences resets the submitted state of a signaled fence
+			FenceStatus fenceStatus = FENCE_STATUS_COMPLETE;
+			getFenceStatus(pRingBuffer->pRenderer, pFrame->pFence, &fenceStatus);
+			if (fenceStatus == FENCE_STATUS_INCOMPLETE)
+				break;
+		}
+
+		const uint32_t pageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+		for (uint32_t i = 0; i < pageCount; ++i)
+		{
+			if (pFrame->mPageHeads[i] > tfrg_atomic64_load_relaxed(&pRingBuffer->mPages[i].mTail))
+				tfrg_atomic64_store_release(&pRingBuffer->mPages[i].mTail, pFrame->mPageHeads[i]);
+		}
+
+		pRingBuffer->mFrameStart = (pRingBuffer->mFrameStart + 1) % MAX_GPU_RING_BUFFER_FRAMES;
+		--pRingBuffer->mFrameCount;
+		retired = true;
+	}
+	return retired;
+}
+
+/// Blocks until the oldest frame in flight completed and releases its memory. Needs pMutex held
+static inline void waitGPURingBufferFrame(GPURingBuffer* pRingBuffer)
+{
+	ASSERT(pRingBuffer->mFrameCount);
+	Fence* pFence = pRingBuffer->mFrames[pRingBuffer->mFrameStart].pFence;
+	if (pFence)
+	{
+		const int64_t start = getUSec();
+		waitForFences(pRingBuffer->pRenderer, 1, &pFence);
+		tfrg_atomic32_add_relaxed(&pRingBuffer->mStallCount, 1);
+		tfrg_atomic64_add_relaxed(&pRingBuffer->mStallTimeUs, (uint64_t)(getUSec() - start));
+	}
+	// The frame is complete now even if the fence got reset by the wait, so retire it unconditionally
+	pRingBuffer->mFrames[pRingBuffer->mFrameStart].pFence = NULL;
+	retireGPURingBufferFrames(pRingBuffer);
+}
+
+/// Marks the end of a frame: everything allocated so far is released once pFence completed.
+/// Call this after the submission signaling pFence. Frames marked with a NULL fence are released as soon as the ring needs memory
+static inline void markGPURingBufferFrame(GPURingBuffer* pRingBuffer, Fence* pFence)
+{
+	MutexLock lock(*pRingBuffer->pMutex);
+	pRingBuffer->mFenceTracking = true;
+
+	retireGPURingBufferFrames(pRingBuffer);
+	if (pRingBuffer->mFrameCount == MAX_GPU_RING_BUFFER_FRAMES)
+		waitGPURingBufferFrame(pRingBuffer);
+
+	GPURingBufferFrame* pFrame =
+		&pRingBuffer->mFrames[(pRingBuffer->mFrameStart + pRingBuffer->mFrameCount) % MAX_GPU_RING_BUFFER_FRAMES];
+	pFrame->pFence = pFence;
+	const uint32_t pageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+	for (uint32_t i = 0; i < pageCount; ++i)
+		pFrame->mPageHeads[i] = tfrg_atomic64_load_acquire(&pRingBuffer->mPages[i].mHead);
+
+	++pRingBuffer->mFrameCount;
+	pRingBuffer->mPeakFramesInFlight = max(pRingBuffer->mPeakFramesInFlight, pRingBuffer->mFrameCount);
+}
+
+static inline bool tryGetGPURingBufferOffset(
+	GPURingBuffer* pRingBuffer, uint32_t pageIndex, uint32_t memoryRequirement, uint32_t alignment, GPURingBufferOffset* pOut)
+{
+	GPURingBufferPage* pPage = &pRingBuffer->mPages[pageIndex];
+	const uint64_t     pageSize = pRingBuffer->mMaxBufferSize;
+	const uint64_t     alignedSize = round_up_64(memoryRequirement, alignment);
+	uint64_t           head = tfrg_atomic64_load_relaxed(&pPage->mHead);
+
+	for (;;)
+	{
+		// Align the physical offset and skip the end of the page if the allocation does not fit in there
+		const uint64_t offset = head % pageSize;
+		uint64_t       alignedOffset = round_up_64(offset, alignment);
+		if (alignedOffset + alignedSize > pageSize)
+			alignedOffset = pageSize;
+
+		const uint64_t start = head + (alignedOffset - offset);
+		const uint64_t end = start + alignedSize;
+		const uint64_t usage = end - tfrg_atomic64_load_acquire(&pPage->mTail);
+		if (usage > pageSize)
+			return false;
+
+		const uint64_t prev = tfrg_atomic64_cas_relaxed(&pPage->mHead, head, end);
+		if (prev == head)
+		{
+			tfrg_atomic64_max_relaxed(&pRingBuffer->mPeakUsage, usage);
+			pOut->pBuffer = pPage->pBuffer;
+			pOut->mOffset = start % pageSize;
+			return true;
+		}
+		head = prev;
+	}
+}
+
+/// Thread safe. Allocations never block unless the ring would overrun memory the GPU still uses
 static inline GPURingBufferOffset getGPURingBufferOffset(GPURingBuffer* pRingBuffer, uint32_t memoryRequirement, uint32_t alignment = 0)
 {
-	uint32_t alignedSize = round_up(memoryRequirement, alignment ? alignment : pRingBuffer->mBufferAlignment);
+	alignment = alignment ? alignment : pRingBuffer->mBufferAlignment;
+	uint32_t alignedSize = round_up(memoryRequirement, alignment);
 
 	if (alignedSize > pRingBuffer->mMaxBufferSize)
 	{
@@ -115,13 +320,71 @@ static inline GPURingBufferOffset getGPURingBufferOffset(GPURingBuffer* pRingBuf
 		return { NULL, 0 };
 	}
 
-	if (pRingBuffer->mCurrentBufferOffset + alignedSize >= pRingBuffer->mMaxBufferSize)
+	GPURingBufferOffset ret = { NULL, 0 };
+	if (tryGetGPURingBufferOffset(pRingBuffer, tfrg_atomic32_load_acquire(&pRingBuffer->mCurrentPage), memoryRequirement, alignment, &ret))
+		return ret;
+
+	MutexLock lock(*pRingBuffer->pMutex);
+	for (;;)
 	{
-		pRingBuffer->mCurrentBufferOffset = 0;
-	}
+		const uint32_t currentPage = tfrg_atomic32_load_acquire(&pRingBuffer->mCurrentPage);
+		if (tryGetGPURingBufferOffset(pRingBuffer, currentPage, memoryRequirement, alignment, &ret))
+			return ret;
 
-	GPURingBufferOffset ret = { pRingBuffer->pBuffer, pRingBuffer->mCurrentBufferOffset };
-	pRingBuffer->mCurrentBufferOffset += alignedSize;
+		if (!pRingBuffer->mFenceTracking)
+		{
+			// No frames were ever marked so there is nothing to wait for. Wrap like a plain ring buffer
+			tfrg_atomic64_store_release(&pRingBuffer->mPages[currentPage].mTail, pRingBuffer->mPages[currentPage].mHead);
+			tfrg_atomic32_add_relaxed(&pRingBuffer->mUnsafeWrapCount, 1);
+			continue;
+		}
 
-	return ret;
+		if (retireGPURingBufferFrames(pRingBuffer))
+			continue;
+
+		// Switch to another page which has enough free memory
+		const uint32_t pageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+		bool           found = false;
+		for (uint32_t i = 1; i < pageCount && !found; ++i)
+		{
+			const uint32_t pageIndex = (currentPage + i) % pageCount;
+			if (tryGetGPURingBufferOffset(pRingBuffer, pageIndex, memoryRequirement, alignment, &ret))
+			{
+				tfrg_atomic32_store_release(&pRingBuffer->mCurrentPage, pageIndex);
+				found = true;
+			}
+		}
+		if (found)
+			return ret;
+
+		// Grow into a new page before stalling on the GPU
+		if (pageCount < pRingBuffer->mMaxPageCount)
+		{
+			addGPURingBufferPage(pRingBuffer);
+			tfrg_atomic32_store_release(&pRingBuffer->mCurrentPage, pageCount);
+			continue;
+		}
+
+		if (pRingBuffer->mFrameCount)
+		{
+			waitGPURingBufferFrame(pRingBuffer);
+			continue;
+		}
+
+		// The current frame alone needs more memory than all pages provide
+		LOGF(LogLevel::eWARNING, "GPU ring buffer overrun by a single frame. Data of this frame gets overwritten");
+		tfrg_atomic64_store_release(&pRingBuffer->mPages[currentPage].mTail, pRingBuffer->mPages[currentPage].mHead);
+		tfrg_atomic32_add_relaxed(&pRingBuffer->mUnsafeWrapCount, 1);
+	}
+}
+
+static inline void getGPURingBufferStats(GPURingBuffer* pRingBuffer, GPURingBufferStats* pStats)
+{
+	MutexLock lock(*pRingBuffer->pMutex);
+	pStats->mPeakUsage = tfrg_atomic64_load_relaxed(&pRingBuffer->mPeakUsage);
+	pStats->mPeakFramesInFlight = pRingBuffer->mPeakFramesInFlight;
+	pStats->mPageCount = tfrg_atomic32_load_acquire(&pRingBuffer->mPageCount);
+	pStats->mStallCount = tfrg_atomic32_load_relaxed(&pRingBuffer->mStallCount);
+	pStats->mStallTimeUs = tfrg_atomic64_load_relaxed(&pRingBuffer->mStallTimeUs);
+	pStats->mUnsafeWrapCount = tfrg_atomic32_load_relaxed(&pRingBuffer->mUnsafeWrapCount);
 }
@@ -23,95 +23,363 @@
 */
 
 #include "EASTL/deque.h"
+#include "EASTL/vector.h"
 
 #include "Interfaces/IThread.h"
 #include "Interfaces/ILog.h"
 
+#include "Atomics.h"
 #include "ThreadSystem.h"
 #include "Interfaces/IMemory.h"
 
 struct ThreadedTask
 {
-	TaskFunc  mTask;
-	void*     mUser;
-	uintptr_t mStart;
-	uintptr_t mEnd;
+	TaskFunc   mTask;
+	void*      mUser;
+	uintptr_t  mStart;
+	uintptr_t  mEnd;
+	TaskGroup* pGroup;
+};
+
+// Task waiting for its dependencies. Holds one reference per incomplete dependency.
+struct DeferredTask
+{
+	ThreadedTask    mTask;
+	tfrg_atomic32_t mDependencyCount;
+};
+
+struct TaskGroup
+{
+	tfrg_atomic64_t              mPendingCount;
+	// Threads currently retiring tasks of this group, the group must not be removed before they are done.
+	tfrg_atomic32_t              mCompletingCount;
+	Mutex                        mContinuationMutex;
+	eastl::vector<DeferredTask*> mContinuations;
 };
 
 enum
 {
-	MAX_LOAD_THREADS = 4
+	MAX_LOAD_THREADS = 64,
+	// Must be a power of two. Tasks that do not fit spill over into the shared queue.
+	TASK_QUEUE_SIZE = 1024,
+	TASK_SPIN_COUNT = 32,
+};
+
+// Chase-Lev work stealing deque. Only the owning worker pushes and pops at the bottom,
+// any other thread steals from the top.
+struct TaskQueue
+{
+	tfrg_atomicptr_t mTop;
+	uint8_t          mPadding0[64 - sizeof(tfrg_atomicptr_t)];
+	tfrg_atomicptr_t mBottom;
+	uint8_t          mPadding1[64 - sizeof(tfrg_atomicptr_t)];
+	ThreadedTask     mTasks[TASK_QUEUE_SIZE];
+};
+
+struct TaskWorker
+{
+	TaskQueue     mQueue;
+	ThreadSystem* pThreadSystem;
+	uint32_t      mIndex;
+	ThreadDesc    mThreadDesc;
+	ThreadHandle  mThread;
 };
 
 struct ThreadSystem
 {
-	ThreadDesc                 mThreadDescs[MAX_LOAD_THREADS];
-	ThreadHandle               mThread[MAX_LOAD_THREADS];
+	TaskWorker*                pWorkers;
+	// Tasks submitted from threads outside the pool (and overflow of the worker queues).
 	eastl::deque<ThreadedTask> mLoadQueue;
 	ConditionVariable          mQueueCond;
 	Mutex                      mQueueMutex;
 	ConditionVariable          mIdleCond;
+	tfrg_atomic32_t            mNumQueuedTasks;
+	tfrg_atomic32_t            mNumSleepingLoaders;
+	tfrg_atomic32_t            mNextVictim;
+	// Number of task indices that were submitted but have not finished executing yet.
+	tfrg_atomic64_t            mNumPendingTasks;
 	uint32_t                   mNumLoaders;
-	uint32_t                   mNumIdleLoaders;
 	volatile bool              mRun;
 };
 
-bool assistThreadSystem(ThreadSystem* pThreadSystem)
+static thread_local TaskWorker* pCurrentWorker = NULL;
+
+static bool pushTaskQueue(TaskQueue* pQueue, const ThreadedTask& task)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	if (!pThreadSystem->mLoadQueue.empty())
+	intptr_t bottom = (intptr_t)tfrg_atomicptr_load_relaxed(&pQueue->mBottom);
+	intptr_t top = (intptr_t)tfrg_atomicptr_load_acquire(&pQueue->mTop);
+	if (bottom - top >= TASK_QUEUE_SIZE)
+		return false;
+
+	pQueue->mTasks[bottom & (TASK_QUEUE_SIZE - 1)] = task;
+	tfrg_atomicptr_store_release(&pQueue->mBottom, (uintptr_t)(bottom + 1));
+	return true;
+}
+
+static bool popTaskQueue(TaskQueue* pQueue, ThreadedTask* pTask)
+{
+	intptr_t bottom = (intptr_t)tfrg_atomicptr_load_relaxed(&pQueue->mBottom) - 1;
+	tfrg_atomicptr_store_relaxed(&pQueue->mBottom, (uintptr_t)bottom);
+	tfrg_memorybarrier_full();
+	intptr_t top = (intptr_t)tfrg_atomicptr_load_relaxed(&pQueue->mTop);
+
+	if (top > bottom)
 	{
-		ThreadedTask resourceTask = pThreadSystem->mLoadQueue.front();
-		if (resourceTask.mStart + 1 == resourceTask.mEnd)
-			pThreadSystem->mLoadQueue.pop_front();
-		else
-			++pThreadSystem->mLoadQueue.front().mStart;
-		pThreadSystem->mQueueMutex.Release();
-		resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
+		tfrg_atomicptr_store_relaxed(&pQueue->mBottom, (uintptr_t)(bottom + 1));
+		return false;
+	}
+
+	*pTask = pQueue->mTasks[bottom & (TASK_QUEUE_SIZE - 1)];
+	if (top != bottom)
+		return true;
+
+	// Last task in the queue, race the thieves for it.
+	bool won = (intptr_t)tfrg_atomicptr_cas_relaxed(&pQueue->mTop, (uintptr_t)top, (uintptr_t)(top + 1)) == top;
+	tfrg_atomicptr_store_relaxed(&pQueue->mBottom, (uintptr_t)(bottom + 1));
+	return won;
+}
+
+static bool stealTaskQueue(TaskQueue* pQueue, ThreadedTask* pTask)
+{
+	intptr_t top = (intptr_t)tfrg_atomicptr_load_acquire(&pQueue->mTop);
+	tfrg_memorybarrier_full();
+	intptr_t bottom = (intptr_t)tfrg_atomicptr_load_acquire(&pQueue->mBottom);
+	if (top >= bottom)
+		return false;
+
+	ThreadedTask task = pQueue->mTasks[top & (TASK_QUEUE_SIZE - 1)];
+	if ((intptr_t)tfrg_atomicptr_cas_relaxed(&pQueue->mTop, (uintptr_t)top, (uintptr_t)(top + 1)) != top)
+		return false;
+
+	*pTask = task;
+	return true;
+}
 
+static bool isTaskQueueEmpty(TaskQueue* pQueue)
+{
+	intptr_t top = (intptr_t)tfrg_atomicptr_load_acquire(&pQueue->mTop);
+	intptr_t bottom = (intptr_t)tfrg_atomicptr_load_acquire(&pQueue->mBottom);
+	return top >= bottom;
+}
+
+static bool hasQueuedTasks(ThreadSystem* pThreadSystem)
+{
+	if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumQueuedTasks))
 		return true;
+	for (uint32_t i = 0; i < pThreadSystem->mNumLoaders; ++i)
+	{
+		if (!isTaskQueueEmpty(&pThreadSystem->pWorkers[i].mQueue))
+			return true;
 	}
-	else
+	return false;
+}
+
+static void wakeLoader(ThreadSystem* pThreadSystem)
+{
+	// Pairs with the increment in waitForTasks so that either the sleeper sees the new task or we see the sleeper.
+	tfrg_memorybarrier_full();
+	if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumSleepingLoaders))
 	{
+		pThreadSystem->mQueueMutex.Acquire();
+		pThreadSystem->mQueueCond.WakeOne();
 		pThreadSystem->mQueueMutex.Release();
+	}
+}
+
+static void pushSharedTask(ThreadSystem* pThreadSystem, const ThreadedTask& task, bool front)
+{
+	pThreadSystem->mQueueMutex.Acquire();
+	if (front)
+		pThreadSystem->mLoadQueue.push_front(task);
+	else
+		pThreadSystem->mLoadQueue.push_back(task);
+	tfrg_atomic32_add_relaxed(&pThreadSystem->mNumQueuedTasks, 1);
+	pThreadSystem->mQueueCond.WakeOne();
+	pThreadSystem->mQueueMutex.Release();
+}
+
+static bool popSharedTask(ThreadSystem* pThreadSystem, ThreadedTask* pTask)
+{
+	if (!tfrg_atomic32_load_relaxed(&pThreadSystem->mNumQueuedTasks))
 		return false;
+
+	bool found = false;
+	pThreadSystem->mQueueMutex.Acquire();
+	if (!pThreadSystem->mLoadQueue.empty())
+	{
+		*pTask = pThreadSystem->mLoadQueue.front();
+		pThreadSystem->mLoadQueue.pop_front();
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumQueuedTasks, -1);
+		found = true;
 	}
+	pThreadSystem->mQueueMutex.Release();
+	return found;
 }
 
-static void taskThreadFunc(void* pThreadData)
+static void pushTask(ThreadSystem* pThreadSystem, const ThreadedTask& task)
 {
-	ThreadSystem* pThreadSystem = (ThreadSystem*)pThreadData;
-	while (pThreadSystem->mRun)
+	TaskWorker* pWorker = pCurrentWorker;
+	if (pWorker && pWorker->pThreadSystem == pThreadSystem && pushTaskQueue(&pWorker->mQueue, task))
+		wakeLoader(pThreadSystem);
+	else
+		pushSharedTask(pThreadSystem, task, false);
+}
+
+static bool getTask(ThreadSystem* pThreadSystem, TaskWorker* pWorker, ThreadedTask* pTask)
+{
+	if (pWorker && popTaskQueue(&pWorker->mQueue, pTask))
+		return true;
+
+	if (popSharedTask(pThreadSystem, pTask))
+		return true;
+
+	uint32_t numLoaders = pThreadSystem->mNumLoaders;
+	uint32_t first = pWorker ? pWorker->mIndex + 1 : tfrg_atomic32_add_relaxed(&pThreadSystem->mNextVictim, 1);
+	for (uint32_t i = 0; i < numLoaders; ++i)
 	{
-		pThreadSystem->mQueueMutex.Acquire();
-		++pThreadSystem->mNumIdleLoaders;
-		while (pThreadSystem->mRun && pThreadSystem->mLoadQueue.empty())
+		TaskWorker* pVictim = &pThreadSystem->pWorkers[(first + i) % numLoaders];
+		if (pVictim != pWorker && stealTaskQueue(&pVictim->mQueue, pTask))
+			return true;
+	}
+
+	return false;
+}
+
+static void releaseDependency(ThreadSystem* pThreadSystem, DeferredTask* pDeferred)
+{
+	if (tfrg_atomic32_add_relaxed(&pDeferred->mDependencyCount, -1) == 1)
+	{
+		pushTask(pThreadSystem, pDeferred->mTask);
+		conf_free(pDeferred);
+	}
+}
+
+static void completeTaskGroup(ThreadSystem* pThreadSystem, TaskGroup* pGroup, uintptr_t count)
+{
+	tfrg_atomic32_add_relaxed(&pGroup->mCompletingCount, 1);
+	bool drained = tfrg_atomic64_add_relaxed(&pGroup->mPendingCount, -(int64_t)count) == count;
+	if (drained)
+	{
+		// The group may have been refilled since the counter hit zero, continuations then wait for it to drain again.
+		pGroup->mContinuationMutex.Acquire();
+		if (tfrg_atomic64_load_acquire(&pGroup->mPendingCount) == 0)
 		{
-			pThreadSystem->mIdleCond.WakeAll();
-			pThreadSystem->mQueueCond.Wait(pThreadSystem->mQueueMutex);
+			for (DeferredTask* pDeferred : pGroup->mContinuations)
+				releaseDependency(pThreadSystem, pDeferred);
+			pGroup->mContinuations.clear();
 		}
-		--pThreadSystem->mNumIdleLoaders;
-		if (!pThreadSystem->mLoadQueue.empty())
+		pGroup->mContinuationMutex.Release();
+
+		// Threads blocked in waitTaskGroupCompleted sleep together with the idle loaders until the group drains.
+		// They wait for mCompletingCount to drop on their own, so nobody needs to wake them after the decrement below.
+		tfrg_memorybarrier_full();
+		if (tfrg_atomic32_load_relaxed(&pThreadSystem->mNumSleepingLoaders))
 		{
-			ThreadedTask resourceTask = pThreadSystem->mLoadQueue.front();
-			if (resourceTask.mStart + 1 == resourceTask.mEnd)
-				pThreadSystem->mLoadQueue.pop_front();
-			else
-				++pThreadSystem->mLoadQueue.front().mStart;
+			pThreadSystem->mQueueMutex.Acquire();
+			pThreadSystem->mQueueCond.WakeAll();
 			pThreadSystem->mQueueMutex.Release();
-			resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
 		}
-		else
+	}
+
+	// A waiter may remove the group as soon as this makes it look completed.
+	tfrg_atomic32_add_relaxed(&pGroup->mCompletingCount, -1);
+}
+
+static void completeTasks(ThreadSystem* pThreadSystem, TaskGroup* pGroup, uintptr_t count)
+{
+	if (pGroup)
+		completeTaskGroup(pThreadSystem, pGroup, count);
+
+	if (tfrg_atomic64_add_relaxed(&pThreadSystem->mNumPendingTasks, -(int64_t)count) == count)
+	{
+		pThreadSystem->mQueueMutex.Acquire();
+		pThreadSystem->mIdleCond.WakeAll();
+		pThreadSystem->mQueueMutex.Release();
+	}
+}
+
+// Runs a range on a worker thread. The remainder of the range is split in half and pushed back onto the
+// worker queue whenever that queue runs dry, so ranges only get subdivided as far as other workers need.
+static void runTask(ThreadSystem* pThreadSystem, TaskWorker* pWorker, ThreadedTask task)
+{
+	uintptr_t start = task.mStart;
+	while (task.mStart < task.mEnd)
+	{
+		uintptr_t remaining = task.mEnd - task.mStart;
+		if (remaining > 1 && isTaskQueueEmpty(&pWorker->mQueue))
 		{
-			pThreadSystem->mQueueMutex.Release();
+			uintptr_t    middle = task.mStart + remaining / 2;
+			ThreadedTask upper = { task.mTask, task.mUser, middle, task.mEnd, task.pGroup };
+			if (pushTaskQueue(&pWorker->mQueue, upper))
+			{
+				task.mEnd = middle;
+				wakeLoader(pThreadSystem);
+			}
 		}
+
+		task.mTask(task.mUser, task.mStart);
+		++task.mStart;
+	}
+	completeTasks(pThreadSystem, task.pGroup, task.mEnd - start);
+}
+
+bool assistThreadSystem(ThreadSystem* pThreadSystem)
+{
+	TaskWorker* pWorker = pCurrentWorker && pCurrentWorker->pThreadSystem == pThreadSystem ? pCurrentWorker : NULL;
+
+	ThreadedTask task;
+	if (!getTask(pThreadSystem, pWorker, &task))
+		return false;
+
+	if (pWorker)
+	{
+		runTask(pThreadSystem, pWorker, task);
+		return true;
 	}
+
+	// Threads outside the pool only run a single index so they are never stuck with a large range.
+	if (task.mStart + 1 < task.mEnd)
+		pushSharedTask(pThreadSystem, ThreadedTask{ task.mTask, task.mUser, task.mStart + 1, task.mEnd, task.pGroup }, true);
+	task.mTask(task.mUser, task.mStart);
+	completeTasks(pThreadSystem, task.pGroup, 1);
+	return true;
+}
+
+static void waitForTasks(ThreadSystem* pThreadSystem)
+{
 	pThreadSystem->mQueueMutex.Acquire();
-	++pThreadSystem->mNumIdleLoaders;
-	pThreadSystem->mIdleCond.WakeAll();
+	tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, 1);
+	while (pThreadSystem->mRun && !hasQueuedTasks(pThreadSystem))
+		pThreadSystem->mQueueCond.Wait(pThreadSystem->mQueueMutex);
+	tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, -1);
 	pThreadSystem->mQueueMutex.Release();
 }
 
+static void taskThreadFunc(void* pThreadData)
+{
+	TaskWorker*   pWorker = (TaskWorker*)pThreadData;
+	ThreadSystem* pThreadSystem = pWorker->pThreadSystem;
+	pCurrentWorker = pWorker;
+
+	uint32_t spinCount = 0;
+	while (pThreadSystem->mRun)
+	{
+		ThreadedTask task;
+		if (getTask(pThreadSystem, pWorker, &task))
+		{
+			runTask(pThreadSystem, pWorker, task);
+			spinCount = 0;
+		}
+		else if (++spinCount >= TASK_SPIN_COUNT)
+		{
+			waitForTasks(pThreadSystem);
+			spinCount = 0;
+		}
+	}
+
+	pCurrentWorker = NULL;
+}
+
 void initThreadSystem(ThreadSystem** ppThreadSystem)
 {
 	ThreadSystem* pThreadSystem = conf_new(ThreadSystem);
@@ -120,72 +388,170 @@ void initThreadSystem(ThreadSystem** ppThreadSystem)
 	uint32_t numLoaders = min<uint32_t>(numThreads, MAX_LOAD_THREADS);
 
 	pThreadSystem->mRun = true;
-	pThreadSystem->mNumIdleLoaders = 0;
+	pThreadSystem->mNumQueuedTasks = 0;
+	pThreadSystem->mNumSleepingLoaders = 0;
+	pThreadSystem->mNextVictim = 0;
+	pThreadSystem->mNumPendingTasks = 0;
+	pThreadSystem->mNumLoaders = numLoaders;
+	pThreadSystem->pWorkers = (TaskWorker*)conf_calloc(numLoaders, sizeof(TaskWorker));
 
-	for (unsigned i = 0; i < numLoaders; ++i)
+	for (uint32_t i = 0; i < numLoaders; ++i)
 	{
-		pThreadSystem->mThreadDescs[i].pFunc = taskThreadFunc;
-		pThreadSystem->mThreadDescs[i].pData = pThreadSystem;
-
-		pThreadSystem->mThread[i] = create_thread(&pThreadSystem->mThreadDescs[i]);
+		TaskWorker* pWorker = &pThreadSystem->pWorkers[i];
+		pWorker->pThreadSystem = pThreadSystem;
+		pWorker->mIndex = i;
+		pWorker->mThreadDesc.pFunc = taskThreadFunc;
+		pWorker->mThreadDesc.pData = pWorker;
 	}
-	pThreadSystem->mNumLoaders = numLoaders;
+
+	// Start the threads only once every queue is set up since they steal from each other straight away.
+	for (uint32_t i = 0; i < numLoaders; ++i)
+		pThreadSystem->pWorkers[i].mThread = create_thread(&pThreadSystem->pWorkers[i].mThreadDesc);
 
 	*ppThreadSystem = pThreadSystem;
 }
 
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadQueue.emplace_back(ThreadedTask{ task, user, index, index+1 });
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeOne();
+	addThreadSystemRangeTask(pThreadSystem, task, user, index, index + 1);
 }
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadQueue.emplace_back(ThreadedTask{ task, user, 0, count });
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeOne();
+	addThreadSystemRangeTask(pThreadSystem, task, user, 0, count);
 }
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	pThreadSystem->mLoadQueue.emplace_back(ThreadedTask{ task, user, start, end });
-	pThreadSystem->mQueueMutex.Release();
-	pThreadSystem->mQueueCond.WakeOne();
+	TaskDesc desc = {};
+	desc.pTask = task;
+	desc.pUser = user;
+	desc.mStart = start;
+	desc.mEnd = end;
+	addThreadSystemTask(pThreadSystem, &desc);
+}
+
+void addThreadSystemTask(ThreadSystem* pThreadSystem, const TaskDesc* pDesc)
+{
+	ASSERT(pDesc->pTask);
+	if (pDesc->mStart >= pDesc->mEnd)
+		return;
+
+	uintptr_t count = pDesc->mEnd - pDesc->mStart;
+	if (pDesc->pGroup)
+		tfrg_atomic64_add_relaxed(&pDesc->pGroup->mPendingCount, count);
+	tfrg_atomic64_add_relaxed(&pThreadSystem->mNumPendingTasks, count);
+
+	ThreadedTask task = { pDesc->pTask, pDesc->pUser, pDesc->mStart, pDesc->mEnd, pDesc->pGroup };
+	if (!pDesc->mDependencyCount)
+	{
+		pushTask(pThreadSystem, task);
+		return;
+	}
+
+	// The extra reference keeps the task from being scheduled while dependencies are still being registered.
+	DeferredTask* pDeferred = (DeferredTask*)conf_malloc(sizeof(DeferredTask));
+	pDeferred->mTask = task;
+	pDeferred->mDependencyCount = pDesc->mDependencyCount + 1;
+
+	for (uint32_t i = 0; i < pDesc->mDependencyCount; ++i)
+	{
+		TaskGroup* pDependency = pDesc->ppDependencies[i];
+		ASSERT(pDependency != pDesc->pGroup);
+
+		bool pending = false;
+		pDependency->mContinuationMutex.Acquire();
+		if (tfrg_atomic64_load_acquire(&pDependency->mPendingCount) != 0)
+		{
+			pDependency->mContinuations.push_back(pDeferred);
+			pending = true;
+		}
+		pDependency->mContinuationMutex.Release();
+
+		if (!pending)
+			releaseDependency(pThreadSystem, pDeferred);
+	}
+
+	releaseDependency(pThreadSystem, pDeferred);
+}
+
+void addTaskGroup(ThreadSystem* pThreadSystem, TaskGroup** ppGroup)
+{
+	UNREF_PARAM(pThreadSystem);
+	TaskGroup* pGroup = conf_new(TaskGroup);
+	pGroup->mPendingCount = 0;
+	pGroup->mCompletingCount = 0;
+	*ppGroup = pGroup;
+}
+
+void removeTaskGroup(ThreadSystem* pThreadSystem, TaskGroup* pGroup)
+{
+	// A continuation of this group can finish before the thread that retired the group's last task is done with it.
+	waitTaskGroupCompleted(pThreadSystem, pGroup);
+	ASSERT(pGroup->mContinuations.empty());
+	conf_delete(pGroup);
+}
+
+bool isTaskGroupCompleted(TaskGroup* pGroup)
+{
+	return tfrg_atomic64_load_acquire(&pGroup->mPendingCount) == 0 && tfrg_atomic32_load_acquire(&pGroup->mCompletingCount) == 0;
+}
+
+void waitTaskGroupCompleted(ThreadSystem* pThreadSystem, TaskGroup* pGroup)
+{
+	while (!isTaskGroupCompleted(pGroup))
+	{
+		if (assistThreadSystem(pThreadSystem))
+			continue;
+
+		// Drained, only the threads retiring the last tasks still hold on to the group
+		if (tfrg_atomic64_load_acquire(&pGroup->mPendingCount) == 0)
+		{
+			Thread::Sleep(0);
+			continue;
+		}
+
+		// Counted as a sleeping loader so that newly scheduled tasks wake us up, otherwise a continuation
+		// of the group could be left waiting for a worker that is blocked in here.
+		pThreadSystem->mQueueMutex.Acquire();
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, 1);
+		while (pThreadSystem->mRun && tfrg_atomic64_load_acquire(&pGroup->mPendingCount) != 0 && !hasQueuedTasks(pThreadSystem))
+			pThreadSystem->mQueueCond.Wait(pThreadSystem->mQueueMutex);
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, -1);
+		pThreadSystem->mQueueMutex.Release();
+
+		if (!pThreadSystem->mRun)
+			break;
+	}
 }
 
 void shutdownThreadSystem(ThreadSystem* pThreadSystem)
 {
 	pThreadSystem->mQueueMutex.Acquire();
 	pThreadSystem->mRun = false;
-	pThreadSystem->mQueueMutex.Release();
 	pThreadSystem->mQueueCond.WakeAll();
+	pThreadSystem->mIdleCond.WakeAll();
+	pThreadSystem->mQueueMutex.Release();
 
 	uint32_t numLoaders = pThreadSystem->mNumLoaders;
 	for (uint32_t i = 0; i < numLoaders; ++i)
 	{
-		destroy_thread(pThreadSystem->mThread[i]);
+		destroy_thread(pThreadSystem->pWorkers[i].mThread);
 	}
 
+	conf_free(pThreadSystem->pWorkers);
 	conf_delete(pThreadSystem);
 }
 
 bool isThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
-	pThreadSystem->mQueueMutex.Acquire();
-	bool idle = (pThreadSystem->mLoadQueue.empty() && pThreadSystem->mNumIdleLoaders == pThreadSystem->mNumLoaders) || !pThreadSystem->mRun;
-	pThreadSystem->mQueueMutex.Release();
-	return idle;
+	return tfrg_atomic64_load_acquire(&pThreadSystem->mNumPendingTasks) == 0 || !pThreadSystem->mRun;
 }
 
 void waitThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
 	pThreadSystem->mQueueMutex.Acquire();
-	while ((!pThreadSystem->mLoadQueue.empty() || pThreadSystem->mNumIdleLoaders < pThreadSystem->mNumLoaders) && pThreadSystem->mRun)
+	while (tfrg_atomic64_load_acquire(&pThreadSystem->mNumPendingTasks) != 0 && pThreadSystem->mRun)
 		pThreadSystem->mIdleCond.Wait(pThreadSystem->mQueueMutex);
 	pThreadSystem->mQueueMutex.Release();
 }
@@ -22,6 +22,8 @@
  * under the License.
 */
 
+#pragma once
+
 typedef void (*TaskFunc)(void* user, uintptr_t arg);
 
 template <class T, void (T::*callback)(size_t)>
@@ -40,6 +42,23 @@ static void memberTaskFunc0(void* userData, size_t)
 
 struct ThreadSystem;
 
+/// Counts the task indices that were added to it and have not finished running yet.
+/// Tasks that depend on a group are held back until the group drains, then scheduled automatically.
+struct TaskGroup;
+
+struct TaskDesc
+{
+	TaskFunc          pTask;
+	void*             pUser;
+	uintptr_t         mStart;
+	uintptr_t         mEnd;
+	/// Optional group this task is counted in
+	TaskGroup*        pGroup;
+	/// Groups that have to complete before this task starts
+	TaskGroup* const* ppDependencies;
+	uint32_t          mDependencyCount;
+};
+
 void initThreadSystem(ThreadSystem** ppThreadSystem);
 
 void shutdownThreadSystem(ThreadSystem* pThreadSystem);
@@ -47,6 +66,13 @@ void shutdownThreadSystem(ThreadSystem* pThreadSystem);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end);
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index = 0);
+void addThreadSystemTask(ThreadSystem* pThreadSystem, const TaskDesc* pDesc);
+
+void addTaskGroup(ThreadSystem* pThreadSystem, TaskGroup** ppGroup);
+void removeTaskGroup(ThreadSystem* pThreadSystem, TaskGroup* pGroup);
+bool isTaskGroupCompleted(TaskGroup* pGroup);
+/// Helps executing tasks until the group completes.
+void waitTaskGroupCompleted(ThreadSystem* pThreadSystem, TaskGroup* pGroup);
 
 bool assistThreadSystem(ThreadSystem* pThreadSystem);
 
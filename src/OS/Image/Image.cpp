@@ -30,9 +30,40 @@
 
 #include "EASTL/functional.h"
 #include "EASTL/unordered_map.h"
+#include "EASTL/vector.h"
+
+#include <float.h>
+
+#if defined(__AVX__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+#if defined(__AVX__)
+#define IMAGE_SIMD_AVX 1
+#endif
+#if defined(__F16C__)
+#define IMAGE_SIMD_F16C 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_SIMD_SSE 1
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define IMAGE_SIMD_SSSE3 1
+#endif
+#if !defined(IMAGE_SIMD_F16C) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+// Hot half float loops get an F16C version picked at runtime when the build does not enable it
+#include <cpuid.h>
+#include <immintrin.h>
+#define IMAGE_SIMD_F16C_DISPATCH 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IMAGE_SIMD_NEON 1
+#endif
 
 #include "Image/Image.h"
 #include "Interfaces/ILog.h"
+#include "OS/Core/ThreadSystem.h"
 #include "TinyEXR/tinyexr.h"
 //stb_image
 #define STB_IMAGE_IMPLEMENTATION
@@ -470,302 +501,1460 @@ typedef struct KTXHeader
 	uint32_t mKeyValueDataLength;
 } KTXHeader;
 
+typedef struct KTX2Header
+{
+	uint8_t  mIdentifier[12];
+	uint32_t mVkFormat;
+	uint32_t mTypeSize;
+	uint32_t mPixelWidth;
+	uint32_t mPixelHeight;
+	uint32_t mPixelDepth;
+	uint32_t mLayerCount;
+	uint32_t mFaceCount;
+	uint32_t mLevelCount;
+	uint32_t mSupercompressionScheme;
+	uint32_t mDfdByteOffset;
+	uint32_t mDfdByteLength;
+	uint32_t mKvdByteOffset;
+	uint32_t mKvdByteLength;
+	uint64_t mSgdByteOffset;
+	uint64_t mSgdByteLength;
+} KTX2Header;
+
+typedef struct KTX2LevelIndex
+{
+	uint64_t mByteOffset;
+	uint64_t mByteLength;
+	uint64_t mUncompressedByteLength;
+} KTX2LevelIndex;
+
 #pragma pack(pop)
 
-// --- BLOCK DECODING ---
+// --- SIMD HELPERS ---
+
+#if defined(IMAGE_SIMD_SSE)
+typedef __m128 SimdFloat4;
+static inline SimdFloat4 simdLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void       simdStore(float* p, SimdFloat4 v) { _mm_storeu_ps(p, v); }
+static inline SimdFloat4 simdSplat(float f) { return _mm_set1_ps(f); }
+static inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return _mm_add_ps(a, b); }
+static inline SimdFloat4 simdSub(SimdFloat4 a, SimdFloat4 b) { return _mm_sub_ps(a, b); }
+static inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return _mm_mul_ps(a, b); }
+static inline SimdFloat4 simdMadd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return _mm_min_ps(a, b); }
+static inline SimdFloat4 simdMax(SimdFloat4 a, SimdFloat4 b) { return _mm_max_ps(a, b); }
+/// Lanes of a where mask is set, lanes of b otherwise. The mask comes from simdLess
+static inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline SimdFloat4 simdLess(SimdFloat4 a, SimdFloat4 b) { return _mm_cmplt_ps(a, b); }
+#elif defined(IMAGE_SIMD_NEON)
+typedef float32x4_t SimdFloat4;
+static inline SimdFloat4 simdLoad(const float* p) { return vld1q_f32(p); }
+static inline void       simdStore(float* p, SimdFloat4 v) { vst1q_f32(p, v); }
+static inline SimdFloat4 simdSplat(float f) { return vdupq_n_f32(f); }
+static inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return vaddq_f32(a, b); }
+static inline SimdFloat4 simdSub(SimdFloat4 a, SimdFloat4 b) { return vsubq_f32(a, b); }
+static inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return vmulq_f32(a, b); }
+static inline SimdFloat4 simdMadd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c) { return vmlaq_f32(c, a, b); }
+static inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return vminq_f32(a, b); }
+static inline SimdFloat4 simdMax(SimdFloat4 a, SimdFloat4 b) { return vmaxq_f32(a, b); }
+static inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+static inline SimdFloat4 simdLess(SimdFloat4 a, SimdFloat4 b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+#else
+typedef struct SimdFloat4
+{
+	float v[4];
+} SimdFloat4;
+#define SIMD_FLOAT4_OP(name, expr)                                      \
+	static inline SimdFloat4 name(SimdFloat4 a, SimdFloat4 b)           \
+	{                                                                   \
+		SimdFloat4 r;                                                   \
+		for (int i = 0; i < 4; ++i)                                     \
+			r.v[i] = expr;                                              \
+		return r;                                                       \
+	}
+SIMD_FLOAT4_OP(simdAdd, a.v[i] + b.v[i])
+SIMD_FLOAT4_OP(simdSub, a.v[i] - b.v[i])
+SIMD_FLOAT4_OP(simdMul, a.v[i] * b.v[i])
+SIMD_FLOAT4_OP(simdMin, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+SIMD_FLOAT4_OP(simdMax, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+SIMD_FLOAT4_OP(simdLess, a.v[i] < b.v[i] ? 1.0f : 0.0f)
+#undef SIMD_FLOAT4_OP
+static inline SimdFloat4 simdLoad(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+static inline void       simdStore(float* p, SimdFloat4 v) { memcpy(p, v.v, sizeof(v.v)); }
+static inline SimdFloat4 simdSplat(float f) { return { { f, f, f, f } }; }
+static inline SimdFloat4 simdMadd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c) { return simdAdd(simdMul(a, b), c); }
+static inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b)
+{
+	return { { mask.v[0] != 0.0f ? a.v[0] : b.v[0], mask.v[1] != 0.0f ? a.v[1] : b.v[1], mask.v[2] != 0.0f ? a.v[2] : b.v[2],
+			   mask.v[3] != 0.0f ? a.v[3] : b.v[3] } };
+}
+#endif
+
+static inline SimdFloat4 simdSaturate(SimdFloat4 v) { return simdMin(simdMax(v, simdSplat(0.0f)), simdSplat(1.0f)); }
+
+#if defined(IMAGE_SIMD_SSE)
+/// Expands four 8 bit unorm values, lane 0 comes from the lowest byte
+static inline SimdFloat4 simdUnpackUnorm8(uint32_t packed)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i i = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)packed), zero), zero);
+	return _mm_mul_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(1.0f / 255.0f));
+}
+static inline uint32_t simdPackUnorm8(SimdFloat4 v)
+{
+	const __m128i i = _mm_cvttps_epi32(simdMadd(simdSaturate(v), simdSplat(255.0f), simdSplat(0.5f)));
+	const __m128i w = _mm_packs_epi32(i, i);
+	return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+}
+static inline SimdFloat4 simdUnpackUnorm16(const uint16_t* p)
+{
+	const __m128i i = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+	return _mm_mul_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(1.0f / 65535.0f));
+}
+static inline void simdPackUnorm16(SimdFloat4 v, uint16_t* p)
+{
+	// SSE2 only has a signed 32 -> 16 bit pack, go through the signed range
+	__m128i i = _mm_cvttps_epi32(simdMadd(simdSaturate(v), simdSplat(65535.0f), simdSplat(0.5f)));
+	i = _mm_packs_epi32(_mm_sub_epi32(i, _mm_set1_epi32(32768)), _mm_setzero_si128());
+	_mm_storel_epi64((__m128i*)p, _mm_xor_si128(i, _mm_set1_epi16((short)0x8000)));
+}
+static inline void simdTruncate(SimdFloat4 v, int32_t* p) { _mm_storeu_si128((__m128i*)p, _mm_cvttps_epi32(v)); }
+#elif defined(IMAGE_SIMD_NEON)
+static inline SimdFloat4 simdUnpackUnorm8(uint32_t packed)
+{
+	const uint16x8_t w = vmovl_u8(vcreate_u8((uint64_t)packed));
+	return vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(w))), vdupq_n_f32(1.0f / 255.0f));
+}
+static inline uint32_t simdPackUnorm8(SimdFloat4 v)
+{
+	const uint16x4_t w = vmovn_u32(vcvtq_u32_f32(simdMadd(simdSaturate(v), simdSplat(255.0f), simdSplat(0.5f))));
+	return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(w, w))), 0);
+}
+static inline SimdFloat4 simdUnpackUnorm16(const uint16_t* p)
+{
+	return vmulq_f32(vcvtq_f32_u32(vmovl_u16(vld1_u16(p))), vdupq_n_f32(1.0f / 65535.0f));
+}
+static inline void simdPackUnorm16(SimdFloat4 v, uint16_t* p)
+{
+	vst1_u16(p, vmovn_u32(vcvtq_u32_f32(simdMadd(simdSaturate(v), simdSplat(65535.0f), simdSplat(0.5f)))));
+}
+static inline void simdTruncate(SimdFloat4 v, int32_t* p) { vst1q_s32(p, vcvtq_s32_f32(v)); }
+#else
+static inline SimdFloat4 simdUnpackUnorm8(uint32_t packed)
+{
+	const float f[4] = { (float)(packed & 0xFF), (float)((packed >> 8) & 0xFF), (float)((packed >> 16) & 0xFF), (float)(packed >> 24) };
+	return simdMul(simdLoad(f), simdSplat(1.0f / 255.0f));
+}
+static inline uint32_t simdPackUnorm8(SimdFloat4 v)
+{
+	float f[4];
+	simdStore(f, simdMadd(simdSaturate(v), simdSplat(255.0f), simdSplat(0.5f)));
+	return (uint32_t)(int32_t)f[0] | ((uint32_t)(int32_t)f[1] << 8) | ((uint32_t)(int32_t)f[2] << 16) | ((uint32_t)(int32_t)f[3] << 24);
+}
+static inline SimdFloat4 simdUnpackUnorm16(const uint16_t* p)
+{
+	const float f[4] = { (float)p[0], (float)p[1], (float)p[2], (float)p[3] };
+	return simdMul(simdLoad(f), simdSplat(1.0f / 65535.0f));
+}
+static inline void simdPackUnorm16(SimdFloat4 v, uint16_t* p)
+{
+	float f[4];
+	simdStore(f, simdMadd(simdSaturate(v), simdSplat(65535.0f), simdSplat(0.5f)));
+	for (int i = 0; i < 4; ++i)
+		p[i] = (uint16_t)(int32_t)f[i];
+}
+static inline void simdTruncate(SimdFloat4 v, int32_t* p)
+{
+	float f[4];
+	simdStore(f, v);
+	for (int i = 0; i < 4; ++i)
+		p[i] = (int32_t)f[i];
+}
+#endif
+
+#if defined(IMAGE_SIMD_F16C)
+static inline SimdFloat4 simdUnpackHalf(const uint16_t* p) { return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)p)); }
+static inline void       simdPackHalf(SimdFloat4 v, uint16_t* p)
+{
+	_mm_storel_epi64((__m128i*)p, _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+#elif defined(IMAGE_SIMD_SSE)
+// Integer versions of the F16C conversions, rounding to nearest even like _mm_cvtps_ph
+static inline SimdFloat4 simdUnpackHalf(const uint16_t* p)
+{
+	const __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+	const __m128i expMantissa = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+	const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMantissa), 16);
+	const __m128i shifted = _mm_slli_epi32(expMantissa, 13);
+	const __m128i exponent = _mm_and_si128(shifted, _mm_set1_epi32(0x7C00 << 13));
+	// Rebias the exponent, infinity and NaN move to the top exponent
+	__m128i bits = _mm_add_epi32(shifted, _mm_set1_epi32((127 - 15) << 23));
+	const __m128i isInfNan = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x7C00 << 13));
+	bits = _mm_add_epi32(bits, _mm_and_si128(isInfNan, _mm_set1_epi32((128 - 16) << 23)));
+	// Denormals are normal floats, subtracting the implicit one renormalizes them without touching float denormals
+	const __m128i isDenormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+	const __m128  denormal =
+		_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+	bits = _mm_or_si128(_mm_and_si128(isDenormal, _mm_castps_si128(denormal)), _mm_andnot_si128(isDenormal, bits));
+	return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+}
+static inline void simdPackHalf(SimdFloat4 v, uint16_t* p)
+{
+	const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128  sign = _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000)));
+	const __m128  absV = _mm_xor_ps(v, sign);
+	const __m128i absBits = _mm_castps_si128(absV);
+
+	const __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absV, absV));
+	const __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absBits);
+	const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absBits);
+	const __m128i infOrNan = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+	// The float add shifts subnormal mantissas into place and rounds them
+	const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absV, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+	const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+	const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), mantissaOdd);
+	const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+	const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+	__m128i       h = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infOrNan));
+	h = _mm_or_si128(h, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+	// Sign extend so the signed pack keeps the 16 bits
+	h = _mm_srai_epi32(_mm_slli_epi32(h, 16), 16);
+	_mm_storel_epi64((__m128i*)p, _mm_packs_epi32(h, h));
+}
+#else
+static inline SimdFloat4 simdUnpackHalf(const uint16_t* p)
+{
+	float f[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		half h;
+		h.sh = p[i];
+		f[i] = h;
+	}
+	return simdLoad(f);
+}
+static inline void simdPackHalf(SimdFloat4 v, uint16_t* p)
+{
+	float f[4];
+	simdStore(f, v);
+	for (int i = 0; i < 4; ++i)
+		p[i] = half(f[i]).sh;
+}
+#endif
+
+// --- PIXEL CONVERSION ---
 
-void iDecodeColorBlock(
-	unsigned char* dest, int w, int h, int xOff, int yOff, ImageFormat::Enum format, int red, int blue, unsigned char* src)
+/// 2^e for -126 <= e <= 127
+static inline float makePow2(int32_t e)
 {
-	unsigned char colors[4][3];
+	const uint32_t bits = (uint32_t)(e + 127) << 23;
+	float          f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
 
-	uint16 c0 = *(uint16*)src;
-	uint16 c1 = *(uint16*)(src + 2);
+/// Exponent e of v = m * 2^e with 0.5 <= m < 1 (what frexpf returns) for normal, positive v
+static inline int32_t getFrexpExponent(float v)
+{
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	return (int32_t)(bits >> 23) - 126;
+}
 
-	colors[0][0] = ((c0 >> 11) & 0x1F) << 3;
-	colors[0][1] = ((c0 >> 5) & 0x3F) << 2;
-	colors[0][2] = (c0 & 0x1F) << 3;
+// Pixel layouts the Image::Convert kernels are specialized on. load() expands a pixel to RGBA: missing channels are 0,
+// alpha is 1 and single channel formats are replicated to RGB. store() writes the first kChannelCount channels
 
-	colors[1][0] = ((c1 >> 11) & 0x1F) << 3;
-	colors[1][1] = ((c1 >> 5) & 0x3F) << 2;
-	colors[1][2] = (c1 & 0x1F) << 3;
+template <uint32_t ChannelCount, bool Bgra = false>
+struct PixelUnorm8
+{
+	static const uint32_t kChannelCount = ChannelCount;
+	static const uint32_t kPixelSize = ChannelCount;
 
-	if (c0 > c1 || format == ImageFormat::DXT5)
+	static SimdFloat4 load(const uint8_t* p)
 	{
-		for (int i = 0; i < 3; i++)
-		{
-			colors[2][i] = (2 * colors[0][i] + colors[1][i] + 1) / 3;
-			colors[3][i] = (colors[0][i] + 2 * colors[1][i] + 1) / 3;
-		}
+		// Assembled in a register, going through memory stalls on the partial store
+		uint32_t packed = 0xFF000000;
+		if (ChannelCount == 1)
+			packed |= p[0] * 0x010101u;
+		else if (ChannelCount == 4)
+			memcpy(&packed, p, sizeof(packed));
+		else
+			packed |= p[0] | (p[1] << 8) | (ChannelCount == 3 ? p[2] << 16 : 0);
+		if (Bgra)
+			packed = (packed & 0xFF00FF00) | ((packed >> 16) & 0xFF) | ((packed & 0xFF) << 16);
+		return simdUnpackUnorm8(packed);
 	}
-	else
+	static void store(uint8_t* p, SimdFloat4 v)
 	{
-		for (int i = 0; i < 3; i++)
-		{
-			colors[2][i] = (colors[0][i] + colors[1][i] + 1) >> 1;
-			colors[3][i] = 0;
-		}
+		uint32_t packed = simdPackUnorm8(v);
+		if (Bgra)
+			packed = (packed & 0xFF00FF00) | ((packed >> 16) & 0xFF) | ((packed & 0xFF) << 16);
+		memcpy(p, &packed, ChannelCount);
 	}
+};
+
+template <uint32_t ChannelCount>
+struct PixelUnorm16
+{
+	static const uint32_t kChannelCount = ChannelCount;
+	static const uint32_t kPixelSize = ChannelCount * sizeof(uint16_t);
 
-	src += 4;
-	for (int y = 0; y < h; y++)
+	static SimdFloat4 load(const uint8_t* p)
 	{
-		unsigned char* dst = dest + yOff * y;
-		unsigned int   indexes = src[y];
-		for (int x = 0; x < w; x++)
-		{
-			unsigned int index = indexes & 0x3;
-			dst[red] = colors[index][0];
-			dst[1] = colors[index][1];
-			dst[blue] = colors[index][2];
-			indexes >>= 2;
+		uint16_t values[4] = { 0, 0, 0, 0xFFFF };
+		memcpy(values, p, kPixelSize);
+		if (ChannelCount == 1)
+			values[2] = values[1] = values[0];
+		return simdUnpackUnorm16(values);
+	}
+	static void store(uint8_t* p, SimdFloat4 v)
+	{
+		uint16_t values[4];
+		simdPackUnorm16(v, values);
+		memcpy(p, values, kPixelSize);
+	}
+};
 
-			dst += xOff;
-		}
+template <uint32_t ChannelCount>
+struct PixelHalf
+{
+	static const uint32_t kChannelCount = ChannelCount;
+	static const uint32_t kPixelSize = ChannelCount * sizeof(uint16_t);
+
+	static SimdFloat4 load(const uint8_t* p)
+	{
+		uint16_t values[4] = { 0, 0, 0, 0x3C00 };
+		memcpy(values, p, kPixelSize);
+		if (ChannelCount == 1)
+			values[2] = values[1] = values[0];
+		return simdUnpackHalf(values);
 	}
-}
+	static void store(uint8_t* p, SimdFloat4 v)
+	{
+		uint16_t values[4];
+		simdPackHalf(v, values);
+		memcpy(p, values, kPixelSize);
+	}
+};
+
+template <uint32_t ChannelCount>
+struct PixelFloat
+{
+	static const uint32_t kChannelCount = ChannelCount;
+	static const uint32_t kPixelSize = ChannelCount * sizeof(float);
+
+	static SimdFloat4 load(const uint8_t* p)
+	{
+		float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		memcpy(values, p, kPixelSize);
+		if (ChannelCount == 1)
+			values[2] = values[1] = values[0];
+		return simdLoad(values);
+	}
+	static void store(uint8_t* p, SimdFloat4 v)
+	{
+		float values[4];
+		simdStore(values, v);
+		memcpy(p, values, kPixelSize);
+	}
+};
 
-void iDecodeDXT3Block(unsigned char* dest, int w, int h, int xOff, int yOff, unsigned char* src)
+/// Same encoding as rgbeToRGB / rgbToRGBE8
+struct PixelRGBE8
 {
-	for (int y = 0; y < h; y++)
+	static const uint32_t kChannelCount = 3;
+	static const uint32_t kPixelSize = 4;
+
+	static SimdFloat4 load(const uint8_t* p)
+	{
+		const float scale = p[3] ? ldexpf(1.0f, p[3] - (int)(128 + 8)) : 0.0f;
+		const float values[4] = { p[0] * scale, p[1] * scale, p[2] * scale, 1.0f };
+		return simdLoad(values);
+	}
+	static void store(uint8_t* p, SimdFloat4 v)
 	{
-		unsigned char* dst = dest + yOff * y;
-		unsigned int   alpha = ((unsigned short*)src)[y];
-		for (int x = 0; x < w; x++)
+		float rgb[4];
+		v = simdMax(v, simdSplat(0.0f));
+		simdStore(rgb, v);
+		const float m = max(max(rgb[0], rgb[1]), rgb[2]);
+		uint32_t    packed = 0;
+		if (m >= 1e-32f)
 		{
-			*dst = (alpha & 0xF) * 17;
-			alpha >>= 4;
-			dst += xOff;
+			const int32_t e = getFrexpExponent(m);
+			int32_t       c[4];
+			simdTruncate(simdMul(v, simdSplat(makePow2(8 - e))), c);
+			packed = (uint32_t)c[0] | ((uint32_t)c[1] << 8) | ((uint32_t)c[2] << 16) | ((uint32_t)(e + 128) << 24);
 		}
+		memcpy(p, &packed, sizeof(packed));
 	}
-}
+};
 
-void iDecodeDXT5Block(unsigned char* dest, int w, int h, int xOff, int yOff, unsigned char* src)
+/// Same encoding as rgbToRGB9E5
+struct PixelRGB9E5
 {
-	unsigned char a0 = src[0];
-	unsigned char a1 = src[1];
-	uint64_t      alpha = (*(uint64_t*)src) >> 16;
+	static const uint32_t kChannelCount = 3;
+	static const uint32_t kPixelSize = 4;
 
-	for (int y = 0; y < h; y++)
+	static SimdFloat4 load(const uint8_t* p)
+	{
+		uint32_t packed;
+		memcpy(&packed, p, sizeof(packed));
+		const float values[4] = { (float)(packed & 0x1FF), (float)((packed >> 9) & 0x1FF), (float)((packed >> 18) & 0x1FF), 1.0f };
+		const float e = makePow2((int32_t)(packed >> 27) - 24);
+		const float scale[4] = { e, e, e, 1.0f };
+		return simdMul(simdLoad(values), simdLoad(scale));
+	}
+	static void store(uint8_t* p, SimdFloat4 v)
 	{
-		unsigned char* dst = dest + yOff * y;
-		for (int x = 0; x < w; x++)
+		float rgb[4];
+		v = simdMax(v, simdSplat(0.0f));
+		simdStore(rgb, v);
+		const float m = max(max(rgb[0], rgb[1]), rgb[2]);
+		uint32_t    packed = 0;
+		if (m >= 1.52587890625e-5f)
 		{
-			int k = ((unsigned int)alpha) & 0x7;
-			if (k == 0)
-			{
-				*dst = a0;
-			}
-			else if (k == 1)
-			{
-				*dst = a1;
-			}
-			else if (a0 > a1)
-			{
-				*dst = (unsigned char)(((8 - k) * a0 + (k - 1) * a1) / 7);
-			}
-			else if (k >= 6)
+			int32_t  c[4];
+			uint32_t e = 31;
+			if (m < 65536.0f)
 			{
-				*dst = (k == 6) ? 0 : 255;
+				e = getFrexpExponent(m);
+				simdTruncate(simdMul(v, simdSplat(makePow2(9 - (int32_t)e))), c);
+				e += 15;
 			}
 			else
 			{
-				*dst = (unsigned char)(((6 - k) * a0 + (k - 1) * a1) / 5);
+				simdTruncate(simdMin(simdMul(v, simdSplat(1.0f / 128.0f)), simdSplat(511.0f)), c);
 			}
-			alpha >>= 3;
-
-			dst += xOff;
+			packed = (uint32_t)c[0] | ((uint32_t)c[1] << 9) | ((uint32_t)c[2] << 18) | (e << 27);
 		}
-		if (w < 4)
-			alpha >>= (3 * (4 - w));
+		memcpy(p, &packed, sizeof(packed));
 	}
-}
+};
 
-void iDecodeCompressedImage(unsigned char* dest, unsigned char* src, const int width, const int height, const ImageFormat::Enum format)
+/// Red in the top bits, alpha in the bottom two
+struct PixelRGB10A2
 {
-	int sx = (width < 4) ? width : 4;
-	int sy = (height < 4) ? height : 4;
+	static const uint32_t kChannelCount = 4;
+	static const uint32_t kPixelSize = 4;
+
+	static SimdFloat4 load(const uint8_t* p)
+	{
+		uint32_t packed;
+		memcpy(&packed, p, sizeof(packed));
+		const float values[4] = { (float)((packed >> 22) & 0x3FF), (float)((packed >> 12) & 0x3FF), (float)((packed >> 2) & 0x3FF),
+								  (float)(packed & 0x3) };
+		const float scale[4] = { 1.0f / 1023.0f, 1.0f / 1023.0f, 1.0f / 1023.0f, 1.0f / 3.0f };
+		return simdMul(simdLoad(values), simdLoad(scale));
+	}
+	static void store(uint8_t* p, SimdFloat4 v)
+	{
+		const float scale[4] = { 1023.0f, 1023.0f, 1023.0f, 3.0f };
+		int32_t     c[4];
+		simdTruncate(simdMadd(simdSaturate(v), simdLoad(scale), simdSplat(0.5f)), c);
+		const uint32_t packed = ((uint32_t)c[0] << 22) | ((uint32_t)c[1] << 12) | ((uint32_t)c[2] << 2) | (uint32_t)c[3];
+		memcpy(p, &packed, sizeof(packed));
+	}
+};
 
-	int nChannels = ImageFormat::GetChannelCount(format);
+typedef PixelUnorm8<4, true> PixelBGRA8;
 
-	for (int y = 0; y < height; y += 4)
+typedef void (*ConvertPixelsFunc)(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount);
+
+template <typename Src, typename Dst>
+static void convertPixels(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; ++i, pSrc += Src::kPixelSize, pDst += Dst::kPixelSize)
 	{
-		for (int x = 0; x < width; x += 4)
+		SimdFloat4 rgba = Src::load(pSrc);
+		if (Dst::kChannelCount == 1 && Src::kChannelCount > 1)
 		{
-			unsigned char* dst = dest + (y * width + x) * nChannels;
-			if (format == ImageFormat::DXT3)
-			{
-				iDecodeDXT3Block(dst + 3, sx, sy, nChannels, width * nChannels, src);
-				src += 8;
-			}
-			else if (format == ImageFormat::DXT5)
-			{
-				iDecodeDXT5Block(dst + 3, sx, sy, nChannels, width * nChannels, src);
-				src += 8;
-			}
-			if (format <= ImageFormat::DXT5)
-			{
-				iDecodeColorBlock(dst, sx, sy, nChannels, width * nChannels, format, 0, 2, src);
-				src += 8;
-			}
-			else
-			{
-				if (format == ImageFormat::ATI1N)
-				{
-					iDecodeDXT5Block(dst, sx, sy, 1, width, src);
-					src += 8;
-				}
-				else if ((format == ImageFormat::ATI2N))
-				{
-					iDecodeDXT5Block(dst, sx, sy, 2, width * 2, src + 8);
-					iDecodeDXT5Block(dst + 1, sx, sy, 2, width * 2, src);
-					src += 16;
-				}
-				else
-					return;
-			}
+			float c[4];
+			simdStore(c, rgba);
+			rgba = simdSplat(0.30f * c[0] + 0.59f * c[1] + 0.11f * c[2]);
 		}
+		Dst::store(pDst, rgba);
 	}
 }
 
-template <typename T>
-inline void swapPixelChannels(T* pixels, int num_pixels, const int channels, const int ch0, const int ch1)
+// 8 bit unorm swizzles and expansions are exact, these skip the round trip through float
+template <>
+void convertPixels<PixelUnorm8<3>, PixelUnorm8<4> >(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
 {
-	for (int i = 0; i < num_pixels; i++)
+	for (uint32_t i = 0; i < pixelCount; ++i, pSrc += 3, pDst += 4)
 	{
-		T tmp = pixels[ch1];
-		pixels[ch1] = pixels[ch0];
-		pixels[ch0] = tmp;
-		pixels += channels;
+		const uint32_t packed = pSrc[0] | (pSrc[1] << 8) | (pSrc[2] << 16) | 0xFF000000;
+		memcpy(pDst, &packed, sizeof(packed));
 	}
 }
 
-Image::Image()
+static void swizzleRedBlue8(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
 {
-	pData = NULL;
-	mLoadFileName = "";
-	mWidth = 0;
-	mHeight = 0;
-	mDepth = 0;
-	mMipMapCount = 0;
-	mArrayCount = 0;
-	mFormat = ImageFormat::NONE;
-	mAdditionalDataSize = 0;
-	pAdditionalData = NULL;
-	mSrgb = false;
-	mOwnsMemory = true;
-	mLinearLayout = true;
+	for (uint32_t i = 0; i < pixelCount; ++i, pSrc += 4, pDst += 4)
+	{
+		uint32_t packed;
+		memcpy(&packed, pSrc, sizeof(packed));
+		packed = (packed & 0xFF00FF00) | ((packed >> 16) & 0xFF) | ((packed & 0xFF) << 16);
+		memcpy(pDst, &packed, sizeof(packed));
+	}
 }
 
-Image::Image(const Image& img)
+template <>
+void convertPixels<PixelUnorm8<4>, PixelBGRA8>(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
 {
-	mWidth = img.mWidth;
-	mHeight = img.mHeight;
-	mDepth = img.mDepth;
-	mMipMapCount = img.mMipMapCount;
-	mArrayCount = img.mArrayCount;
-	mFormat = img.mFormat;
-	mLinearLayout = img.mLinearLayout;
-	mSrgb = img.mSrgb;
-	
-	int size = GetMipMappedSize(0, mMipMapCount) * mArrayCount;
-	pData = (unsigned char*)conf_malloc(sizeof(unsigned char) * size);
-	memcpy(pData, img.pData, size);
-	mLoadFileName = img.mLoadFileName;
-
-	mAdditionalDataSize = img.mAdditionalDataSize;
-	pAdditionalData = (unsigned char*)conf_malloc(sizeof(unsigned char) * mAdditionalDataSize);
-	memcpy(pAdditionalData, img.pAdditionalData, mAdditionalDataSize);
+	swizzleRedBlue8(pSrc, pDst, pixelCount);
 }
 
-unsigned char* Image::Create(const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize)
+template <>
+void convertPixels<PixelBGRA8, PixelUnorm8<4> >(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
 {
-	mFormat = fmt;
-	mWidth = w;
-	mHeight = h;
-	mDepth = d;
-	mMipMapCount = mipMapCount;
-	mArrayCount = arraySize;
-	mOwnsMemory = true;
-
-	uint holder = GetMipMappedSize(0, mMipMapCount);
-	pData = (unsigned char*)conf_malloc(sizeof(unsigned char) * holder * mArrayCount);
-	memset(pData, 0x00, holder * mArrayCount);
-	mLoadFileName = "Undefined";
+	swizzleRedBlue8(pSrc, pDst, pixelCount);
+}
 
-	return pData;
+#define IMAGE_CONVERT_LAYOUTS(X)                                                                                           \
+	X(R8, PixelUnorm8<1>)                                                                                                  \
+	X(RG8, PixelUnorm8<2>)                                                                                                 \
+	X(RGB8, PixelUnorm8<3>)                                                                                                \
+	X(RGBA8, PixelUnorm8<4>)                                                                                               \
+	X(BGRA8, PixelBGRA8)                                                                                                   \
+	X(R16, PixelUnorm16<1>)                                                                                                \
+	X(RG16, PixelUnorm16<2>)                                                                                               \
+	X(RGB16, PixelUnorm16<3>)                                                                                              \
+	X(RGBA16, PixelUnorm16<4>)                                                                                             \
+	X(R16F, PixelHalf<1>)                                                                                                  \
+	X(RG16F, PixelHalf<2>)                                                                                                 \
+	X(RGB16F, PixelHalf<3>)                                                                                                \
+	X(RGBA16F, PixelHalf<4>)                                                                                               \
+	X(R32F, PixelFloat<1>)                                                                                                 \
+	X(RG32F, PixelFloat<2>)                                                                                                \
+	X(RGB32F, PixelFloat<3>)                                                                                               \
+	X(RGBA32F, PixelFloat<4>)                                                                                              \
+	X(RGBE8, PixelRGBE8)                                                                                                   \
+	X(RGB9E5, PixelRGB9E5)                                                                                                 \
+	X(RGB10A2, PixelRGB10A2)
+
+template <typename Src>
+static ConvertPixelsFunc getConvertPixelsFunc(const ImageFormat::Enum dstFormat)
+{
+	switch (dstFormat)
+	{
+#define IMAGE_CONVERT_DST_CASE(format, layout) \
+	case ImageFormat::format: return convertPixels<Src, layout>;
+		IMAGE_CONVERT_LAYOUTS(IMAGE_CONVERT_DST_CASE)
+#undef IMAGE_CONVERT_DST_CASE
+		default: return NULL;
+	}
 }
 
-unsigned char* Image::Create(const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize, unsigned char* rawData)
+/// Kernel table for all source / destination pairs, NULL if the pair cannot be converted
+static ConvertPixelsFunc getConvertPixelsFunc(const ImageFormat::Enum srcFormat, const ImageFormat::Enum dstFormat)
 {
-	mFormat = fmt;
-	mWidth = w;
-	mHeight = h;
-	mDepth = d;
-	mMipMapCount = mipMapCount;
-	mArrayCount = arraySize;
-	mOwnsMemory = false;
+	switch (srcFormat)
+	{
+#define IMAGE_CONVERT_SRC_CASE(format, layout) \
+	case ImageFormat::format: return getConvertPixelsFunc<layout>(dstFormat);
+		IMAGE_CONVERT_LAYOUTS(IMAGE_CONVERT_SRC_CASE)
+#undef IMAGE_CONVERT_SRC_CASE
+		default: return NULL;
+	}
+}
 
-	pData = rawData;	
-	mLoadFileName = "Undefined";
+#define IMAGE_CONVERT_TASK_PIXEL_COUNT (64 * 1024)
 
-	return pData;
+typedef struct ConvertTask
+{
+	ConvertPixelsFunc pConvert;
+	const uint8_t*    pSrc;
+	uint8_t*          pDst;
+	uint32_t          mSrcPixelSize;
+	uint32_t          mDstPixelSize;
+	uint32_t          mPixelCount;
+} ConvertTask;
+
+static void convertPixelsTask(void* pUser, uintptr_t index)
+{
+	const ConvertTask* pTask = (const ConvertTask*)pUser;
+	const uint32_t     first = (uint32_t)index * IMAGE_CONVERT_TASK_PIXEL_COUNT;
+	const uint32_t     count = min((uint32_t)IMAGE_CONVERT_TASK_PIXEL_COUNT, pTask->mPixelCount - first);
+	pTask->pConvert(pTask->pSrc + (size_t)first * pTask->mSrcPixelSize, pTask->pDst + (size_t)first * pTask->mDstPixelSize, count);
 }
 
-void Image::RedefineDimensions(
-	const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize, bool srgb)
-{
-	//Redefine image that was loaded in
-	mFormat = fmt;
-	mWidth = w;
-	mHeight = h;
-	mDepth = d;
-	mMipMapCount = mipMapCount;
-	mArrayCount = arraySize;
-	mSrgb = srgb;
+// --- BLOCK DECODING ---
 
-	switch (mFormat)
-	{
-	case ImageFormat::PVR_2BPP:
-	case ImageFormat::PVR_2BPPA:
-	case ImageFormat::PVR_4BPP:
-	case ImageFormat::PVR_4BPPA:
-		mLinearLayout = false;
-		break;
-	default:
-		mLinearLayout = true;
-	}
+/// One face or depth slice of a mip level. The block rows of all surfaces are numbered consecutively so they can be
+/// processed in parallel
+typedef struct BlockSurface
+{
+	const uint8_t* pSrc;
+	uint8_t*       pDst;
+	uint32_t       mWidth;
+	uint32_t       mHeight;
+	/// Index of the first block row of this surface across all surfaces
+	uint32_t       mFirstBlockRow;
+} BlockSurface;
+
+static uint32_t findBlockSurface(const eastl::vector<BlockSurface>& surfaces, const uint32_t blockRow)
+{
+	uint32_t s = 0;
+	while (s + 1 < (uint32_t)surfaces.size() && surfaces[s + 1].mFirstBlockRow <= blockRow)
+		++s;
+	return s;
 }
 
-void Image::Destroy()
+/// pValues[i] = pPalette[pIndices[i]] for the 16 texels of a block
+static inline void lookupBlockPalette(const uint8_t pPalette[8], const uint8_t pIndices[16], uint8_t pValues[16])
 {
-	if (pData && mOwnsMemory)
-	{
-		conf_free(pData);
-		pData = NULL;
-	}
+#if defined(IMAGE_SIMD_SSSE3)
+	const __m128i palette = _mm_loadl_epi64((const __m128i*)pPalette);
+	_mm_storeu_si128((__m128i*)pValues, _mm_shuffle_epi8(palette, _mm_loadu_si128((const __m128i*)pIndices)));
+#else
+	for (uint32_t i = 0; i < 16; ++i)
+		pValues[i] = pPalette[pIndices[i]];
+#endif
+}
 
-	if (pAdditionalData)
+/// Same as above for four RGBA8 palette entries
+static inline void lookupBlockPalette(const uint32_t pPalette[4], const uint8_t pIndices[16], uint32_t pTexels[16])
+{
+#if defined(IMAGE_SIMD_SSSE3)
+	const __m128i palette = _mm_loadu_si128((const __m128i*)pPalette);
+	const __m128i indices = _mm_loadu_si128((const __m128i*)pIndices);
+	const __m128i byteOffsets = _mm_set1_epi32(0x03020100);
+	for (int i = 0; i < 4; ++i)
 	{
-		conf_free(pAdditionalData);
-		pAdditionalData = NULL;
+		// Spread the indices of four texels over their four bytes and turn them into byte offsets into the palette
+		const __m128i spread = _mm_set_epi8(
+			(char)(i * 4 + 3), (char)(i * 4 + 3), (char)(i * 4 + 3), (char)(i * 4 + 3), (char)(i * 4 + 2), (char)(i * 4 + 2),
+			(char)(i * 4 + 2), (char)(i * 4 + 2), (char)(i * 4 + 1), (char)(i * 4 + 1), (char)(i * 4 + 1), (char)(i * 4 + 1),
+			(char)(i * 4), (char)(i * 4), (char)(i * 4), (char)(i * 4));
+		const __m128i offsets = _mm_add_epi8(_mm_slli_epi16(_mm_shuffle_epi8(indices, spread), 2), byteOffsets);
+		_mm_storeu_si128((__m128i*)(pTexels + i * 4), _mm_shuffle_epi8(palette, offsets));
 	}
+#else
+	for (uint32_t i = 0; i < 16; ++i)
+		pTexels[i] = pPalette[pIndices[i]];
+#endif
 }
 
-void Image::Clear()
+/// Expands a 565 color to RGBA8 by bit replication, the way the GPU does
+static inline uint32_t expandColor565(const uint32_t c)
 {
-	Destroy();
+	const uint32_t r = (c >> 11) & 0x1F;
+	const uint32_t g = (c >> 5) & 0x3F;
+	const uint32_t b = c & 0x1F;
+	return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xFF000000;
+}
+
+/// Decodes the color part of a BC1 - BC3 block to RGBA8 texels. BC2 and BC3 always use the four color mode,
+/// BC1 switches to three colors and transparent black if the first endpoint is not larger than the second one
+static void decodeBC1Block(const uint8_t* pSrc, const bool allowThreeColors, uint32_t pTexels[16])
+{
+	uint16_t c0, c1;
+	uint32_t bits;
+	memcpy(&c0, pSrc, sizeof(c0));
+	memcpy(&c1, pSrc + 2, sizeof(c1));
+	memcpy(&bits, pSrc + 4, sizeof(bits));
+
+	uint32_t palette[4] = { expandColor565(c0), expandColor565(c1), 0xFF000000, 0xFF000000 };
+	const bool fourColors = c0 > c1 || !allowThreeColors;
+	for (uint32_t c = 0; c < 24; c += 8)
+	{
+		const uint32_t a = (palette[0] >> c) & 0xFF;
+		const uint32_t b = (palette[1] >> c) & 0xFF;
+		if (fourColors)
+		{
+			palette[2] |= ((2 * a + b + 1) / 3) << c;
+			palette[3] |= ((a + 2 * b + 1) / 3) << c;
+		}
+		else
+		{
+			palette[2] |= ((a + b + 1) >> 1) << c;
+		}
+	}
+	if (!fourColors)
+		palette[3] = 0;
+
+	uint8_t indices[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		indices[i] = (bits >> (2 * i)) & 0x3;
+	lookupBlockPalette(palette, indices, pTexels);
+}
+
+/// Decodes a BC4 block, the alpha part of BC3 and either half of BC5
+static void decodeBC4Block(const uint8_t* pSrc, uint8_t pValues[16])
+{
+	const uint32_t a0 = pSrc[0];
+	const uint32_t a1 = pSrc[1];
+	uint64_t       bits = 0;
+	memcpy(&bits, pSrc + 2, 6);
+
+	uint8_t palette[8] = { (uint8_t)a0, (uint8_t)a1 };
+	if (a0 > a1)
+	{
+		for (uint32_t k = 2; k < 8; ++k)
+			palette[k] = (uint8_t)(((8 - k) * a0 + (k - 1) * a1) / 7);
+	}
+	else
+	{
+		for (uint32_t k = 2; k < 6; ++k)
+			palette[k] = (uint8_t)(((6 - k) * a0 + (k - 1) * a1) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint8_t indices[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		indices[i] = (uint8_t)((bits >> (3 * i)) & 0x7);
+	lookupBlockPalette(palette, indices, pValues);
+}
+
+typedef struct DecodeTask
+{
+	eastl::vector<BlockSurface> mSurfaces;
+	ImageFormat::Enum           mSrcFormat;
+	uint32_t                    mChannelCount;
+} DecodeTask;
+
+/// Writes the first ChannelCount bytes of the w x h texels that lie inside the surface
+template <uint32_t ChannelCount>
+static inline void storeBlockTexels(const uint32_t pTexels[16], const uint32_t w, const uint32_t h, const uint32_t width, uint8_t* pDst)
+{
+	for (uint32_t y = 0; y < h; ++y, pDst += (size_t)width * ChannelCount)
+	{
+		const uint32_t* pTexel = pTexels + y * 4;
+		if (ChannelCount == 4 && w == 4)
+		{
+			memcpy(pDst, pTexel, sizeof(uint32_t) * 4);
+			continue;
+		}
+		for (uint32_t x = 0; x < w; ++x)
+			memcpy(pDst + x * ChannelCount, pTexel + x, ChannelCount);
+	}
+}
+
+/// Decodes one block row into the R8 - RGBA8 destination, texels outside of the surface are dropped.
+/// Assumes a little endian host like the rest of the block code
+static void decodeBlockRowTask(void* pUser, uintptr_t index)
+{
+	const DecodeTask*   pTask = (const DecodeTask*)pUser;
+	const BlockSurface& surface = pTask->mSurfaces[findBlockSurface(pTask->mSurfaces, (uint32_t)index)];
+	const uint32_t      by = (uint32_t)index - surface.mFirstBlockRow;
+	const uint32_t      blockCountX = (surface.mWidth + 3) / 4;
+	const uint32_t      blockSize = ImageFormat::GetBytesPerBlock(pTask->mSrcFormat);
+	const uint32_t      n = pTask->mChannelCount;
+	const uint8_t*      pSrc = surface.pSrc + (size_t)by * blockCountX * blockSize;
+
+	for (uint32_t bx = 0; bx < blockCountX; ++bx, pSrc += blockSize)
+	{
+		// Channel c of texel i ends up in byte c of texels[i]
+		uint32_t texels[16];
+		uint8_t  values[2][16];
+		switch (pTask->mSrcFormat)
+		{
+			case ImageFormat::DXT1:
+			case ImageFormat::GNF_BC1: decodeBC1Block(pSrc, true, texels); break;
+			case ImageFormat::DXT3:
+			case ImageFormat::GNF_BC2:
+			{
+				uint64_t alpha;
+				memcpy(&alpha, pSrc, sizeof(alpha));
+				decodeBC1Block(pSrc + 8, false, texels);
+				for (uint32_t i = 0; i < 16; ++i)
+					texels[i] = (texels[i] & 0x00FFFFFF) | ((uint32_t)((alpha >> (4 * i)) & 0xF) * 17 << 24);
+				break;
+			}
+			case ImageFormat::DXT5:
+			case ImageFormat::GNF_BC3:
+				decodeBC4Block(pSrc, values[0]);
+				decodeBC1Block(pSrc + 8, false, texels);
+				for (uint32_t i = 0; i < 16; ++i)
+					texels[i] = (texels[i] & 0x00FFFFFF) | ((uint32_t)values[0][i] << 24);
+				break;
+			case ImageFormat::ATI1N:
+			case ImageFormat::GNF_BC4:
+				decodeBC4Block(pSrc, values[0]);
+				for (uint32_t i = 0; i < 16; ++i)
+					texels[i] = values[0][i];
+				break;
+			// Red comes first like on the GPU, ATI2N files are BC5 (DXGI_FORMAT_BC5_UNORM)
+			case ImageFormat::ATI2N:
+			case ImageFormat::GNF_BC5:
+				decodeBC4Block(pSrc, values[0]);
+				decodeBC4Block(pSrc + 8, values[1]);
+				for (uint32_t i = 0; i < 16; ++i)
+					texels[i] = values[0][i] | ((uint32_t)values[1][i] << 8);
+				break;
+			default: return;
+		}
+
+		const uint32_t w = min(4u, surface.mWidth - bx * 4);
+		const uint32_t h = min(4u, surface.mHeight - by * 4);
+		uint8_t*       pDst = surface.pDst + ((size_t)by * 4 * surface.mWidth + bx * 4) * n;
+		switch (n)
+		{
+			case 1: storeBlockTexels<1>(texels, w, h, surface.mWidth, pDst); break;
+			case 2: storeBlockTexels<2>(texels, w, h, surface.mWidth, pDst); break;
+			case 3: storeBlockTexels<3>(texels, w, h, surface.mWidth, pDst); break;
+			default: storeBlockTexels<4>(texels, w, h, surface.mWidth, pDst); break;
+		}
+	}
+}
+
+// --- BLOCK ENCODING ---
+
+/// 4x4 block, one row of 16 values per channel so the pixels can be processed four at a time
+typedef struct EncodeBlock
+{
+	float mValues[4][16];
+} EncodeBlock;
+
+typedef struct BlockBitWriter
+{
+	uint64_t mBits[2];
+	uint32_t mPosition;
+} BlockBitWriter;
+
+static void writeBlockBits(BlockBitWriter* pWriter, uint32_t value, uint32_t bitCount)
+{
+	for (uint32_t i = 0; i < bitCount; ++i, ++pWriter->mPosition)
+		pWriter->mBits[pWriter->mPosition >> 6] |= (uint64_t)((value >> i) & 1) << (pWriter->mPosition & 63);
+}
+
+/// Principal axis of the block through power iteration, returns the two extremes of the block along it
+static void computeBlockEndpoints(const EncodeBlock& block, uint32_t channelCount, float e0[4], float e1[4])
+{
+	float mean[4] = {};
+	for (uint32_t c = 0; c < channelCount; ++c)
+	{
+		for (uint32_t i = 0; i < 16; ++i)
+			mean[c] += block.mValues[c][i];
+		mean[c] *= 1.0f / 16.0f;
+	}
+
+	float cov[4][4] = {};
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		for (uint32_t a = 0; a < channelCount; ++a)
+			for (uint32_t b = a; b < channelCount; ++b)
+				cov[a][b] += (block.mValues[a][i] - mean[a]) * (block.mValues[b][i] - mean[b]);
+	}
+	for (uint32_t a = 0; a < channelCount; ++a)
+		for (uint32_t b = 0; b < a; ++b)
+			cov[a][b] = cov[b][a];
+
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (uint32_t iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+		for (uint32_t a = 0; a < channelCount; ++a)
+		{
+			for (uint32_t b = 0; b < channelCount; ++b)
+				next[a] += cov[a][b] * axis[b];
+			length = max(length, fabsf(next[a]));
+		}
+		if (length < 1e-6f)
+			break;
+		for (uint32_t a = 0; a < channelCount; ++a)
+			axis[a] = next[a] / length;
+	}
+
+	float tMin = 0.0f, tMax = 0.0f, lengthSq = 0.0f;
+	for (uint32_t c = 0; c < channelCount; ++c)
+		lengthSq += axis[c] * axis[c];
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		float t = 0.0f;
+		for (uint32_t c = 0; c < channelCount; ++c)
+			t += (block.mValues[c][i] - mean[c]) * axis[c];
+		tMin = min(tMin, t);
+		tMax = max(tMax, t);
+	}
+
+	for (uint32_t c = 0; c < channelCount; ++c)
+	{
+		e0[c] = mean[c] + axis[c] * tMin / lengthSq;
+		e1[c] = mean[c] + axis[c] * tMax / lengthSq;
+	}
+}
+
+/// Picks the closest palette entry for every pixel and returns the summed squared error
+static float selectBlockIndices(
+	const EncodeBlock& block, uint32_t channelCount, const float palette[][4], uint32_t paletteSize, uint8_t indices[16])
+{
+	SimdFloat4 totalError = simdSplat(0.0f);
+	for (uint32_t i = 0; i < 16; i += 4)
+	{
+		SimdFloat4 bestError = simdSplat(FLT_MAX);
+		SimdFloat4 bestIndex = simdSplat(0.0f);
+		for (uint32_t k = 0; k < paletteSize; ++k)
+		{
+			SimdFloat4 error = simdSplat(0.0f);
+			for (uint32_t c = 0; c < channelCount; ++c)
+			{
+				const SimdFloat4 d = simdSub(simdLoad(&block.mValues[c][i]), simdSplat(palette[k][c]));
+				error = simdMadd(d, d, error);
+			}
+			const SimdFloat4 better = simdLess(error, bestError);
+			bestIndex = simdSelect(better, simdSplat((float)k), bestIndex);
+			bestError = simdMin(error, bestError);
+		}
+
+		float index[4];
+		simdStore(index, bestIndex);
+		for (uint32_t j = 0; j < 4; ++j)
+			indices[i + j] = (uint8_t)index[j];
+		totalError = simdAdd(totalError, bestError);
+	}
+
+	float error[4];
+	simdStore(error, totalError);
+	return error[0] + error[1] + error[2] + error[3];
+}
+
+/// Least squares fit of the endpoints for fixed indices. pWeights maps an index to the interpolation weight of e1
+static bool refineBlockEndpoints(
+	const EncodeBlock& block, uint32_t channelCount, const uint8_t indices[16], const float* pWeights, float e0[4], float e1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const float b = pWeights[indices[i]];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			ax[c] += a * block.mValues[c][i];
+			bx[c] += b * block.mValues[c][i];
+		}
+	}
+
+	const float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f)
+		return false;
+	for (uint32_t c = 0; c < channelCount; ++c)
+	{
+		e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+		e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+	}
+	return true;
+}
+
+static uint32_t getRefinementCount(CompressionQuality quality)
+{
+	static const uint32_t counts[] = { 0, 1, 3 };
+	return counts[quality];
+}
+
+static uint16_t quantizeRGB565(const float c[4])
+{
+	const uint32_t r = (uint32_t)(clamp(c[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = (uint32_t)(clamp(c[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = (uint32_t)(clamp(c[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void expandRGB565(uint16_t v, float c[4])
+{
+	const uint32_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+	c[0] = (float)((r << 3) | (r >> 2));
+	c[1] = (float)((g << 2) | (g >> 4));
+	c[2] = (float)((b << 3) | (b >> 2));
+	c[3] = 0.0f;
+}
+
+/// BC1 color block, always in four color mode
+static void encodeBC1Block(const EncodeBlock& block, CompressionQuality quality, uint8_t* pDst)
+{
+	static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	float              e0[4], e1[4];
+	computeBlockEndpoints(block, 3, e0, e1);
+
+	uint16_t bestColors[2] = {};
+	uint8_t  bestIndices[16] = {};
+	float    bestError = FLT_MAX;
+	for (uint32_t iteration = 0; iteration <= getRefinementCount(quality); ++iteration)
+	{
+		uint16_t c0 = quantizeRGB565(e0), c1 = quantizeRGB565(e1);
+		if (c0 < c1)
+			eastl::swap(c0, c1);
+
+		float palette[4][4];
+		expandRGB565(c0, palette[0]);
+		expandRGB565(c1, palette[1]);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		// Equal endpoints would switch the decoder to three color mode
+		uint8_t     indices[16];
+		const float error = selectBlockIndices(block, 3, palette, c0 == c1 ? 1 : 4, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestColors[0] = c0;
+			bestColors[1] = c1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (c0 == c1 || !refineBlockEndpoints(block, 3, indices, weights, e0, e1))
+			break;
+	}
+
+	memcpy(pDst, bestColors, sizeof(bestColors));
+	for (uint32_t y = 0; y < 4; ++y)
+		pDst[4 + y] = (uint8_t)(bestIndices[y * 4] | (bestIndices[y * 4 + 1] << 2) | (bestIndices[y * 4 + 2] << 4) | (bestIndices[y * 4 + 3] << 6));
+}
+
+/// BC4 block of channel c, also used for the alpha of BC3 and both channels of BC5
+static void encodeBC4Block(const EncodeBlock& block, uint32_t channel, CompressionQuality quality, uint8_t* pDst)
+{
+	EncodeBlock single;
+	memcpy(single.mValues[0], block.mValues[channel], sizeof(single.mValues[0]));
+
+	float e0[4] = {}, e1[4] = {};
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		e0[0] = i ? max(e0[0], single.mValues[0][i]) : single.mValues[0][i];
+		e1[0] = i ? min(e1[0], single.mValues[0][i]) : single.mValues[0][i];
+	}
+
+	// Eight value mode: index 0 and 1 are the endpoints, 2 - 7 step from the first endpoint to the second
+	float weights[8] = { 0.0f, 1.0f };
+	for (uint32_t k = 2; k < 8; ++k)
+		weights[k] = (float)(k - 1) / 7.0f;
+
+	uint8_t bestEndpoints[2] = {};
+	uint8_t bestIndices[16] = {};
+	float   bestError = FLT_MAX;
+	for (uint32_t iteration = 0; iteration <= getRefinementCount(quality); ++iteration)
+	{
+		uint8_t a0 = (uint8_t)(clamp(e0[0], 0.0f, 255.0f) + 0.5f);
+		uint8_t a1 = (uint8_t)(clamp(e1[0], 0.0f, 255.0f) + 0.5f);
+		if (a0 < a1)
+			eastl::swap(a0, a1);
+
+		float palette[8][4] = {};
+		palette[0][0] = a0;
+		palette[1][0] = a1;
+		for (uint32_t k = 2; k < 8; ++k)
+			palette[k][0] = (float)((8 - k) * a0 + (k - 1) * a1) / 7.0f;
+
+		// Equal endpoints select the six value mode, only index 0 is valid then
+		uint8_t     indices[16];
+		const float error = selectBlockIndices(single, 1, palette, a0 == a1 ? 1 : 8, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestEndpoints[0] = a0;
+			bestEndpoints[1] = a1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (a0 == a1 || !refineBlockEndpoints(single, 1, indices, weights, e0, e1))
+			break;
+	}
+
+	pDst[0] = bestEndpoints[0];
+	pDst[1] = bestEndpoints[1];
+	uint64_t bits = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+		bits |= (uint64_t)bestIndices[i] << (3 * i);
+	for (uint32_t i = 0; i < 6; ++i)
+		pDst[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+static const uint32_t gBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// BC7 mode 6: one subset, 7 bit RGBA endpoints with a shared bit each and 4 bit indices
+static void encodeBC7Block(const EncodeBlock& block, CompressionQuality quality, uint8_t* pDst)
+{
+	float weights[16];
+	for (uint32_t k = 0; k < 16; ++k)
+		weights[k] = (float)gBC7Weights4[k] / 64.0f;
+
+	float e0[4], e1[4];
+	computeBlockEndpoints(block, 4, e0, e1);
+
+	uint32_t bestEndpoints[2][4] = {};
+	uint32_t bestPBits[2] = {};
+	uint8_t  bestIndices[16] = {};
+	float    bestError = FLT_MAX;
+	for (uint32_t iteration = 0; iteration <= getRefinementCount(quality); ++iteration)
+	{
+		uint8_t indices[16];
+		for (uint32_t pBits = 0; pBits < 4; ++pBits)
+		{
+			// The fast path only tries the shared bits matching the rounding of the endpoints
+			const uint32_t p0 = pBits & 1, p1 = pBits >> 1;
+			if (quality == COMPRESSION_QUALITY_FAST && (p0 != ((uint32_t)(e0[0] + 0.5f) & 1) || p1 != ((uint32_t)(e1[0] + 0.5f) & 1)))
+				continue;
+
+			uint32_t q[2][4];
+			float    palette[16][4];
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				q[0][c] = (uint32_t)(clamp((e0[c] - (float)p0) * 0.5f, 0.0f, 127.0f) + 0.5f);
+				q[1][c] = (uint32_t)(clamp((e1[c] - (float)p1) * 0.5f, 0.0f, 127.0f) + 0.5f);
+				const uint32_t v0 = (q[0][c] << 1) | p0, v1 = (q[1][c] << 1) | p1;
+				for (uint32_t k = 0; k < 16; ++k)
+					palette[k][c] = (float)(((64 - gBC7Weights4[k]) * v0 + gBC7Weights4[k] * v1 + 32) >> 6);
+			}
+
+			const float error = selectBlockIndices(block, 4, palette, 16, indices);
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(bestEndpoints, q, sizeof(q));
+				bestPBits[0] = p0;
+				bestPBits[1] = p1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+		}
+		if (!refineBlockEndpoints(block, 4, bestIndices, weights, e0, e1))
+			break;
+	}
+
+	// The most significant index bit of the first pixel is implicit zero
+	if (bestIndices[0] & 8)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			eastl::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+		eastl::swap(bestPBits[0], bestPBits[1]);
+		for (uint32_t i = 0; i < 16; ++i)
+			bestIndices[i] = 15 - bestIndices[i];
+	}
+
+	BlockBitWriter writer = {};
+	writeBlockBits(&writer, 1 << 6, 7);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		writeBlockBits(&writer, bestEndpoints[0][c], 7);
+		writeBlockBits(&writer, bestEndpoints[1][c], 7);
+	}
+	writeBlockBits(&writer, bestPBits[0], 1);
+	writeBlockBits(&writer, bestPBits[1], 1);
+	for (uint32_t i = 0; i < 16; ++i)
+		writeBlockBits(&writer, bestIndices[i], i ? 4 : 3);
+	memcpy(pDst, writer.mBits, sizeof(writer.mBits));
+}
+
+/// Inverse of the 10 bit endpoint quantization of unsigned BC6H, result is in the half bits domain
+static uint32_t unquantizeBC6H(uint32_t q)
+{
+	if (q == 0)
+		return 0;
+	if (q == 1023)
+		return 0xFFFF;
+	return ((q << 16) + 0x8000) >> 10;
+}
+
+/// BC6H mode 11: one region, 10 bit endpoints without delta encoding and 4 bit indices.
+/// Values are the half float bit patterns which interpolate roughly logarithmically
+static void encodeBC6HBlock(const EncodeBlock& block, CompressionQuality quality, uint8_t* pDst)
+{
+	float weights[16];
+	for (uint32_t k = 0; k < 16; ++k)
+		weights[k] = (float)gBC7Weights4[k] / 64.0f;
+
+	float e0[4], e1[4];
+	computeBlockEndpoints(block, 3, e0, e1);
+
+	uint32_t bestEndpoints[2][3] = {};
+	uint8_t  bestIndices[16] = {};
+	float    bestError = FLT_MAX;
+	for (uint32_t iteration = 0; iteration <= getRefinementCount(quality); ++iteration)
+	{
+		uint32_t q[2][3];
+		float    palette[16][4];
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			q[0][c] = (uint32_t)(clamp((e0[c] - 15.5f) / 31.0f, 0.0f, 1023.0f) + 0.5f);
+			q[1][c] = (uint32_t)(clamp((e1[c] - 15.5f) / 31.0f, 0.0f, 1023.0f) + 0.5f);
+			const uint32_t u0 = unquantizeBC6H(q[0][c]), u1 = unquantizeBC6H(q[1][c]);
+			for (uint32_t k = 0; k < 16; ++k)
+				palette[k][c] = (float)(((((64 - gBC7Weights4[k]) * u0 + gBC7Weights4[k] * u1 + 32) >> 6) * 31) >> 6);
+		}
+
+		uint8_t     indices[16];
+		const float error = selectBlockIndices(block, 3, palette, 16, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			memcpy(bestEndpoints, q, sizeof(q));
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+		if (!refineBlockEndpoints(block, 3, indices, weights, e0, e1))
+			break;
+	}
+
+	if (bestIndices[0] & 8)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+			eastl::swap(bestEndpoints[0][c], bestEndpoints[1][c]);
+		for (uint32_t i = 0; i < 16; ++i)
+			bestIndices[i] = 15 - bestIndices[i];
+	}
+
+	BlockBitWriter writer = {};
+	writeBlockBits(&writer, 0x03, 5);
+	for (uint32_t e = 0; e < 2; ++e)
+		for (uint32_t c = 0; c < 3; ++c)
+			writeBlockBits(&writer, bestEndpoints[e][c], 10);
+	for (uint32_t i = 0; i < 16; ++i)
+		writeBlockBits(&writer, bestIndices[i], i ? 4 : 3);
+	memcpy(pDst, writer.mBits, sizeof(writer.mBits));
+}
+
+typedef struct CompressTask
+{
+	eastl::vector<BlockSurface> mSurfaces;
+	ImageFormat::Enum           mSrcFormat;
+	ImageFormat::Enum           mDstFormat;
+	CompressionQuality          mQuality;
+	uint32_t                    mChannelCount;
+	uint32_t                    mPixelSize;
+} CompressTask;
+
+/// Loads a 4x4 block, texels outside of the surface are clamped to the edge.
+/// Unorm formats are loaded in the 0 - 255 range, float formats as half float bit patterns
+static void loadEncodeBlock(const CompressTask* pTask, const BlockSurface& surface, uint32_t bx, uint32_t by, EncodeBlock* pBlock)
+{
+	const ImageFormat::Enum fmt = pTask->mSrcFormat;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t x = min(bx * 4 + (i & 3), surface.mWidth - 1);
+		const uint32_t y = min(by * 4 + (i >> 2), surface.mHeight - 1);
+		const uint8_t* pPixel = surface.pSrc + ((size_t)y * surface.mWidth + x) * pTask->mPixelSize;
+		float          rgba[4] = { 0.0f, 0.0f, 0.0f, 255.0f };
+		for (uint32_t c = 0; c < pTask->mChannelCount; ++c)
+		{
+			if (fmt >= ImageFormat::R32F && fmt <= ImageFormat::RGBA32F)
+				rgba[c] = (float)half(clamp(((const float*)pPixel)[c], 0.0f, 65504.0f)).sh;
+			else if (fmt >= ImageFormat::R16F && fmt <= ImageFormat::RGBA16F)
+				rgba[c] = (float)min(((const uint16_t*)pPixel)[c] & 0x8000 ? 0 : ((const uint16_t*)pPixel)[c], 0x7BFF);
+			else
+				rgba[c] = (float)pPixel[c];
+		}
+		if (fmt == ImageFormat::BGRA8)
+			eastl::swap(rgba[0], rgba[2]);
+		for (uint32_t c = 0; c < 4; ++c)
+			pBlock->mValues[c][i] = rgba[c];
+	}
+}
+
+static void compressBlockRowTask(void* pUser, uintptr_t index)
+{
+	const CompressTask* pTask = (const CompressTask*)pUser;
+	const BlockSurface& surface = pTask->mSurfaces[findBlockSurface(pTask->mSurfaces, (uint32_t)index)];
+	const uint32_t      by = (uint32_t)index - surface.mFirstBlockRow;
+	const uint32_t      blockCountX = (surface.mWidth + 3) / 4;
+	const uint32_t      blockSize = ImageFormat::GetBytesPerBlock(pTask->mDstFormat);
+	uint8_t*            pDst = surface.pDst + (size_t)by * blockCountX * blockSize;
+
+	for (uint32_t bx = 0; bx < blockCountX; ++bx, pDst += blockSize)
+	{
+		EncodeBlock block;
+		loadEncodeBlock(pTask, surface, bx, by, &block);
+		switch (pTask->mDstFormat)
+		{
+			case ImageFormat::DXT1:
+			case ImageFormat::GNF_BC1: encodeBC1Block(block, pTask->mQuality, pDst); break;
+			case ImageFormat::DXT5:
+			case ImageFormat::GNF_BC3:
+				encodeBC4Block(block, 3, pTask->mQuality, pDst);
+				encodeBC1Block(block, pTask->mQuality, pDst + 8);
+				break;
+			case ImageFormat::ATI1N:
+			case ImageFormat::GNF_BC4: encodeBC4Block(block, 0, pTask->mQuality, pDst); break;
+			// Red in the first block, the same order decodeBlockRowTask reads
+			case ImageFormat::ATI2N:
+			case ImageFormat::GNF_BC5:
+				encodeBC4Block(block, 0, pTask->mQuality, pDst);
+				encodeBC4Block(block, 1, pTask->mQuality, pDst + 8);
+				break;
+			case ImageFormat::GNF_BC6HUF: encodeBC6HBlock(block, pTask->mQuality, pDst); break;
+			case ImageFormat::GNF_BC7: encodeBC7Block(block, pTask->mQuality, pDst); break;
+			default: break;
+		}
+	}
+}
+
+template <typename T>
+inline void swapPixelChannels(T* pixels, int num_pixels, const int channels, const int ch0, const int ch1)
+{
+	for (int i = 0; i < num_pixels; i++)
+	{
+		T tmp = pixels[ch1];
+		pixels[ch1] = pixels[ch0];
+		pixels[ch0] = tmp;
+		pixels += channels;
+	}
+}
+
+Image::Image()
+{
+	pData = NULL;
+	mLoadFileName = "";
+	mWidth = 0;
+	mHeight = 0;
+	mDepth = 0;
+	mMipMapCount = 0;
+	mArrayCount = 0;
+	mMaxLoadSize = 0;
+	mSkippedMipCount = 0;
+	mSourceWidth = 0;
+	mSourceHeight = 0;
+	mFormat = ImageFormat::NONE;
+	mAdditionalDataSize = 0;
+	pAdditionalData = NULL;
+	mSrgb = false;
+	mOwnsMemory = true;
+	mLinearLayout = true;
+}
+
+Image::Image(const Image& img)
+{
+	mWidth = img.mWidth;
+	mHeight = img.mHeight;
+	mDepth = img.mDepth;
+	mMipMapCount = img.mMipMapCount;
+	mArrayCount = img.mArrayCount;
+	mMaxLoadSize = img.mMaxLoadSize;
+	mSkippedMipCount = img.mSkippedMipCount;
+	mSourceWidth = img.mSourceWidth;
+	mSourceHeight = img.mSourceHeight;
+	mFormat = img.mFormat;
+	mLinearLayout = img.mLinearLayout;
+	mSrgb = img.mSrgb;
+	
+	int size = GetMipMappedSize(0, mMipMapCount) * mArrayCount;
+	pData = (unsigned char*)conf_malloc(sizeof(unsigned char) * size);
+	memcpy(pData, img.pData, size);
+	mLoadFileName = img.mLoadFileName;
+
+	mAdditionalDataSize = img.mAdditionalDataSize;
+	pAdditionalData = (unsigned char*)conf_malloc(sizeof(unsigned char) * mAdditionalDataSize);
+	memcpy(pAdditionalData, img.pAdditionalData, mAdditionalDataSize);
+}
+
+unsigned char* Image::Create(const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize)
+{
+	mFormat = fmt;
+	mWidth = w;
+	mHeight = h;
+	mDepth = d;
+	mMipMapCount = mipMapCount;
+	mArrayCount = arraySize;
+	mOwnsMemory = true;
+
+	uint holder = GetMipMappedSize(0, mMipMapCount);
+	pData = (unsigned char*)conf_malloc(sizeof(unsigned char) * holder * mArrayCount);
+	memset(pData, 0x00, holder * mArrayCount);
+	mLoadFileName = "Undefined";
+
+	return pData;
+}
+
+unsigned char* Image::Create(const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize, unsigned char* rawData)
+{
+	mFormat = fmt;
+	mWidth = w;
+	mHeight = h;
+	mDepth = d;
+	mMipMapCount = mipMapCount;
+	mArrayCount = arraySize;
+	mOwnsMemory = false;
+
+	pData = rawData;	
+	mLoadFileName = "Undefined";
+
+	return pData;
+}
+
+void Image::RedefineDimensions(
+	const ImageFormat::Enum fmt, const int w, const int h, const int d, const int mipMapCount, const int arraySize, bool srgb)
+{
+	//Redefine image that was loaded in
+	mFormat = fmt;
+	mWidth = w;
+	mHeight = h;
+	mDepth = d;
+	mMipMapCount = mipMapCount;
+	mArrayCount = arraySize;
+	mSrgb = srgb;
+
+	switch (mFormat)
+	{
+	case ImageFormat::PVR_2BPP:
+	case ImageFormat::PVR_2BPPA:
+	case ImageFormat::PVR_4BPP:
+	case ImageFormat::PVR_4BPPA:
+		mLinearLayout = false;
+		break;
+	default:
+		mLinearLayout = true;
+	}
+}
+
+void Image::Destroy()
+{
+	if (pData && mOwnsMemory)
+	{
+		conf_free(pData);
+		pData = NULL;
+	}
+
+	if (pAdditionalData)
+	{
+		conf_free(pAdditionalData);
+		pAdditionalData = NULL;
+	}
+}
+
+void Image::Clear()
+{
+	Destroy();
 
 	mWidth = 0;
 	mHeight = 0;
 	mDepth = 0;
 	mMipMapCount = 0;
 	mArrayCount = 0;
+	mSkippedMipCount = 0;
 	mFormat = ImageFormat::NONE;
 
 	mAdditionalDataSize = 0;
 }
 
+uint Image::SkipMipLevelsAboveMaxLoadSize()
+{
+	mSkippedMipCount = 0;
+	// Levels of volume textures shrink in depth as well, they are always loaded whole
+	if (!mMaxLoadSize || mDepth > 1)
+		return 0;
+
+	const uint3 blockSize = ImageFormat::GetBlockSize(mFormat);
+	uint        skipped = 0;
+	while (skipped + 1 < mMipMapCount && max(GetWidth(skipped), GetHeight(skipped)) > mMaxLoadSize)
+		++skipped;
+	while (skipped > 0 && (GetWidth(skipped) % blockSize.x || GetHeight(skipped) % blockSize.y))
+		--skipped;
+	if (!skipped)
+		return 0;
+
+	const uint skippedSize = GetMipMappedSize(0, skipped);
+	mSourceWidth = mWidth;
+	mSourceHeight = mHeight;
+	RedefineDimensions(mFormat, GetWidth(skipped), GetHeight(skipped), mDepth, mMipMapCount - skipped, mArrayCount, mSrgb);
+	mSkippedMipCount = skipped;
+	return skippedSize;
+}
+
 unsigned char* Image::GetPixels(unsigned char* pDstData, const uint mipMapLevel, const uint dummy)
 {
 	UNREF_PARAM(dummy);
@@ -912,56 +2101,172 @@ bool Image::Normalize()
 	return true;
 }
 
-bool Image::Uncompress()
+bool Image::Uncompress(ThreadSystem* pThreadSystem)
 {
-	if (((mFormat >= ImageFormat::PVR_2BPP) && (mFormat <= ImageFormat::PVR_4BPPA)) ||
-		((mFormat >= ImageFormat::ETC1) && (mFormat <= ImageFormat::ATCI)))
+	ImageFormat::Enum destFormat;
+	switch (mFormat)
 	{
-		//  no decompression
-		return false;
+		case ImageFormat::DXT1:
+		case ImageFormat::GNF_BC1: destFormat = ImageFormat::RGB8; break;
+		case ImageFormat::DXT3:
+		case ImageFormat::DXT5:
+		case ImageFormat::GNF_BC2:
+		case ImageFormat::GNF_BC3: destFormat = ImageFormat::RGBA8; break;
+		case ImageFormat::ATI1N:
+		case ImageFormat::GNF_BC4: destFormat = ImageFormat::I8; break;
+		case ImageFormat::ATI2N:
+		case ImageFormat::GNF_BC5: destFormat = ImageFormat::IA8; break;
+		default:
+			//  no decompression
+			return !ImageFormat::IsCompressedFormat(mFormat);
 	}
 
-	if (ImageFormat::IsCompressedFormat(mFormat))
+	const uint32_t faceCount = IsCube() ? 6 : 1;
+	const uint32_t dstSliceSize = GetMipMappedSize(0, mMipMapCount, destFormat);
+	ubyte*         newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * dstSliceSize * mArrayCount);
+
+	DecodeTask task;
+	task.mSrcFormat = mFormat;
+	task.mChannelCount = ImageFormat::GetChannelCount(destFormat);
+
+	// Every face and depth slice of every mip level is decoded on its own
+	uint32_t blockRowCount = 0;
+	for (uint32_t arraySlice = 0; arraySlice < mArrayCount; ++arraySlice)
 	{
-		ImageFormat::Enum destFormat;
-		if (mFormat >= ImageFormat::ATI1N)
-		{
-			destFormat = (mFormat == ImageFormat::ATI1N) ? ImageFormat::I8 : ImageFormat::IA8;
-		}
-		else
+		for (uint32_t level = 0; level < mMipMapCount; ++level)
 		{
-			destFormat = (mFormat == ImageFormat::DXT1) ? ImageFormat::RGB8 : ImageFormat::RGBA8;
+			const uint32_t w = GetWidth(level), h = GetHeight(level);
+			const uint32_t surfaceCount = IsCube() ? faceCount : GetDepth(level);
+			const uint8_t* pSrc = GetPixels(level, arraySlice);
+			uint8_t*       pDst = newPixels + dstSliceSize * arraySlice + GetMipMappedSize(0, level, destFormat);
+			for (uint32_t i = 0; i < surfaceCount; ++i)
+			{
+				BlockSurface surface = { pSrc, pDst, w, h, blockRowCount };
+				task.mSurfaces.push_back(surface);
+				pSrc += GetArraySliceSize(level, mFormat);
+				pDst += GetArraySliceSize(level, destFormat);
+				blockRowCount += (h + 3) / 4;
+			}
 		}
+	}
+
+	if (pThreadSystem && blockRowCount > 1)
+	{
+		TaskGroup* pGroup = NULL;
+		addTaskGroup(pThreadSystem, &pGroup);
+		TaskDesc desc = {};
+		desc.pTask = decodeBlockRowTask;
+		desc.pUser = &task;
+		desc.mStart = 0;
+		desc.mEnd = blockRowCount;
+		desc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &desc);
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+		removeTaskGroup(pThreadSystem, pGroup);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < blockRowCount; ++i)
+			decodeBlockRowTask(&task, i);
+	}
 
-		ubyte* newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * GetMipMappedSize(0, mMipMapCount, destFormat));
+	mFormat = destFormat;
 
-		int    level = 0;
-		ubyte *src, *dst = newPixels;
-		while ((src = GetPixels(level)) != NULL)
-		{
-			int w = GetWidth(level);
-			int h = GetHeight(level);
-			int d = (mDepth == 0) ? 6 : GetDepth(level);
+	Destroy();
+	pData = newPixels;
+	mOwnsMemory = true;
+
+	return true;
+}
 
-			int dstSliceSize = GetArraySliceSize(level, destFormat);
-			int srcSliceSize = GetArraySliceSize(level, mFormat);
+bool Image::Compress(const ImageFormat::Enum newFormat, const CompressionQuality quality, ThreadSystem* pThreadSystem)
+{
+	const bool hdrTarget = newFormat == ImageFormat::GNF_BC6HUF;
+	switch (newFormat)
+	{
+		case ImageFormat::DXT1:
+		case ImageFormat::DXT5:
+		case ImageFormat::ATI1N:
+		case ImageFormat::ATI2N:
+		case ImageFormat::GNF_BC1:
+		case ImageFormat::GNF_BC3:
+		case ImageFormat::GNF_BC4:
+		case ImageFormat::GNF_BC5:
+		case ImageFormat::GNF_BC6HUF:
+		case ImageFormat::GNF_BC7: break;
+		default:
+			LOGF(LogLevel::eERROR, "Image::Compress: %s is not supported as target format", ImageFormat::GetFormatString(newFormat));
+			return false;
+	}
 
-			for (int slice = 0; slice < d; slice++)
-			{
-				iDecodeCompressedImage(dst, src, w, h, mFormat);
+	const bool unorm8 = (mFormat >= ImageFormat::R8 && mFormat <= ImageFormat::RGBA8) || mFormat == ImageFormat::BGRA8;
+	const bool floatFormat = mFormat >= ImageFormat::R16F && mFormat <= ImageFormat::RGBA32F;
+	if ((hdrTarget && !floatFormat) || (!hdrTarget && !unorm8))
+	{
+		LOGF(
+			LogLevel::eERROR, "Image::Compress: cannot compress %s to %s", ImageFormat::GetFormatString(mFormat),
+			ImageFormat::GetFormatString(newFormat));
+		return false;
+	}
+
+	const uint32_t faceCount = IsCube() ? 6 : 1;
+	const uint32_t dstSliceSize = GetMipMappedSize(0, mMipMapCount, newFormat);
+	ubyte*         newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * dstSliceSize * mArrayCount);
 
-				dst += dstSliceSize;
-				src += srcSliceSize;
+	CompressTask task;
+	task.mSrcFormat = mFormat;
+	task.mDstFormat = newFormat;
+	task.mQuality = quality;
+	task.mChannelCount = ImageFormat::GetChannelCount(mFormat);
+	task.mPixelSize = ImageFormat::GetBytesPerPixel(mFormat);
+
+	// Every face and depth slice of every mip level is compressed on its own
+	uint32_t blockRowCount = 0;
+	for (uint32_t arraySlice = 0; arraySlice < mArrayCount; ++arraySlice)
+	{
+		for (uint32_t level = 0; level < mMipMapCount; ++level)
+		{
+			const uint32_t w = GetWidth(level), h = GetHeight(level);
+			const uint32_t surfaceCount = IsCube() ? faceCount : GetDepth(level);
+			const uint8_t* pSrc = GetPixels(level, arraySlice);
+			uint8_t*       pDst = newPixels + dstSliceSize * arraySlice + GetMipMappedSize(0, level, newFormat);
+			for (uint32_t i = 0; i < surfaceCount; ++i)
+			{
+				BlockSurface surface = { pSrc, pDst, w, h, blockRowCount };
+				task.mSurfaces.push_back(surface);
+				pSrc += w * h * task.mPixelSize;
+				pDst += ((w + 3) / 4) * ((h + 3) / 4) * ImageFormat::GetBytesPerBlock(newFormat);
+				blockRowCount += (h + 3) / 4;
 			}
-			level++;
 		}
+	}
 
-		mFormat = destFormat;
-
-		Destroy();
-		pData = newPixels;
+	if (pThreadSystem && blockRowCount > 1)
+	{
+		TaskGroup* pGroup = NULL;
+		addTaskGroup(pThreadSystem, &pGroup);
+		TaskDesc desc = {};
+		desc.pTask = compressBlockRowTask;
+		desc.pUser = &task;
+		desc.mStart = 0;
+		desc.mEnd = blockRowCount;
+		desc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &desc);
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+		removeTaskGroup(pThreadSystem, pGroup);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < blockRowCount; ++i)
+			compressBlockRowTask(&task, i);
 	}
 
+	if (mOwnsMemory)
+		conf_free(pData);
+	pData = newPixels;
+	mOwnsMemory = true;
+	mFormat = newFormat;
+
 	return true;
 }
 
@@ -1240,6 +2545,7 @@ bool iLoadDDSFromMemory(Image* pImage,
 	}
 
 	pImage->RedefineDimensions(imageFormat, width, height, depth, mipMapCount, arrayCount, srgb);
+	const uint skippedSize = pImage->SkipMipLevelsAboveMaxLoadSize();
 
 	int size = pImage->GetMipMappedSize();
 
@@ -1256,6 +2562,8 @@ bool iLoadDDSFromMemory(Image* pImage,
 	{
 		for (int face = 0; face < 6; face++)
 		{
+			// Each face holds its own mip chain
+			file.Seek(skippedSize / 6, SEEK_DIR_CUR);
 			for (uint mipMapLevel = 0; mipMapLevel < pImage->GetMipMapCount(); mipMapLevel++)
 			{
 				int            faceSize = pImage->GetMipMappedSize(mipMapLevel, 1) / 6;
@@ -1267,6 +2575,7 @@ bool iLoadDDSFromMemory(Image* pImage,
 	}
 	else
 	{
+		file.Seek(skippedSize, SEEK_DIR_CUR);
 		file.Read(pImage->GetPixels(), size);
 	}
 
@@ -1389,109 +2698,438 @@ bool iLoadKTXFromMemory(Image* pImage, const char* memory, uint32_t memSize, mem
 	
 	file.Read(&header, sizeof(header));
 
-	char *format = (char *)(header.mIdentifier + 1);
-	if (strncmp(format, "KTX 11", 6) != 0)
+	char *format = (char *)(header.mIdentifier + 1);
+	if (strncmp(format, "KTX 11", 6) != 0)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX failed: Not a valid KTX header.");
+		return false;
+	}
+
+	bool endianSwap = (header.mEndianness == 0x01020304);
+
+	uint32_t width = endianSwap ? (uint32_t)byte_swap(header.mWidth) : header.mWidth;
+	uint32_t height = endianSwap ? (uint32_t)byte_swap(header.mHeight) : header.mHeight;
+	uint32_t depth = max(1U, endianSwap ? (uint32_t)byte_swap(header.mDepth) : header.mDepth);
+	uint32_t arrayCount = max(1U, endianSwap ? (uint32_t)byte_swap(header.mArrayElementCount) : header.mArrayElementCount);
+	uint32_t faceCount = endianSwap ? (uint32_t)byte_swap(header.mFaceCount) : header.mFaceCount;
+	uint32_t internalFormat = endianSwap ? (uint32_t)byte_swap(header.mGlInternalFormat) : header.mGlInternalFormat;
+	uint32_t externalFormat = endianSwap ? (uint32_t)byte_swap(header.mGlFormat) : header.mGlFormat;
+	uint32_t type = endianSwap ? (uint32_t)byte_swap(header.mGlType) : header.mGlType;
+	uint32_t mipCount = endianSwap ? (uint32_t)byte_swap(header.mMipmapCount) : header.mMipmapCount;
+	uint32_t keyValueDataLength = endianSwap ? (uint32_t)byte_swap(header.mKeyValueDataLength) : header.mKeyValueDataLength;
+	bool srgb = false;
+	ImageFormat::Enum imageFormat = ImageFormat::NONE;
+
+	if (arrayCount > 1 && faceCount > 1)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX failed: Loading arrays of cubemaps isn't supported.");
+		return false;
+	}
+
+	if (gKTXSrgbFormats.find((KTXInternalFormat)internalFormat) != gKTXSrgbFormats.end())
+	{
+		srgb = true;
+	}
+
+	// Uncompressed
+	if (externalFormat != 0)
+	{
+		for (uint32_t i = 0; i < ImageFormat::COUNT; ++i)
+		{
+			if (externalFormat == gKTXFormatToImageFormat[i].mExternal && type == gKTXFormatToImageFormat[i].mType)
+			{
+				imageFormat = (ImageFormat::Enum)i;
+				break;
+			}
+		}
+	}
+	// Compressed - Support only ASTC for now
+	else
+	{
+#if !defined(TARGET_IOS) && !defined(__ANDROID__)
+		LOGF(LogLevel::eERROR, "Load KTX failed: Compressed formats supported on mobile targets only.");
+		return false;
+#else
+
+		if (!(internalFormat >= KTXInternalFormat_RGBA_ASTC_4x4 && internalFormat <= KTXInternalFormat_SRGB8_ALPHA8_ASTC_12x12))
+		{
+			LOGF(LogLevel::eERROR, "Load KTX failed: Support for loading ASTC compressed textures only.");
+			return false;
+		}
+
+		imageFormat = (ImageFormat::Enum)(ImageFormat::ASTC_4x4 + (internalFormat - (srgb ? KTXInternalFormat_SRGB8_ALPHA8_ASTC_4x4 : KTXInternalFormat_RGBA_ASTC_4x4)));
+#endif
+	}
+
+	depth = (faceCount > 1) ? 0 : depth;
+	if (depth != 0)
+		arrayCount *= faceCount;
+
+	pImage->RedefineDimensions(imageFormat, width, height, depth, mipCount, arrayCount, srgb);
+
+	// Skip ahead to the pixel data
+	const uint32_t offsetToPixelData = sizeof(KTXHeader) + keyValueDataLength;
+	file.Seek(offsetToPixelData, SEEK_DIR_BEGIN);
+	const uint32_t dataLength = file.GetSize() - offsetToPixelData;
+	
+	if (pAllocator)
+	{
+		pImage->SetPixels((uint8_t*)pAllocator(pImage, dataLength, pUserData));
+	}
+	else
+	{
+		pImage->SetPixels((uint8_t*)conf_malloc(sizeof(uint8_t) * dataLength), true);
+	}
+
+	uint8_t* pData = pImage->GetPixels();
+	uint32_t levelOffset = 0;
+	while (!file.IsEof())
+	{
+		uint32_t levelSize = file.ReadUInt() / pImage->GetArrayCount();
+		if (pImage->GetArrayCount() > 1)
+			levelSize /= faceCount;
+		
+		for (uint32_t i = 0; i < pImage->GetArrayCount(); ++i)
+		{
+			for (uint32_t j = 0; j < faceCount; ++j)
+			{
+				file.Read(pData + levelOffset, levelSize);
+				levelOffset += levelSize;
+				
+				// No need to worry about cube padding since block size is a multiple of 4
+			}
+		}
+		
+		// No need to worry about mip padding since block size is a multiple of 4
+	}
+
+	return true;
+}
+
+typedef enum KTX2Supercompression
+{
+	KTX2Supercompression_None = 0,
+	KTX2Supercompression_BasisLZ = 1,
+	KTX2Supercompression_Zstd = 2,
+	KTX2Supercompression_Zlib = 3,
+} KTX2Supercompression;
+
+/// Data format descriptor color models of the Basis Universal payloads
+enum
+{
+	KTX2DfdModel_ETC1S = 163,
+	KTX2DfdModel_UASTC = 166,
+};
+
+typedef struct KTX2FormatDesc
+{
+	uint32_t          mVkFormat;
+	ImageFormat::Enum mFormat;
+	bool              mSrgb;
+} KTX2FormatDesc;
+
+/// VkFormat values of the formats the engine can upload as is
+static const KTX2FormatDesc gKTX2Formats[] = {
+	{ 9, ImageFormat::R8, false },          { 15, ImageFormat::R8, true },          { 16, ImageFormat::RG8, false },
+	{ 22, ImageFormat::RG8, true },         { 23, ImageFormat::RGB8, false },       { 29, ImageFormat::RGB8, true },
+	{ 37, ImageFormat::RGBA8, false },      { 43, ImageFormat::RGBA8, true },       { 44, ImageFormat::BGRA8, false },
+	{ 50, ImageFormat::BGRA8, true },       { 70, ImageFormat::R16, false },        { 77, ImageFormat::RG16, false },
+	{ 84, ImageFormat::RGB16, false },      { 91, ImageFormat::RGBA16, false },     { 76, ImageFormat::R16F, false },
+	{ 83, ImageFormat::RG16F, false },      { 90, ImageFormat::RGB16F, false },     { 97, ImageFormat::RGBA16F, false },
+	{ 100, ImageFormat::R32F, false },      { 103, ImageFormat::RG32F, false },     { 106, ImageFormat::RGB32F, false },
+	{ 109, ImageFormat::RGBA32F, false },   { 122, ImageFormat::RG11B10F, false },  { 123, ImageFormat::RGB9E5, false },
+	{ 131, ImageFormat::DXT1, false },      { 132, ImageFormat::DXT1, true },       { 133, ImageFormat::DXT1, false },
+	{ 134, ImageFormat::DXT1, true },       { 135, ImageFormat::DXT3, false },      { 136, ImageFormat::DXT3, true },
+	{ 137, ImageFormat::DXT5, false },      { 138, ImageFormat::DXT5, true },       { 139, ImageFormat::ATI1N, false },
+	{ 141, ImageFormat::ATI2N, false },     { 143, ImageFormat::GNF_BC6HUF, false }, { 144, ImageFormat::GNF_BC6HSF, false },
+	{ 145, ImageFormat::GNF_BC7, false },   { 146, ImageFormat::GNF_BC7, true },
+};
+
+/// VK_FORMAT_ASTC_4x4_UNORM_BLOCK, the UNORM / SRGB pairs of all ASTC block sizes follow in ImageFormat order
+#define KTX2_VK_FORMAT_ASTC_FIRST 157
+
+static KTX2Codecs               gKTX2Codecs = {};
+static ImageFormatSupportedFunc gImageFormatSupportedFunc = NULL;
+
+void Image::SetKTX2Codecs(const KTX2Codecs* pCodecs)
+{
+	if (pCodecs)
+		gKTX2Codecs = *pCodecs;
+	else
+		memset(&gKTX2Codecs, 0, sizeof(gKTX2Codecs));
+}
+
+void Image::SetSupportedFormatQuery(ImageFormatSupportedFunc pFunc) { gImageFormatSupportedFunc = pFunc; }
+
+/// Parsed KTX2 file, points into the memory the file was loaded from
+typedef struct KTX2File
+{
+	const uint8_t*        pData;
+	uint64_t              mSize;
+	KTX2Header            mHeader;
+	const KTX2LevelIndex* pLevels;
+	/// Number of images per level, layers times faces
+	uint32_t              mImageCount;
+	bool                  mBasis;
+	bool                  mUASTC;
+	bool                  mAlpha;
+} KTX2File;
+
+/// UASTC transcodes to ASTC / BC7 with little loss, ETC1S is closest to ETC1 / BC1.
+/// Falls back to RGBA8 if none of the block formats is supported or nobody registered a format query
+static ImageFormat::Enum selectKTX2TranscodeFormat(const KTX2File& ktx)
+{
+	ImageFormat::Enum candidates[4];
+	uint32_t          count = 0;
+	const ImageFormat::Enum bc1or3 = ktx.mAlpha ? ImageFormat::DXT5 : ImageFormat::DXT1;
+	if (ktx.mUASTC)
+	{
+		candidates[count++] = ImageFormat::ASTC_4x4;
+		candidates[count++] = ImageFormat::GNF_BC7;
+		candidates[count++] = bc1or3;
+		if (!ktx.mAlpha)
+			candidates[count++] = ImageFormat::ETC1;
+	}
+	else
+	{
+		if (!ktx.mAlpha)
+			candidates[count++] = ImageFormat::ETC1;
+		candidates[count++] = bc1or3;
+		candidates[count++] = ImageFormat::ASTC_4x4;
+		candidates[count++] = ImageFormat::GNF_BC7;
+	}
+
+	for (uint32_t i = 0; gImageFormatSupportedFunc && i < count; ++i)
+	{
+		if (gImageFormatSupportedFunc(candidates[i]))
+			return candidates[i];
+	}
+	return ImageFormat::RGBA8;
+}
+
+/// Inflates a zlib / zstd supercompressed level into pDst
+static bool inflateKTX2Level(const KTX2File& ktx, const uint8_t* pSrc, uint64_t srcSize, uint8_t* pDst, uint64_t dstSize)
+{
+	switch (ktx.mHeader.mSupercompressionScheme)
+	{
+		case KTX2Supercompression_Zlib:
+			if (srcSize > INT_MAX || dstSize > INT_MAX)
+				return false;
+			return stbi_zlib_decode_buffer((char*)pDst, (int)dstSize, (const char*)pSrc, (int)srcSize) == (int)dstSize;
+		case KTX2Supercompression_Zstd:
+			if (!gKTX2Codecs.pZstdDecompress)
+			{
+				LOGF(LogLevel::eERROR, "Load KTX2 failed: zstd supercompression needs a decompressor, see Image::SetKTX2Codecs");
+				return false;
+			}
+			return gKTX2Codecs.pZstdDecompress(pSrc, srcSize, pDst, dstSize, gKTX2Codecs.pUserData);
+		default: return false;
+	}
+}
+
+/// Decodes one mip level into the image. Only the level's own range of the file is read and no other level is touched,
+/// so levels can be loaded in any order and the file does not have to be resident as a whole
+// level is the level in the file, the image lacks the levels a max load size skipped
+static bool decodeKTX2Level(const KTX2File& ktx, Image* pImage, const uint32_t level)
+{
+	const KTX2LevelIndex& index = ktx.pLevels[level];
+	const uint32_t        imageLevel = level - pImage->GetSkippedMipCount();
+	if (index.mByteOffset > ktx.mSize || index.mByteLength > ktx.mSize - index.mByteOffset)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: level %u lies outside of the file.", level);
+		return false;
+	}
+
+	const uint8_t* pSrc = ktx.pData + index.mByteOffset;
+	uint64_t       srcSize = index.mByteLength;
+	uint8_t*       pInflated = NULL;
+	const uint32_t scheme = ktx.mHeader.mSupercompressionScheme;
+	if (scheme == KTX2Supercompression_Zlib || scheme == KTX2Supercompression_Zstd)
+	{
+		pInflated = (uint8_t*)conf_malloc(index.mUncompressedByteLength);
+		if (!inflateKTX2Level(ktx, pSrc, srcSize, pInflated, index.mUncompressedByteLength))
+		{
+			LOGF(LogLevel::eERROR, "Load KTX2 failed: level %u could not be inflated.", level);
+			conf_free(pInflated);
+			return false;
+		}
+		pSrc = pInflated;
+		srcSize = index.mUncompressedByteLength;
+	}
+
+	// Cube faces of a level are stored back to back in the image, layers are a whole mip chain apart
+	const uint32_t faceCount = ktx.mHeader.mFaceCount;
+	const uint32_t imageSize = pImage->GetMipMappedSize(imageLevel, 1) / (pImage->IsCube() ? 6 : 1);
+	bool           success = true;
+	if (ktx.mBasis)
+	{
+		if (!gKTX2Codecs.pBasisTranscode)
+		{
+			LOGF(LogLevel::eERROR, "Load KTX2 failed: Basis Universal payload needs a transcoder, see Image::SetKTX2Codecs");
+			success = false;
+		}
+
+		KTX2TranscodeDesc desc = {};
+		desc.pLevelData = pSrc;
+		desc.mLevelDataSize = srcSize;
+		desc.pGlobalData = ktx.mHeader.mSgdByteLength ? ktx.pData + ktx.mHeader.mSgdByteOffset : NULL;
+		desc.mGlobalDataSize = ktx.mHeader.mSgdByteLength;
+		desc.mUASTC = ktx.mUASTC;
+		desc.mDstSize = imageSize;
+		desc.mDstFormat = pImage->getFormat();
+		desc.mLevel = level;
+		desc.mLevelCount = max(1U, ktx.mHeader.mLevelCount);
+		desc.mWidth = pImage->GetWidth(imageLevel);
+		desc.mHeight = pImage->GetHeight(imageLevel);
+		desc.mImageIndex = 0;
+		desc.mImageCount = ktx.mImageCount;
+		for (uint32_t layer = 0; success && layer < pImage->GetArrayCount(); ++layer)
+		{
+			for (uint32_t face = 0; success && face < faceCount; ++face, ++desc.mImageIndex)
+			{
+				desc.pDst = pImage->GetPixels(imageLevel, layer) + face * imageSize;
+				success = gKTX2Codecs.pBasisTranscode(&desc, gKTX2Codecs.pUserData);
+			}
+		}
+	}
+	else if (srcSize != (uint64_t)imageSize * ktx.mImageCount)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: level %u has %llu bytes, expected %llu.", level, (unsigned long long)srcSize,
+			(unsigned long long)imageSize * ktx.mImageCount);
+		success = false;
+	}
+	else
+	{
+		for (uint32_t layer = 0; layer < pImage->GetArrayCount(); ++layer)
+		{
+			for (uint32_t face = 0; face < faceCount; ++face, pSrc += imageSize)
+				memcpy(pImage->GetPixels(imageLevel, layer) + face * imageSize, pSrc, imageSize);
+		}
+	}
+
+	if (pInflated)
+		conf_free(pInflated);
+	return success;
+}
+
+bool iLoadKTX2FromMemory(Image* pImage, const char* memory, uint32_t memSize, memoryAllocationFunc pAllocator, void* pUserData)
+{
+	static const uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	KTX2File ktx = {};
+	ktx.pData = (const uint8_t*)memory;
+	ktx.mSize = memSize;
+	if (memSize < sizeof(KTX2Header) || memcmp(memory, identifier, sizeof(identifier)) != 0)
 	{
-		LOGF(LogLevel::eERROR, "Load KTX failed: Not a valid KTX header.");
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: Not a valid KTX2 header.");
 		return false;
 	}
+	memcpy(&ktx.mHeader, memory, sizeof(KTX2Header));
 
-	bool endianSwap = (header.mEndianness == 0x01020304);
-
-	uint32_t width = endianSwap ? (uint32_t)byte_swap(header.mWidth) : header.mWidth;
-	uint32_t height = endianSwap ? (uint32_t)byte_swap(header.mHeight) : header.mHeight;
-	uint32_t depth = max(1U, endianSwap ? (uint32_t)byte_swap(header.mDepth) : header.mDepth);
-	uint32_t arrayCount = max(1U, endianSwap ? (uint32_t)byte_swap(header.mArrayElementCount) : header.mArrayElementCount);
-	uint32_t faceCount = endianSwap ? (uint32_t)byte_swap(header.mFaceCount) : header.mFaceCount;
-	uint32_t internalFormat = endianSwap ? (uint32_t)byte_swap(header.mGlInternalFormat) : header.mGlInternalFormat;
-	uint32_t externalFormat = endianSwap ? (uint32_t)byte_swap(header.mGlFormat) : header.mGlFormat;
-	uint32_t type = endianSwap ? (uint32_t)byte_swap(header.mGlType) : header.mGlType;
-	uint32_t mipCount = endianSwap ? (uint32_t)byte_swap(header.mMipmapCount) : header.mMipmapCount;
-	uint32_t keyValueDataLength = endianSwap ? (uint32_t)byte_swap(header.mKeyValueDataLength) : header.mKeyValueDataLength;
-	bool srgb = false;
-	ImageFormat::Enum imageFormat = ImageFormat::NONE;
+	const KTX2Header& header = ktx.mHeader;
+	const uint32_t    levelCount = max(1U, header.mLevelCount);
+	if (sizeof(KTX2Header) + (uint64_t)levelCount * sizeof(KTX2LevelIndex) > memSize ||
+		(uint64_t)header.mDfdByteOffset + header.mDfdByteLength > memSize || header.mSgdByteOffset + header.mSgdByteLength > memSize)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: File is truncated.");
+		return false;
+	}
+	ktx.pLevels = (const KTX2LevelIndex*)(ktx.pData + sizeof(KTX2Header));
 
-	if (arrayCount > 1 && faceCount > 1)
+	if (header.mLayerCount > 1 && header.mFaceCount > 1)
 	{
-		LOGF(LogLevel::eERROR, "Load KTX failed: Loading arrays of cubemaps isn't supported.");
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: Loading arrays of cubemaps isn't supported.");
+		return false;
+	}
+	if (header.mFaceCount != 1 && header.mFaceCount != 6)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: Invalid face count %u.", header.mFaceCount);
 		return false;
 	}
 
-	if (gKTXSrgbFormats.find((KTXInternalFormat)internalFormat) != gKTXSrgbFormats.end())
+	// The first descriptor block of the data format descriptor tells the Basis flavour, sRGB and whether there is alpha
+	uint8_t colorModel = 0;
+	bool    srgb = false;
+	if (header.mDfdByteLength >= 4 + 24 + 16)
 	{
-		srgb = true;
+		const uint8_t* pBlock = ktx.pData + header.mDfdByteOffset + 4;
+		uint16_t       blockSize;
+		memcpy(&blockSize, pBlock + 6, sizeof(blockSize));
+		const uint32_t sampleCount = blockSize >= 24 ? (blockSize - 24) / 16 : 0;
+		colorModel = pBlock[8];
+		srgb = pBlock[10] == 2;
+		if (colorModel == KTX2DfdModel_ETC1S)
+			ktx.mAlpha = sampleCount > 1;
+		// UASTC has one sample, its channel id is RGB (0), RGBA (3), RRR (4), RRRG (5) or RG (6)
+		else if (colorModel == KTX2DfdModel_UASTC && sampleCount)
+			ktx.mAlpha = (pBlock[24 + 3] & 0xF) == 3 || (pBlock[24 + 3] & 0xF) == 5;
 	}
 
-	// Uncompressed
-	if (externalFormat != 0)
+	ImageFormat::Enum imageFormat = ImageFormat::NONE;
+	if (header.mVkFormat == 0)
 	{
-		for (uint32_t i = 0; i < ImageFormat::COUNT; ++i)
+		ktx.mBasis = header.mSupercompressionScheme == KTX2Supercompression_BasisLZ || colorModel == KTX2DfdModel_UASTC;
+		ktx.mUASTC = colorModel == KTX2DfdModel_UASTC;
+		if (!ktx.mBasis)
 		{
-			if (externalFormat == gKTXFormatToImageFormat[i].mExternal && type == gKTXFormatToImageFormat[i].mType)
-			{
-				imageFormat = (ImageFormat::Enum)i;
-				break;
-			}
+			LOGF(LogLevel::eERROR, "Load KTX2 failed: VK_FORMAT_UNDEFINED without a Basis Universal payload.");
+			return false;
 		}
+		imageFormat = selectKTX2TranscodeFormat(ktx);
+	}
+	else if (header.mVkFormat >= KTX2_VK_FORMAT_ASTC_FIRST && header.mVkFormat < KTX2_VK_FORMAT_ASTC_FIRST + 2 * 14)
+	{
+		const uint32_t astc = header.mVkFormat - KTX2_VK_FORMAT_ASTC_FIRST;
+		imageFormat = (ImageFormat::Enum)(ImageFormat::ASTC_4x4 + astc / 2);
+		srgb = (astc & 1) != 0;
 	}
-	// Compressed - Support only ASTC for now
 	else
 	{
-#if !defined(TARGET_IOS) && !defined(__ANDROID__)
-		LOGF(LogLevel::eERROR, "Load KTX failed: Compressed formats supported on mobile targets only.");
-		return false;
-#else
-
-		if (!(internalFormat >= KTXInternalFormat_RGBA_ASTC_4x4 && internalFormat <= KTXInternalFormat_SRGB8_ALPHA8_ASTC_12x12))
+		for (uint32_t i = 0; i < sizeof(gKTX2Formats) / sizeof(gKTX2Formats[0]); ++i)
 		{
-			LOGF(LogLevel::eERROR, "Load KTX failed: Support for loading ASTC compressed textures only.");
-			return false;
+			if (gKTX2Formats[i].mVkFormat == header.mVkFormat)
+			{
+				imageFormat = gKTX2Formats[i].mFormat;
+				srgb = gKTX2Formats[i].mSrgb;
+				break;
+			}
 		}
-
-		imageFormat = (ImageFormat::Enum)(ImageFormat::ASTC_4x4 + (internalFormat - (srgb ? KTXInternalFormat_SRGB8_ALPHA8_ASTC_4x4 : KTXInternalFormat_RGBA_ASTC_4x4)));
-#endif
 	}
 
-	depth = (faceCount > 1) ? 0 : depth;
-	if (depth != 0)
-		arrayCount *= faceCount;
+	if (imageFormat == ImageFormat::NONE)
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: VkFormat %u is not supported.", header.mVkFormat);
+		return false;
+	}
+	if (header.mSupercompressionScheme > KTX2Supercompression_Zlib ||
+		(header.mSupercompressionScheme == KTX2Supercompression_BasisLZ && ktx.mUASTC))
+	{
+		LOGF(LogLevel::eERROR, "Load KTX2 failed: Supercompression scheme %u is not supported.", header.mSupercompressionScheme);
+		return false;
+	}
 
-	pImage->RedefineDimensions(imageFormat, width, height, depth, mipCount, arrayCount, srgb);
+	const uint32_t arrayCount = max(1U, header.mLayerCount);
+	const uint32_t depth = header.mFaceCount == 6 ? 0 : max(1U, header.mPixelDepth);
+	ktx.mImageCount = arrayCount * header.mFaceCount;
+	pImage->RedefineDimensions(
+		imageFormat, header.mPixelWidth, max(1U, header.mPixelHeight), depth, levelCount, arrayCount, srgb);
+	pImage->SkipMipLevelsAboveMaxLoadSize();
 
-	// Skip ahead to the pixel data
-	const uint32_t offsetToPixelData = sizeof(KTXHeader) + keyValueDataLength;
-	file.Seek(offsetToPixelData, SEEK_DIR_BEGIN);
-	const uint32_t dataLength = file.GetSize() - offsetToPixelData;
-	
+	const uint32_t size = pImage->GetMipMappedSize() * arrayCount;
 	if (pAllocator)
 	{
-		pImage->SetPixels((uint8_t*)pAllocator(pImage, dataLength, pUserData));
+		pImage->SetPixels((uint8_t*)pAllocator(pImage, size, pUserData));
 	}
 	else
 	{
-		pImage->SetPixels((uint8_t*)conf_malloc(sizeof(uint8_t) * dataLength), true);
+		pImage->SetPixels((uint8_t*)conf_malloc(sizeof(uint8_t) * size), true);
 	}
 
-	uint8_t* pData = pImage->GetPixels();
-	uint32_t levelOffset = 0;
-	while (!file.IsEof())
+	// Smallest level first, the way the levels are laid out in the file
+	for (uint32_t level = levelCount; level-- > pImage->GetSkippedMipCount();)
 	{
-		uint32_t levelSize = file.ReadUInt() / pImage->GetArrayCount();
-		if (pImage->GetArrayCount() > 1)
-			levelSize /= faceCount;
-		
-		for (uint32_t i = 0; i < pImage->GetArrayCount(); ++i)
-		{
-			for (uint32_t j = 0; j < faceCount; ++j)
-			{
-				file.Read(pData + levelOffset, levelSize);
-				levelOffset += levelSize;
-				
-				// No need to worry about cube padding since block size is a multiple of 4
-			}
-		}
-		
-		// No need to worry about mip padding since block size is a multiple of 4
+		if (!decodeKTX2Level(ktx, pImage, level))
+			return false;
 	}
 
 	return true;
@@ -1702,6 +3340,7 @@ struct StaticImageLoader
 		gImageLoaders.push_back({ ".dds", iLoadDDSFromMemory });
 		gImageLoaders.push_back({ ".pvr", iLoadPVRFromMemory });
 		gImageLoaders.push_back({ ".ktx", iLoadKTXFromMemory });
+		gImageLoaders.push_back({ ".ktx2", iLoadKTX2FromMemory });
 #if defined(ORBIS)
 		gImageLoaders.push_back({ ".gnf", iLoadGNFFromMemory });
 #endif
@@ -1789,319 +3428,918 @@ void Image::loadFromMemoryXY(
 	}
 }
 
-bool Image::loadFromMemory(
-	void const* mem, uint32_t size, char const* extension, memoryAllocationFunc pAllocator, void* pUserData)
+bool Image::loadFromMemory(
+	void const* mem, uint32_t size, char const* extension, memoryAllocationFunc pAllocator, void* pUserData)
+{
+	// try loading the format
+	bool loaded = false;
+	for (uint32_t i = 0; i < (uint32_t)gImageLoaders.size(); ++i)
+	{
+		ImageLoaderDefinition const& def = gImageLoaders[i];
+		if (stricmp(extension, def.mExtension.c_str()) == 0)
+		{
+			loaded = def.pLoader(this, (char const*)mem, size, pAllocator, pUserData);
+			break;
+		}
+	}
+	return loaded;
+}
+
+bool Image::loadImage(const char* origFileName, memoryAllocationFunc pAllocator, void* pUserData, FSRoot root)
+{
+	// clear current image
+	Clear();
+
+	eastl::string extension = FileSystem::GetExtension(origFileName);
+	uint32_t loaderIndex = -1;
+
+	if (extension.size())
+	{
+		for (int i = 0; i < (int)gImageLoaders.size(); i++)
+		{
+			if (stricmp(extension.c_str(), gImageLoaders[i].mExtension.c_str()) == 0)
+			{
+				loaderIndex = i;
+				break;
+			}
+		}
+
+		if (loaderIndex == -1)
+			extension = "";
+	}
+
+	char fileName[MAX_PATH] = {};
+	strcpy(fileName, origFileName);
+	if (!extension.size())
+	{
+#if defined(__ANDROID__)
+		extension = ".ktx";
+#elif defined(TARGET_IOS)
+		extension = ".ktx";
+#elif defined(__linux__)
+		extension = ".dds";
+#elif defined(__APPLE__)
+		extension = ".dds";
+#else
+		extension = ".dds";
+#endif
+
+		strcpy(fileName + strlen(origFileName), extension.c_str());
+	}
+
+	// map the file, the loaders parse straight from the mapping
+	MappedFile file;
+	if (!file.Open(fileName, root))
+	{
+		LOGF(LogLevel::eERROR, "\"%s\": Image file not found or empty.", fileName);
+		return false;
+	}
+
+	if (file.GetSize() > UINT32_MAX)
+	{
+		LOGF(LogLevel::eERROR, "\"%s\": Image file is larger than 4GB.", fileName);
+		return false;
+	}
+
+	const char* data = (const char*)file.GetData();
+	uint32_t    length = (uint32_t)file.GetSize();
+
+	// try loading the format
+	bool loaded = false;
+	bool support = false;
+	for (int i = 0; i < (int)gImageLoaders.size(); i++)
+	{
+		if (stricmp(extension.c_str(), gImageLoaders[i].mExtension.c_str()) == 0)
+		{
+			support = true;
+			loaded = gImageLoaders[i].pLoader(this, data, length, pAllocator, pUserData);
+			if (loaded)
+			{
+				break;
+			}
+		}
+	}
+	if (!support)
+	{
+		LOGF(LogLevel::eERROR, "Can't load this file format for image  :  %s", fileName);
+	}
+	else
+	{
+		mLoadFileName = fileName;
+	}
+	return loaded;
+}
+
+bool Image::Convert(const ImageFormat::Enum newFormat, ThreadSystem* pThreadSystem)
+{
+	const ConvertPixelsFunc pConvert = getConvertPixelsFunc(mFormat, newFormat);
+	if (!pConvert)
+	{
+		LOGF(LogLevel::eERROR, 
+			"Image: %s fail to convert from  %s  to  %s", mLoadFileName.c_str(), ImageFormat::GetFormatString(mFormat),
+			ImageFormat::GetFormatString(newFormat));
+		return false;
+	}
+	if (mFormat == newFormat)
+		return true;
+
+	ubyte* newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * GetMipMappedSize(0, mMipMapCount, newFormat) * mArrayCount);
+
+	// All mip levels and slices are stored back to back in both formats, so the image is converted as one pixel array
+	ConvertTask task;
+	task.pConvert = pConvert;
+	task.pSrc = pData;
+	task.pDst = newPixels;
+	task.mSrcPixelSize = ImageFormat::GetBytesPerPixel(mFormat);
+	task.mDstPixelSize = ImageFormat::GetBytesPerPixel(newFormat);
+	task.mPixelCount = GetNumberOfPixels(0, mMipMapCount) * mArrayCount;
+
+	const uint32_t taskCount = (task.mPixelCount + IMAGE_CONVERT_TASK_PIXEL_COUNT - 1) / IMAGE_CONVERT_TASK_PIXEL_COUNT;
+	if (pThreadSystem && taskCount > 1)
+	{
+		TaskGroup* pGroup = NULL;
+		addTaskGroup(pThreadSystem, &pGroup);
+		TaskDesc desc = {};
+		desc.pTask = convertPixelsTask;
+		desc.pUser = &task;
+		desc.mStart = 0;
+		desc.mEnd = taskCount;
+		desc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &desc);
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+		removeTaskGroup(pThreadSystem, pGroup);
+	}
+	else
+	{
+		pConvert(task.pSrc, task.pDst, task.mPixelCount);
+	}
+
+	if (mOwnsMemory)
+		conf_free(pData);
+	pData = newPixels;
+	mOwnsMemory = true;
+	mFormat = newFormat;
+
+	return true;
+}
+
+//------------------------------------------------------------------------------------
+// Mip generation
+//------------------------------------------------------------------------------------
+/// dst[i] += src[i] * weight, count has to be a multiple of 4
+static void mipAccumulate(float* pDst, const float* pSrc, float weight, uint32_t count)
+{
+	uint32_t i = 0;
+#if defined(IMAGE_SIMD_AVX)
+	const __m256 w8 = _mm256_set1_ps(weight);
+	for (; i + 8 <= count; i += 8)
+	{
+#if defined(__FMA__)
+		_mm256_storeu_ps(pDst + i, _mm256_fmadd_ps(_mm256_loadu_ps(pSrc + i), w8, _mm256_loadu_ps(pDst + i)));
+#else
+		_mm256_storeu_ps(pDst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(pSrc + i), w8), _mm256_loadu_ps(pDst + i)));
+#endif
+	}
+#endif
+	const SimdFloat4 w4 = simdSplat(weight);
+	for (; i < count; i += 4)
+		simdStore(pDst + i, simdMadd(simdLoad(pSrc + i), w4, simdLoad(pDst + i)));
+}
+
+typedef enum MipDataType
+{
+	MIP_DATA_UNORM8 = 0,
+	MIP_DATA_UNORM16,
+	MIP_DATA_SNORM8,
+	MIP_DATA_SNORM16,
+	MIP_DATA_HALF,
+	MIP_DATA_FLOAT,
+	MIP_DATA_SINT16,
+	MIP_DATA_SINT32,
+	MIP_DATA_UINT16,
+	MIP_DATA_UINT32,
+	MIP_DATA_UNSUPPORTED,
+} MipDataType;
+
+static MipDataType getMipDataType(const ImageFormat::Enum format)
+{
+	if (format == ImageFormat::NONE)
+		return MIP_DATA_UNSUPPORTED;
+	if (format <= ImageFormat::RGBA8 || format == ImageFormat::BGRA8)
+		return MIP_DATA_UNORM8;
+	if (format <= ImageFormat::RGBA16)
+		return MIP_DATA_UNORM16;
+	if (format <= ImageFormat::RGBA8S)
+		return MIP_DATA_SNORM8;
+	if (format <= ImageFormat::RGBA16S)
+		return MIP_DATA_SNORM16;
+	if (format <= ImageFormat::RGBA16F)
+		return MIP_DATA_HALF;
+	if (format <= ImageFormat::RGBA32F)
+		return MIP_DATA_FLOAT;
+	if (format <= ImageFormat::RGBA16I)
+		return MIP_DATA_SINT16;
+	if (format <= ImageFormat::RGBA32I)
+		return MIP_DATA_SINT32;
+	if (format <= ImageFormat::RGBA16UI)
+		return MIP_DATA_UINT16;
+	if (format <= ImageFormat::RGBA32UI)
+		return MIP_DATA_UINT32;
+	return MIP_DATA_UNSUPPORTED;
+}
+
+static float srgbToLinear(float s) { return s <= 0.04045f ? s / 12.92f : powf((s + 0.055f) / 1.055f, 2.4f); }
+
+struct SrgbTables
+{
+	SrgbTables()
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			mUnorm[i] = (float)i / 255.0f;
+			mToLinear[i] = srgbToLinear((float)i / 255.0f);
+			mThresholds[i] = srgbToLinear(((float)i + 0.5f) / 255.0f);
+		}
+	}
+
+	float mUnorm[256];
+	float mToLinear[256];
+	/// Linear value half way between the sRGB codes i and i + 1
+	float mThresholds[256];
+};
+
+static const SrgbTables& getSrgbTables()
+{
+	static SrgbTables tables;
+	return tables;
+}
+
+/// Exact round to nearest in sRGB space through a binary search over the code thresholds
+static uint8_t linearToSrgb8(const SrgbTables& tables, float v)
+{
+	uint32_t code = 0;
+	// Select instead of branch, the comparisons are unpredictable on noisy images
+	for (uint32_t step = 128; step > 0; step >>= 1)
+		code += step & (0u - (uint32_t)(v >= tables.mThresholds[code + step - 1]));
+	return (uint8_t)code;
+}
+
+struct HalfTables
+{
+	HalfTables()
+	{
+		for (uint32_t i = 0; i < 65536; ++i)
+		{
+			half h;
+			h.sh = (unsigned short)i;
+			mToFloat[i] = h;
+		}
+	}
+
+	float mToFloat[65536];
+};
+
+static const HalfTables& getHalfTables()
+{
+	static HalfTables tables;
+	return tables;
+}
+
+/// Round to nearest even, without the branches of the half constructor on normal values
+static uint16_t floatToHalf(float v)
+{
+	const uint32_t infinity = 255u << 23;
+	const uint32_t halfMax = (127u + 16u) << 23;
+	const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	const uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint32_t result;
+	if (bits >= halfMax)
+	{
+		// Overflow to infinity, NaN stays NaN
+		result = bits > infinity ? 0x7E00 : 0x7C00;
+	}
+	else if (bits < (113u << 23))
+	{
+		// The float add shifts the mantissa into place and rounds it
+		float denorm, magic;
+		memcpy(&denorm, &bits, sizeof(denorm));
+		memcpy(&magic, &denormMagic, sizeof(magic));
+		denorm += magic;
+		memcpy(&result, &denorm, sizeof(result));
+		result -= denormMagic;
+	}
+	else
+	{
+		const uint32_t mantissaOdd = (bits >> 13) & 1;
+		bits += ((uint32_t)(15 - 127) << 23) + 0xFFF + mantissaOdd;
+		result = bits >> 13;
+	}
+	return (uint16_t)(result | (sign >> 16));
+}
+
+typedef struct MipAxisFilter
+{
+	uint32_t  mTapCount;
+	uint32_t* pIndices;
+	float*    pWeights;
+} MipAxisFilter;
+
+static float mipSinc(float x)
+{
+	if (fabsf(x) < 1e-5f)
+		return 1.0f;
+	x *= PI;
+	return sinf(x) / x;
+}
+
+static float besselI0(float x)
 {
-	// try loading the format
-	bool loaded = false;
-	for (uint32_t i = 0; i < (uint32_t)gImageLoaders.size(); ++i)
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (uint32_t k = 1; k < 32; ++k)
 	{
-		ImageLoaderDefinition const& def = gImageLoaders[i];
-		if (stricmp(extension, def.mExtension.c_str()) == 0)
-		{
-			loaded = def.pLoader(this, (char const*)mem, size, pAllocator, pUserData);
+		const float f = x / (2.0f * (float)k);
+		term *= f * f;
+		sum += term;
+		if (term < sum * 1e-8f)
 			break;
-		}
 	}
-	return loaded;
+	return sum;
 }
 
-bool Image::loadImage(const char* origFileName, memoryAllocationFunc pAllocator, void* pUserData, FSRoot root)
-{
-	// clear current image
-	Clear();
+/// Filter radius in destination texels
+static float getMipFilterRadius(MipFilter filter) { return filter == MIP_FILTER_BOX ? 0.5f : 3.0f; }
 
-	eastl::string extension = FileSystem::GetExtension(origFileName);
-	uint32_t loaderIndex = -1;
+static float evalMipFilter(MipFilter filter, float x)
+{
+	x = fabsf(x);
+	const float radius = getMipFilterRadius(filter);
+	if (x >= radius)
+		return 0.0f;
 
-	if (extension.size())
+	switch (filter)
 	{
-		for (int i = 0; i < (int)gImageLoaders.size(); i++)
+		case MIP_FILTER_KAISER:
 		{
-			if (stricmp(extension.c_str(), gImageLoaders[i].mExtension.c_str()) == 0)
-			{
-				loaderIndex = i;
-				break;
-			}
+			const float alpha = 4.0f;
+			const float t = x / radius;
+			return mipSinc(x) * besselI0(alpha * sqrtf(1.0f - t * t)) / besselI0(alpha);
 		}
-
-		if (loaderIndex == -1)
-			extension = "";
+		case MIP_FILTER_LANCZOS: return mipSinc(x) * mipSinc(x / radius);
+		default: return 1.0f;
 	}
+}
 
-	char fileName[MAX_PATH] = {};
-	strcpy(fileName, origFileName);
-	if (!extension.size())
+static void getMipFilterTaps(MipFilter filter, float center, float radius, int32_t* pFirst, int32_t* pLast)
+{
+	if (filter == MIP_FILTER_BOX)
 	{
-#if defined(__ANDROID__)
-		extension = ".ktx";
-#elif defined(TARGET_IOS)
-		extension = ".ktx";
-#elif defined(__linux__)
-		extension = ".dds";
-#elif defined(__APPLE__)
-		extension = ".dds";
-#else
-		extension = ".dds";
-#endif
-
-		strcpy(fileName + strlen(origFileName), extension.c_str());
+		// Every texel overlapping the footprint
+		*pFirst = (int32_t)floorf(center - radius);
+		*pLast = (int32_t)ceilf(center + radius) - 1;
 	}
-
-	// open file
-	File file = {};
-	file.Open(fileName, FM_ReadBinary, root);
-	if (!file.IsOpen())
+	else
 	{
-		LOGF(LogLevel::eERROR, "\"%s\": Image file not found.", fileName);
-		return false;
+		// Every texel whose center is inside the kernel
+		*pFirst = (int32_t)floorf(center - radius - 0.5f) + 1;
+		*pLast = (int32_t)ceilf(center + radius - 0.5f) - 1;
 	}
+}
 
-	// load file into memory
-	uint32_t length = file.GetSize();
-	if (length == 0)
+/// Precomputes the normalized weights of one axis. Taps outside of the image are clamped to the edge
+static void addMipAxisFilter(MipFilter filter, uint32_t srcSize, uint32_t dstSize, MipAxisFilter* pFilter)
+{
+	const bool  identity = srcSize == dstSize;
+	const float scale = (float)srcSize / (float)dstSize;
+	const float radius = getMipFilterRadius(filter) * scale;
+
+	uint32_t tapCount = 1;
+	if (!identity)
 	{
-		//char output[256];
-		//sprintf(output, "\"%s\": Image file is empty.", fileName);
-		LOGF(LogLevel::eERROR, "\"%s\": Image is an empty file.", fileName);
-		file.Close();
-		return false;
+		for (uint32_t i = 0; i < dstSize; ++i)
+		{
+			int32_t first, last;
+			getMipFilterTaps(filter, ((float)i + 0.5f) * scale, radius, &first, &last);
+			tapCount = max(tapCount, (uint32_t)(last - first + 1));
+		}
 	}
 
-	// read and close file.
-	char* data = (char*)conf_malloc(length * sizeof(char));
-	file.Read(data, (unsigned)length);
-	file.Close();
+	pFilter->mTapCount = tapCount;
+	pFilter->pIndices = (uint32_t*)conf_malloc(sizeof(uint32_t) * tapCount * dstSize);
+	pFilter->pWeights = (float*)conf_malloc(sizeof(float) * tapCount * dstSize);
 
-	// try loading the format
-	bool loaded = false;
-	bool support = false;
-	for (int i = 0; i < (int)gImageLoaders.size(); i++)
+	for (uint32_t i = 0; i < dstSize; ++i)
 	{
-		if (stricmp(extension.c_str(), gImageLoaders[i].mExtension.c_str()) == 0)
+		uint32_t* pIndices = pFilter->pIndices + i * tapCount;
+		float*    pWeights = pFilter->pWeights + i * tapCount;
+		if (identity)
 		{
-			support = true;
-			loaded = gImageLoaders[i].pLoader(this, data, length, pAllocator, pUserData);
-			if (loaded)
+			pIndices[0] = i;
+			pWeights[0] = 1.0f;
+			continue;
+		}
+
+		const float center = ((float)i + 0.5f) * scale;
+		int32_t     first, last;
+		getMipFilterTaps(filter, center, radius, &first, &last);
+
+		float sum = 0.0f;
+		for (uint32_t k = 0; k < tapCount; ++k)
+		{
+			const int32_t j = min(first + (int32_t)k, last);
+			float         weight = 0.0f;
+			if (first + (int32_t)k <= last)
 			{
-				break;
+				if (filter == MIP_FILTER_BOX)
+					weight = max(0.0f, min((float)j + 1.0f, center + radius) - max((float)j, center - radius));
+				else
+					weight = evalMipFilter(filter, ((float)j + 0.5f - center) / scale);
 			}
+			pIndices[k] = (uint32_t)clamp(j, 0, (int32_t)srcSize - 1);
+			pWeights[k] = weight;
+			sum += weight;
 		}
-	}
-	if (!support)
-	{
-		LOGF(LogLevel::eERROR, "Can't load this file format for image  :  %s", fileName);
-	}
-	else
-	{
-		mLoadFileName = fileName;
-	}
-	// cleanup the compressed data
-	conf_free(data);
 
-	return loaded;
+		for (uint32_t k = 0; k < tapCount; ++k)
+			pWeights[k] /= sum;
+	}
 }
 
-bool Image::Convert(const ImageFormat::Enum newFormat)
+static void removeMipAxisFilter(MipAxisFilter* pFilter)
 {
-	ubyte* newPixels;
-	uint   nPixels = GetNumberOfPixels(0, mMipMapCount) * mArrayCount;
+	conf_free(pFilter->pIndices);
+	conf_free(pFilter->pWeights);
+}
 
-	if (mFormat == ImageFormat::RGBE8 && (newFormat == ImageFormat::RGB32F || newFormat == ImageFormat::RGBA32F))
+typedef struct MipGenerationTask
+{
+	Image*      pImage;
+	MipFilter   mFilter;
+	MipDataType mDataType;
+	uint32_t    mChannelCount;
+	uint32_t    mPixelSize;
+	uint32_t    mFaceCount;
+	bool        mSrgb;
+} MipGenerationTask;
+
+/// Decodes a row of pixels to linear RGBA floats
+static void decodeMipRow(const MipGenerationTask* pTask, const uint8_t* pSrc, uint32_t width, float* pDst)
+{
+	const uint32_t c = pTask->mChannelCount;
+	if (c < 4)
+		memset(pDst, 0, sizeof(float) * 4 * width);
+	switch (pTask->mDataType)
 	{
-		newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * GetMipMappedSize(0, mMipMapCount, newFormat) * mArrayCount);
-		float* dest = (float*)newPixels;
-
-		bool   writeAlpha = (newFormat == ImageFormat::RGBA32F);
-		ubyte* src = pData;
-		do
+		case MIP_DATA_UNORM8:
 		{
-			*((vec3*)dest) = rgbeToRGB(src);
-			if (writeAlpha)
+			// Alpha always stays linear
+			const SrgbTables& tables = getSrgbTables();
+			const float*      pColorTable = pTask->mSrgb ? tables.mToLinear : tables.mUnorm;
+			const float*      pTables[4] = { pColorTable, pColorTable, pColorTable, tables.mUnorm };
+			for (uint32_t x = 0; x < width; ++x)
 			{
-				dest[3] = 1.0f;
-				dest += 4;
+				for (uint32_t i = 0; i < c; ++i)
+					pDst[x * 4 + i] = pTables[i][pSrc[x * c + i]];
 			}
-			else
+			break;
+		}
+		case MIP_DATA_UNORM16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = (float)((const uint16_t*)pSrc)[i] * (1.0f / 65535.0f);
+			break;
+		case MIP_DATA_SNORM8:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = max(-1.0f, (float)((const int8_t*)pSrc)[i] * (1.0f / 127.0f));
+			break;
+		case MIP_DATA_SNORM16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = max(-1.0f, (float)((const int16_t*)pSrc)[i] * (1.0f / 32767.0f));
+			break;
+		case MIP_DATA_HALF:
+#if defined(IMAGE_SIMD_F16C)
+			if (c == 4)
 			{
-				dest += 3;
+				for (uint32_t x = 0; x < width; ++x)
+					_mm_storeu_ps(pDst + x * 4, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(pSrc + x * 8))));
+				break;
 			}
-			src += 4;
-		} while (--nPixels);
+#endif
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = ((const half*)pSrc)[i];
+			break;
+		case MIP_DATA_FLOAT:
+			if (c == 4)
+				memcpy(pDst, pSrc, sizeof(float) * 4 * width);
+			else
+				for (uint32_t i = 0; i < width * c; ++i)
+					pDst[(i / c) * 4 + i % c] = ((const float*)pSrc)[i];
+			break;
+		case MIP_DATA_SINT16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = (float)((const int16_t*)pSrc)[i];
+			break;
+		case MIP_DATA_SINT32:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = (float)((const int32_t*)pSrc)[i];
+			break;
+		case MIP_DATA_UINT16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = (float)((const uint16_t*)pSrc)[i];
+			break;
+		case MIP_DATA_UINT32:
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[(i / c) * 4 + i % c] = (float)((const uint32_t*)pSrc)[i];
+			break;
+		default: break;
 	}
-	else
-	{
-		if (!ImageFormat::IsPlainFormat(mFormat) || !(ImageFormat::IsPlainFormat(newFormat) || newFormat == ImageFormat::RGB10A2 ||
-													  newFormat == ImageFormat::RGBE8 || newFormat == ImageFormat::RGB9E5))
-		{
-			LOGF(LogLevel::eERROR, 
-				"Image: %s fail to convert from  %s  to  %s", mLoadFileName.c_str(), ImageFormat::GetFormatString(mFormat),
-				ImageFormat::GetFormatString(newFormat));
-			return false;
-		}
-		if (mFormat == newFormat)
-			return true;
-
-		ubyte* src = pData;
-		ubyte* dest = newPixels = (ubyte*)conf_malloc(sizeof(ubyte) * GetMipMappedSize(0, mMipMapCount, newFormat) * mArrayCount);
+}
 
-		if (mFormat == ImageFormat::RGB8 && newFormat == ImageFormat::RGBA8)
+/// Encodes a row of linear RGBA floats to the image format
+static void encodeMipRow(const MipGenerationTask* pTask, const float* pSrc, uint32_t width, uint8_t* pDst)
+{
+	const uint32_t c = pTask->mChannelCount;
+	switch (pTask->mDataType)
+	{
+		case MIP_DATA_UNORM8:
 		{
-			// Fast path for RGB->RGBA8
-			do
+			const SrgbTables& tables = getSrgbTables();
+			if (pTask->mSrgb)
 			{
-				dest[0] = src[0];
-				dest[1] = src[1];
-				dest[2] = src[2];
-				dest[3] = 255;
-				dest += 4;
-				src += 3;
-			} while (--nPixels);
-		}
-		else if (mFormat == ImageFormat::RGBA8 && newFormat == ImageFormat::BGRA8)
-		{
-			// Fast path for RGBA8->BGRA8 (just swizzle)
-			do
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					for (uint32_t i = 0; i < c; ++i)
+					{
+						const float v = pSrc[x * 4 + i];
+						pDst[x * c + i] = i < 3 ? linearToSrgb8(tables, v) : (uint8_t)(saturate(v) * 255.0f + 0.5f);
+					}
+				}
+				break;
+			}
+#if defined(IMAGE_SIMD_SSE)
+			if (c == 4)
 			{
-				dest[0] = src[2];
-				dest[1] = src[1];
-				dest[2] = src[0];
-				dest[3] = src[3];
-				dest += 4;
-				src += 4;
-			} while (--nPixels);
+				const __m128 scale = _mm_set1_ps(255.0f);
+				const __m128 zero = _mm_setzero_ps();
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const __m128  v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(pSrc + x * 4), scale), zero), scale);
+					const __m128i i32 = _mm_cvtps_epi32(v);
+					const __m128i i16 = _mm_packs_epi32(i32, i32);
+					const int     packed = _mm_cvtsi128_si32(_mm_packus_epi16(i16, i16));
+					memcpy(pDst + x * 4, &packed, sizeof(packed));
+				}
+				break;
+			}
+#endif
+			for (uint32_t i = 0; i < width * c; ++i)
+				pDst[i] = (uint8_t)(saturate(pSrc[(i / c) * 4 + i % c]) * 255.0f + 0.5f);
+			break;
 		}
-		else
-		{
-			int srcSize = ImageFormat::GetBytesPerPixel(mFormat);
-			int nSrcChannels = ImageFormat::GetChannelCount(mFormat);
+		case MIP_DATA_UNORM16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((uint16_t*)pDst)[i] = (uint16_t)(saturate(pSrc[(i / c) * 4 + i % c]) * 65535.0f + 0.5f);
+			break;
+		case MIP_DATA_SNORM8:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((int8_t*)pDst)[i] = (int8_t)roundf(clamp(pSrc[(i / c) * 4 + i % c], -1.0f, 1.0f) * 127.0f);
+			break;
+		case MIP_DATA_SNORM16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((int16_t*)pDst)[i] = (int16_t)roundf(clamp(pSrc[(i / c) * 4 + i % c], -1.0f, 1.0f) * 32767.0f);
+			break;
+		case MIP_DATA_HALF:
+#if defined(IMAGE_SIMD_F16C)
+			if (c == 4)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+					_mm_storel_epi64((__m128i*)(pDst + x * 8), _mm_cvtps_ph(_mm_loadu_ps(pSrc + x * 4), _MM_FROUND_TO_NEAREST_INT));
+				break;
+			}
+#endif
+			for (uint32_t i = 0; i < width * c; ++i)
+				((half*)pDst)[i] = half(pSrc[(i / c) * 4 + i % c]);
+			break;
+		case MIP_DATA_FLOAT:
+			if (c == 4)
+				memcpy(pDst, pSrc, sizeof(float) * 4 * width);
+			else
+				for (uint32_t i = 0; i < width * c; ++i)
+					((float*)pDst)[i] = pSrc[(i / c) * 4 + i % c];
+			break;
+		case MIP_DATA_SINT16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((int16_t*)pDst)[i] = (int16_t)roundf(clamp(pSrc[(i / c) * 4 + i % c], -32768.0f, 32767.0f));
+			break;
+		case MIP_DATA_SINT32:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((int32_t*)pDst)[i] = (int32_t)clamp((double)roundf(pSrc[(i / c) * 4 + i % c]), (double)INT_MIN, (double)INT_MAX);
+			break;
+		case MIP_DATA_UINT16:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((uint16_t*)pDst)[i] = (uint16_t)roundf(clamp(pSrc[(i / c) * 4 + i % c], 0.0f, 65535.0f));
+			break;
+		case MIP_DATA_UINT32:
+			for (uint32_t i = 0; i < width * c; ++i)
+				((uint32_t*)pDst)[i] = (uint32_t)clamp((double)roundf(pSrc[(i / c) * 4 + i % c]), 0.0, (double)UINT_MAX);
+			break;
+		default: break;
+	}
+}
 
-			int destSize = ImageFormat::GetBytesPerPixel(newFormat);
-			int nDestChannels = ImageFormat::GetChannelCount(newFormat);
+template <typename Sum>
+static inline Sum        boxAdd(Sum a, Sum b) { return a + b; }
+static inline SimdFloat4 boxAdd(SimdFloat4 a, SimdFloat4 b) { return simdAdd(a, b); }
 
-			do
+/// Averages the 2x2x2 source block of every destination texel, an axis of size 1 repeats its only sample.
+/// Channels are summed in Sum after decode and turned back into T by encode
+template <typename T, typename Sum, typename Decode, typename Encode>
+static void buildBoxMipLevel(T* dst, const T* src, const uint3& srcDim, const uint32_t c, Decode decode, Encode encode)
+{
+	const uint32_t w = srcDim.x;
+	const uint32_t h = srcDim.y;
+	const uint32_t d = srcDim.z;
+	const uint32_t xOff = (w < 2) ? 0 : c;
+	const uint32_t yOff = (h < 2) ? 0 : c * w;
+	const uint32_t zOff = (d < 2) ? 0 : c * w * h;
+	for (uint32_t z = 0; z < d; z += 2)
+	{
+		for (uint32_t y = 0; y < h; y += 2)
+		{
+			for (uint32_t x = 0; x < w; x += 2)
 			{
-				float rgba[4];
-
-				if (ImageFormat::IsFloatFormat(mFormat))
+				for (uint32_t i = 0; i < c; i++)
 				{
-					if (mFormat <= ImageFormat::RGBA16F)
+					Sum sum = boxAdd(
+						boxAdd(decode(src[0], i), decode(src[xOff], i)), boxAdd(decode(src[yOff], i), decode(src[yOff + xOff], i)));
+					if (zOff)
 					{
-						for (int i = 0; i < nSrcChannels; i++)
-							rgba[i] = ((half*)src)[i];
+						const Sum back = boxAdd(
+							boxAdd(decode(src[zOff], i), decode(src[zOff + xOff], i)),
+							boxAdd(decode(src[zOff + yOff], i), decode(src[zOff + yOff + xOff], i)));
+						sum = boxAdd(sum, back);
 					}
 					else
 					{
-						for (int i = 0; i < nSrcChannels; i++)
-							rgba[i] = ((float*)src)[i];
+						sum = boxAdd(sum, sum);
 					}
+					*dst++ = encode(sum, i);
+					src++;
 				}
-				else if (mFormat >= ImageFormat::I16 && mFormat <= ImageFormat::RGBA16)
+				src += xOff;
+			}
+			src += yOff;
+		}
+		src += zOff;
+	}
+}
+
+#if defined(IMAGE_SIMD_F16C_DISPATCH)
+static bool hasF16C()
+{
+	// F16C is VEX encoded, the OS has to save the AVX state too
+	uint32_t eax, ebx, ecx, edx;
+	__builtin_cpu_init();
+	return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C) && __builtin_cpu_supports("avx");
+}
+
+__attribute__((target("f16c"))) static inline __m128 loadHalf4F16C(const uint16_t* p)
+{
+	return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)p));
+}
+
+/// buildBoxMipLevel of RGBA16F with the hardware conversions
+__attribute__((target("f16c"))) static void buildBoxMipLevelHalf4F16C(uint16_t* dst, const uint16_t* src, const uint3& srcDim)
+{
+	const uint32_t w = srcDim.x;
+	const uint32_t h = srcDim.y;
+	const uint32_t d = srcDim.z;
+	const uint32_t xOff = (w < 2) ? 0 : 4;
+	const uint32_t yOff = (h < 2) ? 0 : 4 * w;
+	const uint32_t zOff = (d < 2) ? 0 : 4 * w * h;
+	for (uint32_t z = 0; z < d; z += 2)
+	{
+		for (uint32_t y = 0; y < h; y += 2)
+		{
+			for (uint32_t x = 0; x < w; x += 2)
+			{
+				__m128 sum = _mm_add_ps(
+					_mm_add_ps(loadHalf4F16C(src), loadHalf4F16C(src + xOff)),
+					_mm_add_ps(loadHalf4F16C(src + yOff), loadHalf4F16C(src + yOff + xOff)));
+				if (zOff)
 				{
-					for (int i = 0; i < nSrcChannels; i++)
-						rgba[i] = ((ushort*)src)[i] * (1.0f / 65535.0f);
+					const __m128 back = _mm_add_ps(
+						_mm_add_ps(loadHalf4F16C(src + zOff), loadHalf4F16C(src + zOff + xOff)),
+						_mm_add_ps(loadHalf4F16C(src + zOff + yOff), loadHalf4F16C(src + zOff + yOff + xOff)));
+					sum = _mm_add_ps(sum, back);
 				}
 				else
 				{
-					for (int i = 0; i < nSrcChannels; i++)
-						rgba[i] = src[i] * (1.0f / 255.0f);
+					sum = _mm_add_ps(sum, sum);
 				}
-				if (nSrcChannels < 4)
-					rgba[3] = 1.0f;
-				if (nSrcChannels == 1)
-					rgba[2] = rgba[1] = rgba[0];
+				_mm_storel_epi64((__m128i*)dst, _mm_cvtps_ph(_mm_mul_ps(sum, _mm_set1_ps(0.125f)), _MM_FROUND_TO_NEAREST_INT));
+				dst += 4;
+				src += 4 + xOff;
+			}
+			src += yOff;
+		}
+		src += zOff;
+	}
+}
+#endif
 
-				if (nDestChannels == 1)
-					rgba[0] = 0.30f * rgba[0] + 0.59f * rgba[1] + 0.11f * rgba[2];
+/// Default box filter when every axis is halved or already 1, which is every level of a power of two image.
+/// Returns false for the formats it does not handle, they go through the resampler
+static bool generateBoxMipLevel(const MipGenerationTask* pTask, const uint8_t* pSrc, const uint3& srcDim, uint8_t* pDst, const uint3& dstDim)
+{
+	if (pTask->mFilter != MIP_FILTER_BOX)
+		return false;
+	if ((srcDim.x != dstDim.x * 2 && srcDim.x != 1) || (srcDim.y != dstDim.y * 2 && srcDim.y != 1) ||
+		(srcDim.z != dstDim.z * 2 && srcDim.z != 1))
+		return false;
 
-				if (ImageFormat::IsFloatFormat(newFormat))
+	const uint32_t c = pTask->mChannelCount;
+	switch (pTask->mDataType)
+	{
+		case MIP_DATA_UNORM8:
+		{
+			if (pTask->mSrgb)
+			{
+				// Average in linear space, alpha always stays linear
+				const SrgbTables& tables = getSrgbTables();
+				buildBoxMipLevel<uint8_t, float>(
+					pDst, pSrc, srcDim, c, [&](uint8_t v, uint32_t i) { return i < 3 ? tables.mToLinear[v] : (float)v; },
+					[&](float sum, uint32_t i) {
+						return i < 3 ? linearToSrgb8(tables, sum * 0.125f) : (uint8_t)(((uint32_t)sum + 4) >> 3);
+					});
+				return true;
+			}
+			buildBoxMipLevel<uint8_t, uint32_t>(
+				pDst, pSrc, srcDim, c, [](uint8_t v, uint32_t) { return (uint32_t)v; },
+				[](uint32_t sum, uint32_t) { return (uint8_t)((sum + 4) >> 3); });
+			return true;
+		}
+		case MIP_DATA_UNORM16:
+		case MIP_DATA_UINT16:
+			buildBoxMipLevel<uint16_t, uint32_t>(
+				(uint16_t*)pDst, (const uint16_t*)pSrc, srcDim, c, [](uint16_t v, uint32_t) { return (uint32_t)v; },
+				[](uint32_t sum, uint32_t) { return (uint16_t)((sum + 4) >> 3); });
+			return true;
+		case MIP_DATA_UINT32:
+			buildBoxMipLevel<uint32_t, uint64_t>(
+				(uint32_t*)pDst, (const uint32_t*)pSrc, srcDim, c, [](uint32_t v, uint32_t) { return (uint64_t)v; },
+				[](uint64_t sum, uint32_t) { return (uint32_t)((sum + 4) >> 3); });
+			return true;
+		case MIP_DATA_HALF:
+		{
+			if (c == 4)
+			{
+#if defined(IMAGE_SIMD_F16C_DISPATCH)
+				static const bool f16c = hasF16C();
+				if (f16c)
 				{
-					if (newFormat <= ImageFormat::RGBA32F)
-					{
-						if (newFormat <= ImageFormat::RGBA16F)
-						{
-							for (int i = 0; i < nDestChannels; i++)
-								((half*)dest)[i] = rgba[i];
-						}
-						else
-						{
-							for (int i = 0; i < nDestChannels; i++)
-								((float*)dest)[i] = rgba[i];
-						}
-					}
-					else
+					buildBoxMipLevelHalf4F16C((uint16_t*)pDst, (const uint16_t*)pSrc, srcDim);
+					return true;
+				}
+#endif
+				// One RGBA16F pixel per element, the four channels are converted together
+				buildBoxMipLevel<uint64_t, SimdFloat4>(
+					(uint64_t*)pDst, (const uint64_t*)pSrc, srcDim, 1,
+					[](const uint64_t& v, uint32_t) { return simdUnpackHalf((const uint16_t*)&v); },
+					[](SimdFloat4 sum, uint32_t) {
+						uint64_t v;
+						simdPackHalf(simdMul(sum, simdSplat(0.125f)), (uint16_t*)&v);
+						return v;
+					});
+				return true;
+			}
+			const HalfTables& tables = getHalfTables();
+			buildBoxMipLevel<uint16_t, float>(
+				(uint16_t*)pDst, (const uint16_t*)pSrc, srcDim, c, [&](uint16_t v, uint32_t) { return tables.mToFloat[v]; },
+				[](float sum, uint32_t) { return floatToHalf(sum * 0.125f); });
+			return true;
+		}
+		case MIP_DATA_FLOAT:
+			buildBoxMipLevel<float, float>(
+				(float*)pDst, (const float*)pSrc, srcDim, c, [](float v, uint32_t) { return v; },
+				[](float sum, uint32_t) { return sum * 0.125f; });
+			return true;
+		default: return false;
+	}
+}
+
+/// Filters one face of a mip level from the previous one. The image is resampled separably: source rows are decoded and
+/// filtered horizontally into a small cache, destination rows are weighted sums of the cached rows.
+static void generateMipLevel(const MipGenerationTask* pTask, const uint8_t* pSrc, const uint3& srcDim, uint8_t* pDst, const uint3& dstDim)
+{
+	if (generateBoxMipLevel(pTask, pSrc, srcDim, pDst, dstDim))
+		return;
+
+	MipAxisFilter filterX, filterY, filterZ;
+	addMipAxisFilter(pTask->mFilter, srcDim.x, dstDim.x, &filterX);
+	addMipAxisFilter(pTask->mFilter, srcDim.y, dstDim.y, &filterY);
+	addMipAxisFilter(pTask->mFilter, srcDim.z, dstDim.z, &filterZ);
+
+	const uint32_t pixelSize = pTask->mPixelSize;
+	const uint32_t srcRowSize = srcDim.x * pixelSize;
+	const uint32_t dstRowSize = dstDim.x * pixelSize;
+	const uint32_t rowFloats = dstDim.x * 4;
+	// Source rows needed by one destination row: consecutive rows never collide modulo the tap count
+	const uint32_t cacheRowCount = filterY.mTapCount * filterZ.mTapCount;
+
+	float*    pLine = (float*)conf_malloc(sizeof(float) * 4 * srcDim.x);
+	float*    pAccum = (float*)conf_malloc(sizeof(float) * rowFloats);
+	float*    pCache = (float*)conf_malloc(sizeof(float) * rowFloats * cacheRowCount);
+	uint64_t* pCacheKeys = (uint64_t*)conf_malloc(sizeof(uint64_t) * cacheRowCount);
+	for (uint32_t i = 0; i < cacheRowCount; ++i)
+		pCacheKeys[i] = UINT64_MAX;
+
+	for (uint32_t z = 0; z < dstDim.z; ++z)
+	{
+		const uint32_t* pIndicesZ = filterZ.pIndices + z * filterZ.mTapCount;
+		const float*    pWeightsZ = filterZ.pWeights + z * filterZ.mTapCount;
+		for (uint32_t y = 0; y < dstDim.y; ++y)
+		{
+			const uint32_t* pIndicesY = filterY.pIndices + y * filterY.mTapCount;
+			const float*    pWeightsY = filterY.pWeights + y * filterY.mTapCount;
+			memset(pAccum, 0, sizeof(float) * rowFloats);
+
+			for (uint32_t l = 0; l < filterZ.mTapCount; ++l)
+			{
+				for (uint32_t k = 0; k < filterY.mTapCount; ++k)
+				{
+					const float weight = pWeightsZ[l] * pWeightsY[k];
+					if (weight == 0.0f)
+						continue;
+
+					const uint32_t srcY = pIndicesY[k];
+					const uint32_t srcZ = pIndicesZ[l];
+					const uint64_t key = (uint64_t)srcZ * srcDim.y + srcY;
+					const uint32_t slot = (srcY % filterY.mTapCount) * filterZ.mTapCount + l;
+					float*         pRow = pCache + (size_t)slot * rowFloats;
+					if (pCacheKeys[slot] != key)
 					{
-						if (newFormat == ImageFormat::RGBE8)
+						decodeMipRow(pTask, pSrc + key * srcRowSize, srcDim.x, pLine);
+						for (uint32_t x = 0; x < dstDim.x; ++x)
 						{
-							*(uint32*)dest = rgbToRGBE8(vec3(rgba[0], rgba[1], rgba[2]));
-						}
-						else
-						{
-							*(uint32*)dest = rgbToRGB9E5(vec3(rgba[0], rgba[1], rgba[2]));
+							const uint32_t* pIndicesX = filterX.pIndices + x * filterX.mTapCount;
+							const float*    pWeightsX = filterX.pWeights + x * filterX.mTapCount;
+							SimdFloat4         sum = simdSplat(0.0f);
+							for (uint32_t t = 0; t < filterX.mTapCount; ++t)
+								sum = simdMadd(simdLoad(pLine + pIndicesX[t] * 4), simdSplat(pWeightsX[t]), sum);
+							simdStore(pRow + x * 4, sum);
 						}
+						pCacheKeys[slot] = key;
 					}
+
+					mipAccumulate(pAccum, pRow, weight, rowFloats);
 				}
-				else if (newFormat >= ImageFormat::I16 && newFormat <= ImageFormat::RGBA16)
-				{
-					for (int i = 0; i < nDestChannels; i++)
-						((ushort*)dest)[i] = (ushort)(65535 * saturate(rgba[i]) + 0.5f);
-				}
-				else if (/*isPackedFormat(newFormat)*/ newFormat == ImageFormat::RGB10A2)
-				{
-					*(uint*)dest = (uint(1023.0f * saturate(rgba[0]) + 0.5f) << 22) | (uint(1023.0f * saturate(rgba[1]) + 0.5f) << 12) |
-								   (uint(1023.0f * saturate(rgba[2]) + 0.5f) << 2) | (uint(3.0f * saturate(rgba[3]) + 0.5f));
-				}
-				else
-				{
-					for (int i = 0; i < nDestChannels; i++)
-						dest[i] = (unsigned char)(255 * saturate(rgba[i]) + 0.5f);
-				}
+			}
 
-				src += srcSize;
-				dest += destSize;
-			} while (--nPixels);
+			encodeMipRow(pTask, pAccum, dstDim.x, pDst + ((size_t)z * dstDim.y + y) * dstRowSize);
 		}
 	}
-	conf_free(pData);
-	pData = newPixels;
-	mFormat = newFormat;
 
-	return true;
+	conf_free(pCacheKeys);
+	conf_free(pCache);
+	conf_free(pAccum);
+	conf_free(pLine);
+	removeMipAxisFilter(&filterZ);
+	removeMipAxisFilter(&filterY);
+	removeMipAxisFilter(&filterX);
 }
 
-template <typename T>
-void buildMipMap(T* dst, const T* src, const uint w, const uint h, const uint d, const uint c)
+/// Generates the mip chain of one face of one array slice
+static void generateMipChainTask(void* pUser, uintptr_t index)
 {
-	uint xOff = (w < 2) ? 0 : c;
-	uint yOff = (h < 2) ? 0 : c * w;
-	uint zOff = (d < 2) ? 0 : c * w * h;
+	const MipGenerationTask* pTask = (const MipGenerationTask*)pUser;
+	const Image*             pImage = pTask->pImage;
+	const uint32_t           arraySlice = (uint32_t)index / pTask->mFaceCount;
+	const uint32_t           face = (uint32_t)index % pTask->mFaceCount;
 
-	for (uint z = 0; z < d; z += 2)
+	for (uint32_t level = 1; level < pImage->GetMipMapCount(); ++level)
 	{
-		for (uint y = 0; y < h; y += 2)
-		{
-			for (uint x = 0; x < w; x += 2)
-			{
-				for (uint i = 0; i < c; i++)
-				{
-					*dst++ = (src[0] + src[xOff] + src[yOff] + src[yOff + xOff] + src[zOff] + src[zOff + xOff] + src[zOff + yOff] +
-							  src[zOff + yOff + xOff]) /
-							 8;
-					src++;
-				}
-				src += xOff;
-			}
-			src += yOff;
-		}
-		src += zOff;
+		const uint3 srcDim = { pImage->GetWidth(level - 1), pImage->GetHeight(level - 1), pImage->GetDepth(level - 1) };
+		const uint3 dstDim = { pImage->GetWidth(level), pImage->GetHeight(level), pImage->GetDepth(level) };
+		const uint32_t srcFaceSize = pImage->GetMipMappedSize(level - 1, 1) / pTask->mFaceCount;
+		const uint32_t dstFaceSize = pImage->GetMipMappedSize(level, 1) / pTask->mFaceCount;
+
+		const uint8_t* pSrc = pImage->GetPixels(level - 1, arraySlice) + face * srcFaceSize;
+		uint8_t*       pDst = pImage->GetPixels(level, arraySlice) + face * dstFaceSize;
+		generateMipLevel(pTask, pSrc, srcDim, pDst, dstDim);
 	}
 }
 
-bool Image::GenerateMipMaps(const uint32_t mipMaps)
+bool Image::GenerateMipMaps(const uint32_t mipMaps, const MipFilter filter, ThreadSystem* pThreadSystem)
 {
-	if (ImageFormat::IsCompressedFormat(mFormat))
+	const MipDataType dataType = getMipDataType(mFormat);
+	if (dataType == MIP_DATA_UNSUPPORTED)
 		return false;
-	if (!(mWidth) || !isPowerOf2(mHeight) || !isPowerOf2(mDepth))
+	if (!mWidth || !mHeight)
 		return false;
 
 	uint actualMipMaps = min(mipMaps, GetMipMapCountFromDimensions());
@@ -2132,45 +4370,35 @@ bool Image::GenerateMipMaps(const uint32_t mipMaps)
 		mMipMapCount = actualMipMaps;
 	}
 
-	int nChannels = ImageFormat::GetChannelCount(mFormat);
-
-	int n = IsCube() ? 6 : 1;
-
-	for (uint arraySlice = 0; arraySlice < mArrayCount; arraySlice++)
+	MipGenerationTask task = {};
+	task.pImage = this;
+	task.mFilter = filter;
+	task.mDataType = dataType;
+	task.mChannelCount = ImageFormat::GetChannelCount(mFormat);
+	task.mPixelSize = ImageFormat::GetBytesPerPixel(mFormat);
+	task.mFaceCount = IsCube() ? 6 : 1;
+	task.mSrgb = mSrgb;
+
+	// Faces and array slices are independent chains
+	const uint32_t chainCount = mArrayCount * task.mFaceCount;
+	if (pThreadSystem && chainCount > 1)
 	{
-		ubyte* src = GetPixels(0, arraySlice);
-		ubyte* dst = GetPixels(1, arraySlice);
-
-		for (uint level = 1; level < mMipMapCount; level++)
-		{
-			int w = GetWidth(level - 1);
-			int h = GetHeight(level - 1);
-			int d = GetDepth(level - 1);
-
-			int srcSize = GetMipMappedSize(level - 1, 1) / n;
-			int dstSize = GetMipMappedSize(level, 1) / n;
-
-			for (int i = 0; i < n; i++)
-			{
-				if (ImageFormat::IsPlainFormat(mFormat))
-				{
-					if (ImageFormat::IsFloatFormat(mFormat))
-					{
-						buildMipMap((float*)dst, (float*)src, w, h, d, nChannels);
-					}
-					else if (mFormat >= ImageFormat::I16)
-					{
-						buildMipMap((ushort*)dst, (ushort*)src, w, h, d, nChannels);
-					}
-					else
-					{
-						buildMipMap(dst, src, w, h, d, nChannels);
-					}
-				}
-				src += srcSize;
-				dst += dstSize;
-			}
-		}
+		TaskGroup* pGroup = NULL;
+		addTaskGroup(pThreadSystem, &pGroup);
+		TaskDesc desc = {};
+		desc.pTask = generateMipChainTask;
+		desc.pUser = &task;
+		desc.mStart = 0;
+		desc.mEnd = chainCount;
+		desc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &desc);
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+		removeTaskGroup(pThreadSystem, pGroup);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < chainCount; ++i)
+			generateMipChainTask(&task, i);
 	}
 
 	return true;
@@ -30,7 +30,6 @@
 
 #include <pthread.h>
 #include <unistd.h>
-#include <sys/sysctl.h>
 
 #include "Interfaces/IMemory.h"
 
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include <stdio.h>
+
+#include "BinaryLog.h"
+
+#include "Interfaces/IMemory.h"
+
+struct BinaryLogArg
+{
+	uint8_t     mType;
+	int64_t     mInt;
+	uint64_t    mUInt;
+	double      mDouble;
+	const char* pString;
+	uint16_t    mLength;
+};
+
+static bool readArg(const uint8_t* pArgs, uint32_t argsSize, uint32_t* pOffset, BinaryLogArg* pArg)
+{
+	if (*pOffset >= argsSize)
+		return false;
+
+	const uint8_t* pData = pArgs + *pOffset + 1;
+	uint32_t       available = argsSize - *pOffset - 1;
+	uint32_t       size = 0;
+	*pArg = {};
+	pArg->mType = pArgs[*pOffset];
+
+	switch (pArg->mType)
+	{
+		case BINARY_LOG_ARG_INT32:
+		case BINARY_LOG_ARG_UINT32:
+		{
+			size = sizeof(uint32_t);
+			if (available < size)
+				return false;
+			uint32_t value = 0;
+			memcpy(&value, pData, size);
+			pArg->mInt = pArg->mType == BINARY_LOG_ARG_INT32 ? (int64_t)(int32_t)value : (int64_t)value;
+			pArg->mUInt = pArg->mType == BINARY_LOG_ARG_INT32 ? (uint64_t)(int64_t)(int32_t)value : (uint64_t)value;
+			pArg->mDouble = (double)pArg->mInt;
+			break;
+		}
+		case BINARY_LOG_ARG_INT64:
+		case BINARY_LOG_ARG_UINT64:
+		case BINARY_LOG_ARG_POINTER:
+		{
+			size = sizeof(uint64_t);
+			if (available < size)
+				return false;
+			memcpy(&pArg->mUInt, pData, size);
+			pArg->mInt = (int64_t)pArg->mUInt;
+			pArg->mDouble = pArg->mType == BINARY_LOG_ARG_INT64 ? (double)pArg->mInt : (double)pArg->mUInt;
+			break;
+		}
+		case BINARY_LOG_ARG_DOUBLE:
+		{
+			size = sizeof(double);
+			if (available < size)
+				return false;
+			memcpy(&pArg->mDouble, pData, size);
+			pArg->mInt = (int64_t)pArg->mDouble;
+			pArg->mUInt = (uint64_t)pArg->mInt;
+			break;
+		}
+		case BINARY_LOG_ARG_STRING:
+		{
+			if (available < sizeof(uint16_t))
+				return false;
+			memcpy(&pArg->mLength, pData, sizeof(uint16_t));
+			size = sizeof(uint16_t) + pArg->mLength;
+			if (available < size)
+				return false;
+			pArg->pString = (const char*)pData + sizeof(uint16_t);
+			break;
+		}
+		default: return false;
+	}
+
+	*pOffset += 1 + size;
+	return true;
+}
+
+// Formats one value with a conversion spec such as "%-8.3f", growing the output as needed
+template <typename T>
+static void appendFormatted(eastl::string& output, const char* spec, T value)
+{
+	char buffer[128];
+	int  length = snprintf(buffer, sizeof(buffer), spec, value);
+	if (length < 0)
+		return;
+	if ((size_t)length < sizeof(buffer))
+	{
+		output.append(buffer, buffer + length);
+		return;
+	}
+
+	size_t offset = output.size();
+	output.resize(offset + length + 1);
+	snprintf(output.begin() + offset, length + 1, spec, value);
+	output.resize(offset + length);
+}
+
+void binary_log_format(const char* format, const uint8_t* pArgs, uint32_t argsSize, eastl::string& output)
+{
+	uint32_t offset = 0;
+	const char* pCurrent = format;
+
+	while (*pCurrent)
+	{
+		const char* pPercent = strchr(pCurrent, '%');
+		if (!pPercent)
+		{
+			output.append(pCurrent);
+			break;
+		}
+
+		output.append(pCurrent, pPercent);
+		pCurrent = pPercent + 1;
+		if (*pCurrent == '%')
+		{
+			output.push_back('%');
+			++pCurrent;
+			continue;
+		}
+
+		// Rebuild the conversion spec without length modifiers, those are replaced to match the stored type
+		char spec[64] = { '%' };
+		uint32_t specLength = 1;
+		auto appendSpec = [&](const char* pText, size_t length) {
+			length = length < sizeof(spec) - specLength - 4 ? length : sizeof(spec) - specLength - 4;
+			memcpy(spec + specLength, pText, length);
+			specLength += (uint32_t)length;
+		};
+
+		const char* pFlags = pCurrent;
+		while (*pCurrent && strchr("-+ #0", *pCurrent))
+			++pCurrent;
+		appendSpec(pFlags, pCurrent - pFlags);
+
+		// Width and precision, either inline or passed as int arguments
+		for (int part = 0; part < 2; ++part)
+		{
+			if (part == 1)
+			{
+				if (*pCurrent != '.')
+					break;
+				appendSpec(pCurrent++, 1);
+			}
+
+			if (*pCurrent == '*')
+			{
+				++pCurrent;
+				BinaryLogArg arg;
+				char         number[24];
+				int          value = readArg(pArgs, argsSize, &offset, &arg) ? (int)arg.mInt : 0;
+				appendSpec(number, snprintf(number, sizeof(number), "%d", value));
+			}
+			else
+			{
+				const char* pDigits = pCurrent;
+				while (*pCurrent >= '0' && *pCurrent <= '9')
+					++pCurrent;
+				appendSpec(pDigits, pCurrent - pDigits);
+			}
+		}
+
+		while (*pCurrent && strchr("hljztLqI0123456789", *pCurrent))
+			++pCurrent;
+
+		const char conversion = *pCurrent;
+		if (!conversion)
+			break;
+		++pCurrent;
+
+		BinaryLogArg arg;
+		if (conversion == 'n')
+			continue;
+		if (!readArg(pArgs, argsSize, &offset, &arg))
+		{
+			output.append("<missing>");
+			continue;
+		}
+
+		switch (conversion)
+		{
+			case 'd':
+			case 'i':
+				appendSpec("ll", 2);
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, (long long)arg.mInt);
+				break;
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+				appendSpec("ll", 2);
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, (unsigned long long)arg.mUInt);
+				break;
+			case 'c':
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, (int)arg.mInt);
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, arg.mDouble);
+				break;
+			case 'p':
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, (const void*)(uintptr_t)arg.mUInt);
+				break;
+			case 's':
+			{
+				if (arg.mType != BINARY_LOG_ARG_STRING)
+				{
+					output.append("<not a string>");
+					break;
+				}
+				// Stored strings are not null terminated
+				eastl::string text(arg.pString, arg.pString + arg.mLength);
+				appendSpec(&conversion, 1);
+				appendFormatted(output, spec, text.c_str());
+				break;
+			}
+			default:
+				output.push_back('%');
+				output.push_back(conversion);
+				break;
+		}
+	}
+}
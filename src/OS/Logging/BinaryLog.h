@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "EASTL/string.h"
+
+// Binary log with deferred formatting
+//
+// BLOGF records the format string pointer, the source location and the raw arguments instead of formatting
+// the message on the calling thread. The log writer thread either expands the record into text or, in binary
+// mode, appends it to a .tflog file that LogDecoder expands offline.
+//
+// Argument stream: for each argument one BinaryLogArgType byte followed by the value, little endian and unaligned.
+// Integers and pointers take 4 or 8 bytes, floating point values are stored as doubles and strings as a uint16_t
+// length followed by the characters without terminator. Strings are truncated to fit BINARY_LOG_MAX_ARGS_SIZE.
+//
+// File layout:
+//   BinaryLogFileHeader
+//   A sequence of entries, each starting with its BinaryLogEntryType byte:
+//     BinaryLogStringEntry followed by mLength characters - format strings and source file names
+//     BinaryLogThreadEntry
+//     BinaryLogMessageEntry followed by mArgsSize bytes of argument stream
+//   String and thread entries are written before the first message that references them.
+
+#define BINARY_LOG_MAGIC 0x4C424654    // 'TFBL'
+#define BINARY_LOG_VERSION 1
+#define BINARY_LOG_MAX_ARGS_SIZE 512
+#define BINARY_LOG_THREAD_NAME_LENGTH 16
+
+typedef enum BinaryLogArgType
+{
+	BINARY_LOG_ARG_INT32 = 1,
+	BINARY_LOG_ARG_UINT32,
+	BINARY_LOG_ARG_INT64,
+	BINARY_LOG_ARG_UINT64,
+	BINARY_LOG_ARG_DOUBLE,
+	BINARY_LOG_ARG_STRING,
+	BINARY_LOG_ARG_POINTER,
+} BinaryLogArgType;
+
+typedef enum BinaryLogEntryType
+{
+	BINARY_LOG_ENTRY_STRING = 1,
+	BINARY_LOG_ENTRY_THREAD,
+	BINARY_LOG_ENTRY_MESSAGE,
+} BinaryLogEntryType;
+
+typedef struct BinaryLogFileHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+} BinaryLogFileHeader;
+
+typedef struct BinaryLogStringEntry
+{
+	uint8_t  mType;
+	uint8_t  mReserved[3];
+	uint32_t mIndex;
+	uint32_t mLength;
+} BinaryLogStringEntry;
+
+typedef struct BinaryLogThreadEntry
+{
+	uint8_t  mType;
+	uint8_t  mReserved[3];
+	uint32_t mIndex;
+	uint64_t mThreadId;
+	char     mName[BINARY_LOG_THREAD_NAME_LENGTH];
+} BinaryLogThreadEntry;
+
+typedef struct BinaryLogMessageEntry
+{
+	uint8_t  mType;
+	// Single LogLevel flag
+	uint8_t  mLevel;
+	uint16_t mArgsSize;
+	uint16_t mIndentation;
+	uint16_t mReserved;
+	uint32_t mThread;
+	uint32_t mFormat;
+	uint32_t mFile;
+	uint32_t mLine;
+	// Seconds since the epoch
+	uint32_t mTime;
+} BinaryLogMessageEntry;
+
+// Serializes printf arguments into the argument stream
+class BinaryLogArgs
+{
+public:
+	BinaryLogArgs(): mSize(0) {}
+
+	void Add(int value) { AddValue(BINARY_LOG_ARG_INT32, (int32_t)value); }
+	void Add(unsigned value) { AddValue(BINARY_LOG_ARG_UINT32, (uint32_t)value); }
+	void Add(long value) { AddValue(BINARY_LOG_ARG_INT64, (int64_t)value); }
+	void Add(unsigned long value) { AddValue(BINARY_LOG_ARG_UINT64, (uint64_t)value); }
+	void Add(long long value) { AddValue(BINARY_LOG_ARG_INT64, (int64_t)value); }
+	void Add(unsigned long long value) { AddValue(BINARY_LOG_ARG_UINT64, (uint64_t)value); }
+	void Add(double value) { AddValue(BINARY_LOG_ARG_DOUBLE, value); }
+	void Add(const void* value) { AddValue(BINARY_LOG_ARG_POINTER, (uint64_t)(uintptr_t)value); }
+	void Add(const char* value) { AddString(value ? value : "(null)"); }
+	void Add(char* value) { Add((const char*)value); }
+	void Add(const eastl::string& value) { AddString(value.c_str()); }
+
+	const uint8_t* GetData() const { return mData; }
+	uint32_t       GetSize() const { return mSize; }
+
+private:
+	template <typename T>
+	void AddValue(uint8_t type, T value)
+	{
+		if (mSize + 1 + sizeof(T) > BINARY_LOG_MAX_ARGS_SIZE)
+			return;
+		mData[mSize++] = type;
+		memcpy(mData + mSize, &value, sizeof(T));
+		mSize += sizeof(T);
+	}
+
+	void AddString(const char* value)
+	{
+		if (mSize + 1 + sizeof(uint16_t) > BINARY_LOG_MAX_ARGS_SIZE)
+			return;
+		size_t   length = strlen(value);
+		uint16_t stored = (uint16_t)(length < BINARY_LOG_MAX_ARGS_SIZE - mSize - 3 ? length : BINARY_LOG_MAX_ARGS_SIZE - mSize - 3);
+		mData[mSize++] = BINARY_LOG_ARG_STRING;
+		memcpy(mData + mSize, &stored, sizeof(stored));
+		mSize += sizeof(stored);
+		memcpy(mData + mSize, value, stored);
+		mSize += stored;
+	}
+
+	uint8_t  mData[BINARY_LOG_MAX_ARGS_SIZE];
+	uint32_t mSize;
+};
+
+inline void binary_log_add_args(BinaryLogArgs&) {}
+
+template <typename T, typename... Args>
+inline void binary_log_add_args(BinaryLogArgs& args, const T& value, const Args&... rest)
+{
+	args.Add(value);
+	binary_log_add_args(args, rest...);
+}
+
+// Expands a printf format string with the arguments of an argument stream and appends the result to output.
+// Arguments that are missing or do not match the conversion are printed as placeholders.
+void binary_log_format(const char* format, const uint8_t* pArgs, uint32_t argsSize, eastl::string& output);
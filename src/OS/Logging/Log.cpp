@@ -26,22 +26,402 @@
 #include "Interfaces/ILog.h"
 #include "Interfaces/IFileSystem.h"
 #include "Interfaces/IOperatingSystem.h"
-#include "EASTL/unordered_map.h"
+#include "../Core/Atomics.h"
+#include "EASTL/hash_map.h"
 
 #include "Interfaces/IMemory.h"
 
 #define LOG_PREAMBLE_SIZE (56 + MAX_THREAD_NAME_LENGTH + FILENAME_NAME_LENGTH_LOG)
+#define LOG_PREFIX_SIZE 6
+
+// Every thread that logs owns one ring. Lines longer than LOG_MAX_RECORD_SIZE are truncated.
+#define LOG_RING_SIZE (64 * 1024)
+#define LOG_RECORD_ALIGNMENT 32
+#define LOG_MAX_RECORD_SIZE (LOG_RING_SIZE / 4)
+
+enum LogRecordFlags
+{
+	LOG_RECORD_PADDING = 0x1,
+	LOG_RECORD_RAW = 0x2,
+	LOG_RECORD_ERROR = 0x4,
+	// Text is a LogDeferredHeader followed by the argument stream of BLOGF
+	LOG_RECORD_DEFERRED = 0x8,
+};
+
+enum LogWriterState
+{
+	LOG_WRITER_IDLE = 0,
+	LOG_WRITER_STARTING,
+	LOG_WRITER_RUNNING,
+	LOG_WRITER_STOPPED,
+};
+
+// Header of a preformatted line in a ring, followed by mLength characters of text.
+// The size is a multiple of the alignment so a wrap always leaves room for a padding header.
+struct LogRecord
+{
+	uint64_t mSequence;
+	uint32_t mSize;
+	uint32_t mLevel;
+	uint32_t mLength;
+	uint32_t mMessageOffset;
+	uint32_t mFlags;
+	uint32_t mReserved;
+};
+static_assert(sizeof(LogRecord) == LOG_RECORD_ALIGNMENT, "LogRecord must fill one alignment unit");
+
+// Single producer / single consumer ring. The owning thread advances mWriteOffset, the writer thread mReadOffset.
+struct LogRing
+{
+	tfrg_atomic64_t mWriteOffset;
+	uint8_t         mPadding0[56];
+	tfrg_atomic64_t mReadOffset;
+	uint8_t         mPadding1[56];
+	tfrg_atomic32_t mOwned;
+	LogRing*        pNext;
+	uint8_t         mData[LOG_RING_SIZE];
+};
+
+struct LogRingCursor
+{
+	LogRing* pRing;
+	uint64_t mReadOffset;
+	uint64_t mEndOffset;
+};
+
+// The pieces of a line, copied into the ring without building intermediate strings
+struct LogText
+{
+	const char* pPreamble;
+	uint32_t    mPreambleLength;
+	const char* pPrefix;
+	uint32_t    mIndentation;
+	const char* pMessage;
+	uint32_t    mMessageLength;
+};
+
+// Captured by WriteDeferred on the calling thread. The format and file strings are literals that outlive the record.
+struct LogDeferredHeader
+{
+	const char* pFormat;
+	const char* pFile;
+	int64_t     mTime;
+	uint64_t    mThreadId;
+	uint32_t    mLine;
+	uint32_t    mIndentation;
+	char        mThreadName[BINARY_LOG_THREAD_NAME_LENGTH];
+};
+
+// Binary log sink. Strings and threads are given an index the first time a message references them.
+struct LogBinaryFile
+{
+	File*                                  pFile;
+	uint32_t                               mLevel;
+	eastl::hash_map<const void*, uint32_t> mStrings;
+	eastl::hash_map<uint64_t, uint32_t>    mThreads;
+	eastl::vector<eastl::string>           mThreadNames;
+};
+
+// Releases the ring of a thread when it exits so a new thread can reuse it
+struct LogRingOwner
+{
+	bool mRegistered = false;
+	~LogRingOwner();
+};
+
+// Declared before gLogger so they outlive it during static destruction
+static tfrg_atomicptr_t gLogRings = 0;
+static tfrg_atomic64_t  gLogSequence = 0;
+static tfrg_atomic32_t  gLogIndentation = 0;
+static tfrg_atomic32_t  gLogInitialFile = 0;
+static tfrg_atomic32_t  gLogWriterState = LOG_WRITER_IDLE;
+static tfrg_atomic32_t  gLogWriterSleeping = 0;
+
+static Mutex             gLogWriterMutex;
+static ConditionVariable gLogWriterCond;
+static ConditionVariable gLogFlushCond;
+static uint64_t          gLogPassStarted = 0;
+static uint64_t          gLogPassCompleted = 0;
+static bool              gLogFlushRequested = false;
+static bool              gLogWriterExit = false;
+static bool              gLogWriterDone = false;
+static ThreadDesc        gLogWriterDesc;
+static ThreadHandle      gLogWriterThread;
+
+static eastl::vector<LogRingCursor> gLogCursors;
+
+static thread_local LogRing*     pThreadLogRing = NULL;
+static thread_local bool         gThreadLogRingReleased = false;
+static thread_local bool         gThreadIsLogWriter = false;
+static thread_local LogRingOwner gThreadLogRingOwner;
+static thread_local time_t       gThreadLogTime = 0;
+static thread_local char         gThreadLogTimeString[24] = {};
+static thread_local time_t       gThreadLogNameTime = 0;
+static thread_local char         gThreadLogName[MAX_THREAD_NAME_LENGTH + 1] = {};
 
 static Log gLogger;
 
-// Fill unordered map for log level prefixes
-static eastl::unordered_map<uint32_t, eastl::string> logLevelPrefixes{
-	eastl::pair<uint32_t, eastl::string>{ LogLevel::eWARNING, eastl::string{ "WARN" } },
-	eastl::pair<uint32_t, eastl::string>{ LogLevel::eINFO, eastl::string{ "INFO" } },
-	eastl::pair<uint32_t, eastl::string>{ LogLevel::eDEBUG, eastl::string{ " DBG" } },
-	eastl::pair<uint32_t, eastl::string>{ LogLevel::eERROR, eastl::string{ " ERR" } }
+// Log level prefixes, tested in this order against the level flags of a message
+static const struct
+{
+	uint32_t    mLevel;
+	const char* pPrefix;
+} gLogLevelPrefixes[] = {
+	{ LogLevel::eWARNING, "WARN| " },
+	{ LogLevel::eINFO, "INFO| " },
+	{ LogLevel::eDEBUG, " DBG| " },
+	{ LogLevel::eERROR, " ERR| " },
 };
-static bool gOnce = true;
+
+static const char* getLogLevelPrefix(uint32_t level)
+{
+	for (uint32_t i = 0; i < sizeof(gLogLevelPrefixes) / sizeof(gLogLevelPrefixes[0]); ++i)
+	{
+		if (gLogLevelPrefixes[i].mLevel == level)
+			return gLogLevelPrefixes[i].pPrefix;
+	}
+	return NULL;
+}
+
+// localtime can hit the file system to look up the time zone and querying the thread name is a system call,
+// so both are cached per thread and refreshed once per second
+static const char* getLogTimeString(time_t t)
+{
+	if (t != gThreadLogTime)
+	{
+		tm time_info;
+#ifdef _WIN32
+		localtime_s(&time_info, &t);
+#else
+		localtime_r(&t, &time_info);
+#endif
+		snprintf(gThreadLogTimeString, sizeof(gThreadLogTimeString), "%04d-%02d-%02d %02d:%02d:%02d ",
+			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
+			time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
+		gThreadLogTime = t;
+	}
+	return gThreadLogTimeString;
+}
+
+static const char* getLogThreadName(time_t t)
+{
+	if (t != gThreadLogNameTime)
+	{
+		Thread::GetCurrentThreadName(gThreadLogName, MAX_THREAD_NAME_LENGTH + 1);
+
+		// No thread name
+		if (gThreadLogName[0] == 0)
+			snprintf(gThreadLogName, MAX_THREAD_NAME_LENGTH + 1, "NoName");
+		gThreadLogNameTime = t;
+	}
+	return gThreadLogName;
+}
+
+static uint32_t getBinaryLogString(LogBinaryFile* pBinaryFile, const char* pString)
+{
+	eastl::hash_map<const void*, uint32_t>::iterator it = pBinaryFile->mStrings.find(pString);
+	if (it != pBinaryFile->mStrings.end())
+		return it->second;
+
+	BinaryLogStringEntry entry = {};
+	entry.mType = BINARY_LOG_ENTRY_STRING;
+	entry.mIndex = (uint32_t)pBinaryFile->mStrings.size();
+	entry.mLength = (uint32_t)strlen(pString);
+	pBinaryFile->pFile->Write(&entry, sizeof(entry));
+	pBinaryFile->pFile->Write(pString, entry.mLength);
+	pBinaryFile->mStrings.insert(eastl::make_pair((const void*)pString, entry.mIndex));
+	return entry.mIndex;
+}
+
+static uint32_t getBinaryLogThread(LogBinaryFile* pBinaryFile, uint64_t threadId, const char* pName)
+{
+	// A renamed thread gets a new entry
+	eastl::hash_map<uint64_t, uint32_t>::iterator it = pBinaryFile->mThreads.find(threadId);
+	if (it != pBinaryFile->mThreads.end() && pBinaryFile->mThreadNames[it->second] == pName)
+		return it->second;
+
+	BinaryLogThreadEntry entry = {};
+	entry.mType = BINARY_LOG_ENTRY_THREAD;
+	entry.mIndex = (uint32_t)pBinaryFile->mThreadNames.size();
+	entry.mThreadId = threadId;
+	strncpy(entry.mName, pName, BINARY_LOG_THREAD_NAME_LENGTH - 1);
+	pBinaryFile->pFile->Write(&entry, sizeof(entry));
+	pBinaryFile->mThreadNames.push_back(entry.mName);
+	pBinaryFile->mThreads[threadId] = entry.mIndex;
+	return entry.mIndex;
+}
+
+static void writeBinaryLogMessage(LogBinaryFile* pBinaryFile, uint32_t level, const LogDeferredHeader& header, const uint8_t* pArgs, uint32_t argsSize)
+{
+	BinaryLogMessageEntry entry = {};
+	entry.mType = BINARY_LOG_ENTRY_MESSAGE;
+	entry.mLevel = (uint8_t)level;
+	entry.mArgsSize = (uint16_t)argsSize;
+	entry.mIndentation = (uint16_t)header.mIndentation;
+	entry.mThread = getBinaryLogThread(pBinaryFile, header.mThreadId, header.mThreadName);
+	entry.mFormat = getBinaryLogString(pBinaryFile, header.pFormat);
+	entry.mFile = getBinaryLogString(pBinaryFile, header.pFile);
+	entry.mLine = header.mLine;
+	entry.mTime = (uint32_t)header.mTime;
+	pBinaryFile->pFile->Write(&entry, sizeof(entry));
+	pBinaryFile->pFile->Write(pArgs, argsSize);
+}
+
+LogRingOwner::~LogRingOwner()
+{
+	// After shutdown the rings are freed
+	if (pThreadLogRing && tfrg_atomic32_load_relaxed(&gLogWriterState) != LOG_WRITER_STOPPED)
+		tfrg_atomic32_store_release(&pThreadLogRing->mOwned, 0);
+	pThreadLogRing = NULL;
+	gThreadLogRingReleased = true;
+}
+
+static LogRing* acquireLogRing()
+{
+	if (pThreadLogRing)
+		return pThreadLogRing;
+	// Thread locals are being destroyed, fall back to the synchronous path
+	if (gThreadLogRingReleased)
+		return NULL;
+
+	// Reuse the ring of a thread that exited before allocating a new one
+	LogRing* pRing = (LogRing*)tfrg_atomicptr_load_acquire(&gLogRings);
+	for (; pRing; pRing = pRing->pNext)
+	{
+		if (tfrg_atomic32_load_relaxed(&pRing->mOwned) == 0 && tfrg_atomic32_cas_relaxed(&pRing->mOwned, 0, 1) == 0)
+			break;
+	}
+
+	if (!pRing)
+	{
+		pRing = (LogRing*)conf_calloc(1, sizeof(LogRing));
+		pRing->mOwned = 1;
+		uintptr_t head = 0;
+		do
+		{
+			head = tfrg_atomicptr_load_relaxed(&gLogRings);
+			pRing->pNext = (LogRing*)head;
+		} while (tfrg_atomicptr_cas_relaxed(&gLogRings, head, (uintptr_t)pRing) != head);
+	}
+
+	pThreadLogRing = pRing;
+	gThreadLogRingOwner.mRegistered = true;
+	return pRing;
+}
+
+static bool hasPendingLogRecords()
+{
+	for (LogRing* pRing = (LogRing*)tfrg_atomicptr_load_acquire(&gLogRings); pRing; pRing = pRing->pNext)
+	{
+		if (tfrg_atomic64_load_acquire(&pRing->mWriteOffset) != tfrg_atomic64_load_relaxed(&pRing->mReadOffset))
+			return true;
+	}
+	return false;
+}
+
+static void wakeLogWriter()
+{
+	// Pairs with the barrier in the writer between raising the sleeping flag and checking the rings.
+	// Only the first producer to see the flag pays for the wake up.
+	tfrg_memorybarrier_full();
+	if (tfrg_atomic32_load_relaxed(&gLogWriterSleeping) && tfrg_atomic32_cas_relaxed(&gLogWriterSleeping, 1, 0) == 1)
+	{
+		MutexLock lock{ gLogWriterMutex };
+		gLogWriterCond.WakeOne();
+	}
+}
+
+static void copyLogText(const LogText& text, uint32_t length, char* pDst)
+{
+	uint32_t offset = 0;
+	auto append = [&](const char* pSrc, uint32_t size) {
+		size = min<uint32_t>(size, length - offset);
+		if (size)
+			memcpy(pDst + offset, pSrc, size);
+		offset += size;
+	};
+
+	append(text.pPreamble, text.mPreambleLength);
+	if (text.pPrefix)
+		append(text.pPrefix, LOG_PREFIX_SIZE);
+	uint32_t indentation = min<uint32_t>(text.mIndentation, length - offset);
+	memset(pDst + offset, ' ', indentation);
+	offset += indentation;
+	append(text.pMessage, text.mMessageLength);
+}
+
+static uint32_t getLogMessageOffset(const LogText& text)
+{
+	return text.mPreambleLength + (text.pPrefix ? LOG_PREFIX_SIZE : 0) + text.mIndentation;
+}
+
+static uint32_t getLogTextLength(const LogText& text)
+{
+	return min<uint32_t>(getLogMessageOffset(text) + text.mMessageLength, LOG_MAX_RECORD_SIZE - (uint32_t)sizeof(LogRecord));
+}
+
+static void fillLogRecord(LogRecord* pRecord, uint32_t level, uint32_t flags, const LogText& text, uint32_t length, uint32_t size)
+{
+	pRecord->mSequence = 0;
+	pRecord->mSize = size;
+	pRecord->mLevel = level;
+	pRecord->mLength = length;
+	pRecord->mMessageOffset = min<uint32_t>(length, getLogMessageOffset(text));
+	pRecord->mFlags = flags;
+	pRecord->mReserved = 0;
+	copyLogText(text, length, (char*)(pRecord + 1));
+}
+
+// Copies the line into the ring of the calling thread. Returns false when the writer thread is not running.
+static bool pushLogRecord(uint32_t level, uint32_t flags, const LogText& text)
+{
+	if (gThreadIsLogWriter || tfrg_atomic32_load_acquire(&gLogWriterState) != LOG_WRITER_RUNNING)
+		return false;
+
+	LogRing* pRing = acquireLogRing();
+	if (!pRing)
+		return false;
+
+	const uint32_t length = getLogTextLength(text);
+	const uint32_t size = ((uint32_t)sizeof(LogRecord) + length + LOG_RECORD_ALIGNMENT - 1) & ~(LOG_RECORD_ALIGNMENT - 1);
+
+	uint64_t writeOffset = tfrg_atomic64_load_relaxed(&pRing->mWriteOffset);
+	uint32_t position = 0;
+	uint32_t contiguous = 0;
+	for (;;)
+	{
+		position = (uint32_t)(writeOffset % LOG_RING_SIZE);
+		contiguous = LOG_RING_SIZE - position;
+		const uint32_t required = size <= contiguous ? size : contiguous + size;
+		const uint64_t readOffset = tfrg_atomic64_load_acquire(&pRing->mReadOffset);
+		if (LOG_RING_SIZE - (writeOffset - readOffset) >= required)
+			break;
+
+		// Ring is full, let the writer catch up
+		wakeLogWriter();
+		Thread::Sleep(0);
+		if (tfrg_atomic32_load_acquire(&gLogWriterState) != LOG_WRITER_RUNNING)
+			return false;
+	}
+
+	if (size > contiguous)
+	{
+		LogRecord* pPadding = (LogRecord*)(pRing->mData + position);
+		memset(pPadding, 0, sizeof(LogRecord));
+		pPadding->mSize = contiguous;
+		pPadding->mFlags = LOG_RECORD_PADDING;
+		writeOffset += contiguous;
+		position = 0;
+	}
+
+	LogRecord* pRecord = (LogRecord*)(pRing->mData + position);
+	fillLogRecord(pRecord, level, flags, text, length, size);
+	pRecord->mSequence = tfrg_atomic64_add_relaxed(&gLogSequence, 1);
+
+	tfrg_atomic64_store_release(&pRing->mWriteOffset, writeOffset + size);
+	wakeLogWriter();
+	return true;
+}
 
 eastl::string GetTimeStamp()
 {
@@ -68,7 +448,6 @@ void log_write(void * user_data, const eastl::string & message)
 {
 	File * file = static_cast<File *>(user_data);
 	file->WriteLine(message);
-	file->Flush();
 }
 
 // Close callback
@@ -102,19 +481,13 @@ Log::LogScope::LogScope(uint32_t log_level, const char * file, int line, const c
 
 	// Write to log and update indentation
 	Log::Write(mLevel, "{ " + mMessage, mFile, mLine);
-	{
-		MutexLock lock{ gLogger.mLogMutex };
-		++gLogger.mIndentation;
-	}
+	tfrg_atomic32_add_relaxed(&gLogIndentation, 1);
 }
 
 Log::LogScope::~LogScope()
 {
 	// Update indentation and write to log
-	{
-		MutexLock lock{ gLogger.mLogMutex };
-		--gLogger.mIndentation;
-	}
+	tfrg_atomic32_add_relaxed(&gLogIndentation, (uint32_t)-1);
 	Log::Write(mLevel, "} " + mMessage, mFile, mLine);
 }
 
@@ -125,13 +498,32 @@ void Log::SetTimeStamp(bool bEnable)           { gLogger.mRecordTimestamp = bEna
 void Log::SetRecordingFile(bool bEnable)       { gLogger.mRecordFile = bEnable; }
 void Log::SetRecordingThreadName(bool bEnable) { gLogger.mRecordThreadName = bEnable; }
 
+void Log::SetBinaryMode(bool bEnable)
+{
+	bool addFile = false;
+	{
+		MutexLock lock{ gLogger.mLogMutex };
+		gLogger.mBinaryMode = bEnable;
+		addFile = bEnable && gLogger.mBinaryFiles.empty();
+	}
+
+	if (addFile)
+	{
+		eastl::string exeFileName = FileSystem::GetProgramFileName();
+		if (exeFileName.size() < 2)
+			exeFileName = "Log";
+		AddBinaryFile((exeFileName + ".tflog").c_str(), LogLevel::eALL);
+	}
+}
+
 // Gettors
 uint32_t Log::GetLevel()            { return gLogger.mLogLevel; }
-eastl::string Log::GetLastMessage() { return gLogger.mLastMessage; }
+eastl::string Log::GetLastMessage() { MutexLock lock{ gLogger.mLogMutex }; return gLogger.mLastMessage; }
 bool Log::IsQuiet()                 { return gLogger.mQuietMode; }
 bool Log::IsRecordingTimeStamp()    { return gLogger.mRecordTimestamp; }
 bool Log::IsRecordingFile()         { return gLogger.mRecordFile; }
 bool Log::IsRecordingThreadName()   { return gLogger.mRecordThreadName; }
+bool Log::IsBinaryMode()            { return gLogger.mBinaryMode; }
 
 void Log::AddFile(const char * filename, FileMode file_mode, LogLevel log_level)
 {
@@ -141,32 +533,57 @@ void Log::AddFile(const char * filename, FileMode file_mode, LogLevel log_level)
 	File * file = conf_placement_new<File>(conf_calloc(1, sizeof(File)));
 	if (file->Open(filename, file_mode, FSR_Absolute))
 	{
+		// Header goes in before the writer thread can see the file
+		eastl::string header;
+		if (gLogger.mRecordTimestamp)
+			header += "date       time     ";
+		if (gLogger.mRecordThreadName)
+			header += "[thread name/id ]";
+		if (gLogger.mRecordFile)
+			header += "                   file:line  ";
+		header += "  v |\n";
+		file->Write(header.c_str(), (unsigned)header.size());
+		file->Flush();
+
 		// AddCallback will try to acquire mutex
 		AddCallback((FileSystem::GetCurrentDir() + filename).c_str(), log_level, file, log_write, log_close, log_flush);
 
+		Write(LogLevel::eINFO, "Opened log file " + eastl::string{ filename }, __FILE__, __LINE__);
+	}
+	else
+	{
+		file->~File();
+		conf_free(file);
+		Write(LogLevel::eERROR, "Failed to create log file " + eastl::string{ filename }, __FILE__, __LINE__); // will try to acquire mutex
+	}
+}
+
+void Log::AddBinaryFile(const char * filename, LogLevel log_level)
+{
+	if (filename == 0)
+		return;
+
+	File * file = conf_placement_new<File>(conf_calloc(1, sizeof(File)));
+	if (file->Open(filename, FileMode::FM_WriteBinary, FSR_Absolute))
+	{
+		BinaryLogFileHeader header = { BINARY_LOG_MAGIC, BINARY_LOG_VERSION };
+		file->Write(&header, sizeof(header));
+
+		LogBinaryFile* pBinaryFile = conf_placement_new<LogBinaryFile>(conf_calloc(1, sizeof(LogBinaryFile)));
+		pBinaryFile->pFile = file;
+		pBinaryFile->mLevel = log_level;
 		{
-			MutexLock lock{ gLogger.mLogMutex }; // scope lock as Write will try to acquire mutex
-
-			// Header
-			eastl::string header;
-			if (gLogger.mRecordTimestamp)
-				header += "date       time     ";
-			if (gLogger.mRecordThreadName)
-				header += "[thread name/id ]";
-			if (gLogger.mRecordFile)
-				header += "                   file:line  ";
-			header += "  v |\n";
-			file->Write(header.c_str(), (unsigned)header.size());
-			file->Flush();
+			MutexLock lock{ gLogger.mLogMutex };
+			gLogger.mBinaryFiles.push_back(pBinaryFile);
 		}
 
-		Write(LogLevel::eINFO, "Opened log file " + eastl::string{ filename }, __FILE__, __LINE__);
+		Write(LogLevel::eINFO, "Opened binary log file " + eastl::string{ filename }, __FILE__, __LINE__);
 	}
 	else
 	{
 		file->~File();
 		conf_free(file);
-		Write(LogLevel::eERROR, "Failed to create log file " + eastl::string{ filename }, __FILE__, __LINE__); // will try to acquire mutex
+		Write(LogLevel::eERROR, "Failed to create binary log file " + eastl::string{ filename }, __FILE__, __LINE__);
 	}
 }
 
@@ -183,98 +600,334 @@ void Log::AddCallback(const char * id, uint32_t log_level, void * user_data, log
 
 void Log::Write(uint32_t level, const eastl::string & message, const char * filename, int line_number)
 {
-	eastl::string log_level_strings[LEVELS_LOG];
-	uint32_t log_levels[LEVELS_LOG];
-	uint32_t log_level_count = 0;
+	if (tfrg_atomic32_load_relaxed(&gLogInitialFile) == 0 && tfrg_atomic32_cas_relaxed(&gLogInitialFile, 0, 1) == 0)
+		AddInitialLogFile();
+	if (tfrg_atomic32_load_relaxed(&gLogWriterState) == LOG_WRITER_IDLE)
+		StartWriter();
+
+	const time_t t = time(NULL);
+	char preamble[LOG_PREAMBLE_SIZE] = { 0 };
+	WritePreamble(preamble, LOG_PREAMBLE_SIZE, t, getLogThreadName(t), filename, line_number);
+
+	LogText text = {};
+	text.pPreamble = preamble;
+	text.mPreambleLength = (uint32_t)strlen(preamble);
+	text.mIndentation = tfrg_atomic32_load_relaxed(&gLogIndentation) * INDENTATION_SIZE_LOG;
+	text.pMessage = message.c_str();
+	text.mMessageLength = (uint32_t)message.size();
 
-	// Check flags
-	for (eastl::unordered_map<uint32_t, eastl::string>::iterator it = logLevelPrefixes.begin(); it != logLevelPrefixes.end(); ++it)
+	// Log for each flag
+	const uint32_t flags = (level & LogLevel::eERROR) ? LOG_RECORD_ERROR : 0;
+	for (uint32_t i = 0; i < sizeof(gLogLevelPrefixes) / sizeof(gLogLevelPrefixes[0]); ++i)
 	{
-		if (it->first & level)
+		if (gLogLevelPrefixes[i].mLevel & level)
 		{
-			log_level_strings[log_level_count] = it->second + "| ";
-			log_levels[log_level_count] = it->first;
-			++log_level_count;
+			text.pPrefix = gLogLevelPrefixes[i].pPrefix;
+			WriteRecord(gLogLevelPrefixes[i].mLevel, flags, text);
 		}
 	}
-	
-	bool do_once = false;
+
+	if (flags & LOG_RECORD_ERROR)
+		Flush();
+}
+
+void Log::WriteRaw(uint32_t level, const eastl::string & message, bool error)
+{
+	if (tfrg_atomic32_load_relaxed(&gLogInitialFile) == 0 && tfrg_atomic32_cas_relaxed(&gLogInitialFile, 0, 1) == 0)
+		AddInitialLogFile();
+	if (tfrg_atomic32_load_relaxed(&gLogWriterState) == LOG_WRITER_IDLE)
+		StartWriter();
+
+	LogText text = {};
+	text.pMessage = message.c_str();
+	text.mMessageLength = (uint32_t)message.size();
+	WriteRecord(level, LOG_RECORD_RAW | (error ? LOG_RECORD_ERROR : 0), text);
+
+	if (error)
+		Flush();
+}
+
+void Log::WriteDeferredArgs(uint32_t level, const char * filename, int line_number, const char * format, const uint8_t * pArgs, uint32_t argsSize)
+{
+	if (tfrg_atomic32_load_relaxed(&gLogInitialFile) == 0 && tfrg_atomic32_cas_relaxed(&gLogInitialFile, 0, 1) == 0)
+		AddInitialLogFile();
+	if (tfrg_atomic32_load_relaxed(&gLogWriterState) == LOG_WRITER_IDLE)
+		StartWriter();
+
+	const time_t t = time(NULL);
+	uint8_t payload[sizeof(LogDeferredHeader) + BINARY_LOG_MAX_ARGS_SIZE];
+	LogDeferredHeader* pHeader = (LogDeferredHeader*)payload;
+	pHeader->pFormat = format;
+	pHeader->pFile = filename;
+	pHeader->mTime = (int64_t)t;
+	pHeader->mThreadId = (uint64_t)(uintptr_t)Thread::GetCurrentThreadID();
+	pHeader->mLine = (uint32_t)line_number;
+	pHeader->mIndentation = tfrg_atomic32_load_relaxed(&gLogIndentation) * INDENTATION_SIZE_LOG;
+	memcpy(pHeader->mThreadName, getLogThreadName(t), sizeof(pHeader->mThreadName));
+	argsSize = min<uint32_t>(argsSize, BINARY_LOG_MAX_ARGS_SIZE);
+	memcpy(payload + sizeof(LogDeferredHeader), pArgs, argsSize);
+
+	LogText text = {};
+	text.pMessage = (const char*)payload;
+	text.mMessageLength = (uint32_t)sizeof(LogDeferredHeader) + argsSize;
+
+	// Log for each flag
+	const uint32_t flags = LOG_RECORD_DEFERRED | ((level & LogLevel::eERROR) ? LOG_RECORD_ERROR : 0);
+	for (uint32_t i = 0; i < sizeof(gLogLevelPrefixes) / sizeof(gLogLevelPrefixes[0]); ++i)
 	{
-		MutexLock lock{ gLogger.mLogMutex }; // scope lock as stack frames from calling AddInitialLogFile will attempt to lock mutex
-		do_once = gOnce;
-		gOnce = false;
+		if (gLogLevelPrefixes[i].mLevel & level)
+			WriteRecord(gLogLevelPrefixes[i].mLevel, flags, text);
 	}
-	if (do_once)
-		AddInitialLogFile();
+
+	if (flags & LOG_RECORD_ERROR)
+		Flush();
+}
+
+void Log::Flush()
+{
+	if (gThreadIsLogWriter || tfrg_atomic32_load_acquire(&gLogWriterState) != LOG_WRITER_RUNNING)
+	{
+		MutexLock lock{ gLogger.mLogMutex };
+		FlushCallbacks();
+		return;
+	}
+
+	// Wait for a complete pass of the writer that started after this point
+	MutexLock lock{ gLogWriterMutex };
+	const uint64_t pass = gLogPassStarted + 1;
+	gLogFlushRequested = true;
+	gLogWriterCond.WakeOne();
+	while (gLogPassCompleted < pass && !gLogWriterDone)
+		gLogFlushCond.Wait(gLogWriterMutex);
+}
+
+void Log::WriteRecord(uint32_t level, uint32_t flags, const LogText & text)
+{
+	if (pushLogRecord(level, flags, text))
+		return;
+
+	// Writer thread is not running, write and flush on the calling thread
+	const uint32_t length = getLogTextLength(text);
+	eastl::vector<uint8_t> storage(sizeof(LogRecord) + length);
+	LogRecord* pRecord = (LogRecord*)storage.data();
+	fillLogRecord(pRecord, level, flags, text, length, (uint32_t)storage.size());
 
 	MutexLock lock{ gLogger.mLogMutex };
-	gLogger.mLastMessage = message;
+	DispatchRecord(*pRecord, (const char*)(pRecord + 1));
+	FlushCallbacks();
+}
 
-	char preamble[LOG_PREAMBLE_SIZE] = { 0 };
-	WritePreamble(preamble, LOG_PREAMBLE_SIZE, filename, line_number);
+void Log::StartWriter()
+{
+	if (tfrg_atomic32_cas_relaxed(&gLogWriterState, LOG_WRITER_IDLE, LOG_WRITER_STARTING) != LOG_WRITER_IDLE)
+		return;
+
+	gLogWriterDesc.pFunc = WriterThread;
+	gLogWriterDesc.pData = NULL;
+	gLogWriterThread = create_thread(&gLogWriterDesc);
+	tfrg_atomic32_store_release(&gLogWriterState, LOG_WRITER_RUNNING);
+}
 
-	// Prepare indentation
-	eastl::string indentation;
-	indentation.resize(gLogger.mIndentation * INDENTATION_SIZE_LOG);
-	memset(indentation.begin(), ' ', indentation.size());
+void Log::StopWriter()
+{
+	if (tfrg_atomic32_cas_relaxed(&gLogWriterState, LOG_WRITER_RUNNING, LOG_WRITER_STOPPED) == LOG_WRITER_RUNNING)
+	{
+		{
+			MutexLock lock{ gLogWriterMutex };
+			gLogWriterExit = true;
+			gLogWriterCond.WakeOne();
+		}
+		destroy_thread(gLogWriterThread);
+	}
+	else
+	{
+		tfrg_atomic32_store_release(&gLogWriterState, LOG_WRITER_STOPPED);
+	}
 
-	// Log for each flag
-	for (uint32_t i = 0; i < log_level_count; ++i)
+	// Pick up whatever was pushed while the writer was exiting
+	DrainRecords();
+	{
+		MutexLock lock{ gLogger.mLogMutex };
+		FlushCallbacks();
+	}
+
+	LogRing* pRing = (LogRing*)tfrg_atomicptr_load_acquire(&gLogRings);
+	tfrg_atomicptr_store_release(&gLogRings, 0);
+	while (pRing)
 	{
-        eastl::string formattedMessage = preamble + log_level_strings[i] + indentation + message;
+		LogRing* pNext = pRing->pNext;
+		conf_free(pRing);
+		pRing = pNext;
+	}
+	pThreadLogRing = NULL;
+	gLogCursors.set_capacity(0);
+}
 
-		if (gLogger.mQuietMode)
+void Log::WriterThread(void * pData)
+{
+	Thread::SetCurrentThreadName("LogWriter");
+	gThreadIsLogWriter = true;
+
+	for (;;)
+	{
+		uint64_t pass = 0;
+		bool exit = false;
 		{
-			if (level & LogLevel::eERROR)
-				_PrintUnicodeLine(formattedMessage, true);
+			MutexLock lock{ gLogWriterMutex };
+			while (!gLogWriterExit && !gLogFlushRequested)
+			{
+				tfrg_atomic32_store_relaxed(&gLogWriterSleeping, 1);
+				tfrg_memorybarrier_full();
+				if (hasPendingLogRecords())
+					break;
+				gLogWriterCond.Wait(gLogWriterMutex);
+			}
+			tfrg_atomic32_store_relaxed(&gLogWriterSleeping, 0);
+			pass = ++gLogPassStarted;
+			exit = gLogWriterExit;
+			gLogFlushRequested = false;
 		}
-		else
+
+		// One flush per batch instead of one per line
+		DrainRecords();
 		{
-			_PrintUnicodeLine(formattedMessage, level & LogLevel::eERROR);
+			MutexLock lock{ gLogger.mLogMutex };
+			FlushCallbacks();
 		}
-	}
-	
-	for (LogCallback & callback : gLogger.mCallbacks)
-	{
-		// Log for each flag
-		for (uint32_t i = 0; i < log_level_count; ++i)
+
 		{
-			if (callback.mLevel & log_levels[i])
-				callback.mCallback(callback.mUserData, preamble + log_level_strings[i] + indentation + message);
+			MutexLock lock{ gLogWriterMutex };
+			gLogPassCompleted = pass;
+			gLogWriterDone = exit;
+			gLogFlushCond.WakeAll();
 		}
+
+		if (exit)
+			break;
 	}
 }
 
-void Log::WriteRaw(uint32_t level, const eastl::string & message, bool error)
+uint32_t Log::DrainRecords()
 {
-	bool do_once = false;
+	// Snapshot the rings, then merge them by sequence number so lines keep the order they were written in
+	gLogCursors.clear();
+	for (LogRing* pRing = (LogRing*)tfrg_atomicptr_load_acquire(&gLogRings); pRing; pRing = pRing->pNext)
 	{
-		MutexLock lock{ gLogger.mLogMutex }; // scope lock as stack frames from calling AddInitialLogFile will attempt to lock mutex
-		do_once = gOnce;
-		gOnce = false;
+		LogRingCursor cursor = { pRing, tfrg_atomic64_load_relaxed(&pRing->mReadOffset), tfrg_atomic64_load_acquire(&pRing->mWriteOffset) };
+		if (cursor.mReadOffset != cursor.mEndOffset)
+			gLogCursors.push_back(cursor);
 	}
-	if (do_once)
-		AddInitialLogFile();
-	
+
+	uint32_t count = 0;
 	MutexLock lock{ gLogger.mLogMutex };
-	
-	gLogger.mLastMessage = message;
-	
-	if (gLogger.mQuietMode)
+	for (;;)
+	{
+		LogRingCursor* pNext = NULL;
+		const LogRecord* pNextRecord = NULL;
+		for (LogRingCursor& cursor : gLogCursors)
+		{
+			while (cursor.mReadOffset != cursor.mEndOffset)
+			{
+				const LogRecord* pRecord = (const LogRecord*)(cursor.pRing->mData + cursor.mReadOffset % LOG_RING_SIZE);
+				if (!(pRecord->mFlags & LOG_RECORD_PADDING))
+				{
+					if (!pNextRecord || pRecord->mSequence < pNextRecord->mSequence)
+					{
+						pNext = &cursor;
+						pNextRecord = pRecord;
+					}
+					break;
+				}
+				cursor.mReadOffset += pRecord->mSize;
+				tfrg_atomic64_store_release(&cursor.pRing->mReadOffset, cursor.mReadOffset);
+			}
+		}
+
+		if (!pNext)
+			break;
+
+		DispatchRecord(*pNextRecord, (const char*)(pNextRecord + 1));
+		pNext->mReadOffset += pNextRecord->mSize;
+		tfrg_atomic64_store_release(&pNext->pRing->mReadOffset, pNext->mReadOffset);
+		++count;
+	}
+
+	return count;
+}
+
+void Log::DispatchRecord(const LogRecord & record, const char * text)
+{
+	// Called with mLogMutex held
+	eastl::string& line = gLogger.mLine;
+	if (record.mFlags & LOG_RECORD_DEFERRED)
 	{
-		if (error)
-			_PrintUnicode(message, true);
+		if (!ExpandDeferredRecord(record, (const uint8_t*)text, line))
+			return;
 	}
 	else
-		_PrintUnicode(message, error);
-	
+	{
+		line.assign(text, text + record.mLength);
+		gLogger.mLastMessage.assign(text + record.mMessageOffset, text + record.mLength);
+	}
+
+	const bool error = (record.mFlags & LOG_RECORD_ERROR) != 0;
+	if (!gLogger.mQuietMode || error)
+	{
+		if (record.mFlags & LOG_RECORD_RAW)
+			_PrintUnicode(line, error);
+		else
+			_PrintUnicodeLine(line, error);
+	}
+
 	for (LogCallback & callback : gLogger.mCallbacks)
 	{
-		if (callback.mLevel & level)
-			callback.mCallback(callback.mUserData, message);
+		if (callback.mLevel & record.mLevel)
+			callback.mCallback(callback.mUserData, line);
 	}
 }
 
+bool Log::ExpandDeferredRecord(const LogRecord & record, const uint8_t * data, eastl::string & line)
+{
+	// Called with mLogMutex held
+	LogDeferredHeader header;
+	memcpy(&header, data, sizeof(header));
+	const uint8_t* pArgs = data + sizeof(header);
+	const uint32_t argsSize = record.mLength - (uint32_t)sizeof(header);
+
+	for (LogBinaryFile* pBinaryFile : gLogger.mBinaryFiles)
+	{
+		if (pBinaryFile->mLevel & record.mLevel)
+			writeBinaryLogMessage(pBinaryFile, record.mLevel, header, pArgs, argsSize);
+	}
+
+	// Errors always make it to the console and text logs
+	if (gLogger.mBinaryMode && !(record.mFlags & LOG_RECORD_ERROR))
+		return false;
+
+	char preamble[LOG_PREAMBLE_SIZE] = { 0 };
+	WritePreamble(preamble, LOG_PREAMBLE_SIZE, header.mTime, header.mThreadName, header.pFile, (int)header.mLine);
+	line.assign(preamble);
+	line.append(getLogLevelPrefix(record.mLevel));
+	line.append(header.mIndentation, ' ');
+	const size_t messageOffset = line.size();
+	binary_log_format(header.pFormat, pArgs, argsSize, line);
+	gLogger.mLastMessage.assign(line.begin() + messageOffset, line.end());
+	return true;
+}
+
+void Log::FlushCallbacks()
+{
+	// Called with mLogMutex held
+	for (LogCallback & callback : gLogger.mCallbacks)
+	{
+		if (callback.mFlush)
+			callback.mFlush(callback.mUserData);
+	}
+
+	for (LogBinaryFile* pBinaryFile : gLogger.mBinaryFiles)
+		pBinaryFile->pFile->Flush();
+}
+
 void Log::AddInitialLogFile()
 {
 	// Add new file with executable name
@@ -285,37 +938,15 @@ void Log::AddInitialLogFile()
 	AddFile((exeFileName + ".log").c_str(), FileMode::FM_WriteBinary, LogLevel::eALL);
 }
 
-void Log::WritePreamble(char * buffer, uint32_t buffer_size, const char * file, int line)
+void Log::WritePreamble(char * buffer, uint32_t buffer_size, int64_t time, const char * thread_name, const char * file, int line)
 {
-	time_t  t = time(NULL);
-	tm time_info;
-#ifdef _WIN32
-	localtime_s(&time_info, &t);
-#else
-	localtime_r(&t, &time_info);
-#endif
-
 	uint32_t pos = 0;
 	// Date and time
 	if (gLogger.mRecordTimestamp && pos < buffer_size)
-	{
-		pos += snprintf(buffer + pos, buffer_size - pos, "%04d-%02d-%02d ",
-			1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday);
-		pos += snprintf(buffer + pos, buffer_size - pos, "%02d:%02d:%02d ",
-			time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
-	}
+		pos += snprintf(buffer + pos, buffer_size - pos, "%s", getLogTimeString((time_t)time));
 
 	if (gLogger.mRecordThreadName && pos < buffer_size)
-	{
-		char thread_name[MAX_THREAD_NAME_LENGTH + 1] = { 0 };
-		Thread::GetCurrentThreadName(thread_name, MAX_THREAD_NAME_LENGTH + 1);
-
-		// No thread name
-		if (thread_name[0] == 0)
-			snprintf(thread_name, MAX_THREAD_NAME_LENGTH + 1, "NoName");
-
 		pos += snprintf(buffer + pos, buffer_size - pos, "[%-15s]", thread_name);
-	}
 
 	// File and line
 	if (gLogger.mRecordFile && pos < buffer_size)
@@ -341,11 +972,11 @@ bool Log::CallbackExists(const char * id)
 
 Log::Log(LogLevel level)
 	: mLogLevel(level)
-	, mIndentation(0)
 	, mQuietMode(false)
 	, mRecordTimestamp(true)
 	, mRecordFile(true)
 	, mRecordThreadName(true)
+	, mBinaryMode(false)
 {
 	Thread::SetMainThread();
 	Thread::SetCurrentThreadName("MainThread");
@@ -353,6 +984,8 @@ Log::Log(LogLevel level)
 
 Log::~Log()
 {
+	StopWriter();
+
 	for (LogCallback & callback : mCallbacks)
 	{
 		if (callback.mClose)
@@ -360,6 +993,17 @@ Log::~Log()
 	}
 	
 	mCallbacks.clear();
+
+	for (LogBinaryFile* pBinaryFile : mBinaryFiles)
+	{
+		pBinaryFile->pFile->Close();
+		pBinaryFile->pFile->~File();
+		conf_free(pBinaryFile->pFile);
+		pBinaryFile->~LogBinaryFile();
+		conf_free(pBinaryFile);
+	}
+
+	mBinaryFiles.clear();
 }
 
 eastl::string ToString(const char* format, ...)
@@ -30,6 +30,8 @@
 #include "Interfaces/IThread.h"
 #include "Interfaces/IFileSystem.h"
 
+#include "BinaryLog.h"
+
 #ifndef FILENAME_NAME_LENGTH_LOG
 #define FILENAME_NAME_LENGTH_LOG 23
 #endif
@@ -62,12 +64,20 @@ enum LogLevel
 };
 
 class File;
+struct LogRecord;
+struct LogText;
+struct LogBinaryFile;
 
 typedef void(*log_callback_t)(void * user_data, const eastl::string & message);
 typedef void(*log_close_t)(void * user_data);
 typedef void(*log_flush_t)(void * user_data);
 
 /// Logging subsystem.
+/// Write and WriteRaw format each line on the calling thread into a per-thread ring buffer without taking a lock.
+/// A background writer thread drains the rings in batches, prints to the console and calls the callbacks,
+/// flushing them once per batch. Errors and shutdown flush synchronously.
+/// WriteDeferred (BLOGF) only captures the format string and raw arguments, the writer thread expands them
+/// into text or, in binary mode, appends them to a binary log that LogDecoder expands offline.
 class Log
 {
 public:
@@ -90,6 +100,9 @@ public:
 	static void SetTimeStamp(bool bEnable);
 	static void SetRecordingFile(bool bEnable);
 	static void SetRecordingThreadName(bool bEnable);
+	/// Deferred messages go to the binary log files only, errors are still expanded into text.
+	/// Opens <executable>.tflog if no binary log file was added yet.
+	static void SetBinaryMode(bool bEnable);
 
 	static uint32_t        GetLevel();
 	static eastl::string   GetLastMessage();
@@ -97,18 +110,40 @@ public:
 	static bool            IsRecordingTimeStamp();
 	static bool            IsRecordingFile();
 	static bool            IsRecordingThreadName();
+	static bool            IsBinaryMode();
 
 	static void AddFile(const char * filename, FileMode file_mode, LogLevel log_level);
+	static void AddBinaryFile(const char * filename, LogLevel log_level);
 	static void AddCallback(const char * id, uint32_t log_level, void * user_data, log_callback_t callback, log_close_t close = nullptr, log_flush_t flush = nullptr);
 
 	static void Write(uint32_t level, const eastl::string& message, const char * filename, int line_number);
 	static void WriteRaw(uint32_t level, const eastl::string& message, bool error = false);
+	/// Format must be a string literal, it is read after the call returns.
+	template <typename... Args>
+	static void WriteDeferred(uint32_t level, const char * filename, int line_number, const char * format, const Args&... args)
+	{
+		BinaryLogArgs binaryArgs;
+		binary_log_add_args(binaryArgs, args...);
+		WriteDeferredArgs(level, filename, line_number, format, binaryArgs.GetData(), binaryArgs.GetSize());
+	}
+	static void WriteDeferredArgs(uint32_t level, const char * filename, int line_number, const char * format, const uint8_t * pArgs, uint32_t argsSize);
+	/// Blocks until every line written before the call reached the callbacks and flushes them.
+	static void Flush();
 
 private:
 	static void AddInitialLogFile();
-	static void WritePreamble(char * buffer, uint32_t buffer_size, const char * file, int line);
+	static void WritePreamble(char * buffer, uint32_t buffer_size, int64_t time, const char * thread_name, const char * file, int line);
 	static bool CallbackExists(const char * id);
 
+	static void StartWriter();
+	static void StopWriter();
+	static void WriteRecord(uint32_t level, uint32_t flags, const LogText & text);
+	static void WriterThread(void * pData);
+	static uint32_t DrainRecords();
+	static void DispatchRecord(const LogRecord & record, const char * text);
+	static bool ExpandDeferredRecord(const LogRecord & record, const uint8_t * data, eastl::string & line);
+	static void FlushCallbacks();
+
 	// Singleton
 	Log(const Log &) = delete;
 	Log(Log &&) = delete;
@@ -135,15 +170,18 @@ private:
 	};
 
 	eastl::vector<LogCallback> mCallbacks;
-	/// Mutex for threaded operation.
+	eastl::vector<LogBinaryFile*> mBinaryFiles;
+	/// Guards the callbacks and the last message. Only the writer thread takes it on the logging path.
 	Mutex           mLogMutex;
 	eastl::string   mLastMessage;
+	/// Scratch line handed to the callbacks by the writer thread.
+	eastl::string   mLine;
 	uint32_t        mLogLevel;
-	uint32_t        mIndentation;
 	bool            mQuietMode;
 	bool            mRecordTimestamp;
 	bool            mRecordFile;
 	bool            mRecordThreadName;
+	bool            mBinaryMode;
 };
 
 eastl::string ToString(const char* formatString, ...);
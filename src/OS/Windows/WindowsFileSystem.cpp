@@ -39,7 +39,7 @@
 #define RESOURCE_DIR "Shaders/D3D12"
 #elif defined(DIRECT3D11)
 #define RESOURCE_DIR "Shaders/D3D11"
-#elif defined(VULKAN)
+#elif defined(VULKAN) || defined(NULL_RENDERER)
 #define RESOURCE_DIR "Shaders/Vulkan"
 #else
 #define RESOURCE_DIR "Shaders"
@@ -70,12 +70,43 @@ void flush_file(FileHandle handle) { fflush((::FILE*)handle); }
 
 size_t read_file(void* buffer, size_t byteCount, FileHandle handle) { return fread(buffer, 1, byteCount, (::FILE*)handle); }
 
-bool seek_file(FileHandle handle, long offset, int origin) { return fseek((::FILE*)handle, offset, origin) == 0; }
+bool seek_file(FileHandle handle, int64_t offset, int origin) { return _fseeki64((::FILE*)handle, offset, origin) == 0; }
 
-long tell_file(FileHandle handle) { return ftell((::FILE*)handle); }
+int64_t tell_file(FileHandle handle) { return _ftelli64((::FILE*)handle); }
 
 size_t write_file(const void* buffer, size_t byteCount, FileHandle handle) { return fwrite(buffer, 1, byteCount, (::FILE*)handle); }
 
+const void* map_file(const char* filename, size_t* pSize, FileHandle* pHandle)
+{
+	*pSize = 0;
+	*pHandle = NULL;
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void*  pData = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	// The view keeps the mapping and the file alive until it is unmapped
+	if (mapping)
+		CloseHandle(mapping);
+	CloseHandle(file);
+	if (!pData)
+		return NULL;
+
+	*pSize = (size_t)fileSize.QuadPart;
+	return pData;
+}
+
+void unmap_file(const void* pData, size_t size, FileHandle handle) { UnmapViewOfFile(pData); }
+
 time_t get_file_last_modified_time(const char* _fileName)
 {
 	struct stat fileInfo = {0};
@@ -136,14 +136,14 @@ size_t read_file(void* buffer, size_t byteCount, FileHandle handle)
 	return fread(buffer, 1, byteCount, (::FILE*)handle);
 }
 
-bool seek_file(FileHandle handle, long offset, int origin)
+bool seek_file(FileHandle handle, int64_t offset, int origin)
 {    // TODO: use NSBundle
-	return fseek((::FILE*)handle, offset, origin) == 0;
+	return fseeko((::FILE*)handle, (off_t)offset, origin) == 0;
 }
 
-long tell_file(FileHandle handle)
+int64_t tell_file(FileHandle handle)
 {    // TODO: use NSBundle
-	return ftell((::FILE*)handle);
+	return ftello((::FILE*)handle);
 }
 
 size_t write_file(const void* buffer, size_t byteCount, FileHandle handle)
@@ -151,6 +151,33 @@ size_t write_file(const void* buffer, size_t byteCount, FileHandle handle)
 	return fwrite(buffer, 1, byteCount, (::FILE*)handle);
 }
 
+const void* map_file(const char* filename, size_t* pSize, FileHandle* pHandle)
+{
+	// TODO: map the file once open_file resolves bundle paths up front. Until then read it through open_file.
+	*pSize = 0;
+	*pHandle = NULL;
+
+	FileHandle file = open_file(filename, "rb");
+	if (!file)
+		return NULL;
+
+	size_t size = (size_t)FileSystem::GetFileSize(file);
+	void*  pData = size ? conf_malloc(size) : NULL;
+	if (pData && read_file(pData, size, file) != size)
+	{
+		conf_free(pData);
+		pData = NULL;
+	}
+	close_file(file);
+	if (!pData)
+		return NULL;
+
+	*pSize = size;
+	return pData;
+}
+
+void unmap_file(const void* pData, size_t size, FileHandle handle) { conf_free((void*)pData); }
+
 eastl::string get_current_dir()
 {
 	return eastl::string([[[NSBundle mainBundle] bundlePath] cStringUsingEncoding:NSUTF8StringEncoding]);
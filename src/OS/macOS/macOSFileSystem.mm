@@ -36,6 +36,8 @@
 #include <sys/stat.h>     // for mkdir
 #include <sys/errno.h>    // for errno
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include "Interfaces/IMemory.h"
 
@@ -65,12 +67,47 @@ void flush_file(FileHandle handle) { fflush((::FILE*)handle); }
 
 size_t read_file(void* buffer, size_t byteCount, FileHandle handle) { return fread(buffer, 1, byteCount, (::FILE*)handle); }
 
-bool seek_file(FileHandle handle, long offset, int origin) { return fseek((::FILE*)handle, offset, origin) == 0; }
+bool seek_file(FileHandle handle, int64_t offset, int origin) { return fseeko((::FILE*)handle, (off_t)offset, origin) == 0; }
 
-long tell_file(FileHandle handle) { return ftell((::FILE*)handle); }
+int64_t tell_file(FileHandle handle) { return ftello((::FILE*)handle); }
 
 size_t write_file(const void* buffer, size_t byteCount, FileHandle handle) { return fwrite(buffer, 1, byteCount, (::FILE*)handle); }
 
+const void* map_file(const char* filename, size_t* pSize, FileHandle* pHandle)
+{
+	*pSize = 0;
+	*pHandle = NULL;
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	struct stat fileInfo = {0};
+	if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	size_t size = (size_t)fileInfo.st_size;
+	void*  pData = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	close(fd);
+	if (pData == MAP_FAILED)
+		return NULL;
+
+	// Callers parse the whole file right away so start reading it in now
+	madvise(pData, size, MADV_WILLNEED);
+
+	*pSize = size;
+	return pData;
+}
+
+void unmap_file(const void* pData, size_t size, FileHandle handle)
+{
+	munmap((void*)pData, size);
+}
+
 time_t get_file_last_modified_time(const char* _fileName)
 {
 	struct stat fileInfo = {0};
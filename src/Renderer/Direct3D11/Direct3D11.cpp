@@ -1447,7 +1447,6 @@ void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
 
 void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 {
-	UNREF_PARAM(secondary);
 	//verify that given pool is valid
 	ASSERT(pCmdPool);
 
@@ -1459,6 +1458,7 @@ void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 	pCmd->pRenderer = pCmdPool->pQueue->pRenderer;
 	pCmd->pCmdPool = pCmdPool;
 	pCmd->mNodeIndex = pCmdPool->pQueue->mQueueDesc.mNodeIndex;
+	pCmd->mSecondary = secondary;
 
 	//add command to pool
 	//ASSERT(pCmdPool->pDxCmdAlloc);
@@ -1474,6 +1474,9 @@ void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 		pCmd->pBoundSrgbValues = (bool*)conf_calloc(MAX_RENDER_TARGET_ATTACHMENTS, sizeof(bool));
 	}
 
+	// Create the cached cmd list up front so beginCmd does not modify gCachedCmds while secondaries are recorded on other threads
+	gCachedCmds[pCmd];
+
 	//set new command
 	*ppCmd = pCmd;
 }
@@ -1497,9 +1500,10 @@ void removeCmd(CmdPool* pCmdPool, Cmd* pCmd)
 		removeBuffer(pCmd->pRenderer, pCmd->pTransientConstantBuffer);
 
 	SAFE_FREE(pCmd->pDescriptorStructPool);
-	SAFE_FREE(pCmd->pDescriptorNamePool);
 	SAFE_FREE(pCmd->pDescriptorResourcesPool);
 
+	gCachedCmds.erase(pCmd);
+
 	//delete command
 	SAFE_FREE(pCmd);
 }
@@ -3067,7 +3071,6 @@ void beginCmd(Cmd* pCmd)
 		gCachedCmds[pCmd];    // create a new cached cmd list
 
 	pCmd->mDescriptorStructPoolOffset = 0;
-	pCmd->mDescriptorNamePoolOffset = 0;
 	pCmd->mDescriptorResourcePoolOffset = 0;
 }
 
@@ -3078,6 +3081,50 @@ void endCmd(Cmd* pCmd)
 	// TODO: should we do anything particular here?
 }
 
+void beginSecondaryCmd(Cmd* pCmd, Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+	ASSERT(pCmd->mSecondary && !pPrimaryCmd->mSecondary);
+
+	// The immediate context replays the cached cmds, the render targets of the primary stay bound
+	::beginCmd(pCmd);
+
+	if (pCmd->pBoundColorFormats && pPrimaryCmd->pBoundColorFormats)
+	{
+		memcpy(pCmd->pBoundColorFormats, pPrimaryCmd->pBoundColorFormats, sizeof(uint32_t) * MAX_RENDER_TARGET_ATTACHMENTS);
+		memcpy(pCmd->pBoundSrgbValues, pPrimaryCmd->pBoundSrgbValues, sizeof(bool) * MAX_RENDER_TARGET_ATTACHMENTS);
+	}
+	pCmd->mBoundDepthStencilFormat = pPrimaryCmd->mBoundDepthStencilFormat;
+	pCmd->mBoundRenderTargetCount = pPrimaryCmd->mBoundRenderTargetCount;
+	pCmd->mBoundSampleCount = pPrimaryCmd->mBoundSampleCount;
+	pCmd->mBoundWidth = pPrimaryCmd->mBoundWidth;
+	pCmd->mBoundHeight = pPrimaryCmd->mBoundHeight;
+	pCmd->mRenderPassHash = pPrimaryCmd->mRenderPassHash;
+}
+
+void cmdExecuteSecondaryCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppSecondaryCmds)
+{
+	ASSERT(pCmd);
+	ASSERT(!pCmd->mSecondary);
+
+	CachedCmds::iterator cachedCmdsIter = gCachedCmds.find(pCmd);
+	ASSERT(cachedCmdsIter != gCachedCmds.end());
+	if (cachedCmdsIter == gCachedCmds.end())
+	{
+		LOGF(LogLevel::eERROR, "beginCmd was never called for that specific Cmd buffer!");
+		return;
+	}
+
+	// Descriptor data of the copied cmds lives in the pools of the secondaries until they get recorded again
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		ASSERT(ppSecondaryCmds[i]->mSecondary);
+		const eastl::vector<CachedCmd>& secondaryCmds = gCachedCmds[ppSecondaryCmds[i]];
+		cachedCmdsIter->second.insert(cachedCmdsIter->second.end(), secondaryCmds.begin(), secondaryCmds.end());
+	}
+}
+
 void cmdBindRenderTargets(
 	Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil,
 	const LoadActionsDesc* pLoadActions /* = NULL*/, uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice,
@@ -3225,6 +3272,28 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 	}
 }
 
+const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t paramIndex, uint32_t* pIndex)
+{
+	if (pParam->pName)
+		return get_descriptor(pRootSignature, pParam->pName, pIndex);
+
+	if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+	{
+		LOGF(LogLevel::eERROR, "Descriptor at index (%u) has no name and an invalid descriptor index (%u)", paramIndex, pParam->mIndex);
+		return NULL;
+	}
+
+	*pIndex = pParam->mIndex;
+	return &pRootSignature->pDescriptors[pParam->mIndex];
+}
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	uint32_t index = UINT32_MAX;
+	get_descriptor(pRootSignature, pName, &index);
+	return index;
+}
+
 void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams)
 {
 	ASSERT(pCmd);
@@ -3240,14 +3309,14 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 	}
 
 	// Create descriptor pool for storing the descriptor data
-	if (!pCmd->pDescriptorNamePool)
+	if (!pCmd->pDescriptorStructPool)
 	{
-		pCmd->pDescriptorNamePool = (uint8_t*)conf_calloc(1024 * 32, sizeof(uint8_t));
 		pCmd->pDescriptorStructPool = (uint8_t*)conf_calloc(1024 * 32, sizeof(uint8_t));
 		pCmd->pDescriptorResourcesPool = (uint8_t*)conf_calloc(1024 * 32, sizeof(uint8_t));
 	}
 
 	DescriptorData* pBegin = NULL;
+	uint32_t        recordedCount = 0;
 
 	for (uint32_t i = 0; i < numDescriptors; ++i)
 	{
@@ -3255,21 +3324,21 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 		const DescriptorData* pSrc = &pDescParams[i];
 		DescriptorData*       pDst = (DescriptorData*)pPool;
 		uint32_t              index = 0;
-		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pSrc->pName, &index);
-    if (!pDesc)
-      continue;
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pSrc, i, &index);
+		if (!pDesc)
+			continue;
 
-		if (i == 0)
+		if (!pBegin)
 			pBegin = pDst;
+		++recordedCount;
 
 		memcpy(pDst, pSrc, sizeof(DescriptorData));
 		pDst->mCount = max(1U, pDst->mCount);
 		pCmd->mDescriptorStructPoolOffset += sizeof(DescriptorData);
 
-		pDst->pName = (char*)(pCmd->pDescriptorNamePool + pCmd->mDescriptorNamePoolOffset);
-		memcpy((void*)pDst->pName, pSrc->pName, strlen(pSrc->pName));
-		((char*)pDst->pName)[strlen(pSrc->pName)] = '\0';
-		pCmd->mDescriptorNamePoolOffset += strlen(pSrc->pName) + 1;
+		// Store the resolved index so the replay does not need to copy and look up the name again
+		pDst->pName = NULL;
+		pDst->mIndex = index;
 
 		const uint32_t count = max(1U, pSrc->mCount);
 
@@ -3306,7 +3375,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 	cmd.pCmd = pCmd;
 	cmd.sType = CMD_TYPE_cmdBindDescriptors;
 	cmd.mBindDescriptorsCmd.pRootSignature = pRootSignature;
-	cmd.mBindDescriptorsCmd.numDescriptors = numDescriptors;
+	cmd.mBindDescriptorsCmd.numDescriptors = recordedCount;
 	cmd.mBindDescriptorsCmd.pDescParams = pBegin;
 	cachedCmdsIter->second.push_back(cmd);
 }
@@ -3742,14 +3811,9 @@ void queueSubmit(
 						const DescriptorData* pParam = &bind.pDescParams[i];
 
 						ASSERT(pParam);
-						if (!pParam->pName)
-						{
-							LOGF(LogLevel::eERROR, "Name of Descriptor at index (%u) is NULL", i);
-							return;
-						}
 
 						uint32_t              descIndex = ~0u;
-						const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+						const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, i, &descIndex);
 						if (!pDesc)
 							continue;
 						const ShaderResource* pRes = &pDesc->mDesc;
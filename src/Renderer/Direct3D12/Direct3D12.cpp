@@ -792,7 +792,9 @@ typedef struct DescriptorBinder
 	DescriptorStoreHeap* pCbvSrvUavHeap[MAX_GPUS];
 	DescriptorStoreHeap* pSamplerHeap[MAX_GPUS];
 	DescriptorBinderMap  mRootSignatureNodes;
-
+	/// Node of the last root signature bound through this binder to skip the map lookup for consecutive binds
+	const RootSignature*  pLastRootSignature;
+	DescriptorBinderNode* pLastNode;
 } DescriptorBinder;
 
 const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
@@ -809,6 +811,21 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 		return NULL;
 	}
 }
+
+const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t paramIndex, uint32_t* pIndex)
+{
+	if (pParam->pName)
+		return get_descriptor(pRootSignature, pParam->pName, pIndex);
+
+	if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+	{
+		LOGF(LogLevel::eERROR, "Descriptor at index (%u) has no name and an invalid descriptor index (%u)", paramIndex, pParam->mIndex);
+		return NULL;
+	}
+
+	*pIndex = pParam->mIndex;
+	return &pRootSignature->pDescriptors[pParam->mIndex];
+}
 /************************************************************************/
 // Get renderer shader macros
 /************************************************************************/
@@ -2380,8 +2397,6 @@ void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
 
 void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 {
-
-	UNREF_PARAM(secondary);
 	//verify that given pool is valid
 	ASSERT(pCmdPool);
 
@@ -2393,6 +2408,9 @@ void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 	pCmd->pRenderer = pCmdPool->pQueue->pRenderer;
 	pCmd->pCmdPool = pCmdPool;
 	pCmd->mNodeIndex = pCmdPool->pQueue->mQueueDesc.mNodeIndex;
+	// Secondary command buffers are regular command lists executed after the closed part of the primary
+	// (bundles cannot set their own descriptor heaps)
+	pCmd->mSecondary = secondary;
 
 	//add command to pool
 	//ASSERT(pCmdPool->pDxCmdAlloc);
@@ -2496,6 +2514,24 @@ void removeCmd(CmdPool* pCmdPool, Cmd* pCmd)
 	if (pCmd->pBoundSrgbValues)
 		SAFE_FREE(pCmd->pBoundSrgbValues);
 
+	// The first segment is the command list created in addCmd
+	if (pCmd->ppDxSegmentCmdLists)
+	{
+		for (uint32_t i = 0; i < pCmd->mSegmentCount; ++i)
+		{
+			SAFE_RELEASE(pCmd->ppDxSegmentCmdAllocs[i]);
+			SAFE_RELEASE(pCmd->ppDxSegmentCmdLists[i]);
+		}
+		SAFE_FREE(pCmd->ppDxSegmentCmdAllocs);
+		SAFE_FREE(pCmd->ppDxSegmentCmdLists);
+		pCmd->pDxCmdAlloc = NULL;
+		pCmd->pDxCmdList = NULL;
+	}
+	if (pCmd->ppDxSubmitCmdLists)
+		SAFE_FREE(pCmd->ppDxSubmitCmdLists);
+	if (pCmd->ppExecutedCmds)
+		SAFE_FREE(pCmd->ppExecutedCmds);
+
 	//remove command from pool
 	SAFE_RELEASE(pCmd->pDxCmdAlloc);
 	SAFE_RELEASE(pCmd->pDxCmdList);
@@ -4790,6 +4826,13 @@ void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
 
 	SAFE_FREE(pRootSignature);
 }
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	uint32_t index = UINT32_MAX;
+	get_descriptor(pRootSignature, pName, &index);
+	return index;
+}
 /************************************************************************/
 // Pipeline State Functions
 /************************************************************************/
@@ -5248,6 +5291,16 @@ void beginCmd(Cmd* pCmd)
 	ASSERT(pCmd->pDxCmdList);
 	ASSERT(pCmd->pDxCmdAlloc);
 
+	// Start over in the first segment
+	if (pCmd->ppDxSegmentCmdLists)
+	{
+		pCmd->pDxCmdAlloc = pCmd->ppDxSegmentCmdAllocs[0];
+		pCmd->pDxCmdList = pCmd->ppDxSegmentCmdLists[0];
+		pCmd->mUsedSegmentCount = 1;
+	}
+	pCmd->mSubmitCmdListCount = 0;
+	pCmd->mExecutedCmdCount = 0;
+
 	HRESULT hres = pCmd->pDxCmdAlloc->Reset();
 	ASSERT(SUCCEEDED(hres));
 
@@ -5290,6 +5343,118 @@ void endCmd(Cmd* pCmd)
 	ASSERT(SUCCEEDED(hres));
 }
 
+static void util_bind_inherited_render_targets(Cmd* pCmd)
+{
+	pCmd->pDxCmdList->OMSetRenderTargets(
+		pCmd->mBoundRenderTargetCount, pCmd->mBoundRtvs, FALSE, pCmd->mBoundDsv.ptr ? &pCmd->mBoundDsv : NULL);
+}
+
+void beginSecondaryCmd(Cmd* pCmd, Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+	ASSERT(pCmd->mSecondary && !pPrimaryCmd->mSecondary);
+	ASSERT(pCmd->pBoundColorFormats && pPrimaryCmd->pBoundColorFormats);
+
+	::beginCmd(pCmd);
+
+	memcpy(pCmd->pBoundColorFormats, pPrimaryCmd->pBoundColorFormats, sizeof(uint32_t) * MAX_RENDER_TARGET_ATTACHMENTS);
+	memcpy(pCmd->pBoundSrgbValues, pPrimaryCmd->pBoundSrgbValues, sizeof(bool) * MAX_RENDER_TARGET_ATTACHMENTS);
+	memcpy(pCmd->mBoundRtvs, pPrimaryCmd->mBoundRtvs, sizeof(pCmd->mBoundRtvs));
+	pCmd->mBoundDsv = pPrimaryCmd->mBoundDsv;
+	pCmd->mBoundDepthStencilFormat = pPrimaryCmd->mBoundDepthStencilFormat;
+	pCmd->mBoundRenderTargetCount = pPrimaryCmd->mBoundRenderTargetCount;
+	pCmd->mBoundSampleCount = pPrimaryCmd->mBoundSampleCount;
+	pCmd->mBoundSampleQuality = pPrimaryCmd->mBoundSampleQuality;
+	pCmd->mBoundWidth = pPrimaryCmd->mBoundWidth;
+	pCmd->mBoundHeight = pPrimaryCmd->mBoundHeight;
+	pCmd->mRenderPassHash = pPrimaryCmd->mRenderPassHash;
+
+	util_bind_inherited_render_targets(pCmd);
+}
+
+template <typename T>
+static T* util_reserve_array(T* pArray, uint32_t* pCapacity, uint32_t count)
+{
+	if (count <= *pCapacity)
+		return pArray;
+
+	*pCapacity = max(count, *pCapacity * 2);
+	return (T*)conf_realloc(pArray, *pCapacity * sizeof(T));
+}
+
+void cmdExecuteSecondaryCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppSecondaryCmds)
+{
+	ASSERT(pCmd);
+	ASSERT(pCmd->pDxCmdList);
+	ASSERT(!pCmd->mSecondary);
+
+	if (!cmdCount)
+		return;
+
+	// Close the current command list, the secondary command lists get executed right after it
+	::cmdFlushBarriers(pCmd);
+	HRESULT hres = pCmd->pDxCmdList->Close();
+	ASSERT(SUCCEEDED(hres));
+
+	pCmd->ppDxSubmitCmdLists =
+		util_reserve_array(pCmd->ppDxSubmitCmdLists, &pCmd->mSubmitCmdListCapacity, pCmd->mSubmitCmdListCount + cmdCount + 1);
+	pCmd->ppExecutedCmds = util_reserve_array(pCmd->ppExecutedCmds, &pCmd->mExecutedCmdCapacity, pCmd->mExecutedCmdCount + cmdCount);
+	pCmd->ppDxSubmitCmdLists[pCmd->mSubmitCmdListCount++] = pCmd->pDxCmdList;
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		ASSERT(ppSecondaryCmds[i]->mSecondary);
+		pCmd->ppDxSubmitCmdLists[pCmd->mSubmitCmdListCount++] = ppSecondaryCmds[i]->pDxCmdList;
+		pCmd->ppExecutedCmds[pCmd->mExecutedCmdCount++] = ppSecondaryCmds[i];
+	}
+
+	// Continue recording in the next segment
+	if (!pCmd->ppDxSegmentCmdLists)
+	{
+		pCmd->ppDxSegmentCmdAllocs = (ID3D12CommandAllocator**)conf_calloc(1, sizeof(ID3D12CommandAllocator*));
+		pCmd->ppDxSegmentCmdLists = (ID3D12GraphicsCommandList**)conf_calloc(1, sizeof(ID3D12GraphicsCommandList*));
+		pCmd->ppDxSegmentCmdAllocs[0] = pCmd->pDxCmdAlloc;
+		pCmd->ppDxSegmentCmdLists[0] = pCmd->pDxCmdList;
+		pCmd->mSegmentCount = 1;
+		pCmd->mUsedSegmentCount = 1;
+	}
+
+	if (pCmd->mUsedSegmentCount < pCmd->mSegmentCount)
+	{
+		pCmd->pDxCmdAlloc = pCmd->ppDxSegmentCmdAllocs[pCmd->mUsedSegmentCount];
+		pCmd->pDxCmdList = pCmd->ppDxSegmentCmdLists[pCmd->mUsedSegmentCount];
+		hres = pCmd->pDxCmdAlloc->Reset();
+		ASSERT(SUCCEEDED(hres));
+		hres = pCmd->pDxCmdList->Reset(pCmd->pDxCmdAlloc, NULL);
+		ASSERT(SUCCEEDED(hres));
+	}
+	else
+	{
+		const D3D12_COMMAND_LIST_TYPE type = gDx12CmdTypeTranslator[pCmd->pCmdPool->mCmdPoolDesc.mCmdPoolType];
+		hres = pCmd->pRenderer->pDxDevice->CreateCommandAllocator(type, __uuidof(pCmd->pDxCmdAlloc), (void**)&(pCmd->pDxCmdAlloc));
+		ASSERT(SUCCEEDED(hres));
+		// Created in the recording state
+		hres = pCmd->pRenderer->pDxDevice->CreateCommandList(
+			pCmd->pCmdPool->pQueue->pDxQueue->GetDesc().NodeMask, type, pCmd->pDxCmdAlloc, NULL, __uuidof(pCmd->pDxCmdList),
+			(void**)&(pCmd->pDxCmdList));
+		ASSERT(SUCCEEDED(hres));
+
+		pCmd->ppDxSegmentCmdAllocs = (ID3D12CommandAllocator**)conf_realloc(
+			pCmd->ppDxSegmentCmdAllocs, (pCmd->mSegmentCount + 1) * sizeof(ID3D12CommandAllocator*));
+		pCmd->ppDxSegmentCmdLists = (ID3D12GraphicsCommandList**)conf_realloc(
+			pCmd->ppDxSegmentCmdLists, (pCmd->mSegmentCount + 1) * sizeof(ID3D12GraphicsCommandList*));
+		pCmd->ppDxSegmentCmdAllocs[pCmd->mSegmentCount] = pCmd->pDxCmdAlloc;
+		pCmd->ppDxSegmentCmdLists[pCmd->mSegmentCount] = pCmd->pDxCmdList;
+		++pCmd->mSegmentCount;
+	}
+	++pCmd->mUsedSegmentCount;
+
+	// No state carries over into the new command list
+	pCmd->pBoundDescriptorBinder = NULL;
+	pCmd->pBoundDescriptorBinderNode = NULL;
+	util_bind_inherited_render_targets(pCmd);
+}
+
 #ifdef _DURANGO
 void endCmd(DmaCmd* pCmd)
 {
@@ -5335,6 +5500,7 @@ void cmdBindRenderTargets(
 		}
 
 		p_rtv_handles[i] = ppRenderTargets[i]->pDxDescriptors[handle];
+		pCmd->mBoundRtvs[i] = p_rtv_handles[i];
 		pCmd->pBoundColorFormats[i] = ppRenderTargets[i]->mDesc.mFormat;
 		pCmd->pBoundSrgbValues[i] = ppRenderTargets[i]->mDesc.mSrgb;
 		pCmd->mBoundWidth = ppRenderTargets[i]->mDesc.mWidth;
@@ -5380,6 +5546,7 @@ void cmdBindRenderTargets(
 	pCmd->mBoundSampleCount = sampleCount;
 	pCmd->mBoundRenderTargetCount = renderTargetCount;
 	pCmd->mRenderPassHash = renderPassHash;
+	pCmd->mBoundDsv.ptr = p_dsv_handle ? p_dsv_handle->ptr : 0;
 
 	pCmd->pDxCmdList->OMSetRenderTargets(renderTargetCount, p_rtv_handles, FALSE, p_dsv_handle);
 
@@ -5580,7 +5747,14 @@ void cmdBindDescriptors(
 	const uint32_t setCount = DESCRIPTOR_UPDATE_FREQ_COUNT;
 	const uint32_t frameIdx = pRenderer->mCurrentFrameIdx;
 
-	DescriptorBinderNode* node = &pDescriptorBinder->mRootSignatureNodes.find(pRootSignature)->second;
+	if (pDescriptorBinder->pLastRootSignature != pRootSignature)
+	{
+		DescriptorBinderMap::iterator it = pDescriptorBinder->mRootSignatureNodes.find(pRootSignature);
+		ASSERT(it != pDescriptorBinder->mRootSignatureNodes.end() && "Root signature was not specified in addDescriptorBinder");
+		pDescriptorBinder->pLastRootSignature = pRootSignature;
+		pDescriptorBinder->pLastNode = &it->second;
+	}
+	DescriptorBinderNode* node = pDescriptorBinder->pLastNode;
 
 	DescriptorStoreHeap* pCbvSrvUavHeap = pDescriptorBinder->pCbvSrvUavHeap[nodeIndex];
 	DescriptorStoreHeap* pSamplerHeap = pDescriptorBinder->pSamplerHeap[nodeIndex];
@@ -5648,14 +5822,9 @@ void cmdBindDescriptors(
 		const DescriptorData* pParam = &pDescParams[i];
 
 		ASSERT(pParam);
-		if (!pParam->pName)
-		{
-			LOGF(LogLevel::eERROR, "Name of Descriptor at index (%u) is NULL", i);
-			return;
-		}
 
 		uint32_t              descIndex = ~0u;
-		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, i, &descIndex);
 		if (!pDesc)
 			continue;
 
@@ -5667,7 +5836,7 @@ void cmdBindDescriptors(
 		{
 			if (!pParam->pRootConstant)
 			{
-				LOGF(LogLevel::eERROR, "Root constant (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Root constant (%s) is NULL", pDesc->mDesc.name);
 				continue;
 			}
 			if (pRootSignature->mPipelineType == PIPELINE_TYPE_COMPUTE)
@@ -5686,7 +5855,7 @@ void cmdBindDescriptors(
 		{
 			if (!pParam->ppBuffers[0])
 			{
-				LOGF(LogLevel::eERROR, "Root descriptor CBV (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Root descriptor CBV (%s) is NULL", pDesc->mDesc.name);
 				continue;
 			}
 			D3D12_GPU_VIRTUAL_ADDRESS cbv = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
@@ -5701,7 +5870,8 @@ void cmdBindDescriptors(
 				if (!pCmd->pRootConstantRingBuffer)
 				{
 					// 4KB ring buffer should be enough since size of root constant data is usually pretty small (< 32 bytes)
-					addUniformGPURingBuffer(pRenderer, 4000U, &pCmd->pRootConstantRingBuffer, true);
+					// Chain more pages instead of stalling if a cmd records a lot of root constants while previous submissions are in flight
+					addUniformGPURingBuffer(pRenderer, 4000U, &pCmd->pRootConstantRingBuffer, true, 4);
 				}
 				uint32_t            size = pDesc->mDesc.size * sizeof(uint32_t);
 				GPURingBufferOffset offset = getGPURingBufferOffset(pCmd->pRootConstantRingBuffer, size);
@@ -5752,19 +5922,19 @@ void cmdBindDescriptors(
 						LogLevel::eERROR,
 						"Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through "
 						"RootSignatureDesc::mStaticSamplers",
-						pParam->pName);
+						pDesc->mDesc.name);
 					continue;
 				}
 				if (!pParam->ppSamplers)
 				{
-					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				for (uint32_t j = 0; j < arrayCount; ++j)
 				{
 					if (!pParam->ppSamplers[j])
 					{
-						LOGF(LogLevel::eERROR, "Sampler descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Sampler descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 					pSamplerHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppSamplers[j]->mSamplerId, 1, pSamplerHash[setIndex]);
@@ -5777,7 +5947,7 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppTextures)
 				{
-					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				D3D12_CPU_DESCRIPTOR_HANDLE* handlePtr = &node->pViewDescriptorHandles[setIndex][pDesc->mHandleIndex];
@@ -5788,7 +5958,7 @@ void cmdBindDescriptors(
 #ifdef _DEBUG
 					if (!pParam->ppTextures[j])
 					{
-						LOGF(LogLevel::eERROR, "Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Texture descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 #endif
@@ -5806,7 +5976,7 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppTextures)
 				{
-					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				D3D12_CPU_DESCRIPTOR_HANDLE* handlePtr = &node->pViewDescriptorHandles[setIndex][pDesc->mHandleIndex];
@@ -5819,7 +5989,7 @@ void cmdBindDescriptors(
 #ifdef _DEBUG
 					if (!pParam->ppTextures[j])
 					{
-						LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 #endif
@@ -5837,14 +6007,14 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppBuffers)
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				for (uint32_t j = 0; j < arrayCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 					pCbvSrvUavHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppBuffers[j]->mBufferId, 1, pCbvSrvUavHash[setIndex]);
@@ -5868,14 +6038,14 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppBuffers)
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				for (uint32_t j = 0; j < arrayCount; ++j)
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 					pCbvSrvUavHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppBuffers[j]->mBufferId, 1, pCbvSrvUavHash[setIndex]);
@@ -5892,7 +6062,7 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppBuffers)
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 
@@ -5902,7 +6072,7 @@ void cmdBindDescriptors(
 				{
 					if (!pParam->ppBuffers[j])
 					{
-						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 
@@ -5944,14 +6114,14 @@ void cmdBindDescriptors(
 			{
 				if (!pParam->ppAccelerationStructures)
 				{
-					LOGF(LogLevel::eERROR, "Acceleration Structure descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Acceleration Structure descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				for (uint32_t j = 0; j < arrayCount; ++j)
 				{
 					if (!pParam->ppAccelerationStructures[j])
 					{
-						LOGF(LogLevel::eERROR, "Acceleration Structure descriptor (%s) at array index (%u) is NULL", pParam->pName, j);
+						LOGF(LogLevel::eERROR, "Acceleration Structure descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, j);
 						return;
 					}
 
@@ -6212,6 +6382,29 @@ void cmdResourceBarrier(
 		TextureBarrier*         pTransBarrier = &pTextureBarriers[i];
 		D3D12_RESOURCE_BARRIER* pBarrier = &barriers[transitionCount];
 		Texture*                pTexture = pTransBarrier->pTexture;
+		if (pTransBarrier->mSubresourceBarrier)
+		{
+			// The caller tracks the state of the subresource, the texture state stays untouched
+			if (pTransBarrier->mCurrentState != pTransBarrier->mNewState)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->Transition.pResource = pTexture->pDxResource;
+				pBarrier->Transition.Subresource = D3D12CalcSubresource(
+					pTransBarrier->mMipLevel, pTransBarrier->mArrayLayer, 0, pTexture->mDesc.mMipLevels, pTexture->mDesc.mArraySize);
+				pBarrier->Transition.StateBefore = util_to_dx_resource_state(pTransBarrier->mCurrentState);
+				pBarrier->Transition.StateAfter = util_to_dx_resource_state(pTransBarrier->mNewState);
+				++transitionCount;
+			}
+			else if (pTransBarrier->mCurrentState == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->UAV.pResource = pTexture->pDxResource;
+				++transitionCount;
+			}
+		}
+		else
 		{
 			if (pTexture->mCurrentState != pTransBarrier->mNewState)
 			{
@@ -6253,6 +6446,13 @@ void cmdResourceBarrier(
 					++transitionCount;
 				}
 			}
+			else if (pTexture->mCurrentState == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->UAV.pResource = pTexture->pDxResource;
+				++transitionCount;
+			}
 		}
 	}
 
@@ -6348,6 +6548,29 @@ void cmdResourceBarrier(
 		TextureBarrier*         pTransBarrier = &pTextureBarriers[i];
 		D3D12_RESOURCE_BARRIER* pBarrier = &barriers[transitionCount];
 		Texture*                pTexture = pTransBarrier->pTexture;
+		if (pTransBarrier->mSubresourceBarrier)
+		{
+			// The caller tracks the state of the subresource, the texture state stays untouched
+			if (pTransBarrier->mCurrentState != pTransBarrier->mNewState)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->Transition.pResource = pTexture->pDxResource;
+				pBarrier->Transition.Subresource = D3D12CalcSubresource(
+					pTransBarrier->mMipLevel, pTransBarrier->mArrayLayer, 0, pTexture->mDesc.mMipLevels, pTexture->mDesc.mArraySize);
+				pBarrier->Transition.StateBefore = util_to_dx_resource_state(pTransBarrier->mCurrentState);
+				pBarrier->Transition.StateAfter = util_to_dx_resource_state(pTransBarrier->mNewState);
+				++transitionCount;
+			}
+			else if (pTransBarrier->mCurrentState == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->UAV.pResource = pTexture->pDxResource;
+				++transitionCount;
+			}
+		}
+		else
 		{
 			if (pTexture->mCurrentState != pTransBarrier->mNewState)
 			{
@@ -6389,6 +6612,13 @@ void cmdResourceBarrier(
 					++transitionCount;
 				}
 			}
+			else if (pTexture->mCurrentState == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				pBarrier->UAV.pResource = pTexture->pDxResource;
+				++transitionCount;
+			}
 		}
 	}
 
@@ -6629,22 +6859,42 @@ void queueSubmit(
 	ASSERT(pQueue->pDxQueue);
 
 	cmdCount = cmdCount > MAX_SUBMIT_CMDS ? MAX_SUBMIT_CMDS : cmdCount;
-	ID3D12CommandList** cmds = (ID3D12CommandList**)alloca(cmdCount * sizeof(ID3D12CommandList*));
+	// Command buffers which executed secondary command buffers consist of several command lists
+	uint32_t cmdListCount = 0;
+	for (uint32_t i = 0; i < cmdCount; ++i)
+		cmdListCount += ppCmds[i]->mSubmitCmdListCount + 1;
+
+	ID3D12CommandList** cmds = (ID3D12CommandList**)alloca(cmdListCount * sizeof(ID3D12CommandList*));
+	cmdListCount = 0;
 	for (uint32_t i = 0; i < cmdCount; ++i)
 	{
-		cmds[i] = ppCmds[i]->pDxCmdList;
+		for (uint32_t j = 0; j < ppCmds[i]->mSubmitCmdListCount; ++j)
+			cmds[cmdListCount++] = ppCmds[i]->ppDxSubmitCmdLists[j];
+		cmds[cmdListCount++] = ppCmds[i]->pDxCmdList;
 	}
 
 	for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
 		pQueue->pDxQueue->Wait(ppWaitSemaphores[i]->pFence->pDxFence, ppWaitSemaphores[i]->pFence->mFenceValue - 1);
 
-	pQueue->pDxQueue->ExecuteCommandLists(cmdCount, cmds);
+	pQueue->pDxQueue->ExecuteCommandLists(cmdListCount, cmds);
 
 	if (pFence)
 		pQueue->pDxQueue->Signal(pFence->pDxFence, pFence->mFenceValue++);
 
 	for (uint32_t i = 0; i < signalSemaphoreCount; ++i)
 		pQueue->pDxQueue->Signal(ppSignalSemaphores[i]->pFence->pDxFence, ppSignalSemaphores[i]->pFence->mFenceValue++);
+
+	// Root constant data recorded into these cmds has to stay untouched until pFence completed
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		if (ppCmds[i]->pRootConstantRingBuffer)
+			markGPURingBufferFrame(ppCmds[i]->pRootConstantRingBuffer, pFence);
+		for (uint32_t j = 0; j < ppCmds[i]->mExecutedCmdCount; ++j)
+		{
+			if (ppCmds[i]->ppExecutedCmds[j]->pRootConstantRingBuffer)
+				markGPURingBufferFrame(ppCmds[i]->ppExecutedCmds[j]->pRootConstantRingBuffer, pFence);
+		}
+	}
 }
 #ifdef _DURANGO
 void queueSubmit(
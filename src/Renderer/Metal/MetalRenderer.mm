@@ -484,6 +484,21 @@ const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const
 	}
 }
 
+const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t paramIndex, uint32_t* pIndex)
+{
+	if (pParam->pName)
+		return get_descriptor(pRootSignature, pParam->pName, pIndex);
+
+	if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+	{
+		LOGF(LogLevel::eERROR, "Descriptor at index (%u) has no name and an invalid descriptor index (%u)", paramIndex, pParam->mIndex);
+		return NULL;
+	}
+
+	*pIndex = pParam->mIndex;
+	return &pRootSignature->pDescriptors[pParam->mIndex];
+}
+
 /************************************************************************/
 // Get renderer shader macros
 /************************************************************************/
@@ -615,21 +630,15 @@ void cmdBindLocalDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, Roo
 	{
 		const DescriptorData* pParam = &pDescParams[paramIdx];
 		ASSERT(pParam);
-		if (!pParam->pName)
-		{
-			LOGF(LogLevel::eERROR, "Name of Descriptor at index (%u) is NULL", paramIdx);
-			return;
-		}
-
 		uint32_t descIndex = -1;
-		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, paramIdx, &descIndex);
 		if (!pDesc)
 			continue;
 
 		const uint32_t arrayCount = max(1U, pParam->mCount);
 
 		// Replace the default DescriptorData by the new data pased into this function.
-		node.pDescriptorDataArray[descIndex].pName = pParam->pName;
+		node.pDescriptorDataArray[descIndex].pName = pDesc->mDesc.name;
 		node.pDescriptorDataArray[descIndex].mCount = arrayCount;
 		node.pDescriptorDataArray[descIndex].pOffsets = pParam->pOffsets;
 		switch(pDesc->mDesc.type)
@@ -637,21 +646,21 @@ void cmdBindLocalDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, Roo
 			case DESCRIPTOR_TYPE_RW_TEXTURE:
 			case DESCRIPTOR_TYPE_TEXTURE:
 				if (!pParam->ppTextures) {
-					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppTextures = pParam->ppTextures;
 				break;
 			case DESCRIPTOR_TYPE_SAMPLER:
 				if (!pParam->ppSamplers) {
-					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppSamplers = pParam->ppSamplers;
 				break;
 			case DESCRIPTOR_TYPE_ROOT_CONSTANT:
 				if (!pParam->pRootConstant) {
-					LOGF(LogLevel::eERROR, "RootConstant array (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "RootConstant array (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].pRootConstant = pParam->pRootConstant;
@@ -660,13 +669,13 @@ void cmdBindLocalDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, Roo
 			case DESCRIPTOR_TYPE_RW_BUFFER:
 			case DESCRIPTOR_TYPE_BUFFER:
 				if (!pParam->ppBuffers) {
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppBuffers = pParam->ppBuffers;
 
 				// In case we're binding an argument buffer, signal that we need to re-encode the resources into the buffer.
-				if(arrayCount > 1 && node.mArgumentBuffers.find(pParam->pName) != node.mArgumentBuffers.end()) node.mArgumentBuffers[pParam->pName].mNeedsReencoding = true;
+				if(arrayCount > 1 && node.mArgumentBuffers.find(pDesc->mDesc.name) != node.mArgumentBuffers.end()) node.mArgumentBuffers[pDesc->mDesc.name].mNeedsReencoding = true;
 
 				break;
 			default: break;
@@ -926,21 +935,15 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 	{
 		const DescriptorData* pParam = &pDescParams[paramIdx];
 		ASSERT(pParam);
-		if (!pParam->pName)
-		{
-			LOGF(LogLevel::eERROR, "Name of Descriptor at index (%u) is NULL", paramIdx);
-			return;
-		}
-
 		uint32_t              descIndex = -1;
-		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName, &descIndex);
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, paramIdx, &descIndex);
 		if (!pDesc)
 			continue;
 
 		const uint32_t arrayCount = max(1U, pParam->mCount);
 
 		// Replace the default DescriptorData by the new data pased into this function.
-		node.pDescriptorDataArray[descIndex].pName = pParam->pName;
+		node.pDescriptorDataArray[descIndex].pName = pDesc->mDesc.name;
 		node.pDescriptorDataArray[descIndex].mCount = arrayCount;
 		node.pDescriptorDataArray[descIndex].pOffsets = pParam->pOffsets;
 		switch (pDesc->mDesc.type)
@@ -949,7 +952,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			case DESCRIPTOR_TYPE_TEXTURE:
 				if (!pParam->ppTextures)
 				{
-					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppTextures = pParam->ppTextures;
@@ -957,7 +960,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			case DESCRIPTOR_TYPE_SAMPLER:
 				if (!pParam->ppSamplers)
 				{
-					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppSamplers = pParam->ppSamplers;
@@ -965,7 +968,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			case DESCRIPTOR_TYPE_ROOT_CONSTANT:
 				if (!pParam->pRootConstant)
 				{
-					LOGF(LogLevel::eERROR, "RootConstant array (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "RootConstant array (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].pRootConstant = pParam->pRootConstant;
@@ -975,14 +978,14 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			case DESCRIPTOR_TYPE_BUFFER:
 				if (!pParam->ppBuffers)
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 					return;
 				}
 				node.pDescriptorDataArray[descIndex].ppBuffers = pParam->ppBuffers;
 
 				// In case we're binding an argument buffer, signal that we need to re-encode the resources into the buffer.
-				if (arrayCount > 1 && node.mArgumentBuffers.find(pParam->pName) != node.mArgumentBuffers.end())
-					node.mArgumentBuffers[pParam->pName].mNeedsReencoding = true;
+				if (arrayCount > 1 && node.mArgumentBuffers.find(pDesc->mDesc.name) != node.mArgumentBuffers.end())
+					node.mArgumentBuffers[pDesc->mDesc.name].mNeedsReencoding = true;
 
 				break;
 			default: break;
@@ -1691,6 +1694,7 @@ void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 
 	pCmd->pRenderer = pCmdPool->pQueue->pRenderer;
 	pCmd->pCmdPool = pCmdPool;
+	pCmd->mSecondary = secondary;
 	pCmd->mtlEncoderFence = [pCmd->pRenderer->pDevice newFence];
 
 	if (pCmdPool->mCmdPoolDesc.mCmdPoolType == CMD_POOL_DIRECT)
@@ -2385,6 +2389,13 @@ void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
 	SAFE_FREE(pRootSignature);
 }
 
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	uint32_t index = UINT32_MAX;
+	get_descriptor(pRootSignature, pName, &index);
+	return index;
+}
+
 uint32_t util_calculate_vertex_layout_stride(const VertexLayout* pVertexLayout)
 {
 	ASSERT(pVertexLayout);
@@ -2791,7 +2802,9 @@ void beginCmd(Cmd* pCmd)
 	@autoreleasepool
 	{
 		ASSERT(pCmd);
+		ASSERT(!pCmd->mSecondary);
 		pCmd->mtlRenderEncoder = nil;
+		pCmd->mtlParallelRenderEncoder = nil;
 		pCmd->mtlComputeEncoder = nil;
 		pCmd->mtlBlitEncoder = nil;
 		pCmd->pShader = nil;
@@ -2805,6 +2818,21 @@ void beginCmd(Cmd* pCmd)
 
 void endCmd(Cmd* pCmd)
 {
+	if (pCmd->mSecondary)
+	{
+		if (pCmd->pBoundDescriptorBinder && pCmd->pBoundRootSignature)
+			reset_bound_resources(pCmd->pBoundDescriptorBinder, pCmd->pBoundRootSignature);
+
+		// The primary takes care of the encoder fence once the parallel encoder ends
+		@autoreleasepool
+		{
+			[pCmd->mtlRenderEncoder endEncoding];
+			pCmd->mtlRenderEncoder = nil;
+		}
+		pCmd->mRenderPassActive = false;
+		return;
+	}
+
 	if (pCmd->mRenderPassActive)
 	{
 		// Reset the bound resources flags for the current root signature's descriptor binder.
@@ -2830,11 +2858,69 @@ void endCmd(Cmd* pCmd)
 	}
 }
 
+void beginSecondaryCmd(Cmd* pCmd, Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+	ASSERT(pCmd->mSecondary && !pPrimaryCmd->mSecondary);
+	ASSERT(pPrimaryCmd->mtlParallelRenderEncoder != nil && "Render targets not bound with LoadActionsDesc::mSecondaryCmds");
+
+	@autoreleasepool
+	{
+		pCmd->mtlComputeEncoder = nil;
+		pCmd->mtlBlitEncoder = nil;
+		pCmd->pShader = nil;
+		pCmd->selectedIndexBuffer = nil;
+		pCmd->pBoundDescriptorBinder = nil;
+		pCmd->pBoundRootSignature = nil;
+		pCmd->mtlCommandBuffer = pPrimaryCmd->mtlCommandBuffer;
+		pCmd->pRenderPassDesc = pPrimaryCmd->pRenderPassDesc;
+		// Sub encoders execute in the order they are created
+		pCmd->mtlRenderEncoder = [pPrimaryCmd->mtlParallelRenderEncoder renderCommandEncoder];
+		if (pCmd->pCmdPool->pQueue->mBarrierFlags & BARRIER_FLAG_FENCE)
+			[pCmd->mtlRenderEncoder waitForFence:pPrimaryCmd->mtlEncoderFence beforeStages:MTLRenderStageVertex];
+	}
+
+	memcpy(pCmd->pBoundColorFormats, pPrimaryCmd->pBoundColorFormats, sizeof(uint32_t) * MAX_RENDER_TARGET_ATTACHMENTS);
+	memcpy(pCmd->pBoundSrgbValues, pPrimaryCmd->pBoundSrgbValues, sizeof(bool) * MAX_RENDER_TARGET_ATTACHMENTS);
+	pCmd->mBoundDepthStencilFormat = pPrimaryCmd->mBoundDepthStencilFormat;
+	pCmd->mBoundRenderTargetCount = pPrimaryCmd->mBoundRenderTargetCount;
+	pCmd->mBoundSampleCount = pPrimaryCmd->mBoundSampleCount;
+	pCmd->mBoundWidth = pPrimaryCmd->mBoundWidth;
+	pCmd->mBoundHeight = pPrimaryCmd->mBoundHeight;
+	pCmd->mRenderPassHash = pPrimaryCmd->mRenderPassHash;
+	pCmd->mRenderPassActive = true;
+}
+
+void cmdExecuteSecondaryCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppSecondaryCmds)
+{
+	ASSERT(pCmd);
+	ASSERT(!pCmd->mSecondary);
+	ASSERT(pCmd->mtlParallelRenderEncoder != nil);
+#if defined(_DEBUG)
+	for (uint32_t i = 0; i < cmdCount; ++i)
+		ASSERT(ppSecondaryCmds[i]->mSecondary && ppSecondaryCmds[i]->mtlRenderEncoder == nil && "Secondary command buffer not ended");
+#endif
+
+	// The sub encoders of the secondaries already run in order inside the parallel encoder.
+	// Later commands of the primary go to a new sub encoder after them
+	@autoreleasepool
+	{
+		if (pCmd->mtlRenderEncoder != nil)
+			[pCmd->mtlRenderEncoder endEncoding];
+		pCmd->mtlRenderEncoder = [pCmd->mtlParallelRenderEncoder renderCommandEncoder];
+	}
+	pCmd->pBoundDescriptorBinder = nil;
+	pCmd->pBoundRootSignature = nil;
+	pCmd->pShader = nil;
+}
+
 void cmdBindRenderTargets(
 	Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil, const LoadActionsDesc* pLoadActions,
 	uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice, uint32_t depthMipSlice)
 {
 	ASSERT(pCmd);
+	ASSERT(!pCmd->mSecondary);
 
 	if (pCmd->mRenderPassActive)
 	{
@@ -3005,9 +3091,19 @@ void cmdBindRenderTargets(
 		pCmd->mBoundHeight = renderTargetCount ? ppRenderTargets[0]->mDesc.mHeight : pDepthStencil->mDesc.mHeight;
 		pCmd->mBoundSampleCount = sampleCount;
 		pCmd->mBoundRenderTargetCount = renderTargetCount;
+		pCmd->mRenderPassHash = renderPassHash;
 
 		util_end_current_encoders(pCmd);
-		pCmd->mtlRenderEncoder = [pCmd->mtlCommandBuffer renderCommandEncoderWithDescriptor:pCmd->pRenderPassDesc];
+		if (pLoadActions && pLoadActions->mSecondaryCmds)
+		{
+			pCmd->mtlParallelRenderEncoder = [pCmd->mtlCommandBuffer parallelRenderCommandEncoderWithDescriptor:pCmd->pRenderPassDesc];
+			// Commands recorded on the primary before cmdExecuteSecondaryCmds come first
+			pCmd->mtlRenderEncoder = [pCmd->mtlParallelRenderEncoder renderCommandEncoder];
+		}
+		else
+		{
+			pCmd->mtlRenderEncoder = [pCmd->mtlCommandBuffer renderCommandEncoderWithDescriptor:pCmd->pRenderPassDesc];
+		}
 
 		pCmd->mRenderPassActive = true;
 	}
@@ -3442,21 +3538,24 @@ void cmdResourceBarrier(
         {
             TextureBarrier* pTrans = &pTextureBarriers[i];
             Texture*        pTexture = pTrans->pTexture;
+            // Subresource states are tracked by the caller
+            ResourceState   currentState = pTrans->mSubresourceBarrier ? pTrans->mCurrentState : pTexture->mCurrentState;
             
-            if (!(pTrans->mNewState & pTexture->mCurrentState) || pTexture->mCurrentState == RESOURCE_STATE_UNORDERED_ACCESS)
+            if (!(pTrans->mNewState & currentState) || currentState == RESOURCE_STATE_UNORDERED_ACCESS)
             {
 				if (pTrans->mNewState == RESOURCE_STATE_DEPTH_WRITE ||
 					pTrans->mNewState == RESOURCE_STATE_DEPTH_READ ||
 					pTrans->mNewState == RESOURCE_STATE_RENDER_TARGET ||
-					pTexture->mCurrentState == RESOURCE_STATE_DEPTH_WRITE ||
-					pTexture->mCurrentState == RESOURCE_STATE_DEPTH_READ ||
-					pTexture->mCurrentState == RESOURCE_STATE_RENDER_TARGET)
+					currentState == RESOURCE_STATE_DEPTH_WRITE ||
+					currentState == RESOURCE_STATE_DEPTH_READ ||
+					currentState == RESOURCE_STATE_RENDER_TARGET)
 				{
 					pCmd->pCmdPool->pQueue->mBarrierFlags |= BARRIER_FLAG_RENDERTARGETS;
 				}
 				
 				pCmd->pCmdPool->pQueue->mBarrierFlags |= BARRIER_FLAG_TEXTURES;
-                pTexture->mCurrentState = pTrans->mNewState;
+				if (!pTrans->mSubresourceBarrier)
+					pTexture->mCurrentState = pTrans->mNewState;
             }
         }
     }
@@ -4169,6 +4268,12 @@ void util_end_current_encoders(Cmd* pCmd)
 		[pCmd->mtlRenderEncoder endEncoding];
 		pCmd->mtlRenderEncoder = nil;
 	}
+
+	if (pCmd->mtlParallelRenderEncoder != nil)
+	{
+		[pCmd->mtlParallelRenderEncoder endEncoding];
+		pCmd->mtlParallelRenderEncoder = nil;
+	}
 	
 	if (pCmd->mtlComputeEncoder != nil)
 	{
@@ -4201,6 +4306,10 @@ void util_end_current_encoders(Cmd* pCmd)
 
 void util_barrier_required(Cmd* pCmd, const CmdPoolType& encoderType)
 {
+	// Secondaries are recorded concurrently and cannot issue barriers, beginSecondaryCmd waited for the pending fence
+	if (pCmd->mSecondary)
+		return;
+
 	if (pCmd->pCmdPool->pQueue->mBarrierFlags)
 	{
 		if (pCmd->pCmdPool->pQueue->mBarrierFlags & BARRIER_FLAG_FENCE)
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "IRenderer.h"
+
+/* Compact binary command stream recorded by the null renderer.
+ * Every command is a NullCmdHeader followed by its payload. Payload sizes are padded to 8 bytes so
+ * pointers and 64 bit values inside the stream stay naturally aligned.
+ * Commands which produce visible memory writes (buffer / texture updates, queries) are replayed on queueSubmit.
+ * All other commands are validated when they are recorded and only walked over on submission.
+ */
+
+enum NullCmdType
+{
+	NULL_CMD_TYPE_cmdBindRenderTargets,
+	NULL_CMD_TYPE_cmdSetViewport,
+	NULL_CMD_TYPE_cmdSetScissor,
+	NULL_CMD_TYPE_cmdBindPipeline,
+	NULL_CMD_TYPE_cmdBindDescriptors,
+	NULL_CMD_TYPE_cmdBindIndexBuffer,
+	NULL_CMD_TYPE_cmdBindVertexBuffer,
+	NULL_CMD_TYPE_cmdDraw,
+	NULL_CMD_TYPE_cmdDrawIndexed,
+	NULL_CMD_TYPE_cmdDispatch,
+	NULL_CMD_TYPE_cmdResourceBarrier,
+	NULL_CMD_TYPE_cmdExecuteIndirect,
+	NULL_CMD_TYPE_cmdBeginQuery,
+	NULL_CMD_TYPE_cmdEndQuery,
+	NULL_CMD_TYPE_cmdResolveQuery,
+	NULL_CMD_TYPE_cmdBeginDebugMarker,
+	NULL_CMD_TYPE_cmdEndDebugMarker,
+	NULL_CMD_TYPE_cmdAddDebugMarker,
+	NULL_CMD_TYPE_cmdUpdateBuffer,
+	NULL_CMD_TYPE_cmdUpdateSubresource,
+	NULL_CMD_TYPE_cmdExecuteSecondaryCmds,
+	NULL_CMD_TYPE_COUNT
+};
+
+struct NullCmdHeader
+{
+	uint32_t mType;
+	/// Size of the payload following this header (in bytes)
+	uint32_t mSize;
+};
+
+/// Followed by mRenderTargetCount RenderTarget pointers
+struct NullBindRenderTargetsCmd
+{
+	RenderTarget* pDepthStencil;
+	uint32_t      mRenderTargetCount;
+	/// Bit i is set if color attachment i is cleared, bit 31 is set if the depth attachment is cleared
+	uint32_t mClearMask;
+};
+
+struct NullSetViewportCmd
+{
+	float x;
+	float y;
+	float width;
+	float height;
+	float minDepth;
+	float maxDepth;
+};
+
+struct NullSetScissorCmd
+{
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct NullBindPipelineCmd
+{
+	Pipeline* pPipeline;
+};
+
+/// Followed by mDescriptorCount NullDescriptorUpdate blocks
+struct NullBindDescriptorsCmd
+{
+	RootSignature* pRootSignature;
+	uint32_t       mDescriptorCount;
+	uint32_t       mPadding;
+};
+
+/// Followed by either mCount resource handles (8 bytes each) or mRootConstantSize bytes of constant data
+struct NullDescriptorUpdate
+{
+	/// Index of the descriptor in RootSignature::pDescriptors
+	uint32_t mIndex;
+	uint32_t mCount;
+	uint32_t mRootConstantSize;
+	uint32_t mUAVMipSlice;
+};
+
+struct NullBindIndexBufferCmd
+{
+	Buffer*  pBuffer;
+	uint64_t mOffset;
+};
+
+/// Followed by mBufferCount (Buffer*, offset) pairs
+struct NullBindVertexBufferCmd
+{
+	uint32_t mBufferCount;
+	uint32_t mPadding;
+};
+
+struct NullDrawCmd
+{
+	uint32_t mVertexCount;
+	uint32_t mFirstVertex;
+	uint32_t mInstanceCount;
+	uint32_t mFirstInstance;
+};
+
+struct NullDrawIndexedCmd
+{
+	uint32_t mIndexCount;
+	uint32_t mFirstIndex;
+	uint32_t mInstanceCount;
+	uint32_t mFirstVertex;
+	uint32_t mFirstInstance;
+	uint32_t mPadding;
+};
+
+struct NullDispatchCmd
+{
+	uint32_t mGroupCountX;
+	uint32_t mGroupCountY;
+	uint32_t mGroupCountZ;
+	uint32_t mPadding;
+};
+
+struct NullResourceBarrierCmd
+{
+	uint32_t mBufferBarrierCount;
+	uint32_t mTextureBarrierCount;
+};
+
+struct NullExecuteIndirectCmd
+{
+	CommandSignature* pCommandSignature;
+	Buffer*           pIndirectBuffer;
+	uint64_t          mBufferOffset;
+	Buffer*           pCounterBuffer;
+	uint64_t          mCounterBufferOffset;
+	uint32_t          mMaxCommandCount;
+	uint32_t          mPadding;
+};
+
+struct NullQueryCmd
+{
+	QueryHeap* pQueryHeap;
+	uint32_t   mIndex;
+	uint32_t   mPadding;
+};
+
+struct NullResolveQueryCmd
+{
+	QueryHeap* pQueryHeap;
+	Buffer*    pReadbackBuffer;
+	uint32_t   mStartQuery;
+	uint32_t   mQueryCount;
+};
+
+/// Followed by the null terminated marker name
+struct NullDebugMarkerCmd
+{
+	float    r;
+	float    g;
+	float    b;
+	uint32_t mNameLength;
+};
+
+struct NullUpdateBufferCmd
+{
+	Buffer*  pBuffer;
+	Buffer*  pSrcBuffer;
+	uint64_t mDstOffset;
+	uint64_t mSrcOffset;
+	uint64_t mSize;
+};
+
+struct NullUpdateSubresourceCmd
+{
+	Texture*            pTexture;
+	Buffer*             pSrcBuffer;
+	SubresourceDataDesc mSubresourceDesc;
+};
+
+/// Followed by mCmdCount Cmd pointers. The streams of the secondaries are replayed in place
+struct NullExecuteSecondaryCmdsCmd
+{
+	uint32_t mCmdCount;
+	uint32_t mPadding;
+};
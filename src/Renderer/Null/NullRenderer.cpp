@@ -0,0 +1,1945 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+/* Headless null renderer.
+ * Implements the full renderer interface without a GPU: buffers and textures are backed by system memory,
+ * command buffers record into a compact binary stream (see NullCommands.h) which is validated at record time
+ * and replayed on queueSubmit, and fences complete after a configurable simulated latency.
+ * Shaders are consumed as SPIR-V so reflection and root signature layouts match the Vulkan backend.
+ */
+
+#ifdef NULL_RENDERER
+#define RENDERER_IMPLEMENTATION
+
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+#include "IRenderer.h"
+#include "Interfaces/ILog.h"
+#include "Interfaces/IThread.h"
+#include "Interfaces/ITime.h"
+#include "OS/Core/Atomics.h"
+#include "Image/Image.h"
+#include "NullCommands.h"
+
+#if defined(__linux__)
+#define stricmp(a, b) strcasecmp(a, b)
+#endif
+
+#include "Interfaces/IMemory.h"
+
+extern void vk_createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, ShaderStage shaderStage, ShaderReflection* pOutReflection);
+
+#define SAFE_FREE(p_var)         \
+	if (p_var)                   \
+	{                            \
+		conf_free((void*)p_var); \
+	}
+
+// Functions not exposed in IRenderer but still need to be assigned when using runtime switch of renderers
+#if !defined(ENABLE_RENDERER_RUNTIME_SWITCH)
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer);
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture);
+void removeTexture(Renderer* pRenderer, Texture* pTexture);
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
+void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, SubresourceDataDesc* pSubresourceDesc);
+const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRenderer);
+#endif
+/************************************************************************/
+// Globals
+/************************************************************************/
+static const uint32_t  SPIRV_MAGIC = 0x07230203;
+static const uint64_t  INITIAL_CMD_STREAM_CAPACITY = 4096;
+static const uint32_t  NULL_RESOURCE_ALIGNMENT = 256;
+
+static tfrg_atomic64_t gBufferIds = 0;
+static tfrg_atomic64_t gTextureIds = 0;
+static tfrg_atomic64_t gSamplerIds = 0;
+// Total system memory currently backing buffers and textures (reported by calculateMemoryStats)
+static tfrg_atomic64_t gAllocatedBytes = 0;
+/************************************************************************/
+// Internal utility functions
+/************************************************************************/
+static void* util_allocate_resource_memory(uint64_t size)
+{
+	if (!size)
+		return NULL;
+
+	void* pMemory = conf_memalign(NULL_RESOURCE_ALIGNMENT, (size_t)size);
+	ASSERT(pMemory);
+	memset(pMemory, 0, (size_t)size);
+	tfrg_atomic64_add_relaxed(&gAllocatedBytes, size);
+	return pMemory;
+}
+
+static void util_free_resource_memory(void* pMemory, uint64_t size)
+{
+	if (!pMemory)
+		return;
+
+	tfrg_atomic64_add_relaxed(&gAllocatedBytes, (uint64_t)(-(int64_t)size));
+	conf_free(pMemory);
+}
+
+// Layout of a single mip level inside the texture memory (tightly packed rows of blocks)
+static uint64_t util_get_mip_layout(const TextureDesc* pDesc, uint32_t mipLevel, uint32_t* pRowPitch, uint32_t* pRowCount, uint32_t* pDepth)
+{
+	const uint3    blockDim = ImageFormat::GetBlockSize(pDesc->mFormat);
+	const uint32_t bytesPerBlock = (uint32_t)ImageFormat::GetBytesPerBlock(pDesc->mFormat);
+	const uint32_t width = max(1U, pDesc->mWidth >> mipLevel);
+	const uint32_t height = max(1U, pDesc->mHeight >> mipLevel);
+	const uint32_t depth = max(1U, pDesc->mDepth >> mipLevel);
+	const uint32_t rowPitch = ((width + blockDim.x - 1) / blockDim.x) * bytesPerBlock;
+	const uint32_t rowCount = (height + blockDim.y - 1) / blockDim.y;
+
+	if (pRowPitch)
+		*pRowPitch = rowPitch;
+	if (pRowCount)
+		*pRowCount = rowCount;
+	if (pDepth)
+		*pDepth = depth;
+
+	return (uint64_t)rowPitch * rowCount * depth;
+}
+
+// Subresources are laid out array layer by array layer, each layer containing its full mip chain
+static uint64_t util_get_subresource_offset(const Texture* pTexture, uint32_t arrayLayer, uint32_t mipLevel)
+{
+	uint64_t layerSize = 0;
+	uint64_t mipOffset = 0;
+	for (uint32_t i = 0; i < pTexture->mDesc.mMipLevels; ++i)
+	{
+		if (i == mipLevel)
+			mipOffset = layerSize;
+		layerSize += util_get_mip_layout(&pTexture->mDesc, i, NULL, NULL, NULL);
+	}
+
+	return arrayLayer * layerSize + mipOffset;
+}
+
+template <typename T>
+static T* util_record_cmd(Cmd* pCmd, NullCmdType type, uint32_t extraSize = 0)
+{
+	const uint32_t payloadSize = round_up((uint32_t)sizeof(T) + extraSize, 8);
+	const uint64_t requiredSize = pCmd->mCmdStreamSize + sizeof(NullCmdHeader) + payloadSize;
+	if (requiredSize > pCmd->mCmdStreamCapacity)
+	{
+		uint64_t newCapacity = max(pCmd->mCmdStreamCapacity * 2, INITIAL_CMD_STREAM_CAPACITY);
+		while (newCapacity < requiredSize)
+			newCapacity *= 2;
+
+		pCmd->pCmdStream = (uint8_t*)conf_realloc(pCmd->pCmdStream, (size_t)newCapacity);
+		ASSERT(pCmd->pCmdStream);
+		pCmd->mCmdStreamCapacity = newCapacity;
+	}
+
+	NullCmdHeader* pHeader = (NullCmdHeader*)(pCmd->pCmdStream + pCmd->mCmdStreamSize);
+	pHeader->mType = type;
+	pHeader->mSize = payloadSize;
+	pCmd->mCmdStreamSize = requiredSize;
+	++pCmd->mCmdCount;
+
+	T* pPayload = (T*)(pHeader + 1);
+	memset(pPayload, 0, payloadSize);
+	return pPayload;
+}
+
+static bool util_is_recording(const Cmd* pCmd)
+{
+	ASSERT(pCmd);
+	if (!pCmd->mRecording)
+	{
+		LOGF(LogLevel::eERROR, "beginCmd was never called for that specific Cmd buffer!");
+		return false;
+	}
+	return true;
+}
+
+static bool util_validate_draw(const Cmd* pCmd)
+{
+	if (!util_is_recording(pCmd))
+		return false;
+	if (!pCmd->pBoundPipeline || pCmd->pBoundPipeline->mType != PIPELINE_TYPE_GRAPHICS)
+	{
+		LOGF(LogLevel::eERROR, "Draw recorded without a graphics pipeline bound");
+		return false;
+	}
+	if (!pCmd->mRenderPassActive)
+	{
+		LOGF(LogLevel::eERROR, "Draw recorded without render targets bound");
+		return false;
+	}
+	return true;
+}
+
+static void util_wait_until(int64_t completionTime)
+{
+	int64_t now = getUSec();
+	while (now < completionTime)
+	{
+		// Sleep for most of the remaining time and spin for the last millisecond to keep the simulated latency accurate
+		const int64_t remaining = completionTime - now;
+		if (remaining > 2000)
+			Thread::Sleep((unsigned)(remaining / 1000) - 1);
+		now = getUSec();
+	}
+}
+
+static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
+{
+	using DescriptorNameToIndexMap = eastl::string_hash_map<uint32_t>;
+	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(pResName);
+	if (it != pRootSignature->pDescriptorNameToIndexMap.end())
+	{
+		*pIndex = it->second;
+		return &pRootSignature->pDescriptors[it->second];
+	}
+	else
+	{
+		LOGF(LogLevel::eERROR, "Invalid descriptor param (%s)", pResName);
+		return NULL;
+	}
+}
+
+static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t paramIndex, uint32_t* pIndex)
+{
+	if (pParam->pName)
+		return get_descriptor(pRootSignature, pParam->pName, pIndex);
+
+	if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+	{
+		LOGF(LogLevel::eERROR, "Descriptor at index (%u) has no name and an invalid descriptor index (%u)", paramIndex, pParam->mIndex);
+		return NULL;
+	}
+
+	*pIndex = pParam->mIndex;
+	return &pRootSignature->pDescriptors[pParam->mIndex];
+}
+/************************************************************************/
+// Command stream replay
+/************************************************************************/
+static void execute_update_subresource(const NullUpdateSubresourceCmd* pUpdate)
+{
+	Texture*                   pTexture = pUpdate->pTexture;
+	const SubresourceDataDesc& desc = pUpdate->mSubresourceDesc;
+	const uint3                blockDim = ImageFormat::GetBlockSize(pTexture->mDesc.mFormat);
+	const uint32_t             bytesPerBlock = (uint32_t)ImageFormat::GetBytesPerBlock(pTexture->mDesc.mFormat);
+
+	uint32_t dstRowPitch = 0;
+	uint32_t dstRowCount = 0;
+	uint32_t dstDepth = 0;
+	util_get_mip_layout(&pTexture->mDesc, desc.mMipLevel, &dstRowPitch, &dstRowCount, &dstDepth);
+	const uint64_t dstSlicePitch = (uint64_t)dstRowPitch * dstRowCount;
+
+	// Region is specified in pixels, staging memory is laid out in rows of blocks
+	const uint32_t blockX = desc.mRegion.mXOffset / blockDim.x;
+	const uint32_t blockY = desc.mRegion.mYOffset / blockDim.y;
+	const uint32_t rowSize = ((desc.mRegion.mWidth + blockDim.x - 1) / blockDim.x) * bytesPerBlock;
+	const uint32_t rowCount = (desc.mRegion.mHeight + blockDim.y - 1) / blockDim.y;
+
+	ASSERT(blockX * bytesPerBlock + rowSize <= dstRowPitch);
+	ASSERT(blockY + rowCount <= dstRowCount);
+	ASSERT(desc.mRegion.mZOffset + desc.mRegion.mDepth <= dstDepth);
+
+	uint8_t*       pDst = (uint8_t*)pTexture->pNullMemory + util_get_subresource_offset(pTexture, desc.mArrayLayer, desc.mMipLevel);
+	const uint8_t* pSrc = (const uint8_t*)pUpdate->pSrcBuffer->pNullMemory + desc.mBufferOffset;
+
+	for (uint32_t z = 0; z < desc.mRegion.mDepth; ++z)
+	{
+		uint8_t*       pDstSlice = pDst + (desc.mRegion.mZOffset + z) * dstSlicePitch + (uint64_t)blockY * dstRowPitch + blockX * bytesPerBlock;
+		const uint8_t* pSrcSlice = pSrc + (uint64_t)z * desc.mSlicePitch;
+		for (uint32_t y = 0; y < rowCount; ++y)
+			memcpy(pDstSlice + (uint64_t)y * dstRowPitch, pSrcSlice + (uint64_t)y * desc.mRowPitch, rowSize);
+	}
+}
+
+static void execute_cmd_stream(const Cmd* pCmd)
+{
+	const uint8_t* pStream = pCmd->pCmdStream;
+	const uint8_t* pStreamEnd = pCmd->pCmdStream + pCmd->mCmdStreamSize;
+
+	while (pStream < pStreamEnd)
+	{
+		const NullCmdHeader* pHeader = (const NullCmdHeader*)pStream;
+		const void*          pPayload = pHeader + 1;
+
+		switch (pHeader->mType)
+		{
+			case NULL_CMD_TYPE_cmdUpdateBuffer:
+			{
+				const NullUpdateBufferCmd* pUpdate = (const NullUpdateBufferCmd*)pPayload;
+				memcpy(
+					(uint8_t*)pUpdate->pBuffer->pNullMemory + pUpdate->mDstOffset,
+					(const uint8_t*)pUpdate->pSrcBuffer->pNullMemory + pUpdate->mSrcOffset, (size_t)pUpdate->mSize);
+				break;
+			}
+			case NULL_CMD_TYPE_cmdUpdateSubresource:
+			{
+				execute_update_subresource((const NullUpdateSubresourceCmd*)pPayload);
+				break;
+			}
+			case NULL_CMD_TYPE_cmdBeginQuery:
+			case NULL_CMD_TYPE_cmdEndQuery:
+			{
+				const NullQueryCmd* pQuery = (const NullQueryCmd*)pPayload;
+				pQuery->pQueryHeap->pTimestamps[pQuery->mIndex] =
+					pQuery->pQueryHeap->mDesc.mType == QUERY_TYPE_TIMESTAMP ? (uint64_t)getUSec() : 0;
+				break;
+			}
+			case NULL_CMD_TYPE_cmdResolveQuery:
+			{
+				const NullResolveQueryCmd* pResolve = (const NullResolveQueryCmd*)pPayload;
+				memcpy(
+					(uint64_t*)pResolve->pReadbackBuffer->pNullMemory + pResolve->mStartQuery,
+					pResolve->pQueryHeap->pTimestamps + pResolve->mStartQuery, pResolve->mQueryCount * sizeof(uint64_t));
+				break;
+			}
+			case NULL_CMD_TYPE_cmdExecuteSecondaryCmds:
+			{
+				const NullExecuteSecondaryCmdsCmd* pExecute = (const NullExecuteSecondaryCmdsCmd*)pPayload;
+				Cmd* const*                        ppSecondaryCmds = (Cmd* const*)(pExecute + 1);
+				for (uint32_t i = 0; i < pExecute->mCmdCount; ++i)
+					execute_cmd_stream(ppSecondaryCmds[i]);
+				break;
+			}
+			default: break;
+		}
+
+		pStream += sizeof(NullCmdHeader) + pHeader->mSize;
+	}
+}
+/************************************************************************/
+// Functions not exposed in IRenderer but still need to be exported in dll
+/************************************************************************/
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mSize > 0);
+
+	Buffer* pBuffer = (Buffer*)conf_calloc(1, sizeof(*pBuffer));
+	ASSERT(pBuffer);
+
+	pBuffer->mDesc = *pDesc;
+
+	// Align the buffer size to multiples of the dynamic uniform buffer minimum size
+	if (pBuffer->mDesc.mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+	{
+		uint64_t minAlignment = pRenderer->pActiveGpuSettings->mUniformBufferAlignment;
+		pBuffer->mDesc.mSize = round_up_64(pBuffer->mDesc.mSize, minAlignment);
+	}
+
+	pBuffer->pNullMemory = util_allocate_resource_memory(pBuffer->mDesc.mSize);
+
+	// Buffers in CPU accessible heaps stay mapped for their entire lifetime
+	if (pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY &&
+		(pBuffer->mDesc.mFlags & BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT))
+		pBuffer->pCpuMappedAddress = pBuffer->pNullMemory;
+
+	pBuffer->mCurrentState = pBuffer->mDesc.mStartState;
+	pBuffer->mPreviousState = pBuffer->mDesc.mStartState;
+	pBuffer->mBufferId = tfrg_atomic64_add_relaxed(&gBufferIds, 1);
+
+	*pp_buffer = pBuffer;
+}
+
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	ASSERT(pRenderer);
+	ASSERT(pBuffer);
+
+	util_free_resource_memory(pBuffer->pNullMemory, pBuffer->mDesc.mSize);
+	SAFE_FREE(pBuffer);
+}
+
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange)
+{
+	UNREF_PARAM(pRenderer);
+	ASSERT(pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to map non-cpu accessible resource");
+
+	pBuffer->pCpuMappedAddress = pBuffer->pNullMemory;
+	if (pRange)
+	{
+		ASSERT(pRange->mOffset < pBuffer->mDesc.mSize);
+		pBuffer->pCpuMappedAddress = ((uint8_t*)pBuffer->pCpuMappedAddress + pRange->mOffset);
+	}
+}
+
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	UNREF_PARAM(pRenderer);
+	ASSERT(pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to unmap non-cpu accessible resource");
+
+	pBuffer->pCpuMappedAddress = NULL;
+}
+
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
+	if (pDesc->mSampleCount > SAMPLE_COUNT_1 && pDesc->mMipLevels > 1)
+	{
+		LOGF(LogLevel::eERROR, "Multi-Sampled textures cannot have mip maps");
+		ASSERT(false);
+		return;
+	}
+
+	Texture* pTexture = (Texture*)conf_calloc(1, sizeof(*pTexture));
+	ASSERT(pTexture);
+
+	pTexture->mDesc = *pDesc;
+	pTexture->mDesc.mDepth = max(1U, pDesc->mDepth);
+	pTexture->mDesc.mArraySize = max(1U, pDesc->mArraySize);
+	pTexture->mDesc.mMipLevels = max(1U, pDesc->mMipLevels);
+	// Null textures never alias a native resource
+	pTexture->mDesc.pNativeHandle = NULL;
+	pTexture->mOwnsImage = true;
+
+	uint64_t layerSize = 0;
+	for (uint32_t i = 0; i < pTexture->mDesc.mMipLevels; ++i)
+		layerSize += util_get_mip_layout(&pTexture->mDesc, i, NULL, NULL, NULL);
+
+	pTexture->mTextureSize = layerSize * pTexture->mDesc.mArraySize * pTexture->mDesc.mSampleCount;
+	pTexture->pNullMemory = util_allocate_resource_memory(pTexture->mTextureSize);
+
+	pTexture->mCurrentState = pDesc->mStartState;
+	pTexture->mPreviousState = pDesc->mStartState;
+	pTexture->mTextureId = tfrg_atomic64_add_relaxed(&gTextureIds, 1);
+
+	*ppTexture = pTexture;
+}
+
+void removeTexture(Renderer* pRenderer, Texture* pTexture)
+{
+	ASSERT(pRenderer);
+	ASSERT(pTexture);
+
+	util_free_resource_memory(pTexture->pNullMemory, pTexture->mTextureSize);
+	SAFE_FREE(pTexture);
+}
+
+void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pBuffer && pSrcBuffer);
+	ASSERT(srcOffset + size <= pSrcBuffer->mDesc.mSize);
+	ASSERT(dstOffset + size <= pBuffer->mDesc.mSize);
+
+	NullUpdateBufferCmd* pUpdate = util_record_cmd<NullUpdateBufferCmd>(pCmd, NULL_CMD_TYPE_cmdUpdateBuffer);
+	pUpdate->pBuffer = pBuffer;
+	pUpdate->pSrcBuffer = pSrcBuffer;
+	pUpdate->mDstOffset = dstOffset;
+	pUpdate->mSrcOffset = srcOffset;
+	pUpdate->mSize = size;
+}
+
+void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, SubresourceDataDesc* pSubresourceDesc)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pTexture && pSrcBuffer && pSubresourceDesc);
+	ASSERT(pSubresourceDesc->mMipLevel < pTexture->mDesc.mMipLevels);
+	ASSERT(pSubresourceDesc->mArrayLayer < pTexture->mDesc.mArraySize);
+	ASSERT(
+		pSubresourceDesc->mBufferOffset + (uint64_t)pSubresourceDesc->mSlicePitch * pSubresourceDesc->mRegion.mDepth <=
+		pSrcBuffer->mDesc.mSize);
+
+	NullUpdateSubresourceCmd* pUpdate = util_record_cmd<NullUpdateSubresourceCmd>(pCmd, NULL_CMD_TYPE_cmdUpdateSubresource);
+	pUpdate->pTexture = pTexture;
+	pUpdate->pSrcBuffer = pSrcBuffer;
+	pUpdate->mSubresourceDesc = *pSubresourceDesc;
+}
+
+const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRenderer) { return RendererShaderDefinesDesc(); }
+/************************************************************************/
+// Renderer Init Remove
+/************************************************************************/
+void initRenderer(const char* appName, const RendererDesc* settings, Renderer** ppRenderer)
+{
+	Renderer* pRenderer = (Renderer*)conf_calloc(1, sizeof(*pRenderer));
+	ASSERT(pRenderer);
+
+	pRenderer->pName = (char*)conf_calloc(strlen(appName) + 1, sizeof(char));
+	memcpy(pRenderer->pName, appName, strlen(appName));
+
+	// Copy settings
+	memcpy(&(pRenderer->mSettings), settings, sizeof(*settings));
+	pRenderer->mSettings.mApi = RENDERER_API_NULL;
+
+	// Report limits matching a typical desktop GPU so upload and uniform buffer alignment code paths are exercised
+	pRenderer->mNumOfGPUs = 1;
+	pRenderer->mLinkedNodeCount = 1;
+	GPUSettings* pGpuSettings = &pRenderer->mGpuSettings[0];
+	pGpuSettings->mUniformBufferAlignment = 256;
+	pGpuSettings->mUploadBufferTextureAlignment = 512;
+	pGpuSettings->mUploadBufferTextureRowAlignment = 256;
+	pGpuSettings->mMaxVertexInputBindings = MAX_VERTEX_BINDINGS;
+	pGpuSettings->mMaxRootSignatureDWORDS = 64;
+	pGpuSettings->mWaveLaneCount = 32;
+	pGpuSettings->mMultiDrawIndirect = true;
+	pGpuSettings->mROVsSupported = false;
+	strncpy(pGpuSettings->mGpuVendorPreset.mVendorId, "0x0000", MAX_GPU_VENDOR_STRING_LENGTH);
+	strncpy(pGpuSettings->mGpuVendorPreset.mModelId, "0x0000", MAX_GPU_VENDOR_STRING_LENGTH);
+	strncpy(pGpuSettings->mGpuVendorPreset.mRevisionId, "0x00", MAX_GPU_VENDOR_STRING_LENGTH);
+	strncpy(pGpuSettings->mGpuVendorPreset.mGpuName, "Null", MAX_GPU_VENDOR_STRING_LENGTH);
+	pGpuSettings->mGpuVendorPreset.mPresetLevel = GPU_PRESET_ULTRA;
+	pRenderer->pActiveGpuSettings = pGpuSettings;
+
+	LOGF(LogLevel::eINFO, "Null renderer initialized (simulated GPU latency: %u us)", pRenderer->mSettings.mSimulatedGpuLatencyUs);
+
+	// Renderer is good! Assign it to result!
+	*(ppRenderer) = pRenderer;
+}
+
+void removeRenderer(Renderer* pRenderer)
+{
+	ASSERT(pRenderer);
+
+	SAFE_FREE(pRenderer->pName);
+
+	// Free all the renderer components
+	SAFE_FREE(pRenderer);
+}
+/************************************************************************/
+// Resource Creation Functions
+/************************************************************************/
+void addFence(Renderer* pRenderer, Fence** ppFence)
+{
+	ASSERT(pRenderer);
+
+	Fence* pFence = (Fence*)conf_calloc(1, sizeof(*pFence));
+	ASSERT(pFence);
+
+	*ppFence = pFence;
+}
+
+void removeFence(Renderer* pRenderer, Fence* pFence)
+{
+	ASSERT(pRenderer);
+	ASSERT(pFence);
+
+	SAFE_FREE(pFence);
+}
+
+void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
+{
+	ASSERT(pRenderer);
+
+	Semaphore* pSemaphore = (Semaphore*)conf_calloc(1, sizeof(*pSemaphore));
+	ASSERT(pSemaphore);
+
+	*ppSemaphore = pSemaphore;
+}
+
+void removeSemaphore(Renderer* pRenderer, Semaphore* pSemaphore)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSemaphore);
+
+	SAFE_FREE(pSemaphore);
+}
+
+void addQueue(Renderer* pRenderer, QueueDesc* pQDesc, Queue** ppQueue)
+{
+	Queue* pQueue = (Queue*)conf_calloc(1, sizeof(*pQueue));
+	ASSERT(pQueue != NULL);
+
+	pQueue->mQueueDesc = *pQDesc;
+	pQueue->mUploadGranularity = { 1, 1, 1 };
+	pQueue->pRenderer = pRenderer;
+
+	*ppQueue = pQueue;
+}
+
+void removeQueue(Queue* pQueue)
+{
+	ASSERT(pQueue != NULL);
+	SAFE_FREE(pQueue);
+}
+
+void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppSwapChain);
+	ASSERT(pDesc->mImageCount);
+
+	SwapChain* pSwapChain = (SwapChain*)conf_calloc(1, sizeof(*pSwapChain));
+	pSwapChain->mDesc = *pDesc;
+
+	// Back buffers are plain render targets backed by system memory
+	RenderTargetDesc descColor = {};
+	descColor.mWidth = pSwapChain->mDesc.mWidth;
+	descColor.mHeight = pSwapChain->mDesc.mHeight;
+	descColor.mDepth = 1;
+	descColor.mArraySize = 1;
+	descColor.mFormat = pSwapChain->mDesc.mColorFormat;
+	descColor.mClearValue = pSwapChain->mDesc.mColorClearValue;
+	descColor.mSampleCount = SAMPLE_COUNT_1;
+	descColor.mSampleQuality = 0;
+	descColor.mSrgb = pSwapChain->mDesc.mSrgb;
+
+	pSwapChain->ppSwapchainRenderTargets =
+		(RenderTarget**)conf_calloc(pSwapChain->mDesc.mImageCount, sizeof(*pSwapChain->ppSwapchainRenderTargets));
+
+	for (uint32_t i = 0; i < pSwapChain->mDesc.mImageCount; ++i)
+		::addRenderTarget(pRenderer, &descColor, &pSwapChain->ppSwapchainRenderTargets[i]);
+
+	*ppSwapChain = pSwapChain;
+}
+
+void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
+{
+	for (uint32_t i = 0; i < pSwapChain->mDesc.mImageCount; ++i)
+		::removeRenderTarget(pRenderer, pSwapChain->ppSwapchainRenderTargets[i]);
+
+	SAFE_FREE(pSwapChain->ppSwapchainRenderTargets);
+	SAFE_FREE(pSwapChain);
+}
+/************************************************************************/
+// Command Pool Functions
+/************************************************************************/
+void addCmdPool(Renderer* pRenderer, Queue* pQueue, bool transient, CmdPool** ppCmdPool)
+{
+	UNREF_PARAM(transient);
+	ASSERT(pRenderer);
+
+	CmdPool* pCmdPool = (CmdPool*)conf_calloc(1, sizeof(*pCmdPool));
+	ASSERT(pCmdPool);
+
+	pCmdPool->pQueue = pQueue;
+	pCmdPool->mCmdPoolDesc.mCmdPoolType = pQueue->mQueueDesc.mType;
+
+	*ppCmdPool = pCmdPool;
+}
+
+void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+	ASSERT(pRenderer);
+	ASSERT(pCmdPool);
+	SAFE_FREE(pCmdPool);
+}
+
+void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
+{
+	ASSERT(pCmdPool);
+	ASSERT(pCmdPool->mCmdPoolDesc.mCmdPoolType < CmdPoolType::MAX_CMD_TYPE);
+
+	Cmd* pCmd = (Cmd*)conf_calloc(1, sizeof(*pCmd));
+	ASSERT(pCmd);
+
+	pCmd->pRenderer = pCmdPool->pQueue->pRenderer;
+	pCmd->pCmdPool = pCmdPool;
+	pCmd->mNodeIndex = pCmdPool->pQueue->mQueueDesc.mNodeIndex;
+	pCmd->mSecondary = secondary;
+
+	if (pCmdPool->mCmdPoolDesc.mCmdPoolType == CMD_POOL_DIRECT)
+	{
+		pCmd->pBoundColorFormats = (uint32_t*)conf_calloc(MAX_RENDER_TARGET_ATTACHMENTS, sizeof(uint32_t));
+		pCmd->pBoundSrgbValues = (bool*)conf_calloc(MAX_RENDER_TARGET_ATTACHMENTS, sizeof(bool));
+	}
+
+	pCmd->pCmdStream = (uint8_t*)conf_malloc((size_t)INITIAL_CMD_STREAM_CAPACITY);
+	pCmd->mCmdStreamCapacity = INITIAL_CMD_STREAM_CAPACITY;
+
+	*ppCmd = pCmd;
+}
+
+void removeCmd(CmdPool* pCmdPool, Cmd* pCmd)
+{
+	ASSERT(pCmdPool);
+	ASSERT(pCmd);
+
+	SAFE_FREE(pCmd->pBoundColorFormats);
+	SAFE_FREE(pCmd->pBoundSrgbValues);
+	SAFE_FREE(pCmd->pCmdStream);
+	SAFE_FREE(pCmd);
+}
+
+void addCmd_n(CmdPool* pCmdPool, bool secondary, uint32_t cmdCount, Cmd*** pppCmd)
+{
+	ASSERT(pppCmd);
+
+	Cmd** ppCmd = (Cmd**)conf_calloc(cmdCount, sizeof(*ppCmd));
+	ASSERT(ppCmd);
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		::addCmd(pCmdPool, secondary, &(ppCmd[i]));
+	}
+	*pppCmd = ppCmd;
+}
+
+void removeCmd_n(CmdPool* pCmdPool, uint32_t cmdCount, Cmd** ppCmd)
+{
+	ASSERT(ppCmd);
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		::removeCmd(pCmdPool, ppCmd[i]);
+	}
+
+	SAFE_FREE(ppCmd);
+}
+/************************************************************************/
+// All buffer, texture loading handled by resource system -> IResourceLoader.
+/************************************************************************/
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppRenderTarget);
+
+	bool isDepth = ImageFormat::IsDepthFormat(pDesc->mFormat);
+
+	ASSERT(!((isDepth) && (pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE)) && "Cannot use depth stencil as UAV");
+
+	RenderTarget* pRenderTarget = (RenderTarget*)conf_calloc(1, sizeof(*pRenderTarget));
+	pRenderTarget->mDesc = *pDesc;
+	pRenderTarget->mDesc.mMipLevels = max(1U, pDesc->mMipLevels);
+
+	TextureDesc textureDesc = {};
+	textureDesc.mArraySize = pDesc->mArraySize;
+	textureDesc.mClearValue = pDesc->mClearValue;
+	textureDesc.mDepth = pDesc->mDepth;
+	textureDesc.mFlags = pDesc->mFlags;
+	textureDesc.mFormat = pDesc->mFormat;
+	textureDesc.mHeight = pDesc->mHeight;
+	textureDesc.mMipLevels = pRenderTarget->mDesc.mMipLevels;
+	textureDesc.mSampleCount = pDesc->mSampleCount;
+	textureDesc.mSampleQuality = pDesc->mSampleQuality;
+	textureDesc.mWidth = pDesc->mWidth;
+	textureDesc.mSrgb = pDesc->mSrgb;
+	textureDesc.mNodeIndex = pDesc->mNodeIndex;
+	textureDesc.mStartState = isDepth ? RESOURCE_STATE_DEPTH_WRITE : RESOURCE_STATE_RENDER_TARGET;
+	// Create SRV by default for a render target
+	textureDesc.mDescriptors = pDesc->mDescriptors | DESCRIPTOR_TYPE_TEXTURE;
+
+	::addTexture(pRenderer, &textureDesc, &pRenderTarget->pTexture);
+
+	*ppRenderTarget = pRenderTarget;
+}
+
+void removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
+{
+	::removeTexture(pRenderer, pRenderTarget->pTexture);
+	SAFE_FREE(pRenderTarget);
+}
+
+void addSampler(Renderer* pRenderer, const SamplerDesc* pDesc, Sampler** ppSampler)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc->mCompareFunc < MAX_COMPARE_MODES);
+
+	Sampler* pSampler = (Sampler*)conf_calloc(1, sizeof(*pSampler));
+	ASSERT(pSampler);
+	pSampler->mSamplerId = tfrg_atomic64_add_relaxed(&gSamplerIds, 1);
+
+	*ppSampler = pSampler;
+}
+
+void removeSampler(Renderer* pRenderer, Sampler* pSampler)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSampler);
+
+	SAFE_FREE(pSampler);
+}
+/************************************************************************/
+// Shader Functions
+/************************************************************************/
+void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+
+	Shader* pShaderProgram = (Shader*)conf_calloc(1, sizeof(*pShaderProgram));
+
+	conf_placement_new<Shader>(pShaderProgram);
+
+	pShaderProgram->mStages = pDesc->mStages;
+
+	uint32_t         counter = 0;
+	ShaderReflection stageReflections[SHADER_STAGE_COUNT] = {};
+
+	for (uint32_t i = 0; i < SHADER_STAGE_COUNT; ++i)
+	{
+		ShaderStage stage_mask = (ShaderStage)(1 << i);
+		if (stage_mask != (pShaderProgram->mStages & stage_mask))
+			continue;
+
+		const BinaryShaderStageDesc* pStageDesc = NULL;
+		switch (stage_mask)
+		{
+			case SHADER_STAGE_VERT: pStageDesc = &pDesc->mVert; break;
+			case SHADER_STAGE_TESC: pStageDesc = &pDesc->mHull; break;
+			case SHADER_STAGE_TESE: pStageDesc = &pDesc->mDomain; break;
+			case SHADER_STAGE_GEOM: pStageDesc = &pDesc->mGeom; break;
+			case SHADER_STAGE_FRAG: pStageDesc = &pDesc->mFrag; break;
+			case SHADER_STAGE_COMP: pStageDesc = &pDesc->mComp; break;
+			default: break;
+		}
+
+		if (!pStageDesc)
+			continue;
+
+		// Only SPIR-V can be reflected. Anything else still yields a valid shader with an empty layout
+		if (pStageDesc->mByteCodeSize < sizeof(uint32_t) || *(const uint32_t*)pStageDesc->pByteCode != SPIRV_MAGIC)
+		{
+			LOGF(LogLevel::eWARNING, "Shader stage (%u) byte code is not SPIR-V. Resource reflection is skipped", (uint32_t)stage_mask);
+			continue;
+		}
+
+		vk_createShaderReflection(
+			(const uint8_t*)pStageDesc->pByteCode, pStageDesc->mByteCodeSize, stage_mask, &stageReflections[counter++]);
+	}
+
+	createPipelineReflection(stageReflections, counter, &pShaderProgram->mReflection);
+	// Stages without reflection data still need to be known to addRootSignature for the pipeline type
+	pShaderProgram->mReflection.mShaderStages = pShaderProgram->mStages;
+
+	*ppShaderProgram = pShaderProgram;
+}
+
+void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
+{
+	UNREF_PARAM(pRenderer);
+
+	destroyPipelineReflection(&pShaderProgram->mReflection);
+	pShaderProgram->~Shader();
+	SAFE_FREE(pShaderProgram);
+}
+/************************************************************************/
+// Root Signature Functions
+/************************************************************************/
+void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatureDesc, RootSignature** ppRootSignature)
+{
+	UNREF_PARAM(pRenderer);
+
+	RootSignature* pRootSignature = (RootSignature*)conf_calloc(1, sizeof(*pRootSignature));
+
+	conf_placement_new<RootSignature>(pRootSignature);
+
+	eastl::vector<ShaderResource>        shaderResources;
+	eastl::hash_map<eastl::string, bool> staticSamplerMap;
+
+	for (uint32_t i = 0; i < pRootSignatureDesc->mStaticSamplerCount; ++i)
+		staticSamplerMap.insert({ { pRootSignatureDesc->ppStaticSamplerNames[i], true } });
+
+	// Collect all unique shader resources in the given shaders
+	// Resources are parsed by name (two resources named "XYZ" in two shaders will be considered the same resource)
+	for (uint32_t sh = 0; sh < pRootSignatureDesc->mShaderCount; ++sh)
+	{
+		PipelineReflection const* pReflection = &pRootSignatureDesc->ppShaders[sh]->mReflection;
+
+		if (pReflection->mShaderStages & SHADER_STAGE_COMP)
+			pRootSignature->mPipelineType = PIPELINE_TYPE_COMPUTE;
+		else
+			pRootSignature->mPipelineType = PIPELINE_TYPE_GRAPHICS;
+
+		for (uint32_t i = 0; i < pReflection->mShaderResourceCount; ++i)
+		{
+			ShaderResource const* pRes = &pReflection->pShaderResources[i];
+
+			eastl::string_hash_map<uint32_t>::iterator it = pRootSignature->pDescriptorNameToIndexMap.find(pRes->name);
+			if (it == pRootSignature->pDescriptorNameToIndexMap.end())
+			{
+				pRootSignature->pDescriptorNameToIndexMap.insert(pRes->name, (uint32_t)shaderResources.size());
+				shaderResources.emplace_back(*pRes);
+			}
+			else
+			{
+				if (shaderResources[it->second].reg != pRes->reg || shaderResources[it->second].set != pRes->set)
+				{
+					LOGF(
+						LogLevel::eERROR,
+						"Failed to create root signature. Shared shader resource %s has mismatching binding. All shader resources "
+						"shared by multiple shaders specified in addRootSignature must have the same binding and set",
+						pRes->name);
+					pRootSignature->pDescriptorNameToIndexMap.~string_hash_map();
+					SAFE_FREE(pRootSignature);
+					return;
+				}
+
+				shaderResources[it->second].used_stages |= pRes->used_stages;
+			}
+		}
+	}
+
+	if ((uint32_t)shaderResources.size())
+	{
+		pRootSignature->mDescriptorCount = (uint32_t)shaderResources.size();
+		pRootSignature->pDescriptors = (DescriptorInfo*)conf_calloc(pRootSignature->mDescriptorCount, sizeof(DescriptorInfo));
+	}
+
+	// Handles of every update frequency are stored contiguously (same layout as the Vulkan descriptor update data)
+	uint32_t cumulativeDescriptorCounts[DESCRIPTOR_UPDATE_FREQ_COUNT] = {};
+	uint32_t descriptorCounts[DESCRIPTOR_UPDATE_FREQ_COUNT] = {};
+	uint32_t rootConstantCount = 0;
+
+	for (uint32_t i = 0; i < (uint32_t)shaderResources.size(); ++i)
+	{
+		DescriptorInfo*       pDesc = &pRootSignature->pDescriptors[i];
+		ShaderResource const* pRes = &shaderResources[i];
+
+		pDesc->mDesc.reg = pRes->reg;
+		pDesc->mDesc.set = pRes->set;
+		pDesc->mDesc.size = pRes->size;
+		pDesc->mDesc.type = pRes->type;
+		pDesc->mDesc.used_stages = pRes->used_stages;
+		pDesc->mDesc.name_size = pRes->name_size;
+		pDesc->mDesc.name = (const char*)conf_calloc(pDesc->mDesc.name_size + 1, sizeof(char));
+		pDesc->mDesc.dim = pRes->dim;
+		memcpy((char*)pDesc->mDesc.name, pRes->name, pRes->name_size);
+
+		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
+		{
+			pDesc->mDesc.set = 0;
+			pDesc->mIndexInParent = rootConstantCount++;
+			continue;
+		}
+
+		const uint32_t setIndex = min(pDesc->mDesc.set, (uint32_t)DESCRIPTOR_UPDATE_FREQ_COUNT - 1);
+		pDesc->mUpdateFrquency = (DescriptorUpdateFrequency)setIndex;
+
+		// Set the index to an invalid value so we can use this later for error checking if user tries to update a static sampler
+		if (staticSamplerMap.find(pDesc->mDesc.name) != staticSamplerMap.end())
+		{
+			LOGF(LogLevel::eINFO, "Descriptor (%s) : User specified Static Sampler", pDesc->mDesc.name);
+			pDesc->mIndexInParent = -1;
+			continue;
+		}
+
+		pDesc->mIndexInParent = descriptorCounts[setIndex]++;
+		pDesc->mHandleIndex = cumulativeDescriptorCounts[setIndex];
+		cumulativeDescriptorCounts[setIndex] += pDesc->mDesc.size;
+	}
+
+	*ppRootSignature = pRootSignature;
+}
+
+void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
+{
+	UNREF_PARAM(pRenderer);
+
+	for (uint32_t i = 0; i < pRootSignature->mDescriptorCount; ++i)
+	{
+		SAFE_FREE(pRootSignature->pDescriptors[i].mDesc.name);
+	}
+
+	// Need delete since the destructor frees allocated memory
+	pRootSignature->pDescriptorNameToIndexMap.~string_hash_map();
+
+	SAFE_FREE(pRootSignature->pDescriptors);
+	SAFE_FREE(pRootSignature);
+}
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	uint32_t index = UINT32_MAX;
+	get_descriptor(pRootSignature, pName, &index);
+	return index;
+}
+/************************************************************************/
+// Pipeline Functions
+/************************************************************************/
+void addGraphicsPipelineImpl(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->pShaderProgram);
+	ASSERT(pDesc->pRootSignature);
+
+	Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
+	ASSERT(pPipeline);
+
+	memcpy(&(pPipeline->mGraphics), pDesc, sizeof(*pDesc));
+	pPipeline->mType = PIPELINE_TYPE_GRAPHICS;
+
+	*ppPipeline = pPipeline;
+}
+
+void addPipeline(Renderer* pRenderer, const GraphicsPipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	addGraphicsPipelineImpl(pRenderer, pDesc, ppPipeline);
+}
+
+void addComputePipelineImpl(Renderer* pRenderer, const ComputePipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->pShaderProgram);
+	ASSERT(pDesc->pRootSignature);
+
+	Pipeline* pPipeline = (Pipeline*)conf_calloc(1, sizeof(*pPipeline));
+	ASSERT(pPipeline);
+
+	memcpy(&(pPipeline->mCompute), pDesc, sizeof(*pDesc));
+	pPipeline->mType = PIPELINE_TYPE_COMPUTE;
+
+	*ppPipeline = pPipeline;
+}
+
+void addComputePipeline(Renderer* pRenderer, const ComputePipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	addComputePipelineImpl(pRenderer, pDesc, ppPipeline);
+}
+
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	switch (pDesc->mType)
+	{
+		case (PIPELINE_TYPE_COMPUTE):
+		{
+			addComputePipelineImpl(pRenderer, &pDesc->mComputeDesc, ppPipeline);
+			break;
+		}
+		case (PIPELINE_TYPE_GRAPHICS):
+		{
+			addGraphicsPipelineImpl(pRenderer, &pDesc->mGraphicsDesc, ppPipeline);
+			break;
+		}
+		case (PIPELINE_TYPE_RAYTRACING):
+		default:
+		{
+			LOGF(LogLevel::eERROR, "Null renderer does not support raytracing pipelines");
+			ASSERT(false);
+			*ppPipeline = NULL;
+			break;
+		}
+	}
+}
+
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPipeline);
+
+	SAFE_FREE(pPipeline);
+}
+/************************************************************************/
+// Pipeline State Functions
+/************************************************************************/
+void addBlendState(Renderer* pRenderer, const BlendStateDesc* pDesc, BlendState** ppBlendState)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+
+	BlendState* pBlendState = (BlendState*)conf_calloc(1, sizeof(*pBlendState));
+	*ppBlendState = pBlendState;
+}
+
+void removeBlendState(BlendState* pBlendState) { SAFE_FREE(pBlendState); }
+
+void addDepthState(Renderer* pRenderer, const DepthStateDesc* pDesc, DepthState** ppDepthState)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mDepthFunc < CompareMode::MAX_COMPARE_MODES);
+
+	DepthState* pDepthState = (DepthState*)conf_calloc(1, sizeof(*pDepthState));
+	*ppDepthState = pDepthState;
+}
+
+void removeDepthState(DepthState* pDepthState) { SAFE_FREE(pDepthState); }
+
+void addRasterizerState(Renderer* pRenderer, const RasterizerStateDesc* pDesc, RasterizerState** ppRasterizerState)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mFillMode < FillMode::MAX_FILL_MODES);
+	ASSERT(pDesc->mCullMode < CullMode::MAX_CULL_MODES);
+
+	RasterizerState* pRasterizerState = (RasterizerState*)conf_calloc(1, sizeof(*pRasterizerState));
+	*ppRasterizerState = pRasterizerState;
+}
+
+void removeRasterizerState(RasterizerState* pRasterizerState) { SAFE_FREE(pRasterizerState); }
+/************************************************************************/
+// Descriptor Binder Implementation
+/************************************************************************/
+typedef struct DescriptorBinder
+{
+	DescriptorBinderDesc mDesc;
+} DescriptorBinder;
+
+void addDescriptorBinder(
+	Renderer* pRenderer, uint32_t gpuIndex, uint32_t descCount, const DescriptorBinderDesc* pDescs, DescriptorBinder** ppDescriptorBinder)
+{
+	UNREF_PARAM(pRenderer);
+	UNREF_PARAM(gpuIndex);
+
+	DescriptorBinder* pDescriptorBinder = (DescriptorBinder*)conf_calloc(1, sizeof(*pDescriptorBinder));
+	if (descCount)
+		pDescriptorBinder->mDesc = pDescs[0];
+	*ppDescriptorBinder = pDescriptorBinder;
+}
+
+void removeDescriptorBinder(Renderer* pRenderer, DescriptorBinder* pDescriptorBinder)
+{
+	UNREF_PARAM(pRenderer);
+	SAFE_FREE(pDescriptorBinder);
+}
+/************************************************************************/
+// Command buffer Functions
+/************************************************************************/
+void beginCmd(Cmd* pCmd)
+{
+	ASSERT(pCmd);
+	if (pCmd->mRecording)
+		LOGF(LogLevel::eWARNING, "beginCmd called on a Cmd buffer which is already recording. Previous commands are discarded");
+
+	pCmd->mCmdStreamSize = 0;
+	pCmd->mCmdCount = 0;
+	pCmd->mRecording = true;
+	pCmd->mRenderPassActive = false;
+	pCmd->mInheritedRenderPass = false;
+	pCmd->pBoundPipeline = NULL;
+	pCmd->pBoundRootSignature = NULL;
+	pCmd->pBoundIndexBuffer = NULL;
+	pCmd->pBoundDescriptorBinder = NULL;
+	pCmd->pBoundDescriptorBinderNode = NULL;
+}
+
+void endCmd(Cmd* pCmd)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	pCmd->mRecording = false;
+	pCmd->mRenderPassActive = false;
+}
+
+void beginSecondaryCmd(Cmd* pCmd, Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+
+	// A rejected begin must not leave the secondary executable with what it recorded before
+	pCmd->mInheritedRenderPass = false;
+	if (!pCmd->mSecondary || pPrimaryCmd->mSecondary)
+	{
+		LOGF(LogLevel::eERROR, "beginSecondaryCmd needs a Cmd buffer added with secondary = true and a primary Cmd buffer");
+		return;
+	}
+	if (!util_is_recording(pPrimaryCmd))
+		return;
+	if (!pPrimaryCmd->mRenderPassActive || !pPrimaryCmd->mSecondaryRenderPass)
+	{
+		LOGF(LogLevel::eERROR, "beginSecondaryCmd called without render targets bound with LoadActionsDesc::mSecondaryCmds on the primary");
+		return;
+	}
+
+	::beginCmd(pCmd);
+
+	if (pCmd->pBoundColorFormats && pPrimaryCmd->pBoundColorFormats)
+	{
+		memcpy(pCmd->pBoundColorFormats, pPrimaryCmd->pBoundColorFormats, sizeof(uint32_t) * MAX_RENDER_TARGET_ATTACHMENTS);
+		memcpy(pCmd->pBoundSrgbValues, pPrimaryCmd->pBoundSrgbValues, sizeof(bool) * MAX_RENDER_TARGET_ATTACHMENTS);
+	}
+	pCmd->mBoundRenderTargetCount = pPrimaryCmd->mBoundRenderTargetCount;
+	pCmd->mBoundDepthStencilFormat = pPrimaryCmd->mBoundDepthStencilFormat;
+	pCmd->mBoundWidth = pPrimaryCmd->mBoundWidth;
+	pCmd->mBoundHeight = pPrimaryCmd->mBoundHeight;
+	pCmd->mBoundSampleCount = pPrimaryCmd->mBoundSampleCount;
+	pCmd->mRenderPassHash = pPrimaryCmd->mRenderPassHash;
+	pCmd->mRenderPassActive = true;
+	pCmd->mInheritedRenderPass = true;
+}
+
+void cmdExecuteSecondaryCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppSecondaryCmds)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	if (pCmd->mSecondary)
+	{
+		LOGF(LogLevel::eERROR, "Secondary Cmd buffers cannot execute other secondary Cmd buffers");
+		return;
+	}
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		if (!ppSecondaryCmds[i]->mSecondary || !ppSecondaryCmds[i]->mInheritedRenderPass || ppSecondaryCmds[i]->mRecording)
+		{
+			LOGF(LogLevel::eERROR, "Cmd buffer at index (%u) is not an ended secondary Cmd buffer begun with beginSecondaryCmd", i);
+			return;
+		}
+	}
+
+	NullExecuteSecondaryCmdsCmd* pExecute =
+		util_record_cmd<NullExecuteSecondaryCmdsCmd>(pCmd, NULL_CMD_TYPE_cmdExecuteSecondaryCmds, cmdCount * sizeof(Cmd*));
+	pExecute->mCmdCount = cmdCount;
+	memcpy(pExecute + 1, ppSecondaryCmds, cmdCount * sizeof(Cmd*));
+
+	// The primary has to bind its state again
+	pCmd->pBoundPipeline = NULL;
+	pCmd->pBoundRootSignature = NULL;
+	pCmd->pBoundIndexBuffer = NULL;
+	pCmd->pBoundDescriptorBinder = NULL;
+	pCmd->pBoundDescriptorBinderNode = NULL;
+}
+
+void cmdBindRenderTargets(
+	Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil, const LoadActionsDesc* pLoadActions,
+	uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice, uint32_t depthMipSlice)
+{
+	UNREF_PARAM(pColorArraySlices);
+	UNREF_PARAM(pColorMipSlices);
+	UNREF_PARAM(depthArraySlice);
+	UNREF_PARAM(depthMipSlice);
+
+	if (!util_is_recording(pCmd))
+		return;
+
+	if (pCmd->mSecondary)
+	{
+		LOGF(LogLevel::eERROR, "Render targets cannot be bound in secondary Cmd buffers");
+		return;
+	}
+
+	if (renderTargetCount > MAX_RENDER_TARGET_ATTACHMENTS)
+	{
+		LOGF(LogLevel::eERROR, "Render target count (%u) exceeds MAX_RENDER_TARGET_ATTACHMENTS", renderTargetCount);
+		return;
+	}
+
+	NullBindRenderTargetsCmd* pBind = util_record_cmd<NullBindRenderTargetsCmd>(
+		pCmd, NULL_CMD_TYPE_cmdBindRenderTargets, renderTargetCount * sizeof(RenderTarget*));
+	pBind->pDepthStencil = pDepthStencil;
+	pBind->mRenderTargetCount = renderTargetCount;
+
+	RenderTarget** ppBoundTargets = (RenderTarget**)(pBind + 1);
+	for (uint32_t i = 0; i < renderTargetCount; ++i)
+	{
+		ASSERT(ppRenderTargets[i]);
+		ppBoundTargets[i] = ppRenderTargets[i];
+		if (pLoadActions && pLoadActions->mLoadActionsColor[i] == LOAD_ACTION_CLEAR)
+			pBind->mClearMask |= 1U << i;
+		if (pCmd->pBoundColorFormats)
+		{
+			pCmd->pBoundColorFormats[i] = ppRenderTargets[i]->mDesc.mFormat;
+			pCmd->pBoundSrgbValues[i] = ppRenderTargets[i]->mDesc.mSrgb;
+		}
+	}
+	if (pDepthStencil && pLoadActions && pLoadActions->mLoadActionDepth == LOAD_ACTION_CLEAR)
+		pBind->mClearMask |= 1U << 31;
+
+	RenderTarget* pFirstTarget = renderTargetCount ? ppRenderTargets[0] : pDepthStencil;
+	pCmd->mBoundRenderTargetCount = renderTargetCount;
+	pCmd->mBoundDepthStencilFormat = pDepthStencil ? pDepthStencil->mDesc.mFormat : ImageFormat::NONE;
+	pCmd->mBoundWidth = pFirstTarget ? pFirstTarget->mDesc.mWidth : 0;
+	pCmd->mBoundHeight = pFirstTarget ? pFirstTarget->mDesc.mHeight : 0;
+	pCmd->mBoundSampleCount = pFirstTarget ? pFirstTarget->mDesc.mSampleCount : SAMPLE_COUNT_1;
+	pCmd->mRenderPassActive = pFirstTarget != NULL;
+	pCmd->mSecondaryRenderPass = pLoadActions && pLoadActions->mSecondaryCmds;
+}
+
+void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	NullSetViewportCmd* pViewport = util_record_cmd<NullSetViewportCmd>(pCmd, NULL_CMD_TYPE_cmdSetViewport);
+	pViewport->x = x;
+	pViewport->y = y;
+	pViewport->width = width;
+	pViewport->height = height;
+	pViewport->minDepth = minDepth;
+	pViewport->maxDepth = maxDepth;
+}
+
+void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	NullSetScissorCmd* pScissor = util_record_cmd<NullSetScissorCmd>(pCmd, NULL_CMD_TYPE_cmdSetScissor);
+	pScissor->x = x;
+	pScissor->y = y;
+	pScissor->width = width;
+	pScissor->height = height;
+}
+
+void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pPipeline);
+	util_record_cmd<NullBindPipelineCmd>(pCmd, NULL_CMD_TYPE_cmdBindPipeline)->pPipeline = pPipeline;
+	pCmd->pBoundPipeline = pPipeline;
+}
+
+void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams)
+{
+	ASSERT(pDescriptorBinder);
+	ASSERT(pRootSignature);
+
+	if (!util_is_recording(pCmd))
+		return;
+
+	pCmd->pBoundDescriptorBinder = pDescriptorBinder;
+	pCmd->pBoundRootSignature = pRootSignature;
+
+	// First pass resolves and validates the input params and computes the size of the recorded payload
+	uint32_t* pDescIndices = (uint32_t*)alloca(numDescriptors * sizeof(uint32_t));
+	uint32_t  payloadSize = 0;
+	uint32_t  validCount = 0;
+	for (uint32_t i = 0; i < numDescriptors; ++i)
+	{
+		const DescriptorData* pParam = &pDescParams[i];
+		pDescIndices[i] = UINT32_MAX;
+
+		uint32_t              descIndex = 0;
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, i, &descIndex);
+		if (!pDesc)
+			continue;
+
+		const uint32_t arrayCount = max(1U, pParam->mCount);
+
+		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
+		{
+			if (!pParam->pRootConstant)
+			{
+				LOGF(LogLevel::eERROR, "Root constant (%s) is NULL", pDesc->mDesc.name);
+				return;
+			}
+			payloadSize += sizeof(NullDescriptorUpdate) + round_up(pDesc->mDesc.size, 8);
+			pDescIndices[i] = descIndex;
+			++validCount;
+			continue;
+		}
+
+		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_SAMPLER && pDesc->mIndexInParent == (uint32_t)-1)
+		{
+			LOGF(
+				LogLevel::eERROR,
+				"Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through "
+				"RootSignatureDesc::mStaticSamplers",
+				pDesc->mDesc.name);
+			continue;
+		}
+
+		if (pDesc->mDesc.size && arrayCount > pDesc->mDesc.size)
+		{
+			LOGF(
+				LogLevel::eERROR, "Descriptor (%s) : Array count (%u) exceeds the declared array size (%u)", pDesc->mDesc.name, arrayCount,
+				pDesc->mDesc.size);
+			return;
+		}
+
+		// All resource arrays share the same memory through the DescriptorData union
+		const void* const* ppResources = (const void* const*)pParam->ppTextures;
+		if (!ppResources)
+		{
+			LOGF(LogLevel::eERROR, "Descriptor (%s) is NULL", pDesc->mDesc.name);
+			return;
+		}
+		for (uint32_t arr = 0; arr < arrayCount; ++arr)
+		{
+			if (!ppResources[arr])
+			{
+				LOGF(LogLevel::eERROR, "Descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, arr);
+				return;
+			}
+		}
+
+		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_RW_TEXTURE)
+		{
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				const Texture* pTexture = pParam->ppTextures[arr];
+				if (!(pTexture->mDesc.mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE))
+				{
+					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) : Texture was not created with DESCRIPTOR_TYPE_RW_TEXTURE", pDesc->mDesc.name);
+					return;
+				}
+				if (pParam->mUAVMipSlice >= pTexture->mDesc.mMipLevels)
+				{
+					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) : Mip slice (%u) out of range", pDesc->mDesc.name, pParam->mUAVMipSlice);
+					return;
+				}
+			}
+		}
+		else if (
+			pDesc->mDesc.type == DESCRIPTOR_TYPE_UNIFORM_BUFFER || pDesc->mDesc.type == DESCRIPTOR_TYPE_BUFFER ||
+			pDesc->mDesc.type == DESCRIPTOR_TYPE_BUFFER_RAW || pDesc->mDesc.type == DESCRIPTOR_TYPE_RW_BUFFER ||
+			pDesc->mDesc.type == DESCRIPTOR_TYPE_RW_BUFFER_RAW)
+		{
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				const Buffer* pBuffer = pParam->ppBuffers[arr];
+				if (pParam->pOffsets && pParam->pOffsets[arr] >= pBuffer->mDesc.mSize)
+				{
+					LOGF(
+						LogLevel::eERROR, "Buffer descriptor (%s) : Offset (%llu) is out of bounds", pDesc->mDesc.name,
+						(unsigned long long)pParam->pOffsets[arr]);
+					return;
+				}
+				if (pParam->pOffsets && pParam->pSizes && pParam->pOffsets[arr] + pParam->pSizes[arr] > pBuffer->mDesc.mSize)
+				{
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) : Range exceeds the buffer size", pDesc->mDesc.name);
+					return;
+				}
+			}
+		}
+
+		payloadSize += sizeof(NullDescriptorUpdate) + arrayCount * sizeof(uint64_t);
+		pDescIndices[i] = descIndex;
+		++validCount;
+	}
+
+	// Second pass records the resolved descriptor indices and resource handles
+	NullBindDescriptorsCmd* pBind = util_record_cmd<NullBindDescriptorsCmd>(pCmd, NULL_CMD_TYPE_cmdBindDescriptors, payloadSize);
+	pBind->pRootSignature = pRootSignature;
+	pBind->mDescriptorCount = validCount;
+
+	uint8_t* pData = (uint8_t*)(pBind + 1);
+	for (uint32_t i = 0; i < numDescriptors; ++i)
+	{
+		const DescriptorData* pParam = &pDescParams[i];
+		if (pDescIndices[i] == UINT32_MAX)
+			continue;
+
+		const DescriptorInfo* pDesc = &pRootSignature->pDescriptors[pDescIndices[i]];
+
+		NullDescriptorUpdate* pUpdate = (NullDescriptorUpdate*)pData;
+		pUpdate->mIndex = pDescIndices[i];
+		pData += sizeof(NullDescriptorUpdate);
+
+		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
+		{
+			pUpdate->mRootConstantSize = pDesc->mDesc.size;
+			memcpy(pData, pParam->pRootConstant, pDesc->mDesc.size);
+			pData += round_up(pDesc->mDesc.size, 8);
+			continue;
+		}
+
+		pUpdate->mCount = max(1U, pParam->mCount);
+		pUpdate->mUAVMipSlice = pDesc->mDesc.type == DESCRIPTOR_TYPE_RW_TEXTURE ? pParam->mUAVMipSlice : 0;
+		memcpy(pData, pParam->ppTextures, pUpdate->mCount * sizeof(uint64_t));
+		pData += pUpdate->mCount * sizeof(uint64_t);
+	}
+}
+
+void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pBuffer);
+	ASSERT(offset < pBuffer->mDesc.mSize);
+
+	NullBindIndexBufferCmd* pBind = util_record_cmd<NullBindIndexBufferCmd>(pCmd, NULL_CMD_TYPE_cmdBindIndexBuffer);
+	pBind->pBuffer = pBuffer;
+	pBind->mOffset = offset;
+	pCmd->pBoundIndexBuffer = pBuffer;
+}
+
+void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, uint64_t* pOffsets)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(bufferCount && ppBuffers);
+	if (bufferCount > pCmd->pRenderer->pActiveGpuSettings->mMaxVertexInputBindings)
+	{
+		LOGF(LogLevel::eERROR, "Vertex buffer count (%u) exceeds the maximum vertex input bindings", bufferCount);
+		return;
+	}
+
+	NullBindVertexBufferCmd* pBind =
+		util_record_cmd<NullBindVertexBufferCmd>(pCmd, NULL_CMD_TYPE_cmdBindVertexBuffer, bufferCount * 2 * sizeof(uint64_t));
+	pBind->mBufferCount = bufferCount;
+
+	uint64_t* pBindings = (uint64_t*)(pBind + 1);
+	for (uint32_t i = 0; i < bufferCount; ++i)
+	{
+		ASSERT(ppBuffers[i]);
+		ASSERT(!pOffsets || pOffsets[i] < ppBuffers[i]->mDesc.mSize);
+		pBindings[i * 2] = (uint64_t)(uintptr_t)ppBuffers[i];
+		pBindings[i * 2 + 1] = pOffsets ? pOffsets[i] : 0;
+	}
+}
+
+void cmdDraw(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex) { cmdDrawInstanced(pCmd, vertexCount, firstVertex, 1, 0); }
+
+void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount, uint32_t firstInstance)
+{
+	if (!util_validate_draw(pCmd))
+		return;
+
+	NullDrawCmd* pDraw = util_record_cmd<NullDrawCmd>(pCmd, NULL_CMD_TYPE_cmdDraw);
+	pDraw->mVertexCount = vertexCount;
+	pDraw->mFirstVertex = firstVertex;
+	pDraw->mInstanceCount = instanceCount;
+	pDraw->mFirstInstance = firstInstance;
+}
+
+void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t firstVertex)
+{
+	cmdDrawIndexedInstanced(pCmd, indexCount, firstIndex, 1, firstVertex, 0);
+}
+
+void cmdDrawIndexedInstanced(
+	Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	if (!util_validate_draw(pCmd))
+		return;
+
+	if (!pCmd->pBoundIndexBuffer)
+	{
+		LOGF(LogLevel::eERROR, "Indexed draw recorded without an index buffer bound");
+		return;
+	}
+
+	const uint32_t indexSize = pCmd->pBoundIndexBuffer->mDesc.mIndexType == INDEX_TYPE_UINT16 ? 2 : 4;
+	if ((uint64_t)(firstIndex + indexCount) * indexSize > pCmd->pBoundIndexBuffer->mDesc.mSize)
+	{
+		LOGF(LogLevel::eERROR, "Indexed draw reads past the end of the bound index buffer");
+		return;
+	}
+
+	NullDrawIndexedCmd* pDraw = util_record_cmd<NullDrawIndexedCmd>(pCmd, NULL_CMD_TYPE_cmdDrawIndexed);
+	pDraw->mIndexCount = indexCount;
+	pDraw->mFirstIndex = firstIndex;
+	pDraw->mInstanceCount = instanceCount;
+	pDraw->mFirstVertex = firstVertex;
+	pDraw->mFirstInstance = firstInstance;
+}
+
+void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	if (!pCmd->pBoundPipeline || pCmd->pBoundPipeline->mType != PIPELINE_TYPE_COMPUTE)
+	{
+		LOGF(LogLevel::eERROR, "Dispatch recorded without a compute pipeline bound");
+		return;
+	}
+
+	NullDispatchCmd* pDispatch = util_record_cmd<NullDispatchCmd>(pCmd, NULL_CMD_TYPE_cmdDispatch);
+	pDispatch->mGroupCountX = groupCountX;
+	pDispatch->mGroupCountY = groupCountY;
+	pDispatch->mGroupCountZ = groupCountZ;
+}
+/************************************************************************/
+// Transition Commands
+/************************************************************************/
+void cmdResourceBarrier(
+	Cmd* pCmd, uint32_t numBufferBarriers, BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers, TextureBarrier* pTextureBarriers,
+	bool batch)
+{
+	UNREF_PARAM(batch);
+
+	if (!util_is_recording(pCmd))
+		return;
+
+	if (pCmd->mSecondary)
+	{
+		LOGF(LogLevel::eERROR, "Barriers cannot be recorded in secondary Cmd buffers");
+		return;
+	}
+
+	// Resource states are tracked at record time like the other backends do
+	for (uint32_t i = 0; i < numBufferBarriers; ++i)
+	{
+		Buffer* pBuffer = pBufferBarriers[i].pBuffer;
+		if (pBuffer->mCurrentState == pBufferBarriers[i].mNewState && !pBufferBarriers[i].mSplit)
+			continue;
+		pBuffer->mPreviousState = pBuffer->mCurrentState;
+		pBuffer->mCurrentState = pBufferBarriers[i].mNewState;
+	}
+
+	for (uint32_t i = 0; i < numTextureBarriers; ++i)
+	{
+		Texture* pTexture = pTextureBarriers[i].pTexture;
+		if (pTextureBarriers[i].mSubresourceBarrier)
+			continue;
+		if (pTexture->mCurrentState == pTextureBarriers[i].mNewState && !pTextureBarriers[i].mSplit)
+			continue;
+		pTexture->mPreviousState = pTexture->mCurrentState;
+		pTexture->mCurrentState = pTextureBarriers[i].mNewState;
+	}
+
+	NullResourceBarrierCmd* pBarrier = util_record_cmd<NullResourceBarrierCmd>(pCmd, NULL_CMD_TYPE_cmdResourceBarrier);
+	pBarrier->mBufferBarrierCount = numBufferBarriers;
+	pBarrier->mTextureBarrierCount = numTextureBarriers;
+}
+
+void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers, uint32_t numTextures, Texture** ppTextures, bool batch)
+{
+	UNREF_PARAM(ppBuffers);
+	UNREF_PARAM(ppTextures);
+	UNREF_PARAM(batch);
+
+	if (!util_is_recording(pCmd))
+		return;
+
+	NullResourceBarrierCmd* pBarrier = util_record_cmd<NullResourceBarrierCmd>(pCmd, NULL_CMD_TYPE_cmdResourceBarrier);
+	pBarrier->mBufferBarrierCount = numBuffers;
+	pBarrier->mTextureBarrierCount = numTextures;
+}
+
+void cmdFlushBarriers(Cmd* pCmd) { UNREF_PARAM(pCmd); }
+/************************************************************************/
+// Queue Fence Semaphore Functions
+/************************************************************************/
+void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex)
+{
+	ASSERT(pRenderer);
+	ASSERT(pSignalSemaphore || pFence);
+
+	*pImageIndex = pSwapChain->mCurrentImageIndex;
+	pSwapChain->mCurrentImageIndex = (pSwapChain->mCurrentImageIndex + 1) % pSwapChain->mDesc.mImageCount;
+
+	if (pFence != NULL)
+	{
+		pFence->mCompletionTime = getUSec();
+		pFence->mSubmitted = true;
+	}
+	else
+	{
+		pSignalSemaphore->mSignaled = true;
+	}
+
+	pRenderer->mCurrentFrameIdx = (pRenderer->mCurrentFrameIdx + 1) % pSwapChain->mDesc.mImageCount;
+}
+
+void queueSubmit(
+	Queue* pQueue, uint32_t cmdCount, Cmd** ppCmds, Fence* pFence, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores,
+	uint32_t signalSemaphoreCount, Semaphore** ppSignalSemaphores)
+{
+	ASSERT(pQueue);
+	ASSERT(cmdCount > 0);
+	ASSERT(ppCmds);
+	if (waitSemaphoreCount > 0)
+	{
+		ASSERT(ppWaitSemaphores);
+	}
+	if (signalSemaphoreCount > 0)
+	{
+		ASSERT(ppSignalSemaphores);
+	}
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		if (ppCmds[i]->mRecording)
+		{
+			LOGF(LogLevel::eERROR, "Cmd buffer at index (%u) is still recording. endCmd must be called before queueSubmit", i);
+			return;
+		}
+	}
+
+	for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
+		ppWaitSemaphores[i]->mSignaled = false;
+
+	for (uint32_t i = 0; i < cmdCount; ++i)
+		execute_cmd_stream(ppCmds[i]);
+
+	// Work on the same queue executes in order: the simulated latency starts once the queue is idle
+	const int64_t now = getUSec();
+	const int64_t start = pQueue->mIdleTime > now ? pQueue->mIdleTime : now;
+	pQueue->mIdleTime = start + pQueue->pRenderer->mSettings.mSimulatedGpuLatencyUs;
+
+	if (pFence)
+	{
+		pFence->mCompletionTime = pQueue->mIdleTime;
+		pFence->mSubmitted = true;
+	}
+
+	for (uint32_t i = 0; i < signalSemaphoreCount; ++i)
+		ppSignalSemaphores[i]->mSignaled = true;
+}
+
+void queuePresent(Queue* pQueue, SwapChain* pSwapChain, uint32_t swapChainImageIndex, uint32_t waitSemaphoreCount, Semaphore** ppWaitSemaphores)
+{
+	ASSERT(pQueue);
+	ASSERT(pSwapChain);
+	ASSERT(swapChainImageIndex < pSwapChain->mDesc.mImageCount);
+
+	for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
+		ppWaitSemaphores[i]->mSignaled = false;
+
+	// Presentation is only visible once the queue finished the frame
+	if (pSwapChain->mDesc.mEnableVsync)
+		util_wait_until(pQueue->mIdleTime);
+}
+
+void waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences)
+{
+	ASSERT(pRenderer);
+	ASSERT(fenceCount);
+	ASSERT(ppFences);
+
+	int64_t completionTime = 0;
+	for (uint32_t i = 0; i < fenceCount; ++i)
+	{
+		if (ppFences[i]->mSubmitted && ppFences[i]->mCompletionTime > completionTime)
+			completionTime = ppFences[i]->mCompletionTime;
+	}
+
+	util_wait_until(completionTime);
+
+	for (uint32_t i = 0; i < fenceCount; ++i)
+		ppFences[i]->mSubmitted = false;
+}
+
+void waitQueueIdle(Queue* pQueue) { util_wait_until(pQueue->mIdleTime); }
+
+void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
+{
+	UNREF_PARAM(pRenderer);
+
+	if (pFence->mSubmitted)
+	{
+		const bool completed = getUSec() >= pFence->mCompletionTime;
+		if (completed)
+			pFence->mSubmitted = false;
+
+		*pFenceStatus = completed ? FENCE_STATUS_COMPLETE : FENCE_STATUS_INCOMPLETE;
+	}
+	else
+	{
+		*pFenceStatus = FENCE_STATUS_NOTSUBMITTED;
+	}
+}
+
+void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
+{
+	UNREF_PARAM(pRenderer);
+	(*ppSwapChain)->mDesc.mEnableVsync = !(*ppSwapChain)->mDesc.mEnableVsync;
+}
+/************************************************************************/
+// Utility functions
+/************************************************************************/
+bool isImageFormatSupported(ImageFormat::Enum format) { return ImageFormat::GetBytesPerBlock(format) > 0; }
+
+ImageFormat::Enum getRecommendedSwapchainFormat(bool hintHDR)
+{
+	UNREF_PARAM(hintHDR);
+	return ImageFormat::BGRA8;
+}
+/************************************************************************/
+// Indirect Draw functions
+/************************************************************************/
+void addIndirectCommandSignature(Renderer* pRenderer, const CommandSignatureDesc* pDesc, CommandSignature** ppCommandSignature)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+
+	CommandSignature* pCommandSignature = (CommandSignature*)conf_calloc(1, sizeof(CommandSignature));
+	pCommandSignature->mDesc = *pDesc;
+
+	for (uint32_t i = 0; i < pDesc->mIndirectArgCount; ++i)    // counting for all types;
+	{
+		switch (pDesc->pArgDescs[i].mType)
+		{
+			case INDIRECT_DRAW:
+				pCommandSignature->mDrawType = INDIRECT_DRAW;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDrawArguments);
+				break;
+			case INDIRECT_DRAW_INDEX:
+				pCommandSignature->mDrawType = INDIRECT_DRAW_INDEX;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDrawIndexArguments);
+				break;
+			case INDIRECT_DISPATCH:
+				pCommandSignature->mDrawType = INDIRECT_DISPATCH;
+				pCommandSignature->mDrawCommandStride += sizeof(IndirectDispatchArguments);
+				break;
+			default: LOGF(LogLevel::eERROR, "Null runtime only supports IndirectDraw, IndirectDrawIndex and IndirectDispatch at this point"); break;
+		}
+	}
+
+	pCommandSignature->mDrawCommandStride = round_up(pCommandSignature->mDrawCommandStride, 16);
+
+	*ppCommandSignature = pCommandSignature;
+}
+
+void removeIndirectCommandSignature(Renderer* pRenderer, CommandSignature* pCommandSignature) { SAFE_FREE(pCommandSignature); }
+
+void cmdExecuteIndirect(
+	Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset,
+	Buffer* pCounterBuffer, uint64_t counterBufferOffset)
+{
+	ASSERT(pCommandSignature);
+	ASSERT(pIndirectBuffer);
+
+	if (pCommandSignature->mDrawType == INDIRECT_DISPATCH ? !util_is_recording(pCmd) : !util_validate_draw(pCmd))
+		return;
+
+	if (bufferOffset + (uint64_t)maxCommandCount * pCommandSignature->mDrawCommandStride > pIndirectBuffer->mDesc.mSize &&
+		!pCounterBuffer)
+	{
+		LOGF(LogLevel::eERROR, "Indirect arguments read past the end of the indirect buffer");
+		return;
+	}
+
+	NullExecuteIndirectCmd* pExecute = util_record_cmd<NullExecuteIndirectCmd>(pCmd, NULL_CMD_TYPE_cmdExecuteIndirect);
+	pExecute->pCommandSignature = pCommandSignature;
+	pExecute->pIndirectBuffer = pIndirectBuffer;
+	pExecute->mBufferOffset = bufferOffset;
+	pExecute->pCounterBuffer = pCounterBuffer;
+	pExecute->mCounterBufferOffset = counterBufferOffset;
+	pExecute->mMaxCommandCount = maxCommandCount;
+}
+/************************************************************************/
+// GPU Query Implementation
+/************************************************************************/
+void getTimestampFrequency(Queue* pQueue, double* pFrequency)
+{
+	UNREF_PARAM(pQueue);
+	// Queries are resolved with getUSec
+	*pFrequency = (double)getTimerFrequency();
+}
+
+void addQueryHeap(Renderer* pRenderer, const QueryHeapDesc* pDesc, QueryHeap** ppQueryHeap)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+
+	QueryHeap* pQueryHeap = (QueryHeap*)conf_calloc(1, sizeof(*pQueryHeap));
+	pQueryHeap->mDesc = *pDesc;
+	pQueryHeap->pTimestamps = (uint64_t*)conf_calloc(pDesc->mQueryCount, sizeof(uint64_t));
+
+	*ppQueryHeap = pQueryHeap;
+}
+
+void removeQueryHeap(Renderer* pRenderer, QueryHeap* pQueryHeap)
+{
+	UNREF_PARAM(pRenderer);
+
+	SAFE_FREE(pQueryHeap->pTimestamps);
+	SAFE_FREE(pQueryHeap);
+}
+
+void cmdBeginQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pQuery->mIndex < pQueryHeap->mDesc.mQueryCount);
+
+	NullQueryCmd* pQueryCmd = util_record_cmd<NullQueryCmd>(pCmd, NULL_CMD_TYPE_cmdBeginQuery);
+	pQueryCmd->pQueryHeap = pQueryHeap;
+	pQueryCmd->mIndex = pQuery->mIndex;
+}
+
+void cmdEndQuery(Cmd* pCmd, QueryHeap* pQueryHeap, QueryDesc* pQuery)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(pQuery->mIndex < pQueryHeap->mDesc.mQueryCount);
+
+	NullQueryCmd* pQueryCmd = util_record_cmd<NullQueryCmd>(pCmd, NULL_CMD_TYPE_cmdEndQuery);
+	pQueryCmd->pQueryHeap = pQueryHeap;
+	pQueryCmd->mIndex = pQuery->mIndex;
+}
+
+void cmdResolveQuery(Cmd* pCmd, QueryHeap* pQueryHeap, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	ASSERT(startQuery + queryCount <= pQueryHeap->mDesc.mQueryCount);
+	ASSERT((uint64_t)(startQuery + queryCount) * sizeof(uint64_t) <= pReadbackBuffer->mDesc.mSize);
+
+	NullResolveQueryCmd* pResolve = util_record_cmd<NullResolveQueryCmd>(pCmd, NULL_CMD_TYPE_cmdResolveQuery);
+	pResolve->pQueryHeap = pQueryHeap;
+	pResolve->pReadbackBuffer = pReadbackBuffer;
+	pResolve->mStartQuery = startQuery;
+	pResolve->mQueryCount = queryCount;
+}
+/************************************************************************/
+// Memory Stats Implementation
+/************************************************************************/
+void calculateMemoryStats(Renderer* pRenderer, char** stats)
+{
+	UNREF_PARAM(pRenderer);
+
+	*stats = (char*)conf_calloc(128, sizeof(char));
+	snprintf(
+		*stats, 128, "{ \"NullRenderer\": { \"AllocatedBytes\": %llu } }",
+		(unsigned long long)tfrg_atomic64_load_relaxed(&gAllocatedBytes));
+}
+
+void freeMemoryStats(Renderer* pRenderer, char* stats)
+{
+	UNREF_PARAM(pRenderer);
+	SAFE_FREE(stats);
+}
+/************************************************************************/
+// Debug Marker Implementation
+/************************************************************************/
+static void util_record_debug_marker(Cmd* pCmd, NullCmdType type, float r, float g, float b, const char* pName)
+{
+	const uint32_t nameLength = pName ? (uint32_t)strlen(pName) : 0;
+
+	NullDebugMarkerCmd* pMarker = util_record_cmd<NullDebugMarkerCmd>(pCmd, type, nameLength + 1);
+	pMarker->r = r;
+	pMarker->g = g;
+	pMarker->b = b;
+	pMarker->mNameLength = nameLength;
+	if (nameLength)
+		memcpy(pMarker + 1, pName, nameLength);
+}
+
+void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	util_record_debug_marker(pCmd, NULL_CMD_TYPE_cmdBeginDebugMarker, r, g, b, pName);
+}
+
+void cmdEndDebugMarker(Cmd* pCmd)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	util_record_cmd<NullCmdHeader>(pCmd, NULL_CMD_TYPE_cmdEndDebugMarker, 0);
+}
+
+void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+	if (!util_is_recording(pCmd))
+		return;
+
+	util_record_debug_marker(pCmd, NULL_CMD_TYPE_cmdAddDebugMarker, r, g, b, pName);
+}
+/************************************************************************/
+// Resource Debug Naming Interface
+/************************************************************************/
+void setBufferName(Renderer* pRenderer, Buffer* pBuffer, const char* pName) {}
+
+void setTextureName(Renderer* pRenderer, Texture* pTexture, const char* pName) {}
+#endif    // NULL_RENDERER
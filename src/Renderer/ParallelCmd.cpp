@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "IRenderer.h"
+#include "ParallelCmd.h"
+#include "OS/Core/ThreadSystem.h"
+#include "Interfaces/ILog.h"
+#include "Interfaces/IMemory.h"
+
+typedef struct SecondaryCmdTaskData
+{
+	Cmd**            ppSecondaryCmds;
+	SecondaryCmdFunc pFunc;
+	void*            pUserData;
+} SecondaryCmdTaskData;
+
+static void recordSecondaryCmdTask(void* pUser, uintptr_t index)
+{
+	SecondaryCmdTaskData* pData = (SecondaryCmdTaskData*)pUser;
+	Cmd*                  pCmd = pData->ppSecondaryCmds[index];
+	pData->pFunc(pCmd, (uint32_t)index, pData->pUserData);
+	endCmd(pCmd);
+}
+
+void cmdRecordSecondaryCmds(
+	Cmd* pPrimaryCmd, ThreadSystem* pThreadSystem, uint32_t cmdCount, Cmd** ppSecondaryCmds, SecondaryCmdFunc pFunc, void* pUserData)
+{
+	ASSERT(pPrimaryCmd);
+	ASSERT(ppSecondaryCmds);
+	ASSERT(pFunc);
+
+	if (!cmdCount)
+		return;
+
+	// Begin in index order: Metal executes the secondaries in the order they were begun
+	for (uint32_t i = 0; i < cmdCount; ++i)
+		beginSecondaryCmd(ppSecondaryCmds[i], pPrimaryCmd);
+
+	SecondaryCmdTaskData data = { ppSecondaryCmds, pFunc, pUserData };
+	if (pThreadSystem && cmdCount > 1)
+	{
+		TaskGroup* pGroup = NULL;
+		addTaskGroup(pThreadSystem, &pGroup);
+
+		TaskDesc taskDesc = {};
+		taskDesc.pTask = recordSecondaryCmdTask;
+		taskDesc.pUser = &data;
+		taskDesc.mStart = 0;
+		taskDesc.mEnd = cmdCount;
+		taskDesc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &taskDesc);
+
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+		removeTaskGroup(pThreadSystem, pGroup);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < cmdCount; ++i)
+			recordSecondaryCmdTask(&data, i);
+	}
+
+	cmdExecuteSecondaryCmds(pPrimaryCmd, cmdCount, ppSecondaryCmds);
+}
@@ -0,0 +1,837 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "EASTL/sort.h"
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+
+#include "IRenderer.h"
+#include "RenderGraph.h"
+#include "Interfaces/ILog.h"
+#include "Interfaces/IMemory.h"
+
+typedef enum RenderGraphResourceType
+{
+	RENDER_GRAPH_RESOURCE_TEXTURE = 0,
+	RENDER_GRAPH_RESOURCE_RENDER_TARGET,
+	RENDER_GRAPH_RESOURCE_BUFFER,
+	RENDER_GRAPH_RESOURCE_TRANSIENT,
+} RenderGraphResourceType;
+
+typedef struct RenderGraphResourceNode
+{
+	eastl::string           mName;
+	RenderGraphResourceType mType;
+	Texture*                pTexture;
+	RenderTarget*           pRenderTarget;
+	Buffer*                 pBuffer;
+	/// Transient render targets only
+	RenderTargetDesc        mDesc;
+	ResourceState           mInitialState;
+	ResourceState           mFinalState;
+	uint32_t                mMipLevels;
+	uint32_t                mArraySize;
+	/// Lifetime in live passes, UINT32_MAX if no live pass uses the resource
+	uint32_t                mFirstPass;
+	uint32_t                mLastPass;
+	uint32_t                mPhysicalIndex;
+} RenderGraphResourceNode;
+
+typedef struct RenderGraphPassNode
+{
+	eastl::string       mName;
+	RenderGraphPassFunc pExecute;
+	void*               pUserData;
+	uint32_t            mFirstAccess;
+	uint32_t            mAccessCount;
+	bool                mSideEffects;
+	bool                mCulled;
+} RenderGraphPassNode;
+
+/// Render target shared by transient render targets with the same desc and disjoint lifetimes
+typedef struct PhysicalRenderTarget
+{
+	RenderTargetDesc mDesc;
+	uint64_t         mSize;
+	uint32_t         mLastPass;
+	/// State the graph leaves the render target in
+	ResourceState    mFinalState;
+	uint32_t         mPoolIndex;
+} PhysicalRenderTarget;
+
+typedef struct PooledRenderTarget
+{
+	RenderTargetDesc mDesc;
+	RenderTarget*    pRenderTarget;
+	bool             mUsed;
+} PooledRenderTarget;
+
+/// Subresource states while compiling. Imported resources have their own, transient render targets the one of their physical render target
+typedef struct RenderGraphStateSlot
+{
+	eastl::vector<ResourceState> mStates;
+	uint32_t                     mLastAccessPass;
+	bool                         mLastWrite;
+	bool                         mPassWrite;
+} RenderGraphStateSlot;
+
+typedef struct RenderGraph
+{
+	Renderer*                              pRenderer;
+	eastl::vector<RenderGraphResourceNode> mResources;
+	eastl::vector<RenderGraphPassNode>     mPasses;
+	eastl::vector<RenderGraphAccess>       mAccesses;
+	eastl::vector<RenderGraphBarrier>      mBarriers;
+	eastl::vector<PhysicalRenderTarget>    mPhysicalRenderTargets;
+	eastl::vector<PooledRenderTarget>      mRenderTargetPool;
+	/// Scratch memory of executeRenderGraph
+	eastl::vector<TextureBarrier>          mTextureBarriers;
+	eastl::vector<BufferBarrier>           mBufferBarriers;
+	uint64_t                               mTransientSize;
+	bool                                   mCompiled;
+	bool                                   mPhysicalRenderTargetsBound;
+} RenderGraph;
+
+// States which only allow reads and can be combined with other read states
+static const ResourceState gWriteStates = RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_UNORDERED_ACCESS | RESOURCE_STATE_DEPTH_WRITE |
+										  RESOURCE_STATE_STREAM_OUT | RESOURCE_STATE_COPY_DEST | RESOURCE_STATE_COMMON;
+
+static inline bool isReadOnlyState(ResourceState state) { return state != RESOURCE_STATE_UNDEFINED && !(state & gWriteStates); }
+
+static bool isRenderTargetDescEqual(const RenderTargetDesc* pA, const RenderTargetDesc* pB)
+{
+	return pA->mFlags == pB->mFlags && pA->mWidth == pB->mWidth && pA->mHeight == pB->mHeight && pA->mDepth == pB->mDepth &&
+		   pA->mArraySize == pB->mArraySize && pA->mMipLevels == pB->mMipLevels && pA->mSampleCount == pB->mSampleCount &&
+		   pA->mFormat == pB->mFormat && pA->mSampleQuality == pB->mSampleQuality && pA->mDescriptors == pB->mDescriptors &&
+		   pA->mNodeIndex == pB->mNodeIndex && pA->mSrgb == pB->mSrgb &&
+		   memcmp(&pA->mClearValue, &pB->mClearValue, sizeof(ClearValue)) == 0;
+}
+
+static uint64_t getRenderTargetSize(const RenderTargetDesc* pDesc)
+{
+	uint64_t texels = 0;
+	for (uint32_t mip = 0; mip < max(pDesc->mMipLevels, 1U); ++mip)
+	{
+		texels += (uint64_t)max(pDesc->mWidth >> mip, 1U) * max(pDesc->mHeight >> mip, 1U) * max(pDesc->mDepth >> mip, 1U);
+	}
+	return texels * max(pDesc->mArraySize, 1U) * ImageFormat::GetBytesPerPixel(pDesc->mFormat) * (uint32_t)pDesc->mSampleCount;
+}
+
+static void getAccessRange(
+	const RenderGraphResourceNode* pNode, const RenderGraphAccess* pAccess, uint32_t* pMip, uint32_t* pMipCount, uint32_t* pLayer,
+	uint32_t* pLayerCount)
+{
+	*pMip = pAccess->mMipLevel;
+	*pMipCount = pAccess->mMipCount ? pAccess->mMipCount : pNode->mMipLevels - pAccess->mMipLevel;
+	*pLayer = pAccess->mArrayLayer;
+	*pLayerCount = pAccess->mArrayLayerCount ? pAccess->mArrayLayerCount : pNode->mArraySize - pAccess->mArrayLayer;
+}
+
+static bool isWholeResourceAccess(const RenderGraphResourceNode* pNode, const RenderGraphAccess* pAccess)
+{
+	uint32_t mip, mipCount, layer, layerCount;
+	getAccessRange(pNode, pAccess, &mip, &mipCount, &layer, &layerCount);
+	return mip == 0 && mipCount == pNode->mMipLevels && layer == 0 && layerCount == pNode->mArraySize;
+}
+
+static Texture* getNodeTexture(const RenderGraph* pGraph, const RenderGraphResourceNode* pNode)
+{
+	switch (pNode->mType)
+	{
+		case RENDER_GRAPH_RESOURCE_TEXTURE: return pNode->pTexture;
+		case RENDER_GRAPH_RESOURCE_RENDER_TARGET: return pNode->pRenderTarget->pTexture;
+		case RENDER_GRAPH_RESOURCE_TRANSIENT:
+		{
+			RenderTarget* pRenderTarget = getRenderGraphRenderTarget(pGraph, (RenderGraphResource)(pNode - pGraph->mResources.data()));
+			return pRenderTarget ? pRenderTarget->pTexture : NULL;
+		}
+		default: return NULL;
+	}
+}
+/************************************************************************/
+// Graph Building
+/************************************************************************/
+void addRenderGraph(Renderer* pRenderer, RenderGraph** ppGraph)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppGraph);
+
+	RenderGraph* pGraph = conf_new(RenderGraph);
+	pGraph->pRenderer = pRenderer;
+	*ppGraph = pGraph;
+}
+
+void removeRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mRenderTargetPool.size(); ++i)
+		removeRenderTarget(pGraph->pRenderer, pGraph->mRenderTargetPool[i].pRenderTarget);
+
+	conf_delete(pGraph);
+}
+
+void resetRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	pGraph->mResources.clear();
+	pGraph->mPasses.clear();
+	pGraph->mAccesses.clear();
+	pGraph->mBarriers.clear();
+	pGraph->mPhysicalRenderTargets.clear();
+	pGraph->mTransientSize = 0;
+	pGraph->mCompiled = false;
+	pGraph->mPhysicalRenderTargetsBound = false;
+}
+
+RenderGraphResource importRenderGraphResource(RenderGraph* pGraph, const RenderGraphImportDesc* pDesc)
+{
+	ASSERT(pGraph);
+	ASSERT(pDesc);
+
+	if ((pDesc->pTexture != NULL) + (pDesc->pRenderTarget != NULL) + (pDesc->pBuffer != NULL) != 1)
+	{
+		LOGF(LogLevel::eERROR, "Render graph import of %s needs exactly one of pTexture, pRenderTarget, pBuffer", pDesc->pName ? pDesc->pName : "");
+		return RENDER_GRAPH_RESOURCE_NONE;
+	}
+
+	RenderGraphResourceNode node = {};
+	node.mName = pDesc->pName ? pDesc->pName : "";
+	node.pTexture = pDesc->pTexture;
+	node.pRenderTarget = pDesc->pRenderTarget;
+	node.pBuffer = pDesc->pBuffer;
+	node.mMipLevels = 1;
+	node.mArraySize = 1;
+	ResourceState currentState = RESOURCE_STATE_UNDEFINED;
+	if (pDesc->pTexture)
+	{
+		node.mType = RENDER_GRAPH_RESOURCE_TEXTURE;
+		node.mMipLevels = max(pDesc->pTexture->mDesc.mMipLevels, 1U);
+		node.mArraySize = max(pDesc->pTexture->mDesc.mArraySize, 1U);
+		currentState = pDesc->pTexture->mCurrentState;
+	}
+	else if (pDesc->pRenderTarget)
+	{
+		node.mType = RENDER_GRAPH_RESOURCE_RENDER_TARGET;
+		node.mMipLevels = max(pDesc->pRenderTarget->mDesc.mMipLevels, 1U);
+		node.mArraySize = max(pDesc->pRenderTarget->mDesc.mArraySize, 1U);
+		currentState = pDesc->pRenderTarget->pTexture->mCurrentState;
+	}
+	else
+	{
+		node.mType = RENDER_GRAPH_RESOURCE_BUFFER;
+		currentState = pDesc->pBuffer->mCurrentState;
+	}
+	node.mInitialState = pDesc->mInitialState != RESOURCE_STATE_UNDEFINED ? pDesc->mInitialState : currentState;
+	node.mFinalState = pDesc->mFinalState != RESOURCE_STATE_UNDEFINED ? pDesc->mFinalState : node.mInitialState;
+
+	pGraph->mResources.push_back(node);
+	pGraph->mCompiled = false;
+	return (RenderGraphResource)pGraph->mResources.size() - 1;
+}
+
+RenderGraphResource addRenderGraphRenderTarget(RenderGraph* pGraph, const RenderTargetDesc* pDesc, const char* pName)
+{
+	ASSERT(pGraph);
+	ASSERT(pDesc);
+	ASSERT(!pDesc->pNativeHandle && "Transient render targets are created by the render graph");
+
+	RenderGraphResourceNode node = {};
+	node.mName = pName ? pName : "";
+	node.mType = RENDER_GRAPH_RESOURCE_TRANSIENT;
+	node.mDesc = *pDesc;
+	node.mDesc.mMipLevels = max(pDesc->mMipLevels, 1U);
+	node.mDesc.mArraySize = max(pDesc->mArraySize, 1U);
+	node.mDesc.mDepth = max(pDesc->mDepth, 1U);
+	node.mMipLevels = node.mDesc.mMipLevels;
+	node.mArraySize = node.mDesc.mArraySize;
+
+	pGraph->mResources.push_back(node);
+	pGraph->mCompiled = false;
+	return (RenderGraphResource)pGraph->mResources.size() - 1;
+}
+
+uint32_t addRenderGraphPass(RenderGraph* pGraph, const RenderGraphPassDesc* pDesc)
+{
+	ASSERT(pGraph);
+	ASSERT(pDesc);
+	ASSERT(pDesc->mAccessCount == 0 || pDesc->pAccesses);
+
+	RenderGraphPassNode pass = {};
+	pass.mName = pDesc->pName ? pDesc->pName : "";
+	pass.pExecute = pDesc->pExecute;
+	pass.pUserData = pDesc->pUserData;
+	pass.mFirstAccess = (uint32_t)pGraph->mAccesses.size();
+	pass.mAccessCount = pDesc->mAccessCount;
+	pass.mSideEffects = pDesc->mSideEffects;
+	pGraph->mAccesses.insert(pGraph->mAccesses.end(), pDesc->pAccesses, pDesc->pAccesses + pDesc->mAccessCount);
+
+	pGraph->mPasses.push_back(pass);
+	pGraph->mCompiled = false;
+	return (uint32_t)pGraph->mPasses.size() - 1;
+}
+/************************************************************************/
+// Compilation
+/************************************************************************/
+static bool hasLivePassBetween(const RenderGraph* pGraph, uint32_t firstPass, uint32_t lastPass)
+{
+	for (uint32_t p = firstPass + 1; p < lastPass; ++p)
+	{
+		if (!pGraph->mPasses[p].mCulled)
+			return true;
+	}
+	return false;
+}
+
+static bool needsTransition(ResourceState currentState, ResourceState newState, bool write, bool lastWrite, bool exact)
+{
+	// Unordered access after unordered access only needs a barrier if one of them writes
+	if (currentState == RESOURCE_STATE_UNORDERED_ACCESS && newState == RESOURCE_STATE_UNORDERED_ACCESS)
+		return write || lastWrite;
+	if (currentState == newState)
+		return false;
+	// A combined read state already covers the reads it contains
+	return exact || write || !isReadOnlyState(currentState) || (currentState & newState) != newState;
+}
+
+// Reads until the next write of the resource are merged into one read state, so the resource is not transitioned
+// between them. Textures only merge the shader resource states (they need a single layout)
+static ResourceState getMergedReadState(const RenderGraph* pGraph, uint32_t pass, const RenderGraphAccess* pAccess)
+{
+	const RenderGraphResourceNode* pNode = &pGraph->mResources[pAccess->mResource];
+	const bool                     buffer = pNode->mType == RENDER_GRAPH_RESOURCE_BUFFER;
+	const ResourceState            mergeableStates = buffer ? (ResourceState)~gWriteStates : RESOURCE_STATE_SHADER_RESOURCE;
+
+	ResourceState state = pAccess->mState;
+	if (!isReadOnlyState(state) || (state & ~mergeableStates))
+		return state;
+
+	for (uint32_t p = pass + 1; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		const RenderGraphPassNode* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess* pNext = &pGraph->mAccesses[pPass->mFirstAccess + a];
+			if (pNext->mResource != pAccess->mResource)
+				continue;
+			if (pNext->mWrite || !isReadOnlyState(pNext->mState) || (pNext->mState & ~mergeableStates))
+				return state;
+			state |= pNext->mState;
+		}
+	}
+
+	return state;
+}
+
+static void addTransition(
+	RenderGraph* pGraph, RenderGraphStateSlot* pSlot, RenderGraphResource resource, const RenderGraphResourceNode* pNode, uint32_t mip,
+	uint32_t mipCount, uint32_t layer, uint32_t layerCount, ResourceState newState, bool write, uint32_t pass, bool exact)
+{
+	const uint32_t subresourceCount = (uint32_t)pSlot->mStates.size();
+
+	bool undefined = true;
+	for (uint32_t i = 0; i < subresourceCount && undefined; ++i)
+		undefined = pSlot->mStates[i] == RESOURCE_STATE_UNDEFINED;
+	// Contents of a render target used for the first time are undefined, transition all of it at once
+	if (undefined)
+	{
+		mip = 0;
+		mipCount = pNode->mMipLevels;
+		layer = 0;
+		layerCount = pNode->mArraySize;
+	}
+
+	bool uniform = mip == 0 && mipCount == pNode->mMipLevels && layer == 0 && layerCount == pNode->mArraySize;
+	for (uint32_t i = 1; i < subresourceCount && uniform; ++i)
+		uniform = pSlot->mStates[i] == pSlot->mStates[0];
+
+	if (uniform)
+	{
+		const ResourceState currentState = pSlot->mStates[0];
+		if (!needsTransition(currentState, newState, write, pSlot->mLastWrite, exact))
+			return;
+
+		RenderGraphBarrier barrier = {};
+		barrier.mPass = pass;
+		barrier.mResource = resource;
+		barrier.mOldState = currentState;
+		barrier.mNewState = newState;
+		barrier.mType = RENDER_GRAPH_BARRIER_FULL;
+
+		// Let the GPU start the transition as soon as the previous user is done with the resource
+		if (currentState != newState && currentState != RESOURCE_STATE_UNDEFINED && pSlot->mLastAccessPass != UINT32_MAX &&
+			hasLivePassBetween(pGraph, pSlot->mLastAccessPass, pass))
+		{
+			RenderGraphBarrier begin = barrier;
+			begin.mPass = pSlot->mLastAccessPass + 1;
+			begin.mType = RENDER_GRAPH_BARRIER_BEGIN;
+			pGraph->mBarriers.push_back(begin);
+			barrier.mType = RENDER_GRAPH_BARRIER_END;
+		}
+		pGraph->mBarriers.push_back(barrier);
+
+		for (uint32_t i = 0; i < subresourceCount; ++i)
+			pSlot->mStates[i] = newState;
+		return;
+	}
+
+	for (uint32_t l = layer; l < layer + layerCount; ++l)
+	{
+		for (uint32_t m = mip; m < mip + mipCount; ++m)
+		{
+			ResourceState& state = pSlot->mStates[l * pNode->mMipLevels + m];
+			if (!needsTransition(state, newState, write, pSlot->mLastWrite, exact))
+				continue;
+
+			RenderGraphBarrier barrier = {};
+			barrier.mPass = pass;
+			barrier.mResource = resource;
+			barrier.mOldState = state;
+			barrier.mNewState = newState;
+			barrier.mType = RENDER_GRAPH_BARRIER_FULL;
+			barrier.mSubresource = true;
+			barrier.mMipLevel = m;
+			barrier.mArrayLayer = l;
+			pGraph->mBarriers.push_back(barrier);
+
+			state = newState;
+		}
+	}
+}
+
+static void cullPasses(RenderGraph* pGraph)
+{
+	// Walk the passes backwards starting from the imported resources and the passes with side effects
+	eastl::vector<bool> needed(pGraph->mResources.size());
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+		needed[r] = pGraph->mResources[r].mType != RENDER_GRAPH_RESOURCE_TRANSIENT;
+
+	for (uint32_t p = (uint32_t)pGraph->mPasses.size(); p-- > 0;)
+	{
+		RenderGraphPassNode*     pPass = &pGraph->mPasses[p];
+		const RenderGraphAccess* pAccesses = &pGraph->mAccesses[pPass->mFirstAccess];
+
+		pPass->mCulled = !pPass->mSideEffects;
+		for (uint32_t a = 0; a < pPass->mAccessCount && pPass->mCulled; ++a)
+			pPass->mCulled = !(pAccesses[a].mWrite && needed[pAccesses[a].mResource]);
+		if (pPass->mCulled)
+			continue;
+
+		// Earlier writes of a transient render target this pass overwrites completely are dead
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphResourceNode* pNode = &pGraph->mResources[pAccesses[a].mResource];
+			if (!pAccesses[a].mWrite || pNode->mType != RENDER_GRAPH_RESOURCE_TRANSIENT || !isWholeResourceAccess(pNode, &pAccesses[a]))
+				continue;
+
+			bool read = false;
+			for (uint32_t b = 0; b < pPass->mAccessCount && !read; ++b)
+				read = !pAccesses[b].mWrite && pAccesses[b].mResource == pAccesses[a].mResource;
+			if (!read)
+				needed[pAccesses[a].mResource] = false;
+		}
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			if (!pAccesses[a].mWrite)
+				needed[pAccesses[a].mResource] = true;
+		}
+	}
+}
+
+static void planTransientMemory(RenderGraph* pGraph)
+{
+	eastl::vector<RenderGraphResource> transients;
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		RenderGraphResourceNode* pNode = &pGraph->mResources[r];
+		if (pNode->mType == RENDER_GRAPH_RESOURCE_TRANSIENT && pNode->mFirstPass != UINT32_MAX)
+			transients.push_back(r);
+	}
+
+	const RenderGraph* pConstGraph = pGraph;
+	eastl::stable_sort(transients.begin(), transients.end(), [pConstGraph](RenderGraphResource a, RenderGraphResource b) {
+		return pConstGraph->mResources[a].mFirstPass < pConstGraph->mResources[b].mFirstPass;
+	});
+
+	// Greedy assignment in order of first use: a transient takes over the render target of a transient with the same desc
+	// whose last pass is done. No placed resources in the API, so aliasing happens at render target granularity
+	for (uint32_t t = 0; t < (uint32_t)transients.size(); ++t)
+	{
+		RenderGraphResourceNode* pNode = &pGraph->mResources[transients[t]];
+		pGraph->mTransientSize += getRenderTargetSize(&pNode->mDesc);
+
+		uint32_t physical = UINT32_MAX;
+		for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysicalRenderTargets.size() && physical == UINT32_MAX; ++i)
+		{
+			const PhysicalRenderTarget* pPhysical = &pGraph->mPhysicalRenderTargets[i];
+			if (pPhysical->mLastPass < pNode->mFirstPass && isRenderTargetDescEqual(&pPhysical->mDesc, &pNode->mDesc))
+				physical = i;
+		}
+
+		if (physical == UINT32_MAX)
+		{
+			PhysicalRenderTarget newPhysical = {};
+			newPhysical.mDesc = pNode->mDesc;
+			newPhysical.mSize = getRenderTargetSize(&pNode->mDesc);
+			newPhysical.mPoolIndex = UINT32_MAX;
+			pGraph->mPhysicalRenderTargets.push_back(newPhysical);
+			physical = (uint32_t)pGraph->mPhysicalRenderTargets.size() - 1;
+		}
+
+		pGraph->mPhysicalRenderTargets[physical].mLastPass = pNode->mLastPass;
+		pNode->mPhysicalIndex = physical;
+	}
+}
+
+bool compileRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	const uint32_t passCount = (uint32_t)pGraph->mPasses.size();
+	const uint32_t resourceCount = (uint32_t)pGraph->mResources.size();
+
+	for (uint32_t a = 0; a < (uint32_t)pGraph->mAccesses.size(); ++a)
+	{
+		const RenderGraphAccess* pAccess = &pGraph->mAccesses[a];
+		if (pAccess->mResource >= resourceCount)
+		{
+			LOGF(LogLevel::eERROR, "Render graph access of unknown resource %u", pAccess->mResource);
+			return false;
+		}
+
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[pAccess->mResource];
+		uint32_t                       mip, mipCount, layer, layerCount;
+		getAccessRange(pNode, pAccess, &mip, &mipCount, &layer, &layerCount);
+		if (mip + mipCount > pNode->mMipLevels || layer + layerCount > pNode->mArraySize || !mipCount || !layerCount)
+		{
+			LOGF(LogLevel::eERROR, "Render graph access of %s is out of its subresource range", pNode->mName.c_str());
+			return false;
+		}
+	}
+
+	pGraph->mBarriers.clear();
+	pGraph->mPhysicalRenderTargets.clear();
+	pGraph->mTransientSize = 0;
+	pGraph->mPhysicalRenderTargetsBound = false;
+
+	cullPasses(pGraph);
+
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		pGraph->mResources[r].mFirstPass = UINT32_MAX;
+		pGraph->mResources[r].mLastPass = 0;
+		pGraph->mResources[r].mPhysicalIndex = UINT32_MAX;
+	}
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		const RenderGraphPassNode* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			RenderGraphResourceNode* pNode = &pGraph->mResources[pGraph->mAccesses[pPass->mFirstAccess + a].mResource];
+			pNode->mFirstPass = min(pNode->mFirstPass, p);
+			pNode->mLastPass = max(pNode->mLastPass, p);
+		}
+	}
+
+	planTransientMemory(pGraph);
+
+	// State slots: one per resource, transient render targets use the slot of their physical render target
+	eastl::vector<RenderGraphStateSlot> slots(resourceCount + pGraph->mPhysicalRenderTargets.size());
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[r];
+		if (pNode->mType == RENDER_GRAPH_RESOURCE_TRANSIENT)
+			continue;
+		slots[r].mStates.resize(pNode->mMipLevels * pNode->mArraySize, pNode->mInitialState);
+		slots[r].mLastAccessPass = UINT32_MAX;
+		// Writes from before the graph may still be in flight
+		slots[r].mLastWrite = true;
+	}
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysicalRenderTargets.size(); ++i)
+	{
+		const PhysicalRenderTarget* pPhysical = &pGraph->mPhysicalRenderTargets[i];
+		slots[resourceCount + i].mStates.resize(pPhysical->mDesc.mMipLevels * pPhysical->mDesc.mArraySize, RESOURCE_STATE_UNDEFINED);
+		slots[resourceCount + i].mLastAccessPass = UINT32_MAX;
+	}
+
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		const RenderGraphPassNode* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled)
+			continue;
+
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess*       pAccess = &pGraph->mAccesses[pPass->mFirstAccess + a];
+			const RenderGraphResourceNode* pNode = &pGraph->mResources[pAccess->mResource];
+			RenderGraphStateSlot*          pSlot =
+				&slots[pNode->mType == RENDER_GRAPH_RESOURCE_TRANSIENT ? resourceCount + pNode->mPhysicalIndex : pAccess->mResource];
+
+			uint32_t mip, mipCount, layer, layerCount;
+			getAccessRange(pNode, pAccess, &mip, &mipCount, &layer, &layerCount);
+			const ResourceState state = pAccess->mWrite ? pAccess->mState : getMergedReadState(pGraph, p, pAccess);
+			addTransition(pGraph, pSlot, pAccess->mResource, pNode, mip, mipCount, layer, layerCount, state, pAccess->mWrite, p, false);
+			pSlot->mPassWrite = false;
+		}
+
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess*       pAccess = &pGraph->mAccesses[pPass->mFirstAccess + a];
+			const RenderGraphResourceNode* pNode = &pGraph->mResources[pAccess->mResource];
+			RenderGraphStateSlot*          pSlot =
+				&slots[pNode->mType == RENDER_GRAPH_RESOURCE_TRANSIENT ? resourceCount + pNode->mPhysicalIndex : pAccess->mResource];
+			pSlot->mPassWrite |= pAccess->mWrite;
+			pSlot->mLastWrite = pSlot->mPassWrite;
+			pSlot->mLastAccessPass = p;
+		}
+	}
+
+	// Imported resources end in their final state, physical render targets in a single state for the next execution
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[r];
+		if (pNode->mType != RENDER_GRAPH_RESOURCE_TRANSIENT)
+			addTransition(
+				pGraph, &slots[r], r, pNode, 0, pNode->mMipLevels, 0, pNode->mArraySize, pNode->mFinalState, false, passCount, true);
+	}
+	for (uint32_t r = 0; r < resourceCount; ++r)
+	{
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[r];
+		if (pNode->mType != RENDER_GRAPH_RESOURCE_TRANSIENT || pNode->mPhysicalIndex == UINT32_MAX)
+			continue;
+
+		PhysicalRenderTarget* pPhysical = &pGraph->mPhysicalRenderTargets[pNode->mPhysicalIndex];
+		RenderGraphStateSlot* pSlot = &slots[resourceCount + pNode->mPhysicalIndex];
+		// The last transient using the physical render target transitions it
+		if (pNode->mLastPass != pPhysical->mLastPass || pPhysical->mFinalState != RESOURCE_STATE_UNDEFINED)
+			continue;
+		pPhysical->mFinalState = pSlot->mStates[0];
+		addTransition(pGraph, pSlot, r, pNode, 0, pNode->mMipLevels, 0, pNode->mArraySize, pSlot->mStates[0], false, passCount, true);
+	}
+
+	eastl::stable_sort(pGraph->mBarriers.begin(), pGraph->mBarriers.end(), [](const RenderGraphBarrier& a, const RenderGraphBarrier& b) {
+		return a.mPass < b.mPass;
+	});
+
+	pGraph->mCompiled = true;
+	return true;
+}
+/************************************************************************/
+// Execution
+/************************************************************************/
+static void bindPhysicalRenderTargets(RenderGraph* pGraph)
+{
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mRenderTargetPool.size(); ++i)
+		pGraph->mRenderTargetPool[i].mUsed = false;
+
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPhysicalRenderTargets.size(); ++p)
+	{
+		PhysicalRenderTarget* pPhysical = &pGraph->mPhysicalRenderTargets[p];
+		pPhysical->mPoolIndex = UINT32_MAX;
+		for (uint32_t i = 0; i < (uint32_t)pGraph->mRenderTargetPool.size() && pPhysical->mPoolIndex == UINT32_MAX; ++i)
+		{
+			PooledRenderTarget* pPooled = &pGraph->mRenderTargetPool[i];
+			if (!pPooled->mUsed && isRenderTargetDescEqual(&pPooled->mDesc, &pPhysical->mDesc))
+				pPhysical->mPoolIndex = i;
+		}
+
+		if (pPhysical->mPoolIndex == UINT32_MAX)
+		{
+			PooledRenderTarget pooled = {};
+			pooled.mDesc = pPhysical->mDesc;
+			addRenderTarget(pGraph->pRenderer, &pooled.mDesc, &pooled.pRenderTarget);
+			pGraph->mRenderTargetPool.push_back(pooled);
+			pPhysical->mPoolIndex = (uint32_t)pGraph->mRenderTargetPool.size() - 1;
+		}
+		pGraph->mRenderTargetPool[pPhysical->mPoolIndex].mUsed = true;
+	}
+
+	pGraph->mPhysicalRenderTargetsBound = true;
+}
+
+static void recordBarriers(RenderGraph* pGraph, Cmd* pCmd, uint32_t pass, uint32_t* pBarrierIndex)
+{
+	pGraph->mTextureBarriers.clear();
+	pGraph->mBufferBarriers.clear();
+
+	for (; *pBarrierIndex < (uint32_t)pGraph->mBarriers.size() && pGraph->mBarriers[*pBarrierIndex].mPass == pass; ++*pBarrierIndex)
+	{
+		const RenderGraphBarrier*      pBarrier = &pGraph->mBarriers[*pBarrierIndex];
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[pBarrier->mResource];
+		const bool                     split = pBarrier->mType != RENDER_GRAPH_BARRIER_FULL;
+		// The backends transition from the tracked state. Subresource barriers do not update it, so sync it to the state the
+		// graph knows. The end half of a split barrier relies on the state set by the begin half
+		const bool syncState = pBarrier->mType != RENDER_GRAPH_BARRIER_END && pBarrier->mOldState != RESOURCE_STATE_UNDEFINED;
+
+		if (pNode->mType == RENDER_GRAPH_RESOURCE_BUFFER)
+		{
+			if (syncState)
+				pNode->pBuffer->mCurrentState = pBarrier->mOldState;
+			BufferBarrier barrier = {};
+			barrier.pBuffer = pNode->pBuffer;
+			barrier.mNewState = pBarrier->mNewState;
+			barrier.mSplit = split;
+			pGraph->mBufferBarriers.push_back(barrier);
+			continue;
+		}
+
+		Texture*       pTexture = getNodeTexture(pGraph, pNode);
+		TextureBarrier barrier = {};
+		barrier.pTexture = pTexture;
+		barrier.mNewState = pBarrier->mNewState;
+		barrier.mSplit = split;
+		if (pBarrier->mSubresource)
+		{
+			barrier.mSubresourceBarrier = true;
+			barrier.mMipLevel = pBarrier->mMipLevel;
+			barrier.mArrayLayer = pBarrier->mArrayLayer;
+			barrier.mCurrentState = pBarrier->mOldState;
+		}
+		else if (syncState)
+		{
+			pTexture->mCurrentState = pBarrier->mOldState;
+		}
+		pGraph->mTextureBarriers.push_back(barrier);
+	}
+
+	if (pGraph->mBufferBarriers.size() || pGraph->mTextureBarriers.size())
+	{
+		cmdResourceBarrier(
+			pCmd, (uint32_t)pGraph->mBufferBarriers.size(), pGraph->mBufferBarriers.data(), (uint32_t)pGraph->mTextureBarriers.size(),
+			pGraph->mTextureBarriers.data(), false);
+	}
+}
+
+void executeRenderGraph(RenderGraph* pGraph, Cmd* pCmd)
+{
+	ASSERT(pGraph);
+	ASSERT(pCmd);
+	ASSERT(pGraph->mCompiled && "compileRenderGraph has to be called after changing the graph");
+
+	if (!pGraph->mPhysicalRenderTargetsBound)
+		bindPhysicalRenderTargets(pGraph);
+
+	uint32_t barrierIndex = 0;
+	for (uint32_t p = 0; p < (uint32_t)pGraph->mPasses.size(); ++p)
+	{
+		recordBarriers(pGraph, pCmd, p, &barrierIndex);
+
+		const RenderGraphPassNode* pPass = &pGraph->mPasses[p];
+		if (pPass->mCulled || !pPass->pExecute)
+			continue;
+
+		if (!pPass->mName.empty())
+			cmdBeginDebugMarker(pCmd, 1.0f, 1.0f, 0.0f, pPass->mName.c_str());
+		pPass->pExecute(pCmd, pGraph, pPass->pUserData);
+		if (!pPass->mName.empty())
+			cmdEndDebugMarker(pCmd);
+	}
+	recordBarriers(pGraph, pCmd, (uint32_t)pGraph->mPasses.size(), &barrierIndex);
+
+	// Resources with subresource barriers at the end are still tracked in their old state
+	for (uint32_t r = 0; r < (uint32_t)pGraph->mResources.size(); ++r)
+	{
+		const RenderGraphResourceNode* pNode = &pGraph->mResources[r];
+		if (pNode->mType == RENDER_GRAPH_RESOURCE_BUFFER)
+			pNode->pBuffer->mCurrentState = pNode->mFinalState;
+		else if (pNode->mType != RENDER_GRAPH_RESOURCE_TRANSIENT)
+			getNodeTexture(pGraph, pNode)->mCurrentState = pNode->mFinalState;
+	}
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPhysicalRenderTargets.size(); ++i)
+	{
+		const PhysicalRenderTarget* pPhysical = &pGraph->mPhysicalRenderTargets[i];
+		pGraph->mRenderTargetPool[pPhysical->mPoolIndex].pRenderTarget->pTexture->mCurrentState = pPhysical->mFinalState;
+	}
+}
+/************************************************************************/
+// Queries
+/************************************************************************/
+void getRenderGraphBarriers(const RenderGraph* pGraph, const RenderGraphBarrier** ppBarriers, uint32_t* pBarrierCount)
+{
+	ASSERT(pGraph);
+	ASSERT(ppBarriers);
+	ASSERT(pBarrierCount);
+
+	*ppBarriers = pGraph->mBarriers.data();
+	*pBarrierCount = (uint32_t)pGraph->mBarriers.size();
+}
+
+bool isRenderGraphPassCulled(const RenderGraph* pGraph, uint32_t pass)
+{
+	ASSERT(pGraph);
+	ASSERT(pass < (uint32_t)pGraph->mPasses.size());
+	return pGraph->mPasses[pass].mCulled;
+}
+
+void getRenderGraphMemoryPlan(const RenderGraph* pGraph, RenderGraphMemoryPlan* pPlan)
+{
+	ASSERT(pGraph);
+	ASSERT(pPlan);
+
+	pPlan->mPhysicalRenderTargetCount = (uint32_t)pGraph->mPhysicalRenderTargets.size();
+	pPlan->mTransientSize = pGraph->mTransientSize;
+	pPlan->mAliasedSize = 0;
+	for (uint32_t i = 0; i < pPlan->mPhysicalRenderTargetCount; ++i)
+		pPlan->mAliasedSize += pGraph->mPhysicalRenderTargets[i].mSize;
+}
+
+uint32_t getRenderGraphPhysicalIndex(const RenderGraph* pGraph, RenderGraphResource resource)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].mPhysicalIndex;
+}
+
+Texture* getRenderGraphTexture(const RenderGraph* pGraph, RenderGraphResource resource)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	return getNodeTexture(pGraph, &pGraph->mResources[resource]);
+}
+
+RenderTarget* getRenderGraphRenderTarget(const RenderGraph* pGraph, RenderGraphResource resource)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+
+	const RenderGraphResourceNode* pNode = &pGraph->mResources[resource];
+	if (pNode->mType == RENDER_GRAPH_RESOURCE_RENDER_TARGET)
+		return pNode->pRenderTarget;
+	if (pNode->mType != RENDER_GRAPH_RESOURCE_TRANSIENT || pNode->mPhysicalIndex == UINT32_MAX || !pGraph->mPhysicalRenderTargetsBound)
+		return NULL;
+	return pGraph->mRenderTargetPool[pGraph->mPhysicalRenderTargets[pNode->mPhysicalIndex].mPoolIndex].pRenderTarget;
+}
+
+Buffer* getRenderGraphBuffer(const RenderGraph* pGraph, RenderGraphResource resource)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mResources.size());
+	return pGraph->mResources[resource].pBuffer;
+}
@@ -29,12 +29,18 @@
 #endif
 
 #include "EASTL/deque.h"
+#include "EASTL/hash_map.h"
+#include "EASTL/sort.h"
+#include "EASTL/vector.h"
 
 #include "OS/Core/Atomics.h"
+#include "OS/Core/ThreadSystem.h"
 #include "IRenderer.h"
 #include "ResourceLoader.h"
+#include "ShaderCache.h"
 #include "Interfaces/ILog.h"
 #include "Interfaces/IThread.h"
+#include "Interfaces/ITime.h"
 #include "Image/Image.h"
 
 //this is needed for unix as PATH_MAX is defined instead of MAX_PATH
@@ -76,6 +82,58 @@ typedef struct TextureUpdateDescInternal
 	bool     mFreeImage;
 } TextureUpdateDescInternal;
 
+//////////////////////////////////////////////////////////////////////////
+// Internal TextureLoadTask
+// Texture read from disk, decoded and created on the loader thread pool.
+// The streamer picks it up once it is ready.
+//////////////////////////////////////////////////////////////////////////
+typedef struct TextureLoadTask
+{
+	struct ResourceLoader* pLoader;
+	TextureLoadDesc        mDesc;
+	eastl::string          mFileName;
+	Image*                 pImage;
+	bool                   mReady;
+} TextureLoadTask;
+
+//////////////////////////////////////////////////////////////////////////
+// Internal StreamedTexture
+// Texture loaded with TextureLoadDesc::mStreamMips. Its GPU texture only holds the levels from mResidentMip on.
+// Other levels are made resident by building a new texture in the background which updateTextureStreaming swaps in.
+//////////////////////////////////////////////////////////////////////////
+typedef struct StreamedTexture
+{
+	struct ResourceLoader* pLoader;
+	/// Texture handed out to the user, stays the same object when the resident levels change
+	Texture*               pTexture;
+	/// Texture with the mip tail only while more detailed levels are resident, evictions swap it back in
+	Texture*               pTailTexture;
+	TextureLoadDesc        mDesc;
+	eastl::string          mFileName;
+	/// Size of level 0 in the file
+	uint32_t               mWidth;
+	uint32_t               mHeight;
+	/// Memory of mip level i and all smaller levels of all array layers
+	eastl::vector<uint64_t> mChainSizes;
+	uint32_t                mTailMip;
+	uint32_t                mResidentMip;
+	uint32_t                mRequestedMip;
+	/// First level of the texture being built, UINT32_MAX if there is none
+	uint32_t                mTargetMip;
+	Texture*                pPendingTexture;
+	SyncToken               mPendingToken;
+	uint64_t                mLastRequestFrame;
+	bool                    mBuilding;
+	/// Set by removeResource, the record is freed once the texture being built is done
+	bool                    mRemoved;
+} StreamedTexture;
+
+typedef struct RetiredTexture
+{
+	Texture* pTexture;
+	uint64_t mFrame;
+} RetiredTexture;
+
 //////////////////////////////////////////////////////////////////////////
 // Resource CopyEngine Structures
 //////////////////////////////////////////////////////////////////////////
@@ -85,8 +143,35 @@ typedef struct MappedMemoryRange
 	Buffer*  pBuffer;
 	uint64_t mOffset;
 	uint64_t mSize;
+	/// Position in the staging ring (UINT64_MAX for temporary staging buffers)
+	uint64_t mRingOffset;
 } MappedMemoryRange;
 
+typedef struct StagingRegion
+{
+	uint64_t mStart;
+	uint64_t mEnd;
+	bool     mReleased;
+} StagingRegion;
+
+/// Staging memory of one GPU, shared by the streamer and callers writing to staging memory directly.
+/// Regions are handed out in order and reclaimed once the copy which consumed them completed.
+/// A region released out of order only frees memory once all regions before it got released as well.
+typedef struct StagingRing
+{
+	Buffer*  pBuffer;
+	uint64_t mSize;
+	uint32_t mNodeIndex;
+	/// Virtual offsets, the offset in pBuffer is the virtual offset modulo mSize
+	uint64_t mHead;
+	uint64_t mTail;
+	eastl::deque<StagingRegion> mRegions;
+	Mutex                       mMutex;
+
+	tfrg_atomic64_t mBytesUploaded;
+	tfrg_atomic64_t mTempStagingBytes;
+} StagingRing;
+
 typedef struct ResourceSet
 {
 	Fence*  pFence;
@@ -95,7 +180,9 @@ typedef struct ResourceSet
 #else
 	Cmd*    pCmd;
 #endif
-	Buffer* mBuffer;
+	/// Staging memory consumed by the copies of this set, released once pFence completed
+	eastl::vector<uint64_t> mRingAllocations;
+	eastl::vector<Buffer*>  mTempBuffers;
 } CopyResourceSet;
 
 enum
@@ -104,67 +191,194 @@ enum
 	DEFAULT_BUFFER_COUNT = 2u,
 	DEFAULT_TIMESLICE_MS = 4u,
 	MAX_BUFFER_COUNT = 8u,
+	// Plain staging copies are split into chunks of this size so several workers can fill one large buffer update
+	STAGING_COPY_CHUNK_SIZE = 1u<<20,
+	LOAD_PRIORITY_BITS = 2u,
+	LOAD_PRIORITY_MASK = (1u << LOAD_PRIORITY_BITS) - 1u,
+	// Levels up to this size are the mip tail, streamed textures always keep it resident
+	STREAMING_MIP_TAIL_SIZE = 128u,
+	// Frames a replaced streamed texture is kept alive for since the GPU might still read it
+	STREAMING_RETIRE_DELAY = 4u,
+	// Streamed textures built at the same time, each build reads and decodes the file from its top level on
+	STREAMING_MAX_BUILDS = 4u,
 };
 
+/// CPU copy into staging memory. Recorded while the copy commands are built and executed on the
+/// thread system before the commands get submitted.
+typedef struct StagingCopy
+{
+	uint8_t* pDstData;
+	uint8_t* pSrcData;
+	/// memcpy (memset if pSrcData is NULL) of mSize bytes if not zero, upload rect copy otherwise
+	uint64_t mSize;
+	Region3D mRegion;
+	uint3    mSrcPitches;
+	uint3    mDstPitches;
+	bool     mZCurve;
+} StagingCopy;
+
 //Synchronization?
 typedef struct CopyEngine
 {
 	Queue*      pQueue;
 	CmdPool*    pCmdPool;
 	ResourceSet* resourceSets;
-	uint64_t    bufferSize;
-	uint64_t    allocatedSpace;
+	StagingRing* pStagingRing;
 	uint32_t    bufferCount;
 	bool        isRecording;
+
+	eastl::vector<StagingCopy> mStagingCopies;
+	/// Images of completed texture updates, freed once their staging copies ran
+	eastl::vector<Image*>      mPendingImages;
 } CopyEngine;
 
+//////////////////////////////////////////////////////////////////////////
+// Staging Ring Functions
+//////////////////////////////////////////////////////////////////////////
+static void addStagingRing(Renderer* pRenderer, uint32_t nodeIndex, uint64_t size, StagingRing** ppRing)
+{
+	StagingRing* pRing = conf_new(StagingRing);
+
+	BufferDesc bufferDesc = {};
+	bufferDesc.mSize = size;
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_ONLY;
+	bufferDesc.mFlags = BUFFER_CREATION_FLAG_OWN_MEMORY_BIT | BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	bufferDesc.mNodeIndex = nodeIndex;
+	addBuffer(pRenderer, &bufferDesc, &pRing->pBuffer);
+
+	pRing->mSize = size;
+	pRing->mNodeIndex = nodeIndex;
+	*ppRing = pRing;
+}
+
+static void removeStagingRing(Renderer* pRenderer, StagingRing* pRing)
+{
+	removeBuffer(pRenderer, pRing->pBuffer);
+	conf_delete(pRing);
+}
+
+/// Largest contiguous block which can currently be allocated with the given alignment
+static uint64_t getStagingRingSpace(StagingRing* pRing, uint64_t alignment)
+{
+	MutexLock lock(pRing->mMutex);
+	const uint64_t freeSpace = pRing->mSize - (pRing->mHead - pRing->mTail);
+	const uint64_t offset = pRing->mHead % pRing->mSize;
+	const uint64_t alignedOffset = round_up_64(offset, alignment);
+	const uint64_t toEnd = alignedOffset < pRing->mSize ? pRing->mSize - alignedOffset : 0;
+	const uint64_t padding = alignedOffset - offset;
+	if (freeSpace < padding)
+		return 0;
+
+	// Either the block at the current position or the one after wrapping to the start of the buffer
+	const uint64_t atHead = min(toEnd, freeSpace - padding);
+	const uint64_t skipped = pRing->mSize - offset;
+	const uint64_t atStart = freeSpace > skipped ? freeSpace - skipped : 0;
+	return max(atHead, atStart);
+}
+
+static MappedMemoryRange allocateStagingRing(Renderer* pRenderer, StagingRing* pRing, uint64_t memoryRequirement, uint64_t alignment)
+{
+	MutexLock lock(pRing->mMutex);
+	const uint64_t offset = pRing->mHead % pRing->mSize;
+	uint64_t       alignedOffset = round_up_64(offset, alignment);
+	// Skip the end of the buffer if the allocation does not fit in there
+	if (alignedOffset + memoryRequirement > pRing->mSize)
+		alignedOffset = pRing->mSize;
+
+	const uint64_t start = pRing->mHead + (alignedOffset - offset);
+	const uint64_t end = start + memoryRequirement;
+	if (end - pRing->mTail > pRing->mSize)
+		return { NULL, NULL, 0, 0, UINT64_MAX };
+
+	// Padding belongs to the new region so it is reclaimed together with it
+	StagingRegion region = { pRing->mHead, end, false };
+	pRing->mRegions.push_back(region);
+	pRing->mHead = end;
+
+	Buffer* pBuffer = pRing->pBuffer;
+#if defined(DIRECT3D11)
+	// TODO: do done once, unmap before queue submit
+	mapBuffer(pRenderer, pBuffer, NULL);
+#else
+	UNREF_PARAM(pRenderer);
+#endif
+	const uint64_t bufferOffset = start % pRing->mSize;
+	return { (uint8_t*)pBuffer->pCpuMappedAddress + bufferOffset, pBuffer, bufferOffset, memoryRequirement, region.mStart };
+}
+
+static void releaseStagingRing(StagingRing* pRing, uint64_t ringOffset)
+{
+	MutexLock lock(pRing->mMutex);
+	for (uint32_t i = 0; i < (uint32_t)pRing->mRegions.size(); ++i)
+	{
+		if (pRing->mRegions[i].mStart == ringOffset)
+		{
+			pRing->mRegions[i].mReleased = true;
+			break;
+		}
+	}
+
+	while (!pRing->mRegions.empty() && pRing->mRegions.front().mReleased)
+	{
+		pRing->mTail = pRing->mRegions.front().mEnd;
+		pRing->mRegions.pop_front();
+	}
+}
+
+/// Dedicated staging buffer for allocations which do not fit into the ring
+static MappedMemoryRange allocateTempStagingBuffer(Renderer* pRenderer, StagingRing* pRing, uint64_t memoryRequirement)
+{
+	BufferDesc bufferDesc = {};
+	bufferDesc.mSize = memoryRequirement;
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_ONLY;
+	bufferDesc.mFlags = BUFFER_CREATION_FLAG_OWN_MEMORY_BIT | BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	bufferDesc.mNodeIndex = pRing->mNodeIndex;
+	Buffer* pBuffer = NULL;
+	addBuffer(pRenderer, &bufferDesc, &pBuffer);
+#if defined(DIRECT3D11)
+	mapBuffer(pRenderer, pBuffer, NULL);
+#endif
+	tfrg_atomic64_add_relaxed(&pRing->mTempStagingBytes, memoryRequirement);
+	return { (uint8_t*)pBuffer->pCpuMappedAddress, pBuffer, 0, memoryRequirement, UINT64_MAX };
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Resource Loader Internal Functions
 //////////////////////////////////////////////////////////////////////////
-static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, uint64_t size, uint32_t bufferCount)
+static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, StagingRing* pStagingRing, uint32_t bufferCount)
 {
 	QueueDesc desc = { QUEUE_FLAG_NONE, QUEUE_PRIORITY_NORMAL, CMD_POOL_COPY, nodeIndex };
 	addQueue(pRenderer, &desc, &pCopyEngine->pQueue);
 
 	addCmdPool(pRenderer, pCopyEngine->pQueue, false, &pCopyEngine->pCmdPool);
 
-	const uint32_t maxBlockSize = 32;
-	uint64_t       minUploadSize = pCopyEngine->pQueue->mUploadGranularity.mWidth * pCopyEngine->pQueue->mUploadGranularity.mHeight *
-							 pCopyEngine->pQueue->mUploadGranularity.mDepth * maxBlockSize;
-	size = max(size, minUploadSize);
-
 	pCopyEngine->resourceSets = (ResourceSet*)conf_malloc(sizeof(ResourceSet)*bufferCount);
 	for (uint32_t i=0;  i < bufferCount; ++i)
 	{
-		ResourceSet& resourceSet = pCopyEngine->resourceSets[i];
+		ResourceSet& resourceSet = *conf_placement_new<ResourceSet>(&pCopyEngine->resourceSets[i]);
 		addFence(pRenderer, &resourceSet.pFence);
 
 		addCmd(pCopyEngine->pCmdPool, false, &resourceSet.pCmd);
-
-		BufferDesc bufferDesc = {};
-		bufferDesc.mSize = size;
-		bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_ONLY;
-		bufferDesc.mFlags = BUFFER_CREATION_FLAG_OWN_MEMORY_BIT | BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-		bufferDesc.mNodeIndex = nodeIndex;
-		addBuffer(pRenderer, &bufferDesc, &resourceSet.mBuffer);
 	}
 
-	pCopyEngine->bufferSize = size;
+	pCopyEngine->pStagingRing = pStagingRing;
 	pCopyEngine->bufferCount = bufferCount;
-	pCopyEngine->allocatedSpace = 0;
 	pCopyEngine->isRecording = false;
 }
 
+static void resetCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet);
+
 static void cleanupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine)
 {
 	for (uint32_t i = 0; i < pCopyEngine->bufferCount; ++i)
 	{
 		ResourceSet& resourceSet = pCopyEngine->resourceSets[i];
-		removeBuffer(pRenderer, resourceSet.mBuffer);
+		resetCopyEngineSet(pRenderer, pCopyEngine, i);
 
 		removeCmd(pCopyEngine->pCmdPool, resourceSet.pCmd);
 
 		removeFence(pRenderer, resourceSet.pFence);
+		resourceSet.~ResourceSet();
 	}
 	
 	conf_free(pCopyEngine->resourceSets);
@@ -181,11 +395,18 @@ static void waitCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size
 	waitForFences(pRenderer, 1, &resourceSet.pFence);
 }
 
+/// Releases the staging memory used by the copies of the set. The fence of the set has to be completed
 static void resetCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet)
 {
 	ASSERT(!pCopyEngine->isRecording);
-	pCopyEngine->allocatedSpace = 0;
-	pCopyEngine->isRecording = false;
+	ResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+	for (uint32_t i = 0; i < (uint32_t)resourceSet.mRingAllocations.size(); ++i)
+		releaseStagingRing(pCopyEngine->pStagingRing, resourceSet.mRingAllocations[i]);
+	resourceSet.mRingAllocations.clear();
+
+	for (uint32_t i = 0; i < (uint32_t)resourceSet.mTempBuffers.size(); ++i)
+		removeBuffer(pRenderer, resourceSet.mTempBuffers[i]);
+	resourceSet.mTempBuffers.clear();
 }
 
 #ifdef _DURANGO
@@ -223,31 +444,32 @@ static void streamerFlush(CopyEngine* pCopyEngine, size_t activeSet)
 	}
 }
 
-/// Return memory from pre-allocated staging buffer or create a temporary buffer if the streamer ran out of memory
-static MappedMemoryRange allocateStagingMemory(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, uint64_t memoryRequirement, uint32_t alignment)
+/// Makes the staging memory part of the active set so it gets reclaimed once the copies of the set completed
+static void trackStagingMemory(CopyEngine* pCopyEngine, size_t activeSet, const MappedMemoryRange& range)
 {
-	uint64_t offset = pCopyEngine->allocatedSpace;
-	if (alignment != 0)
-	{
-		offset = round_up_64(offset, alignment);
-	}
+	ResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+	if (range.mRingOffset != UINT64_MAX)
+		resourceSet.mRingAllocations.push_back(range.mRingOffset);
+	else
+		resourceSet.mTempBuffers.push_back(range.pBuffer);
+	tfrg_atomic64_add_relaxed(&pCopyEngine->pStagingRing->mBytesUploaded, range.mSize);
+}
 
-	CopyResourceSet* pResourceSet = &pCopyEngine->resourceSets[activeSet];
-	uint64_t size = pResourceSet->mBuffer->mDesc.mSize;
-	bool memoryAvailable = (offset < size) && (memoryRequirement <= size - offset);
-	if (memoryAvailable)
-	{
-		Buffer* buffer = pResourceSet->mBuffer;
-#if defined(DIRECT3D11)
-		// TODO: do done once, unmap before queue submit
-	mapBuffer(pRenderer, buffer, NULL);
-#endif
-		uint8_t* pDstData = (uint8_t*)buffer->pCpuMappedAddress + offset;
-		pCopyEngine->allocatedSpace = offset + memoryRequirement;
-		return { pDstData, buffer, offset, memoryRequirement };
-	}
+/// Return memory from the staging ring or NULL if the ring has no space left
+static MappedMemoryRange allocateStagingMemory(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, uint64_t memoryRequirement, uint32_t alignment)
+{
+	MappedMemoryRange range = allocateStagingRing(pRenderer, pCopyEngine->pStagingRing, memoryRequirement, max(1U, alignment));
+	if (range.pData)
+		trackStagingMemory(pCopyEngine, activeSet, range);
+	return range;
+}
 
-	return { nullptr, nullptr, 0, 0};
+/// Return memory from a temporary staging buffer for uploads larger than the staging ring
+static MappedMemoryRange allocateTempStagingMemory(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, uint64_t memoryRequirement)
+{
+	MappedMemoryRange range = allocateTempStagingBuffer(pRenderer, pCopyEngine->pStagingRing, memoryRequirement);
+	trackStagingMemory(pCopyEngine, activeSet, range);
+	return range;
 }
 
 static ResourceState util_determine_resource_start_state(DescriptorType usage)
@@ -296,9 +518,24 @@ typedef enum UpdateRequestType
 	UPDATE_REQUEST_UPDATE_BUFFER,
 	UPDATE_REQUEST_UPDATE_TEXTURE,
 	UPDATE_REQUEST_UPDATE_RESOURCE_STATE,
+	UPDATE_REQUEST_LOAD_TEXTURE,
+	UPDATE_REQUEST_COPY_STAGED,
 	UPDATE_REQUEST_INVALID,
 } UpdateRequestType;
 
+/// Copy of data the caller wrote into staging memory through beginUpdateResource
+typedef struct StagedUpdateDesc
+{
+	Buffer*             pBuffer;
+	Texture*            pTexture;
+	uint64_t            mDstOffset;
+	uint32_t            mMipLevel;
+	uint32_t            mArrayLayer;
+	uint32_t            mRowPitch;
+	uint32_t            mSlicePitch;
+	MappedStagingMemory mStaging;
+} StagedUpdateDesc;
+
 typedef struct UpdateRequest
 {
 	UpdateRequest() : mType(UPDATE_REQUEST_INVALID) {}
@@ -306,6 +543,8 @@ typedef struct UpdateRequest
 	UpdateRequest(TextureUpdateDescInternal& texture) : mType(UPDATE_REQUEST_UPDATE_TEXTURE), texUpdateDesc(texture) {}
 	UpdateRequest(Buffer* buf) : mType(UPDATE_REQUEST_UPDATE_RESOURCE_STATE) { buffer = buf; texture = NULL; }
 	UpdateRequest(Texture* tex) : mType(UPDATE_REQUEST_UPDATE_RESOURCE_STATE) { texture = tex; buffer = NULL; }
+	UpdateRequest(TextureLoadTask* task) : mType(UPDATE_REQUEST_LOAD_TEXTURE) { pLoadTask = task; }
+	UpdateRequest(StagedUpdateDesc& staged) : mType(UPDATE_REQUEST_COPY_STAGED), stagedUpdateDesc(staged) {}
 	UpdateRequestType mType;
 	SyncToken mToken = 0;
 	union
@@ -313,6 +552,8 @@ typedef struct UpdateRequest
 		BufferUpdateDesc bufUpdateDesc;
 		TextureUpdateDescInternal texUpdateDesc;
 		struct { Buffer* buffer; Texture* texture; };
+		TextureLoadTask* pLoadTask;
+		StagedUpdateDesc stagedUpdateDesc;
 	};
 } UpdateRequest;
 
@@ -415,6 +656,70 @@ Region3D calculateUploadRegion(uint3 offset, uint3 extent, uint3 uploadBlock, ui
 	return { regionOffset.x, regionOffset.y, regionOffset.z, regionSize.x, regionSize.y, regionSize.z };
 }
 
+static void executeStagingCopy(const StagingCopy& copy)
+{
+	if (copy.mSize)
+	{
+		if (copy.pSrcData)
+			memcpy(copy.pDstData, copy.pSrcData, copy.mSize);
+		else
+			memset(copy.pDstData, 0, copy.mSize);
+	}
+	else if (copy.mZCurve)
+	{
+		copyUploadRectZCurve(copy.pDstData, copy.pSrcData, copy.mRegion, copy.mSrcPitches, copy.mDstPitches);
+	}
+	else
+	{
+		copyUploadRect(copy.pDstData, copy.pSrcData, copy.mRegion, copy.mSrcPitches, copy.mDstPitches);
+	}
+}
+
+static void addStagingCopy(CopyEngine* pCopyEngine, const StagingCopy& copy)
+{
+#if defined(DIRECT3D11)
+	// Staging memory is only mapped around each copy
+	executeStagingCopy(copy);
+#else
+	pCopyEngine->mStagingCopies.push_back(copy);
+#endif
+}
+
+static void stagingCopyTask(void* pUser, uintptr_t index)
+{
+	CopyEngine* pCopyEngine = (CopyEngine*)pUser;
+	executeStagingCopy(pCopyEngine->mStagingCopies[index]);
+}
+
+/// Fills the staging memory of all copies recorded so far using the workers of the staging thread system
+static void executeStagingCopies(ThreadSystem* pThreadSystem, TaskGroup* pGroup, CopyEngine* pCopyEngine)
+{
+	const uint32_t copyCount = (uint32_t)pCopyEngine->mStagingCopies.size();
+	if (copyCount > 1)
+	{
+		TaskDesc desc = {};
+		desc.pTask = stagingCopyTask;
+		desc.pUser = pCopyEngine;
+		desc.mStart = 0;
+		desc.mEnd = copyCount;
+		desc.pGroup = pGroup;
+		addThreadSystemTask(pThreadSystem, &desc);
+		waitTaskGroupCompleted(pThreadSystem, pGroup);
+	}
+	else if (copyCount == 1)
+	{
+		executeStagingCopy(pCopyEngine->mStagingCopies[0]);
+	}
+	pCopyEngine->mStagingCopies.clear();
+
+	for (uint32_t i = 0; i < (uint32_t)pCopyEngine->mPendingImages.size(); ++i)
+	{
+		pCopyEngine->mPendingImages[i]->Destroy();
+		conf_delete(pCopyEngine->mPendingImages[i]);
+	}
+	pCopyEngine->mPendingImages.clear();
+}
+
 static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateState& pTextureUpdate)
 {
 	TextureUpdateDescInternal& texUpdateDesc = pTextureUpdate.mRequest.texUpdateDesc;
@@ -447,7 +752,9 @@ static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t a
 	// Only need transition for vulkan and durango since resource will auto promote to copy dest on copy queue in PC dx12
 	if (applyBarrieers && (uploadOffset.x == 0) && (uploadOffset.y == 0) && (uploadOffset.z == 0))
 	{
-		TextureBarrier preCopyBarrier = { pTexture, RESOURCE_STATE_COPY_DEST };
+		TextureBarrier preCopyBarrier = {};
+		preCopyBarrier.pTexture = pTexture;
+		preCopyBarrier.mNewState = RESOURCE_STATE_COPY_DEST;
 		cmdResourceBarrier(pCmd, 0, NULL, 1, &preCopyBarrier, false);
 	}
 
@@ -470,9 +777,16 @@ static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t a
 
 		ASSERT(uploadOffset.x < uploadExtent.x || uploadOffset.y < uploadExtent.y || uploadOffset.z < uploadExtent.z);
 
+		// Subresources larger than the whole staging ring are uploaded at once through a temporary staging buffer
+		// instead of being split across many flushes
+		const uint64_t subresourceSize = (uint64_t)dstPitches.z * uploadExtent.z;
+		const bool     oversize = subresourceSize > pCopyEngine->pStagingRing->mSize;
+
 		for (; j < arrayCount; ++j)
 		{
-			uint64_t spaceAvailable{ round_down_64(pCopyEngine->bufferSize - pCopyEngine->allocatedSpace, textureRowAlignment) };
+			const bool useTempBuffer = oversize && uploadOffset.x == 0 && uploadOffset.y == 0 && uploadOffset.z == 0;
+			uint64_t   spaceAvailable{ useTempBuffer ? subresourceSize
+												  : round_down_64(getStagingRingSpace(pCopyEngine->pStagingRing, textureAlignment), textureRowAlignment) };
 			uint3    uploadRectExtent{ calculateUploadRect(spaceAvailable, dstPitches, uploadOffset, uploadExtent, granularity) };
 			uint32_t uploadPitchY{ round_up(uploadRectExtent.x * dstPitches.x, textureRowAlignment) };
 			uint3    uploadPitches{ blockSize, uploadPitchY, uploadPitchY * uploadRectExtent.y };
@@ -489,8 +803,9 @@ static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t a
 				return false;
 			}
 
-			MappedMemoryRange range =
-				allocateStagingMemory(pRenderer, pCopyEngine, activeSet, uploadRectExtent.z * uploadPitches.z, textureAlignment);
+			const uint64_t    uploadSize = (uint64_t)uploadRectExtent.z * uploadPitches.z;
+			MappedMemoryRange range = useTempBuffer ? allocateTempStagingMemory(pRenderer, pCopyEngine, activeSet, uploadSize)
+													: allocateStagingMemory(pRenderer, pCopyEngine, activeSet, uploadSize, textureAlignment);
 			// TODO: should not happed, resolve, simplify
 			//ASSERT(range.pData);
 			if (!range.pData)
@@ -513,19 +828,20 @@ static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t a
 			uint32_t k = j - n * nSlices;
 			uint8_t* pSrcData = (uint8_t*)img.GetPixels(i, n) + k * srcPitches.z;
 
-			Region3D uploadRegion{ uploadOffset.x,     uploadOffset.y,     uploadOffset.z,
-								   uploadRectExtent.x, uploadRectExtent.y, uploadRectExtent.z };
-
-			if (isSwizzledZCurve)
-				copyUploadRectZCurve(range.pData, pSrcData, uploadRegion, srcPitches, uploadPitches);
-			else
-				copyUploadRect(range.pData, pSrcData, uploadRegion, srcPitches, uploadPitches);
+			StagingCopy copy = {};
+			copy.pDstData = range.pData;
+			copy.pSrcData = pSrcData;
+			copy.mRegion = { uploadOffset.x, uploadOffset.y, uploadOffset.z, uploadRectExtent.x, uploadRectExtent.y, uploadRectExtent.z };
+			copy.mSrcPitches = srcPitches;
+			copy.mDstPitches = uploadPitches;
+			copy.mZCurve = isSwizzledZCurve;
+			addStagingCopy(pCopyEngine, copy);
 
 #if defined(DIRECT3D11)
 			unmapBuffer(pRenderer, range.pBuffer);
 #endif
 
-			cmdUpdateSubresource(pCmd, pTexture, pCopyEngine->resourceSets[activeSet].mBuffer, &texData);
+			cmdUpdateSubresource(pCmd, pTexture, range.pBuffer, &texData);
 
 			uploadOffset.x += uploadRectExtent.x;
 			uploadOffset.y += (uploadOffset.x < uploadExtent.x) ? 0 : uploadRectExtent.y;
@@ -550,15 +866,15 @@ static bool updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t a
 	// Only need transition for vulkan and durango since resource will decay to srv on graphics queue in PC dx12
 	if (applyBarrieers)
 	{
-		TextureBarrier postCopyBarrier = { pTexture, util_determine_resource_start_state(pTexture->mDesc.mDescriptors) };
+		TextureBarrier postCopyBarrier = {};
+		postCopyBarrier.pTexture = pTexture;
+		postCopyBarrier.mNewState = util_determine_resource_start_state(pTexture->mDesc.mDescriptors);
 		cmdResourceBarrier(pCmd, 0, NULL, 1, &postCopyBarrier, true);
 	}
 	
+	// Staging copies still read from the image
 	if (texUpdateDesc.mFreeImage)
-	{
-		texUpdateDesc.pImage->Destroy();
-		conf_delete(texUpdateDesc.pImage);
-	}
+		pCopyEngine->mPendingImages.push_back(texUpdateDesc.pImage);
 
 	return true;
 }
@@ -574,12 +890,16 @@ static bool updateBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t ac
 	const uint64_t bufferSize = (bufUpdateDesc.mSize > 0) ? bufUpdateDesc.mSize : pBuffer->mDesc.mSize;
 	const uint64_t alignment = pBuffer->mDesc.mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER ? pRenderer->pActiveGpuSettings->mUniformBufferAlignment : 1;
 	const uint64_t offset = round_up_64(bufUpdateDesc.mDstOffset, alignment) + pBufferUpdate.mSize;
-	uint64_t       spaceAvailable = round_down_64(pCopyEngine->bufferSize - pCopyEngine->allocatedSpace, RESOURCE_BUFFER_ALIGNMENT);
+	const uint64_t remaining = bufferSize - pBufferUpdate.mSize;
+	// Updates larger than the whole staging ring go through a temporary staging buffer in one piece
+	const bool     useTempBuffer = remaining > pCopyEngine->pStagingRing->mSize;
+	uint64_t       spaceAvailable =
+		useTempBuffer ? remaining : round_down_64(getStagingRingSpace(pCopyEngine->pStagingRing, RESOURCE_BUFFER_ALIGNMENT), RESOURCE_BUFFER_ALIGNMENT);
 
 	if (spaceAvailable < RESOURCE_BUFFER_ALIGNMENT)
 		return false;
 
-	uint64_t dataToCopy = min(spaceAvailable, bufferSize - pBufferUpdate.mSize);
+	uint64_t dataToCopy = min(spaceAvailable, remaining);
 
 #ifdef _DURANGO
 	DmaCmd* pCmd = aquireCmd(pCopyEngine, activeSet);
@@ -587,21 +907,26 @@ static bool updateBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t ac
 	Cmd* pCmd = aquireCmd(pCopyEngine, activeSet);
 #endif
 	
-	MappedMemoryRange range = allocateStagingMemory(pRenderer, pCopyEngine, activeSet, dataToCopy, RESOURCE_BUFFER_ALIGNMENT);
+	MappedMemoryRange range = useTempBuffer ? allocateTempStagingMemory(pRenderer, pCopyEngine, activeSet, dataToCopy)
+											: allocateStagingMemory(pRenderer, pCopyEngine, activeSet, dataToCopy, RESOURCE_BUFFER_ALIGNMENT);
 
 	// TODO: should not happed, resolve, simplify
 	//ASSERT(range.pData);
 	if (!range.pData)
 		return false;
 
-	void* pSrcBufferAddress = NULL;
+	uint8_t* pSrcBufferAddress = NULL;
 	if (bufUpdateDesc.pData)
 		pSrcBufferAddress = (uint8_t*)(bufUpdateDesc.pData) + (bufUpdateDesc.mSrcOffset + pBufferUpdate.mSize);
 
-	if (pSrcBufferAddress)
-		memcpy(range.pData, pSrcBufferAddress, dataToCopy);
-	else
-		memset(range.pData, 0, dataToCopy);
+	for (uint64_t copyOffset = 0; copyOffset < dataToCopy; copyOffset += STAGING_COPY_CHUNK_SIZE)
+	{
+		StagingCopy copy = {};
+		copy.pDstData = range.pData + copyOffset;
+		copy.pSrcData = pSrcBufferAddress ? pSrcBufferAddress + copyOffset : NULL;
+		copy.mSize = min<uint64_t>(STAGING_COPY_CHUNK_SIZE, dataToCopy - copyOffset);
+		addStagingCopy(pCopyEngine, copy);
+	}
 
 	cmdUpdateBuffer(pCmd, pBuffer, offset, range.pBuffer, range.mOffset, dataToCopy);
 #if defined(DIRECT3D11)
@@ -640,12 +965,16 @@ static bool updateResourceState(Renderer* pRenderer, CopyEngine* pCopyEngine, si
 #endif
 		if (pUpdate.mRequest.buffer)
 		{
-			BufferBarrier barrier = { pUpdate.mRequest.buffer, pUpdate.mRequest.buffer->mDesc.mStartState };
+			BufferBarrier barrier = {};
+			barrier.pBuffer = pUpdate.mRequest.buffer;
+			barrier.mNewState = pUpdate.mRequest.buffer->mDesc.mStartState;
 			cmdResourceBarrier(pCmd, 1, &barrier, 0, NULL, true);
 		}
 		else if (pUpdate.mRequest.texture)
 		{
-			TextureBarrier barrier = { pUpdate.mRequest.texture, pUpdate.mRequest.texture->mDesc.mStartState };
+			TextureBarrier barrier = {};
+			barrier.pTexture = pUpdate.mRequest.texture;
+			barrier.mNewState = pUpdate.mRequest.texture->mDesc.mStartState;
 			cmdResourceBarrier(pCmd, 0, NULL, 1, &barrier, true);
 		}
 		else
@@ -657,6 +986,80 @@ static bool updateResourceState(Renderer* pRenderer, CopyEngine* pCopyEngine, si
 
 	return true;
 }
+static bool updateStaged(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateState& pUpdate)
+{
+	StagedUpdateDesc& staged = pUpdate.mRequest.stagedUpdateDesc;
+#ifdef _DURANGO
+	DmaCmd* pCmd = aquireCmd(pCopyEngine, activeSet);
+#else
+	Cmd* pCmd = aquireCmd(pCopyEngine, activeSet);
+#endif
+
+	MappedMemoryRange range = { (uint8_t*)staged.mStaging.pSystemMemory, staged.mStaging.pBuffer, staged.mStaging.mOffset,
+								staged.mStaging.mSize, staged.mStaging.mRingOffset };
+	if (staged.mStaging.pSystemMemory)
+	{
+		// The data could not be written to staging memory directly, copy it over now
+		range = allocateTempStagingMemory(pRenderer, pCopyEngine, activeSet, staged.mStaging.mSize);
+		memcpy(range.pData, staged.mStaging.pSystemMemory, staged.mStaging.mSize);
+#if defined(DIRECT3D11)
+		unmapBuffer(pRenderer, range.pBuffer);
+#endif
+		conf_free(staged.mStaging.pSystemMemory);
+	}
+	else
+	{
+		trackStagingMemory(pCopyEngine, activeSet, range);
+	}
+
+	if (staged.pBuffer)
+	{
+		cmdUpdateBuffer(pCmd, staged.pBuffer, staged.mDstOffset, range.pBuffer, range.mOffset, range.mSize);
+#ifdef _DURANGO
+		BufferBarrier bufferBarriers[] = { { staged.pBuffer, util_determine_resource_start_state(&staged.pBuffer->mDesc) } };
+		cmdResourceBarrier(pCmd, 1, bufferBarriers, 0, NULL, false);
+#else
+		staged.pBuffer->mCurrentState = util_determine_resource_start_state(&staged.pBuffer->mDesc);
+#endif
+		return true;
+	}
+
+	Texture* pTexture = staged.pTexture;
+	bool     applyBarriers = pRenderer->mSettings.mApi == RENDERER_API_VULKAN || pRenderer->mSettings.mApi == RENDERER_API_XBOX_D3D12 ||
+						 pRenderer->mSettings.mApi == RENDERER_API_METAL;
+	if (applyBarriers)
+	{
+		TextureBarrier preCopyBarrier = {};
+		preCopyBarrier.pTexture = pTexture;
+		preCopyBarrier.mNewState = RESOURCE_STATE_COPY_DEST;
+		cmdResourceBarrier(pCmd, 0, NULL, 1, &preCopyBarrier, false);
+	}
+
+	const ImageFormat::Enum fmt = pTexture->mDesc.mFormat;
+	const uint3             pxBlockDim = ImageFormat::GetBlockSize(fmt);
+	const uint3             pxImageDim{ max(1U, pTexture->mDesc.mWidth >> staged.mMipLevel), max(1U, pTexture->mDesc.mHeight >> staged.mMipLevel),
+                            max(1U, pTexture->mDesc.mDepth >> staged.mMipLevel) };
+	const uint3             uploadExtent{ (pxImageDim + pxBlockDim - uint3(1)) / pxBlockDim };
+
+	SubresourceDataDesc texData;
+	texData.mArrayLayer = staged.mArrayLayer;
+	texData.mMipLevel = staged.mMipLevel;
+	texData.mBufferOffset = range.mOffset;
+	texData.mRegion = calculateUploadRegion(uint3(0), uploadExtent, pxBlockDim, pxImageDim);
+	texData.mRowPitch = staged.mRowPitch;
+	texData.mSlicePitch = staged.mSlicePitch;
+	cmdUpdateSubresource(pCmd, pTexture, range.pBuffer, &texData);
+
+	if (applyBarriers)
+	{
+		TextureBarrier postCopyBarrier = {};
+		postCopyBarrier.pTexture = pTexture;
+		postCopyBarrier.mNewState = util_determine_resource_start_state(pTexture->mDesc.mDescriptors);
+		cmdResourceBarrier(pCmd, 0, NULL, 1, &postCopyBarrier, true);
+	}
+
+	return true;
+}
 //////////////////////////////////////////////////////////////////////////
 // Resource Loader Implementation
 //////////////////////////////////////////////////////////////////////////
@@ -666,6 +1069,10 @@ typedef struct ResourceLoader
 
 	ResourceLoaderDesc mDesc;
 
+	ThreadSystem* pThreadSystem;
+	/// Only runs staging copies. The streamer waits on them, so they must not queue behind texture loads on pThreadSystem
+	ThreadSystem* pStagingThreadSystem;
+
 	volatile int mRun;
 	ThreadDesc   mThreadDesc;
 	ThreadHandle mThread;
@@ -674,24 +1081,71 @@ typedef struct ResourceLoader
 	ConditionVariable mQueueCond;
 	Mutex mTokenMutex;
 	ConditionVariable mTokenCond;
-	eastl::deque <UpdateRequest> mRequestQueue[MAX_GPUS];
-
-	tfrg_atomic64_t mTokenCompleted;
+	eastl::deque <UpdateRequest> mRequestQueue[MAX_GPUS][LOAD_PRIORITY_COUNT];
+	StagingRing* pStagingRings[MAX_GPUS];
+
+	tfrg_atomic64_t mStallTimeUs;
+	uint64_t        mLastStatsBytes;
+	int64_t         mLastStatsTimeUs;
+
+	/// Every token up to this one of the priority class completed, on all GPUs
+	tfrg_atomic64_t mTokenCompleted[LOAD_PRIORITY_COUNT];
+	/// Last token handed out per priority class
+	tfrg_atomic64_t mTokenIssued[LOAD_PRIORITY_COUNT];
+	/// Last token queued per GPU and priority class, guarded by mQueueMutex
+	SyncToken       mNodeTokenIssued[MAX_GPUS][LOAD_PRIORITY_COUNT];
 	tfrg_atomic64_t mTokenCounter;
+
+	Mutex mStreamingMutex;
+	eastl::hash_map<Texture*, StreamedTexture*> mStreamedTextureMap;
+	/// Also holds removed textures until their build finished
+	eastl::vector<StreamedTexture*> mStreamedTextures;
+	eastl::vector<RetiredTexture>   mRetiredTextures;
+	uint64_t                        mStreamingFrame;
+	/// Memory of the resident levels of all streamed textures and of the textures being built
+	uint64_t                        mStreamedBytes;
+	uint32_t                        mStreamingBuildCount;
 } ResourceLoader;
 
+// Order in which the streamer hands out staging memory
+static const LoadPriority gStreamerPriorityOrder[LOAD_PRIORITY_COUNT] = { LOAD_PRIORITY_CRITICAL, LOAD_PRIORITY_VISIBLE,
+																		  LOAD_PRIORITY_PREFETCH };
+
+static bool isRequestReady(const UpdateRequest& request)
+{
+	return request.mType != UPDATE_REQUEST_LOAD_TEXTURE || request.pLoadTask->mReady;
+}
+
+// Requests of a priority class are processed in order so that its tokens complete in order, a texture still being loaded holds back its queue.
 static bool allQueuesEmpty(ResourceLoader* pLoader)
 {
 	for (size_t i = 0; i < MAX_GPUS; ++i)
 	{
-		if (!pLoader->mRequestQueue[i].empty())
+		for (size_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
 		{
-			return false;
+			if (!pLoader->mRequestQueue[i][c].empty() && isRequestReady(pLoader->mRequestQueue[i][c].front()))
+			{
+				return false;
+			}
 		}
 	}
 	return true;
 }
 
+static UpdateRequest finishTextureLoad(const UpdateRequest& request)
+{
+	TextureLoadTask* pTask = request.pLoadTask;
+	UpdateRequest    result;
+	if (pTask->pImage)
+	{
+		TextureUpdateDescInternal updateDesc = { *pTask->mDesc.ppTexture, pTask->pImage, true };
+		result = UpdateRequest(updateDesc);
+	}
+	result.mToken = request.mToken;
+	conf_delete(pTask);
+	return result;
+}
+
 static void streamerThreadFunc(void* pThreadData)
 {
 	ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
@@ -701,15 +1155,21 @@ static void streamerThreadFunc(void* pThreadData)
 	CopyEngine pCopyEngines[MAX_GPUS];
 	for (uint32_t i = 0; i < linkedGPUCount; ++i)
 	{
-		setupCopyEngine(pLoader->pRenderer, &pCopyEngines[i], i, pLoader->mDesc.mBufferSize, pLoader->mDesc.mBufferCount);
+		setupCopyEngine(pLoader->pRenderer, &pCopyEngines[i], i, pLoader->pStagingRings[i], pLoader->mDesc.mBufferCount);
 	}
 
-	const uint32_t allUploadsCompleted = (1 << linkedGPUCount) - 1;
+	TaskGroup* pStagingGroup = NULL;
+	addTaskGroup(pLoader->pStagingThreadSystem, &pStagingGroup);
+
+	// One bit per GPU and priority class, set if the class has no unfinished request on that GPU
+	const uint32_t allUploadsCompleted = (1 << (linkedGPUCount * LOAD_PRIORITY_COUNT)) - 1;
 	uint32_t       completionMask = allUploadsCompleted;
-	UpdateState updateState[MAX_GPUS];
+	UpdateState updateState[MAX_GPUS][LOAD_PRIORITY_COUNT];
 
 	unsigned nextTimeslot = getSystemTime() + pLoader->mDesc.mTimesliceMs;
-	SyncToken maxToken[MAX_BUFFER_COUNT] = { 0 };
+	// Tokens of one GPU complete in order, tokens of linked GPUs interleave
+	SyncToken maxToken[MAX_BUFFER_COUNT][MAX_GPUS][LOAD_PRIORITY_COUNT] = {};
+	SyncToken nodeTokenCompleted[MAX_GPUS][LOAD_PRIORITY_COUNT] = {};
 	size_t activeSet = 0;
 	while (pLoader->mRun)
 	{
@@ -721,49 +1181,72 @@ static void streamerThreadFunc(void* pThreadData)
 		}
 		pLoader->mQueueMutex.Release();
 
+		// Every class makes progress on each iteration. Higher classes go first so they get the staging memory
+		// and a small request never waits for a large upload of a lower class to finish.
+		bool stagingFull = false;
 		for (uint32_t i = 0; i < linkedGPUCount; ++i)
 		{
-			pLoader->mQueueMutex.Acquire();
-			const uint32_t mask = 1 << i;
-			if (completionMask & mask)
+			for (uint32_t p = 0; p < LOAD_PRIORITY_COUNT; ++p)
 			{
-				if (!pLoader->mRequestQueue[i].empty())
+				const uint32_t c = gStreamerPriorityOrder[p];
+				const uint32_t mask = 1 << (i * LOAD_PRIORITY_COUNT + c);
+				UpdateState&   state = updateState[i][c];
+
+				pLoader->mQueueMutex.Acquire();
+				if (completionMask & mask)
 				{
-					updateState[i] = pLoader->mRequestQueue[i].front();
-					pLoader->mRequestQueue[i].pop_front();
-					completionMask &= ~mask;
+					eastl::deque<UpdateRequest>& queue = pLoader->mRequestQueue[i][c];
+					if (!queue.empty() && isRequestReady(queue.front()))
+					{
+						UpdateRequest request = queue.front();
+						queue.pop_front();
+						if (request.mType == UPDATE_REQUEST_LOAD_TEXTURE)
+							request = finishTextureLoad(request);
+						state = request;
+						completionMask &= ~mask;
+					}
+					else
+					{
+						state = UpdateRequest();
+					}
 				}
-				else
+				pLoader->mQueueMutex.Release();
+
+				bool completed = true;
+				switch (state.mRequest.mType)
+				{
+					case UPDATE_REQUEST_UPDATE_BUFFER:
+						completed = updateBuffer(pLoader->pRenderer, &pCopyEngines[i], activeSet, state);
+						break;
+					case UPDATE_REQUEST_UPDATE_TEXTURE:
+						completed = updateTexture(pLoader->pRenderer, &pCopyEngines[i], activeSet, state);
+						break;
+					case UPDATE_REQUEST_UPDATE_RESOURCE_STATE:
+						completed = updateResourceState(pLoader->pRenderer, &pCopyEngines[i], activeSet, state);
+						break;
+					case UPDATE_REQUEST_COPY_STAGED:
+						completed = updateStaged(pLoader->pRenderer, &pCopyEngines[i], activeSet, state);
+						break;
+					default: break;
+				}
+				// Requests only stay incomplete if they ran out of staging memory
+				stagingFull |= !completed;
+				if (completed)
+					completionMask |= mask;
+				if (state.mRequest.mToken && completed)
 				{
-					updateState[i] = UpdateRequest();
+					ASSERT(maxToken[activeSet][i][c] < state.mRequest.mToken);
+					maxToken[activeSet][i][c] = state.mRequest.mToken;
 				}
 			}
+		}
 
-			pLoader->mQueueMutex.Release();
-
-			bool completed = true;
-			switch (updateState[i].mRequest.mType)
-			{
-				case UPDATE_REQUEST_UPDATE_BUFFER:
-					completed = updateBuffer(pLoader->pRenderer, &pCopyEngines[i], activeSet, updateState[i]);
-					break;
-				case UPDATE_REQUEST_UPDATE_TEXTURE:
-					completed = updateTexture(pLoader->pRenderer, &pCopyEngines[i], activeSet, updateState[i]);
-					break;
-				case UPDATE_REQUEST_UPDATE_RESOURCE_STATE:
-					completed = updateResourceState(pLoader->pRenderer, &pCopyEngines[i], activeSet, updateState[i]);
-					break;
-				default: break;
-			}
-			completionMask |= completed << i;
-			if (updateState[i].mRequest.mToken && completed)
-			{
-				ASSERT(maxToken[activeSet] < updateState[i].mRequest.mToken);
-				maxToken[activeSet] = updateState[i].mRequest.mToken;
-			}
+		for (uint32_t i = 0; i < linkedGPUCount; ++i)
+		{
+			executeStagingCopies(pLoader->pStagingThreadSystem, pStagingGroup, &pCopyEngines[i]);
 		}
-		
-		if (getSystemTime() > nextTimeslot || completionMask == 0)
+
+		if (getSystemTime() > nextTimeslot || stagingFull)
 		{
 			for (uint32_t i = 0; i < linkedGPUCount; ++i)
 			{
@@ -771,17 +1254,42 @@ static void streamerThreadFunc(void* pThreadData)
 			}
 			
 			activeSet = (activeSet + 1) % pLoader->mDesc.mBufferCount;
+			const int64_t waitStart = getUSec();
 			for (uint32_t i = 0; i < linkedGPUCount; ++i)
 			{
 				waitCopyEngineSet(pLoader->pRenderer, &pCopyEngines[i], activeSet);
 				resetCopyEngineSet(pLoader->pRenderer, &pCopyEngines[i], activeSet);
 			}
+			tfrg_atomic64_add_relaxed(&pLoader->mStallTimeUs, (uint64_t)(getUSec() - waitStart));
 			
-			SyncToken nextToken = maxToken[activeSet];
-			SyncToken prevToken = tfrg_atomic64_load_relaxed(&pLoader->mTokenCompleted);
+			// A class is complete up to the oldest unfinished token of any GPU. A GPU that finished everything queued on it
+			// does not hold the class back, tokens queued later are larger than any token published now.
+			SyncToken completedTokens[LOAD_PRIORITY_COUNT] = {};
+			pLoader->mQueueMutex.Acquire();
+			for (uint32_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
+			{
+				SyncToken caughtUpToken = 0;
+				SyncToken laggingToken = UINT64_MAX;
+				for (uint32_t i = 0; i < linkedGPUCount; ++i)
+				{
+					SyncToken& nodeToken = nodeTokenCompleted[i][c];
+					nodeToken = max(nodeToken, maxToken[activeSet][i][c]);
+					if (nodeToken >= pLoader->mNodeTokenIssued[i][c])
+						caughtUpToken = max(caughtUpToken, nodeToken);
+					else
+						laggingToken = min(laggingToken, nodeToken);
+				}
+				completedTokens[c] = laggingToken != UINT64_MAX ? laggingToken : caughtUpToken;
+			}
+			pLoader->mQueueMutex.Release();
+
 			// As the only writer atomicity is preserved
 			pLoader->mTokenMutex.Acquire();
-			tfrg_atomic64_store_release(&pLoader->mTokenCompleted, nextToken > prevToken ? nextToken : prevToken);
+			for (uint32_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
+			{
+				SyncToken prevToken = tfrg_atomic64_load_relaxed(&pLoader->mTokenCompleted[c]);
+				tfrg_atomic64_store_release(&pLoader->mTokenCompleted[c], max(completedTokens[c], prevToken));
+			}
 			pLoader->mTokenMutex.Release();
 			pLoader->mTokenCond.WakeAll();
 			nextTimeslot = getSystemTime() + pLoader->mDesc.mTimesliceMs;
@@ -795,6 +1303,8 @@ static void streamerThreadFunc(void* pThreadData)
 		waitQueueIdle(pCopyEngines[i].pQueue);
 		cleanupCopyEngine(pLoader->pRenderer, &pCopyEngines[i]);
 	}
+
+	removeTaskGroup(pLoader->pStagingThreadSystem, pStagingGroup);
 }
 
 static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, ResourceLoader** ppLoader)
@@ -803,7 +1313,20 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 	pLoader->pRenderer = pRenderer;
 
 	pLoader->mRun = true;
-	pLoader->mDesc = pDesc ? *pDesc : ResourceLoaderDesc{ DEFAULT_BUFFER_SIZE, DEFAULT_BUFFER_COUNT, DEFAULT_TIMESLICE_MS };
+	pLoader->mDesc = pDesc ? *pDesc : ResourceLoaderDesc{ DEFAULT_BUFFER_SIZE, DEFAULT_BUFFER_COUNT, DEFAULT_TIMESLICE_MS, DEFAULT_MEMORY_BUDGET };
+	if (!pLoader->mDesc.mMemoryBudget)
+		pLoader->mDesc.mMemoryBudget = DEFAULT_MEMORY_BUDGET;
+
+	initThreadSystem(&pLoader->pThreadSystem);
+	initThreadSystem(&pLoader->pStagingThreadSystem);
+
+	// Basis Universal textures get transcoded to a block format this renderer can sample
+	Image::SetSupportedFormatQuery(isImageFormatSupported);
+
+	// Created here so callers can write to staging memory before the streamer thread is up
+	for (uint32_t i = 0; i < pRenderer->mLinkedNodeCount; ++i)
+		addStagingRing(pRenderer, i, pLoader->mDesc.mBufferSize * pLoader->mDesc.mBufferCount, &pLoader->pStagingRings[i]);
+	pLoader->mLastStatsTimeUs = getUSec();
 
 	pLoader->mThreadDesc.pFunc = streamerThreadFunc;
 	pLoader->mThreadDesc.pData = pLoader;
@@ -815,10 +1338,32 @@ static void addResourceLoader(Renderer* pRenderer, ResourceLoaderDesc* pDesc, Re
 
 static void removeResourceLoader(ResourceLoader* pLoader)
 {
+	// Pending texture loads still reference the streamer queues
+	waitThreadSystemIdle(pLoader->pThreadSystem);
+
 	pLoader->mRun = false;
 	pLoader->mQueueCond.WakeOne();
 	destroy_thread(pLoader->mThread);
 
+	// The streamer fills staging memory on the staging thread system so it can only go away after the streamer stopped
+	shutdownThreadSystem(pLoader->pStagingThreadSystem);
+	shutdownThreadSystem(pLoader->pThreadSystem);
+
+	// Textures handed out to the user are removed by the user
+	for (uint32_t i = 0; i < (uint32_t)pLoader->mStreamedTextures.size(); ++i)
+	{
+		if (pLoader->mStreamedTextures[i]->pPendingTexture)
+			removeTexture(pLoader->pRenderer, pLoader->mStreamedTextures[i]->pPendingTexture);
+		if (pLoader->mStreamedTextures[i]->pTailTexture)
+			removeTexture(pLoader->pRenderer, pLoader->mStreamedTextures[i]->pTailTexture);
+		conf_delete(pLoader->mStreamedTextures[i]);
+	}
+	for (uint32_t i = 0; i < (uint32_t)pLoader->mRetiredTextures.size(); ++i)
+		removeTexture(pLoader->pRenderer, pLoader->mRetiredTextures[i].pTexture);
+
+	for (uint32_t i = 0; i < pLoader->pRenderer->mLinkedNodeCount; ++i)
+		removeStagingRing(pLoader->pRenderer, pLoader->pStagingRings[i]);
+
 	conf_delete(pLoader);
 }
 
@@ -858,64 +1403,58 @@ static void updateCPUbuffer(Renderer* pRenderer, BufferUpdateDesc* pBufferUpdate
 	}
 }
 
-static void queueResourceUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+static void queueResourceUpdate(ResourceLoader* pLoader, uint32_t nodeIndex, LoadPriority priority, const UpdateRequest& request, bool wakeStreamer, SyncToken* token)
 {
-	uint32_t nodeIndex = pBufferUpdate->pBuffer->mDesc.mNodeIndex;
+	ASSERT(priority < LOAD_PRIORITY_COUNT);
 	pLoader->mQueueMutex.Acquire();
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pBufferUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mToken = t;
+	SyncToken t = ((tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1) << LOAD_PRIORITY_BITS) | priority;
+	tfrg_atomic64_store_release(&pLoader->mTokenIssued[priority], t);
+	pLoader->mNodeTokenIssued[nodeIndex][priority] = t;
+	pLoader->mRequestQueue[nodeIndex][priority].emplace_back(request);
+	pLoader->mRequestQueue[nodeIndex][priority].back().mToken = t;
 	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
+	if (wakeStreamer)
+		pLoader->mQueueCond.WakeOne();
 	if (token) *token = t;
 }
 
-static void queueResourceUpdate(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, SyncToken* token)
+static void queueResourceUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
 {
-	uint32_t nodeIndex = pTextureUpdate->pTexture->mDesc.mNodeIndex;
-	pLoader->mQueueMutex.Acquire();
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mToken = t;
-	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
-	if (token) *token = t;
+	queueResourceUpdate(pLoader, pBufferUpdate->pBuffer->mDesc.mNodeIndex, pBufferUpdate->mPriority, UpdateRequest(*pBufferUpdate), true, token);
 }
 
-static void queueResourceUpdate(ResourceLoader* pLoader, Buffer* pBuffer, SyncToken* token)
+static void queueResourceUpdate(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, LoadPriority priority, SyncToken* token)
 {
-	uint32_t nodeIndex = pBuffer->mDesc.mNodeIndex;
-	pLoader->mQueueMutex.Acquire();
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(pBuffer));
-	pLoader->mRequestQueue[nodeIndex].back().mToken = t;
-	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
-	if (token) *token = t;
+	queueResourceUpdate(pLoader, pTextureUpdate->pTexture->mDesc.mNodeIndex, priority, UpdateRequest(*pTextureUpdate), true, token);
 }
 
-static void queueResourceUpdate(ResourceLoader* pLoader, Texture* pTexture, SyncToken* token)
+static void queueResourceUpdate(ResourceLoader* pLoader, Buffer* pBuffer, LoadPriority priority, SyncToken* token)
 {
-	uint32_t nodeIndex = pTexture->mDesc.mNodeIndex;
-	pLoader->mQueueMutex.Acquire();
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(pTexture));
-	pLoader->mRequestQueue[nodeIndex].back().mToken = t;
-	pLoader->mQueueMutex.Release();
-	pLoader->mQueueCond.WakeOne();
-	if (token) *token = t;
+	queueResourceUpdate(pLoader, pBuffer->mDesc.mNodeIndex, priority, UpdateRequest(pBuffer), true, token);
+}
+
+static void queueResourceUpdate(ResourceLoader* pLoader, TextureLoadTask* pTextureLoad, SyncToken* token)
+{
+	// The streamer gets woken up by the load task once the texture is ready
+	queueResourceUpdate(pLoader, pTextureLoad->mDesc.mNodeIndex, pTextureLoad->mDesc.mPriority, UpdateRequest(pTextureLoad), false, token);
+}
+
+static void queueResourceUpdate(ResourceLoader* pLoader, Texture* pTexture, LoadPriority priority, SyncToken* token)
+{
+	queueResourceUpdate(pLoader, pTexture->mDesc.mNodeIndex, priority, UpdateRequest(pTexture), true, token);
 }
 
 static bool isTokenCompleted(ResourceLoader* pLoader, SyncToken token)
 {
-	bool completed = tfrg_atomic64_load_acquire(&pLoader->mTokenCompleted) >= token;
+	const uint32_t priority = (uint32_t)(token & LOAD_PRIORITY_MASK);
+	bool completed = tfrg_atomic64_load_acquire(&pLoader->mTokenCompleted[priority]) >= token;
 	return completed;
 }
 
 static void waitTokenCompleted(ResourceLoader* pLoader, SyncToken token)
 {
 	pLoader->mTokenMutex.Acquire();
-	while (!isTokenCompleted(token))
+	while (!isTokenCompleted(pLoader, token))
 	{
 		pLoader->mTokenCond.Wait(pLoader->mTokenMutex);
 	}
@@ -961,6 +1500,7 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
 	{
 		BufferUpdateDesc bufferUpdate(*pBufferDesc->ppBuffer, pBufferDesc->pData);
         bufferUpdate.mSize = pBufferDesc->mDesc.mSize;
+		bufferUpdate.mPriority = pBufferDesc->mPriority;
 		updateResource(&bufferUpdate, token);
 	}
 	else
@@ -970,26 +1510,267 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
 			pBufferDesc->mDesc.mMemoryUsage == RESOURCE_MEMORY_USAGE_GPU_ONLY &&
 			// Check whether this is required (user specified a state other than undefined / common)
 			(pBufferDesc->mDesc.mStartState != RESOURCE_STATE_UNDEFINED && pBufferDesc->mDesc.mStartState != RESOURCE_STATE_COMMON))
-			queueResourceUpdate(pResourceLoader, *pBufferDesc->ppBuffer, token);
+			queueResourceUpdate(pResourceLoader, *pBufferDesc->ppBuffer, pBufferDesc->mPriority, token);
 	}
 }
 
-void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
+static void addTextureFromImage(Renderer* pRenderer, const TextureLoadDesc* pTextureDesc, Image* pImage)
 {
-	ASSERT(pTextureDesc->ppTexture);
+	TextureDesc desc = {};
+	desc.mFlags = pTextureDesc->mCreationFlag;
+	desc.mWidth = pImage->GetWidth();
+	desc.mHeight = pImage->GetHeight();
+	desc.mDepth = max(1U, pImage->GetDepth());
+	desc.mArraySize = pImage->GetArrayCount();
 
-	bool freeImage = false;
-	Image* pImage = NULL;
-	if (pTextureDesc->pFilename)
+	desc.mMipLevels = pImage->GetMipMapCount();
+	desc.mSampleCount = SAMPLE_COUNT_1;
+	desc.mSampleQuality = 0;
+	desc.mFormat = pImage->getFormat();
+	desc.mClearValue = ClearValue();
+	desc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+	desc.mStartState = RESOURCE_STATE_COPY_DEST;
+	desc.pNativeHandle = NULL;
+	desc.mHostVisible = false;
+	desc.mSrgb = pImage->IsSrgb() || pTextureDesc->mSrgb;
+	desc.mNodeIndex = pTextureDesc->mNodeIndex;
+
+	if (pImage->IsCube())
 	{
-		pImage = conf_new(Image);
-		if (!pImage->loadImage(pTextureDesc->pFilename, NULL, NULL, pTextureDesc->mRoot))
-		{
-			conf_delete(pImage);
-			return;
-		}
-		freeImage = true;
-	}
+		desc.mDescriptors |= DESCRIPTOR_TYPE_TEXTURE_CUBE;
+		desc.mArraySize *= 6;
+	}
+
+	wchar_t         debugName[MAX_PATH] = {};
+	eastl::string filename = FileSystem::GetFileNameAndExtension(pImage->GetName());
+	mbstowcs(debugName, filename.c_str(), min((size_t)MAX_PATH, filename.size()));
+	desc.pDebugName = debugName;
+
+	addTexture(pRenderer, &desc, pTextureDesc->ppTexture);
+}
+
+static void generateMipMaps(ResourceLoader* pLoader, const TextureLoadDesc* pTextureDesc, Image* pImage)
+{
+	if (pTextureDesc->mGenerateMipMaps && pImage->GetMipMapCount() == 1 && !ImageFormat::IsCompressedFormat(pImage->getFormat()))
+	{
+		// The texture gets created as sRGB in that case so filter in linear space as well
+		if (pTextureDesc->mSrgb)
+			pImage->setSrgb(true);
+		pImage->GenerateMipMaps(ALL_MIPLEVELS, pTextureDesc->mMipFilter, pLoader->pThreadSystem);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Texture Streaming Functions
+//////////////////////////////////////////////////////////////////////////
+static uint32_t getMipTailLevel(const Image* pImage)
+{
+	const uint3    blockSize = ImageFormat::GetBlockSize(pImage->getFormat());
+	const uint32_t mipCount = pImage->GetMipMapCount();
+	uint32_t       mip = 0;
+	while (mip + 1 < mipCount && max(pImage->GetWidth(mip), pImage->GetHeight(mip)) > STREAMING_MIP_TAIL_SIZE)
+		++mip;
+	// The top level of a block compressed texture has to be block aligned
+	while (mip > 0 && (pImage->GetWidth(mip) % blockSize.x || pImage->GetHeight(mip) % blockSize.y))
+		--mip;
+	return mip;
+}
+
+// Replaces pImage by an image holding its levels from baseMip on
+static Image* createMipChainImage(Image* pImage, uint32_t baseMip)
+{
+	if (baseMip == 0)
+		return pImage;
+
+	const uint32_t mipCount = pImage->GetMipMapCount() - baseMip;
+	const uint32_t arrayCount = pImage->GetArrayCount();
+	const uint32_t layerSize = pImage->GetMipMappedSize(baseMip, mipCount);
+	Image*         pChain = conf_new(Image);
+	pChain->RedefineDimensions(
+		pImage->getFormat(), pImage->GetWidth(baseMip), pImage->GetHeight(baseMip), pImage->IsCube() ? 0 : pImage->GetDepth(baseMip),
+		mipCount, arrayCount, pImage->IsSrgb());
+	pChain->SetPixels((unsigned char*)conf_malloc((size_t)layerSize * arrayCount), true);
+	pChain->SetName(pImage->GetName());
+	// Levels of a layer are stored back to back
+	for (uint32_t layer = 0; layer < arrayCount; ++layer)
+		memcpy(pChain->GetPixels(0, layer), pImage->GetPixels(baseMip, layer), layerSize);
+
+	pImage->Destroy();
+	conf_delete(pImage);
+	return pChain;
+}
+
+// Creates the texture of a TextureLoadDesc::mStreamMips load holding the mip tail only.
+// Files with stored mip levels were loaded from the tail on, the skipped levels only count for the chain sizes
+static Image* addStreamedTexture(ResourceLoader* pLoader, const TextureLoadTask* pTask, Image* pImage)
+{
+	const uint32_t   skippedMips = pImage->GetSkippedMipCount();
+	StreamedTexture* pStreamed = conf_new(StreamedTexture);
+	pStreamed->pLoader = pLoader;
+	pStreamed->pTailTexture = NULL;
+	pStreamed->mDesc = pTask->mDesc;
+	pStreamed->mFileName = pTask->mFileName;
+	pStreamed->mWidth = pImage->GetSourceWidth();
+	pStreamed->mHeight = pImage->GetSourceHeight();
+	pStreamed->mTailMip = skippedMips + getMipTailLevel(pImage);
+	pStreamed->mResidentMip = pStreamed->mTailMip;
+	pStreamed->mRequestedMip = pStreamed->mTailMip;
+	pStreamed->mTargetMip = UINT32_MAX;
+	pStreamed->pPendingTexture = NULL;
+	pStreamed->mPendingToken = 0;
+	pStreamed->mBuilding = false;
+	pStreamed->mRemoved = false;
+
+	Image source;
+	const uint32_t mipCount = skippedMips + pImage->GetMipMapCount();
+	source.RedefineDimensions(
+		pImage->getFormat(), pStreamed->mWidth, pStreamed->mHeight, pImage->IsCube() ? 0 : pImage->GetDepth(), mipCount,
+		pImage->GetArrayCount(), pImage->IsSrgb());
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+		pStreamed->mChainSizes.push_back((uint64_t)source.GetMipMappedSize(mip, mipCount - mip) * source.GetArrayCount());
+
+	pImage = createMipChainImage(pImage, pStreamed->mTailMip - skippedMips);
+	addTextureFromImage(pLoader->pRenderer, &pTask->mDesc, pImage);
+	pStreamed->pTexture = *pTask->mDesc.ppTexture;
+
+	MutexLock lock(pLoader->mStreamingMutex);
+	pStreamed->mLastRequestFrame = pLoader->mStreamingFrame;
+	pLoader->mStreamedBytes += pStreamed->mChainSizes[pStreamed->mTailMip];
+	pLoader->mStreamedTextures.push_back(pStreamed);
+	pLoader->mStreamedTextureMap[pStreamed->pTexture] = pStreamed;
+	return pImage;
+}
+
+// Runs on the loader thread pool: reads the file again and creates the texture holding the levels from mTargetMip on
+static void buildStreamedTextureTask(void* pUser, uintptr_t)
+{
+	StreamedTexture* pStreamed = (StreamedTexture*)pUser;
+	ResourceLoader*  pLoader = pStreamed->pLoader;
+	const uint32_t   targetMip = pStreamed->mTargetMip;
+
+	Texture*  pTexture = NULL;
+	SyncToken token = 0;
+	Image*    pImage = conf_new(Image);
+	pImage->SetMaxLoadSize(max(max(pStreamed->mWidth >> targetMip, 1u), max(pStreamed->mHeight >> targetMip, 1u)));
+	if (pImage->loadImage(pStreamed->mFileName.c_str(), NULL, NULL, pStreamed->mDesc.mRoot))
+	{
+		generateMipMaps(pLoader, &pStreamed->mDesc, pImage);
+		const uint32_t skippedMips = pImage->GetSkippedMipCount();
+		// The file could have changed since the mip tail was loaded
+		if (skippedMips <= targetMip && skippedMips + pImage->GetMipMapCount() == pStreamed->mChainSizes.size())
+		{
+			pImage = createMipChainImage(pImage, targetMip - skippedMips);
+			TextureLoadDesc desc = pStreamed->mDesc;
+			desc.ppTexture = &pTexture;
+			addTextureFromImage(pLoader->pRenderer, &desc, pImage);
+
+			TextureUpdateDescInternal updateDesc = { pTexture, pImage, true };
+			queueResourceUpdate(pLoader, &updateDesc, LOAD_PRIORITY_PREFETCH, &token);
+			pImage = NULL;
+		}
+	}
+
+	if (pImage)
+	{
+		LOGF(LogLevel::eERROR, "Failed to stream mip levels of %s", pStreamed->mFileName.c_str());
+		pImage->Destroy();
+		conf_delete(pImage);
+	}
+
+	MutexLock lock(pLoader->mStreamingMutex);
+	pStreamed->pPendingTexture = pTexture;
+	pStreamed->mPendingToken = token;
+	pStreamed->mBuilding = false;
+	if (!pTexture)
+	{
+		// Do not retry until the levels get requested again
+		pLoader->mStreamedBytes -= pStreamed->mChainSizes[targetMip];
+		pStreamed->mRequestedMip = pStreamed->mResidentMip;
+		pStreamed->mTargetMip = UINT32_MAX;
+	}
+	--pLoader->mStreamingBuildCount;
+}
+
+// Called with mStreamingMutex held. The memory of the new texture counts against the budget right away
+static void startStreamedTextureBuild(ResourceLoader* pLoader, StreamedTexture* pStreamed, uint32_t mip)
+{
+	pStreamed->mTargetMip = mip;
+	pStreamed->mBuilding = true;
+	pLoader->mStreamedBytes += pStreamed->mChainSizes[mip];
+	++pLoader->mStreamingBuildCount;
+	addThreadSystemTask(pLoader->pThreadSystem, buildStreamedTextureTask, pStreamed);
+}
+
+// Called with mStreamingMutex held. Swaps the mip tail kept since the first upgrade back in, nothing is read or uploaded.
+// The levels it replaces stop counting against the budget right away, they are freed once the GPU is done with them
+static void evictStreamedTexture(ResourceLoader* pLoader, StreamedTexture* pStreamed, uint64_t frame)
+{
+	ASSERT(pStreamed->pTailTexture);
+	eastl::swap(*pStreamed->pTexture, *pStreamed->pTailTexture);
+	pLoader->mRetiredTextures.push_back({ pStreamed->pTailTexture, frame });
+	pLoader->mStreamedBytes -= pStreamed->mChainSizes[pStreamed->mResidentMip];
+	pStreamed->pTailTexture = NULL;
+	pStreamed->mResidentMip = pStreamed->mTailMip;
+	pStreamed->mRequestedMip = pStreamed->mTailMip;
+}
+
+// Runs on the loader thread pool: file read, decode, mip generation and texture creation.
+static void loadTextureTask(void* pUser, uintptr_t)
+{
+	TextureLoadTask* pTask = (TextureLoadTask*)pUser;
+	ResourceLoader*  pLoader = pTask->pLoader;
+
+	Image* pImage = conf_new(Image);
+	// Only the mip tail is read and decoded if the file stores its mip levels
+	if (pTask->mDesc.mStreamMips)
+		pImage->SetMaxLoadSize(STREAMING_MIP_TAIL_SIZE);
+	if (pImage->loadImage(pTask->mFileName.c_str(), NULL, NULL, pTask->mDesc.mRoot))
+	{
+		generateMipMaps(pLoader, &pTask->mDesc, pImage);
+		if (pTask->mDesc.mStreamMips)
+			pImage = addStreamedTexture(pLoader, pTask, pImage);
+		else
+			addTextureFromImage(pLoader->pRenderer, &pTask->mDesc, pImage);
+	}
+	else
+	{
+		// The token still completes so that nobody waits forever, the caller sees a NULL texture
+		LOGF(LogLevel::eERROR, "Failed to load texture %s", pTask->mFileName.c_str());
+		pImage->Destroy();
+		conf_delete(pImage);
+		pImage = NULL;
+		*pTask->mDesc.ppTexture = NULL;
+	}
+
+	pLoader->mQueueMutex.Acquire();
+	pTask->pImage = pImage;
+	pTask->mReady = true;
+	pLoader->mQueueMutex.Release();
+	pLoader->mQueueCond.WakeOne();
+}
+
+void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
+{
+	ASSERT(pTextureDesc->ppTexture);
+
+	bool freeImage = false;
+	Image* pImage = NULL;
+	if (pTextureDesc->pFilename)
+	{
+		// The request keeps its place in the queue while the image is loaded in the background.
+		// *ppTexture is written once the image is decoded, or set to NULL if it fails to load, and becomes usable when the token completes.
+		TextureLoadTask* pTask = conf_new(TextureLoadTask);
+		pTask->pLoader = pResourceLoader;
+		pTask->mDesc = *pTextureDesc;
+		pTask->mFileName = pTextureDesc->pFilename;
+		pTask->mDesc.pFilename = NULL;
+		pTask->pImage = NULL;
+		pTask->mReady = false;
+
+		queueResourceUpdate(pResourceLoader, pTask, token);
+		addThreadSystemTask(pResourceLoader->pThreadSystem, loadTextureTask, pTask);
+		return;
+	}
 	else if (!pTextureDesc->pFilename && !pTextureDesc->pRawImageData && !pTextureDesc->pBinaryImageData && pTextureDesc->pDesc)
 	{
 		// If texture is supposed to be filled later (UAV / Update later / ...) proceed with the mStartState provided by the user in the texture description
@@ -999,7 +1780,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
 		if (pResourceLoader->pRenderer->mSettings.mApi == RENDERER_API_VULKAN &&
 			// Check whether this is required (user specified a state other than undefined / common)
 			(pTextureDesc->pDesc->mStartState != RESOURCE_STATE_UNDEFINED && pTextureDesc->pDesc->mStartState != RESOURCE_STATE_COMMON))
-			queueResourceUpdate(pResourceLoader, *pTextureDesc->ppTexture, token);
+			queueResourceUpdate(pResourceLoader, *pTextureDesc->ppTexture, pTextureDesc->mPriority, token);
 		return;
 	}
 	else if (pTextureDesc->pRawImageData && !pTextureDesc->pBinaryImageData)
@@ -1011,52 +1792,26 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
 	else if (pTextureDesc->pBinaryImageData)
 	{
 		pImage = conf_new(Image);
-#ifdef _DEBUG
-		bool success =
-#endif
-		pImage->loadFromMemory(pTextureDesc->pBinaryImageData->pBinaryData, pTextureDesc->pBinaryImageData->mSize, pTextureDesc->pBinaryImageData->pExtension);
-#ifdef _DEBUG
-		ASSERT(success);
-#endif
+		if (!pImage->loadFromMemory(pTextureDesc->pBinaryImageData->pBinaryData, pTextureDesc->pBinaryImageData->mSize, pTextureDesc->pBinaryImageData->pExtension))
+		{
+			LOGF(LogLevel::eERROR, "Failed to load texture from memory (%s)", pTextureDesc->pBinaryImageData->pExtension);
+			pImage->Destroy();
+			conf_delete(pImage);
+			*pTextureDesc->ppTexture = NULL;
+			return;
+		}
+		generateMipMaps(pResourceLoader, pTextureDesc, pImage);
 		freeImage = true;
 	}
 	else
-		ASSERT(0 && "Invalid params");
-
-	TextureDesc desc = {};
-	desc.mFlags = pTextureDesc->mCreationFlag;
-	desc.mWidth = pImage->GetWidth();
-	desc.mHeight = pImage->GetHeight();
-	desc.mDepth = max(1U, pImage->GetDepth());
-	desc.mArraySize = pImage->GetArrayCount();
-
-	desc.mMipLevels = pImage->GetMipMapCount();
-	desc.mSampleCount = SAMPLE_COUNT_1;
-	desc.mSampleQuality = 0;
-	desc.mFormat = pImage->getFormat();
-	desc.mClearValue = ClearValue();
-	desc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
-	desc.mStartState = RESOURCE_STATE_COPY_DEST;
-	desc.pNativeHandle = NULL;
-	desc.mHostVisible = false;
-	desc.mSrgb = pImage->IsSrgb() || pTextureDesc->mSrgb;
-	desc.mNodeIndex = pTextureDesc->mNodeIndex;
-
-	if (pImage->IsCube())
 	{
-		desc.mDescriptors |= DESCRIPTOR_TYPE_TEXTURE_CUBE;
-		desc.mArraySize *= 6;
+		ASSERT(0 && "Invalid params");
 	}
 
-	wchar_t         debugName[MAX_PATH] = {};
-	eastl::string filename = FileSystem::GetFileNameAndExtension(pImage->GetName());
-	mbstowcs(debugName, filename.c_str(), min((size_t)MAX_PATH, filename.size()));
-	desc.pDebugName = debugName;
-
-	addTexture(pResourceLoader->pRenderer, &desc, pTextureDesc->ppTexture);
+	addTextureFromImage(pResourceLoader->pRenderer, pTextureDesc, pImage);
 
 	TextureUpdateDescInternal updateDesc = { *pTextureDesc->ppTexture, pImage, freeImage };
-	queueResourceUpdate(pResourceLoader, &updateDesc, token);
+	queueResourceUpdate(pResourceLoader, &updateDesc, pTextureDesc->mPriority, token);
 }
 
 void updateResource(BufferUpdateDesc* pBufferUpdate, bool batch)
@@ -1081,9 +1836,20 @@ void updateResource(TextureUpdateDesc* pTextureUpdate, bool batch)
 
 void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources)
 {
-	SyncToken token = 0;
-	updateResources(resourceCount, pResources, &token);
-	waitTokenCompleted(token);
+	// Tokens are only ordered within a priority class, wait for the last one of every class used
+	uint64_t tokens[LOAD_PRIORITY_COUNT] = {};
+	for (uint32_t i = 0; i < resourceCount; ++i)
+	{
+		SyncToken token = 0;
+		updateResources(1, &pResources[i], &token);
+		const uint32_t priority = (uint32_t)(token & LOAD_PRIORITY_MASK);
+		tokens[priority] = token > tokens[priority] ? token : tokens[priority];
+	}
+	for (uint32_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
+	{
+		if (tokens[c])
+			waitTokenCompleted(tokens[c]);
+	}
 }
 
 void updateResource(BufferUpdateDesc* pBufferUpdate, SyncToken* token)
@@ -1124,7 +1890,7 @@ void updateResource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
 	}
 
 	SyncToken updateToken;
-	queueResourceUpdate(pResourceLoader, &desc, &updateToken);
+	queueResourceUpdate(pResourceLoader, &desc, pTextureUpdate->mPriority, &updateToken);
 #if defined(DIRECT3D11)
 	waitTokenCompleted(updateToken);
 #endif
@@ -1146,8 +1912,309 @@ void updateResources(uint32_t resourceCount, ResourceUpdateDesc* pResources, Syn
 	}
 }
 
+/// Staging memory for a direct write from the calling thread. Falls back to a temporary staging buffer instead of
+/// waiting if the ring is full since the ring might only drain after the caller queued its update
+static MappedStagingMemory beginStagingWrite(ResourceLoader* pLoader, uint32_t nodeIndex, uint64_t size, uint32_t alignment, void** ppData)
+{
+	MappedStagingMemory staging = {};
+#if defined(DIRECT3D11)
+	// Staging buffers can only be mapped on the immediate context, the streamer copies the data over
+	UNREF_PARAM(nodeIndex);
+	UNREF_PARAM(alignment);
+	staging.pSystemMemory = conf_malloc(size);
+	staging.mSize = size;
+	staging.mRingOffset = UINT64_MAX;
+	*ppData = staging.pSystemMemory;
+#else
+	Renderer*         pRenderer = pLoader->pRenderer;
+	StagingRing*      pRing = pLoader->pStagingRings[nodeIndex];
+	MappedMemoryRange range = { NULL, NULL, 0, 0, UINT64_MAX };
+	if (size <= pRing->mSize)
+		range = allocateStagingRing(pRenderer, pRing, size, max(1U, alignment));
+	if (!range.pData)
+		range = allocateTempStagingBuffer(pRenderer, pRing, size);
+
+	staging.pBuffer = range.pBuffer;
+	staging.mOffset = range.mOffset;
+	staging.mSize = range.mSize;
+	staging.mRingOffset = range.mRingOffset;
+	*ppData = range.pData;
+#endif
+	return staging;
+}
+
+void beginUpdateResource(BufferUpdateDesc* pBufferUpdate)
+{
+	Buffer* pBuffer = pBufferUpdate->pBuffer;
+	ASSERT(pBuffer);
+	const uint64_t size = pBufferUpdate->mSize > 0 ? pBufferUpdate->mSize : pBuffer->mDesc.mSize - pBufferUpdate->mDstOffset;
+	ASSERT(pBufferUpdate->mDstOffset + size <= pBuffer->mDesc.mSize);
+	pBufferUpdate->mSize = size;
+
+	if (pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY)
+	{
+		// CPU visible buffers are written in place
+		bool map = !pBuffer->pCpuMappedAddress;
+		if (map)
+			mapBuffer(pResourceLoader->pRenderer, pBuffer, NULL);
+		// pBuffer is only set if endUpdateResource has to unmap the buffer again
+		pBufferUpdate->mInternal = {};
+		pBufferUpdate->mInternal.pBuffer = map ? pBuffer : NULL;
+		pBufferUpdate->mInternal.mRingOffset = UINT64_MAX;
+		pBufferUpdate->pMappedData = (uint8_t*)pBuffer->pCpuMappedAddress + pBufferUpdate->mDstOffset;
+		return;
+	}
+
+	pBufferUpdate->mInternal =
+		beginStagingWrite(pResourceLoader, pBuffer->mDesc.mNodeIndex, size, RESOURCE_BUFFER_ALIGNMENT, &pBufferUpdate->pMappedData);
+}
+
+void endUpdateResource(BufferUpdateDesc* pBufferUpdate, SyncToken* token)
+{
+	Buffer* pBuffer = pBufferUpdate->pBuffer;
+	ASSERT(pBufferUpdate->pMappedData);
+	if (pBuffer->mDesc.mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY)
+	{
+		if (pBufferUpdate->mInternal.pBuffer)
+			unmapBuffer(pResourceLoader->pRenderer, pBuffer);
+	}
+	else
+	{
+		StagedUpdateDesc staged = {};
+		staged.pBuffer = pBuffer;
+		staged.mDstOffset = pBufferUpdate->mDstOffset;
+		staged.mStaging = pBufferUpdate->mInternal;
+		SyncToken updateToken;
+		queueResourceUpdate(pResourceLoader, pBuffer->mDesc.mNodeIndex, pBufferUpdate->mPriority, UpdateRequest(staged), true, &updateToken);
+#if defined(DIRECT3D11)
+		waitTokenCompleted(updateToken);
+#endif
+		if (token) *token = updateToken;
+	}
+
+	pBufferUpdate->pMappedData = NULL;
+	pBufferUpdate->mInternal = {};
+}
+
+void beginUpdateResource(TextureUpdateDesc* pTextureUpdate)
+{
+	Texture*  pTexture = pTextureUpdate->pTexture;
+	Renderer* pRenderer = pResourceLoader->pRenderer;
+	ASSERT(pTexture);
+	ASSERT(pTextureUpdate->mMipLevel < pTexture->mDesc.mMipLevels);
+	ASSERT(pTextureUpdate->mArrayLayer < pTexture->mDesc.mArraySize);
+
+	const uint32_t          textureAlignment = pRenderer->pActiveGpuSettings->mUploadBufferTextureAlignment;
+	const uint32_t          textureRowAlignment = pRenderer->pActiveGpuSettings->mUploadBufferTextureRowAlignment;
+	const ImageFormat::Enum fmt = pTexture->mDesc.mFormat;
+	const uint32_t          blockSize = ImageFormat::GetBytesPerBlock(fmt);
+	const uint3             pxBlockDim = ImageFormat::GetBlockSize(fmt);
+	const uint32_t          mip = pTextureUpdate->mMipLevel;
+	const uint3             pxImageDim{ max(1U, pTexture->mDesc.mWidth >> mip), max(1U, pTexture->mDesc.mHeight >> mip),
+                            max(1U, pTexture->mDesc.mDepth >> mip) };
+	const uint3             uploadExtent{ (pxImageDim + pxBlockDim - uint3(1)) / pxBlockDim };
+
+	pTextureUpdate->mRowCount = uploadExtent.y;
+	pTextureUpdate->mDstRowPitch = round_up(blockSize * uploadExtent.x, textureRowAlignment);
+	pTextureUpdate->mDstSlicePitch = pTextureUpdate->mDstRowPitch * uploadExtent.y;
+	pTextureUpdate->mInternal = beginStagingWrite(
+		pResourceLoader, pTexture->mDesc.mNodeIndex, (uint64_t)pTextureUpdate->mDstSlicePitch * uploadExtent.z, textureAlignment,
+		&pTextureUpdate->pMappedData);
+}
+
+void endUpdateResource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
+{
+	ASSERT(pTextureUpdate->pMappedData);
+	StagedUpdateDesc staged = {};
+	staged.pTexture = pTextureUpdate->pTexture;
+	staged.mMipLevel = pTextureUpdate->mMipLevel;
+	staged.mArrayLayer = pTextureUpdate->mArrayLayer;
+	staged.mRowPitch = pTextureUpdate->mDstRowPitch;
+	staged.mSlicePitch = pTextureUpdate->mDstSlicePitch;
+	staged.mStaging = pTextureUpdate->mInternal;
+
+	SyncToken updateToken;
+	queueResourceUpdate(
+		pResourceLoader, pTextureUpdate->pTexture->mDesc.mNodeIndex, pTextureUpdate->mPriority, UpdateRequest(staged), true, &updateToken);
+#if defined(DIRECT3D11)
+	waitTokenCompleted(updateToken);
+#endif
+	if (token) *token = updateToken;
+
+	pTextureUpdate->pMappedData = NULL;
+	pTextureUpdate->mInternal = {};
+}
+
+static StreamedTexture* findStreamedTexture(ResourceLoader* pLoader, Texture* pTexture)
+{
+	eastl::hash_map<Texture*, StreamedTexture*>::iterator it = pLoader->mStreamedTextureMap.find(pTexture);
+	return it != pLoader->mStreamedTextureMap.end() ? it->second : NULL;
+}
+
+void requestTextureMips(Texture* pTexture, uint32_t mostDetailedMip)
+{
+	MutexLock        lock(pResourceLoader->mStreamingMutex);
+	StreamedTexture* pStreamed = findStreamedTexture(pResourceLoader, pTexture);
+	if (!pStreamed)
+		return;
+
+	// Requests never drop resident levels, that is up to the budget or evictTextureMips
+	pStreamed->mRequestedMip = min(min(mostDetailedMip, pStreamed->mTailMip), pStreamed->mResidentMip);
+	pStreamed->mLastRequestFrame = pResourceLoader->mStreamingFrame;
+}
+
+void evictTextureMips(Texture* pTexture, uint32_t mostDetailedMip)
+{
+	MutexLock        lock(pResourceLoader->mStreamingMutex);
+	StreamedTexture* pStreamed = findStreamedTexture(pResourceLoader, pTexture);
+	if (pStreamed)
+		pStreamed->mRequestedMip = max(pStreamed->mRequestedMip, min(mostDetailedMip, pStreamed->mTailMip));
+}
+
+uint32_t getTextureResidentMip(Texture* pTexture)
+{
+	MutexLock        lock(pResourceLoader->mStreamingMutex);
+	StreamedTexture* pStreamed = findStreamedTexture(pResourceLoader, pTexture);
+	return pStreamed ? pStreamed->mResidentMip : 0;
+}
+
+void updateTextureStreaming()
+{
+	ResourceLoader* pLoader = pResourceLoader;
+	MutexLock       lock(pLoader->mStreamingMutex);
+	const uint64_t  frame = ++pLoader->mStreamingFrame;
+
+	// Retired in frame order, the GPU is done with the ones replaced STREAMING_RETIRE_DELAY frames ago
+	uint32_t retiredCount = 0;
+	while (retiredCount < pLoader->mRetiredTextures.size() &&
+		   frame - pLoader->mRetiredTextures[retiredCount].mFrame >= STREAMING_RETIRE_DELAY)
+		removeTexture(pLoader->pRenderer, pLoader->mRetiredTextures[retiredCount++].pTexture);
+	pLoader->mRetiredTextures.erase(pLoader->mRetiredTextures.begin(), pLoader->mRetiredTextures.begin() + retiredCount);
+
+	eastl::vector<StreamedTexture*> requests;
+	eastl::vector<StreamedTexture*> evictable;
+	for (uint32_t i = 0; i < (uint32_t)pLoader->mStreamedTextures.size();)
+	{
+		StreamedTexture* pStreamed = pLoader->mStreamedTextures[i];
+		if (pStreamed->pPendingTexture && isTokenCompleted(pLoader, pStreamed->mPendingToken))
+		{
+			if (pStreamed->mRemoved)
+			{
+				removeTexture(pLoader->pRenderer, pStreamed->pPendingTexture);
+				pLoader->mStreamedBytes -= pStreamed->mChainSizes[pStreamed->mTargetMip];
+			}
+			else
+			{
+				// Swapping the contents keeps the Texture handed out to the user valid, descriptors pick up the new resource through its id
+				eastl::swap(*pStreamed->pTexture, *pStreamed->pPendingTexture);
+				// The mip tail is kept for evictions, more detailed levels which got replaced are retired
+				if (pStreamed->mResidentMip == pStreamed->mTailMip)
+				{
+					pStreamed->pTailTexture = pStreamed->pPendingTexture;
+				}
+				else
+				{
+					pLoader->mRetiredTextures.push_back({ pStreamed->pPendingTexture, frame });
+					pLoader->mStreamedBytes -= pStreamed->mChainSizes[pStreamed->mResidentMip];
+				}
+				pStreamed->mResidentMip = pStreamed->mTargetMip;
+			}
+			pStreamed->pPendingTexture = NULL;
+			pStreamed->mTargetMip = UINT32_MAX;
+		}
+
+		if (pStreamed->mRemoved)
+		{
+			if (!pStreamed->mBuilding && !pStreamed->pPendingTexture)
+			{
+				conf_delete(pStreamed);
+				pLoader->mStreamedTextures.erase_unsorted(pLoader->mStreamedTextures.begin() + i);
+				continue;
+			}
+		}
+		else if (pStreamed->mTargetMip == UINT32_MAX)
+		{
+			if (pStreamed->mRequestedMip > pStreamed->mResidentMip)
+				evictStreamedTexture(pLoader, pStreamed, frame);
+			else if (pStreamed->mRequestedMip < pStreamed->mResidentMip)
+				requests.push_back(pStreamed);
+			else if (pStreamed->mResidentMip < pStreamed->mTailMip)
+				evictable.push_back(pStreamed);
+		}
+		++i;
+	}
+
+	// Most recently requested textures get the memory first, the least recently requested ones make room for them
+	eastl::sort(requests.begin(), requests.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+		return a->mLastRequestFrame > b->mLastRequestFrame;
+	});
+	eastl::sort(evictable.begin(), evictable.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+		return a->mLastRequestFrame < b->mLastRequestFrame;
+	});
+
+	const uint64_t budget = pLoader->mDesc.mMemoryBudget;
+	uint32_t       victim = 0;
+	for (uint32_t i = 0; i < (uint32_t)requests.size() && pLoader->mStreamingBuildCount < STREAMING_MAX_BUILDS; ++i)
+	{
+		StreamedTexture* pStreamed = requests[i];
+		uint32_t         mip = pStreamed->mRequestedMip;
+		if (mip < pStreamed->mResidentMip)
+		{
+			while (pLoader->mStreamedBytes + pStreamed->mChainSizes[mip] > budget && victim < (uint32_t)evictable.size() &&
+				   evictable[victim]->mLastRequestFrame < pStreamed->mLastRequestFrame)
+				evictStreamedTexture(pLoader, evictable[victim++], frame);
+
+			// Take the most detailed levels which fit
+			while (mip < pStreamed->mResidentMip && pLoader->mStreamedBytes + pStreamed->mChainSizes[mip] > budget)
+				++mip;
+			if (mip == pStreamed->mResidentMip || pLoader->mStreamingBuildCount >= STREAMING_MAX_BUILDS)
+				continue;
+		}
+		startStreamedTextureBuild(pLoader, pStreamed, mip);
+	}
+}
+
+void getResourceLoaderStats(ResourceLoaderStats* pStats)
+{
+	ResourceLoader* pLoader = pResourceLoader;
+	*pStats = {};
+	for (uint32_t i = 0; i < pLoader->pRenderer->mLinkedNodeCount; ++i)
+	{
+		pStats->mBytesUploaded += tfrg_atomic64_load_relaxed(&pLoader->pStagingRings[i]->mBytesUploaded);
+		pStats->mTempStagingBytes += tfrg_atomic64_load_relaxed(&pLoader->pStagingRings[i]->mTempStagingBytes);
+	}
+	pStats->mStallTimeUs = tfrg_atomic64_load_relaxed(&pLoader->mStallTimeUs);
+	pLoader->mStreamingMutex.Acquire();
+	pStats->mStreamedTextureBytes = pLoader->mStreamedBytes;
+	pLoader->mStreamingMutex.Release();
+
+	const int64_t now = getUSec();
+	const int64_t elapsed = now - pLoader->mLastStatsTimeUs;
+	if (elapsed > 0)
+		pStats->mBytesPerSecond = (double)(pStats->mBytesUploaded - pLoader->mLastStatsBytes) * 1e6 / (double)elapsed;
+	pLoader->mLastStatsBytes = pStats->mBytesUploaded;
+	pLoader->mLastStatsTimeUs = now;
+}
+
 void removeResource(Texture* pTexture)
 {
+	pResourceLoader->mStreamingMutex.Acquire();
+	StreamedTexture* pStreamed = findStreamedTexture(pResourceLoader, pTexture);
+	if (pStreamed)
+	{
+		pStreamed->mRemoved = true;
+		pResourceLoader->mStreamedBytes -= pStreamed->mChainSizes[pStreamed->mTailMip];
+		if (pStreamed->pTailTexture)
+		{
+			// The GPU might still read the mip tail it held before the last upgrade
+			pResourceLoader->mStreamedBytes -= pStreamed->mChainSizes[pStreamed->mResidentMip];
+			pResourceLoader->mRetiredTextures.push_back({ pStreamed->pTailTexture, pResourceLoader->mStreamingFrame });
+			pStreamed->pTailTexture = NULL;
+		}
+		pResourceLoader->mStreamedTextureMap.erase(pTexture);
+	}
+	pResourceLoader->mStreamingMutex.Release();
+
 	removeTexture(pResourceLoader->pRenderer, pTexture);
 }
 
@@ -1168,14 +2235,22 @@ void waitTokenCompleted(SyncToken token)
 
 bool isBatchCompleted()
 {
-	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
-	return isTokenCompleted(pResourceLoader, token);
+	for (uint32_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
+	{
+		SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenIssued[c]);
+		if (!isTokenCompleted(pResourceLoader, token))
+			return false;
+	}
+	return true;
 }
 
 void waitBatchCompleted()
 {
-	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
-	waitTokenCompleted(pResourceLoader, token);
+	for (uint32_t c = 0; c < LOAD_PRIORITY_COUNT; ++c)
+	{
+		SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenIssued[c]);
+		waitTokenCompleted(pResourceLoader, token);
+	}
 }
 
 void flushResourceUpdates()
@@ -1209,7 +2284,7 @@ shaderc_shader_kind getShadercShaderType(ShaderStage type)
 }
 #endif
 
-#if defined(VULKAN)
+#if defined(VULKAN) || defined(NULL_RENDERER)
 #if defined(__ANDROID__)
 // Android:
 // Use shaderc to compile glsl to spirV
@@ -1243,6 +2318,16 @@ void vk_compileShader(
 }
 #else
 // PC:
+static eastl::string get_glslang_validator_path()
+{
+	eastl::string glslangValidator = getenv("VULKAN_SDK");
+	if (glslangValidator.size())
+		glslangValidator += "/bin/glslangValidator";
+	else
+		glslangValidator = "/usr/bin/glslangValidator";
+	return glslangValidator;
+}
+
 // Vulkan has no builtin functions to compile source to spirv
 // So we call the glslangValidator tool located inside VulkanSDK on user machine to compile the glsl code to spirv
 // This code is not added to Vulkan.cpp since it calls no Vulkan specific functions
@@ -1293,11 +2378,7 @@ void vk_compileShader(
 	}
 	args.push_back(commandLine);
 
-	eastl::string glslangValidator = getenv("VULKAN_SDK");
-	if (glslangValidator.size())
-		glslangValidator += "/bin/glslangValidator";
-	else
-		glslangValidator = "/usr/bin/glslangValidator";
+	eastl::string glslangValidator = get_glslang_validator_path();
 	if (FileSystem::SystemRun(glslangValidator, args, outFile + "_compile.log") == 0)
 	{
 		File file = {};
@@ -1410,22 +2491,16 @@ extern void compileShader(
 	uint32_t macroCount, ShaderMacro* pMacros, void* (*allocator)(size_t a, const char *f, int l, const char *sf), uint32_t* pByteCodeSize, char** ppByteCode, const char* pEntryPoint);
 #endif
 
-// Function to generate the timestamp of this shader source file considering all include file timestamp
-static bool process_source_file(File* original, File* file, time_t& outTimeStamp, eastl::string& outCode)
+// Reads the shader source and hashes it together with every file it includes, so the byte code cache key changes
+// whenever anything the compiler will see changes
+static bool process_source_file(File* original, File* file, ShaderCacheHasher* pHasher, eastl::string& outCode)
 {
-	// If the source if a non-packaged file, store the timestamp
-	if (file)
-	{
-		eastl::string fullName = file->GetName();
-		time_t          fileTimeStamp = FileSystem::GetLastModifiedTime(fullName);
-		if (fileTimeStamp > outTimeStamp)
-			outTimeStamp = fileTimeStamp;
-	}
-
 	const eastl::string pIncludeDirective = "#include";
 	while (!file->IsEof())
 	{
 		eastl::string line = file->ReadLine();
+		if (pHasher)
+			pHasher->Add(line);
 		size_t        filePos = line.find(pIncludeDirective, 0);
 		const size_t  commentPosCpp = line.find("//", 0);
 		const size_t  commentPosC = line.find("/*", 0);
@@ -1471,7 +2546,7 @@ static bool process_source_file(File* original, File* file, time_t& outTimeStamp
 			}
 
 			// Add the include file into the current code recursively
-			if (!process_source_file(original, &includeFile, outTimeStamp, outCode))
+			if (!process_source_file(original, &includeFile, pHasher, outCode))
 			{
 				includeFile.Close();
 				return false;
@@ -1507,47 +2582,31 @@ static bool process_source_file(File* original, File* file, time_t& outTimeStamp
 	return true;
 }
 
-// Loads the bytecode from file if the binary shader file is newer than the source
-bool check_for_byte_code(const eastl::string& binaryShaderName, time_t sourceTimeStamp, eastl::vector<char>& byteCode)
+// Identifies the compiler build so an updated compiler does not reuse byte code produced by the previous one
+static eastl::string get_shader_compiler_id(Renderer* pRenderer, ShaderTarget target)
 {
-	if (!FileSystem::FileExists(binaryShaderName, FSR_Absolute))
-		return false;
-
-	// If source code is loaded from a package, its timestamp will be zero. Else check that binary is not older
-	// than source
-	if (sourceTimeStamp && FileSystem::GetLastModifiedTime(binaryShaderName) < sourceTimeStamp)
-		return false;
-
-	File file = {};
-	file.Open(binaryShaderName, FM_ReadBinary, FSR_Absolute);
-	if (!file.IsOpen())
+	eastl::string compilerId;
+	switch (pRenderer->mSettings.mApi)
 	{
-		LOGF(LogLevel::eERROR, (binaryShaderName + " is not a valid shader bytecode file").c_str());
-		return false;
+		case RENDERER_API_D3D12:
+		case RENDERER_API_XBOX_D3D12:
+		case RENDERER_API_D3D11: compilerId = target >= shader_target_6_0 ? "dxc" : "fxc"; break;
+		case RENDERER_API_METAL: compilerId = "metal"; break;
+		case RENDERER_API_VULKAN:
+		// The null renderer consumes the Vulkan GLSL shaders as SPIR-V
+		case RENDERER_API_NULL:
+		{
+#if defined(VULKAN) && defined(__ANDROID__)
+			compilerId = "shaderc";
+#elif defined(VULKAN) || defined(NULL_RENDERER)
+			eastl::string glslangValidator = get_glslang_validator_path();
+			compilerId = glslangValidator + eastl::string().sprintf(" %lld", (long long)FileSystem::GetLastModifiedTime(glslangValidator));
+#endif
+			break;
+		}
+		default: break;
 	}
-
-	byteCode.resize(file.GetSize());
-	memcpy(byteCode.data(), file.ReadText().c_str(), byteCode.size());
-	return true;
-}
-
-// Saves bytecode to a file
-bool save_byte_code(const eastl::string& binaryShaderName, const eastl::vector<char>& byteCode)
-{
-	eastl::string path = FileSystem::GetPath(binaryShaderName);
-	if (!FileSystem::DirExists(path))
-		FileSystem::CreateDir(path);
-
-	File outFile = {};
-	outFile.Open(binaryShaderName, FM_WriteBinary, FSR_Absolute);
-
-	if (!outFile.IsOpen())
-		return false;
-
-	outFile.Write(byteCode.data(), (uint32_t)byteCode.size() * sizeof(char));
-	outFile.Close();
-
-	return true;
+	return compilerId;
 }
 
 bool load_shader_stage_byte_code(
@@ -1555,9 +2614,9 @@ bool load_shader_stage_byte_code(
 	ShaderMacro* pMacros, eastl::vector<char>& byteCode,
 	const char* pEntryPoint)
 {
-	File            shaderSource = {};
-	eastl::string code;
-	time_t          timeStamp = 0;
+	File              shaderSource = {};
+	eastl::string     code;
+	ShaderCacheHasher hasher;
 
 #ifndef METAL
 	const char* shaderName = fileName;
@@ -1570,23 +2629,19 @@ bool load_shader_stage_byte_code(
 	shaderSource.Open(shaderName, FM_ReadBinary, root);
 	ASSERT(shaderSource.IsOpen());
 
-	if (!process_source_file(&shaderSource, &shaderSource, timeStamp, code))
+	if (!process_source_file(&shaderSource, &shaderSource, &hasher, code))
 		return false;
 
-	eastl::string name, extension, path;
-	FileSystem::SplitPath(fileName, &path, &name, &extension);
-	eastl::string shaderDefines;
-	// Apply user specified macros
-	for (uint32_t i = 0; i < macroCount; ++i)
+	// glslangValidator picks up limits from a config file next to the source
+	eastl::string configFileName = FileSystem::GetPath(shaderSource.GetName()) + "/config.conf";
+	if (FileSystem::FileExists(configFileName, FSR_Absolute))
 	{
-		shaderDefines += (pMacros[i].definition + pMacros[i].value);
+		File configFile = {};
+		configFile.Open(configFileName, FM_ReadBinary, FSR_Absolute);
+		hasher.Add(configFile.ReadText());
+		configFile.Close();
 	}
 
-#if 0    //#ifdef _DURANGO
-	// Using Durango application data storage requires appmanifest(from application) changes.
-	eastl::string binaryShaderName = FileSystem::GetAppPreferencesDir(NULL,NULL) + "/" + pRenderer->pName + "/CompiledShadersBinary/" +
-		FileSystem::GetFileName(fileName) + eastl::string().sprintf("_%zu", eastl::hash(shaderDefines)) + extension + ".bin";
-#else
 	eastl::string rendererApi;
 	switch (pRenderer->mSettings.mApi)
 	{
@@ -1594,10 +2649,15 @@ bool load_shader_stage_byte_code(
 		case RENDERER_API_XBOX_D3D12: rendererApi = "D3D12"; break;
 		case RENDERER_API_D3D11: rendererApi = "D3D11"; break;
 		case RENDERER_API_VULKAN: rendererApi = "Vulkan"; break;
+		case RENDERER_API_NULL: rendererApi = "Null"; break;
 		case RENDERER_API_METAL: rendererApi = "Metal"; break;
 		default: break;
 	}
 
+#if 0    //#ifdef _DURANGO
+	// Using Durango application data storage requires appmanifest(from application) changes.
+	eastl::string shaderCacheDir = FileSystem::GetAppPreferencesDir(NULL,NULL) + "/" + pRenderer->pName + "/CompiledShadersBinary/";
+#else
 	eastl::string appName(pRenderer->pName);
 
 #ifdef __linux__
@@ -1605,26 +2665,54 @@ bool load_shader_stage_byte_code(
 	appName = appName != pRenderer->pName ? appName : appName + "_";
 #endif
 
-	eastl::string binaryShaderName = FileSystem::GetProgramDir() + "/" + appName + eastl::string("/Shaders/") + rendererApi +
-									 eastl::string().sprintf("/CompiledShadersBinary/") + FileSystem::GetFileName(fileName) +
-									 eastl::string().sprintf("_%zu", eastl::string_hash<eastl::string>()(shaderDefines)) + extension +
-									 eastl::string().sprintf("%u", target) + ".bin";
+	// Entries are content addressed so several applications, or a build farm, can point at one shared directory
+	const char*   pSharedCacheDir = getenv("THE_FORGE_SHADER_CACHE_DIR");
+	eastl::string shaderCacheDir = pSharedCacheDir && *pSharedCacheDir
+									   ? FileSystem::AddTrailingSlash(pSharedCacheDir) + rendererApi
+									   : FileSystem::GetProgramDir() + "/" + appName + eastl::string("/Shaders/") + rendererApi +
+											 "/CompiledShadersBinary";
 #endif
 
-	// Shader source is newer than binary
-	if (!check_for_byte_code(binaryShaderName, timeStamp, byteCode))
+	hasher.Add(rendererApi);
+	hasher.Add(get_shader_compiler_id(pRenderer, target));
+#if defined(_WINDOWS)
+	hasher.Add("WINDOWS");
+#elif defined(__ANDROID__)
+	hasher.Add("ANDROID");
+#elif defined(__linux__)
+	hasher.Add("LINUX");
+#endif
+	hasher.Add((uint32_t)target);
+	hasher.Add((uint32_t)stage);
+	hasher.Add(pEntryPoint);
+	hasher.Add(macroCount);
+	for (uint32_t i = 0; i < macroCount; ++i)
+	{
+		hasher.Add(pMacros[i].definition);
+		hasher.Add(pMacros[i].value);
+	}
+	const ShaderCacheKey cacheKey = hasher.GetKey();
+
+	if (!load_shader_cache_entry(shaderCacheDir, cacheKey, byteCode))
 	{
-		if (pRenderer->mSettings.mApi == RENDERER_API_METAL || pRenderer->mSettings.mApi == RENDERER_API_VULKAN)
+		if (pRenderer->mSettings.mApi == RENDERER_API_METAL || pRenderer->mSettings.mApi == RENDERER_API_VULKAN ||
+			pRenderer->mSettings.mApi == RENDERER_API_NULL)
 		{
-#if defined(VULKAN)
+			// The offline compilers write their output to a file, give them a private scratch path and publish the
+			// result through the cache so concurrent processes never read a half written entry
+			eastl::string compilerOutput = get_shader_cache_temp_path(shaderCacheDir, cacheKey);
+#if defined(VULKAN) || defined(NULL_RENDERER)
 #if defined(__ANDROID__)
-			vk_compileShader(pRenderer, stage, (uint32_t)code.size(), code.c_str(), binaryShaderName, macroCount, pMacros, &byteCode, pEntryPoint);
+			vk_compileShader(pRenderer, stage, (uint32_t)code.size(), code.c_str(), compilerOutput, macroCount, pMacros, &byteCode, pEntryPoint);
 #else
-			vk_compileShader(pRenderer, target, shaderSource.GetName(), binaryShaderName, macroCount, pMacros, &byteCode, pEntryPoint);
+			vk_compileShader(pRenderer, target, shaderSource.GetName(), compilerOutput, macroCount, pMacros, &byteCode, pEntryPoint);
 #endif
 #elif defined(METAL)
-			mtl_compileShader(pRenderer, shaderSource.GetName(), binaryShaderName, macroCount, pMacros, &byteCode, pEntryPoint);
+			mtl_compileShader(pRenderer, shaderSource.GetName(), compilerOutput, macroCount, pMacros, &byteCode, pEntryPoint);
 #endif
+			FileSystem::Delete(compilerOutput);
+			FileSystem::Delete(compilerOutput + "_compile.log");
+			FileSystem::Delete(compilerOutput + ".air");
 		}
 		else
 		{
@@ -1637,11 +2725,6 @@ bool load_shader_stage_byte_code(
 			byteCode.resize(byteCodeSize);
 			memcpy(byteCode.data(), pByteCode, byteCodeSize);
 			conf_free(pByteCode);
-			if (!save_byte_code(binaryShaderName, byteCode))
-			{
-				const char* shaderName = shaderSource.GetName().c_str();
-				LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", shaderName);
-			}
 #endif
 		}
 		if (!byteCode.size())
@@ -1650,6 +2733,11 @@ bool load_shader_stage_byte_code(
 			shaderSource.Close();
 			return false;
 		}
+		if (!save_shader_cache_entry(shaderCacheDir, cacheKey, byteCode))
+		{
+			const char* shaderName = shaderSource.GetName().c_str();
+			LOGF(LogLevel::eWARNING, "Failed to save byte code for file %s", shaderName);
+		}
 	}
 
 	shaderSource.Close();
@@ -1846,8 +2934,7 @@ void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShad
 				ASSERT(shaderSource.IsOpen());
 
 				pStage->mName = pDesc->mStages[i].mFileName;
-				time_t timestamp = 0;
-				process_source_file(&shaderSource, &shaderSource, timestamp, pStage->mCode);
+				process_source_file(&shaderSource, &shaderSource, NULL, pStage->mCode);
                 if (pDesc->mStages[i].mEntryPointName)
                     pStage->mEntryPoint = pDesc->mStages[i].mEntryPointName;
                 else
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include "ShaderCache.h"
+
+#include "EASTL/hash_map.h"
+#include "EASTL/sort.h"
+#include "OS/Core/Atomics.h"
+#include "Interfaces/IFileSystem.h"
+#include "Interfaces/ILog.h"
+#include "Interfaces/IThread.h"
+#include "Interfaces/ITime.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Interfaces/IMemory.h"
+
+#define SHADER_CACHE_MAGIC 0x43534654    // 'TFSC'
+#define SHADER_CACHE_VERSION 1
+#define SHADER_CACHE_INDEX_FILE "index.txt"
+// Scratch files older than this were left behind by a process that died mid compile
+#define SHADER_CACHE_STALE_TEMP_SECONDS (60 * 60)
+
+typedef struct ShaderCacheEntryHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint64_t mKey[2];
+	uint64_t mSize;
+	uint32_t mChecksum;
+	uint32_t mReserved;
+} ShaderCacheEntryHeader;
+
+typedef struct ShaderCacheUsage
+{
+	eastl::string mFileName;
+	uint64_t      mSize;
+	int64_t       mLastUsed;
+} ShaderCacheUsage;
+
+static Mutex                                 gShaderCacheMutex;
+static eastl::vector<eastl::string>          gTrimmedShaderCaches;
+static tfrg_atomic32_t                       gShaderCacheTempCounter;
+
+/************************************************************************/
+// Hashing
+/************************************************************************/
+ShaderCacheHasher::ShaderCacheHasher() : mSize(0)
+{
+	mLanes[0] = 0xcbf29ce484222325ull;
+	mLanes[1] = 0x84222325cbf29ce4ull;
+}
+
+void ShaderCacheHasher::Add(const void* pData, size_t size)
+{
+	// Two independent byte-wise lanes: FNV-1a and a golden ratio multiply with an xor shift
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	uint64_t       a = mLanes[0];
+	uint64_t       b = mLanes[1];
+	for (size_t i = 0; i < size; ++i)
+	{
+		a = (a ^ pBytes[i]) * 0x100000001b3ull;
+		b = (b + pBytes[i]) * 0x9e3779b97f4a7c15ull;
+		b ^= b >> 29;
+	}
+	mLanes[0] = a;
+	mLanes[1] = b;
+	mSize += size;
+}
+
+static uint64_t shader_cache_mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return x;
+}
+
+ShaderCacheKey ShaderCacheHasher::GetKey() const
+{
+	ShaderCacheKey key;
+	key.mHash[0] = shader_cache_mix(mLanes[0] ^ mSize);
+	key.mHash[1] = shader_cache_mix(mLanes[1] + shader_cache_mix(mSize));
+	return key;
+}
+
+static uint32_t shader_cache_checksum(const void* pData, size_t size)
+{
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	uint32_t       hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ pBytes[i]) * 16777619u;
+	return hash;
+}
+
+static eastl::string get_shader_cache_key_string(const ShaderCacheKey& key)
+{
+	return eastl::string().sprintf("%016llx%016llx", (unsigned long long)key.mHash[0], (unsigned long long)key.mHash[1]);
+}
+
+static eastl::string get_shader_cache_entry_path(const eastl::string& cacheDir, const ShaderCacheKey& key)
+{
+	return FileSystem::AddTrailingSlash(cacheDir) + get_shader_cache_key_string(key) + ".bin";
+}
+
+static eastl::string get_shader_cache_temp_suffix()
+{
+	// Microseconds, a process wide counter and an address that moves with ASLR keep scratch names unique across
+	// threads and concurrent processes
+	uint64_t unique = shader_cache_mix((uint64_t)getUSec() ^ ((uint64_t)(uintptr_t)&gShaderCacheTempCounter << 16));
+	return eastl::string().sprintf(
+		".%016llx%x.tmp", (unsigned long long)unique, tfrg_atomic32_add_relaxed(&gShaderCacheTempCounter, 1));
+}
+
+static bool ends_with(const eastl::string& str, const char* suffix)
+{
+	size_t length = strlen(suffix);
+	return str.size() >= length && str.compare(str.size() - length, length, suffix) == 0;
+}
+
+/************************************************************************/
+// Index
+/************************************************************************/
+static void append_shader_cache_index(const eastl::string& cacheDir, const ShaderCacheKey& key, uint64_t size)
+{
+	// One short line per write so appends from several processes land as whole records
+	eastl::string line = eastl::string().sprintf(
+		"%s %llu %lld\n", get_shader_cache_key_string(key).c_str(), (unsigned long long)size, (long long)time(NULL));
+
+	File index = {};
+	if (!index.Open(FileSystem::AddTrailingSlash(cacheDir) + SHADER_CACHE_INDEX_FILE, FileMode(FM_Append | FM_Binary), FSR_Absolute))
+		return;
+	index.Write(line.c_str(), (unsigned)line.size());
+	index.Close();
+}
+
+// Evicts least recently used entries until the directory is back under budget and compacts the index.
+// Another process may append to the index while it is rewritten, losing a few usage records only makes the
+// eviction order less precise. An entry deleted while another process maps it stays readable on POSIX and
+// turns into a miss everywhere else.
+static void trim_shader_cache(const eastl::string& cacheDir)
+{
+	eastl::string dir = FileSystem::AddTrailingSlash(cacheDir);
+	int64_t       now = (int64_t)time(NULL);
+
+	eastl::vector<eastl::string> files;
+	FileSystem::GetFilesWithExtension(dir, ".tmp", files);
+	for (const eastl::string& file : files)
+	{
+		if (ends_with(file, ".tmp") && now - (int64_t)FileSystem::GetLastModifiedTime(file) > SHADER_CACHE_STALE_TEMP_SECONDS)
+			FileSystem::Delete(file);
+	}
+
+	files.clear();
+	FileSystem::GetFilesWithExtension(dir, ".bin", files);
+
+	eastl::hash_map<eastl::string, ShaderCacheUsage> entries;
+	for (const eastl::string& file : files)
+	{
+		if (!ends_with(file, ".bin"))
+			continue;
+		// Entries missing from the index age from their write time
+		ShaderCacheUsage usage = { file, 0, (int64_t)FileSystem::GetLastModifiedTime(file) };
+		entries[FileSystem::GetFileName(file)] = usage;
+	}
+
+	uint32_t indexLines = 0;
+	File     index = {};
+	if (index.Open(dir + SHADER_CACHE_INDEX_FILE, FM_ReadBinary, FSR_Absolute))
+	{
+		eastl::string text = index.ReadText();
+		index.Close();
+
+		size_t lineStart = 0;
+		while (lineStart < text.size())
+		{
+			size_t lineEnd = text.find('\n', lineStart);
+			if (lineEnd == eastl::string::npos)
+				lineEnd = text.size();
+			eastl::string line = text.substr(lineStart, lineEnd - lineStart);
+			lineStart = lineEnd + 1;
+			++indexLines;
+
+			char               name[33] = {};
+			unsigned long long size = 0;
+			long long          lastUsed = 0;
+			if (sscanf(line.c_str(), "%32s %llu %lld", name, &size, &lastUsed) != 3)
+				continue;
+
+			decltype(entries)::iterator it = entries.find(eastl::string(name));
+			if (it == entries.end())
+				continue;
+			it->second.mSize = size;
+			if ((int64_t)lastUsed > it->second.mLastUsed)
+				it->second.mLastUsed = (int64_t)lastUsed;
+		}
+	}
+
+	uint64_t                        totalSize = 0;
+	eastl::vector<ShaderCacheUsage> usages;
+	usages.reserve(entries.size());
+	for (decltype(entries)::value_type& it : entries)
+	{
+		if (!it.second.mSize)
+		{
+			File entry = {};
+			if (entry.Open(it.second.mFileName, FM_ReadBinary, FSR_Absolute))
+			{
+				it.second.mSize = entry.GetSize();
+				entry.Close();
+			}
+		}
+		totalSize += it.second.mSize;
+		usages.push_back(it.second);
+	}
+
+	bool evicted = false;
+	if (totalSize > SHADER_CACHE_MAX_SIZE)
+	{
+		eastl::sort(usages.begin(), usages.end(), [](const ShaderCacheUsage& lhs, const ShaderCacheUsage& rhs) {
+			return lhs.mLastUsed < rhs.mLastUsed;
+		});
+
+		// Leave some headroom so the next few compiles do not trigger another eviction right away
+		const uint64_t targetSize = SHADER_CACHE_MAX_SIZE / 4 * 3;
+		uint32_t       removed = 0;
+		while (totalSize > targetSize && removed < usages.size())
+		{
+			FileSystem::Delete(usages[removed].mFileName);
+			totalSize -= usages[removed].mSize;
+			++removed;
+		}
+		usages.erase(usages.begin(), usages.begin() + removed);
+		evicted = true;
+		LOGF(LogLevel::eINFO, "Evicted %u shader cache entries from %s", removed, dir.c_str());
+	}
+
+	if (!evicted && indexLines <= usages.size() * 2 + 64)
+		return;
+
+	eastl::string compacted;
+	for (const ShaderCacheUsage& usage : usages)
+	{
+		compacted.append_sprintf(
+			"%s %llu %lld\n", FileSystem::GetFileName(usage.mFileName).c_str(), (unsigned long long)usage.mSize,
+			(long long)usage.mLastUsed);
+	}
+
+	eastl::string tempName = dir + "index" + get_shader_cache_temp_suffix();
+	File tempIndex = {};
+	if (!tempIndex.Open(tempName, FM_WriteBinary, FSR_Absolute))
+		return;
+	tempIndex.Write(compacted.c_str(), (unsigned)compacted.size());
+	tempIndex.Close();
+	if (!FileSystem::Rename(tempName, dir + SHADER_CACHE_INDEX_FILE))
+		FileSystem::Delete(tempName);
+}
+
+static void prepare_shader_cache(const eastl::string& cacheDir)
+{
+	MutexLock lock(gShaderCacheMutex);
+	for (const eastl::string& dir : gTrimmedShaderCaches)
+	{
+		if (dir == cacheDir)
+			return;
+	}
+	gTrimmedShaderCaches.push_back(cacheDir);
+
+	if (!FileSystem::DirExists(cacheDir))
+		FileSystem::CreateDir(cacheDir);
+	else
+		trim_shader_cache(cacheDir);
+}
+
+/************************************************************************/
+// Entries
+/************************************************************************/
+bool load_shader_cache_entry(const eastl::string& cacheDir, const ShaderCacheKey& key, eastl::vector<char>& byteCode)
+{
+	prepare_shader_cache(cacheDir);
+
+	eastl::string fileName = get_shader_cache_entry_path(cacheDir, key);
+	if (!FileSystem::FileExists(fileName, FSR_Absolute))
+		return false;
+
+	MappedFile file;
+	if (!file.Open(fileName, FSR_Absolute))
+		return false;
+
+	ShaderCacheEntryHeader header = {};
+	if (file.GetSize() >= sizeof(header))
+		memcpy(&header, file.GetData(), sizeof(header));
+
+	const char* pData = (const char*)file.GetData() + sizeof(header);
+	if (file.GetSize() < sizeof(header) || header.mMagic != SHADER_CACHE_MAGIC || header.mVersion != SHADER_CACHE_VERSION ||
+		header.mKey[0] != key.mHash[0] || header.mKey[1] != key.mHash[1] || header.mSize != file.GetSize() - sizeof(header) ||
+		header.mChecksum != shader_cache_checksum(pData, (size_t)header.mSize))
+	{
+		LOGF(LogLevel::eWARNING, "Ignoring damaged shader cache entry %s", fileName.c_str());
+		return false;
+	}
+
+	byteCode.assign(pData, pData + header.mSize);
+	append_shader_cache_index(cacheDir, key, file.GetSize());
+	return true;
+}
+
+bool save_shader_cache_entry(const eastl::string& cacheDir, const ShaderCacheKey& key, const eastl::vector<char>& byteCode)
+{
+	prepare_shader_cache(cacheDir);
+
+	ShaderCacheEntryHeader header = {};
+	header.mMagic = SHADER_CACHE_MAGIC;
+	header.mVersion = SHADER_CACHE_VERSION;
+	header.mKey[0] = key.mHash[0];
+	header.mKey[1] = key.mHash[1];
+	header.mSize = byteCode.size();
+	header.mChecksum = shader_cache_checksum(byteCode.data(), byteCode.size());
+
+	// Readers in other processes only ever see a complete entry or none at all. Two processes storing the same
+	// key write identical contents so the last rename wins harmlessly.
+	eastl::string tempName = get_shader_cache_temp_path(cacheDir, key);
+	File          file = {};
+	if (!file.Open(tempName, FM_WriteBinary, FSR_Absolute))
+		return false;
+
+	bool written = file.Write(&header, sizeof(header)) == sizeof(header);
+	written = written && file.Write(byteCode.data(), (unsigned)byteCode.size()) == byteCode.size();
+	file.Close();
+
+	if (!written || !FileSystem::Rename(tempName, get_shader_cache_entry_path(cacheDir, key)))
+	{
+		FileSystem::Delete(tempName);
+		return false;
+	}
+
+	append_shader_cache_index(cacheDir, key, sizeof(header) + byteCode.size());
+	return true;
+}
+
+eastl::string get_shader_cache_temp_path(const eastl::string& cacheDir, const ShaderCacheKey& key)
+{
+	return FileSystem::AddTrailingSlash(cacheDir) + get_shader_cache_key_string(key) + get_shader_cache_temp_suffix();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#pragma once
+
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+#include <string.h>
+
+// Content addressed cache for compiled shader byte code
+//
+// Entries are named after a 128 bit hash of everything that affects the compiler output (source and included
+// files, macros, target, stage, entry point and compiler identity), so a permutation never reuses another
+// permutation's byte code and an unchanged shader is never recompiled because a timestamp moved.
+//
+// The directory can be shared by several processes. Entries are written to a temporary file and renamed into
+// place, and every entry carries a checksum so a torn or foreign file is treated as a miss. Hits and stores are
+// appended to an index file that records when each entry was last used. The first lookup in a directory from a
+// process evicts the least recently used entries once the directory exceeds SHADER_CACHE_MAX_SIZE.
+
+#ifndef SHADER_CACHE_MAX_SIZE
+#define SHADER_CACHE_MAX_SIZE (256ull << 20)
+#endif
+
+typedef struct ShaderCacheKey
+{
+	uint64_t mHash[2];
+} ShaderCacheKey;
+
+class ShaderCacheHasher
+{
+	public:
+	ShaderCacheHasher();
+
+	void Add(const void* pData, size_t size);
+	// Strings are hashed with their terminator so consecutive fields cannot run into each other
+	void Add(const char* pString) { Add(pString ? pString : "", strlen(pString ? pString : "") + 1); }
+	void Add(const eastl::string& str) { Add(str.c_str(), str.size() + 1); }
+	void Add(uint32_t value) { Add(&value, sizeof(value)); }
+
+	ShaderCacheKey GetKey() const;
+
+	private:
+	uint64_t mLanes[2];
+	uint64_t mSize;
+};
+
+// Returns false on a miss or when the entry is damaged
+bool load_shader_cache_entry(const eastl::string& cacheDir, const ShaderCacheKey& key, eastl::vector<char>& byteCode);
+bool save_shader_cache_entry(const eastl::string& cacheDir, const ShaderCacheKey& key, const eastl::vector<char>& byteCode);
+// Unique scratch path inside the cache directory for compilers that can only write their output to a file
+eastl::string get_shader_cache_temp_path(const eastl::string& cacheDir, const ShaderCacheKey& key);
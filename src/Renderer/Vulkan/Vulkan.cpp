@@ -78,6 +78,7 @@ static const char * g_hackSemanticList[] =
 #include "IRenderer.h"
 #include "EASTL/functional.h"
 #include "EASTL/sort.h"
+#include "Interfaces/IFileSystem.h"
 #include "Interfaces/ILog.h"
 #include "VulkanMemoryAllocator/VulkanMemoryAllocator.h"
 #include "OS/Core/Atomics.h"
@@ -406,6 +407,8 @@ static bool gExternalMemoryExtension = false;
 static bool gDrawIndirectCountExtension = false;
 static bool gDeviceGroupCreationExtension = false;
 static bool gDescriptorIndexingExtension = false;
+/// Descriptor indexing features needed by the bindless table are supported
+static bool gBindlessSupported = false;
 static bool gAMDDrawIndirectCountExtension = false;
 static bool gAMDGCNShaderExtension = false;
 static bool gNVRayTracingExtension = false;
@@ -555,15 +558,46 @@ union DescriptorUpdateData
 namespace {
 #endif
 
+#define INVALID_CACHE_ENTRY UINT32_MAX
+/// A cached set is recycled this many cache frames (gCacheFrameIndex) after its last bind, once every queue completed the
+/// work recorded with it
+#define DESCRIPTOR_SET_RETIRE_FRAMES 4
+
+typedef struct DescriptorSetCacheEntry
+{
+	VkDescriptorSet pDescriptorSet;
+	uint64_t        mKey;
+	/// gCacheFrameIndex of the last bind
+	uint64_t        mLastUsedFrame;
+	uint32_t        mPrev;
+	uint32_t        mNext;
+} DescriptorSetCacheEntry;
+
+/// Descriptor sets of one update frequency addressed by the hash of their contents and kept across frames, so binding the same
+/// resources again costs a lookup instead of vkUpdateDescriptorSet. The hash covers the descriptor index, array index and id
+/// of every bound resource. Ids are never reused: sets of removed resources are never hit again and age out. Entries are
+/// kept in least recently used order, a miss recycles the tail once no frame in flight can use it anymore. A cache full of sets
+/// still in flight grows with sets from an overflow pool instead.
+typedef struct DescriptorSetCache
+{
+	HashMap                  mEntryIndices;
+	DescriptorSetCacheEntry* pEntries;
+	uint32_t                 mCapacity;
+	uint32_t                 mCount;
+	/// Most / least recently used entry
+	uint32_t                 mHead;
+	uint32_t                 mTail;
+} DescriptorSetCache;
+
 typedef struct DescriptorBinderNode
 {
 	uint32_t              mMaxUsagePerSet[DESCRIPTOR_UPDATE_FREQ_COUNT];
 
-	VkDescriptorSet*      pDescriptorSets_FrameFreqUsage[MAX_FRAMES_IN_FLIGHT][DESCRIPTOR_UPDATE_FREQ_COUNT];
-	HashMap               mUpdatedHashes[MAX_FRAMES_IN_FLIGHT][DESCRIPTOR_UPDATE_FREQ_COUNT];
-	/// VK_UNIFORM_BUFFER_DYNAMIC hash to avoid redundant calls to vkUpdateDescriptorSet
-	HashMap               mUpdatedDynamicUniformHashes[MAX_FRAMES_IN_FLIGHT][DESCRIPTOR_UPDATE_FREQ_COUNT];
-	uint32_t              mUpdateCount[MAX_FRAMES_IN_FLIGHT][DESCRIPTOR_UPDATE_FREQ_COUNT];
+	/// DESCRIPTOR_UPDATE_FREQ_NONE, PER_FRAME and PER_BATCH sets
+	DescriptorSetCache    mSetCaches[DESCRIPTOR_UPDATE_FREQ_COUNT];
+	/// DESCRIPTOR_UPDATE_FREQ_PER_DRAW sets are updated on every bind, one ring per frame in flight
+	VkDescriptorSet*      pPerDrawDescriptorSets[MAX_FRAMES_IN_FLIGHT];
+	uint32_t              mPerDrawUpdateCount[MAX_FRAMES_IN_FLIGHT];
 
 	/// Array of Dynamic offsets per update frequency to pass the vkCmdBindDescriptorSet for binding dynamic uniform or storage buffers
 	uint32_t*             pDynamicOffsets[DESCRIPTOR_UPDATE_FREQ_COUNT];
@@ -591,13 +625,147 @@ typedef struct DescriptorBinder
 {
 	DescriptorStoreHeap*  pDescriptorPool;
 	DescriptorBinderMap   mRootSignatureNodes;
+	/// Node of the last root signature bound through this binder to skip the map lookup for consecutive binds
+	const RootSignature*  pLastRootSignature;
+	DescriptorBinderNode* pLastNode;
+	/// Descriptor set cache counters (getDescriptorBinderStats)
+	uint64_t              mCacheHits;
+	uint64_t              mCacheMisses;
+	uint64_t              mCacheEvictions;
+	/// Pools of the sets added to caches which ran full of sets in flight
+	eastl::vector<DescriptorStoreHeap*> mOverflowPools;
 } DescriptorBinder;
 
-static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName)
+static void unlink_cache_entry(DescriptorSetCache* pCache, uint32_t index)
+{
+	DescriptorSetCacheEntry* pEntry = &pCache->pEntries[index];
+	if (pEntry->mPrev != INVALID_CACHE_ENTRY)
+		pCache->pEntries[pEntry->mPrev].mNext = pEntry->mNext;
+	else
+		pCache->mHead = pEntry->mNext;
+	if (pEntry->mNext != INVALID_CACHE_ENTRY)
+		pCache->pEntries[pEntry->mNext].mPrev = pEntry->mPrev;
+	else
+		pCache->mTail = pEntry->mPrev;
+}
+
+static void push_cache_entry_front(DescriptorSetCache* pCache, uint32_t index)
+{
+	DescriptorSetCacheEntry* pEntry = &pCache->pEntries[index];
+	pEntry->mPrev = INVALID_CACHE_ENTRY;
+	pEntry->mNext = pCache->mHead;
+	if (pCache->mHead != INVALID_CACHE_ENTRY)
+		pCache->pEntries[pCache->mHead].mPrev = index;
+	else
+		pCache->mTail = index;
+	pCache->mHead = index;
+}
+
+/// Returns the entry holding the contents hashed to key, INVALID_CACHE_ENTRY if there is none
+static uint32_t find_cached_descriptor_set(DescriptorSetCache* pCache, uint64_t key, uint64_t frame)
+{
+	ConstHashMapIterator it = pCache->mEntryIndices.find(key);
+	if (it == pCache->mEntryIndices.end())
+		return INVALID_CACHE_ENTRY;
+
+	const uint32_t index = it->second;
+	pCache->pEntries[index].mLastUsedFrame = frame;
+	if (pCache->mHead != index)
+	{
+		unlink_cache_entry(pCache, index);
+		push_cache_entry_front(pCache, index);
+	}
+	return index;
+}
+
+/// Returns an entry for new contents (to be written by the caller), INVALID_CACHE_ENTRY if all sets are used by frames in flight
+static uint32_t add_cached_descriptor_set(DescriptorSetCache* pCache, uint64_t key, uint64_t frame, bool* pEvicted)
+{
+	uint32_t index = INVALID_CACHE_ENTRY;
+	*pEvicted = false;
+	if (pCache->mCount < pCache->mCapacity)
+	{
+		index = pCache->mCount++;
+	}
+	else
+	{
+		// Cache frames only pass once the queues completed the work submitted before, the GPU is done with the set
+		index = pCache->mTail;
+		if (index == INVALID_CACHE_ENTRY || pCache->pEntries[index].mLastUsedFrame + DESCRIPTOR_SET_RETIRE_FRAMES > frame)
+			return INVALID_CACHE_ENTRY;
+
+		unlink_cache_entry(pCache, index);
+		pCache->mEntryIndices.erase(pCache->pEntries[index].mKey);
+		*pEvicted = true;
+	}
+
+	pCache->pEntries[index].mKey = key;
+	pCache->pEntries[index].mLastUsedFrame = frame;
+	push_cache_entry_front(pCache, index);
+	pCache->mEntryIndices.insert({ { key, index } });
+	return index;
+}
+
+/// Doubles the capacity of a cache whose sets are all in flight. The new sets come from a pool sized for them, the binder
+/// pool only holds the sets counted in addDescriptorBinder
+static void grow_descriptor_set_cache(
+	Renderer* pRenderer, DescriptorBinder* pDescriptorBinder, const RootSignature* pRootSignature, uint32_t setIndex,
+	DescriptorSetCache* pCache)
+{
+	const uint32_t newSetCount = max(1U, pCache->mCapacity);
+
+	VkDescriptorPoolSize poolSizes[CONF_DESCRIPTOR_TYPE_RANGE_SIZE] = {};
+	for (uint32_t d = 0; d < pRootSignature->mDescriptorCount; ++d)
+	{
+		const DescriptorInfo* pDesc = &pRootSignature->pDescriptors[d];
+		if (pDesc->mUpdateFrquency != setIndex)
+			continue;
+		uint32_t descriptorTypeIndex = pDesc->mVkType;
+#ifdef VK_NV_ray_tracing
+		if (descriptorTypeIndex == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_NV)
+			descriptorTypeIndex = VK_DESCRIPTOR_TYPE_RANGE_SIZE;
+#endif
+		poolSizes[descriptorTypeIndex].type = pDesc->mVkType;
+		poolSizes[descriptorTypeIndex].descriptorCount += pDesc->mDesc.size * newSetCount;
+	}
+	// Vulkan does not allow empty pool sizes
+	uint32_t poolSizeCount = 0;
+	for (uint32_t i = 0; i < gDescriptorTypeRangeSize; ++i)
+		if (poolSizes[i].descriptorCount)
+			poolSizes[poolSizeCount++] = poolSizes[i];
+
+	DescriptorStoreHeap* pPool = NULL;
+	add_descriptor_heap(pRenderer, newSetCount, 0, poolSizes, poolSizeCount, &pPool);
+	pDescriptorBinder->mOverflowPools.push_back(pPool);
+
+	const uint32_t capacity = pCache->mCapacity + newSetCount;
+	pCache->pEntries = (DescriptorSetCacheEntry*)conf_realloc(pCache->pEntries, capacity * sizeof(DescriptorSetCacheEntry));
+	for (uint32_t entryIdx = pCache->mCapacity; entryIdx < capacity; ++entryIdx)
+	{
+		VkDescriptorSet* pSets[] = { &pCache->pEntries[entryIdx].pDescriptorSet };
+		consume_descriptor_sets_lock_free(pRenderer, &pRootSignature->mVkDescriptorSetLayouts[setIndex], pSets, 1, pPool);
+	}
+
+	LOGF(
+		LogLevel::eWARNING, "Descriptor set cache of set (%u) is full of sets in flight, growing it from %u to %u sets", setIndex,
+		pCache->mCapacity, capacity);
+	pCache->mCapacity = capacity;
+}
+
+/// Adds a resource to a cache key. Its position is part of the key, binding the same resources to other descriptors or array
+/// elements gives a different set
+static inline uint64_t hash_descriptor_resource(uint64_t hash, uint32_t descriptorIndex, uint32_t arrayIndex, uint64_t resourceId)
+{
+	const uint64_t keyData[2] = { (uint64_t)descriptorIndex << 32 | arrayIndex, resourceId };
+	return eastl::mem_hash<uint64_t>()(keyData, 2, hash);
+}
+
+static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const char* pResName, uint32_t* pIndex)
 {
 	DescriptorNameToIndexMap::const_iterator it = pRootSignature->pDescriptorNameToIndexMap.find(pResName);
 	if (it != pRootSignature->pDescriptorNameToIndexMap.end())
 	{
+		*pIndex = it->second;
 		return &pRootSignature->pDescriptors[it->second];
 	}
 	else
@@ -606,6 +774,23 @@ static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature,
 		return NULL;
 	}
 }
+
+static const DescriptorInfo* get_descriptor(const RootSignature* pRootSignature, const DescriptorData* pParam, uint32_t paramIndex)
+{
+	if (pParam->pName)
+	{
+		uint32_t index = UINT32_MAX;
+		return get_descriptor(pRootSignature, pParam->pName, &index);
+	}
+
+	if (pParam->mIndex >= pRootSignature->mDescriptorCount)
+	{
+		LOGF(LogLevel::eERROR, "Descriptor at index (%u) has no name and an invalid descriptor index (%u)", paramIndex, pParam->mIndex);
+		return NULL;
+	}
+
+	return &pRootSignature->pDescriptors[pParam->mIndex];
+}
 /************************************************************************/
 // Render Pass Implementation
 /************************************************************************/
@@ -645,6 +830,9 @@ typedef struct FrameBuffer
 	uint32_t      mWidth;
 	uint32_t      mHeight;
 	uint32_t      mArraySize;
+	/// Attachments, the frame buffer is invalidated when one of them gets removed
+	uint64_t      mTextureIds[MAX_RENDER_TARGET_ATTACHMENTS + 1];
+	uint32_t      mTextureIdCount;
 } FrameBuffer;
 
 static void add_render_pass(Renderer* pRenderer, const RenderPassDesc* pDesc, RenderPass** ppRenderPass)
@@ -819,6 +1007,7 @@ static void add_framebuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, F
 		}
 		*iter_attachments = pDesc->ppRenderTargets[i]->pVkDescriptors[handle];
 		++iter_attachments;
+		pFrameBuffer->mTextureIds[pFrameBuffer->mTextureIdCount++] = pDesc->ppRenderTargets[i]->pTexture->mTextureId;
 	}
 	// Depth/stencil
 	if (pDesc->pDepthStencil)
@@ -837,6 +1026,7 @@ static void add_framebuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, F
 		}
 		*iter_attachments = pDesc->pDepthStencil->pVkDescriptors[handle];
 		++iter_attachments;
+		pFrameBuffer->mTextureIds[pFrameBuffer->mTextureIdCount++] = pDesc->pDepthStencil->pTexture->mTextureId;
 	}
 
 	DECLARE_ZERO(VkFramebufferCreateInfo, add_info);
@@ -867,51 +1057,624 @@ static void remove_framebuffer(Renderer* pRenderer, FrameBuffer* pFrameBuffer)
 	SAFE_FREE(pFrameBuffer);
 }
 /************************************************************************/
-// Per Thread Render Pass synchronization logic
+// Render Pass / Frame Buffer cache
 /************************************************************************/
-/// Render-passes are not exposed to the app code since they are not available on all apis
-/// This map takes care of hashing a render pass based on the render targets passed to cmdBeginRender
-using RenderPassMap = eastl::hash_map<uint64_t, struct RenderPass*>;
-using RenderPassMapNode = RenderPassMap::value_type;
-using RenderPassMapIt = RenderPassMap::iterator;
-using FrameBufferMap = eastl::hash_map<uint64_t, struct FrameBuffer*>;
-using FrameBufferMapNode = FrameBufferMap::value_type;
-using FrameBufferMapIt = FrameBufferMap::iterator;
-
-// RenderPass map per thread (this will make lookups lock free and we only need a lock when inserting a RenderPass Map for the first time)
-eastl::hash_map<ThreadID, RenderPassMap> gRenderPassMap;
-// FrameBuffer map per thread (this will make lookups lock free and we only need a lock when inserting a FrameBuffer map for the first time)
-eastl::hash_map<ThreadID, FrameBufferMap> gFrameBufferMap;
-Mutex                                            gRenderPassMutex;
-
-static RenderPassMap& get_render_pass_map()
-{
-	decltype(gRenderPassMap)::iterator it = gRenderPassMap.find(Thread::GetCurrentThreadID());
-	if (it == gRenderPassMap.end())
-	{
-		// Only need a lock when creating a new renderpass map for this thread
-		MutexLock lock(gRenderPassMutex);
-		return gRenderPassMap.insert(Thread::GetCurrentThreadID()).first->second;
+/// Render-passes are not exposed to the app code since they are not available on all apis.
+/// The caches below map the content hash computed in cmdBindRenderTargets to render passes and frame buffers.
+/// Lookups are lock free so any number of threads can bind render targets at once. Inserting and removing entries takes the
+/// cache mutex and is rare: it only happens on misses, when a render target gets removed and when the cache is over budget.
+/// Frame buffer hashes contain the texture ids of the attachments. Texture ids are never reused, so an entry of a removed
+/// render target can never be hit by a new one.
+#define DEFAULT_MAX_CACHED_FRAME_BUFFERS 512
+#define MAX_CACHED_RENDER_PASSES 256
+/// Entries evicted or invalidated are destroyed this many cache frames later, once no command buffer can use them anymore
+#define OBJECT_CACHE_RETIRE_FRAMES 4
+
+typedef void (*ObjectCacheDestroyFunc)(Renderer* pRenderer, void* pObject);
+
+typedef struct ObjectCacheSlot
+{
+	/// 0 if the slot is empty
+	tfrg_atomic64_t  mKey;
+	tfrg_atomicptr_t pObject;
+	tfrg_atomic64_t  mLastUsedFrame;
+} ObjectCacheSlot;
+
+typedef struct RetiredObject
+{
+	void*    pObject;
+	uint64_t mRetireFrame;
+} RetiredObject;
+
+typedef struct ObjectCache
+{
+	/// Power of two slot count, at least twice mMaxCount so probe sequences stay short
+	ObjectCacheSlot*             pSlots;
+	uint32_t                     mSlotMask;
+	uint32_t                     mCount;
+	uint32_t                     mMaxCount;
+	ObjectCacheDestroyFunc       pDestroy;
+	eastl::vector<RetiredObject> mRetiredObjects;
+	/// mMaxCount entries each, eviction and rebuilds run under the mutex and never hold more entries than that
+	ObjectCacheSlot*             pScratchSlots;
+	uint64_t*                    pScratchFrames;
+	Mutex                        mMutex;
+	tfrg_atomic64_t              mHits;
+	tfrg_atomic64_t              mMisses;
+	tfrg_atomic64_t              mEvictions;
+} ObjectCache;
+
+static ObjectCache*    gRenderPassCache = NULL;
+static ObjectCache*    gFrameBufferCache = NULL;
+/// Advanced by fence signals and idle queues (see advance_cache_frame), so it keeps running for applications that never
+/// present. Drives LRU eviction and the destruction of retired entries
+static tfrg_atomic64_t gCacheFrameIndex = 0;
+
+static void destroy_cached_render_pass(Renderer* pRenderer, void* pObject) { remove_render_pass(pRenderer, (RenderPass*)pObject); }
+
+static void destroy_cached_frame_buffer(Renderer* pRenderer, void* pObject) { remove_framebuffer(pRenderer, (FrameBuffer*)pObject); }
+
+static void add_object_cache(uint32_t maxCount, ObjectCacheDestroyFunc pDestroy, ObjectCache** ppCache)
+{
+	uint32_t slotCount = 1;
+	while (slotCount < maxCount * 2)
+		slotCount <<= 1;
+
+	ObjectCache* pCache = conf_new(ObjectCache);
+	pCache->pSlots = (ObjectCacheSlot*)conf_calloc(slotCount, sizeof(ObjectCacheSlot));
+	pCache->mSlotMask = slotCount - 1;
+	pCache->mMaxCount = maxCount;
+	pCache->pScratchSlots = (ObjectCacheSlot*)conf_calloc(maxCount, sizeof(ObjectCacheSlot));
+	pCache->pScratchFrames = (uint64_t*)conf_calloc(maxCount, sizeof(uint64_t));
+	pCache->pDestroy = pDestroy;
+	*ppCache = pCache;
+}
+
+static void remove_object_cache(Renderer* pRenderer, ObjectCache* pCache)
+{
+	for (uint32_t i = 0; i <= pCache->mSlotMask; ++i)
+	{
+		if (pCache->pSlots[i].pObject)
+			pCache->pDestroy(pRenderer, (void*)pCache->pSlots[i].pObject);
 	}
-	else
+	for (RetiredObject& retired : pCache->mRetiredObjects)
+		pCache->pDestroy(pRenderer, retired.pObject);
+
+	SAFE_FREE(pCache->pScratchFrames);
+	SAFE_FREE(pCache->pScratchSlots);
+	SAFE_FREE(pCache->pSlots);
+	conf_delete(pCache);
+}
+
+/// Lock free. Returns NULL on a miss
+static void* find_cached_object(ObjectCache* pCache, uint64_t key)
+{
+	const uint64_t frameIndex = tfrg_atomic64_load_relaxed(&gCacheFrameIndex);
+	for (uint32_t i = (uint32_t)key & pCache->mSlotMask;; i = (i + 1) & pCache->mSlotMask)
 	{
-		return it->second;
+		ObjectCacheSlot* pSlot = &pCache->pSlots[i];
+		const uint64_t   slotKey = tfrg_atomic64_load_acquire(&pSlot->mKey);
+		if (!slotKey)
+			return NULL;
+		if (slotKey == key)
+		{
+			void* pObject = (void*)tfrg_atomicptr_load_acquire(&pSlot->pObject);
+			// The slot might have been reused by a rebuild in between. Any object stored under key is valid for it
+			if (tfrg_atomic64_load_acquire(&pSlot->mKey) != key)
+				return NULL;
+			// Keep the cache line shared between threads unless the frame changed
+			if (pObject && tfrg_atomic64_load_relaxed(&pSlot->mLastUsedFrame) != frameIndex)
+				tfrg_atomic64_store_relaxed(&pSlot->mLastUsedFrame, frameIndex);
+			return pObject;
+		}
 	}
 }
 
-static FrameBufferMap& get_frame_buffer_map()
+static void destroy_retired_objects(Renderer* pRenderer, ObjectCache* pCache, uint64_t frameIndex)
 {
-	decltype(gFrameBufferMap)::iterator it = gFrameBufferMap.find(Thread::GetCurrentThreadID());
-	if (it == gFrameBufferMap.end())
+	uint32_t keep = 0;
+	for (uint32_t i = 0; i < (uint32_t)pCache->mRetiredObjects.size(); ++i)
 	{
-		// Only need a lock when creating a new framebuffer map for this thread
-		MutexLock lock(gRenderPassMutex);
-		return gFrameBufferMap.insert(Thread::GetCurrentThreadID()).first->second;
+		if (pCache->mRetiredObjects[i].mRetireFrame + OBJECT_CACHE_RETIRE_FRAMES <= frameIndex)
+			pCache->pDestroy(pRenderer, pCache->mRetiredObjects[i].pObject);
+		else
+			pCache->mRetiredObjects[keep++] = pCache->mRetiredObjects[i];
 	}
-	else
+	pCache->mRetiredObjects.resize(keep);
+}
+
+/// Called with the cache mutex held. Retires the entries pShouldRemove returns true for and rebuilds the probe sequences.
+/// Lookups running at the same time can miss an entry which is being moved, they fall back to the locked path
+static void remove_cached_objects(ObjectCache* pCache, bool (*pShouldRemove)(void* pObject, uint64_t lastUsedFrame, void* pUserData), void* pUserData)
+{
+	const uint64_t frameIndex = tfrg_atomic64_load_relaxed(&gCacheFrameIndex);
+	const uint32_t slotCount = pCache->mSlotMask + 1;
+
+	ObjectCacheSlot* pKept = pCache->pScratchSlots;
+	uint32_t         keptCount = 0;
+	for (uint32_t i = 0; i < slotCount; ++i)
 	{
-		return it->second;
+		ObjectCacheSlot* pSlot = &pCache->pSlots[i];
+		void*            pObject = (void*)pSlot->pObject;
+		if (!pObject)
+			continue;
+
+		if (pShouldRemove(pObject, pSlot->mLastUsedFrame, pUserData))
+			pCache->mRetiredObjects.push_back({ pObject, frameIndex });
+		else
+			pKept[keptCount++] = *pSlot;
+
+		tfrg_atomicptr_store_release(&pSlot->pObject, 0);
+		tfrg_atomic64_store_release(&pSlot->mKey, 0);
+	}
+
+	pCache->mCount = keptCount;
+	for (uint32_t k = 0; k < keptCount; ++k)
+	{
+		uint32_t i = (uint32_t)pKept[k].mKey & pCache->mSlotMask;
+		while (pCache->pSlots[i].mKey)
+			i = (i + 1) & pCache->mSlotMask;
+		pCache->pSlots[i].mLastUsedFrame = pKept[k].mLastUsedFrame;
+		tfrg_atomicptr_store_release(&pCache->pSlots[i].pObject, pKept[k].pObject);
+		tfrg_atomic64_store_release(&pCache->pSlots[i].mKey, pKept[k].mKey);
+	}
+}
+
+typedef struct EvictionThreshold
+{
+	/// Entries last used before this frame are evicted
+	uint64_t mLastUsedFrame;
+	/// Number of entries last used in that frame which are evicted as well
+	uint32_t mTieCount;
+} EvictionThreshold;
+
+static bool is_least_recently_used(void* pObject, uint64_t lastUsedFrame, void* pUserData)
+{
+	UNREF_PARAM(pObject);
+	EvictionThreshold* pThreshold = (EvictionThreshold*)pUserData;
+	if (lastUsedFrame < pThreshold->mLastUsedFrame)
+		return true;
+	if (lastUsedFrame != pThreshold->mLastUsedFrame || !pThreshold->mTieCount)
+		return false;
+	--pThreshold->mTieCount;
+	return true;
+}
+
+/// Called with the cache mutex held when the cache is full. Evicts exactly the least recently used quarter of the entries
+/// (at least one), entries sharing the last used frame of the threshold are only taken until the quarter is reached
+static void evict_cached_objects(ObjectCache* pCache)
+{
+	uint64_t* pLastUsedFrames = pCache->pScratchFrames;
+	uint32_t  count = 0;
+	for (uint32_t i = 0; i <= pCache->mSlotMask; ++i)
+	{
+		if (pCache->pSlots[i].pObject)
+			pLastUsedFrames[count++] = pCache->pSlots[i].mLastUsedFrame;
+	}
+	if (!count)
+		return;
+
+	const uint32_t victimCount = max(count / 4, 1U);
+	uint64_t*      pNth = pLastUsedFrames + victimCount - 1;
+	eastl::nth_element(pLastUsedFrames, pNth, pLastUsedFrames + count);
+
+	// Every entry last used before the threshold ended up in front of it
+	EvictionThreshold threshold = {};
+	threshold.mLastUsedFrame = *pNth;
+	threshold.mTieCount = victimCount;
+	for (uint64_t* pFrame = pLastUsedFrames; pFrame < pNth; ++pFrame)
+	{
+		if (*pFrame < threshold.mLastUsedFrame)
+			--threshold.mTieCount;
+	}
+
+	const uint64_t frameIndex = tfrg_atomic64_load_relaxed(&gCacheFrameIndex);
+	if (threshold.mLastUsedFrame + OBJECT_CACHE_RETIRE_FRAMES > frameIndex)
+		LOGF(LogLevel::eWARNING, "Render pass / frame buffer cache is too small for the working set (%u entries)", pCache->mMaxCount);
+
+	const uint32_t previousCount = pCache->mCount;
+	remove_cached_objects(pCache, is_least_recently_used, &threshold);
+	tfrg_atomic64_add_relaxed(&pCache->mEvictions, previousCount - pCache->mCount);
+}
+
+/// Returns the cached object for key, create is called with the cache mutex held on a miss
+template <typename T, typename CreateFunc>
+static T* get_cached_object(Renderer* pRenderer, ObjectCache* pCache, uint64_t key, CreateFunc create)
+{
+	// 0 marks empty slots
+	key = key ? key : 1;
+
+	void* pObject = find_cached_object(pCache, key);
+	if (pObject)
+	{
+		tfrg_atomic64_add_relaxed(&pCache->mHits, 1);
+		return (T*)pObject;
+	}
+
+	MutexLock lock(pCache->mMutex);
+	// Another thread might have inserted it in the meantime
+	pObject = find_cached_object(pCache, key);
+	if (pObject)
+	{
+		tfrg_atomic64_add_relaxed(&pCache->mHits, 1);
+		return (T*)pObject;
+	}
+
+	tfrg_atomic64_add_relaxed(&pCache->mMisses, 1);
+	const uint64_t frameIndex = tfrg_atomic64_load_relaxed(&gCacheFrameIndex);
+	destroy_retired_objects(pRenderer, pCache, frameIndex);
+	if (pCache->mCount >= pCache->mMaxCount)
+		evict_cached_objects(pCache);
+
+	T* pNewObject = create();
+
+	uint32_t i = (uint32_t)key & pCache->mSlotMask;
+	while (pCache->pSlots[i].mKey)
+		i = (i + 1) & pCache->mSlotMask;
+	pCache->pSlots[i].mLastUsedFrame = frameIndex;
+	// Publish the object before the key so lock free lookups never see a key without its object
+	tfrg_atomicptr_store_release(&pCache->pSlots[i].pObject, (uintptr_t)pNewObject);
+	tfrg_atomic64_store_release(&pCache->pSlots[i].mKey, key);
+	++pCache->mCount;
+
+	return pNewObject;
+}
+
+static bool references_texture(void* pObject, uint64_t lastUsedFrame, void* pUserData)
+{
+	UNREF_PARAM(lastUsedFrame);
+	const FrameBuffer* pFrameBuffer = (const FrameBuffer*)pObject;
+	const uint64_t     textureId = *(uint64_t*)pUserData;
+	for (uint32_t i = 0; i < pFrameBuffer->mTextureIdCount; ++i)
+	{
+		if (pFrameBuffer->mTextureIds[i] == textureId)
+			return true;
+	}
+	return false;
+}
+
+/// Frame buffers using pRenderTarget are retired when it gets removed
+static void invalidate_cached_frame_buffers(Renderer* pRenderer, RenderTarget* pRenderTarget)
+{
+	if (!gFrameBufferCache)
+		return;
+
+	MutexLock lock(gFrameBufferCache->mMutex);
+	uint64_t  textureId = pRenderTarget->pTexture->mTextureId;
+	remove_cached_objects(gFrameBufferCache, references_texture, &textureId);
+	destroy_retired_objects(pRenderer, gFrameBufferCache, tfrg_atomic64_load_relaxed(&gCacheFrameIndex));
+}
+
+void getRenderPassCacheStats(Renderer* pRenderer, RenderPassCacheStats* pStats)
+{
+	UNREF_PARAM(pRenderer);
+	ASSERT(pStats);
+
+	pStats->mRenderPassHits = tfrg_atomic64_load_relaxed(&gRenderPassCache->mHits);
+	pStats->mRenderPassMisses = tfrg_atomic64_load_relaxed(&gRenderPassCache->mMisses);
+	pStats->mRenderPassEvictions = tfrg_atomic64_load_relaxed(&gRenderPassCache->mEvictions);
+	pStats->mRenderPassCount = gRenderPassCache->mCount;
+	pStats->mFrameBufferHits = tfrg_atomic64_load_relaxed(&gFrameBufferCache->mHits);
+	pStats->mFrameBufferMisses = tfrg_atomic64_load_relaxed(&gFrameBufferCache->mMisses);
+	pStats->mFrameBufferEvictions = tfrg_atomic64_load_relaxed(&gFrameBufferCache->mEvictions);
+	pStats->mFrameBufferCount = gFrameBufferCache->mCount;
+}
+/************************************************************************/
+// Queue tracking
+/************************************************************************/
+/// Fence values of the queues tell when the GPU is done with the work submitted before some point. A cache frame passes
+/// once every queue completed the work submitted when the previous one passed, so the fences of the resource loader or of
+/// a compute queue, waited for several times per frame, do not make the clock run faster than the GPU
+#define MAX_TRACKED_QUEUES 8
+
+typedef struct QueueTracker
+{
+	Queue*   pQueues[MAX_TRACKED_QUEUES];
+	/// Queue fence values when the current cache frame started
+	uint64_t mFrameFenceValues[MAX_TRACKED_QUEUES];
+	Mutex    mMutex;
+} QueueTracker;
+
+static QueueTracker gQueueTracker;
+
+static void track_queue(Queue* pQueue)
+{
+	MutexLock lock(gQueueTracker.mMutex);
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		if (!gQueueTracker.pQueues[i])
+		{
+			gQueueTracker.pQueues[i] = pQueue;
+			gQueueTracker.mFrameFenceValues[i] = 0;
+			return;
+		}
+	}
+	LOGF(LogLevel::eWARNING, "%u queues are tracked, cached objects do not wait for the work of the others", MAX_TRACKED_QUEUES);
+}
+
+/// Returns the index the queue was tracked at, MAX_TRACKED_QUEUES if it was not
+static uint32_t untrack_queue(Queue* pQueue)
+{
+	MutexLock lock(gQueueTracker.mMutex);
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		if (gQueueTracker.pQueues[i] == pQueue)
+		{
+			gQueueTracker.pQueues[i] = NULL;
+			return i;
+		}
+	}
+	return MAX_TRACKED_QUEUES;
+}
+
+/// Called after a queue completed more work. Work submitted without a fence counts as done once a later fence of its queue
+/// signals or the queue goes idle
+static void advance_cache_frame()
+{
+	MutexLock lock(gQueueTracker.mMutex);
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		const Queue* pQueue = gQueueTracker.pQueues[i];
+		if (pQueue && tfrg_atomic64_load_relaxed(&pQueue->mCompletedFenceValue) < gQueueTracker.mFrameFenceValues[i])
+			return;
+	}
+
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		if (gQueueTracker.pQueues[i])
+			gQueueTracker.mFrameFenceValues[i] = tfrg_atomic64_load_relaxed(&gQueueTracker.pQueues[i]->mFenceValue);
+	}
+	tfrg_atomic64_add_relaxed(&gCacheFrameIndex, 1);
+}
+
+/// Current fence value of every tracked queue, 0 for the unused entries
+static void get_queue_fence_values(uint64_t* pFenceValues)
+{
+	MutexLock lock(gQueueTracker.mMutex);
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		const Queue* pQueue = gQueueTracker.pQueues[i];
+		pFenceValues[i] = pQueue ? tfrg_atomic64_load_relaxed(&pQueue->mFenceValue) : 0;
+	}
+}
+
+/// True once every tracked queue completed the fence values returned by get_queue_fence_values
+static bool are_queue_fence_values_completed(const uint64_t* pFenceValues)
+{
+	MutexLock lock(gQueueTracker.mMutex);
+	for (uint32_t i = 0; i < MAX_TRACKED_QUEUES; ++i)
+	{
+		const Queue* pQueue = gQueueTracker.pQueues[i];
+		if (pQueue && tfrg_atomic64_load_relaxed(&pQueue->mCompletedFenceValue) < pFenceValues[i])
+			return false;
+	}
+	return true;
+}
+/************************************************************************/
+// Bindless table
+/************************************************************************/
+/// One update after bind descriptor set holding every texture and storage buffer, bound once per pipeline instead of
+/// updating descriptor sets per draw. Resources keep their slot for their whole lifetime. Slots are written when the
+/// resource is created. A slot of a removed resource is reused once every queue completed the work submitted before the
+/// removal, so a command buffer still in flight never sees a descriptor it uses change (partially bound + update unused
+/// while pending).
+#define DEFAULT_MAX_BINDLESS_TEXTURES 16384
+#define DEFAULT_MAX_BINDLESS_BUFFERS 4096
+
+typedef struct RetiredBindlessSlot
+{
+	uint32_t mIndex;
+	/// Fence value of every tracked queue at the time of the removal
+	uint64_t mFenceValues[MAX_TRACKED_QUEUES];
+} RetiredBindlessSlot;
+
+typedef struct BindlessSlots
+{
+	uint32_t                           mCapacity;
+	/// Slots below mUsedCount were handed out at least once
+	uint32_t                           mUsedCount;
+	eastl::vector<uint32_t>            mFreeSlots;
+	eastl::vector<RetiredBindlessSlot> mRetiredSlots;
+} BindlessSlots;
+
+typedef struct BindlessTable
+{
+	VkDescriptorSetLayout pLayout;
+	VkDescriptorPool      pPool;
+	VkDescriptorSet       pSet;
+	BindlessSlots         mTextures;
+	BindlessSlots         mBuffers;
+	/// Guards the slot lists and the descriptor writes, resources get created on the loader thread as well
+	Mutex                 mMutex;
+} BindlessTable;
+
+static BindlessTable* gBindlessTable = NULL;
+
+static void add_bindless_table(Renderer* pRenderer, const RendererDesc* pDesc)
+{
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {
+		VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT
+	};
+	VkPhysicalDeviceProperties2 properties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(pRenderer->pVkActiveGPU, &properties);
+
+	uint32_t textureCount = pDesc->mMaxBindlessTextures ? pDesc->mMaxBindlessTextures : DEFAULT_MAX_BINDLESS_TEXTURES;
+	uint32_t bufferCount = pDesc->mMaxBindlessBuffers ? pDesc->mMaxBindlessBuffers : DEFAULT_MAX_BINDLESS_BUFFERS;
+	textureCount = min(
+		textureCount, min(
+						  indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+						  indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages));
+	bufferCount = min(
+		bufferCount, min(
+						 indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+						 indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers));
+
+	BindlessTable* pTable = conf_new(BindlessTable);
+	pTable->mTextures.mCapacity = textureCount;
+	pTable->mBuffers.mCapacity = bufferCount;
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = BINDLESS_TEXTURE_BINDING;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	bindings[0].descriptorCount = textureCount;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].binding = BINDLESS_BUFFER_BINDING;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = bufferCount;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	const VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+	};
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT
+	};
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+	VkResult vk_res = vkCreateDescriptorSetLayout(pRenderer->pVkDevice, &layoutInfo, NULL, &pTable->pLayout);
+	ASSERT(VK_SUCCESS == vk_res);
+
+	VkDescriptorPoolSize poolSizes[2] = { { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, textureCount },
+										  { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCount } };
+	VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 2;
+	poolInfo.pPoolSizes = poolSizes;
+	vk_res = vkCreateDescriptorPool(pRenderer->pVkDevice, &poolInfo, NULL, &pTable->pPool);
+	ASSERT(VK_SUCCESS == vk_res);
+
+	VkDescriptorSetAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	allocInfo.descriptorPool = pTable->pPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &pTable->pLayout;
+	vk_res = vkAllocateDescriptorSets(pRenderer->pVkDevice, &allocInfo, &pTable->pSet);
+	ASSERT(VK_SUCCESS == vk_res);
+
+	LOGF(LogLevel::eINFO, "Bindless table: %u textures, %u buffers", textureCount, bufferCount);
+	gBindlessTable = pTable;
+}
+
+static void remove_bindless_table(Renderer* pRenderer)
+{
+	if (!gBindlessTable)
+		return;
+
+	vkDestroyDescriptorPool(pRenderer->pVkDevice, gBindlessTable->pPool, NULL);
+	vkDestroyDescriptorSetLayout(pRenderer->pVkDevice, gBindlessTable->pLayout, NULL);
+	conf_delete(gBindlessTable);
+	gBindlessTable = NULL;
+}
+
+/// Called with the queue at trackedIndex idle and untracked, the fence values recorded for it do not apply to the next
+/// queue tracked at that index
+static void remove_bindless_queue(uint32_t trackedIndex)
+{
+	if (!gBindlessTable || trackedIndex >= MAX_TRACKED_QUEUES)
+		return;
+
+	MutexLock lock(gBindlessTable->mMutex);
+	for (RetiredBindlessSlot& retired : gBindlessTable->mTextures.mRetiredSlots)
+		retired.mFenceValues[trackedIndex] = 0;
+	for (RetiredBindlessSlot& retired : gBindlessTable->mBuffers.mRetiredSlots)
+		retired.mFenceValues[trackedIndex] = 0;
+}
+
+static uint32_t acquire_bindless_slot(BindlessSlots* pSlots, const char* pTypeName)
+{
+	// Fence values only grow, so slots become reusable in the order they were retired
+	uint32_t reusableCount = 0;
+	while (reusableCount < (uint32_t)pSlots->mRetiredSlots.size() &&
+		   are_queue_fence_values_completed(pSlots->mRetiredSlots[reusableCount].mFenceValues))
+		pSlots->mFreeSlots.push_back(pSlots->mRetiredSlots[reusableCount++].mIndex);
+	pSlots->mRetiredSlots.erase(pSlots->mRetiredSlots.begin(), pSlots->mRetiredSlots.begin() + reusableCount);
+
+	if (!pSlots->mFreeSlots.empty())
+	{
+		uint32_t index = pSlots->mFreeSlots.back();
+		pSlots->mFreeSlots.pop_back();
+		return index;
 	}
+	if (pSlots->mUsedCount < pSlots->mCapacity)
+		return pSlots->mUsedCount++;
+
+	LOGF(LogLevel::eWARNING, "Bindless table is full (%u %s), raise RendererDesc::mMaxBindless*", pSlots->mCapacity, pTypeName);
+	return INVALID_BINDLESS_INDEX;
+}
+
+static void add_bindless_texture(Renderer* pRenderer, Texture* pTexture)
+{
+	pTexture->mBindlessIndex = INVALID_BINDLESS_INDEX;
+	if (!gBindlessTable || VK_NULL_HANDLE == pTexture->pVkSRVDescriptor)
+		return;
+
+	MutexLock lock(gBindlessTable->mMutex);
+	pTexture->mBindlessIndex = acquire_bindless_slot(&gBindlessTable->mTextures, "textures");
+	if (INVALID_BINDLESS_INDEX == pTexture->mBindlessIndex)
+		return;
+
+	VkDescriptorImageInfo imageInfo = { VK_NULL_HANDLE, pTexture->pVkSRVDescriptor, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkWriteDescriptorSet  write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = gBindlessTable->pSet;
+	write.dstBinding = BINDLESS_TEXTURE_BINDING;
+	write.dstArrayElement = pTexture->mBindlessIndex;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(pRenderer->pVkDevice, 1, &write, 0, NULL);
+}
+
+static void add_bindless_buffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	pBuffer->mBindlessIndex = INVALID_BINDLESS_INDEX;
+	if (!gBindlessTable || !(pBuffer->mDesc.mDescriptors & (DESCRIPTOR_TYPE_BUFFER | DESCRIPTOR_TYPE_RW_BUFFER)))
+		return;
+
+	MutexLock lock(gBindlessTable->mMutex);
+	pBuffer->mBindlessIndex = acquire_bindless_slot(&gBindlessTable->mBuffers, "buffers");
+	if (INVALID_BINDLESS_INDEX == pBuffer->mBindlessIndex)
+		return;
+
+	VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = gBindlessTable->pSet;
+	write.dstBinding = BINDLESS_BUFFER_BINDING;
+	write.dstArrayElement = pBuffer->mBindlessIndex;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &pBuffer->mVkBufferInfo;
+	vkUpdateDescriptorSets(pRenderer->pVkDevice, 1, &write, 0, NULL);
+}
+
+/// The descriptor stays in the table until the slot gets reused, partially bound allows it to point to a destroyed resource
+static void retire_bindless_slot(BindlessSlots* pSlots, uint32_t index)
+{
+	MutexLock           lock(gBindlessTable->mMutex);
+	RetiredBindlessSlot retired = {};
+	retired.mIndex = index;
+	get_queue_fence_values(retired.mFenceValues);
+	pSlots->mRetiredSlots.push_back(retired);
+}
+
+static void remove_bindless_texture(Texture* pTexture)
+{
+	if (gBindlessTable && INVALID_BINDLESS_INDEX != pTexture->mBindlessIndex)
+		retire_bindless_slot(&gBindlessTable->mTextures, pTexture->mBindlessIndex);
+}
+
+static void remove_bindless_buffer(Buffer* pBuffer)
+{
+	if (gBindlessTable && INVALID_BINDLESS_INDEX != pBuffer->mBindlessIndex)
+		retire_bindless_slot(&gBindlessTable->mBuffers, pBuffer->mBindlessIndex);
 }
 /************************************************************************/
 // Logging, Validation layer implementation
@@ -1478,7 +2241,8 @@ VkImageUsageFlags util_to_vk_image_usage(DescriptorType usage)
 	return result;
 }
 
-VkAccessFlags util_to_vk_access_flags(ResourceState state)
+/// Accesses of stages the queue does not have are left out, the queue using the resource next makes them visible
+VkAccessFlags util_to_vk_access_flags(ResourceState state, CmdPoolType queueType)
 {
 	VkAccessFlags ret = 0;
 	if (state & RESOURCE_STATE_COPY_SOURCE)
@@ -1522,9 +2286,66 @@ VkAccessFlags util_to_vk_access_flags(ResourceState state)
 		ret |= VK_ACCESS_MEMORY_READ_BIT;
 	}
 
+	if (queueType == CMD_POOL_COPY)
+	{
+		ret &= VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	}
+	else if (queueType == CMD_POOL_COMPUTE)
+	{
+		ret &= ~(VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+				 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+				 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	}
+
 	return ret;
 }
 
+/// Stages which access a resource in the given states. Graphics stages are left out on compute and copy queues
+VkPipelineStageFlags util_determine_pipeline_stage_flags(Renderer* pRenderer, ResourceState state, CmdPoolType queueType)
+{
+	const VkPhysicalDeviceFeatures& features = pRenderer->mVkGpuFeatures[pRenderer->mActiveGPUIndex];
+	VkPipelineStageFlags            graphicsShaderStages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	if (features.geometryShader)
+		graphicsShaderStages |= VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+	if (features.tessellationShader)
+		graphicsShaderStages |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+
+	VkPipelineStageFlags flags = 0;
+	if (queueType == CMD_POOL_DIRECT || queueType == CMD_POOL_BUNDLE)
+	{
+		if (state & (RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | RESOURCE_STATE_INDEX_BUFFER))
+			flags |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		if (state & (RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | RESOURCE_STATE_UNORDERED_ACCESS))
+			flags |= graphicsShaderStages | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		if (state & RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			flags |= graphicsShaderStages;
+		// The pixel shader bit of RESOURCE_STATE_SHADER_RESOURCE
+		if (state & 0x80)
+			flags |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		if (state & RESOURCE_STATE_RENDER_TARGET)
+			flags |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		if (state & (RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_DEPTH_READ))
+			flags |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	}
+	if (queueType != CMD_POOL_COPY)
+	{
+		if (state & (RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | RESOURCE_STATE_UNORDERED_ACCESS | RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE))
+			flags |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		if (state & RESOURCE_STATE_INDIRECT_ARGUMENT)
+			flags |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	}
+	if (state & (RESOURCE_STATE_COPY_SOURCE | RESOURCE_STATE_COPY_DEST))
+		flags |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+	if (state & RESOURCE_STATE_PRESENT)
+		flags |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	if (state & RESOURCE_STATE_COMMON)
+		flags |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+	// Undefined contents or no stage of this queue touches the states: nothing to wait for, the access flags of the barrier
+	// are empty then as well (see util_to_vk_access_flags)
+	return flags ? flags : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+}
+
 VkImageLayout util_to_vk_image_layout(ResourceState usage)
 {
 	if (usage & RESOURCE_STATE_COPY_SOURCE)
@@ -2225,6 +3046,12 @@ static void AddDevice(Renderer* pRenderer)
 
 	vkGetPhysicalDeviceFeatures2KHR(pRenderer->pVkActiveGPU, &gpuFeatures2);
 
+	gBindlessSupported = gDescriptorIndexingExtension && descriptorIndexingFeatures.runtimeDescriptorArray &&
+						 descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+						 descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+						 descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+						 descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind;
+
 	// need a queue_priorite for each queue in the queue family we create
 	uint32_t queueFamiliesCount = pRenderer->mVkQueueFamilyPropertyCount[pRenderer->mActiveGPUIndex];
 	VkQueueFamilyProperties* queueFamiliesProperties = pRenderer->mVkQueueFamilyProperties[pRenderer->mActiveGPUIndex];
@@ -2352,6 +3179,207 @@ uint64_t get_vk_device_memory_offset(Renderer* pRenderer, Buffer* pBuffer)
 	return (uint64_t)allocInfo.offset;
 }
 
+/************************************************************************/
+// Pipeline Cache
+/************************************************************************/
+// Pipeline compilation goes through one VkPipelineCache per thread so threads creating pipelines in parallel do not
+// serialize on the cache. Every cache is seeded from the data saved by the previous run and the caches are merged
+// back into a single blob when the renderer is removed.
+#define PIPELINE_CACHE_FILE_MAGIC 0x43504654    // 'TFPC'
+#define PIPELINE_CACHE_FILE_VERSION 1
+
+typedef struct PipelineCacheFileHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mVendorID;
+	uint32_t mDeviceID;
+	uint32_t mDriverVersion;
+	uint32_t mChecksum;
+	uint64_t mDataSize;
+	uint8_t  mPipelineCacheUUID[VK_UUID_SIZE];
+} PipelineCacheFileHeader;
+
+typedef struct PipelineCacheStore
+{
+	Mutex                                     mLock;
+	eastl::string                             mFileName;
+	eastl::vector<uint8_t>                    mInitialData;
+	eastl::hash_map<ThreadID, VkPipelineCache> mCaches;
+} PipelineCacheStore;
+
+static uint32_t pipeline_cache_checksum(const uint8_t* pData, size_t size)
+{
+	// FNV-1a, only used to reject truncated or corrupted files
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ pData[i]) * 16777619u;
+	return hash;
+}
+
+static void fill_pipeline_cache_header(Renderer* pRenderer, PipelineCacheFileHeader* pHeader)
+{
+	const VkPhysicalDeviceProperties& props = pRenderer->pVkActiveGPUProperties->properties;
+	memset(pHeader, 0, sizeof(*pHeader));
+	pHeader->mMagic = PIPELINE_CACHE_FILE_MAGIC;
+	pHeader->mVersion = PIPELINE_CACHE_FILE_VERSION;
+	pHeader->mVendorID = props.vendorID;
+	pHeader->mDeviceID = props.deviceID;
+	pHeader->mDriverVersion = props.driverVersion;
+	memcpy(pHeader->mPipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static void load_pipeline_cache_data(Renderer* pRenderer, PipelineCacheStore* pStore)
+{
+	if (!FileSystem::FileExists(pStore->mFileName, FSR_Absolute))
+		return;
+
+	MappedFile file;
+	if (!file.Open(pStore->mFileName, FSR_Absolute))
+		return;
+
+	PipelineCacheFileHeader expected;
+	fill_pipeline_cache_header(pRenderer, &expected);
+
+	PipelineCacheFileHeader header = {};
+	const uint8_t*          pData = (const uint8_t*)file.GetData();
+	if (file.GetSize() >= sizeof(header))
+		memcpy(&header, pData, sizeof(header));
+
+	const uint8_t* pBlob = pData + sizeof(header);
+	// A new driver or a different device produces incompatible blobs, drop those instead of handing them to the driver
+	if (file.GetSize() < sizeof(header) || header.mMagic != expected.mMagic || header.mVersion != expected.mVersion ||
+		header.mVendorID != expected.mVendorID || header.mDeviceID != expected.mDeviceID ||
+		header.mDriverVersion != expected.mDriverVersion ||
+		memcmp(header.mPipelineCacheUUID, expected.mPipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+		header.mDataSize != file.GetSize() - sizeof(header) || header.mChecksum != pipeline_cache_checksum(pBlob, (size_t)header.mDataSize))
+	{
+		LOGF(LogLevel::eINFO, "Discarding pipeline cache %s, it does not match the current device or driver", pStore->mFileName.c_str());
+		return;
+	}
+
+	pStore->mInitialData.assign(pBlob, pBlob + header.mDataSize);
+}
+
+static void save_pipeline_cache_data(Renderer* pRenderer, PipelineCacheStore* pStore, const eastl::vector<uint8_t>& data)
+{
+	eastl::string path = FileSystem::GetPath(pStore->mFileName);
+	if (!FileSystem::DirExists(path))
+		FileSystem::CreateDir(path);
+
+	File file = {};
+	if (!file.Open(pStore->mFileName, FM_WriteBinary, FSR_Absolute))
+	{
+		LOGF(LogLevel::eWARNING, "Could not write pipeline cache %s", pStore->mFileName.c_str());
+		return;
+	}
+
+	PipelineCacheFileHeader header;
+	fill_pipeline_cache_header(pRenderer, &header);
+	header.mDataSize = data.size();
+	header.mChecksum = pipeline_cache_checksum(data.data(), data.size());
+
+	file.Write(&header, sizeof(header));
+	file.Write(data.data(), (uint32_t)data.size());
+	file.Close();
+}
+
+static void add_pipeline_cache(Renderer* pRenderer)
+{
+	if (pRenderer->mSettings.mDisablePipelineCache)
+		return;
+
+	PipelineCacheStore* pStore = conf_placement_new<PipelineCacheStore>(conf_calloc(1, sizeof(PipelineCacheStore)));
+
+	const VkPhysicalDeviceProperties& props = pRenderer->pVkActiveGPUProperties->properties;
+	// Same application directory as the compiled shader binaries written by the resource loader
+	eastl::string appName(pRenderer->pName);
+#ifdef __linux__
+	appName.make_lower();
+	appName = appName != pRenderer->pName ? appName : appName + "_";
+#endif
+	pStore->mFileName = FileSystem::GetProgramDir() + "/" + appName +
+						eastl::string().sprintf("/PipelineCache/Vulkan_%04x_%04x.cache", props.vendorID, props.deviceID);
+
+	load_pipeline_cache_data(pRenderer, pStore);
+
+	pRenderer->pPipelineCacheStore = pStore;
+}
+
+static void remove_pipeline_cache(Renderer* pRenderer)
+{
+	PipelineCacheStore* pStore = pRenderer->pPipelineCacheStore;
+	if (!pStore)
+		return;
+
+	if (!pStore->mCaches.empty())
+	{
+		eastl::vector<VkPipelineCache> caches;
+		for (decltype(pStore->mCaches)::value_type& it : pStore->mCaches)
+			caches.push_back(it.second);
+
+		VkPipelineCache merged = caches[0];
+		if (caches.size() > 1)
+			vkMergePipelineCaches(pRenderer->pVkDevice, merged, (uint32_t)caches.size() - 1, caches.data() + 1);
+
+		size_t dataSize = 0;
+		VkResult vk_res = vkGetPipelineCacheData(pRenderer->pVkDevice, merged, &dataSize, NULL);
+		if (VK_SUCCESS == vk_res && dataSize)
+		{
+			eastl::vector<uint8_t> data(dataSize);
+			vk_res = vkGetPipelineCacheData(pRenderer->pVkDevice, merged, &dataSize, data.data());
+			data.resize(dataSize);
+			// Skip the write when this run did not compile anything new
+			bool unchanged = data.size() == pStore->mInitialData.size() &&
+							 memcmp(data.data(), pStore->mInitialData.data(), data.size()) == 0;
+			if (VK_SUCCESS == vk_res && !unchanged)
+				save_pipeline_cache_data(pRenderer, pStore, data);
+		}
+
+		for (VkPipelineCache cache : caches)
+			vkDestroyPipelineCache(pRenderer->pVkDevice, cache, NULL);
+	}
+
+	pStore->~PipelineCacheStore();
+	conf_free(pStore);
+	pRenderer->pPipelineCacheStore = NULL;
+}
+
+VkPipelineCache get_vk_pipeline_cache(Renderer* pRenderer)
+{
+	PipelineCacheStore* pStore = pRenderer->pPipelineCacheStore;
+	if (!pStore)
+		return VK_NULL_HANDLE;
+
+	ThreadID threadId = Thread::GetCurrentThreadID();
+	MutexLock lock(pStore->mLock);
+	decltype(pStore->mCaches)::iterator it = pStore->mCaches.find(threadId);
+	if (it != pStore->mCaches.end())
+		return it->second;
+
+	DECLARE_ZERO(VkPipelineCacheCreateInfo, add_info);
+	add_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	add_info.pNext = NULL;
+	add_info.flags = 0;
+	add_info.initialDataSize = pStore->mInitialData.size();
+	add_info.pInitialData = pStore->mInitialData.data();
+
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	VkResult        vk_res = vkCreatePipelineCache(pRenderer->pVkDevice, &add_info, NULL, &cache);
+	if (VK_SUCCESS != vk_res && add_info.initialDataSize)
+	{
+		// The driver rejected the saved data, start this thread from an empty cache
+		add_info.initialDataSize = 0;
+		add_info.pInitialData = NULL;
+		vk_res = vkCreatePipelineCache(pRenderer->pVkDevice, &add_info, NULL, &cache);
+	}
+	if (VK_SUCCESS != vk_res)
+		return VK_NULL_HANDLE;
+
+	pStore->mCaches.insert(eastl::make_pair(threadId, cache));
+	return cache;
+}
+
 #if defined(__cplusplus) && defined(ENABLE_RENDERER_RUNTIME_SWITCH)
 namespace vk {
 #endif
@@ -2453,6 +3481,21 @@ void initRenderer(const char* app_name, const RendererDesc* settings, Renderer**
 		createInfo.pVulkanFunctions = &vulkanFunctions;
 
 		vmaCreateAllocator(&createInfo, &pRenderer->pVmaAllocator);
+
+		add_pipeline_cache(pRenderer);
+	}
+
+	add_object_cache(MAX_CACHED_RENDER_PASSES, destroy_cached_render_pass, &gRenderPassCache);
+	add_object_cache(
+		settings->mMaxCachedFrameBuffers ? settings->mMaxCachedFrameBuffers : DEFAULT_MAX_CACHED_FRAME_BUFFERS, destroy_cached_frame_buffer,
+		&gFrameBufferCache);
+
+	if (settings->mBindless)
+	{
+		if (gBindlessSupported)
+			add_bindless_table(pRenderer, settings);
+		else
+			LOGF(LogLevel::eWARNING, "Bindless table requested but descriptor indexing with update after bind is not supported");
 	}
 
 	create_default_resources(pRenderer);
@@ -2469,19 +3512,16 @@ void removeRenderer(Renderer* pRenderer)
 
 	destroy_default_resources(pRenderer);
 
-	// Remove the renderpasses
-	for (decltype(gRenderPassMap)::value_type& t : gRenderPassMap)
-		for (RenderPassMapNode& it : t.second)
-			remove_render_pass(pRenderer, it.second);
-
-	for (decltype(gFrameBufferMap)::value_type& t : gFrameBufferMap)
-		for (FrameBufferMapNode& it : t.second)
-			remove_framebuffer(pRenderer, it.second);
+	remove_bindless_table(pRenderer);
 
-	gRenderPassMap.clear();
-	gFrameBufferMap.clear();
+	// Remove the renderpasses
+	remove_object_cache(pRenderer, gRenderPassCache);
+	remove_object_cache(pRenderer, gFrameBufferCache);
+	gRenderPassCache = NULL;
+	gFrameBufferCache = NULL;
 
 	// Destroy the Vulkan bits
+	remove_pipeline_cache(pRenderer);
 	vmaDestroyAllocator(pRenderer->pVmaAllocator);
 
 	RemoveDevice(pRenderer);
@@ -2627,6 +3667,7 @@ void addQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue)
 		*ppQueue = pQueueToCreate;
 
 		++pRenderer->mVkUsedQueueCount[nodeIndex][queueProps.queueFlags];
+		track_queue(pQueueToCreate);
 	}
 	else
 	{
@@ -2640,6 +3681,7 @@ void removeQueue(Queue* pQueue)
 	const uint32_t nodeIndex = pQueue->mQueueDesc.mNodeIndex;
 	VkQueueFlags   queueFlags = pQueue->pRenderer->mVkQueueFamilyProperties[nodeIndex][pQueue->mVkQueueFamilyIndex].queueFlags;
 	--pQueue->pRenderer->mVkUsedQueueCount[nodeIndex][queueFlags];
+	remove_bindless_queue(untrack_queue(pQueue));
 	SAFE_FREE(pQueue);
 }
 
@@ -2693,6 +3735,7 @@ void addCmd(CmdPool* pCmdPool, bool secondary, Cmd** ppCmd)
 	pCmd->pRenderer = pCmdPool->pQueue->pRenderer;
 	pCmd->pCmdPool = pCmdPool;
 	pCmd->mNodeIndex = pCmdPool->pQueue->mQueueDesc.mNodeIndex;
+	pCmd->mSecondary = secondary;
 
 	DECLARE_ZERO(VkCommandBufferAllocateInfo, alloc_info);
 	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -3213,6 +4256,8 @@ void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer)
 			vkCreateBufferView(pRenderer->pVkDevice, &viewInfo, NULL, &pBuffer->pVkStorageTexelView);
 		}
 	}
+
+	add_bindless_buffer(pRenderer, pBuffer);
 	/************************************************************************/
 	/************************************************************************/
 	pBuffer->mBufferId = tfrg_atomic32_add_relaxed(&gBufferIds, 1);
@@ -3227,6 +4272,8 @@ void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 	ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 	ASSERT(VK_NULL_HANDLE != pBuffer->pVkBuffer);
 
+	remove_bindless_buffer(pBuffer);
+
 	if (pBuffer->pVkUniformTexelView)
 	{
 		vkDestroyBufferView(pRenderer->pVkDevice, pBuffer->pVkUniformTexelView, NULL);
@@ -3502,6 +4549,8 @@ void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTextu
 	vkGetImageMemoryRequirements(pRenderer->pVkDevice, pTexture->pVkImage, &vk_mem_reqs);
 	pTexture->mTextureSize = vk_mem_reqs.size;
 
+	add_bindless_texture(pRenderer, pTexture);
+
 	*ppTexture = pTexture;
 }
 
@@ -3512,6 +4561,8 @@ void removeTexture(Renderer* pRenderer, Texture* pTexture)
 	ASSERT(VK_NULL_HANDLE != pRenderer->pVkDevice);
 	ASSERT(VK_NULL_HANDLE != pTexture->pVkImage);
 
+	remove_bindless_texture(pTexture);
+
 	if (pTexture->mOwnsImage)
 		vk_destroyTexture(pRenderer->pVmaAllocator, pTexture);
 
@@ -3657,6 +4708,8 @@ void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderT
 
 void removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
 {
+	invalidate_cached_frame_buffers(pRenderer, pRenderTarget);
+
 	::removeTexture(pRenderer, pRenderTarget->pTexture);
 
 	vkDestroyImageView(pRenderer->pVkDevice, pRenderTarget->pVkDescriptors[0], NULL);
@@ -3765,6 +4818,7 @@ void addDescriptorBinder(Renderer* pRenderer, uint32_t gpuIndex, uint32_t descCo
 	DescriptorBinder* pDescriptorBinder = (DescriptorBinder*)conf_calloc(1, sizeof(DescriptorBinder));
 	
 	pDescriptorBinder->mRootSignatureNodes = *conf_placement_new<DescriptorBinderMap>(&pDescriptorBinder->mRootSignatureNodes);
+	conf_placement_new<eastl::vector<DescriptorStoreHeap*> >(&pDescriptorBinder->mOverflowPools);
 
 	// Allocate all unique root signatures in the map
 	for (uint32_t i = 0; i < descCount; i++)
@@ -3849,19 +4903,33 @@ void addDescriptorBinder(Renderer* pRenderer, uint32_t gpuIndex, uint32_t descCo
 	{
 		const RootSignature* rootSignature = it.first;
 		DescriptorBinderNode* node = it.second;
+		const uint32_t perDrawUsage = node->mMaxUsagePerSet[DESCRIPTOR_UPDATE_FREQ_PER_DRAW];
 		for (uint32_t frameIdx = 0; frameIdx < MAX_FRAMES_IN_FLIGHT; frameIdx++)
 		{
-			for (uint32_t setIndex = 0; setIndex < setCount; setIndex++)
+			node->pPerDrawDescriptorSets[frameIdx] = (VkDescriptorSet*)conf_calloc(perDrawUsage, sizeof(VkDescriptorSet));
+
+			for (uint32_t usageIdx = 0; usageIdx < perDrawUsage; usageIdx++)
 			{
-				node->pDescriptorSets_FrameFreqUsage[frameIdx][setIndex] = (VkDescriptorSet*)conf_calloc(node->mMaxUsagePerSet[setIndex], sizeof(VkDescriptorSet));
-			
-				uint32_t usageCountThisSet = node->mMaxUsagePerSet[setIndex];
+				VkDescriptorSet* pSets[] = { &node->pPerDrawDescriptorSets[frameIdx][usageIdx] };
+				consume_descriptor_sets_lock_free(pRenderer, &rootSignature->mVkDescriptorSetLayouts[DESCRIPTOR_UPDATE_FREQ_PER_DRAW], pSets, 1, pDescriptorBinder->pDescriptorPool);
+			}
+		}
 
-				for (uint32_t usageIdx = 0; usageIdx < usageCountThisSet; usageIdx++)
-				{
-					VkDescriptorSet* pSets[] = { &node->pDescriptorSets_FrameFreqUsage[frameIdx][setIndex][usageIdx] };
-					consume_descriptor_sets_lock_free(pRenderer, &rootSignature->mVkDescriptorSetLayouts[setIndex], pSets, 1, pDescriptorBinder->pDescriptorPool);
-				}
+		// The cache gets the sets the per frame copies used to take, MAX_FRAMES_IN_FLIGHT times the updates allowed per frame
+		for (uint32_t setIndex = 0; setIndex < setCount; setIndex++)
+		{
+			DescriptorSetCache* pCache = &node->mSetCaches[setIndex];
+			pCache->mHead = INVALID_CACHE_ENTRY;
+			pCache->mTail = INVALID_CACHE_ENTRY;
+			if (setIndex == DESCRIPTOR_UPDATE_FREQ_PER_DRAW)
+				continue;
+
+			pCache->mCapacity = node->mMaxUsagePerSet[setIndex] * MAX_FRAMES_IN_FLIGHT;
+			pCache->pEntries = (DescriptorSetCacheEntry*)conf_calloc(pCache->mCapacity, sizeof(DescriptorSetCacheEntry));
+			for (uint32_t entryIdx = 0; entryIdx < pCache->mCapacity; entryIdx++)
+			{
+				VkDescriptorSet* pSets[] = { &pCache->pEntries[entryIdx].pDescriptorSet };
+				consume_descriptor_sets_lock_free(pRenderer, &rootSignature->mVkDescriptorSetLayouts[setIndex], pSets, 1, pDescriptorBinder->pDescriptorPool);
 			}
 		}
 	}
@@ -3993,10 +5061,27 @@ void addDescriptorBinder(Renderer* pRenderer, uint32_t gpuIndex, uint32_t descCo
 	*ppDescriptorBinder = pDescriptorBinder;
 }
 
+void getDescriptorBinderStats(DescriptorBinder* pDescriptorBinder, DescriptorBinderStats* pStats)
+{
+	ASSERT(pDescriptorBinder);
+	ASSERT(pStats);
+
+	pStats->mHits = pDescriptorBinder->mCacheHits;
+	pStats->mMisses = pDescriptorBinder->mCacheMisses;
+	pStats->mEvictions = pDescriptorBinder->mCacheEvictions;
+	pStats->mCachedSetCount = 0;
+	for (DescriptorBinderMapNode& it : pDescriptorBinder->mRootSignatureNodes)
+		for (uint32_t setIndex = 0; setIndex < DESCRIPTOR_UPDATE_FREQ_COUNT; ++setIndex)
+			pStats->mCachedSetCount += it.second->mSetCaches[setIndex].mCount;
+}
+
 void removeDescriptorBinder(Renderer* pRenderer, DescriptorBinder* pDescriptorBinder)
 {
 	reset_descriptor_heap(pRenderer, pDescriptorBinder->pDescriptorPool);
 	remove_descriptor_heap(pRenderer, pDescriptorBinder->pDescriptorPool);
+	for (uint32_t i = 0; i < (uint32_t)pDescriptorBinder->mOverflowPools.size(); ++i)
+		remove_descriptor_heap(pRenderer, pDescriptorBinder->mOverflowPools[i]);
+	pDescriptorBinder->mOverflowPools.~vector();
 
 	for (DescriptorBinderMapNode& it : pDescriptorBinder->mRootSignatureNodes)
 	{
@@ -4012,15 +5097,13 @@ void removeDescriptorBinder(Renderer* pRenderer, DescriptorBinder* pDescriptorBi
 				vkDestroyDescriptorUpdateTemplateKHR(pRenderer->pVkDevice, node->mUpdateTemplates[setIndex], NULL);
 		}
 
-		for (uint32_t frameIdx = 0; frameIdx < MAX_FRAMES_IN_FLIGHT; frameIdx++)
+		for (uint32_t setIndex = 0; setIndex < DESCRIPTOR_UPDATE_FREQ_COUNT; setIndex++)
 		{
-			for (uint32_t setIndex = 0; setIndex < DESCRIPTOR_UPDATE_FREQ_COUNT; setIndex++)
-			{
-				node->mUpdatedHashes[frameIdx][setIndex].~hash_map();
-				node->mUpdatedDynamicUniformHashes[frameIdx][setIndex].~hash_map();
-				SAFE_FREE(node->pDescriptorSets_FrameFreqUsage[frameIdx][setIndex]);
-			}
-		}			
+			node->mSetCaches[setIndex].mEntryIndices.~hash_map();
+			SAFE_FREE(node->mSetCaches[setIndex].pEntries);
+		}
+		for (uint32_t frameIdx = 0; frameIdx < MAX_FRAMES_IN_FLIGHT; frameIdx++)
+			SAFE_FREE(node->pPerDrawDescriptorSets[frameIdx]);
 		SAFE_FREE(node);
 	}
 
@@ -4032,7 +5115,7 @@ void removeDescriptorBinder(Renderer* pRenderer, DescriptorBinder* pDescriptorBi
 // Shader Functions
 /************************************************************************/
 // renderer shader macros allocated on stack
-ShaderMacro                     gRendererShaderDefines[2];
+ShaderMacro                     gRendererShaderDefines[3];
 const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRenderer)
 {
 	// Set shader macro based on runtime information
@@ -4042,7 +5125,10 @@ const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRenderer)
 	gRendererShaderDefines[1].definition = "VK_FEATURE_TEXTURE_ARRAY_DYNAMIC_INDEXING_ENABLED";
 	gRendererShaderDefines[1].value = eastl::string().sprintf("%d", static_cast<int>(pRenderer->mVkGpuFeatures[0].shaderSampledImageArrayDynamicIndexing));
 
-	RendererShaderDefinesDesc defineDesc = { gRendererShaderDefines, 2 };
+	gRendererShaderDefines[2].definition = "VK_BINDLESS_ENABLED";
+	gRendererShaderDefines[2].value = eastl::string().sprintf("%d", static_cast<int>(gBindlessTable != NULL));
+
+	RendererShaderDefinesDesc defineDesc = { gRendererShaderDefines, 3 };
 	return defineDesc;
 }
 
@@ -4275,6 +5361,21 @@ void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatu
 			if (pRes->type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
 				setIndex = 0;
 
+			// The bindless arrays are not part of the root signature, the pipeline layout references the global table
+			if (setIndex == BINDLESS_DESCRIPTOR_SET)
+			{
+				if (!gBindlessTable)
+				{
+					ErrorMsg(
+						"\nFailed to create root signature\n"
+						"Shader resource %s uses the bindless set but the renderer was created without RendererDesc::mBindless",
+						pRes->name);
+					return;
+				}
+				pRootSignature->mVkBindless = true;
+				continue;
+			}
+
 			eastl::string_hash_map<uint32_t>::iterator it =
 				pRootSignature->pDescriptorNameToIndexMap.find(pRes->name);
 			if (it == pRootSignature->pDescriptorNameToIndexMap.end())
@@ -4492,11 +5593,26 @@ void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSignatu
 	/************************************************************************/
 	// Pipeline layout
 	/************************************************************************/
+	// The bindless set comes after all update frequencies, the sets in front of it need (empty) layouts
+	if (pRootSignature->mVkBindless)
+	{
+		for (uint32_t i = 0; i < DESCRIPTOR_UPDATE_FREQ_COUNT; ++i)
+		{
+			if (VK_NULL_HANDLE == pRootSignature->mVkDescriptorSetLayouts[i])
+			{
+				VkDescriptorSetLayoutCreateInfo layoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+				vkCreateDescriptorSetLayout(pRenderer->pVkDevice, &layoutInfo, NULL, &pRootSignature->mVkDescriptorSetLayouts[i]);
+			}
+		}
+	}
+
 	eastl::vector<VkDescriptorSetLayout> descriptorSetLayouts;
 	eastl::vector<VkPushConstantRange>   pushConstants(pRootSignature->mVkPushConstantCount);
 	for (uint32_t i = 0; i < DESCRIPTOR_UPDATE_FREQ_COUNT; ++i)
 		if (pRootSignature->mVkDescriptorSetLayouts[i])
 			descriptorSetLayouts.emplace_back(pRootSignature->mVkDescriptorSetLayouts[i]);
+	if (pRootSignature->mVkBindless)
+		descriptorSetLayouts.emplace_back(gBindlessTable->pLayout);
 	for (uint32_t i = 0; i < pRootSignature->mVkPushConstantCount; ++i)
 		pushConstants[i] = pRootSignature->pVkPushConstantRanges[i];
 
@@ -4541,6 +5657,13 @@ void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
 	SAFE_FREE(pRootSignature);
 }
 
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+	uint32_t index = UINT32_MAX;
+	get_descriptor(pRootSignature, pName, &index);
+	return index;
+}
+
 #ifdef FORGE_JHABLE_EDITS_V01
 static bool convertVertInputToSemantic(int& semanticType, int& semanticIndex, const char attrName[], int attrLen)
 {
@@ -5001,7 +6124,7 @@ void addGraphicsPipelineImpl(Renderer* pRenderer, const GraphicsPipelineDesc* pD
 		add_info.subpass = 0;
 		add_info.basePipelineHandle = VK_NULL_HANDLE;
 		add_info.basePipelineIndex = -1;
-		VkResult vk_res = vkCreateGraphicsPipelines(pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &add_info, NULL, &(pPipeline->pVkPipeline));
+		VkResult vk_res = vkCreateGraphicsPipelines(pRenderer->pVkDevice, get_vk_pipeline_cache(pRenderer), 1, &add_info, NULL, &(pPipeline->pVkPipeline));
 		ASSERT(VK_SUCCESS == vk_res);
 
 		remove_render_pass(pRenderer, pRenderPass);
@@ -5051,7 +6174,7 @@ void addComputePipelineImpl(Renderer* pRenderer, const ComputePipelineDesc* pDes
 		create_info.layout = pDesc->pRootSignature->pPipelineLayout;
 		create_info.basePipelineHandle = 0;
 		create_info.basePipelineIndex = 0;
-		VkResult vk_res = vkCreateComputePipelines(pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &create_info, NULL, &(pPipeline->pVkPipeline));
+		VkResult vk_res = vkCreateComputePipelines(pRenderer->pVkDevice, get_vk_pipeline_cache(pRenderer), 1, &create_info, NULL, &(pPipeline->pVkPipeline));
 		ASSERT(VK_SUCCESS == vk_res);
 	}
 
@@ -5249,6 +6372,12 @@ void beginCmd(Cmd* pCmd)
 	begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 	begin_info.pInheritanceInfo = NULL;
 
+	// Secondary command buffers always need inheritance info, here without a render pass
+	DECLARE_ZERO(VkCommandBufferInheritanceInfo, inheritance_info);
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	if (pCmd->mSecondary)
+		begin_info.pInheritanceInfo = &inheritance_info;
+
 	VkDeviceGroupCommandBufferBeginInfoKHR deviceGroupBeginInfo = { VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO_KHR };
 	deviceGroupBeginInfo.pNext = NULL;
 	if (pCmd->pRenderer->mSettings.mGpuMode == GPU_MODE_LINKED)
@@ -5265,6 +6394,60 @@ void beginCmd(Cmd* pCmd)
 	pCmd->pBoundDescriptorBinderNode = NULL;
 }
 
+void beginSecondaryCmd(Cmd* pCmd, Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+	ASSERT(pCmd->mSecondary && !pPrimaryCmd->mSecondary);
+	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+	ASSERT(VK_NULL_HANDLE != pPrimaryCmd->pVkActiveRenderPass && "No render pass bound on the primary command buffer");
+
+	vkResetCommandBuffer(pCmd->pVkCmdBuf, 0);
+
+	DECLARE_ZERO(VkCommandBufferInheritanceInfo, inheritance_info);
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.pNext = NULL;
+	inheritance_info.renderPass = pPrimaryCmd->pVkActiveRenderPass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = pPrimaryCmd->pVkActiveFrameBuffer;
+
+	DECLARE_ZERO(VkCommandBufferBeginInfo, begin_info);
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.pNext = NULL;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	begin_info.pInheritanceInfo = &inheritance_info;
+
+	VkDeviceGroupCommandBufferBeginInfoKHR deviceGroupBeginInfo = { VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO_KHR };
+	deviceGroupBeginInfo.pNext = NULL;
+	if (pCmd->pRenderer->mSettings.mGpuMode == GPU_MODE_LINKED)
+	{
+		deviceGroupBeginInfo.deviceMask = (1 << pCmd->mNodeIndex);
+		begin_info.pNext = &deviceGroupBeginInfo;
+	}
+
+	VkResult vk_res = vkBeginCommandBuffer(pCmd->pVkCmdBuf, &begin_info);
+	ASSERT(VK_SUCCESS == vk_res);
+
+	// Pipelines are created against the bound render target formats, take them over from the primary
+	if (pCmd->pBoundColorFormats)
+	{
+		memcpy(pCmd->pBoundColorFormats, pPrimaryCmd->pBoundColorFormats, sizeof(uint32_t) * MAX_RENDER_TARGET_ATTACHMENTS);
+		memcpy(pCmd->pBoundSrgbValues, pPrimaryCmd->pBoundSrgbValues, sizeof(bool) * MAX_RENDER_TARGET_ATTACHMENTS);
+	}
+	pCmd->mBoundDepthStencilFormat = pPrimaryCmd->mBoundDepthStencilFormat;
+	pCmd->mBoundRenderTargetCount = pPrimaryCmd->mBoundRenderTargetCount;
+	pCmd->mBoundSampleCount = pPrimaryCmd->mBoundSampleCount;
+	pCmd->mBoundSampleQuality = pPrimaryCmd->mBoundSampleQuality;
+	pCmd->mBoundWidth = pPrimaryCmd->mBoundWidth;
+	pCmd->mBoundHeight = pPrimaryCmd->mBoundHeight;
+	pCmd->mRenderPassHash = pPrimaryCmd->mRenderPassHash;
+	// The render pass belongs to the primary, endCmd must not end it here
+	pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
+
+	pCmd->pBoundDescriptorBinder = NULL;
+	pCmd->pBoundDescriptorBinderNode = NULL;
+}
+
 void endCmd(Cmd* pCmd)
 {
 	ASSERT(pCmd);
@@ -5276,6 +6459,7 @@ void endCmd(Cmd* pCmd)
 	}
 
 	pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
+	pCmd->pVkActiveFrameBuffer = VK_NULL_HANDLE;
 	pCmd->mBoundDepthStencilFormat = ImageFormat::NONE;
 	pCmd->mBoundRenderTargetCount = 0;
 
@@ -5292,11 +6476,13 @@ void cmdBindRenderTargets(
 {
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+	ASSERT(!pCmd->mSecondary && "Secondary command buffers inherit the render targets of the primary");
 
 	if (pCmd->pVkActiveRenderPass)
 	{
 		vkCmdEndRenderPass(pCmd->pVkCmdBuf);
 		pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
+		pCmd->pVkActiveFrameBuffer = VK_NULL_HANDLE;
 		pCmd->mBoundDepthStencilFormat = ImageFormat::NONE;
 		pCmd->mBoundRenderTargetCount = 0;
 	}
@@ -5355,22 +6541,8 @@ void cmdBindRenderTargets(
 	pCmd->mBoundRenderTargetCount = renderTargetCount;
 	pCmd->mRenderPassHash = renderPassHash;
 
-	RenderPassMap&  renderPassMap = get_render_pass_map();
-	FrameBufferMap& frameBufferMap = get_frame_buffer_map();
-
-	const RenderPassMapIt  pNode = renderPassMap.find(renderPassHash);
-	const FrameBufferMapIt pFrameBufferNode = frameBufferMap.find(frameBufferHash);
-
-	RenderPass*  pRenderPass = NULL;
-	FrameBuffer* pFrameBuffer = NULL;
-
 	// If a render pass of this combination already exists just use it or create a new one
-	if (pNode != renderPassMap.end())
-	{
-		pRenderPass = pNode->second;
-	}
-	else
-	{
+	RenderPass* pRenderPass = get_cached_object<RenderPass>(pCmd->pRenderer, gRenderPassCache, renderPassHash, [&]() {
 		ImageFormat::Enum colorFormats[MAX_RENDER_TARGET_ATTACHMENTS] = {};
 		bool              srgbValues[MAX_RENDER_TARGET_ATTACHMENTS] = {};
 		ImageFormat::Enum depthStencilFormat = ImageFormat::NONE;
@@ -5393,19 +6565,13 @@ void cmdBindRenderTargets(
 		renderPassDesc.pLoadActionsColor = pLoadActions ? pLoadActions->mLoadActionsColor : NULL;
 		renderPassDesc.mLoadActionDepth = pLoadActions ? pLoadActions->mLoadActionDepth : LOAD_ACTION_DONTCARE;
 		renderPassDesc.mLoadActionStencil = pLoadActions ? pLoadActions->mLoadActionStencil : LOAD_ACTION_DONTCARE;
-		add_render_pass(pCmd->pRenderer, &renderPassDesc, &pRenderPass);
-
-		// No need of a lock here since this map is per thread
-		renderPassMap.insert({{ renderPassHash, pRenderPass }});
-	}
+		RenderPass* pNewRenderPass = NULL;
+		add_render_pass(pCmd->pRenderer, &renderPassDesc, &pNewRenderPass);
+		return pNewRenderPass;
+	});
 
 	// If a frame buffer of this combination already exists just use it or create a new one
-	if (pFrameBufferNode != frameBufferMap.end())
-	{
-		pFrameBuffer = pFrameBufferNode->second;
-	}
-	else
-	{
+	FrameBuffer* pFrameBuffer = get_cached_object<FrameBuffer>(pCmd->pRenderer, gFrameBufferCache, frameBufferHash, [&]() {
 		FrameBufferDesc desc = { 0 };
 		desc.mRenderTargetCount = renderTargetCount;
 		desc.pDepthStencil = pDepthStencil;
@@ -5415,11 +6581,10 @@ void cmdBindRenderTargets(
 		desc.pColorMipSlices = pColorMipSlices;
 		desc.mDepthArraySlice = depthArraySlice;
 		desc.mDepthMipSlice = depthMipSlice;
-		add_framebuffer(pCmd->pRenderer, &desc, &pFrameBuffer);
-
-		// No need of a lock here since this map is per thread
-		frameBufferMap.insert({{ frameBufferHash, pFrameBuffer }});
-	}
+		FrameBuffer* pNewFrameBuffer = NULL;
+		add_framebuffer(pCmd->pRenderer, &desc, &pNewFrameBuffer);
+		return pNewFrameBuffer;
+	});
 
 	DECLARE_ZERO(VkRect2D, render_area);
 	render_area.offset.x = 0;
@@ -5455,8 +6620,30 @@ void cmdBindRenderTargets(
 	begin_info.clearValueCount = clearValueCount;
 	begin_info.pClearValues = clearValues;
 
-	vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+	const VkSubpassContents contents =
+		(pLoadActions && pLoadActions->mSecondaryCmds) ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+	vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &begin_info, contents);
 	pCmd->pVkActiveRenderPass = pRenderPass->pRenderPass;
+	pCmd->pVkActiveFrameBuffer = pFrameBuffer->pFramebuffer;
+}
+
+void cmdExecuteSecondaryCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppSecondaryCmds)
+{
+	ASSERT(pCmd);
+	ASSERT(VK_NULL_HANDLE != pCmd->pVkCmdBuf);
+	ASSERT(!pCmd->mSecondary);
+
+	if (!cmdCount)
+		return;
+
+	VkCommandBuffer* pCmdBufs = (VkCommandBuffer*)alloca(cmdCount * sizeof(VkCommandBuffer));
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		ASSERT(ppSecondaryCmds[i]->mSecondary);
+		pCmdBufs[i] = ppSecondaryCmds[i]->pVkCmdBuf;
+	}
+
+	vkCmdExecuteCommands(pCmd->pVkCmdBuf, cmdCount, pCmdBufs);
 }
 
 void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth)
@@ -5495,6 +6682,20 @@ void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
 
 	VkPipelineBindPoint pipeline_bind_point = gPipelineBindPoint[pPipeline->mType];
 	vkCmdBindPipeline(pCmd->pVkCmdBuf, pipeline_bind_point, pPipeline->pVkPipeline);
+
+	const RootSignature* pRootSignature = NULL;
+	if (pPipeline->mType == PIPELINE_TYPE_GRAPHICS)
+		pRootSignature = pPipeline->mGraphics.pRootSignature;
+	else if (pPipeline->mType == PIPELINE_TYPE_COMPUTE)
+		pRootSignature = pPipeline->mCompute.pRootSignature;
+
+	// Sets bound by cmdBindDescriptors use the same layout, so they do not disturb the bindless set
+	if (pRootSignature && pRootSignature->mVkBindless)
+	{
+		vkCmdBindDescriptorSets(
+			pCmd->pVkCmdBuf, pipeline_bind_point, pRootSignature->pPipelineLayout, BINDLESS_DESCRIPTOR_SET, 1, &gBindlessTable->pSet, 0,
+			NULL);
+	}
 }
 
 void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset)
@@ -5573,6 +6774,19 @@ void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t
 	vkCmdDispatch(pCmd->pVkCmdBuf, groupCountX, groupCountY, groupCountZ);
 }
 
+void cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, uint32_t paramIndex, const void* pConstants)
+{
+	ASSERT(pCmd);
+	ASSERT(pRootSignature);
+	ASSERT(pConstants);
+	ASSERT(paramIndex < pRootSignature->mDescriptorCount);
+
+	const DescriptorInfo* pDesc = &pRootSignature->pDescriptors[paramIndex];
+	ASSERT(pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT);
+
+	vkCmdPushConstants(pCmd->pVkCmdBuf, pRootSignature->pPipelineLayout, pDesc->mVkStages, 0, pDesc->mDesc.size, pConstants);
+}
+
 void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSignature* pRootSignature, uint32_t numDescriptors, DescriptorData* pDescParams)
 {
 	ASSERT(pDescriptorBinder);
@@ -5581,9 +6795,18 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 	Renderer*             pRenderer = pCmd->pRenderer;
 	const uint32_t        setCount = DESCRIPTOR_UPDATE_FREQ_COUNT;
 	const uint32_t        frameIdx = pRenderer->mCurrentFrameIdx;
-	DescriptorBinderNode* node = pDescriptorBinder->mRootSignatureNodes.find(pRootSignature)->second;
+	const uint64_t        cacheFrame = tfrg_atomic64_load_relaxed(&gCacheFrameIndex);
 	const VkDeviceSize    maxUniformRange = (VkDeviceSize)pRenderer->pVkActiveGPUProperties->properties.limits.maxUniformBufferRange;
 
+	if (pDescriptorBinder->pLastRootSignature != pRootSignature)
+	{
+		DescriptorBinderMap::const_iterator it = pDescriptorBinder->mRootSignatureNodes.find(pRootSignature);
+		ASSERT(it != pDescriptorBinder->mRootSignatureNodes.end() && "Root signature was not specified in addDescriptorBinder");
+		pDescriptorBinder->pLastRootSignature = pRootSignature;
+		pDescriptorBinder->pLastNode = it->second;
+	}
+	DescriptorBinderNode* node = pDescriptorBinder->pLastNode;
+
 #ifdef ENABLE_RAYTRACING
 	VkWriteDescriptorSet* raytracingWrites[setCount] = {};
 	VkWriteDescriptorSetAccelerationStructureNV* raytracingWritesNV[setCount] = {};
@@ -5606,16 +6829,8 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 
 	if (node->mFrameIdx != frameIdx)
 	{
-		// Frame changed: reuse descriptors from the beginning since all allocations are per frame
-		for (uint32_t setIndex = 0; setIndex < setCount; ++setIndex)
-		{
-			node->mUpdateCount[frameIdx][setIndex] = 0;
-			if (setIndex != DESCRIPTOR_UPDATE_FREQ_NONE)
-			{
-				node->mUpdatedHashes[frameIdx][setIndex].clear();
-				node->mUpdatedDynamicUniformHashes[frameIdx][setIndex].clear();
-			}
-		}
+		// Frame changed: the per draw sets of this frame index are free again
+		node->mPerDrawUpdateCount[frameIdx] = 0;
 		node->mFrameIdx = frameIdx;
 	}
 
@@ -5649,13 +6864,8 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 	{
 		const DescriptorData* pParam = &pDescParams[i];
 		ASSERT(pParam);
-		if (!pParam->pName)
-		{
-			LOGF(LogLevel::eERROR, "Name of Descriptor at index (%u) is NULL", i);
-			return;
-		}
 
-		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam->pName);
+		const DescriptorInfo* pDesc = get_descriptor(pRootSignature, pParam, i);
 		if (!pDesc)
 			continue;
 
@@ -5663,6 +6873,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 		// This is also the set index to be used in vkCmdBindDescriptorSets
 		const DescriptorUpdateFrequency setIndex = pDesc->mUpdateFrquency;
 		const uint32_t                  arrayCount = max(1U, pParam->mCount);
+		const uint32_t                  descriptorIndex = (uint32_t)(pDesc - pRootSignature->pDescriptors);
 
 		// If input param is a root constant no need to do any further checks
 		if (pDesc->mDesc.type == DESCRIPTOR_TYPE_ROOT_CONSTANT)
@@ -5680,22 +6891,22 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 				LOGF(LogLevel::eERROR, 
 					"Trying to bind a static sampler (%s). All static samplers must be bound in addRootSignature through "
 					"RootSignatureDesc::mStaticSamplers",
-					pParam->pName);
+					pDesc->mDesc.name);
 				continue;
 			}
 			if (!pParam->ppSamplers)
 			{
-				LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Sampler descriptor (%s) is NULL", pDesc->mDesc.name);
 				return;
 			}
 			for (uint32_t i = 0; i < arrayCount; ++i)
 			{
 				if (!pParam->ppSamplers[i])
 				{
-					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					LOGF(LogLevel::eERROR, "Sampler descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, i);
 					return;
 				}
-				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppSamplers[i]->mSamplerId, 1, pHash[setIndex]);
+				pHash[setIndex] = hash_descriptor_resource(pHash[setIndex], descriptorIndex, i, pParam->ppSamplers[i]->mSamplerId);
 				node->pUpdateData[setIndex][pDesc->mHandleIndex + i].mImageInfo = pParam->ppSamplers[i]->mVkSamplerView;
 			}
 		}
@@ -5703,7 +6914,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 		{
 			if (!pParam->ppTextures)
 			{
-				LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 				return;
 			}
 
@@ -5711,11 +6922,11 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			{
 				if (!pParam->ppTextures[i])
 				{
-					LOGF(LogLevel::eERROR, "Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					LOGF(LogLevel::eERROR, "Texture descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, i);
 					return;
 				}
 
-				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppTextures[i]->mTextureId, 1, pHash[setIndex]);
+				pHash[setIndex] = hash_descriptor_resource(pHash[setIndex], descriptorIndex, i, pParam->ppTextures[i]->mTextureId);
 				uint64_t bindStencilResource = (uint64_t)pParam->mBindStencilResource;	// Needed to meet alignment requirements
 				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&bindStencilResource, 1, pHash[setIndex]);
 
@@ -5732,7 +6943,7 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 		{
 			if (!pParam->ppTextures)
 			{
-				LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) is NULL", pDesc->mDesc.name);
 				return;
 			}
 
@@ -5743,11 +6954,11 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 			{
 				if (!pParam->ppTextures[i])
 				{
-					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					LOGF(LogLevel::eERROR, "RW Texture descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, i);
 					return;
 				}
 
-				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppTextures[i]->mTextureId, 1, pHash[setIndex]);
+				pHash[setIndex] = hash_descriptor_resource(pHash[setIndex], descriptorIndex, i, pParam->ppTextures[i]->mTextureId);
 
 				// Store the new descriptor so we can use it in vkUpdateDescriptorSet later
 				node->pUpdateData[setIndex][pDesc->mHandleIndex + i].mImageInfo.imageView =
@@ -5760,17 +6971,17 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 		{
 			if (!pParam->ppBuffers)
 			{
-				LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 				return;
 			}
 			for (uint32_t i = 0; i < arrayCount; ++i)
 			{
 				if (!pParam->ppBuffers[i])
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, i);
 					return;
 				}
-				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppBuffers[i]->mBufferId, 1, pHash[setIndex]);
+				pHash[setIndex] = hash_descriptor_resource(pHash[setIndex], descriptorIndex, i, pParam->ppBuffers[i]->mBufferId);
 
 				// Store the new descriptor so we can use it in vkUpdateDescriptorSet later
 				node->pUpdateData[setIndex][pDesc->mHandleIndex + i].mBufferInfo = pParam->ppBuffers[i]->mVkBufferInfo;
@@ -5789,7 +7000,8 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 					node->pDynamicOffsets[setIndex][pDesc->mDynamicUniformIndex] = offset;
 					node->pUpdateData[setIndex][pDesc->mHandleIndex].mBufferInfo.range = pParam->pSizes[i];
 
-					pDynamicUniformHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppBuffers[i]->mBufferId, 1, pDynamicUniformHash[setIndex]);
+					pDynamicUniformHash[setIndex] =
+						hash_descriptor_resource(pDynamicUniformHash[setIndex], descriptorIndex, i, pParam->ppBuffers[i]->mBufferId);
 					pDynamicUniformHash[setIndex] = eastl::mem_hash<uint64_t>()(pParam->pSizes, arrayCount, pDynamicUniformHash[setIndex]);
 				}
 				// If descriptor is not of type uniform buffer dynamic, hash the offset value
@@ -5841,17 +7053,17 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 
 			if (!pParam->ppBuffers)
 			{
-				LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pParam->pName);
+				LOGF(LogLevel::eERROR, "Buffer descriptor (%s) is NULL", pDesc->mDesc.name);
 				return;
 			}
 			for (uint32_t i = 0; i < arrayCount; ++i)
 			{
 				if (!pParam->ppBuffers[i])
 				{
-					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pParam->pName, i);
+					LOGF(LogLevel::eERROR, "Buffer descriptor (%s) at array index (%u) is NULL", pDesc->mDesc.name, i);
 					return;
 				}
-				pHash[setIndex] = eastl::mem_hash<uint64_t>()(&pParam->ppBuffers[i]->mBufferId, 1, pHash[setIndex]);
+				pHash[setIndex] = hash_descriptor_resource(pHash[setIndex], descriptorIndex, i, pParam->ppBuffers[i]->mBufferId);
 
 				if (pDesc->mVkType == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER)
 					node->pUpdateData[setIndex][pDesc->mHandleIndex + i].mBuferView = pParam->ppBuffers[i]->pVkUniformTexelView;
@@ -5873,51 +7085,50 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 
 		if (descCount && !node->mBoundSets[setIndex])
 		{
-			const uint64_t setIndexHash = pHash[setIndex];
 			VkDescriptorSet pDescriptorSet = VK_NULL_HANDLE;
-			uint32_t descriptorSetSlotToUse = 0;
+			bool            mustUpdateDescriptorSet = true;
 
-			// Determine if we have to update the descriptor set depending on the hashed states. Frequencies BATCH and DRAW are considered dynamic (multiple updates per frame). 
-			// DRAW and are always updated to a new (pre-allocated) slot every time they are bound. This allows to avoid a dictionary lookup for them. 
-			// BATCH use a dictionary lookup to reuse descriptors that are already updated. This avoids updating them every time.
-			// Frequencies NONE and FRAME only allow 1 update per frame by definition. They allow for 1 update per frame each.
-			bool mustUpdateDescriptorSet = (setIndex == DESCRIPTOR_UPDATE_FREQ_PER_DRAW);
-
-			if (setIndex != DESCRIPTOR_UPDATE_FREQ_PER_DRAW)
+			// DRAW sets are always updated to a new (pre-allocated) slot every time they are bound. This avoids a lookup for them.
+			// All other frequencies look their contents up in the persistent cache and only update a set on a miss.
+			if (setIndex == DESCRIPTOR_UPDATE_FREQ_PER_DRAW)
 			{
-				HashMap& activeSet = node->mUpdatedHashes[frameIdx][setIndex];
-				ConstHashMapIterator it = activeSet.find(setIndexHash);
-				if (it != activeSet.end())
+				const uint32_t descriptorSetSlotToUse = node->mPerDrawUpdateCount[frameIdx]++;
+				if (descriptorSetSlotToUse >= node->mMaxUsagePerSet[setIndex])
 				{
-					descriptorSetSlotToUse = it->second;
-					mustUpdateDescriptorSet = false;
+					LOGF(LogLevel::eERROR, "Trying to update more descriptors than allocated for set (%d)", setIndex); ASSERT(0);
+					return;
 				}
-				// Check if this is just to update the dynamic offset of a dynamic uniform buffer descriptor (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
-				// If true, we dont need to call update descriptor set with the new offsets as the offsets are passed directly to bind descriptor set
-				else if (rootDescCount && pDynamicUniformHash[setIndex])
+				pDescriptorSet = node->pPerDrawDescriptorSets[frameIdx][descriptorSetSlotToUse];
+			}
+			else
+			{
+				// Offsets of dynamic uniform buffers are passed to vkCmdBindDescriptorSets, only their buffers and sizes are part of the key
+				const uint64_t      key = eastl::mem_hash<uint64_t>()(&pDynamicUniformHash[setIndex], 1, pHash[setIndex]);
+				DescriptorSetCache* pCache = &node->mSetCaches[setIndex];
+				uint32_t            entry = find_cached_descriptor_set(pCache, key, cacheFrame);
+				if (entry != INVALID_CACHE_ENTRY)
 				{
-					HashMap& activeSet = node->mUpdatedDynamicUniformHashes[frameIdx][setIndex];
-					ConstHashMapIterator it = activeSet.find(pDynamicUniformHash[setIndex]);
-					mustUpdateDescriptorSet = it == activeSet.end();
-					if (!mustUpdateDescriptorSet)
-						descriptorSetSlotToUse = it->second;
+					++pDescriptorBinder->mCacheHits;
+					mustUpdateDescriptorSet = false;
 				}
 				else
 				{
-					mustUpdateDescriptorSet = true;
+					bool evicted = false;
+					entry = add_cached_descriptor_set(pCache, key, cacheFrame, &evicted);
+					if (entry == INVALID_CACHE_ENTRY)
+					{
+						grow_descriptor_set_cache(pRenderer, pDescriptorBinder, pRootSignature, setIndex, pCache);
+						entry = add_cached_descriptor_set(pCache, key, cacheFrame, &evicted);
+					}
+					++pDescriptorBinder->mCacheMisses;
+					if (evicted)
+						++pDescriptorBinder->mCacheEvictions;
 				}
+				pDescriptorSet = pCache->pEntries[entry].pDescriptorSet;
 			}
 
 			if (mustUpdateDescriptorSet)
 			{
-				descriptorSetSlotToUse = node->mUpdateCount[frameIdx][setIndex]++;
-				if (descriptorSetSlotToUse >= node->mMaxUsagePerSet[setIndex])
-				{
-					LOGF(LogLevel::eERROR, "Trying to update more descriptors than allocated for set (%d)", setIndex); ASSERT(0);
-					return;
-				}
-
-				pDescriptorSet = node->pDescriptorSets_FrameFreqUsage[frameIdx][setIndex][descriptorSetSlotToUse];
 				vkUpdateDescriptorSetWithTemplateKHR(pRenderer->pVkDevice, pDescriptorSet, node->mUpdateTemplates[setIndex], node->pUpdateData[setIndex]);
 
 #ifdef ENABLE_RAYTRACING
@@ -5932,23 +7143,11 @@ void cmdBindDescriptors(Cmd* pCmd, DescriptorBinder* pDescriptorBinder, RootSign
 					vkUpdateDescriptorSets(pRenderer->pVkDevice, raytracingWriteCount[setIndex], raytracingWrites[setIndex], 0, NULL);
 				}
 #endif
-
-				if (setIndex != DESCRIPTOR_UPDATE_FREQ_PER_DRAW)
-				{
-					node->mUpdatedHashes[frameIdx][setIndex].insert({ { setIndexHash, descriptorSetSlotToUse } });
-					if (rootDescCount && pDynamicUniformHash[setIndex])
-						node->mUpdatedDynamicUniformHashes[frameIdx][setIndex].insert({ { pDynamicUniformHash[setIndex], descriptorSetSlotToUse } });
-				}
-
-				// Reset all descriptor data to default descriptors
-				memcpy(node->pUpdateData[setIndex], node->pDefaultUpdateData[setIndex], pRootSignature->mVkCumulativeDescriptorCounts[setIndex] * sizeof(DescriptorUpdateData));
-			}
-			else
-			{
-				// No need to update descriptors. Just point to a pre-allocated available descriptor set given by descriptorSetSlotToUse.
-				pDescriptorSet = node->pDescriptorSets_FrameFreqUsage[frameIdx][setIndex][descriptorSetSlotToUse];
 			}
 
+			// Reset all descriptor data to default descriptors, the contents of the next bind must match its key
+			memcpy(node->pUpdateData[setIndex], node->pDefaultUpdateData[setIndex], pRootSignature->mVkCumulativeDescriptorCounts[setIndex] * sizeof(DescriptorUpdateData));
+
 			vkCmdBindDescriptorSets(
 				pCmd->pVkCmdBuf, gPipelineBindPoint[pRootSignature->mPipelineType], pRootSignature->pPipelineLayout, setIndex, 1,
 				&pDescriptorSet, rootDescCount, node->pDynamicOffsets[setIndex]);
@@ -5972,11 +7171,17 @@ void cmdResourceBarrier(
 		numBufferBarriers ? (VkBufferMemoryBarrier*)alloca(numBufferBarriers * sizeof(VkBufferMemoryBarrier)) : NULL;
 	uint32_t bufferBarrierCount = 0;
 
+	// Only the stages touching the resources in their old / new states take part in the barrier
+	const CmdPoolType queueType = pCmd->pCmdPool->pQueue->mQueueDesc.mType;
+	ResourceState srcStates = RESOURCE_STATE_UNDEFINED;
+	ResourceState dstStates = RESOURCE_STATE_UNDEFINED;
+
 	for (uint32_t i = 0; i < numBufferBarriers; ++i)
 	{
 		BufferBarrier* pTrans = &pBufferBarriers[i];
 		Buffer*        pBuffer = pTrans->pBuffer;
-		if (!(pTrans->mNewState & pBuffer->mCurrentState))
+		// Unordered access to unordered access still has to wait for the previous writes
+		if (!(pTrans->mNewState & pBuffer->mCurrentState) || pTrans->mNewState == RESOURCE_STATE_UNORDERED_ACCESS)
 		{
 			VkBufferMemoryBarrier* pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
 			pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -5986,12 +7191,14 @@ void cmdResourceBarrier(
 			pBufferBarrier->size = VK_WHOLE_SIZE;
 			pBufferBarrier->offset = 0;
 
-			pBufferBarrier->srcAccessMask = util_to_vk_access_flags(pBuffer->mCurrentState);
-			pBufferBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState);
+			pBufferBarrier->srcAccessMask = util_to_vk_access_flags(pBuffer->mCurrentState, queueType);
+			pBufferBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState, queueType);
 
 			pBufferBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			pBufferBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
+			srcStates |= pBuffer->mCurrentState;
+			dstStates |= pTrans->mNewState;
 			pBuffer->mCurrentState = pTrans->mNewState;
 		}
 	}
@@ -5999,7 +7206,35 @@ void cmdResourceBarrier(
 	{
 		TextureBarrier* pTrans = &pTextureBarriers[i];
 		Texture*        pTexture = pTrans->pTexture;
-		if (!(pTrans->mNewState & pTexture->mCurrentState))
+		if (pTrans->mSubresourceBarrier)
+		{
+			// Single subresource, the caller tracks its state and the state of the whole texture stays untouched
+			if (pTrans->mCurrentState != pTrans->mNewState || pTrans->mNewState == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				VkImageMemoryBarrier* pImageBarrier = &imageBarriers[imageBarrierCount++];
+				pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				pImageBarrier->pNext = NULL;
+
+				pImageBarrier->image = pTexture->pVkImage;
+				pImageBarrier->subresourceRange.aspectMask = pTexture->mVkAspectMask;
+				pImageBarrier->subresourceRange.baseMipLevel = pTrans->mMipLevel;
+				pImageBarrier->subresourceRange.levelCount = 1;
+				pImageBarrier->subresourceRange.baseArrayLayer = pTrans->mArrayLayer;
+				pImageBarrier->subresourceRange.layerCount = 1;
+
+				pImageBarrier->srcAccessMask = util_to_vk_access_flags(pTrans->mCurrentState, queueType);
+				pImageBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState, queueType);
+				pImageBarrier->oldLayout = util_to_vk_image_layout(pTrans->mCurrentState);
+				pImageBarrier->newLayout = util_to_vk_image_layout(pTrans->mNewState);
+
+				pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+				srcStates |= pTrans->mCurrentState;
+				dstStates |= pTrans->mNewState;
+			}
+		}
+		else if (!(pTrans->mNewState & pTexture->mCurrentState) || pTrans->mNewState == RESOURCE_STATE_UNORDERED_ACCESS)
 		{
 			VkImageMemoryBarrier* pImageBarrier = &imageBarriers[imageBarrierCount++];
 			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -6012,20 +7247,25 @@ void cmdResourceBarrier(
 			pImageBarrier->subresourceRange.baseArrayLayer = 0;
 			pImageBarrier->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 
-			pImageBarrier->srcAccessMask = util_to_vk_access_flags(pTexture->mCurrentState);
-			pImageBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState);
+			pImageBarrier->srcAccessMask = util_to_vk_access_flags(pTexture->mCurrentState, queueType);
+			pImageBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState, queueType);
 			pImageBarrier->oldLayout = util_to_vk_image_layout(pTexture->mCurrentState);
 			pImageBarrier->newLayout = util_to_vk_image_layout(pTrans->mNewState);
 
 			pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 			pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
+			srcStates |= pTexture->mCurrentState;
+			dstStates |= pTrans->mNewState;
 			pTexture->mCurrentState = pTrans->mNewState;
 		}
 	}
 
 	if (bufferBarrierCount || imageBarrierCount)
 	{
+		VkPipelineStageFlags srcPipelineFlags = util_determine_pipeline_stage_flags(pCmd->pRenderer, srcStates, queueType);
+		VkPipelineStageFlags dstPipelineFlags = util_determine_pipeline_stage_flags(pCmd->pRenderer, dstStates, queueType);
+
 		uint32_t bufferBarrierEmptySlots = MAX_BATCH_BARRIERS - pCmd->mBatchBufferMemoryBarrierCount;
 		uint32_t imageBarrierEmptySlots = MAX_BATCH_BARRIERS - pCmd->mBatchImageMemoryBarrierCount;
 
@@ -6040,11 +7280,11 @@ void cmdResourceBarrier(
 				pCmd->pBatchImageMemoryBarriers + pCmd->mBatchImageMemoryBarrierCount, imageBarriers,
 				imageBarrierCount * sizeof(VkImageMemoryBarrier));
 			pCmd->mBatchImageMemoryBarrierCount += imageBarrierCount;
+			pCmd->mBatchSrcStageFlags |= srcPipelineFlags;
+			pCmd->mBatchDstStageFlags |= dstPipelineFlags;
 		}
 		else
 		{
-			VkPipelineStageFlags srcPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-			VkPipelineStageFlags dstPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 			vkCmdPipelineBarrier(
 				pCmd->pVkCmdBuf, srcPipelineFlags, dstPipelineFlags, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount,
 				imageBarriers);
@@ -6060,6 +7300,10 @@ void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers,
 	VkBufferMemoryBarrier* bufferBarriers = numBuffers ? (VkBufferMemoryBarrier*)alloca(numBuffers * sizeof(VkBufferMemoryBarrier)) : NULL;
 	uint32_t               bufferBarrierCount = 0;
 
+	const CmdPoolType   queueType = pCmd->pCmdPool->pQueue->mQueueDesc.mType;
+	const VkAccessFlags dstAccess = util_to_vk_access_flags(RESOURCE_STATE_UNORDERED_ACCESS, queueType);
+	const VkAccessFlags srcAccess = dstAccess & VK_ACCESS_SHADER_WRITE_BIT;
+
 	for (uint32_t i = 0; i < numBuffers; ++i)
 	{
 		VkBufferMemoryBarrier* pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
@@ -6070,8 +7314,8 @@ void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers,
 		pBufferBarrier->size = VK_WHOLE_SIZE;
 		pBufferBarrier->offset = 0;
 
-		pBufferBarrier->srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-		pBufferBarrier->dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		pBufferBarrier->srcAccessMask = srcAccess;
+		pBufferBarrier->dstAccessMask = dstAccess;
 
 		pBufferBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 		pBufferBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -6089,8 +7333,8 @@ void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers,
 		pImageBarrier->subresourceRange.baseArrayLayer = 0;
 		pImageBarrier->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 
-		pImageBarrier->srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-		pImageBarrier->dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		pImageBarrier->srcAccessMask = srcAccess;
+		pImageBarrier->dstAccessMask = dstAccess;
 		pImageBarrier->oldLayout = VK_IMAGE_LAYOUT_GENERAL;
 		pImageBarrier->newLayout = VK_IMAGE_LAYOUT_GENERAL;
 
@@ -6100,6 +7344,8 @@ void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers,
 
 	if (bufferBarrierCount || imageBarrierCount)
 	{
+		VkPipelineStageFlags stageFlags = util_determine_pipeline_stage_flags(pCmd->pRenderer, RESOURCE_STATE_UNORDERED_ACCESS, queueType);
+
 		uint32_t bufferBarrierEmptySlots = MAX_BATCH_BARRIERS - pCmd->mBatchBufferMemoryBarrierCount;
 		uint32_t imageBarrierEmptySlots = MAX_BATCH_BARRIERS - pCmd->mBatchImageMemoryBarrierCount;
 
@@ -6114,13 +7360,13 @@ void cmdSynchronizeResources(Cmd* pCmd, uint32_t numBuffers, Buffer** ppBuffers,
 				pCmd->pBatchImageMemoryBarriers + pCmd->mBatchImageMemoryBarrierCount, imageBarriers,
 				imageBarrierCount * sizeof(VkImageMemoryBarrier));
 			pCmd->mBatchImageMemoryBarrierCount += imageBarrierCount;
+			pCmd->mBatchSrcStageFlags |= stageFlags;
+			pCmd->mBatchDstStageFlags |= stageFlags;
 		}
 		else
 		{
-			VkPipelineStageFlags srcPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-			VkPipelineStageFlags dstPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 			vkCmdPipelineBarrier(
-				pCmd->pVkCmdBuf, srcPipelineFlags, dstPipelineFlags, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount,
+				pCmd->pVkCmdBuf, stageFlags, stageFlags, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount,
 				imageBarriers);
 		}
 	}
@@ -6130,14 +7376,14 @@ void cmdFlushBarriers(Cmd* pCmd)
 {
 	if (pCmd->mBatchBufferMemoryBarrierCount || pCmd->mBatchImageMemoryBarrierCount)
 	{
-		VkPipelineStageFlags srcPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-		VkPipelineStageFlags dstPipelineFlags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 		vkCmdPipelineBarrier(
-			pCmd->pVkCmdBuf, srcPipelineFlags, dstPipelineFlags, 0, 0, NULL, pCmd->mBatchBufferMemoryBarrierCount,
+			pCmd->pVkCmdBuf, pCmd->mBatchSrcStageFlags, pCmd->mBatchDstStageFlags, 0, 0, NULL, pCmd->mBatchBufferMemoryBarrierCount,
 			pCmd->pBatchBufferMemoryBarriers, pCmd->mBatchImageMemoryBarrierCount, pCmd->pBatchImageMemoryBarriers);
 
 		pCmd->mBatchBufferMemoryBarrierCount = 0;
 		pCmd->mBatchImageMemoryBarrierCount = 0;
+		pCmd->mBatchSrcStageFlags = 0;
+		pCmd->mBatchDstStageFlags = 0;
 	}
 }
 
@@ -6329,8 +7575,13 @@ void queueSubmit(
 	VkResult vk_res = vkQueueSubmit(pQueue->pVkQueue, 1, &submit_info, pFence ? pFence->pVkFence : VK_NULL_HANDLE);
 	ASSERT(VK_SUCCESS == vk_res);
 
+	const uint64_t fenceValue = tfrg_atomic64_add_relaxed(&pQueue->mFenceValue, 1) + 1;
 	if (pFence)
+	{
 		pFence->mSubmitted = true;
+		pFence->pSubmitQueue = pQueue;
+		pFence->mFenceValue = fenceValue;
+	}
 }
 
 void queuePresent(
@@ -6376,6 +7627,13 @@ void queuePresent(
 		ASSERT(VK_SUCCESS == vk_res);
 }
 
+/// Queues execute their submissions in order, a signaled fence completes everything submitted before it
+static void util_complete_fence(Fence* pFence)
+{
+	if (pFence->pSubmitQueue)
+		tfrg_atomic64_max_relaxed(&pFence->pSubmitQueue->mCompletedFenceValue, pFence->mFenceValue);
+}
+
 void waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences)
 {
 	ASSERT(pRenderer);
@@ -6397,13 +7655,22 @@ void waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences)
 	}
 
 	for (uint32_t i = 0; i < fenceCount; ++i)
+	{
+		if (ppFences[i]->mSubmitted)
+			util_complete_fence(ppFences[i]);
 		ppFences[i]->mSubmitted = false;
+	}
+
+	if (numValidFences)
+		advance_cache_frame();
 }
 
 
 void waitQueueIdle(Queue* pQueue)
 {
 	vkQueueWaitIdle(pQueue->pVkQueue);
+	tfrg_atomic64_max_relaxed(&pQueue->mCompletedFenceValue, tfrg_atomic64_load_relaxed(&pQueue->mFenceValue));
+	advance_cache_frame();
 }
 
 void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
@@ -6417,6 +7684,8 @@ void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatu
 		{
 			vkResetFences(pRenderer->pVkDevice, 1, &pFence->pVkFence);
 			pFence->mSubmitted = false;
+			util_complete_fence(pFence);
+			advance_cache_frame();
 		}
 
 		*pFenceStatus = vkRes == VK_SUCCESS ? FENCE_STATUS_COMPLETE : FENCE_STATUS_INCOMPLETE;
@@ -75,6 +75,7 @@ extern const RendererShaderDefinesDesc get_renderer_shaderdefines(Renderer* pRen
 
 extern VkDeviceMemory get_vk_device_memory(Renderer* pRenderer, Buffer* pBuffer);
 extern VkDeviceSize get_vk_device_memory_offset(Renderer* pRenderer, Buffer* pBuffer);
+extern VkPipelineCache get_vk_pipeline_cache(Renderer* pRenderer);
 
 VkBuildAccelerationStructureFlagsNV util_to_vk_acceleration_structure_build_flags(AccelerationStructureBuildFlags flags);
 VkGeometryFlagsNV util_to_vk_geometry_flags(AccelerationStructureGeometryFlags flags);
@@ -828,7 +829,7 @@ void vk_addRaytracingPipeline(const RaytracingPipelineDesc* pDesc, Pipeline** pp
 	createInfo.basePipelineHandle = VK_NULL_HANDLE;
 	createInfo.basePipelineIndex = 0;
 
-	VkResult vk_result = vkCreateRayTracingPipelinesNV(pDesc->pRaytracing->pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &createInfo, nullptr, &pResult->pVkPipeline);
+	VkResult vk_result = vkCreateRayTracingPipelinesNV(pDesc->pRaytracing->pRenderer->pVkDevice, get_vk_pipeline_cache(pDesc->pRaytracing->pRenderer), 1, &createInfo, nullptr, &pResult->pVkPipeline);
 	ASSERT(VK_SUCCESS == vk_result);
 
 	*ppPipeline = pResult;
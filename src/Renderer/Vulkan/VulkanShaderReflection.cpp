@@ -22,7 +22,7 @@
  * under the License.
 */
 
-#ifdef VULKAN
+#if defined(VULKAN) || defined(NULL_RENDERER)
 
 #include "IRenderer.h"
 
@@ -261,4 +261,4 @@ void vk_createShaderReflection(const uint8_t* shaderCode, uint32_t shaderSize, S
 	pOutReflection->pVariables = pVariables;
 	pOutReflection->mVariableCount = variablesCount;
 }
-#endif    // #ifdef VULKAN
\ No newline at end of file
+#endif    // #if defined(VULKAN) || defined(NULL_RENDERER)
\ No newline at end of file
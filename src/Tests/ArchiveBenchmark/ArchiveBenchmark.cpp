@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Time to open and read thousands of small files loose against the same files served from a mounted archive.
+// The files are written first, so both paths read from the page cache and only the per file overhead is measured.
+//
+// Usage: ArchiveBenchmark <ArchivePacker executable> [scale]
+//   scale  Multiplies the file count, 1 by default
+
+#include <stdlib.h>
+
+#include "EASTL/vector.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+static const char* gSubDirs[] = { "Shaders/", "Fonts/", "Textures/", "Meshes/" };
+
+// Half text-like so compressed archives have something to shrink, half noise
+static void fillFile(uint8_t* pData, uint32_t size, uint32_t seed)
+{
+	uint32_t state = seed * 2654435761u + 1;
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		state = state * 1664525u + 1013904223u;
+		pData[i] = i < size / 2 ? (uint8_t)('a' + (i * 7 + seed) % 26) : (uint8_t)(state >> 24);
+	}
+}
+
+static uint64_t checksumBytes(const uint8_t* pData, uint32_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (uint32_t i = 0; i < size; ++i)
+		hash = (hash ^ pData[i]) * 1099511628211ULL;
+	return hash;
+}
+
+// Opens and reads every file through FSR_OtherFiles, which an archive may be mounted on.
+// The timed runs only touch both ends of each file so hashing does not hide the per file cost.
+static uint64_t readAll(const eastl::vector<eastl::string>& names, uint8_t* pBuffer, uint32_t bufferSize, bool hashContents)
+{
+	uint64_t sum = 0;
+	for (uint32_t i = 0; i < (uint32_t)names.size(); ++i)
+	{
+		File file;
+		if (!file.Open(names[i], FM_ReadBinary, FSR_OtherFiles))
+			return 0;
+		unsigned size = file.GetSize();
+		if (size > bufferSize || file.Read(pBuffer, size) != size)
+			return 0;
+		file.Close();
+		sum += hashContents ? checksumBytes(pBuffer, size) : size + pBuffer[0] + pBuffer[size - 1];
+	}
+	return sum;
+}
+
+static bool packArchive(const char* pPacker, const char* pFlags, const eastl::string& dir, const eastl::string& archive)
+{
+	eastl::string command = eastl::string("\"") + pPacker + "\" " + pFlags + " \"" + dir + "\" \"" + archive + "\" > /dev/null";
+	return system(command.c_str()) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	if (argc < 2)
+	{
+		printf("Usage: ArchiveBenchmark <ArchivePacker executable> [scale]\n");
+		return 1;
+	}
+
+	uint32_t scale = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+	if (!scale)
+		scale = 1;
+
+	const uint32_t fileCount = 4000 * scale;
+	const uint32_t maxFileSize = 32 * 1024;
+
+	eastl::string directory = getTestDirectory("ArchiveBenchmark");
+	eastl::string looseDir = directory + "Loose/";
+	eastl::string archiveName = directory + "Files.pak";
+	eastl::string compressedArchiveName = directory + "FilesCompressed.pak";
+
+	// Sizes between 512 bytes and 32 KB, roughly what shaders, font metrics and small textures weigh
+	eastl::vector<eastl::string> names;
+	uint64_t                     totalBytes = 0;
+	uint8_t*                     pBuffer = (uint8_t*)conf_malloc(maxFileSize);
+	FileSystem::CreateDir(looseDir);
+	for (uint32_t i = 0; i < sizeof(gSubDirs) / sizeof(gSubDirs[0]); ++i)
+		FileSystem::CreateDir(looseDir + gSubDirs[i]);
+	for (uint32_t i = 0; i < fileCount; ++i)
+	{
+		char name[64];
+		sprintf(name, "%sfile%05u.bin", gSubDirs[i % 4], i);
+		uint32_t size = 512 + (i * 7919u) % (maxFileSize - 512);
+		fillFile(pBuffer, size, i);
+
+		File file;
+		TEST_CHECK(file.Open(looseDir + name, FM_WriteBinary, FSR_Absolute));
+		file.Write(pBuffer, size);
+		file.Close();
+		names.push_back(name);
+		totalBytes += size;
+	}
+
+	TEST_CHECK(packArchive(argv[1], "", looseDir, archiveName));
+	TEST_CHECK(packArchive(argv[1], "-c", looseDir, compressedArchiveName));
+
+	FileSystem::SetRootPath(FSR_OtherFiles, looseDir);
+
+	uint64_t looseSum = readAll(names, pBuffer, maxFileSize, true);
+	double   looseSeconds = measureBestSeconds(3, [&]() { readAll(names, pBuffer, maxFileSize, false); });
+
+	TEST_CHECK(FileSystem::MountArchive(FSR_OtherFiles, archiveName));
+	uint64_t archiveSum = readAll(names, pBuffer, maxFileSize, true);
+	double   archiveSeconds = measureBestSeconds(3, [&]() { readAll(names, pBuffer, maxFileSize, false); });
+
+	// Mounting again on the same root replaces the previous archive
+	TEST_CHECK(FileSystem::MountArchive(FSR_OtherFiles, compressedArchiveName));
+	uint64_t compressedSum = readAll(names, pBuffer, maxFileSize, true);
+	double   compressedSeconds = measureBestSeconds(3, [&]() { readAll(names, pBuffer, maxFileSize, false); });
+	FileSystem::UnmountArchive(FSR_OtherFiles);
+
+	TEST_CHECK(looseSum != 0);
+	TEST_CHECK(archiveSum == looseSum);
+	TEST_CHECK(compressedSum == looseSum);
+
+	printf("%u files, %.1f MB\n", fileCount, totalBytes / 1048576.0);
+	printf("%-18s %10s %12s %8s\n", "path", "ms", "files/s", "speedup");
+	printf("%-18s %10.2f %12.0f %7.2fx\n", "loose", looseSeconds * 1e3, fileCount / looseSeconds, 1.0);
+	printf("%-18s %10.2f %12.0f %7.2fx\n", "archive", archiveSeconds * 1e3, fileCount / archiveSeconds, looseSeconds / archiveSeconds);
+	printf(
+		"%-18s %10.2f %12.0f %7.2fx\n", "archive compressed", compressedSeconds * 1e3, fileCount / compressedSeconds,
+		looseSeconds / compressedSeconds);
+
+	for (uint32_t i = 0; i < (uint32_t)names.size(); ++i)
+		FileSystem::Delete(looseDir + names[i]);
+	FileSystem::Delete(archiveName);
+	FileSystem::Delete(compressedArchiveName);
+	conf_free(pBuffer);
+	return testResult("ArchiveBenchmark");
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Read throughput of AsyncFileIO at queue depths 1 to 64, with io_uring when the kernel allows it and with the thread pool.
+// The file is written first, so the reads come from the page cache and the numbers show the submission overhead.
+//
+// Usage: AsyncIOBenchmark [size in MB]
+//   size  Size of the test file, 64 by default
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "OS/Core/AsyncFileIO.h"
+#include "OS/Core/Atomics.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+static const uint32_t gBlockSizes[] = { 4096, 65536 };
+
+static tfrg_atomic32_t gFailedReads;
+
+static void readCallback(void* pUserData, int64_t bytesRead)
+{
+	if (bytesRead != (int64_t)(uintptr_t)pUserData)
+		tfrg_atomic32_add_relaxed(&gFailedReads, 1);
+}
+
+// Every 8 bytes of the file hold their own offset
+static bool checkContents(const uint64_t* pData, uint64_t size)
+{
+	for (uint64_t i = 0; i < size / 8; ++i)
+		if (pData[i] != i * 8)
+			return false;
+	return true;
+}
+
+// Reads every block of the file once in a scattered order, returns the seconds it took
+static double readFile(
+	AsyncFileIO* pAsyncFileIO, AsyncFileHandle file, uint64_t fileSize, uint32_t blockSize, uint8_t* pBuffer, AsyncReadDesc* pDescs)
+{
+	uint32_t blockCount = (uint32_t)(fileSize / blockSize);
+	for (uint32_t i = 0; i < blockCount; ++i)
+	{
+		// Odd stride visits each block exactly once
+		uint64_t block = (uint64_t)i * 7919 % blockCount;
+		pDescs[i].mFile = file;
+		pDescs[i].mOffset = block * blockSize;
+		pDescs[i].mSize = blockSize;
+		pDescs[i].pBuffer = pBuffer + block * blockSize;
+		pDescs[i].pCallback = readCallback;
+		pDescs[i].pUserData = (void*)(uintptr_t)blockSize;
+	}
+
+	return measureSeconds([&]() { waitAsyncIOTokenCompleted(pAsyncFileIO, addAsyncReads(pAsyncFileIO, blockCount, pDescs)); });
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t sizeMB = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 64;
+	if (!sizeMB)
+		sizeMB = 64;
+
+	uint64_t      fileSize = (uint64_t)sizeMB << 20;
+	eastl::string directory = getTestDirectory("AsyncIOBenchmark");
+	eastl::string fileName = directory + "data.bin";
+	uint64_t*     pData = (uint64_t*)conf_malloc(fileSize);
+	for (uint64_t i = 0; i < fileSize / 8; ++i)
+		pData[i] = i * 8;
+	{
+		File file;
+		TEST_CHECK(file.Open(fileName, FM_WriteBinary, FSR_Absolute));
+		file.Write(pData, (unsigned)fileSize);
+		file.Close();
+	}
+
+	AsyncReadDesc* pDescs = (AsyncReadDesc*)conf_calloc(fileSize / gBlockSizes[0], sizeof(AsyncReadDesc));
+	uint8_t*       pBuffer = (uint8_t*)pData;
+
+	AsyncFileHandle file = 0;
+	TEST_CHECK(openAsyncFile(fileName, FSR_Absolute, &file));
+	TEST_CHECK(getAsyncFileSize(file) == fileSize);
+
+	printf("%u MB file, MB/s per queue depth\n", sizeMB);
+	printf("%-12s %6s", "backend", "block");
+	for (uint32_t depth = 1; depth <= 64; depth *= 2)
+		printf(" %8u", depth);
+	printf("\n");
+
+	for (uint32_t threadPool = 0; threadPool < 2; ++threadPool)
+	{
+		for (uint32_t b = 0; b < sizeof(gBlockSizes) / sizeof(gBlockSizes[0]); ++b)
+		{
+			uint32_t blockSize = gBlockSizes[b];
+			bool     printed = false;
+			for (uint32_t depth = 1; depth <= 64; depth *= 2)
+			{
+				AsyncFileIODesc desc = {};
+				desc.mQueueDepth = depth;
+				desc.mForceThreadPool = threadPool != 0;
+				AsyncFileIO* pAsyncFileIO = NULL;
+				initAsyncFileIO(&desc, &pAsyncFileIO);
+
+				// io_uring can be missing or blocked, nothing to compare then
+				if (!threadPool && !isAsyncFileIONative(pAsyncFileIO))
+				{
+					shutdownAsyncFileIO(pAsyncFileIO);
+					break;
+				}
+				if (!printed)
+				{
+					printf("%-12s %6u", threadPool ? "thread pool" : "io_uring", blockSize);
+					printed = true;
+				}
+
+				memset(pBuffer, 0, fileSize);
+				double seconds = readFile(pAsyncFileIO, file, fileSize, blockSize, pBuffer, pDescs);
+				seconds = eastl::min(seconds, readFile(pAsyncFileIO, file, fileSize, blockSize, pBuffer, pDescs));
+				shutdownAsyncFileIO(pAsyncFileIO);
+
+				TEST_CHECK(checkContents(pData, fileSize));
+				printf(" %8.0f", fileSize / seconds / 1048576.0);
+			}
+			if (printed)
+				printf("\n");
+		}
+	}
+
+	// Errors are reported through the callback and still complete the token
+	{
+		AsyncFileIODesc desc = {};
+		AsyncFileIO*    pAsyncFileIO = NULL;
+		initAsyncFileIO(&desc, &pAsyncFileIO);
+		int64_t       result = 0;
+		AsyncReadDesc badRead = {};
+		badRead.mFile = (AsyncFileHandle)-1;
+		badRead.mSize = 16;
+		badRead.pBuffer = pBuffer;
+		badRead.pCallback = [](void* pUserData, int64_t bytesRead) { *(int64_t*)pUserData = bytesRead; };
+		badRead.pUserData = &result;
+		waitAsyncIOTokenCompleted(pAsyncFileIO, addAsyncReads(pAsyncFileIO, 1, &badRead));
+		TEST_CHECK(result < 0);
+		shutdownAsyncFileIO(pAsyncFileIO);
+	}
+
+	TEST_CHECK(tfrg_atomic32_load_relaxed(&gFailedReads) == 0);
+
+	closeAsyncFile(file);
+	FileSystem::Delete(fileName);
+	conf_free(pDescs);
+	conf_free(pData);
+	return testResult("AsyncIOBenchmark");
+}
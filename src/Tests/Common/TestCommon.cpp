@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "TestCommon.h"
+
+// Tests use absolute paths or set the roots they need through FileSystem::SetRootPath
+const char* pszBases[FSR_Count] = {
+	"",    // FSR_BinShaders
+	"",    // FSR_SrcShaders
+	"",    // FSR_Textures
+	"",    // FSR_Meshes
+	"",    // FSR_Builtin_Fonts
+	"",    // FSR_GpuConfig
+	"",    // FSR_Animation
+	"",    // FSR_Audio
+	"",    // FSR_OtherFiles
+	"",    // FSR_Middleware0
+	"",    // FSR_Middleware1
+	"",    // FSR_Middleware2
+};
+
+uint32_t gTestFailures = 0;
+
+int testResult(const char* pTestName)
+{
+	if (gTestFailures)
+		printf("%s: %u checks failed\n", pTestName, gTestFailures);
+	else
+		printf("%s: passed\n", pTestName);
+	return gTestFailures ? 1 : 0;
+}
+
+eastl::string getTestDirectory(const char* pTestName)
+{
+	eastl::string directory = FileSystem::GetCurrentDir() + pTestName + "_Data/";
+	if (!FileSystem::DirExists(directory))
+		FileSystem::CreateDir(directory);
+	return directory;
+}
+
+void resetPeakMemory()
+{
+	FILE* fp = fopen("/proc/self/clear_refs", "w");
+	if (fp)
+	{
+		fputs("5", fp);
+		fclose(fp);
+	}
+}
+
+uint64_t getPeakMemory()
+{
+	FILE* fp = fopen("/proc/self/status", "r");
+	if (!fp)
+		return 0;
+
+	uint64_t peakKB = 0;
+	char     line[256];
+	while (fgets(line, sizeof(line), fp))
+	{
+		if (strncmp(line, "VmHWM:", 6) == 0)
+		{
+			peakKB = strtoull(line + 6, NULL, 10);
+			break;
+		}
+	}
+	fclose(fp);
+	return peakKB * 1024;
+}
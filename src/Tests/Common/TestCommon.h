@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Shared by the tests and benchmarks under src/Tests, add_theforge_test links TestCommon.cpp into each of them.
+// Benchmarks print their measurements and only fail on wrong results, never on timings.
+
+#pragma once
+
+#include <stdio.h>
+
+#include "Interfaces/IFileSystem.h"
+#include "Interfaces/ILog.h"
+#include "Interfaces/ITime.h"
+
+extern uint32_t gTestFailures;
+
+#define TEST_CHECK(condition)                                                      \
+	do                                                                             \
+	{                                                                              \
+		if (!(condition))                                                          \
+		{                                                                          \
+			++gTestFailures;                                                       \
+			printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+		}                                                                          \
+	} while (0)
+
+/// Exit code of a test executable
+int testResult(const char* pTestName);
+
+/// Wall clock time of one call of func in seconds
+template <typename Func>
+inline double measureSeconds(Func func)
+{
+	HiresTimer timer;
+	func();
+	return timer.GetUSec(false) / 1e6;
+}
+
+/// Best of count runs, benchmarks use it to filter out scheduling noise
+template <typename Func>
+inline double measureBestSeconds(uint32_t count, Func func)
+{
+	double best = measureSeconds(func);
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		double seconds = measureSeconds(func);
+		best = seconds < best ? seconds : best;
+	}
+	return best;
+}
+
+/// Resets the peak resident set size to the current one, Linux only (4.0+)
+void resetPeakMemory();
+/// Peak resident set size in bytes since the last resetPeakMemory, 0 if it cannot be read
+uint64_t getPeakMemory();
+
+/// Directory under the working directory (the build directory when run through ctest) that a test can freely write to
+eastl::string getTestDirectory(const char* pTestName);
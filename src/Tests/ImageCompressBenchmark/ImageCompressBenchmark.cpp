@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Throughput and PSNR of Image::Compress for every target format and quality, on one thread and on a ThreadSystem.
+// The test image mixes gradients, fine detail, hard edges and noise so every quality level has something to fix.
+// BC1 - BC5 are decoded with Image::Uncompress, BC7 mode 6 and BC6H mode 11 (the modes the compressor writes) are
+// decoded here. ATI2N and BC5 also go through a roundtrip that checks the red and green blocks stay in order.
+//
+// Usage: ImageCompressBenchmark [size]
+//   size  Width and height of the test image, 256 by default
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Image/Image.h"
+#include "OS/Core/ThreadSystem.h"
+#include "OS/Math/MathTypes.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+/************************************************************************/
+// Test images
+/************************************************************************/
+static uint32_t gRandomState = 1;
+
+static float randomFloat()
+{
+	gRandomState = gRandomState * 1664525u + 1013904223u;
+	return (float)(gRandomState >> 8) / 16777216.0f;
+}
+
+/// RGBA8: smooth color ramps, a high frequency ring pattern, a few hard edged rectangles and a little noise.
+/// Alpha is a radial falloff
+static void fillTestImage(uint32_t size, uint8_t* pPixels)
+{
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			const float u = (float)x / size, v = (float)y / size;
+			const float dx = u - 0.5f, dy = v - 0.5f;
+			const float r2 = dx * dx + dy * dy;
+			float       rgb[3] = { u, v, 1.0f - 0.5f * (u + v) };
+			if (u > 0.5f && v < 0.5f)
+			{
+				const float rings = 0.5f + 0.5f * sinf(r2 * 900.0f);
+				rgb[0] = rings;
+				rgb[1] *= rings;
+			}
+			if ((x / 48 + y / 48) % 5 == 0)
+			{
+				rgb[0] = 1.0f - rgb[0];
+				rgb[2] = 0.1f;
+			}
+			uint8_t* pPixel = pPixels + (y * size + x) * 4;
+			for (uint32_t c = 0; c < 3; ++c)
+				pPixel[c] = (uint8_t)clamp(rgb[c] * 255.0f + (randomFloat() - 0.5f) * 8.0f, 0.0f, 255.0f);
+			pPixel[3] = (uint8_t)clamp((1.0f - 2.0f * sqrtf(r2)) * 255.0f, 0.0f, 255.0f);
+		}
+	}
+}
+
+/// RGBA32F with values up to 16: the RGBA8 image made linear and scaled by an exposure that grows along y
+static void fillHdrTestImage(uint32_t size, const uint8_t* pPixels, float* pHdr)
+{
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		const float exposure = exp2f(4.0f * y / size);
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const float value = (float)pPixels[(y * size + x) * 4 + c] / 255.0f;
+				pHdr[(y * size + x) * 4 + c] = c < 3 ? powf(value, 2.2f) * exposure : 1.0f;
+			}
+		}
+	}
+}
+
+/************************************************************************/
+// Decoders for the BC6H and BC7 modes Image::Compress writes
+/************************************************************************/
+static const uint32_t gWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BlockBitReader
+{
+	const uint8_t* pBlock;
+	uint32_t       mPosition;
+};
+
+static uint32_t readBits(BlockBitReader* pReader, uint32_t bitCount)
+{
+	uint32_t value = 0;
+	for (uint32_t i = 0; i < bitCount; ++i, ++pReader->mPosition)
+		value |= ((pReader->pBlock[pReader->mPosition >> 3] >> (pReader->mPosition & 7)) & 1u) << i;
+	return value;
+}
+
+/// BC7 mode 6 to RGBA8, returns false for any other mode
+static bool decodeBC7Mode6(const uint8_t* pBlock, uint8_t pTexels[16][4])
+{
+	BlockBitReader reader = { pBlock, 0 };
+	if (readBits(&reader, 7) != (1 << 6))
+		return false;
+
+	uint32_t endpoints[2][4];
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = readBits(&reader, 7);
+		endpoints[1][c] = readBits(&reader, 7);
+	}
+	const uint32_t p0 = readBits(&reader, 1), p1 = readBits(&reader, 1);
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t w = gWeights4[readBits(&reader, i ? 4 : 3)];
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			const uint32_t e0 = (endpoints[0][c] << 1) | p0, e1 = (endpoints[1][c] << 1) | p1;
+			pTexels[i][c] = (uint8_t)(((64 - w) * e0 + w * e1 + 32) >> 6);
+		}
+	}
+	return true;
+}
+
+static uint32_t unquantizeBC6H(uint32_t q)
+{
+	if (q == 0)
+		return 0;
+	if (q == 1023)
+		return 0xFFFF;
+	return ((q << 16) + 0x8000) >> 10;
+}
+
+/// Unsigned BC6H mode 11 to RGB floats, returns false for any other mode
+static bool decodeBC6HMode11(const uint8_t* pBlock, float pTexels[16][3])
+{
+	BlockBitReader reader = { pBlock, 0 };
+	if (readBits(&reader, 5) != 0x03)
+		return false;
+
+	uint32_t endpoints[2][3];
+	for (uint32_t e = 0; e < 2; ++e)
+		for (uint32_t c = 0; c < 3; ++c)
+			endpoints[e][c] = unquantizeBC6H(readBits(&reader, 10));
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		const uint32_t w = gWeights4[readBits(&reader, i ? 4 : 3)];
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			half h;
+			h.sh = (unsigned short)(((((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6) * 31) >> 6);
+			pTexels[i][c] = h;
+		}
+	}
+	return true;
+}
+
+/************************************************************************/
+// Error measurement
+/************************************************************************/
+struct TargetDesc
+{
+	const char*       pName;
+	ImageFormat::Enum mFormat;
+	uint32_t          mChannelCount;    // Channels of the source the format keeps
+	float             mMinPsnr;         // At normal quality on the test image
+};
+
+static double psnrFromSquaredError(double squaredError, uint64_t count, double peak)
+{
+	const double mse = squaredError / (double)count;
+	return mse > 0.0 ? 10.0 * log10(peak * peak / mse) : 99.0;
+}
+
+/// PSNR of the compressed LDR image against the RGBA8 source over the channels the format keeps
+static double measureLdrPsnr(const TargetDesc& target, Image* pImage, uint32_t size, const uint8_t* pSource)
+{
+	const uint32_t count = size * size;
+	double         squaredError = 0.0;
+	if (target.mFormat == ImageFormat::GNF_BC7)
+	{
+		const uint8_t* pBlock = pImage->GetPixels();
+		for (uint32_t by = 0; by < size / 4; ++by)
+		{
+			for (uint32_t bx = 0; bx < size / 4; ++bx, pBlock += 16)
+			{
+				uint8_t texels[16][4];
+				if (!decodeBC7Mode6(pBlock, texels))
+					return 0.0;
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					const uint8_t* pPixel = pSource + ((by * 4 + i / 4) * size + bx * 4 + i % 4) * 4;
+					for (uint32_t c = 0; c < 4; ++c)
+						squaredError += ((double)texels[i][c] - pPixel[c]) * ((double)texels[i][c] - pPixel[c]);
+				}
+			}
+		}
+		return psnrFromSquaredError(squaredError, (uint64_t)count * 4, 255.0);
+	}
+
+	if (!pImage->Uncompress())
+		return 0.0;
+	const uint32_t decodedChannels = ImageFormat::GetChannelCount(pImage->getFormat());
+	const uint8_t* pDecoded = pImage->GetPixels();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		for (uint32_t c = 0; c < target.mChannelCount; ++c)
+		{
+			const double diff = (double)pDecoded[i * decodedChannels + c] - pSource[i * 4 + c];
+			squaredError += diff * diff;
+		}
+	}
+	return psnrFromSquaredError(squaredError, (uint64_t)count * target.mChannelCount, 255.0);
+}
+
+/// PSNR of the BC6H image against the RGB of the float source, the peak is the largest source value
+static double measureHdrPsnr(Image* pImage, uint32_t size, const float* pSource)
+{
+	double peak = 0.0;
+	for (uint32_t i = 0; i < size * size; ++i)
+		for (uint32_t c = 0; c < 3; ++c)
+			peak = eastl::max(peak, (double)pSource[i * 4 + c]);
+
+	double         squaredError = 0.0;
+	const uint8_t* pBlock = pImage->GetPixels();
+	for (uint32_t by = 0; by < size / 4; ++by)
+	{
+		for (uint32_t bx = 0; bx < size / 4; ++bx, pBlock += 16)
+		{
+			float texels[16][3];
+			if (!decodeBC6HMode11(pBlock, texels))
+				return 0.0;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const float* pPixel = pSource + ((by * 4 + i / 4) * size + bx * 4 + i % 4) * 4;
+				for (uint32_t c = 0; c < 3; ++c)
+					squaredError += ((double)texels[i][c] - pPixel[c]) * ((double)texels[i][c] - pPixel[c]);
+			}
+		}
+	}
+	return psnrFromSquaredError(squaredError, (uint64_t)size * size * 3, peak);
+}
+
+/// Red along x, green along y through Compress and Uncompress, each channel has to come back in its own place
+static bool checkBC5Roundtrip(ImageFormat::Enum format)
+{
+	Image    image;
+	uint8_t* pPixels = image.Create(ImageFormat::RG8, 16, 16, 1, 1);
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		pPixels[i * 2] = (uint8_t)(i % 16 * 17);
+		pPixels[i * 2 + 1] = (uint8_t)(255 - i / 16 * 17);
+	}
+	if (!image.Compress(format) || !image.Uncompress() || ImageFormat::GetChannelCount(image.getFormat()) != 2)
+		return false;
+
+	bool           matches = true;
+	const uint8_t* pDecoded = image.GetPixels();
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		matches &= abs((int)pDecoded[i * 2] - (int)(i % 16 * 17)) <= 12;
+		matches &= abs((int)pDecoded[i * 2 + 1] - (int)(255 - i / 16 * 17)) <= 12;
+	}
+	image.Destroy();
+	return matches;
+}
+
+/************************************************************************/
+// Benchmark
+/************************************************************************/
+struct CompressResult
+{
+	double mSeconds;
+	double mThreadedSeconds;
+	double mPsnr;
+};
+
+/// Best of three compressions on one thread and on the thread system, the error is measured on the last one
+static bool runCompress(
+	const TargetDesc& target, CompressionQuality quality, ImageFormat::Enum srcFormat, uint32_t size, const void* pSource,
+	ThreadSystem* pThreadSystem, CompressResult* pResult)
+{
+	const uint32_t sourceSize = size * size * ImageFormat::GetBytesPerPixel(srcFormat);
+	*pResult = {};
+	pResult->mSeconds = 1e9;
+	pResult->mThreadedSeconds = 1e9;
+	for (uint32_t run = 0; run < 6; ++run)
+	{
+		ThreadSystem* pThreads = run & 1 ? pThreadSystem : NULL;
+		Image         image;
+		memcpy(image.Create(srcFormat, size, size, 1, 1), pSource, sourceSize);
+
+		bool         compressed = false;
+		const double seconds = measureSeconds([&]() { compressed = image.Compress(target.mFormat, quality, pThreads); });
+		if (!compressed)
+			return false;
+		double& best = pThreads ? pResult->mThreadedSeconds : pResult->mSeconds;
+		best = eastl::min(best, seconds);
+
+		if (run == 5)
+		{
+			if (target.mFormat == ImageFormat::GNF_BC6HUF)
+				pResult->mPsnr = measureHdrPsnr(&image, size, (const float*)pSource);
+			else
+				pResult->mPsnr = measureLdrPsnr(target, &image, size, (const uint8_t*)pSource);
+		}
+		image.Destroy();
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 256;
+	if (size < 4)
+		size = 256;
+	size &= ~3u;
+
+	uint8_t* pPixels = (uint8_t*)conf_malloc(size * size * 4);
+	float*   pHdrPixels = (float*)conf_malloc(size * size * 4 * sizeof(float));
+	fillTestImage(size, pPixels);
+	fillHdrTestImage(size, pPixels, pHdrPixels);
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const TargetDesc targets[] = {
+		{ "BC1", ImageFormat::GNF_BC1, 3, 30.0f },    { "BC3", ImageFormat::GNF_BC3, 4, 30.0f },
+		{ "BC4", ImageFormat::GNF_BC4, 1, 33.0f },    { "BC5", ImageFormat::GNF_BC5, 2, 35.0f },
+		{ "BC6H", ImageFormat::GNF_BC6HUF, 3, 26.0f }, { "BC7", ImageFormat::GNF_BC7, 4, 38.0f },
+	};
+	const char* qualityNames[] = { "fast", "normal", "high" };
+
+	printf("%ux%u image, megapixels/s on 1 thread and on the thread system\n", size, size);
+	printf("%-6s %-7s %10s %10s %9s\n", "format", "quality", "1 thread", "threads", "PSNR dB");
+	for (uint32_t t = 0; t < sizeof(targets) / sizeof(targets[0]); ++t)
+	{
+		const TargetDesc& target = targets[t];
+		const bool        hdr = target.mFormat == ImageFormat::GNF_BC6HUF;
+		double            previousPsnr = 0.0;
+		for (uint32_t quality = COMPRESSION_QUALITY_FAST; quality <= COMPRESSION_QUALITY_HIGH; ++quality)
+		{
+			CompressResult result;
+			TEST_CHECK(runCompress(
+				target, (CompressionQuality)quality, hdr ? ImageFormat::RGBA32F : ImageFormat::RGBA8, size,
+				hdr ? (const void*)pHdrPixels : (const void*)pPixels, pThreadSystem, &result));
+
+			const double megapixels = (double)size * size / 1e6;
+			printf(
+				"%-6s %-7s %10.2f %10.2f %9.2f\n", target.pName, qualityNames[quality], megapixels / result.mSeconds,
+				megapixels / result.mThreadedSeconds, result.mPsnr);
+
+			// Higher quality levels refine the same start, they never make the image worse
+			if (quality == COMPRESSION_QUALITY_NORMAL)
+				TEST_CHECK(result.mPsnr >= target.mMinPsnr);
+			TEST_CHECK(result.mPsnr >= previousPsnr - 0.05);
+			previousPsnr = result.mPsnr;
+		}
+	}
+
+	// ATI2N and BC5 are the same format, red is in the first block for both
+	TEST_CHECK(checkBC5Roundtrip(ImageFormat::ATI2N));
+	TEST_CHECK(checkBC5Roundtrip(ImageFormat::GNF_BC5));
+
+	shutdownThreadSystem(pThreadSystem);
+	conf_free(pHdrPixels);
+	conf_free(pPixels);
+	return testResult("ImageCompressBenchmark");
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Messages per second of LOGF and BLOGF from 1 to 32 threads against a logger that formats and flushes every line
+// under one mutex, like Log::Write did before the per-thread rings.
+// Both write their lines to a file, the console is quiet.
+//
+// Usage: LogBenchmark [scale]
+//   scale  Multiplies the message count, 1 by default
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "Interfaces/IThread.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+/************************************************************************/
+// Reference: format and write every line to a file and flush it while holding the lock
+/************************************************************************/
+struct LockedLogger
+{
+	Mutex mMutex;
+	File  mFile;
+};
+
+static LockedLogger* pLockedLogger = NULL;
+
+static void lockedLogWrite(const char* pFile, int line, const eastl::string& message)
+{
+	MutexLock lock(pLockedLogger->mMutex);
+
+	time_t        sysTime = time(NULL);
+	eastl::string timeStamp = ctime(&sysTime);
+	timeStamp.pop_back();
+	char threadName[32] = {};
+	Thread::GetCurrentThreadName(threadName, sizeof(threadName));
+	char preamble[128];
+	snprintf(preamble, sizeof(preamble), "%s [%-15s] %22s:%-5u ", timeStamp.c_str(), threadName, pFile, line);
+
+	eastl::string formattedMessage = eastl::string(preamble) + "WARN| " + message;
+	pLockedLogger->mFile.WriteLine(formattedMessage);
+	pLockedLogger->mFile.Flush();
+}
+
+/************************************************************************/
+// Workers
+/************************************************************************/
+enum LogMode
+{
+	LOG_MODE_LOCKED,
+	LOG_MODE_LOGF,
+	LOG_MODE_BLOGF,
+	LOG_MODE_COUNT,
+};
+
+struct WorkerData
+{
+	LogMode  mMode;
+	uint32_t mThreadIndex;
+	uint32_t mMessageCount;
+};
+
+static void workerThread(void* pData)
+{
+	WorkerData* pWorker = (WorkerData*)pData;
+	char        name[16];
+	snprintf(name, sizeof(name), "LogWorker%u", pWorker->mThreadIndex);
+	Thread::SetCurrentThreadName(name);
+
+	// A typical warning, a couple of numbers and a name
+	for (uint32_t i = 0; i < pWorker->mMessageCount; ++i)
+	{
+		switch (pWorker->mMode)
+		{
+			case LOG_MODE_LOCKED:
+				lockedLogWrite(__FILE__, __LINE__, ToString("Resource %u of thread %u is missing from %s", i, pWorker->mThreadIndex, "cache"));
+				break;
+			case LOG_MODE_LOGF:
+				LOGF(LogLevel::eWARNING, "Resource %u of thread %u is missing from %s", i, pWorker->mThreadIndex, "cache");
+				break;
+			case LOG_MODE_BLOGF:
+				BLOGF(LogLevel::eWARNING, "Resource %u of thread %u is missing from %s", i, pWorker->mThreadIndex, "cache");
+				break;
+			default: break;
+		}
+	}
+}
+
+static uint64_t gDeliveredCount = 0;
+
+// Runs on the log writer thread
+static void countCallback(void*, const eastl::string&) { ++gDeliveredCount; }
+
+// Seconds until every thread submitted its messages and until they all reached the callbacks
+static void runThreads(LogMode mode, uint32_t threadCount, uint32_t messageCount, double* pSubmitSeconds, double* pTotalSeconds)
+{
+	ThreadDesc   descs[32];
+	WorkerData   workers[32];
+	ThreadHandle threads[32];
+
+	HiresTimer timer;
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		workers[i] = { mode, i, messageCount / threadCount };
+		descs[i].pFunc = workerThread;
+		descs[i].pData = &workers[i];
+		threads[i] = create_thread(&descs[i]);
+	}
+	for (uint32_t i = 0; i < threadCount; ++i)
+		destroy_thread(threads[i]);
+	*pSubmitSeconds = timer.GetUSec(false) / 1e6;
+
+	if (mode != LOG_MODE_LOCKED)
+		Log::Flush();
+	*pTotalSeconds = timer.GetUSec(false) / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+	Log::SetQuiet(true);
+
+	uint32_t scale = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1;
+	if (!scale)
+		scale = 1;
+	const uint32_t messageCount = 16384 * scale;
+
+	eastl::string directory = getTestDirectory("LogBenchmark");
+	eastl::string lockedLogName = directory + "Locked.log";
+	pLockedLogger = conf_new(LockedLogger);
+	TEST_CHECK(pLockedLogger->mFile.Open(lockedLogName, FM_WriteBinary, FSR_Absolute));
+
+	// Opens the default log file next to the executable and starts the writer before anything is timed
+	LOGF(LogLevel::eINFO, "LogBenchmark: %u messages per run", messageCount);
+	Log::AddCallback("LogBenchmark", LogLevel::eWARNING, NULL, countCallback);
+
+	const char* modeNames[] = { "locked", "LOGF", "BLOGF" };
+	printf("%u messages per run, thousands of messages/s submitted (delivered)\n", messageCount);
+	printf("%-7s", "threads");
+	for (uint32_t mode = 0; mode < LOG_MODE_COUNT; ++mode)
+		printf(" %22s", modeNames[mode]);
+	printf("\n");
+
+	for (uint32_t threadCount = 1; threadCount <= 32; threadCount *= 2)
+	{
+		printf("%-7u", threadCount);
+		for (uint32_t mode = 0; mode < LOG_MODE_COUNT; ++mode)
+		{
+			double   submitSeconds = 0.0;
+			double   totalSeconds = 0.0;
+			uint64_t delivered = gDeliveredCount;
+			runThreads((LogMode)mode, threadCount, messageCount, &submitSeconds, &totalSeconds);
+
+			// Flush returned, so the writer thread handed every line to the callbacks
+			uint32_t expected = mode == LOG_MODE_LOCKED ? 0 : messageCount / threadCount * threadCount;
+			TEST_CHECK(gDeliveredCount - delivered == expected);
+			printf(" %10.0f (%9.0f)", messageCount / submitSeconds / 1e3, messageCount / totalSeconds / 1e3);
+		}
+		printf("\n");
+	}
+
+	pLockedLogger->mFile.Close();
+	conf_delete(pLockedLogger);
+	FileSystem::Delete(lockedLogName);
+	return testResult("LogBenchmark");
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Load time and peak resident memory of reading through a MappedFile against the buffered File::Read path it replaced.
+// The files are written first, so both paths read from the page cache.
+//
+// Usage: MappedFileBenchmark [size in MB]
+//   size  Size of the test image, 64 by default
+
+#include <stdlib.h>
+
+#include "Image/Image.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+struct PathResult
+{
+	double   mSeconds;
+	uint64_t mPeakBytes;
+	uint64_t mChecksum;
+};
+
+template <typename Func>
+static PathResult measurePath(Func func)
+{
+	PathResult result = {};
+	result.mSeconds = 1e9;
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		resetPeakMemory();
+		uint64_t baseline = getPeakMemory();
+		double   seconds = measureSeconds([&]() { result.mChecksum = func(); });
+		uint64_t peak = getPeakMemory();
+		result.mSeconds = seconds < result.mSeconds ? seconds : result.mSeconds;
+		result.mPeakBytes = peak > baseline ? peak - baseline : 0;
+	}
+	return result;
+}
+
+static uint64_t checksumBytes(const void* pData, size_t size)
+{
+	// One read per page is enough to fault every page in, the sum keeps the reads alive
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	uint64_t       sum = 0;
+	for (size_t i = 0; i < size; i += 4096)
+		sum += pBytes[i];
+	return sum + (size ? pBytes[size - 1] : 0);
+}
+
+/************************************************************************/
+// Paths
+/************************************************************************/
+static uint64_t readBuffered(const eastl::string& fileName)
+{
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, FSR_Absolute))
+		return 0;
+
+	unsigned size = file.GetSize();
+	void*    pData = conf_malloc(size);
+	file.Read(pData, size);
+	file.Close();
+	uint64_t sum = checksumBytes(pData, size);
+	conf_free(pData);
+	return sum;
+}
+
+static uint64_t readMapped(const eastl::string& fileName)
+{
+	MappedFile file;
+	if (!file.Open(fileName, FSR_Absolute))
+		return 0;
+	return checksumBytes(file.GetData(), file.GetSize());
+}
+
+// What Image::loadImage did before MappedFile: copy the whole file, then parse the copy
+static uint64_t loadImageBuffered(const eastl::string& fileName)
+{
+	File file;
+	if (!file.Open(fileName, FM_ReadBinary, FSR_Absolute))
+		return 0;
+
+	unsigned size = file.GetSize();
+	char*    pData = (char*)conf_malloc(size);
+	file.Read(pData, size);
+	file.Close();
+
+	Image image;
+	bool  loaded = image.loadFromMemory(pData, size, FileSystem::GetExtension(fileName).c_str());
+	conf_free(pData);
+	uint64_t sum = loaded ? checksumBytes(image.GetPixels(), image.GetMipMappedSize()) : 0;
+	image.Destroy();
+	return sum;
+}
+
+static uint64_t loadImageMapped(const eastl::string& fileName)
+{
+	Image    image;
+	bool     loaded = image.loadImage(fileName.c_str(), NULL, NULL, FSR_Absolute);
+	uint64_t sum = loaded ? checksumBytes(image.GetPixels(), image.GetMipMappedSize()) : 0;
+	image.Destroy();
+	return sum;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t sizeMB = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 64;
+	if (!sizeMB)
+		sizeMB = 64;
+
+	// Square RGBA8 image of about sizeMB
+	uint32_t width = 256;
+	while ((uint64_t)width * width * 4 * 4 <= (uint64_t)sizeMB << 20)
+		width *= 2;
+
+	eastl::string directory = getTestDirectory("MappedFileBenchmark");
+	eastl::string imageName = directory + "image.dds";
+	{
+		Image    image;
+		uint8_t* pPixels = image.Create(ImageFormat::RGBA8, width, width, 1, 1);
+		for (uint32_t i = 0; i < width * width * 4; ++i)
+			pPixels[i] = (uint8_t)(i * 7 + (i >> 12));
+		TEST_CHECK(image.iSaveDDS(imageName.c_str()));
+		image.Destroy();
+	}
+
+	struct
+	{
+		const char* pName;
+		PathResult  mBuffered;
+		PathResult  mMapped;
+	} results[] = {
+		{ "raw read", measurePath([&]() { return readBuffered(imageName); }), measurePath([&]() { return readMapped(imageName); }) },
+		{ "dds load", measurePath([&]() { return loadImageBuffered(imageName); }),
+		  measurePath([&]() { return loadImageMapped(imageName); }) },
+	};
+
+	printf("%ux%u RGBA8 DDS, %.1f MB\n", width, width, width * width * 4 / 1048576.0);
+	printf("%-9s %12s %12s %14s %14s\n", "path", "buffered ms", "mapped ms", "buffered peak", "mapped peak");
+	for (uint32_t i = 0; i < sizeof(results) / sizeof(results[0]); ++i)
+	{
+		TEST_CHECK(results[i].mBuffered.mChecksum != 0);
+		TEST_CHECK(results[i].mBuffered.mChecksum == results[i].mMapped.mChecksum);
+		printf(
+			"%-9s %12.2f %12.2f %11.1f MB %11.1f MB\n", results[i].pName, results[i].mBuffered.mSeconds * 1e3,
+			results[i].mMapped.mSeconds * 1e3, results[i].mBuffered.mPeakBytes / 1048576.0, results[i].mMapped.mPeakBytes / 1048576.0);
+	}
+
+	// A mapping shows up in the resident set as clean page cache pages the kernel can drop, the buffered copy is anonymous memory
+	printf("peak is the VmHWM increase, mapped pages count towards it while they are mapped\n");
+
+	FileSystem::Delete(imageName);
+	return testResult("MappedFileBenchmark");
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Full mip chain generation time of Image::GenerateMipMaps with the box, Kaiser and Lanczos filters against the scalar
+// 2x2x2 buildMipMap loop it replaced, for RGBA8, RGBA8 sRGB, RGBA16F and RGBA32F on one thread.
+// The old loop averaged sRGB in gamma space and had no half path, for RGBA16F its 16 bit integer loop stands in for the cost.
+// Also checks non power of two sizes (every level halves rounding down, the last level is 1x1, constant images stay
+// constant, the box filter keeps the mean) and that sRGB images are filtered in linear space.
+//
+// Usage: MipGenerationBenchmark [size]
+//   size  Width and height of the test image, 1024 by default
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Image/Image.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+/************************************************************************/
+// Reference: the buildMipMap loop GenerateMipMaps used before, power of two 2D images only
+/************************************************************************/
+template <typename T>
+static void buildMipMap(T* dst, const T* src, const uint32_t w, const uint32_t h, const uint32_t c)
+{
+	uint32_t xOff = (w < 2) ? 0 : c;
+	uint32_t yOff = (h < 2) ? 0 : c * w;
+
+	for (uint32_t y = 0; y < h; y += 2)
+	{
+		for (uint32_t x = 0; x < w; x += 2)
+		{
+			for (uint32_t i = 0; i < c; i++)
+			{
+				// The depth taps of the old loop read the same texels again for 2D images
+				*dst++ = (src[0] + src[xOff] + src[yOff] + src[yOff + xOff] + src[0] + src[xOff] + src[yOff] + src[yOff + xOff]) / 8;
+				src++;
+			}
+			src += xOff;
+		}
+		src += yOff;
+	}
+}
+
+template <typename T>
+static void buildReferenceChain(Image* pImage)
+{
+	for (uint32_t level = 1; level < pImage->GetMipMapCount(); ++level)
+	{
+		buildMipMap(
+			(T*)pImage->GetPixels(level), (const T*)pImage->GetPixels(level - 1), pImage->GetWidth(level - 1), pImage->GetHeight(level - 1),
+			4);
+	}
+}
+
+/************************************************************************/
+// Test images
+/************************************************************************/
+/// Smooth ramps with a fine ring pattern on top, alpha is a radial falloff
+static void fillTestImage(uint32_t width, uint32_t height, float* pPixels)
+{
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const float u = (float)x / width;
+			const float v = (float)y / height;
+			const float r2 = (u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f);
+			float*      pPixel = &pPixels[(y * width + x) * 4];
+			pPixel[0] = u;
+			pPixel[1] = v;
+			pPixel[2] = 0.5f + 0.5f * sinf(r2 * 400.0f);
+			pPixel[3] = fmaxf(0.0f, 1.0f - 2.0f * sqrtf(r2));
+		}
+	}
+}
+
+/// Image with a single level in format, converted from RGBA32F pixels
+static void createImage(Image* pImage, ImageFormat::Enum format, bool srgb, uint32_t width, uint32_t height, const float* pPixels)
+{
+	pImage->Create(ImageFormat::RGBA32F, width, height, 1, 1);
+	memcpy(pImage->GetPixels(), pPixels, width * height * 4 * sizeof(float));
+	if (format != ImageFormat::RGBA32F)
+		pImage->Convert(format);
+	pImage->setSrgb(srgb);
+}
+
+/************************************************************************/
+// Correctness
+/************************************************************************/
+static bool isNear(float a, float b, float tolerance) { return fabsf(a - b) <= tolerance; }
+
+static void testNonPowerOfTwo()
+{
+	const uint32_t sizes[][2] = { { 37, 21 }, { 1, 7 }, { 255, 3 } };
+	const float    color[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+
+	for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+	{
+		const uint32_t width = sizes[s][0];
+		const uint32_t height = sizes[s][1];
+		float*         pConstant = (float*)conf_malloc(width * height * 4 * sizeof(float));
+		float*         pRamp = (float*)conf_malloc(width * height * 4 * sizeof(float));
+		for (uint32_t i = 0; i < width * height; ++i)
+			memcpy(&pConstant[i * 4], color, sizeof(color));
+		fillTestImage(width, height, pRamp);
+
+		for (uint32_t filter = MIP_FILTER_BOX; filter <= MIP_FILTER_LANCZOS; ++filter)
+		{
+			// Constant images stay constant with every filter, the weights of every texel sum up to one
+			Image image;
+			createImage(&image, ImageFormat::RGBA32F, false, width, height, pConstant);
+			TEST_CHECK(image.GenerateMipMaps(ALL_MIPLEVELS, (MipFilter)filter));
+			TEST_CHECK(image.GetMipMapCount() == calculateMipMapLevels(width, height));
+			for (uint32_t level = 1; level < image.GetMipMapCount(); ++level)
+			{
+				TEST_CHECK(image.GetWidth(level) == (width >> level ? width >> level : 1));
+				TEST_CHECK(image.GetHeight(level) == (height >> level ? height >> level : 1));
+				const float* pLevel = (const float*)image.GetPixels(level);
+				bool         constant = true;
+				for (uint32_t i = 0; i < image.GetWidth(level) * image.GetHeight(level) * 4; ++i)
+					constant = constant && isNear(pLevel[i], color[i % 4], 1e-5f);
+				TEST_CHECK(constant);
+			}
+			const uint32_t lastLevel = image.GetMipMapCount() - 1;
+			TEST_CHECK(image.GetWidth(lastLevel) == 1 && image.GetHeight(lastLevel) == 1);
+			image.Destroy();
+
+			// Box weights are the exact texel coverage, so every level keeps the mean of the image
+			if (filter != MIP_FILTER_BOX)
+				continue;
+			createImage(&image, ImageFormat::RGBA32F, false, width, height, pRamp);
+			TEST_CHECK(image.GenerateMipMaps(ALL_MIPLEVELS, MIP_FILTER_BOX));
+			double mean[4] = {};
+			for (uint32_t i = 0; i < width * height * 4; ++i)
+				mean[i % 4] += pRamp[i] / (width * height);
+			const float* pLast = (const float*)image.GetPixels(lastLevel);
+			for (uint32_t c = 0; c < 4; ++c)
+				TEST_CHECK(isNear(pLast[c], (float)mean[c], 1e-4f));
+			image.Destroy();
+		}
+
+		// The 8 bit path rounds, a constant stays exactly the same
+		uint8_t expected[4] = {};
+		Image   image;
+		createImage(&image, ImageFormat::RGBA8, false, width, height, pConstant);
+		memcpy(expected, image.GetPixels(), 4);
+		TEST_CHECK(image.GenerateMipMaps(ALL_MIPLEVELS, MIP_FILTER_LANCZOS));
+		const uint32_t lastLevel = image.GetMipMapCount() - 1;
+		TEST_CHECK(memcmp(image.GetPixels(lastLevel), expected, 4) == 0);
+		image.Destroy();
+
+		conf_free(pRamp);
+		conf_free(pConstant);
+	}
+}
+
+/// Rows alternating between black and white, with transparent and opaque alpha. Every texel of level 1 covers one row of each
+static void testSrgb()
+{
+	// 8x8 halves exactly and takes the 2x2 box path, 5x4 goes through the resampler
+	const uint32_t sizes[][2] = { { 8, 8 }, { 5, 4 } };
+	for (uint32_t s = 0; s < 2; ++s)
+	{
+		const uint32_t width = sizes[s][0];
+		const uint32_t height = sizes[s][1];
+		for (uint32_t srgb = 0; srgb < 2; ++srgb)
+		{
+			Image    image;
+			uint8_t* pPixels = image.Create(ImageFormat::RGBA8, width, height, 1, 1);
+			for (uint32_t i = 0; i < width * height * 4; ++i)
+				pPixels[i] = (i / (width * 4)) & 1 ? 255 : 0;
+			image.setSrgb(srgb != 0);
+			TEST_CHECK(image.GenerateMipMaps(ALL_MIPLEVELS, MIP_FILTER_BOX));
+
+			// Half of linear 1.0 encodes to 187.5 in sRGB, the gamma space average would be 127.5. Alpha is always linear
+			const int      expectedColor = srgb ? 188 : 128;
+			const uint8_t* pLevel = image.GetPixels(1);
+			bool           linear = true;
+			for (uint32_t i = 0; i < image.GetWidth(1) * image.GetHeight(1); ++i)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+					linear = linear && abs(pLevel[i * 4 + c] - expectedColor) <= 1;
+				linear = linear && abs(pLevel[i * 4 + 3] - 128) <= 1;
+			}
+			TEST_CHECK(linear);
+			image.Destroy();
+		}
+	}
+}
+
+/************************************************************************/
+// Benchmark
+/************************************************************************/
+struct FormatDesc
+{
+	const char*       pName;
+	ImageFormat::Enum mFormat;
+	bool              mSrgb;
+};
+
+static double measureChain(const FormatDesc& format, uint32_t size, const float* pPixels, int filter)
+{
+	Image source;
+	createImage(&source, format.mFormat, format.mSrgb, size, size, pPixels);
+	const uint32_t topSize = source.GetMipMappedSize(0, 1);
+
+	double seconds = measureBestSeconds(3, [&]() {
+		Image image;
+		// filter < 0 is the reference loop
+		if (filter < 0)
+		{
+			image.Create(format.mFormat, size, size, 1, calculateMipMapLevels(size, size));
+			memcpy(image.GetPixels(), source.GetPixels(), topSize);
+			if (format.mFormat == ImageFormat::RGBA8)
+				buildReferenceChain<uint8_t>(&image);
+			else if (format.mFormat == ImageFormat::RGBA16F)
+				buildReferenceChain<uint16_t>(&image);
+			else
+				buildReferenceChain<float>(&image);
+		}
+		else
+		{
+			image.Create(format.mFormat, size, size, 1, 1);
+			memcpy(image.GetPixels(), source.GetPixels(), topSize);
+			image.setSrgb(format.mSrgb);
+			TEST_CHECK(image.GenerateMipMaps(ALL_MIPLEVELS, (MipFilter)filter));
+		}
+		image.Destroy();
+	});
+	source.Destroy();
+	return seconds;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1024;
+	// The reference loop only handles powers of two
+	uint32_t powerOfTwo = 4;
+	while (powerOfTwo * 2 <= size)
+		powerOfTwo *= 2;
+	size = powerOfTwo;
+
+	testNonPowerOfTwo();
+	testSrgb();
+
+	float* pPixels = (float*)conf_malloc(size * size * 4 * sizeof(float));
+	fillTestImage(size, size, pPixels);
+
+	const FormatDesc formats[] = {
+		{ "RGBA8", ImageFormat::RGBA8, false },
+		{ "RGBA8 sRGB", ImageFormat::RGBA8, true },
+		{ "RGBA16F", ImageFormat::RGBA16F, false },
+		{ "RGBA32F", ImageFormat::RGBA32F, false },
+	};
+
+	printf("%ux%u full chain, ms on 1 thread\n", size, size);
+	printf("%-11s %8s %8s %8s %8s\n", "format", "old", "box", "kaiser", "lanczos");
+	for (uint32_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+	{
+		double seconds[4] = {};
+		for (int filter = -1; filter <= MIP_FILTER_LANCZOS; ++filter)
+			seconds[filter + 1] = measureChain(formats[f], size, pPixels, filter);
+		printf(
+			"%-11s %8.2f %8.2f %8.2f %8.2f\n", formats[f].pName, seconds[0] * 1e3, seconds[1] * 1e3, seconds[2] * 1e3,
+			seconds[3] * 1e3);
+	}
+
+	conf_free(pPixels);
+	return testResult("MipGenerationBenchmark");
+}
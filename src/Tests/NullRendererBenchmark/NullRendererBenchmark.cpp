@@ -0,0 +1,784 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// CPU cost of the renderer front end on the Null renderer, without a GPU or driver in the numbers:
+//  - cmdBindDescriptors recording and replay for a per draw update and for a full table
+//  - buffer streaming through the resource loader with addResource and updateResource
+//  - a UI frame recorded the way ImguiGUIDriver::draw does it, a scissor, a texture and an indexed draw per widget
+//  - mip streaming of DDS files under a memory budget: the first load reads the mip tail only, evictions upload nothing
+//    and the streamed bytes stay within the budget
+// UIApp itself cannot run here, its shaders are compiled with glslangValidator at load time. The shader below is
+// hand written SPIR-V so the benchmark has no tool dependency.
+//
+// Usage: NullRendererBenchmark [scale]
+//   scale  Multiplies the bind, upload and draw counts, 1 by default
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <initializer_list>
+
+#include "EASTL/vector.h"
+
+#include "IRenderer.h"
+#include "ResourceLoader.h"
+#include "Image/Image.h"
+#include "Interfaces/IThread.h"
+#include "Renderer/Null/NullCommands.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+#define TEXTURE_COUNT 8
+#define OBJECT_COUNT 1024
+#define OBJECT_STRIDE 16
+
+/************************************************************************/
+// Shader
+/************************************************************************/
+// Ids of the module, the resources match what a typical forward pass declares per update frequency
+enum ShaderId
+{
+	ID_VOID = 1,
+	ID_FUNCTION_TYPE,
+	ID_MAIN,
+	ID_LABEL,
+	ID_FLOAT,
+	ID_VEC4,
+	ID_UINT,
+	ID_INT,
+	ID_INT_0,
+	ID_UINT_TEXTURE_COUNT,
+	ID_IMAGE,
+	ID_IMAGE_ARRAY,
+	ID_IMAGE_ARRAY_PTR,
+	ID_TEXTURES,
+	ID_IMAGE_PTR,
+	ID_SAMPLER_TYPE,
+	ID_SAMPLER_PTR,
+	ID_SAMPLER,
+	ID_UNIFORM_BLOCK_TYPE,
+	ID_UNIFORM_BLOCK_PTR,
+	ID_UNIFORM_BLOCK,
+	ID_UNIFORM_VEC4_PTR,
+	ID_OBJECT_ARRAY,
+	ID_OBJECT_BUFFER_TYPE,
+	ID_OBJECT_BUFFER_PTR,
+	ID_OBJECT_BUFFER,
+	ID_ROOT_CONSTANT_TYPE,
+	ID_ROOT_CONSTANT_PTR,
+	ID_ROOT_CONSTANT,
+	ID_PUSH_UINT_PTR,
+	ID_TEXTURE_ELEMENT,
+	ID_TEXTURE_VALUE,
+	ID_SAMPLER_VALUE,
+	ID_UNIFORM_ELEMENT,
+	ID_UNIFORM_VALUE,
+	ID_OBJECT_ELEMENT,
+	ID_OBJECT_VALUE,
+	ID_ROOT_CONSTANT_ELEMENT,
+	ID_ROOT_CONSTANT_VALUE,
+	ID_BOUND,
+};
+
+// Appends one instruction, a string operand goes last and is null terminated and padded to whole words
+static void emitOp(eastl::vector<uint32_t>& words, uint32_t opcode, std::initializer_list<uint32_t> operands, const char* pString = NULL)
+{
+	const uint32_t stringWords = pString ? (uint32_t)strlen(pString) / 4 + 1 : 0;
+	words.push_back((1 + (uint32_t)operands.size() + stringWords) << 16 | opcode);
+	words.insert(words.end(), operands.begin(), operands.end());
+	if (pString)
+	{
+		const size_t start = words.size();
+		words.resize(start + stringWords, 0);
+		memcpy(&words[start], pString, strlen(pString));
+	}
+}
+
+// Reflection drops resources the entry point never touches, main loads from every one of them.
+// textures[8] and defaultSampler are per none (set 0), uniformBlock per frame (set 1), objectBuffer per draw (set 3),
+// rootConstant is a push constant.
+static void buildShader(bool compute, eastl::vector<uint32_t>& words)
+{
+	words = { 0x07230203, 0x00010000, 0, ID_BOUND, 0 };
+	emitOp(words, 17, { 1 });                                   // OpCapability Shader
+	emitOp(words, 14, { 0, 1 });                                // OpMemoryModel Logical GLSL450
+	emitOp(words, 15, { compute ? 5u : 4u, ID_MAIN }, "main");  // OpEntryPoint GLCompute / Fragment
+	if (compute)
+		emitOp(words, 16, { ID_MAIN, 17, 64, 1, 1 });           // OpExecutionMode LocalSize 64 1 1
+	else
+		emitOp(words, 16, { ID_MAIN, 7 });                      // OpExecutionMode OriginUpperLeft
+
+	// OpName
+	emitOp(words, 5, { ID_TEXTURES }, "textures");
+	emitOp(words, 5, { ID_SAMPLER }, "defaultSampler");
+	emitOp(words, 5, { ID_UNIFORM_BLOCK }, "uniformBlock");
+	emitOp(words, 5, { ID_OBJECT_BUFFER }, "objectBuffer");
+	emitOp(words, 5, { ID_ROOT_CONSTANT }, "rootConstant");
+
+	// OpDecorate DescriptorSet (34), Binding (33), Block (2), BufferBlock (3), ArrayStride (6), OpMemberDecorate Offset (35)
+	emitOp(words, 71, { ID_TEXTURES, 34, 0 });
+	emitOp(words, 71, { ID_TEXTURES, 33, 0 });
+	emitOp(words, 71, { ID_SAMPLER, 34, 0 });
+	emitOp(words, 71, { ID_SAMPLER, 33, 1 });
+	emitOp(words, 71, { ID_UNIFORM_BLOCK_TYPE, 2 });
+	emitOp(words, 72, { ID_UNIFORM_BLOCK_TYPE, 0, 35, 0 });
+	emitOp(words, 71, { ID_UNIFORM_BLOCK, 34, 1 });
+	emitOp(words, 71, { ID_UNIFORM_BLOCK, 33, 0 });
+	emitOp(words, 71, { ID_OBJECT_ARRAY, 6, OBJECT_STRIDE });
+	emitOp(words, 71, { ID_OBJECT_BUFFER_TYPE, 3 });
+	emitOp(words, 72, { ID_OBJECT_BUFFER_TYPE, 0, 35, 0 });
+	emitOp(words, 71, { ID_OBJECT_BUFFER, 34, 3 });
+	emitOp(words, 71, { ID_OBJECT_BUFFER, 33, 0 });
+	emitOp(words, 71, { ID_ROOT_CONSTANT_TYPE, 2 });
+	emitOp(words, 72, { ID_ROOT_CONSTANT_TYPE, 0, 35, 0 });
+
+	// Types, constants and variables. Storage classes UniformConstant (0), Uniform (2), PushConstant (9)
+	emitOp(words, 19, { ID_VOID });                                                   // OpTypeVoid
+	emitOp(words, 33, { ID_FUNCTION_TYPE, ID_VOID });                                 // OpTypeFunction
+	emitOp(words, 22, { ID_FLOAT, 32 });                                              // OpTypeFloat
+	emitOp(words, 23, { ID_VEC4, ID_FLOAT, 4 });                                      // OpTypeVector
+	emitOp(words, 21, { ID_UINT, 32, 0 });                                            // OpTypeInt
+	emitOp(words, 21, { ID_INT, 32, 1 });                                             // OpTypeInt
+	emitOp(words, 43, { ID_INT, ID_INT_0, 0 });                                       // OpConstant
+	emitOp(words, 43, { ID_UINT, ID_UINT_TEXTURE_COUNT, TEXTURE_COUNT });             // OpConstant
+	emitOp(words, 25, { ID_IMAGE, ID_FLOAT, 1, 0, 0, 0, 1, 0 });                      // OpTypeImage 2D sampled
+	emitOp(words, 28, { ID_IMAGE_ARRAY, ID_IMAGE, ID_UINT_TEXTURE_COUNT });           // OpTypeArray
+	emitOp(words, 32, { ID_IMAGE_ARRAY_PTR, 0, ID_IMAGE_ARRAY });                     // OpTypePointer
+	emitOp(words, 59, { ID_IMAGE_ARRAY_PTR, ID_TEXTURES, 0 });                        // OpVariable
+	emitOp(words, 32, { ID_IMAGE_PTR, 0, ID_IMAGE });                                 // OpTypePointer
+	emitOp(words, 26, { ID_SAMPLER_TYPE });                                           // OpTypeSampler
+	emitOp(words, 32, { ID_SAMPLER_PTR, 0, ID_SAMPLER_TYPE });                        // OpTypePointer
+	emitOp(words, 59, { ID_SAMPLER_PTR, ID_SAMPLER, 0 });                             // OpVariable
+	emitOp(words, 30, { ID_UNIFORM_BLOCK_TYPE, ID_VEC4 });                            // OpTypeStruct
+	emitOp(words, 32, { ID_UNIFORM_BLOCK_PTR, 2, ID_UNIFORM_BLOCK_TYPE });            // OpTypePointer
+	emitOp(words, 59, { ID_UNIFORM_BLOCK_PTR, ID_UNIFORM_BLOCK, 2 });                 // OpVariable
+	emitOp(words, 32, { ID_UNIFORM_VEC4_PTR, 2, ID_VEC4 });                           // OpTypePointer
+	emitOp(words, 29, { ID_OBJECT_ARRAY, ID_VEC4 });                                  // OpTypeRuntimeArray
+	emitOp(words, 30, { ID_OBJECT_BUFFER_TYPE, ID_OBJECT_ARRAY });                    // OpTypeStruct
+	emitOp(words, 32, { ID_OBJECT_BUFFER_PTR, 2, ID_OBJECT_BUFFER_TYPE });            // OpTypePointer
+	emitOp(words, 59, { ID_OBJECT_BUFFER_PTR, ID_OBJECT_BUFFER, 2 });                 // OpVariable
+	emitOp(words, 30, { ID_ROOT_CONSTANT_TYPE, ID_UINT });                            // OpTypeStruct
+	emitOp(words, 32, { ID_ROOT_CONSTANT_PTR, 9, ID_ROOT_CONSTANT_TYPE });            // OpTypePointer
+	emitOp(words, 59, { ID_ROOT_CONSTANT_PTR, ID_ROOT_CONSTANT, 9 });                 // OpVariable
+	emitOp(words, 32, { ID_PUSH_UINT_PTR, 9, ID_UINT });                              // OpTypePointer
+
+	// main, OpAccessChain (65) and OpLoad (61) of every resource
+	emitOp(words, 54, { ID_VOID, ID_MAIN, 0, ID_FUNCTION_TYPE });                     // OpFunction
+	emitOp(words, 248, { ID_LABEL });                                                 // OpLabel
+	emitOp(words, 65, { ID_IMAGE_PTR, ID_TEXTURE_ELEMENT, ID_TEXTURES, ID_INT_0 });
+	emitOp(words, 61, { ID_IMAGE, ID_TEXTURE_VALUE, ID_TEXTURE_ELEMENT });
+	emitOp(words, 61, { ID_SAMPLER_TYPE, ID_SAMPLER_VALUE, ID_SAMPLER });
+	emitOp(words, 65, { ID_UNIFORM_VEC4_PTR, ID_UNIFORM_ELEMENT, ID_UNIFORM_BLOCK, ID_INT_0 });
+	emitOp(words, 61, { ID_VEC4, ID_UNIFORM_VALUE, ID_UNIFORM_ELEMENT });
+	emitOp(words, 65, { ID_UNIFORM_VEC4_PTR, ID_OBJECT_ELEMENT, ID_OBJECT_BUFFER, ID_INT_0, ID_INT_0 });
+	emitOp(words, 61, { ID_VEC4, ID_OBJECT_VALUE, ID_OBJECT_ELEMENT });
+	emitOp(words, 65, { ID_PUSH_UINT_PTR, ID_ROOT_CONSTANT_ELEMENT, ID_ROOT_CONSTANT, ID_INT_0 });
+	emitOp(words, 61, { ID_UINT, ID_ROOT_CONSTANT_VALUE, ID_ROOT_CONSTANT_ELEMENT });
+	emitOp(words, 253, {});                                                           // OpReturn
+	emitOp(words, 56, {});                                                            // OpFunctionEnd
+}
+
+static void addBenchmarkShader(Renderer* pRenderer, bool compute, Shader** ppShader)
+{
+	eastl::vector<uint32_t> words;
+	buildShader(compute, words);
+
+	BinaryShaderDesc       desc = {};
+	BinaryShaderStageDesc* pStage = compute ? &desc.mComp : &desc.mFrag;
+	desc.mStages = compute ? SHADER_STAGE_COMP : SHADER_STAGE_FRAG;
+	pStage->pByteCode = (char*)words.data();
+	pStage->mByteCodeSize = (uint32_t)(words.size() * sizeof(uint32_t));
+	pStage->mEntryPoint = "main";
+	addShaderBinary(pRenderer, &desc, ppShader);
+}
+
+/************************************************************************/
+// Command stream inspection
+/************************************************************************/
+// Payload of the last recorded command of the given type, NULL if there is none
+static const void* findLastCmd(const Cmd* pCmd, NullCmdType type)
+{
+	const void*    pFound = NULL;
+	const uint8_t* pStream = pCmd->pCmdStream;
+	const uint8_t* pStreamEnd = pCmd->pCmdStream + pCmd->mCmdStreamSize;
+	while (pStream < pStreamEnd)
+	{
+		const NullCmdHeader* pHeader = (const NullCmdHeader*)pStream;
+		if (pHeader->mType == (uint32_t)type)
+			pFound = pHeader + 1;
+		pStream += sizeof(NullCmdHeader) + pHeader->mSize;
+	}
+	return pFound;
+}
+
+/************************************************************************/
+// Benchmarks
+/************************************************************************/
+struct Context
+{
+	Renderer*         pRenderer;
+	Queue*            pQueue;
+	CmdPool*          pCmdPool;
+	Cmd*              pCmd;
+	Fence*            pFence;
+	Shader*           pComputeShader;
+	Shader*           pUIShader;
+	RootSignature*    pComputeRootSignature;
+	RootSignature*    pUIRootSignature;
+	DescriptorBinder* pComputeBinder;
+	DescriptorBinder* pUIBinder;
+	Pipeline*         pComputePipeline;
+	Pipeline*         pUIPipeline;
+	Texture*          pTextures[TEXTURE_COUNT];
+	Sampler*          pSampler;
+	Buffer*           pUniformBuffer;
+	Buffer*           pObjectBuffer;
+	RenderTarget*     pRenderTarget;
+};
+
+static void submitAndWait(Context* pContext)
+{
+	queueSubmit(pContext->pQueue, 1, &pContext->pCmd, pContext->pFence, 0, NULL, 0, NULL);
+	waitForFences(pContext->pRenderer, 1, &pContext->pFence);
+}
+
+struct BindResult
+{
+	double mRecordSeconds;
+	double mReplaySeconds;
+};
+
+// Binds params bindCount times, the root constant and the object offset change every time like they do per draw
+static BindResult runBinds(Context* pContext, uint32_t bindCount, uint32_t paramCount, DescriptorData* pParams, uint32_t* pRootConstant, uint64_t* pObjectOffset)
+{
+	Cmd*       pCmd = pContext->pCmd;
+	BindResult result = {};
+	result.mRecordSeconds = measureBestSeconds(3, [&]() {
+		beginCmd(pCmd);
+		cmdBindPipeline(pCmd, pContext->pComputePipeline);
+		for (uint32_t i = 0; i < bindCount; ++i)
+		{
+			*pRootConstant = i;
+			*pObjectOffset = (i % OBJECT_COUNT) * OBJECT_STRIDE;
+			cmdBindDescriptors(pCmd, pContext->pComputeBinder, pContext->pComputeRootSignature, paramCount, pParams);
+		}
+		endCmd(pCmd);
+	});
+	result.mReplaySeconds = measureBestSeconds(3, [&]() { submitAndWait(pContext); });
+
+	// Every bind made it into the stream, the last one holds the last root constant
+	TEST_CHECK(pCmd->mCmdCount == bindCount + 1);
+	const NullBindDescriptorsCmd* pBind = (const NullBindDescriptorsCmd*)findLastCmd(pCmd, NULL_CMD_TYPE_cmdBindDescriptors);
+	TEST_CHECK(pBind && pBind->mDescriptorCount == paramCount);
+	bool foundRootConstant = false;
+	const uint8_t* pData = (const uint8_t*)(pBind + 1);
+	for (uint32_t i = 0; pBind && i < pBind->mDescriptorCount; ++i)
+	{
+		const NullDescriptorUpdate* pUpdate = (const NullDescriptorUpdate*)pData;
+		pData += sizeof(NullDescriptorUpdate);
+		if (pUpdate->mRootConstantSize)
+		{
+			foundRootConstant = *(const uint32_t*)pData == bindCount - 1;
+			pData += (pUpdate->mRootConstantSize + 7) & ~7u;
+		}
+		else
+		{
+			pData += pUpdate->mCount * sizeof(uint64_t);
+		}
+	}
+	TEST_CHECK(foundRootConstant);
+	return result;
+}
+
+static void benchmarkBindDescriptors(Context* pContext, uint32_t scale)
+{
+	const uint32_t bindCount = 65536 * scale;
+	uint32_t       rootConstant = 0;
+	uint64_t       objectOffset = 0;
+	uint64_t       uniformOffset = 0;
+
+	// Per draw: the object data and a root constant
+	DescriptorData perDraw[2] = {};
+	perDraw[0].pName = "objectBuffer";
+	perDraw[0].ppBuffers = &pContext->pObjectBuffer;
+	perDraw[0].pOffsets = &objectOffset;
+	perDraw[1].pName = "rootConstant";
+	perDraw[1].pRootConstant = &rootConstant;
+
+	// The same resolved once with getDescriptorIndexFromName
+	DescriptorData perDrawByIndex[2] = {};
+	memcpy(perDrawByIndex, perDraw, sizeof(perDraw));
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		perDrawByIndex[i].mIndex = getDescriptorIndexFromName(pContext->pComputeRootSignature, perDraw[i].pName);
+		perDrawByIndex[i].pName = NULL;
+	}
+
+	// Every frequency at once, as after a pipeline change
+	DescriptorData all[5] = {};
+	memcpy(all, perDraw, sizeof(perDraw));
+	all[2].pName = "uniformBlock";
+	all[2].ppBuffers = &pContext->pUniformBuffer;
+	all[2].pOffsets = &uniformOffset;
+	all[3].pName = "textures";
+	all[3].ppTextures = pContext->pTextures;
+	all[3].mCount = TEXTURE_COUNT;
+	all[4].pName = "defaultSampler";
+	all[4].ppSamplers = &pContext->pSampler;
+
+	struct
+	{
+		const char*     pName;
+		uint32_t        mParamCount;
+		DescriptorData* pParams;
+	} runs[] = {
+		{ "per draw, by name", 2, perDraw },
+		{ "per draw, by index", 2, perDrawByIndex },
+		{ "all frequencies", 5, all },
+	};
+
+	printf("cmdBindDescriptors, %u binds\n", bindCount);
+	printf("%-20s %12s %12s %14s\n", "params", "record ns", "replay ns", "binds/s");
+	for (uint32_t i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i)
+	{
+		BindResult result = runBinds(pContext, bindCount, runs[i].mParamCount, runs[i].pParams, &rootConstant, &objectOffset);
+		printf(
+			"%-20s %12.1f %12.1f %14.0f\n", runs[i].pName, result.mRecordSeconds * 1e9 / bindCount, result.mReplaySeconds * 1e9 / bindCount,
+			bindCount / result.mRecordSeconds);
+	}
+	printf("\n");
+}
+
+static void fillPattern(uint8_t* pData, uint64_t size, uint32_t seed)
+{
+	uint32_t* pWords = (uint32_t*)pData;
+	for (uint64_t i = 0; i < size / 4; ++i)
+		pWords[i] = (uint32_t)i * 2654435761u + seed;
+}
+
+static void benchmarkResourceStreaming(uint32_t scale)
+{
+	const uint32_t bufferCount = 64 * scale;
+	const uint64_t bufferSize = 1 << 20;
+	const uint64_t streamSize = bufferCount * bufferSize;
+	const uint64_t chunkSize = 64 * 1024;
+
+	uint8_t* pSource = (uint8_t*)conf_malloc((size_t)streamSize);
+	fillPattern(pSource, streamSize, 1);
+
+	// Many GPU buffers created with initial data, like a level load
+	eastl::vector<Buffer*> buffers(bufferCount);
+	double                 addSeconds = 1e9;
+	for (uint32_t run = 0; run < 3; ++run)
+	{
+		addSeconds = eastl::min(addSeconds, measureSeconds([&]() {
+			for (uint32_t i = 0; i < bufferCount; ++i)
+			{
+				BufferLoadDesc desc = {};
+				desc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+				desc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+				desc.mDesc.mSize = bufferSize;
+				desc.mDesc.mElementCount = bufferSize / OBJECT_STRIDE;
+				desc.mDesc.mStructStride = OBJECT_STRIDE;
+				desc.pData = pSource + i * bufferSize;
+				desc.ppBuffer = &buffers[i];
+				addResource(&desc, true);
+			}
+			waitBatchCompleted();
+		}));
+
+		for (uint32_t i = 0; i < bufferCount; ++i)
+		{
+			TEST_CHECK(memcmp(buffers[i]->pNullMemory, pSource + i * bufferSize, (size_t)bufferSize) == 0);
+			removeResource(buffers[i]);
+		}
+	}
+
+	// One large buffer streamed in chunks, like per frame dynamic data or a streamed mesh
+	Buffer*        pStreamBuffer = NULL;
+	BufferLoadDesc streamDesc = {};
+	streamDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	streamDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	streamDesc.mDesc.mSize = streamSize;
+	streamDesc.mDesc.mElementCount = streamSize / OBJECT_STRIDE;
+	streamDesc.mDesc.mStructStride = OBJECT_STRIDE;
+	streamDesc.ppBuffer = &pStreamBuffer;
+	addResource(&streamDesc);
+
+	double updateSeconds = 1e9;
+	for (uint32_t run = 0; run < 3; ++run)
+	{
+		fillPattern(pSource, streamSize, run + 2);
+		updateSeconds = eastl::min(updateSeconds, measureSeconds([&]() {
+			for (uint64_t offset = 0; offset < streamSize; offset += chunkSize)
+			{
+				BufferUpdateDesc update(pStreamBuffer, pSource, offset, offset, chunkSize);
+				updateResource(&update, true);
+			}
+			waitBatchCompleted();
+		}));
+		TEST_CHECK(memcmp(pStreamBuffer->pNullMemory, pSource, (size_t)streamSize) == 0);
+	}
+	removeResource(pStreamBuffer);
+	conf_free(pSource);
+
+	printf("Resource loader, %.0f MB\n", streamSize / 1048576.0);
+	printf("%-32s %10s %10s\n", "path", "ms", "MB/s");
+	printf("%-32s %10.2f %10.0f\n", "addResource 1 MB buffers", addSeconds * 1e3, streamSize / addSeconds / 1048576.0);
+	printf("%-32s %10.2f %10.0f\n", "updateResource 64 KB chunks", updateSeconds * 1e3, streamSize / updateSeconds / 1048576.0);
+	printf("\n");
+}
+
+static void benchmarkUISubmission(Context* pContext, uint32_t scale)
+{
+	// A busy debug UI: a few windows with many widgets, one draw command each
+	const uint32_t drawCount = 2048 * scale;
+	const uint32_t vertexStride = 20;
+
+	Buffer*        pVertexBuffer = NULL;
+	Buffer*        pIndexBuffer = NULL;
+	BufferLoadDesc vbDesc = {};
+	vbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+	vbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	vbDesc.mDesc.mSize = drawCount * 4 * vertexStride;
+	vbDesc.mDesc.mVertexStride = vertexStride;
+	vbDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	vbDesc.ppBuffer = &pVertexBuffer;
+	addResource(&vbDesc);
+	BufferLoadDesc ibDesc = vbDesc;
+	ibDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
+	ibDesc.mDesc.mSize = drawCount * 6 * sizeof(uint16_t);
+	ibDesc.mDesc.mIndexType = INDEX_TYPE_UINT16;
+	ibDesc.ppBuffer = &pIndexBuffer;
+	addResource(&ibDesc);
+
+	eastl::vector<uint8_t>  vertices((size_t)vbDesc.mDesc.mSize);
+	eastl::vector<uint16_t> indices(drawCount * 6);
+	for (uint32_t i = 0; i < drawCount; ++i)
+	{
+		const uint16_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+		for (uint32_t j = 0; j < 6; ++j)
+			indices[i * 6 + j] = (uint16_t)(quad[j] + (i * 4) % 65532);
+	}
+	fillPattern(vertices.data(), vertices.size(), 7);
+
+	Cmd*     pCmd = pContext->pCmd;
+	uint64_t uniformOffset = 0;
+	double   recordSeconds = 1e9;
+	double   submitSeconds = 1e9;
+	for (uint32_t frame = 0; frame < 16; ++frame)
+	{
+		recordSeconds = eastl::min(recordSeconds, measureSeconds([&]() {
+			// The draw lists are copied to the mapped buffers every frame
+			BufferUpdateDesc update(pVertexBuffer, vertices.data(), 0, 0, vertices.size());
+			updateResource(&update);
+			update = BufferUpdateDesc(pIndexBuffer, indices.data(), 0, 0, indices.size() * sizeof(uint16_t));
+			updateResource(&update);
+
+			beginCmd(pCmd);
+			cmdBindRenderTargets(pCmd, 1, &pContext->pRenderTarget, NULL, NULL, NULL, NULL, -1, -1);
+			cmdSetViewport(pCmd, 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f);
+			cmdBindPipeline(pCmd, pContext->pUIPipeline);
+			cmdBindIndexBuffer(pCmd, pIndexBuffer, 0);
+			uint64_t vertexOffset = 0;
+			cmdBindVertexBuffer(pCmd, 1, &pVertexBuffer, &vertexOffset);
+
+			DescriptorData params[1] = {};
+			params[0].pName = "uniformBlock";
+			params[0].pOffsets = &uniformOffset;
+			params[0].ppBuffers = &pContext->pUniformBuffer;
+			cmdBindDescriptors(pCmd, pContext->pUIBinder, pContext->pUIRootSignature, 1, params);
+
+			for (uint32_t i = 0; i < drawCount; ++i)
+			{
+				cmdSetScissor(pCmd, (i * 37) % 1800, (i * 11) % 1000, 120, 24);
+				params[0] = {};
+				params[0].pName = "textures";
+				params[0].ppTextures = &pContext->pTextures[i % TEXTURE_COUNT];
+				cmdBindDescriptors(pCmd, pContext->pUIBinder, pContext->pUIRootSignature, 1, params);
+				cmdDrawIndexed(pCmd, 6, i * 6, 0);
+			}
+			cmdBindRenderTargets(pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+			endCmd(pCmd);
+		}));
+		submitSeconds = eastl::min(submitSeconds, measureSeconds([&]() { submitAndWait(pContext); }));
+	}
+
+	// Render targets, viewport, pipeline, buffers, uniforms, then scissor, texture and draw per widget, then the unbind
+	TEST_CHECK(pCmd->mCmdCount == 6 + drawCount * 3 + 1);
+	const NullDrawIndexedCmd* pDraw = (const NullDrawIndexedCmd*)findLastCmd(pCmd, NULL_CMD_TYPE_cmdDrawIndexed);
+	TEST_CHECK(pDraw && pDraw->mIndexCount == 6 && pDraw->mFirstIndex == (drawCount - 1) * 6);
+	TEST_CHECK(memcmp(pIndexBuffer->pNullMemory, indices.data(), indices.size() * sizeof(uint16_t)) == 0);
+
+	removeResource(pVertexBuffer);
+	removeResource(pIndexBuffer);
+
+	printf("UI frame, %u draw commands\n", drawCount);
+	printf("%-10s %10s %12s\n", "step", "us/frame", "ns/draw");
+	printf("%-10s %10.1f %12.1f\n", "record", recordSeconds * 1e6, recordSeconds * 1e9 / drawCount);
+	printf("%-10s %10.1f %12.1f\n", "submit", submitSeconds * 1e6, submitSeconds * 1e9 / drawCount);
+}
+
+// Runs frames requesting mip 0 of pTextures[first, first + count) until they are resident or a few seconds passed
+static bool streamTextures(Texture** ppTextures, uint32_t first, uint32_t count, uint64_t budget)
+{
+	for (uint32_t frame = 0; frame < 5000; ++frame)
+	{
+		for (uint32_t i = first; i < first + count; ++i)
+			requestTextureMips(ppTextures[i], 0);
+		updateTextureStreaming();
+
+		ResourceLoaderStats stats = {};
+		getResourceLoaderStats(&stats);
+		TEST_CHECK(stats.mStreamedTextureBytes <= budget);
+
+		bool resident = true;
+		for (uint32_t i = first; i < first + count; ++i)
+			resident = resident && getTextureResidentMip(ppTextures[i]) == 0;
+		if (resident)
+			return true;
+		Thread::Sleep(1);
+	}
+	return false;
+}
+
+static uint64_t getBytesUploaded()
+{
+	ResourceLoaderStats stats = {};
+	getResourceLoaderStats(&stats);
+	return stats.mBytesUploaded;
+}
+
+static void testTextureStreaming(Renderer* pRenderer)
+{
+	const uint32_t textureCount = 8;
+	const uint32_t size = 512;
+	const uint32_t tailMip = 2;
+
+	Image image;
+	image.Create(ImageFormat::RGBA8, size, size, 1, 1);
+	fillPattern(image.GetPixels(), image.GetMipMappedSize(0, 1), 3);
+	TEST_CHECK(image.GenerateMipMaps());
+	const uint32_t mipCount = image.GetMipMapCount();
+	const uint64_t chainSize = image.GetMipMappedSize(0, mipCount);
+	const uint64_t tailSize = image.GetMipMappedSize(tailMip, mipCount - tailMip);
+	eastl::string  fileName = getTestDirectory("NullRendererBenchmark") + "Streamed.dds";
+	TEST_CHECK(image.iSaveDDS(fileName.c_str()));
+
+	// Loads with a max size skip the larger levels in the file
+	Image tail;
+	tail.SetMaxLoadSize(128);
+	TEST_CHECK(tail.loadImage(fileName.c_str(), NULL, NULL, FSR_Absolute));
+	TEST_CHECK(tail.GetSkippedMipCount() == tailMip);
+	TEST_CHECK(tail.GetSourceWidth() == size && tail.GetWidth() == size >> tailMip);
+	TEST_CHECK(tail.GetMipMapCount() == mipCount - tailMip);
+	TEST_CHECK(memcmp(tail.GetPixels(), image.GetPixels(tailMip), (size_t)tailSize) == 0);
+	tail.Destroy();
+	image.Destroy();
+
+	// Room for the mip tails and two fully resident textures, which keep their tail textures for evictions
+	const uint64_t     budget = textureCount * tailSize + 2 * chainSize;
+	ResourceLoaderDesc loaderDesc = { 8ull << 20, 2, 4, budget };
+	removeResourceLoaderInterface(pRenderer);
+	initResourceLoaderInterface(pRenderer, &loaderDesc);
+
+	Texture*  pTextures[textureCount] = {};
+	SyncToken token = 0;
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		TextureLoadDesc loadDesc = {};
+		loadDesc.pFilename = fileName.c_str();
+		loadDesc.mRoot = FSR_Absolute;
+		loadDesc.mStreamMips = true;
+		loadDesc.ppTexture = &pTextures[i];
+		addResource(&loadDesc, &token);
+	}
+	waitTokenCompleted(token);
+
+	ResourceLoaderStats stats = {};
+	getResourceLoaderStats(&stats);
+	TEST_CHECK(stats.mStreamedTextureBytes == textureCount * tailSize);
+	for (uint32_t i = 0; i < textureCount; ++i)
+		TEST_CHECK(getTextureResidentMip(pTextures[i]) == tailMip);
+
+	uint64_t uploaded = getBytesUploaded();
+	TEST_CHECK(streamTextures(pTextures, 0, 2, budget));
+	const uint64_t firstUpload = getBytesUploaded() - uploaded;
+
+	// Two other textures only fit once the first two are evicted, which swaps their tails back in and uploads nothing
+	uploaded = getBytesUploaded();
+	TEST_CHECK(streamTextures(pTextures, 2, 2, budget));
+	TEST_CHECK(getBytesUploaded() - uploaded == firstUpload);
+	TEST_CHECK(getTextureResidentMip(pTextures[0]) == tailMip && getTextureResidentMip(pTextures[1]) == tailMip);
+
+	uploaded = getBytesUploaded();
+	evictTextureMips(pTextures[2], 1);
+	updateTextureStreaming();
+	TEST_CHECK(getTextureResidentMip(pTextures[2]) == tailMip);
+	getResourceLoaderStats(&stats);
+	TEST_CHECK(stats.mStreamedTextureBytes == textureCount * tailSize + chainSize);
+	TEST_CHECK(stats.mBytesUploaded == uploaded);
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+		removeResource(pTextures[i]);
+	getResourceLoaderStats(&stats);
+	TEST_CHECK(stats.mStreamedTextureBytes == 0);
+
+	removeResourceLoaderInterface(pRenderer);
+	initResourceLoaderInterface(pRenderer);
+	FileSystem::Delete(fileName);
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t scale = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1;
+	if (!scale)
+		scale = 1;
+
+	Context        context = {};
+	Context*       pContext = &context;
+	RendererDesc   settings = {};
+	initRenderer("NullRendererBenchmark", &settings, &pContext->pRenderer);
+	TEST_CHECK(pContext->pRenderer);
+	if (!pContext->pRenderer)
+		return testResult("NullRendererBenchmark");
+	Renderer* pRenderer = pContext->pRenderer;
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	addFence(pRenderer, &pContext->pFence);
+	initResourceLoaderInterface(pRenderer);
+
+	// One root signature per pipeline type, both reflected from the same resource layout
+	addBenchmarkShader(pRenderer, true, &pContext->pComputeShader);
+	addBenchmarkShader(pRenderer, false, &pContext->pUIShader);
+	TEST_CHECK(pContext->pComputeShader->mReflection.mShaderResourceCount == 5);
+
+	RootSignatureDesc rootDesc = {};
+	rootDesc.mShaderCount = 1;
+	rootDesc.ppShaders = &pContext->pComputeShader;
+	addRootSignature(pRenderer, &rootDesc, &pContext->pComputeRootSignature);
+	rootDesc.ppShaders = &pContext->pUIShader;
+	addRootSignature(pRenderer, &rootDesc, &pContext->pUIRootSignature);
+	TEST_CHECK(pContext->pComputeRootSignature->mDescriptorCount == 5);
+
+	DescriptorBinderDesc binderDesc = { pContext->pComputeRootSignature, 0, 65536 * scale };
+	addDescriptorBinder(pRenderer, 0, 1, &binderDesc, &pContext->pComputeBinder);
+	binderDesc.pRootSignature = pContext->pUIRootSignature;
+	addDescriptorBinder(pRenderer, 0, 1, &binderDesc, &pContext->pUIBinder);
+
+	PipelineDesc pipelineDesc = {};
+	pipelineDesc.mType = PIPELINE_TYPE_COMPUTE;
+	pipelineDesc.mComputeDesc.pShaderProgram = pContext->pComputeShader;
+	pipelineDesc.mComputeDesc.pRootSignature = pContext->pComputeRootSignature;
+	addPipeline(pRenderer, &pipelineDesc, &pContext->pComputePipeline);
+
+	RenderTargetDesc rtDesc = {};
+	rtDesc.mWidth = 1920;
+	rtDesc.mHeight = 1080;
+	rtDesc.mDepth = 1;
+	rtDesc.mArraySize = 1;
+	rtDesc.mMipLevels = 1;
+	rtDesc.mSampleCount = SAMPLE_COUNT_1;
+	rtDesc.mFormat = ImageFormat::RGBA8;
+	addRenderTarget(pRenderer, &rtDesc, &pContext->pRenderTarget);
+
+	ImageFormat::Enum colorFormat = ImageFormat::RGBA8;
+	pipelineDesc = {};
+	pipelineDesc.mType = PIPELINE_TYPE_GRAPHICS;
+	pipelineDesc.mGraphicsDesc.pShaderProgram = pContext->pUIShader;
+	pipelineDesc.mGraphicsDesc.pRootSignature = pContext->pUIRootSignature;
+	pipelineDesc.mGraphicsDesc.pColorFormats = &colorFormat;
+	pipelineDesc.mGraphicsDesc.mRenderTargetCount = 1;
+	pipelineDesc.mGraphicsDesc.mSampleCount = SAMPLE_COUNT_1;
+	pipelineDesc.mGraphicsDesc.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
+	addPipeline(pRenderer, &pipelineDesc, &pContext->pUIPipeline);
+
+	TextureDesc textureDesc = {};
+	textureDesc.mWidth = 64;
+	textureDesc.mHeight = 64;
+	textureDesc.mDepth = 1;
+	textureDesc.mArraySize = 1;
+	textureDesc.mMipLevels = 1;
+	textureDesc.mSampleCount = SAMPLE_COUNT_1;
+	textureDesc.mFormat = ImageFormat::RGBA8;
+	textureDesc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i)
+	{
+		TextureLoadDesc loadDesc = {};
+		loadDesc.pDesc = &textureDesc;
+		loadDesc.ppTexture = &pContext->pTextures[i];
+		addResource(&loadDesc);
+	}
+
+	SamplerDesc samplerDesc = {};
+	addSampler(pRenderer, &samplerDesc, &pContext->pSampler);
+
+	BufferLoadDesc bufferDesc = {};
+	bufferDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bufferDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	bufferDesc.mDesc.mSize = 256;
+	bufferDesc.ppBuffer = &pContext->pUniformBuffer;
+	addResource(&bufferDesc);
+	bufferDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	bufferDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	bufferDesc.mDesc.mSize = OBJECT_COUNT * OBJECT_STRIDE;
+	bufferDesc.mDesc.mElementCount = OBJECT_COUNT;
+	bufferDesc.mDesc.mStructStride = OBJECT_STRIDE;
+	bufferDesc.ppBuffer = &pContext->pObjectBuffer;
+	addResource(&bufferDesc);
+
+	benchmarkBindDescriptors(pContext, scale);
+	benchmarkResourceStreaming(scale);
+	benchmarkUISubmission(pContext, scale);
+	testTextureStreaming(pRenderer);
+
+	removeResource(pContext->pObjectBuffer);
+	removeResource(pContext->pUniformBuffer);
+	removeSampler(pRenderer, pContext->pSampler);
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i)
+		removeResource(pContext->pTextures[i]);
+	removeRenderTarget(pRenderer, pContext->pRenderTarget);
+	removePipeline(pRenderer, pContext->pUIPipeline);
+	removePipeline(pRenderer, pContext->pComputePipeline);
+	removeDescriptorBinder(pRenderer, pContext->pUIBinder);
+	removeDescriptorBinder(pRenderer, pContext->pComputeBinder);
+	removeRootSignature(pRenderer, pContext->pUIRootSignature);
+	removeRootSignature(pRenderer, pContext->pComputeRootSignature);
+	removeShader(pRenderer, pContext->pUIShader);
+	removeShader(pRenderer, pContext->pComputeShader);
+	removeResourceLoaderInterface(pRenderer);
+	removeFence(pRenderer, pContext->pFence);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeRenderer(pRenderer);
+	return testResult("NullRendererBenchmark");
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Pipeline creation time with the persistent Vulkan pipeline cache disabled, cold (no cache file) and warm (the file saved
+// by the cold run). Creation goes through the renderer's VkPipelineCache, hits are counted with VK_EXT_pipeline_creation_feedback
+// when the driver has it. Runs on any Vulkan driver, the software rasterizer lavapipe is enough.
+// Exits with 77, which ctest reports as skipped, when there is no Vulkan device.
+//
+// Usage: PipelineCacheBenchmark [pipeline count]
+//   count  Number of distinct compute pipelines, at most and by default 128
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "EASTL/vector.h"
+
+#include "IRenderer.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+extern VkPipelineCache get_vk_pipeline_cache(Renderer* pRenderer);
+
+#define SKIP_RETURN_CODE 77
+// Every local size up to 8x4x4, 128 invocations is the smallest maxComputeWorkGroupInvocations a device may report
+#define MAX_PIPELINE_COUNT 128
+
+static const char* gAppName = "PipelineCacheBenchmark";
+
+// Empty compute shader, the local size makes every pipeline distinct
+static void buildComputeShader(uint32_t index, eastl::vector<uint32_t>& words)
+{
+	const uint32_t x = 1 + index % 8;
+	const uint32_t y = 1 + index / 8 % 4;
+	const uint32_t z = 1 + index / 32 % 4;
+	const uint32_t spirv[] = {
+		0x07230203, 0x00010000, 0, 5, 0,                  // Header, bound 5
+		(2 << 16) | 17, 1,                                // OpCapability Shader
+		(3 << 16) | 14, 0, 1,                             // OpMemoryModel Logical GLSL450
+		(5 << 16) | 15, 5, 3, 0x6E69616D, 0,              // OpEntryPoint GLCompute %3 "main"
+		(6 << 16) | 16, 3, 17, x, y, z,                   // OpExecutionMode %3 LocalSize x y z
+		(2 << 16) | 19, 1,                                // %1 = OpTypeVoid
+		(3 << 16) | 33, 2, 1,                             // %2 = OpTypeFunction %1
+		(5 << 16) | 54, 1, 3, 0, 2,                       // %3 = OpFunction %1 None %2
+		(2 << 16) | 248, 4,                               // %4 = OpLabel
+		(1 << 16) | 253,                                  // OpReturn
+		(1 << 16) | 56,                                   // OpFunctionEnd
+	};
+	words.assign(spirv, spirv + sizeof(spirv) / sizeof(spirv[0]));
+}
+
+#ifdef VK_EXT_pipeline_creation_feedback
+static bool hasDeviceExtension(Renderer* pRenderer, const char* pName)
+{
+	for (uint32_t i = 0; i < MAX_DEVICE_EXTENSIONS && pRenderer->gVkDeviceExtensions[i]; ++i)
+	{
+		if (strcmp(pRenderer->gVkDeviceExtensions[i], pName) == 0)
+			return true;
+	}
+	return false;
+}
+#endif
+
+struct RunResult
+{
+	double   mSeconds;
+	uint32_t mHits;
+	bool     mFeedback;
+};
+
+// Creates count compute pipelines on a fresh renderer, removing the renderer saves the cache
+static bool runPipelines(bool disableCache, uint32_t count, RunResult* pResult)
+{
+	RendererDesc settings = {};
+	settings.mDisablePipelineCache = disableCache;
+#ifdef VK_EXT_pipeline_creation_feedback
+	settings.mDeviceExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+#endif
+
+	Renderer* pRenderer = NULL;
+	initRenderer(gAppName, &settings, &pRenderer);
+	if (!pRenderer)
+		return false;
+
+	*pResult = {};
+#ifdef VK_EXT_pipeline_creation_feedback
+	pResult->mFeedback = hasDeviceExtension(pRenderer, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+#endif
+
+	VkDevice device = pRenderer->pVkDevice;
+
+	// Shader modules and the layout are not part of what the cache saves, create them up front
+	eastl::vector<VkShaderModule> modules(count);
+	eastl::vector<VkPipeline>     pipelines(count);
+	eastl::vector<uint32_t>       words;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		buildComputeShader(i, words);
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = words.size() * sizeof(uint32_t);
+		moduleInfo.pCode = words.data();
+		TEST_CHECK(vkCreateShaderModule(device, &moduleInfo, NULL, &modules[i]) == VK_SUCCESS);
+	}
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	TEST_CHECK(vkCreatePipelineLayout(device, &layoutInfo, NULL, &layout) == VK_SUCCESS);
+
+	pResult->mSeconds = measureSeconds([&]() {
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			VkComputePipelineCreateInfo pipelineInfo = {};
+			pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineInfo.stage.module = modules[i];
+			pipelineInfo.stage.pName = "main";
+			pipelineInfo.layout = layout;
+
+#ifdef VK_EXT_pipeline_creation_feedback
+			VkPipelineCreationFeedbackEXT feedback = {};
+			VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo = {};
+			feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+			feedbackInfo.pPipelineCreationFeedback = &feedback;
+			if (pResult->mFeedback)
+				pipelineInfo.pNext = &feedbackInfo;
+#endif
+
+			// Same cache addComputePipeline uses on this thread
+			TEST_CHECK(
+				vkCreateComputePipelines(device, get_vk_pipeline_cache(pRenderer), 1, &pipelineInfo, NULL, &pipelines[i]) == VK_SUCCESS);
+
+#ifdef VK_EXT_pipeline_creation_feedback
+			if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) &&
+				(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT))
+				++pResult->mHits;
+#endif
+		}
+	});
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		vkDestroyPipeline(device, pipelines[i], NULL);
+		vkDestroyShaderModule(device, modules[i], NULL);
+	}
+	vkDestroyPipelineLayout(device, layout, NULL);
+
+	removeRenderer(pRenderer);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : MAX_PIPELINE_COUNT;
+	if (!count || count > MAX_PIPELINE_COUNT)
+		count = MAX_PIPELINE_COUNT;
+
+	// Mesa keeps its own on-disk shader cache, it would turn the cold run warm
+	setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+
+	// Same directory add_pipeline_cache picks for this application name
+	eastl::string appDir(gAppName);
+	appDir.make_lower();
+	eastl::string cacheDir = FileSystem::GetProgramDir() + "/" + appDir + "/PipelineCache/";
+	eastl::vector<eastl::string> cacheFiles;
+	FileSystem::GetFilesWithExtension(cacheDir, ".cache", cacheFiles);
+	for (uint32_t i = 0; i < (uint32_t)cacheFiles.size(); ++i)
+		FileSystem::Delete(cacheFiles[i]);
+
+	RunResult disabled = {};
+	if (!runPipelines(true, count, &disabled))
+	{
+		printf("No Vulkan device, skipping\n");
+		return SKIP_RETURN_CODE;
+	}
+
+	RunResult cold = {};
+	RunResult warm = {};
+	TEST_CHECK(runPipelines(false, count, &cold));
+	cacheFiles.clear();
+	FileSystem::GetFilesWithExtension(cacheDir, ".cache", cacheFiles);
+	TEST_CHECK(cacheFiles.size() == 1);
+	TEST_CHECK(runPipelines(false, count, &warm));
+
+	const char* names[] = { "disabled", "cold", "warm" };
+	RunResult*  results[] = { &disabled, &cold, &warm };
+	printf("%u compute pipelines\n", count);
+	printf("%-9s %10s %14s %10s\n", "cache", "ms", "us/pipeline", "hits");
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		char hits[32] = "n/a";
+		if (results[i]->mFeedback)
+			snprintf(hits, sizeof(hits), "%u/%u", results[i]->mHits, count);
+		printf(
+			"%-9s %10.2f %14.1f %10s\n", names[i], results[i]->mSeconds * 1e3, results[i]->mSeconds * 1e6 / count, hits);
+	}
+
+	// Every pipeline of the warm run must come out of the file saved by the cold run
+	if (warm.mFeedback)
+	{
+		TEST_CHECK(cold.mHits == 0);
+		TEST_CHECK(warm.mHits == count);
+	}
+	else
+	{
+		printf("VK_EXT_pipeline_creation_feedback is not available, hits are not counted\n");
+	}
+
+	return testResult("PipelineCacheBenchmark");
+}
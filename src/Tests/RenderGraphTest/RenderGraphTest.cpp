@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Render graph compilation and execution on the Null renderer:
+//  - culling of passes nobody reads from, of writes a later pass overwrites and of read only passes, side effects keep a pass
+//  - split barriers: the begin half right after the last user of the old state when a live pass lies in between
+//  - transient render targets with the same desc and disjoint lifetimes sharing one pooled render target
+// The Null renderer tracks resource states at record time, so the pass callbacks see which barriers were recorded before them.
+
+#include <initializer_list>
+
+#include "IRenderer.h"
+#include "RenderGraph.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+#define PASS_COUNT_MAX 8
+
+struct Context
+{
+	Renderer*     pRenderer;
+	Queue*        pQueue;
+	CmdPool*      pCmdPool;
+	Cmd*          pCmd;
+	Fence*        pFence;
+	RenderTarget* pBackBuffer;
+	RenderTarget* pImage;
+	RenderGraph*  pGraph;
+};
+
+// What a pass callback saw while the graph executed
+struct PassRecord
+{
+	uint32_t            mExecuteCount;
+	RenderGraphResource mResource;
+	RenderTarget*       pRenderTarget;
+	ResourceState       mState;
+};
+
+static void recordPass(Cmd*, RenderGraph* pGraph, void* pUserData)
+{
+	PassRecord* pRecord = (PassRecord*)pUserData;
+	++pRecord->mExecuteCount;
+	if (pRecord->mResource == RENDER_GRAPH_RESOURCE_NONE)
+		return;
+	pRecord->pRenderTarget = getRenderGraphRenderTarget(pGraph, pRecord->mResource);
+	Texture* pTexture = getRenderGraphTexture(pGraph, pRecord->mResource);
+	pRecord->mState = pTexture ? pTexture->mCurrentState : RESOURCE_STATE_UNDEFINED;
+}
+
+static RenderGraphAccess readAccess(RenderGraphResource resource)
+{
+	RenderGraphAccess access = {};
+	access.mResource = resource;
+	access.mState = RESOURCE_STATE_SHADER_RESOURCE;
+	return access;
+}
+
+static RenderGraphAccess writeAccess(RenderGraphResource resource)
+{
+	RenderGraphAccess access = {};
+	access.mResource = resource;
+	access.mState = RESOURCE_STATE_RENDER_TARGET;
+	access.mWrite = true;
+	return access;
+}
+
+static uint32_t addPass(
+	RenderGraph* pGraph, const char* pName, PassRecord* pRecord, std::initializer_list<RenderGraphAccess> accesses, bool sideEffects = false)
+{
+	RenderGraphPassDesc passDesc = {};
+	passDesc.pName = pName;
+	passDesc.pExecute = recordPass;
+	passDesc.pUserData = pRecord;
+	passDesc.pAccesses = (RenderGraphAccess*)accesses.begin();
+	passDesc.mAccessCount = (uint32_t)accesses.size();
+	passDesc.mSideEffects = sideEffects;
+	return addRenderGraphPass(pGraph, &passDesc);
+}
+
+static RenderGraphResource importRenderTarget(RenderGraph* pGraph, RenderTarget* pRenderTarget, ResourceState state, const char* pName)
+{
+	RenderGraphImportDesc importDesc = {};
+	importDesc.pRenderTarget = pRenderTarget;
+	importDesc.mInitialState = state;
+	importDesc.mFinalState = state;
+	importDesc.pName = pName;
+	return importRenderGraphResource(pGraph, &importDesc);
+}
+
+static void executeGraph(Context* pContext)
+{
+	beginCmd(pContext->pCmd);
+	executeRenderGraph(pContext->pGraph, pContext->pCmd);
+	endCmd(pContext->pCmd);
+}
+
+// Barriers of a resource in the order they are recorded
+static uint32_t findBarriers(const RenderGraph* pGraph, RenderGraphResource resource, const RenderGraphBarrier** ppFound, uint32_t maxCount)
+{
+	const RenderGraphBarrier* pBarriers = NULL;
+	uint32_t                  barrierCount = 0;
+	getRenderGraphBarriers(pGraph, &pBarriers, &barrierCount);
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < barrierCount; ++i)
+	{
+		if (pBarriers[i].mResource == resource && count < maxCount)
+			ppFound[count++] = &pBarriers[i];
+	}
+	return count;
+}
+
+static RenderTargetDesc getTransientDesc(uint32_t width, uint32_t height)
+{
+	RenderTargetDesc rtDesc = {};
+	rtDesc.mWidth = width;
+	rtDesc.mHeight = height;
+	rtDesc.mDepth = 1;
+	rtDesc.mArraySize = 1;
+	rtDesc.mMipLevels = 1;
+	rtDesc.mSampleCount = SAMPLE_COUNT_1;
+	rtDesc.mFormat = ImageFormat::RGBA8;
+	rtDesc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+	return rtDesc;
+}
+
+/************************************************************************/
+// Tests
+/************************************************************************/
+static void testCulling(Context* pContext)
+{
+	RenderGraph* pGraph = pContext->pGraph;
+	resetRenderGraph(pGraph);
+
+	RenderTargetDesc    rtDesc = getTransientDesc(256, 256);
+	RenderGraphResource backBuffer = importRenderTarget(pGraph, pContext->pBackBuffer, RESOURCE_STATE_PRESENT, "BackBuffer");
+	RenderGraphResource a = addRenderGraphRenderTarget(pGraph, &rtDesc, "A");
+	RenderGraphResource unused = addRenderGraphRenderTarget(pGraph, &rtDesc, "Unused");
+	RenderGraphResource c = addRenderGraphRenderTarget(pGraph, &rtDesc, "C");
+
+	PassRecord records[PASS_COUNT_MAX] = {};
+	for (uint32_t i = 0; i < PASS_COUNT_MAX; ++i)
+		records[i].mResource = RENDER_GRAPH_RESOURCE_NONE;
+
+	addPass(pGraph, "WriteA", &records[0], { writeAccess(a) });
+	addPass(pGraph, "WriteUnused", &records[1], { writeAccess(unused) });
+	// Overwritten completely by the next pass before anybody reads it
+	addPass(pGraph, "WriteCDead", &records[2], { writeAccess(c) });
+	addPass(pGraph, "WriteC", &records[3], { writeAccess(c) });
+	// Only reads, kept for its side effects (e.g. a readback the graph does not know about)
+	addPass(pGraph, "Readback", &records[4], { readAccess(a) }, true);
+	addPass(pGraph, "Composite", &records[5], { readAccess(a), readAccess(c), writeAccess(backBuffer) });
+	addPass(pGraph, "ReadOnly", &records[6], { readAccess(c) });
+	TEST_CHECK(compileRenderGraph(pGraph));
+
+	const bool expectedCulled[] = { false, true, true, false, false, false, true };
+	for (uint32_t p = 0; p < 7; ++p)
+		TEST_CHECK(isRenderGraphPassCulled(pGraph, p) == expectedCulled[p]);
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, unused) == UINT32_MAX);
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, a) != UINT32_MAX);
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, c) != UINT32_MAX);
+
+	const RenderGraphBarrier* pFound[4] = {};
+	TEST_CHECK(findBarriers(pGraph, unused, pFound, 4) == 0);
+
+	executeGraph(pContext);
+	for (uint32_t p = 0; p < 7; ++p)
+		TEST_CHECK(records[p].mExecuteCount == (expectedCulled[p] ? 0U : 1U));
+	TEST_CHECK(pContext->pBackBuffer->pTexture->mCurrentState == RESOURCE_STATE_PRESENT);
+}
+
+static void testSplitBarriers(Context* pContext)
+{
+	RenderGraph*     pGraph = pContext->pGraph;
+	RenderTargetDesc rtDesc = getTransientDesc(256, 256);
+
+	for (uint32_t liveBetween = 0; liveBetween < 2; ++liveBetween)
+	{
+		resetRenderGraph(pGraph);
+		RenderGraphResource backBuffer = importRenderTarget(pGraph, pContext->pBackBuffer, RESOURCE_STATE_PRESENT, "BackBuffer");
+		RenderGraphImportDesc importDesc = {};
+		importDesc.pRenderTarget = pContext->pImage;
+		importDesc.mInitialState = RESOURCE_STATE_RENDER_TARGET;
+		importDesc.mFinalState = RESOURCE_STATE_SHADER_RESOURCE;
+		importDesc.pName = "Image";
+		RenderGraphResource image = importRenderGraphResource(pGraph, &importDesc);
+		RenderGraphResource other = addRenderGraphRenderTarget(pGraph, &rtDesc, "Other");
+
+		PassRecord records[3] = {};
+		for (uint32_t i = 0; i < 3; ++i)
+			records[i].mResource = image;
+
+		addPass(pGraph, "DrawImage", &records[0], { writeAccess(image) });
+		// Does not touch the image, culled unless the last pass reads its output
+		addPass(pGraph, "DrawOther", &records[1], { writeAccess(other) });
+		if (liveBetween)
+			addPass(pGraph, "Sample", &records[2], { readAccess(image), readAccess(other), writeAccess(backBuffer) });
+		else
+			addPass(pGraph, "Sample", &records[2], { readAccess(image), writeAccess(backBuffer) });
+		TEST_CHECK(compileRenderGraph(pGraph));
+		TEST_CHECK(isRenderGraphPassCulled(pGraph, 1) == !liveBetween);
+
+		const RenderGraphBarrier* pFound[4] = {};
+		const uint32_t            count = findBarriers(pGraph, image, pFound, 4);
+		if (liveBetween)
+		{
+			// Begin half right after DrawImage, end half right before Sample
+			TEST_CHECK(count == 2);
+			if (count == 2)
+			{
+				TEST_CHECK(pFound[0]->mType == RENDER_GRAPH_BARRIER_BEGIN && pFound[0]->mPass == 1);
+				TEST_CHECK(pFound[1]->mType == RENDER_GRAPH_BARRIER_END && pFound[1]->mPass == 2);
+				for (uint32_t i = 0; i < 2; ++i)
+				{
+					TEST_CHECK(pFound[i]->mOldState == RESOURCE_STATE_RENDER_TARGET);
+					TEST_CHECK(pFound[i]->mNewState == RESOURCE_STATE_SHADER_RESOURCE);
+					TEST_CHECK(!pFound[i]->mSubresource);
+				}
+			}
+
+			// First use from undefined, then read right after the pass writing it, nothing to overlap the transitions with
+			TEST_CHECK(findBarriers(pGraph, other, pFound, 4) == 2);
+			TEST_CHECK(pFound[0]->mType == RENDER_GRAPH_BARRIER_FULL && pFound[0]->mOldState == RESOURCE_STATE_UNDEFINED);
+			TEST_CHECK(pFound[1]->mType == RENDER_GRAPH_BARRIER_FULL && pFound[1]->mPass == 2);
+		}
+		else
+		{
+			TEST_CHECK(count == 1);
+			if (count == 1)
+				TEST_CHECK(pFound[0]->mType == RENDER_GRAPH_BARRIER_FULL && pFound[0]->mPass == 2);
+		}
+
+		executeGraph(pContext);
+		TEST_CHECK(records[0].mState == RESOURCE_STATE_RENDER_TARGET);
+		// The begin half is recorded before DrawOther already
+		TEST_CHECK(records[1].mExecuteCount == liveBetween);
+		if (liveBetween)
+			TEST_CHECK(records[1].mState == RESOURCE_STATE_SHADER_RESOURCE);
+		TEST_CHECK(records[2].mState == RESOURCE_STATE_SHADER_RESOURCE);
+		TEST_CHECK(pContext->pImage->pTexture->mCurrentState == RESOURCE_STATE_SHADER_RESOURCE);
+		TEST_CHECK(pContext->pBackBuffer->pTexture->mCurrentState == RESOURCE_STATE_PRESENT);
+
+		// Leave the image the way the next iteration imports it
+		pContext->pImage->pTexture->mCurrentState = RESOURCE_STATE_RENDER_TARGET;
+	}
+}
+
+static void testTransientAliasing(Context* pContext)
+{
+	RenderGraph* pGraph = pContext->pGraph;
+	resetRenderGraph(pGraph);
+
+	RenderTargetDesc    rtDesc = getTransientDesc(256, 256);
+	RenderTargetDesc    halfDesc = getTransientDesc(128, 128);
+	RenderGraphResource backBuffer = importRenderTarget(pGraph, pContext->pBackBuffer, RESOURCE_STATE_PRESENT, "BackBuffer");
+	RenderGraphResource a = addRenderGraphRenderTarget(pGraph, &rtDesc, "A");
+	RenderGraphResource b = addRenderGraphRenderTarget(pGraph, &rtDesc, "B");
+	RenderGraphResource c = addRenderGraphRenderTarget(pGraph, &rtDesc, "C");
+	RenderGraphResource half = addRenderGraphRenderTarget(pGraph, &halfDesc, "Half");
+
+	// Lifetimes: A [0, 1], B [1, 2], C [2, 3], Half [0, 3]. Only A and C are disjoint
+	PassRecord records[4] = {};
+	records[0].mResource = a;
+	records[1].mResource = b;
+	records[2].mResource = c;
+	records[3].mResource = backBuffer;
+	addPass(pGraph, "A", &records[0], { writeAccess(a), writeAccess(half) });
+	addPass(pGraph, "B", &records[1], { readAccess(a), writeAccess(b) });
+	addPass(pGraph, "C", &records[2], { readAccess(b), writeAccess(c) });
+	addPass(pGraph, "Composite", &records[3], { readAccess(c), readAccess(half), writeAccess(backBuffer) });
+	TEST_CHECK(compileRenderGraph(pGraph));
+
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, a) == getRenderGraphPhysicalIndex(pGraph, c));
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, a) != getRenderGraphPhysicalIndex(pGraph, b));
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, half) != getRenderGraphPhysicalIndex(pGraph, a));
+	TEST_CHECK(getRenderGraphPhysicalIndex(pGraph, half) != getRenderGraphPhysicalIndex(pGraph, b));
+
+	const uint64_t        fullSize = 256 * 256 * 4;
+	const uint64_t        halfSize = 128 * 128 * 4;
+	RenderGraphMemoryPlan plan = {};
+	getRenderGraphMemoryPlan(pGraph, &plan);
+	TEST_CHECK(plan.mPhysicalRenderTargetCount == 3);
+	TEST_CHECK(plan.mTransientSize == 3 * fullSize + halfSize);
+	TEST_CHECK(plan.mAliasedSize == 2 * fullSize + halfSize);
+
+	// C takes over the render target A was read from, the transition starts from A's last state instead of undefined
+	const RenderGraphBarrier* pFound[4] = {};
+	TEST_CHECK(findBarriers(pGraph, c, pFound, 4) >= 1);
+	TEST_CHECK(pFound[0] && pFound[0]->mPass == 2 && pFound[0]->mOldState == RESOURCE_STATE_SHADER_RESOURCE);
+	TEST_CHECK(pFound[0] && pFound[0]->mNewState == RESOURCE_STATE_RENDER_TARGET);
+
+	// Transient render targets are bound to pooled render targets by the first execution
+	TEST_CHECK(getRenderGraphRenderTarget(pGraph, a) == NULL);
+
+	executeGraph(pContext);
+	TEST_CHECK(records[0].pRenderTarget && records[0].pRenderTarget == records[2].pRenderTarget);
+	TEST_CHECK(records[1].pRenderTarget && records[1].pRenderTarget != records[0].pRenderTarget);
+	for (uint32_t p = 0; p < 3; ++p)
+		TEST_CHECK(records[p].mState == RESOURCE_STATE_RENDER_TARGET);
+	TEST_CHECK(records[3].pRenderTarget == pContext->pBackBuffer);
+
+	// The pooled render targets are reused by the next frame and by a recompiled graph
+	RenderTarget* pFirstFrame[3] = { records[0].pRenderTarget, records[1].pRenderTarget, records[2].pRenderTarget };
+	executeGraph(pContext);
+	for (uint32_t p = 0; p < 3; ++p)
+		TEST_CHECK(records[p].pRenderTarget == pFirstFrame[p]);
+	TEST_CHECK(compileRenderGraph(pGraph));
+	executeGraph(pContext);
+	for (uint32_t p = 0; p < 3; ++p)
+		TEST_CHECK(records[p].pRenderTarget == pFirstFrame[p]);
+}
+
+int main()
+{
+	Log log(LogLevel::eWARNING);
+
+	Context      context = {};
+	Context*     pContext = &context;
+	RendererDesc settings = {};
+	initRenderer("RenderGraphTest", &settings, &pContext->pRenderer);
+	TEST_CHECK(pContext->pRenderer);
+	if (!pContext->pRenderer)
+		return testResult("RenderGraphTest");
+	Renderer* pRenderer = pContext->pRenderer;
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	addFence(pRenderer, &pContext->pFence);
+
+	RenderTargetDesc rtDesc = getTransientDesc(1920, 1080);
+	addRenderTarget(pRenderer, &rtDesc, &pContext->pBackBuffer);
+	pContext->pBackBuffer->pTexture->mCurrentState = RESOURCE_STATE_PRESENT;
+	rtDesc = getTransientDesc(256, 256);
+	addRenderTarget(pRenderer, &rtDesc, &pContext->pImage);
+	addRenderGraph(pRenderer, &pContext->pGraph);
+
+	testCulling(pContext);
+	testSplitBarriers(pContext);
+	testTransientAliasing(pContext);
+
+	removeRenderGraph(pContext->pGraph);
+	removeRenderTarget(pRenderer, pContext->pImage);
+	removeRenderTarget(pRenderer, pContext->pBackBuffer);
+	removeFence(pRenderer, pContext->pFence);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeRenderer(pRenderer);
+	return testResult("RenderGraphTest");
+}
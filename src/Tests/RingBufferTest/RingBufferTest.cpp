@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Fence aware GPURingBuffer on the Null renderer, whose fences complete a simulated GPU latency after the submission:
+//  - without marked frames the ring wraps like a plain ring buffer and counts the unprotected wraps
+//  - an allocation overrunning a frame in flight waits for its fence, one whose fence completed is reused right away
+//  - with more than one page the ring chains new pages instead of waiting, up to the max page count
+//  - the stats report the peak usage, frames in flight, pages and stalls
+
+#include "IRenderer.h"
+#include "ResourceLoader.h"
+#include "OS/Core/RingBuffer.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+// Long enough that nothing completes while a test records, short enough to keep the stalls cheap
+#define GPU_LATENCY_US 250000
+#define PAGE_SIZE 1024
+#define HALF_PAGE (PAGE_SIZE / 2)
+#define FENCE_COUNT 4
+
+struct Context
+{
+	Renderer* pRenderer;
+	Queue*    pQueue;
+	CmdPool*  pCmdPool;
+	Cmd*      pCmd;
+	Fence*    pFences[FENCE_COUNT];
+};
+
+static void addRing(Context* pContext, uint32_t maxPageCount, GPURingBuffer** ppRingBuffer)
+{
+	BufferDesc desc = {};
+	desc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	desc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	desc.mSize = PAGE_SIZE;
+	addGPURingBuffer(pContext->pRenderer, &desc, ppRingBuffer, maxPageCount);
+}
+
+// Submits the frame which consumes everything allocated so far and marks it on the ring
+static void submitFrame(Context* pContext, GPURingBuffer* pRingBuffer, Fence* pFence)
+{
+	beginCmd(pContext->pCmd);
+	endCmd(pContext->pCmd);
+	queueSubmit(pContext->pQueue, 1, &pContext->pCmd, pFence, 0, NULL, 0, NULL);
+	markGPURingBufferFrame(pRingBuffer, pFence);
+}
+
+static bool isFenceComplete(Context* pContext, Fence* pFence)
+{
+	FenceStatus status = FENCE_STATUS_COMPLETE;
+	getFenceStatus(pContext->pRenderer, pFence, &status);
+	return status != FENCE_STATUS_INCOMPLETE;
+}
+
+/************************************************************************/
+// Tests
+/************************************************************************/
+static void testUnprotectedWrap(Context* pContext)
+{
+	GPURingBuffer* pRingBuffer = NULL;
+	addRing(pContext, 1, &pRingBuffer);
+
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		GPURingBufferOffset offset = getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+		TEST_CHECK(offset.pBuffer == pRingBuffer->pBuffer);
+		TEST_CHECK(offset.mOffset == (i % 2) * HALF_PAGE);
+	}
+
+	GPURingBufferStats stats = {};
+	getGPURingBufferStats(pRingBuffer, &stats);
+	TEST_CHECK(stats.mUnsafeWrapCount == 2);
+	TEST_CHECK(stats.mStallCount == 0);
+	TEST_CHECK(stats.mPageCount == 1);
+	TEST_CHECK(stats.mPeakUsage == PAGE_SIZE);
+	removeGPURingBuffer(pRingBuffer);
+}
+
+static void testOverrun(Context* pContext)
+{
+	GPURingBuffer* pRingBuffer = NULL;
+	addRing(pContext, 1, &pRingBuffer);
+	Fence* pFence = pContext->pFences[0];
+
+	getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	submitFrame(pContext, pRingBuffer, pFence);
+	TEST_CHECK(!isFenceComplete(pContext, pFence));
+
+	// The page is full of data the GPU still reads, the allocation has to wait for the frame
+	GPURingBufferOffset offset = getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	TEST_CHECK(offset.pBuffer == pRingBuffer->pBuffer);
+	TEST_CHECK(offset.mOffset == 0);
+	TEST_CHECK(isFenceComplete(pContext, pFence));
+
+	GPURingBufferStats stats = {};
+	getGPURingBufferStats(pRingBuffer, &stats);
+	TEST_CHECK(stats.mStallCount == 1);
+	TEST_CHECK(stats.mStallTimeUs > 0);
+	TEST_CHECK(stats.mUnsafeWrapCount == 0);
+
+	// A frame whose fence completed is released without waiting
+	getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	submitFrame(pContext, pRingBuffer, pFence);
+	waitForFences(pContext->pRenderer, 1, &pFence);
+	offset = getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	TEST_CHECK(offset.mOffset == 0);
+
+	getGPURingBufferStats(pRingBuffer, &stats);
+	TEST_CHECK(stats.mStallCount == 1);
+	TEST_CHECK(stats.mUnsafeWrapCount == 0);
+	TEST_CHECK(stats.mPeakUsage == PAGE_SIZE);
+	TEST_CHECK(stats.mPeakFramesInFlight == 1);
+
+	waitQueueIdle(pContext->pQueue);
+	removeGPURingBuffer(pRingBuffer);
+}
+
+static void testGrowth(Context* pContext)
+{
+	const uint32_t maxPageCount = 3;
+	GPURingBuffer* pRingBuffer = NULL;
+	addRing(pContext, maxPageCount, &pRingBuffer);
+
+	// Every frame fills one page, the next allocation chains a new page while the frames are in flight
+	Buffer* pPageBuffers[maxPageCount] = {};
+	for (uint32_t frame = 0; frame < maxPageCount; ++frame)
+	{
+		GPURingBufferOffset offset = getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+		TEST_CHECK(offset.mOffset == 0);
+		pPageBuffers[frame] = offset.pBuffer;
+		for (uint32_t i = 0; i < frame; ++i)
+			TEST_CHECK(offset.pBuffer != pPageBuffers[i]);
+
+		getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+		submitFrame(pContext, pRingBuffer, pContext->pFences[frame]);
+
+		GPURingBufferStats stats = {};
+		getGPURingBufferStats(pRingBuffer, &stats);
+		TEST_CHECK(stats.mPageCount == frame + 1);
+		TEST_CHECK(stats.mStallCount == 0);
+	}
+	TEST_CHECK(pPageBuffers[0] == pRingBuffer->pBuffer);
+
+	// All pages are in use, the ring waits for the oldest frame and reuses its page
+	GPURingBufferOffset offset = getGPURingBufferOffset(pRingBuffer, HALF_PAGE);
+	TEST_CHECK(isFenceComplete(pContext, pContext->pFences[0]));
+	TEST_CHECK(offset.pBuffer == pPageBuffers[0]);
+	TEST_CHECK(offset.mOffset == 0);
+
+	GPURingBufferStats stats = {};
+	getGPURingBufferStats(pRingBuffer, &stats);
+	TEST_CHECK(stats.mPageCount == maxPageCount);
+	TEST_CHECK(stats.mStallCount == 1);
+	TEST_CHECK(stats.mPeakFramesInFlight == maxPageCount);
+	TEST_CHECK(stats.mPeakUsage == PAGE_SIZE);
+	TEST_CHECK(stats.mUnsafeWrapCount == 0);
+
+	waitQueueIdle(pContext->pQueue);
+	removeGPURingBuffer(pRingBuffer);
+}
+
+int main()
+{
+	Log log(LogLevel::eWARNING);
+
+	Context      context = {};
+	Context*     pContext = &context;
+	RendererDesc settings = {};
+	settings.mSimulatedGpuLatencyUs = GPU_LATENCY_US;
+	initRenderer("RingBufferTest", &settings, &pContext->pRenderer);
+	TEST_CHECK(pContext->pRenderer);
+	if (!pContext->pRenderer)
+		return testResult("RingBufferTest");
+	Renderer* pRenderer = pContext->pRenderer;
+	initResourceLoaderInterface(pRenderer);
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	for (uint32_t i = 0; i < FENCE_COUNT; ++i)
+		addFence(pRenderer, &pContext->pFences[i]);
+
+	testUnprotectedWrap(pContext);
+	testOverrun(pContext);
+	testGrowth(pContext);
+
+	for (uint32_t i = 0; i < FENCE_COUNT; ++i)
+		removeFence(pRenderer, pContext->pFences[i]);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeResourceLoaderInterface(pRenderer);
+	removeRenderer(pRenderer);
+	return testResult("RingBufferTest");
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Secondary command buffers on the Null renderer:
+//  - secondaries recorded in parallel by cmdRecordSecondaryCmds are replayed by the primary in index order, between the
+//    commands the primary recorded before and after them
+//  - a secondary without the render pass of a primary to inherit is rejected, both when it is begun and when it is executed
+// Every recorded step copies the id of the step replayed before it out of a cursor and then writes its own id into the cursor,
+// so the buffer holds the replay order once the primary was submitted.
+
+#include "IRenderer.h"
+#include "ParallelCmd.h"
+#include "OS/Core/ThreadSystem.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+// Not exposed in IRenderer, the resource loader declares them the same way
+extern void addBuffer(Renderer* pRenderer, const BufferDesc* desc, Buffer** pp_buffer);
+extern void removeBuffer(Renderer* pRenderer, Buffer* p_buffer);
+extern void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
+
+#define SECONDARY_COUNT 8
+#define STEP_COUNT_MAX 64
+#define NO_STEP UINT32_MAX
+
+struct Context
+{
+	Renderer*     pRenderer;
+	Queue*        pQueue;
+	CmdPool*      pCmdPool;
+	Cmd*          pCmd;
+	Fence*        pFence;
+	CmdPool*      pSecondaryCmdPools[SECONDARY_COUNT];
+	Cmd*          pSecondaryCmds[SECONDARY_COUNT];
+	RenderTarget* pRenderTarget;
+	ThreadSystem* pThreadSystem;
+	// mIds[i] == i
+	Buffer*       pIdBuffer;
+	// Cursor followed by the id of the step replayed before each step
+	Buffer*       pOrderBuffer;
+	uint32_t      mFirstStep[SECONDARY_COUNT + 1];
+};
+
+static uint32_t* getOrder(Context* pContext) { return (uint32_t*)pContext->pOrderBuffer->pCpuMappedAddress; }
+
+static void recordStep(Context* pContext, Cmd* pCmd, uint32_t step)
+{
+	cmdUpdateBuffer(pCmd, pContext->pOrderBuffer, (1 + step) * sizeof(uint32_t), pContext->pOrderBuffer, 0, sizeof(uint32_t));
+	cmdUpdateBuffer(pCmd, pContext->pOrderBuffer, 0, pContext->pIdBuffer, step * sizeof(uint32_t), sizeof(uint32_t));
+}
+
+static void recordSecondarySteps(Cmd* pCmd, uint32_t index, void* pUserData)
+{
+	Context* pContext = (Context*)pUserData;
+	for (uint32_t step = pContext->mFirstStep[index]; step < pContext->mFirstStep[index + 1]; ++step)
+		recordStep(pContext, pCmd, step);
+}
+
+static void resetOrder(Context* pContext)
+{
+	uint32_t* pOrder = getOrder(pContext);
+	pOrder[0] = NO_STEP;
+	for (uint32_t i = 1; i <= STEP_COUNT_MAX; ++i)
+		pOrder[i] = NO_STEP;
+}
+
+static void submit(Context* pContext)
+{
+	queueSubmit(pContext->pQueue, 1, &pContext->pCmd, pContext->pFence, 0, NULL, 0, NULL);
+	waitForFences(pContext->pRenderer, 1, &pContext->pFence);
+}
+
+static void bindRenderTarget(Context* pContext, bool secondaryCmds)
+{
+	LoadActionsDesc loadActions = {};
+	loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
+	loadActions.mSecondaryCmds = secondaryCmds;
+	cmdBindRenderTargets(pContext->pCmd, 1, &pContext->pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
+}
+
+/************************************************************************/
+// Tests
+/************************************************************************/
+static void testReplayOrder(Context* pContext)
+{
+	// Step 0 is recorded on the primary before the secondaries, the last one after them
+	pContext->mFirstStep[0] = 1;
+	for (uint32_t i = 0; i < SECONDARY_COUNT; ++i)
+		pContext->mFirstStep[i + 1] = pContext->mFirstStep[i] + 1 + (i * 5) % 7;
+	const uint32_t lastStep = pContext->mFirstStep[SECONDARY_COUNT];
+	ASSERT(lastStep < STEP_COUNT_MAX);
+
+	for (uint32_t frame = 0; frame < 32; ++frame)
+	{
+		resetOrder(pContext);
+
+		beginCmd(pContext->pCmd);
+		recordStep(pContext, pContext->pCmd, 0);
+		bindRenderTarget(pContext, true);
+		cmdRecordSecondaryCmds(
+			pContext->pCmd, pContext->pThreadSystem, SECONDARY_COUNT, pContext->pSecondaryCmds, recordSecondarySteps, pContext);
+		cmdBindRenderTargets(pContext->pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+		recordStep(pContext, pContext->pCmd, lastStep);
+		endCmd(pContext->pCmd);
+
+		// Nothing runs before the submit
+		TEST_CHECK(getOrder(pContext)[0] == NO_STEP);
+		submit(pContext);
+
+		const uint32_t* pOrder = getOrder(pContext);
+		TEST_CHECK(pOrder[0] == lastStep);
+		bool inOrder = pOrder[1] == NO_STEP;
+		for (uint32_t step = 1; step <= lastStep; ++step)
+			inOrder = inOrder && pOrder[1 + step] == step - 1;
+		TEST_CHECK(inOrder);
+		if (!inOrder)
+			break;
+	}
+}
+
+static void testRejectedSecondary(Context* pContext)
+{
+	Cmd* pSecondary = pContext->pSecondaryCmds[0];
+
+	// Recorded properly once, a rejected begin afterwards must not leave these commands executable
+	pContext->mFirstStep[0] = 1;
+	pContext->mFirstStep[1] = 2;
+	beginCmd(pContext->pCmd);
+	bindRenderTarget(pContext, true);
+	cmdRecordSecondaryCmds(pContext->pCmd, NULL, 1, &pSecondary, recordSecondarySteps, pContext);
+	cmdBindRenderTargets(pContext->pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+	endCmd(pContext->pCmd);
+	resetOrder(pContext);
+	submit(pContext);
+	TEST_CHECK(getOrder(pContext)[0] == 1);
+
+	for (uint32_t attempt = 0; attempt < 4; ++attempt)
+	{
+		resetOrder(pContext);
+		beginCmd(pContext->pCmd);
+		switch (attempt)
+		{
+			// No render pass on the primary
+			case 0: beginSecondaryCmd(pSecondary, pContext->pCmd); break;
+			// Render pass on the primary recorded by the primary itself
+			case 1:
+				bindRenderTarget(pContext, false);
+				beginSecondaryCmd(pSecondary, pContext->pCmd);
+				break;
+			// Another secondary as the primary
+			case 2:
+				bindRenderTarget(pContext, true);
+				beginSecondaryCmd(pSecondary, pContext->pSecondaryCmds[1]);
+				break;
+			// Begun like a primary, without any inheritance
+			case 3:
+				bindRenderTarget(pContext, true);
+				beginCmd(pSecondary);
+				break;
+		}
+		recordStep(pContext, pSecondary, 3);
+		endCmd(pSecondary);
+
+		const uint32_t cmdCount = pContext->pCmd->mCmdCount;
+		cmdExecuteSecondaryCmds(pContext->pCmd, 1, &pSecondary);
+		TEST_CHECK(pContext->pCmd->mCmdCount == cmdCount);
+		if (attempt)
+			cmdBindRenderTargets(pContext->pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+		endCmd(pContext->pCmd);
+		submit(pContext);
+		TEST_CHECK(getOrder(pContext)[0] == NO_STEP);
+	}
+}
+
+int main()
+{
+	Log log(LogLevel::eWARNING);
+
+	Context      context = {};
+	Context*     pContext = &context;
+	RendererDesc settings = {};
+	initRenderer("SecondaryCmdTest", &settings, &pContext->pRenderer);
+	TEST_CHECK(pContext->pRenderer);
+	if (!pContext->pRenderer)
+		return testResult("SecondaryCmdTest");
+	Renderer* pRenderer = pContext->pRenderer;
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = CMD_POOL_DIRECT;
+	addQueue(pRenderer, &queueDesc, &pContext->pQueue);
+	addCmdPool(pRenderer, pContext->pQueue, false, &pContext->pCmdPool);
+	addCmd(pContext->pCmdPool, false, &pContext->pCmd);
+	addFence(pRenderer, &pContext->pFence);
+	// Command pools are not thread safe, every secondary gets its own
+	for (uint32_t i = 0; i < SECONDARY_COUNT; ++i)
+	{
+		addCmdPool(pRenderer, pContext->pQueue, false, &pContext->pSecondaryCmdPools[i]);
+		addCmd(pContext->pSecondaryCmdPools[i], true, &pContext->pSecondaryCmds[i]);
+	}
+	initThreadSystem(&pContext->pThreadSystem);
+
+	RenderTargetDesc rtDesc = {};
+	rtDesc.mWidth = 256;
+	rtDesc.mHeight = 256;
+	rtDesc.mDepth = 1;
+	rtDesc.mArraySize = 1;
+	rtDesc.mMipLevels = 1;
+	rtDesc.mSampleCount = SAMPLE_COUNT_1;
+	rtDesc.mFormat = ImageFormat::RGBA8;
+	addRenderTarget(pRenderer, &rtDesc, &pContext->pRenderTarget);
+
+	BufferDesc bufferDesc = {};
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	bufferDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+	bufferDesc.mSize = STEP_COUNT_MAX * sizeof(uint32_t);
+	addBuffer(pRenderer, &bufferDesc, &pContext->pIdBuffer);
+	bufferDesc.mSize = (1 + STEP_COUNT_MAX) * sizeof(uint32_t);
+	addBuffer(pRenderer, &bufferDesc, &pContext->pOrderBuffer);
+	for (uint32_t i = 0; i < STEP_COUNT_MAX; ++i)
+		((uint32_t*)pContext->pIdBuffer->pCpuMappedAddress)[i] = i;
+
+	testReplayOrder(pContext);
+	testRejectedSecondary(pContext);
+
+	removeBuffer(pRenderer, pContext->pOrderBuffer);
+	removeBuffer(pRenderer, pContext->pIdBuffer);
+	removeRenderTarget(pRenderer, pContext->pRenderTarget);
+	shutdownThreadSystem(pContext->pThreadSystem);
+	for (uint32_t i = 0; i < SECONDARY_COUNT; ++i)
+	{
+		removeCmd(pContext->pSecondaryCmdPools[i], pContext->pSecondaryCmds[i]);
+		removeCmdPool(pRenderer, pContext->pSecondaryCmdPools[i]);
+	}
+	removeFence(pRenderer, pContext->pFence);
+	removeCmd(pContext->pCmdPool, pContext->pCmd);
+	removeCmdPool(pRenderer, pContext->pCmdPool);
+	removeQueue(pContext->pQueue);
+	removeRenderer(pRenderer);
+	return testResult("SecondaryCmdTest");
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Scheduling cost of task graphs built from task groups and dependencies.
+// Every shape is run three ways:
+//  - flat:    the same number of tasks as one parallel-for without dependencies, the floor for the flat task queue
+//  - barrier: the graph levels separated by waitThreadSystemIdle, how dependencies had to be expressed before task groups
+//  - graph:   every node a task group, dependencies scheduled as continuations, all instances submitted up front
+// The per-task overhead is the wall clock time per task of the graph run minus the one of the flat run.
+//
+// Usage: TaskGroupBenchmark [scale]
+//   scale  Multiplies the number of graph instances, 1 by default
+
+#include <stdlib.h>
+
+#include "Interfaces/IThread.h"
+#include "OS/Core/Atomics.h"
+#include "OS/Core/ThreadSystem.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+#define SHAPE_NODE_COUNT_MAX 16
+#define NODE_DEPENDENCY_COUNT_MAX 2
+
+struct ShapeNode
+{
+	uint32_t mWidth;
+	uint32_t mDependencyCount;
+	uint32_t mDependencies[NODE_DEPENDENCY_COUNT_MAX];
+};
+
+struct Shape
+{
+	const char* pName;
+	ShapeNode   mNodes[SHAPE_NODE_COUNT_MAX];
+	uint32_t    mNodeCount;
+	// Longest path to the node, the barrier run submits one level at a time
+	uint32_t mLevels[SHAPE_NODE_COUNT_MAX];
+	uint32_t mLevelCount;
+	uint32_t mTaskCount;
+};
+
+struct NodeState
+{
+	const ShapeNode* pNode;
+	// First node of the instance this node belongs to
+	NodeState*       pInstanceNodes;
+	TaskGroup*       pGroup;
+	tfrg_atomic32_t  mFinished;
+};
+
+static tfrg_atomic32_t gOrderViolations;
+static tfrg_atomic64_t gChecksum;
+
+// A few hundred nanoseconds of work, the same body ThreadSystemBenchmark uses
+static void smallWork(uintptr_t index)
+{
+	uint64_t value = index;
+	for (uint32_t i = 0; i < 64; ++i)
+		value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+	tfrg_atomic64_add_relaxed(&gChecksum, value ? 1 : 2);
+}
+
+static void nodeTask(void* pData, uintptr_t index)
+{
+	NodeState* pState = (NodeState*)pData;
+	// Every task of every dependency has to be done before any task of the node starts
+	for (uint32_t d = 0; d < pState->pNode->mDependencyCount; ++d)
+	{
+		NodeState* pDependency = &pState->pInstanceNodes[pState->pNode->mDependencies[d]];
+		if (tfrg_atomic32_load_acquire(&pDependency->mFinished) != pDependency->pNode->mWidth)
+			tfrg_atomic32_add_relaxed(&gOrderViolations, 1);
+	}
+	smallWork(index);
+	tfrg_atomic32_add_relaxed(&pState->mFinished, 1);
+}
+
+static void flatTask(void*, uintptr_t index) { smallWork(index); }
+
+static void addShapeNode(Shape* pShape, uint32_t width, uint32_t dependencyCount = 0, uint32_t dependency0 = 0, uint32_t dependency1 = 0)
+{
+	ASSERT(pShape->mNodeCount < SHAPE_NODE_COUNT_MAX);
+	ShapeNode* pNode = &pShape->mNodes[pShape->mNodeCount];
+	pNode->mWidth = width;
+	pNode->mDependencyCount = dependencyCount;
+	pNode->mDependencies[0] = dependency0;
+	pNode->mDependencies[1] = dependency1;
+
+	uint32_t level = 0;
+	for (uint32_t d = 0; d < dependencyCount; ++d)
+	{
+		uint32_t dependencyLevel = pShape->mLevels[pNode->mDependencies[d]] + 1;
+		level = dependencyLevel > level ? dependencyLevel : level;
+	}
+	pShape->mLevels[pShape->mNodeCount] = level;
+	pShape->mLevelCount = level + 1 > pShape->mLevelCount ? level + 1 : pShape->mLevelCount;
+	pShape->mTaskCount += width;
+	++pShape->mNodeCount;
+}
+
+static void resetStates(const Shape* pShape, NodeState* pStates, uint32_t instanceCount)
+{
+	for (uint32_t i = 0; i < instanceCount; ++i)
+	{
+		NodeState* pInstanceNodes = &pStates[i * pShape->mNodeCount];
+		for (uint32_t n = 0; n < pShape->mNodeCount; ++n)
+		{
+			pInstanceNodes[n].pNode = &pShape->mNodes[n];
+			pInstanceNodes[n].pInstanceNodes = pInstanceNodes;
+			pInstanceNodes[n].pGroup = NULL;
+			tfrg_atomic32_store_relaxed(&pInstanceNodes[n].mFinished, 0);
+		}
+	}
+}
+
+static void waitIdle(ThreadSystem* pThreadSystem)
+{
+	while (assistThreadSystem(pThreadSystem))
+		;
+	waitThreadSystemIdle(pThreadSystem);
+}
+
+static double runBarrier(ThreadSystem* pThreadSystem, const Shape* pShape, NodeState* pStates, uint32_t instanceCount)
+{
+	resetStates(pShape, pStates, instanceCount);
+	return measureSeconds([&]() {
+		for (uint32_t level = 0; level < pShape->mLevelCount; ++level)
+		{
+			for (uint32_t i = 0; i < instanceCount; ++i)
+			{
+				for (uint32_t n = 0; n < pShape->mNodeCount; ++n)
+				{
+					if (pShape->mLevels[n] == level)
+						addThreadSystemRangeTask(pThreadSystem, nodeTask, &pStates[i * pShape->mNodeCount + n], pShape->mNodes[n].mWidth);
+				}
+			}
+			waitIdle(pThreadSystem);
+		}
+	});
+}
+
+static double runGraph(ThreadSystem* pThreadSystem, const Shape* pShape, NodeState* pStates, uint32_t instanceCount)
+{
+	resetStates(pShape, pStates, instanceCount);
+	return measureSeconds([&]() {
+		for (uint32_t i = 0; i < instanceCount; ++i)
+		{
+			NodeState* pInstanceNodes = &pStates[i * pShape->mNodeCount];
+			// Nodes are listed after their dependencies, so the groups they wait on already exist
+			for (uint32_t n = 0; n < pShape->mNodeCount; ++n)
+			{
+				const ShapeNode* pNode = &pShape->mNodes[n];
+				TaskGroup*       pDependencies[NODE_DEPENDENCY_COUNT_MAX] = {};
+				for (uint32_t d = 0; d < pNode->mDependencyCount; ++d)
+					pDependencies[d] = pInstanceNodes[pNode->mDependencies[d]].pGroup;
+
+				addTaskGroup(pThreadSystem, &pInstanceNodes[n].pGroup);
+				TaskDesc desc = {};
+				desc.pTask = nodeTask;
+				desc.pUser = &pInstanceNodes[n];
+				desc.mEnd = pNode->mWidth;
+				desc.pGroup = pInstanceNodes[n].pGroup;
+				desc.ppDependencies = pDependencies;
+				desc.mDependencyCount = pNode->mDependencyCount;
+				addThreadSystemTask(pThreadSystem, &desc);
+			}
+		}
+
+		// The last node of every shape is its only sink
+		for (uint32_t i = 0; i < instanceCount; ++i)
+			waitTaskGroupCompleted(pThreadSystem, pStates[(i + 1) * pShape->mNodeCount - 1].pGroup);
+		for (uint32_t i = 0; i < instanceCount * pShape->mNodeCount; ++i)
+			removeTaskGroup(pThreadSystem, pStates[i].pGroup);
+	});
+}
+
+static void checkStates(const Shape* pShape, NodeState* pStates, uint32_t instanceCount)
+{
+	for (uint32_t i = 0; i < instanceCount * pShape->mNodeCount; ++i)
+		TEST_CHECK(tfrg_atomic32_load_acquire(&pStates[i].mFinished) == pStates[i].pNode->mWidth);
+	TEST_CHECK(tfrg_atomic32_load_acquire(&gOrderViolations) == 0);
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t scale = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1;
+	if (!scale)
+		scale = 1;
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	Shape shapes[3] = {};
+	// Fan-out/fan-in: one task spreading to 64 which are joined by one
+	shapes[0].pName = "fan";
+	addShapeNode(&shapes[0], 1);
+	addShapeNode(&shapes[0], 64, 1, 0);
+	addShapeNode(&shapes[0], 1, 1, 1);
+	// Chain: 16 single tasks, each waiting on the previous one
+	shapes[1].pName = "chain";
+	addShapeNode(&shapes[1], 1);
+	for (uint32_t n = 1; n < 16; ++n)
+		addShapeNode(&shapes[1], 1, 1, n - 1);
+	// Diamonds: four stacked diamonds of two 8 wide sides
+	shapes[2].pName = "diamond";
+	addShapeNode(&shapes[2], 1);
+	for (uint32_t d = 0; d < 4; ++d)
+	{
+		uint32_t top = shapes[2].mNodeCount - 1;
+		addShapeNode(&shapes[2], 8, 1, top);
+		addShapeNode(&shapes[2], 8, 1, top);
+		addShapeNode(&shapes[2], 1, 2, top + 1, top + 2);
+	}
+
+	const uint32_t instanceCount = 2048 * scale;
+	const uint32_t runCount = 3;
+
+	printf("%u cores, %u instances per shape\n", Thread::GetNumCPUCores(), instanceCount);
+	printf(
+		"%-8s %6s %6s %10s %12s %12s %12s %14s\n", "shape", "tasks", "levels", "total", "flat Mt/s", "barrier Mt/s", "graph Mt/s",
+		"overhead ns/t");
+	for (uint32_t s = 0; s < 3; ++s)
+	{
+		const Shape* pShape = &shapes[s];
+		uint64_t     taskCount = (uint64_t)pShape->mTaskCount * instanceCount;
+		NodeState*   pStates = (NodeState*)conf_calloc(instanceCount * pShape->mNodeCount, sizeof(NodeState));
+
+		tfrg_atomic32_store_relaxed(&gOrderViolations, 0);
+		tfrg_atomic64_store_relaxed(&gChecksum, 0);
+
+		double flatSeconds = measureBestSeconds(runCount, [&]() {
+			addThreadSystemRangeTask(pThreadSystem, flatTask, NULL, taskCount);
+			waitIdle(pThreadSystem);
+		});
+		double barrierSeconds = runBarrier(pThreadSystem, pShape, pStates, instanceCount);
+		checkStates(pShape, pStates, instanceCount);
+		double graphSeconds = runGraph(pThreadSystem, pShape, pStates, instanceCount);
+		checkStates(pShape, pStates, instanceCount);
+		for (uint32_t r = 1; r < runCount; ++r)
+		{
+			double seconds = runBarrier(pThreadSystem, pShape, pStates, instanceCount);
+			barrierSeconds = seconds < barrierSeconds ? seconds : barrierSeconds;
+			seconds = runGraph(pThreadSystem, pShape, pStates, instanceCount);
+			graphSeconds = seconds < graphSeconds ? seconds : graphSeconds;
+		}
+		checkStates(pShape, pStates, instanceCount);
+		// Every task of every run did its work exactly once
+		TEST_CHECK(tfrg_atomic64_load_acquire(&gChecksum) == taskCount * runCount * 3);
+
+		printf(
+			"%-8s %6u %6u %10llu %12.2f %12.2f %12.2f %14.1f\n", pShape->pName, pShape->mTaskCount, pShape->mLevelCount,
+			(unsigned long long)taskCount, taskCount / flatSeconds / 1e6, taskCount / barrierSeconds / 1e6, taskCount / graphSeconds / 1e6,
+			(graphSeconds - flatSeconds) / taskCount * 1e9);
+
+		conf_free(pStates);
+	}
+
+	TEST_CHECK(isThreadSystemIdle(pThreadSystem));
+	shutdownThreadSystem(pThreadSystem);
+	return testResult("TaskGroupBenchmark");
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Task group completion, continuations and the wait-then-remove pattern used by cmdRecordSecondaryCmds.
+// Best run under AddressSanitizer, a thread touching a group after it was removed is a use after free.
+
+#include "Interfaces/IThread.h"
+#include "OS/Core/Atomics.h"
+#include "OS/Core/ThreadSystem.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+struct GroupCounters
+{
+	tfrg_atomic32_t mFirstCount;
+	tfrg_atomic32_t mSecondCount;
+	// First group tasks that had finished when a task of the dependent group started
+	tfrg_atomic32_t mMinFirstSeen;
+	uint32_t        mFirstTotal;
+};
+
+static void firstTask(void* pData, uintptr_t)
+{
+	GroupCounters* pCounters = (GroupCounters*)pData;
+	tfrg_atomic32_add_relaxed(&pCounters->mFirstCount, 1);
+}
+
+static void secondTask(void* pData, uintptr_t)
+{
+	GroupCounters* pCounters = (GroupCounters*)pData;
+	uint32_t       seen = tfrg_atomic32_load_acquire(&pCounters->mFirstCount);
+	if (seen < tfrg_atomic32_load_relaxed(&pCounters->mMinFirstSeen))
+		tfrg_atomic32_store_relaxed(&pCounters->mMinFirstSeen, seen);
+	tfrg_atomic32_add_relaxed(&pCounters->mSecondCount, 1);
+}
+
+int main()
+{
+	Log log(LogLevel::eWARNING);
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const uint32_t iterations = 2000;
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		GroupCounters counters = {};
+		counters.mFirstTotal = 1 + i % 97;
+		counters.mMinFirstSeen = UINT32_MAX;
+
+		TaskGroup* pFirst = NULL;
+		TaskGroup* pSecond = NULL;
+		addTaskGroup(pThreadSystem, &pFirst);
+		addTaskGroup(pThreadSystem, &pSecond);
+
+		TaskDesc desc = {};
+		desc.pTask = firstTask;
+		desc.pUser = &counters;
+		desc.mEnd = counters.mFirstTotal;
+		desc.pGroup = pFirst;
+		addThreadSystemTask(pThreadSystem, &desc);
+
+		// Continuation of the first group
+		desc.pTask = secondTask;
+		desc.mEnd = 1 + i % 13;
+		desc.pGroup = pSecond;
+		desc.ppDependencies = &pFirst;
+		desc.mDependencyCount = 1;
+		addThreadSystemTask(pThreadSystem, &desc);
+
+		// Removing right after the wait is the pattern that must not race the threads retiring the last tasks
+		if (i & 1)
+		{
+			waitTaskGroupCompleted(pThreadSystem, pSecond);
+			TEST_CHECK(isTaskGroupCompleted(pSecond));
+			removeTaskGroup(pThreadSystem, pSecond);
+			removeTaskGroup(pThreadSystem, pFirst);
+		}
+		else
+		{
+			// removeTaskGroup waits on its own
+			removeTaskGroup(pThreadSystem, pFirst);
+			removeTaskGroup(pThreadSystem, pSecond);
+		}
+
+		TEST_CHECK(counters.mFirstCount == counters.mFirstTotal);
+		TEST_CHECK(counters.mSecondCount == 1 + i % 13);
+		TEST_CHECK(counters.mMinFirstSeen == counters.mFirstTotal);
+		if (gTestFailures)
+			break;
+	}
+
+	waitThreadSystemIdle(pThreadSystem);
+	TEST_CHECK(isThreadSystemIdle(pThreadSystem));
+	shutdownThreadSystem(pThreadSystem);
+	return testResult("TaskGroupTest");
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Textures per second and peak memory of loading a directory of DDS/KTX files on the Null renderer:
+//  - serial:   read, parse and mip generation on the calling thread, what addResource(TextureLoadDesc*) did before it
+//              handed file loads to the loader thread pool. The file is passed as BinaryImageData, which still runs synchronously
+//  - pipeline: addResource with a file name, the CPU stages run on the loader thread pool and only the copies on the streamer
+// Also checks that a file which fails to load leaves a NULL texture and still completes its token.
+//
+// Usage: TextureLoadBenchmark [directory] [repeat]
+//   directory  Directory with .dds and .ktx files, 32 generated RGBA8 DDS files without mip levels by default
+//   repeat     How many times every file is loaded per run, 4 by default
+
+#include <stdlib.h>
+
+#include "EASTL/vector.h"
+
+#include "IRenderer.h"
+#include "ResourceLoader.h"
+#include "Image/Image.h"
+#include "Interfaces/IThread.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+#define GENERATED_TEXTURE_COUNT 32
+#define GENERATED_TEXTURE_SIZE 256
+
+struct RunResult
+{
+	double   mSeconds;
+	uint64_t mPeakBytes;
+	uint32_t mLoadedCount;
+};
+
+static void generateTextures(const eastl::string& directory, eastl::vector<eastl::string>& files)
+{
+	for (uint32_t i = 0; i < GENERATED_TEXTURE_COUNT; ++i)
+	{
+		Image    image;
+		uint8_t* pPixels = image.Create(ImageFormat::RGBA8, GENERATED_TEXTURE_SIZE, GENERATED_TEXTURE_SIZE, 1, 1);
+		for (uint32_t p = 0; p < GENERATED_TEXTURE_SIZE * GENERATED_TEXTURE_SIZE * 4; ++p)
+			pPixels[p] = (uint8_t)(p * (i + 3) + (p >> 11));
+		eastl::string fileName = directory + "texture" + eastl::to_string(i) + ".dds";
+		TEST_CHECK(image.iSaveDDS(fileName.c_str()));
+		image.Destroy();
+		files.push_back(fileName);
+	}
+}
+
+static TextureLoadDesc getLoadDesc(Texture** ppTexture, bool generateMipMaps)
+{
+	TextureLoadDesc loadDesc = {};
+	loadDesc.mRoot = FSR_Absolute;
+	loadDesc.mGenerateMipMaps = generateMipMaps;
+	loadDesc.ppTexture = ppTexture;
+	return loadDesc;
+}
+
+static void loadSerial(const eastl::vector<eastl::string>& files, uint32_t repeat, bool generateMipMaps, Texture** ppTextures)
+{
+	SyncToken token = 0;
+	for (uint32_t r = 0; r < repeat; ++r)
+	{
+		for (uint32_t i = 0; i < (uint32_t)files.size(); ++i)
+		{
+			MappedFile file;
+			if (!file.Open(files[i], FSR_Absolute))
+				continue;
+			eastl::string   extension = FileSystem::GetExtension(files[i]);
+			BinaryImageData binaryData = { (unsigned char*)file.GetData(), (uint32_t)file.GetSize(), extension.c_str() };
+
+			TextureLoadDesc loadDesc = getLoadDesc(&ppTextures[r * files.size() + i], generateMipMaps);
+			loadDesc.pBinaryImageData = &binaryData;
+			addResource(&loadDesc, &token);
+		}
+	}
+	waitTokenCompleted(token);
+}
+
+static void loadPipeline(const eastl::vector<eastl::string>& files, uint32_t repeat, bool generateMipMaps, Texture** ppTextures)
+{
+	SyncToken token = 0;
+	for (uint32_t r = 0; r < repeat; ++r)
+	{
+		for (uint32_t i = 0; i < (uint32_t)files.size(); ++i)
+		{
+			TextureLoadDesc loadDesc = getLoadDesc(&ppTextures[r * files.size() + i], generateMipMaps);
+			loadDesc.pFilename = files[i].c_str();
+			addResource(&loadDesc, &token);
+		}
+	}
+	waitTokenCompleted(token);
+}
+
+template <typename Func>
+static RunResult measureRun(uint32_t textureCount, Func func)
+{
+	Texture** ppTextures = (Texture**)conf_calloc(textureCount, sizeof(Texture*));
+	RunResult result = {};
+	result.mSeconds = 1e9;
+	for (uint32_t run = 0; run < 3; ++run)
+	{
+		resetPeakMemory();
+		uint64_t baseline = getPeakMemory();
+		double   seconds = measureSeconds([&]() { func(ppTextures); });
+		uint64_t peak = getPeakMemory();
+		result.mSeconds = seconds < result.mSeconds ? seconds : result.mSeconds;
+		result.mPeakBytes = peak > baseline ? peak - baseline : 0;
+
+		result.mLoadedCount = 0;
+		for (uint32_t i = 0; i < textureCount; ++i)
+		{
+			if (ppTextures[i])
+			{
+				++result.mLoadedCount;
+				removeResource(ppTextures[i]);
+				ppTextures[i] = NULL;
+			}
+		}
+	}
+	conf_free(ppTextures);
+	return result;
+}
+
+static void testLoadFailure(const eastl::string& directory)
+{
+	eastl::string fileName = directory + "missing.dds";
+	// Stale value the failed load has to clear
+	Texture*  pTexture = (Texture*)&fileName;
+	SyncToken token = 0;
+
+	TextureLoadDesc loadDesc = getLoadDesc(&pTexture, false);
+	loadDesc.pFilename = fileName.c_str();
+	addResource(&loadDesc, &token);
+	waitTokenCompleted(token);
+	TEST_CHECK(isTokenCompleted(token));
+	TEST_CHECK(pTexture == NULL);
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint32_t repeat = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4;
+	if (!repeat)
+		repeat = 4;
+
+	eastl::string                directory = getTestDirectory("TextureLoadBenchmark");
+	eastl::vector<eastl::string> files;
+	bool                         generated = argc < 2;
+	if (generated)
+	{
+		generateTextures(directory, files);
+	}
+	else
+	{
+		eastl::vector<eastl::string> candidates;
+		FileSystem::GetFilesWithExtension(argv[1], ".dds", candidates);
+		FileSystem::GetFilesWithExtension(argv[1], ".ktx", candidates);
+		// Some formats only load on the platforms that support them (e.g. ASTC KTX files on mobile)
+		for (uint32_t i = 0; i < (uint32_t)candidates.size(); ++i)
+		{
+			Image image;
+			if (image.loadImage(candidates[i].c_str(), NULL, NULL, FSR_Absolute))
+				files.push_back(candidates[i]);
+			else
+				printf("skipping %s, it does not load on this platform\n", candidates[i].c_str());
+			image.Destroy();
+		}
+	}
+	TEST_CHECK(!files.empty());
+
+	Renderer*    pRenderer = NULL;
+	RendererDesc settings = {};
+	initRenderer("TextureLoadBenchmark", &settings, &pRenderer);
+	TEST_CHECK(pRenderer);
+	if (!pRenderer || files.empty())
+		return testResult("TextureLoadBenchmark");
+	initResourceLoaderInterface(pRenderer);
+
+	// Generated files only store the top level, the loads then generate the mip chain as well
+	const uint32_t textureCount = (uint32_t)files.size() * repeat;
+	RunResult      serial = measureRun(textureCount, [&](Texture** ppTextures) { loadSerial(files, repeat, generated, ppTextures); });
+	RunResult      pipeline = measureRun(textureCount, [&](Texture** ppTextures) { loadPipeline(files, repeat, generated, ppTextures); });
+	TEST_CHECK(serial.mLoadedCount == textureCount);
+	TEST_CHECK(pipeline.mLoadedCount == textureCount);
+
+	testLoadFailure(directory);
+
+	printf(
+		"%u files%s, %u loads per run, %u cores\n", (uint32_t)files.size(), generated ? " (generated)" : "", textureCount,
+		Thread::GetNumCPUCores());
+	printf("%-9s %12s %12s %10s\n", "path", "textures/s", "ms", "peak MB");
+	printf("%-9s %12.1f %12.2f %10.1f\n", "serial", textureCount / serial.mSeconds, serial.mSeconds * 1e3, serial.mPeakBytes / 1048576.0);
+	printf(
+		"%-9s %12.1f %12.2f %10.1f\n", "pipeline", textureCount / pipeline.mSeconds, pipeline.mSeconds * 1e3,
+		pipeline.mPeakBytes / 1048576.0);
+	printf("peak is the VmHWM increase during the run\n");
+
+	removeResourceLoaderInterface(pRenderer);
+	removeRenderer(pRenderer);
+	if (generated)
+	{
+		for (uint32_t i = 0; i < (uint32_t)files.size(); ++i)
+			FileSystem::Delete(files[i]);
+	}
+	return testResult("TextureLoadBenchmark");
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Tasks per second of the work stealing ThreadSystem against the single locked queue it replaced.
+//
+// Usage: ThreadSystemBenchmark [scale]
+//   scale  Multiplies the task counts, 1 by default
+
+#include <stdlib.h>
+
+#include "EASTL/algorithm.h"
+#include "EASTL/deque.h"
+
+#include "Interfaces/IThread.h"
+#include "OS/Core/Atomics.h"
+#include "OS/Core/ThreadSystem.h"
+
+#include "../Common/TestCommon.h"
+#include "Interfaces/IMemory.h"
+
+/************************************************************************/
+// Reference: one mutex guarded deque handing out range tasks one index at a time, at most four workers
+/************************************************************************/
+struct LockedTask
+{
+	TaskFunc  mTask;
+	void*     mUser;
+	uintptr_t mStart;
+	uintptr_t mEnd;
+};
+
+enum
+{
+	LOCKED_POOL_MAX_THREADS = 4,
+};
+
+struct LockedPool
+{
+	ThreadDesc               mThreadDescs[LOCKED_POOL_MAX_THREADS];
+	ThreadHandle             mThreads[LOCKED_POOL_MAX_THREADS];
+	eastl::deque<LockedTask> mQueue;
+	Mutex                    mMutex;
+	ConditionVariable        mQueueCond;
+	ConditionVariable        mIdleCond;
+	uint32_t                 mNumThreads;
+	uint32_t                 mNumRunning;
+	volatile bool            mRun;
+};
+
+static bool runLockedTask(LockedPool* pPool)
+{
+	// Called with the mutex held, returns with it held
+	if (pPool->mQueue.empty())
+		return false;
+
+	LockedTask task = pPool->mQueue.front();
+	if (task.mStart + 1 == task.mEnd)
+		pPool->mQueue.pop_front();
+	else
+		++pPool->mQueue.front().mStart;
+	++pPool->mNumRunning;
+	pPool->mMutex.Release();
+
+	task.mTask(task.mUser, task.mStart);
+
+	pPool->mMutex.Acquire();
+	if (--pPool->mNumRunning == 0 && pPool->mQueue.empty())
+		pPool->mIdleCond.WakeAll();
+	return true;
+}
+
+static void lockedPoolThreadFunc(void* pData)
+{
+	LockedPool* pPool = (LockedPool*)pData;
+	pPool->mMutex.Acquire();
+	while (pPool->mRun)
+	{
+		if (!runLockedTask(pPool))
+			pPool->mQueueCond.Wait(pPool->mMutex);
+	}
+	pPool->mMutex.Release();
+}
+
+static void initLockedPool(LockedPool* pPool, uint32_t numThreads)
+{
+	pPool->mNumThreads = numThreads;
+	pPool->mNumRunning = 0;
+	pPool->mRun = true;
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		pPool->mThreadDescs[i].pFunc = lockedPoolThreadFunc;
+		pPool->mThreadDescs[i].pData = pPool;
+		pPool->mThreads[i] = create_thread(&pPool->mThreadDescs[i]);
+	}
+}
+
+static void shutdownLockedPool(LockedPool* pPool)
+{
+	pPool->mMutex.Acquire();
+	pPool->mRun = false;
+	pPool->mQueueCond.WakeAll();
+	pPool->mMutex.Release();
+	for (uint32_t i = 0; i < pPool->mNumThreads; ++i)
+		destroy_thread(pPool->mThreads[i]);
+}
+
+static void addLockedTask(LockedPool* pPool, TaskFunc task, void* user, uintptr_t start, uintptr_t end)
+{
+	pPool->mMutex.Acquire();
+	pPool->mQueue.push_back(LockedTask{ task, user, start, end });
+	pPool->mQueueCond.WakeOne();
+	pPool->mMutex.Release();
+}
+
+static void waitLockedPoolIdle(LockedPool* pPool)
+{
+	pPool->mMutex.Acquire();
+	// The submitting thread helps like assistThreadSystem did
+	while (runLockedTask(pPool))
+		;
+	while (pPool->mNumRunning || !pPool->mQueue.empty())
+		pPool->mIdleCond.Wait(pPool->mMutex);
+	pPool->mMutex.Release();
+}
+
+/************************************************************************/
+// Workloads, run on both schedulers through the Scheduler adapters below
+/************************************************************************/
+static tfrg_atomic64_t gChecksum;
+
+// A few hundred nanoseconds of work, about what a small parallel-for body costs
+static void smallTask(void*, uintptr_t index)
+{
+	uint64_t value = index;
+	for (uint32_t i = 0; i < 64; ++i)
+		value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+	// Depends on the result so the loop is not optimized out, the generator only reaches 0 from one seed
+	tfrg_atomic64_add_relaxed(&gChecksum, value ? 1 : 2);
+}
+
+struct ThreadSystemScheduler
+{
+	ThreadSystem* pThreadSystem;
+	void add(TaskFunc task, void* user, uintptr_t start, uintptr_t end) { addThreadSystemRangeTask(pThreadSystem, task, user, start, end); }
+	void wait()
+	{
+		while (assistThreadSystem(pThreadSystem))
+			;
+		waitThreadSystemIdle(pThreadSystem);
+	}
+};
+
+struct LockedScheduler
+{
+	LockedPool* pPool;
+	void add(TaskFunc task, void* user, uintptr_t start, uintptr_t end) { addLockedTask(pPool, task, user, start, end); }
+	void wait() { waitLockedPoolIdle(pPool); }
+};
+
+template <typename Scheduler>
+struct NestedSpawn
+{
+	Scheduler* pScheduler;
+	uint32_t   mChildCount;
+	static void spawn(void* pData, uintptr_t)
+	{
+		NestedSpawn* pThis = (NestedSpawn*)pData;
+		pThis->pScheduler->add(smallTask, NULL, 0, pThis->mChildCount);
+	}
+};
+
+template <typename Scheduler>
+static double runWorkload(Scheduler* pScheduler, uint32_t workload, uint64_t taskCount)
+{
+	tfrg_atomic64_store_relaxed(&gChecksum, 0);
+	double seconds = 0.0;
+	switch (workload)
+	{
+		// One large parallel-for
+		case 0:
+			seconds = measureSeconds([&]() {
+				pScheduler->add(smallTask, NULL, 0, taskCount);
+				pScheduler->wait();
+			});
+			break;
+		// Many single index tasks submitted from outside the pool
+		case 1:
+			seconds = measureSeconds([&]() {
+				for (uint64_t i = 0; i < taskCount; ++i)
+					pScheduler->add(smallTask, NULL, i, i + 1);
+				pScheduler->wait();
+			});
+			break;
+		// Tasks submitting more tasks from the workers
+		case 2:
+		{
+			NestedSpawn<Scheduler> spawn = { pScheduler, 64 };
+			seconds = measureSeconds([&]() {
+				pScheduler->add(NestedSpawn<Scheduler>::spawn, &spawn, 0, taskCount / 64);
+				pScheduler->wait();
+			});
+			taskCount = taskCount / 64 * 64;
+			break;
+		}
+	}
+
+	// Every index ran exactly once
+	TEST_CHECK(tfrg_atomic64_load_acquire(&gChecksum) == taskCount);
+	return seconds;
+}
+
+int main(int argc, char** argv)
+{
+	Log log(LogLevel::eWARNING);
+
+	uint64_t scale = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+	if (!scale)
+		scale = 1;
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+	uint32_t numCores = Thread::GetNumCPUCores();
+
+	LockedPool* pPool = conf_new(LockedPool);
+	uint32_t    lockedThreads = numCores > 1 ? numCores - 1 : 1;
+	initLockedPool(pPool, lockedThreads < LOCKED_POOL_MAX_THREADS ? lockedThreads : LOCKED_POOL_MAX_THREADS);
+
+	ThreadSystemScheduler stealing = { pThreadSystem };
+	LockedScheduler       locked = { pPool };
+
+	const char*    workloadNames[] = { "range", "single", "nested" };
+	const uint64_t taskCounts[] = { 1000000 * scale, 100000 * scale, 256000 * scale };
+
+	printf("%u cores, locked queue uses %u workers\n", numCores, pPool->mNumThreads);
+	printf("%-8s %14s %14s %8s\n", "workload", "locked Mt/s", "stealing Mt/s", "speedup");
+	for (uint32_t workload = 0; workload < 3; ++workload)
+	{
+		uint64_t taskCount = taskCounts[workload];
+		double   lockedSeconds = runWorkload(&locked, workload, taskCount);
+		double   stealingSeconds = runWorkload(&stealing, workload, taskCount);
+		// Second round once the threads are warmed up
+		lockedSeconds = eastl::min(lockedSeconds, runWorkload(&locked, workload, taskCount));
+		stealingSeconds = eastl::min(stealingSeconds, runWorkload(&stealing, workload, taskCount));
+
+		printf(
+			"%-8s %14.2f %14.2f %7.2fx\n", workloadNames[workload], taskCount / lockedSeconds / 1e6, taskCount / stealingSeconds / 1e6,
+			lockedSeconds / stealingSeconds);
+	}
+
+	TEST_CHECK(isThreadSystemIdle(pThreadSystem));
+
+	shutdownLockedPool(pPool);
+	conf_delete(pPool);
+	shutdownThreadSystem(pThreadSystem);
+	return testResult("ThreadSystemBenchmark");
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Packs a directory into an archive that FileSystem::MountArchive can serve files from.
+//
+// Usage: ArchivePacker [-c] <directory> <archive>
+//   -c  Compress entries that shrink by at least an eighth
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+
+#include "OS/Core/Archive.h"
+#include "Interfaces/IMemory.h"
+
+struct PackedFile
+{
+	eastl::string mPath;
+	// Path relative to the packed directory with '/' separators
+	eastl::string mName;
+};
+
+static void collectFiles(const eastl::string& dir, const eastl::string& relativeDir, eastl::vector<PackedFile>& files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE           find = FindFirstFileA((dir + "/*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		if (findData.cFileName[0] == '.')
+			continue;
+
+		eastl::string path = dir + "/" + findData.cFileName;
+		eastl::string name = relativeDir + findData.cFileName;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			collectFiles(path, name + "/", files);
+		else
+			files.push_back({ path, name });
+	} while (FindNextFileA(find, &findData));
+
+	FindClose(find);
+#else
+	DIR* directory = opendir(dir.c_str());
+	if (!directory)
+		return;
+
+	while (struct dirent* entry = readdir(directory))
+	{
+		if (entry->d_name[0] == '.')
+			continue;
+
+		eastl::string path = dir + "/" + entry->d_name;
+		eastl::string name = relativeDir + entry->d_name;
+		struct stat   fileInfo = {};
+		if (stat(path.c_str(), &fileInfo) != 0)
+			continue;
+
+		if (S_ISDIR(fileInfo.st_mode))
+			collectFiles(path, name + "/", files);
+		else if (S_ISREG(fileInfo.st_mode))
+			files.push_back({ path, name });
+	}
+
+	closedir(directory);
+#endif
+}
+
+static bool readWholeFile(const char* path, eastl::vector<uint8_t>& data)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (size < 0)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	data.resize((size_t)size);
+	bool success = fread(data.data(), 1, data.size(), fp) == data.size();
+	fclose(fp);
+	return success;
+}
+
+static bool writePadding(FILE* fp, uint64_t* pOffset, uint64_t alignedOffset)
+{
+	static const uint8_t zeros[256] = {};
+	while (*pOffset < alignedOffset)
+	{
+		size_t count = (size_t)eastl::min<uint64_t>(alignedOffset - *pOffset, sizeof(zeros));
+		if (fwrite(zeros, 1, count, fp) != count)
+			return false;
+		*pOffset += count;
+	}
+	return true;
+}
+
+static inline uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+// Small entries are packed inside the current block, anything that does not fit in its remainder starts a new block
+static uint64_t placeEntry(uint64_t offset, uint64_t size)
+{
+	uint64_t aligned = alignUp(offset, ARCHIVE_ENTRY_ALIGNMENT);
+	uint64_t blockEnd = alignUp(aligned + 1, ARCHIVE_BLOCK_SIZE);
+	if (size <= blockEnd - aligned)
+		return aligned;
+	return alignUp(offset, ARCHIVE_BLOCK_SIZE);
+}
+
+int main(int argc, char** argv)
+{
+	bool compress = false;
+	int  arg = 1;
+	if (arg < argc && strcmp(argv[arg], "-c") == 0)
+	{
+		compress = true;
+		++arg;
+	}
+
+	if (argc - arg != 2)
+	{
+		printf("Usage: ArchivePacker [-c] <directory> <archive>\n");
+		return 1;
+	}
+
+	eastl::string directory = argv[arg];
+	while (directory.size() > 1 && (directory.back() == '/' || directory.back() == '\\'))
+		directory.pop_back();
+	const char* archiveName = argv[arg + 1];
+
+	eastl::vector<PackedFile> files;
+	collectFiles(directory, "", files);
+	// Deterministic output regardless of directory enumeration order
+	eastl::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.mName < b.mName; });
+
+	FILE* fp = fopen(archiveName, "wb");
+	if (!fp)
+	{
+		printf("Could not open %s for writing\n", archiveName);
+		return 1;
+	}
+
+	ArchiveHeader header = {};
+	header.mMagic = ARCHIVE_MAGIC;
+	header.mVersion = ARCHIVE_VERSION;
+	header.mEntryCount = (uint32_t)files.size();
+	header.mBucketCount = 1;
+	while (header.mBucketCount < header.mEntryCount)
+		header.mBucketCount <<= 1;
+
+	eastl::vector<ArchiveEntry> entries(files.size());
+	eastl::vector<uint32_t>     buckets(header.mBucketCount, ARCHIVE_INVALID_INDEX);
+	eastl::string               names;
+	eastl::vector<uint8_t>      data;
+	eastl::vector<uint8_t>      compressed;
+	uint64_t                    offset = 0;
+	uint64_t                    originalTotal = 0;
+	bool                        success = fwrite(&header, sizeof(header), 1, fp) == 1;
+	offset += sizeof(header);
+
+	for (uint32_t i = 0; success && i < (uint32_t)files.size(); ++i)
+	{
+		const PackedFile& file = files[i];
+		if (!readWholeFile(file.mPath.c_str(), data))
+		{
+			printf("Could not read %s\n", file.mPath.c_str());
+			success = false;
+			break;
+		}
+
+		ArchiveEntry& entry = entries[i];
+		entry.mHash = archive_hash_path(file.mName.c_str(), file.mName.size());
+		entry.mOriginalSize = data.size();
+		entry.mNameOffset = (uint32_t)names.size();
+		entry.mNameLength = (uint32_t)file.mName.size();
+		entry.mCompression = ARCHIVE_COMPRESSION_NONE;
+		names += file.mName;
+
+		const uint8_t* pStored = data.data();
+		uint64_t       storedSize = data.size();
+		if (compress && data.size() && data.size() <= UINT32_MAX)
+		{
+			compressed.resize(archive_compress_bound((uint32_t)data.size()));
+			uint32_t compressedSize = archive_compress(data.data(), (uint32_t)data.size(), compressed.data(), (uint32_t)compressed.size());
+			if (compressedSize && compressedSize <= data.size() - data.size() / 8)
+			{
+				entry.mCompression = ARCHIVE_COMPRESSION_LZ;
+				pStored = compressed.data();
+				storedSize = compressedSize;
+			}
+		}
+
+		entry.mSize = storedSize;
+		entry.mOffset = placeEntry(offset, storedSize);
+		success = writePadding(fp, &offset, entry.mOffset) && fwrite(pStored, 1, (size_t)storedSize, fp) == storedSize;
+		offset += storedSize;
+		originalTotal += data.size();
+
+		// Chains always point to earlier entries
+		uint32_t bucket = (uint32_t)(entry.mHash & (header.mBucketCount - 1));
+		entry.mNext = buckets[bucket];
+		buckets[bucket] = i;
+	}
+
+	if (success)
+	{
+		header.mEntryOffset = alignUp(offset, sizeof(uint64_t));
+		success = writePadding(fp, &offset, header.mEntryOffset);
+		success = success && fwrite(entries.data(), sizeof(ArchiveEntry), entries.size(), fp) == entries.size();
+		offset += entries.size() * sizeof(ArchiveEntry);
+
+		header.mBucketOffset = offset;
+		success = success && fwrite(buckets.data(), sizeof(uint32_t), buckets.size(), fp) == buckets.size();
+		offset += buckets.size() * sizeof(uint32_t);
+
+		header.mNameOffset = offset;
+		header.mNameSize = names.size();
+		success = success && fwrite(names.data(), 1, names.size(), fp) == names.size();
+		offset += names.size();
+
+		success = success && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+	}
+
+	success = fclose(fp) == 0 && success;
+	if (!success)
+	{
+		printf("Failed to write %s\n", archiveName);
+		remove(archiveName);
+		return 1;
+	}
+
+	printf(
+		"Packed %u files, %llu bytes into %s (%llu bytes)\n", header.mEntryCount, (unsigned long long)originalTotal, archiveName,
+		(unsigned long long)offset);
+	return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2018-2019 Confetti Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+
+// Expands a binary log written in Log binary mode into the same text lines the text log files contain.
+//
+// Usage: LogDecoder <log.tflog> [output.log]
+//   Writes to stdout when no output file is given
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+
+#include "OS/Logging/BinaryLog.h"
+#include "Interfaces/IMemory.h"
+
+// Same values as LogLevel in Log.h
+static const struct
+{
+	uint32_t    mLevel;
+	const char* pPrefix;
+} gLevelPrefixes[] = {
+	{ 2, " DBG| " },
+	{ 4, "INFO| " },
+	{ 8, "WARN| " },
+	{ 16, " ERR| " },
+};
+
+struct DecodedThread
+{
+	uint64_t mThreadId;
+	char     mName[BINARY_LOG_THREAD_NAME_LENGTH];
+};
+
+static bool readWholeFile(const char* path, eastl::vector<uint8_t>& data)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp)
+		return false;
+
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (size < 0)
+	{
+		fclose(fp);
+		return false;
+	}
+
+	data.resize((size_t)size);
+	bool success = fread(data.data(), 1, data.size(), fp) == data.size();
+	fclose(fp);
+	return success;
+}
+
+static const char* getFileName(const char* path)
+{
+	const char* name = path;
+	for (const char* ptr = path; *ptr; ++ptr)
+	{
+		if (*ptr == '/' || *ptr == '\\')
+			name = ptr + 1;
+	}
+	return name;
+}
+
+// Matches the preamble written by Log::WritePreamble with every field enabled
+static void appendPreamble(eastl::string& line, time_t t, const char* threadName, const char* file, uint32_t lineNumber)
+{
+	tm time_info;
+#ifdef _WIN32
+	localtime_s(&time_info, &t);
+#else
+	localtime_r(&t, &time_info);
+#endif
+
+	char shortenedFileName[24];
+	snprintf(shortenedFileName, sizeof(shortenedFileName), "%s", getFileName(file));
+
+	char preamble[128];
+	snprintf(preamble, sizeof(preamble), "%04d-%02d-%02d %02d:%02d:%02d [%-15s] %22s:%-5u ",
+		1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday, time_info.tm_hour, time_info.tm_min, time_info.tm_sec,
+		threadName, shortenedFileName, lineNumber);
+	line.append(preamble);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2 && argc != 3)
+	{
+		printf("Usage: LogDecoder <log.tflog> [output.log]\n");
+		return 1;
+	}
+
+	eastl::vector<uint8_t> data;
+	if (!readWholeFile(argv[1], data))
+	{
+		printf("Could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	BinaryLogFileHeader header = {};
+	if (data.size() < sizeof(header))
+	{
+		printf("%s is not a binary log\n", argv[1]);
+		return 1;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.mMagic != BINARY_LOG_MAGIC || header.mVersion != BINARY_LOG_VERSION)
+	{
+		printf("%s is not a binary log or was written by a different version\n", argv[1]);
+		return 1;
+	}
+
+	FILE* output = stdout;
+	if (argc == 3)
+	{
+		output = fopen(argv[2], "wb");
+		if (!output)
+		{
+			printf("Could not open %s for writing\n", argv[2]);
+			return 1;
+		}
+	}
+
+	eastl::vector<eastl::string> strings;
+	eastl::vector<DecodedThread> threads;
+	eastl::string                line;
+	size_t                       offset = sizeof(header);
+	uint32_t                     messageCount = 0;
+	bool                         truncated = false;
+
+	while (offset < data.size() && !truncated)
+	{
+		const uint8_t* pEntry = data.data() + offset;
+		const size_t   available = data.size() - offset;
+
+		switch (pEntry[0])
+		{
+			case BINARY_LOG_ENTRY_STRING:
+			{
+				BinaryLogStringEntry entry;
+				if (available < sizeof(entry) || (memcpy(&entry, pEntry, sizeof(entry)), available - sizeof(entry) < entry.mLength))
+				{
+					truncated = true;
+					break;
+				}
+				if (strings.size() <= entry.mIndex)
+					strings.resize(entry.mIndex + 1);
+				strings[entry.mIndex].assign((const char*)pEntry + sizeof(entry), entry.mLength);
+				offset += sizeof(entry) + entry.mLength;
+				break;
+			}
+			case BINARY_LOG_ENTRY_THREAD:
+			{
+				BinaryLogThreadEntry entry;
+				if (available < sizeof(entry))
+				{
+					truncated = true;
+					break;
+				}
+				memcpy(&entry, pEntry, sizeof(entry));
+				entry.mName[BINARY_LOG_THREAD_NAME_LENGTH - 1] = 0;
+				if (threads.size() <= entry.mIndex)
+					threads.resize(entry.mIndex + 1);
+				threads[entry.mIndex].mThreadId = entry.mThreadId;
+				memcpy(threads[entry.mIndex].mName, entry.mName, sizeof(entry.mName));
+				offset += sizeof(entry);
+				break;
+			}
+			case BINARY_LOG_ENTRY_MESSAGE:
+			{
+				BinaryLogMessageEntry entry;
+				if (available < sizeof(entry) || (memcpy(&entry, pEntry, sizeof(entry)), available - sizeof(entry) < entry.mArgsSize))
+				{
+					truncated = true;
+					break;
+				}
+
+				const char* format = entry.mFormat < strings.size() ? strings[entry.mFormat].c_str() : "<unknown format>";
+				const char* file = entry.mFile < strings.size() ? strings[entry.mFile].c_str() : "<unknown>";
+				const char* threadName = entry.mThread < threads.size() ? threads[entry.mThread].mName : "NoName";
+				const char* prefix = "    | ";
+				for (uint32_t i = 0; i < sizeof(gLevelPrefixes) / sizeof(gLevelPrefixes[0]); ++i)
+				{
+					if (gLevelPrefixes[i].mLevel == entry.mLevel)
+						prefix = gLevelPrefixes[i].pPrefix;
+				}
+
+				line.clear();
+				appendPreamble(line, (time_t)entry.mTime, threadName, file, entry.mLine);
+				line.append(prefix);
+				line.append(entry.mIndentation, ' ');
+				binary_log_format(format, pEntry + sizeof(entry), entry.mArgsSize, line);
+				line.push_back('\n');
+				fwrite(line.c_str(), 1, line.size(), output);
+
+				offset += sizeof(entry) + entry.mArgsSize;
+				++messageCount;
+				break;
+			}
+			default:
+				printf("Unknown entry type %u at offset %llu, stopping\n", (uint32_t)pEntry[0], (unsigned long long)offset);
+				truncated = true;
+				break;
+		}
+	}
+
+	if (output != stdout)
+	{
+		fclose(output);
+		printf("Decoded %u messages from %s\n", messageCount, argv[1]);
+	}
+
+	// A log that was still being written can end in a partial entry
+	if (truncated && offset < data.size())
+		fprintf(stderr, "Stopped at offset %llu of %llu\n", (unsigned long long)offset, (unsigned long long)data.size());
+
+	return 0;
+}